@@ -1 +1,33 @@
-AM_CONDITIONAL([HAVE_CUDA], [true])
+#
+# Check for CUDA support
+#
+cuda_happy="no"
+AC_ARG_WITH([cuda],
+           [AS_HELP_STRING([--with-cuda=(DIR)], [Enable the use of CUDA (default is guess).])],
+           [], [with_cuda=guess])
+
+AS_IF([test "x$with_cuda" != xno],
+      [AS_IF([test "x$with_cuda" = xguess -o "x$with_cuda" = xyes],
+             [with_cuda=/usr/local/cuda],
+             [:])
+       AC_CHECK_HEADER([$with_cuda/include/cuda_runtime.h],
+                       [AC_CHECK_LIB([cudart], [cudaMemcpyAsync],
+                                     [CFLAGS="$CFLAGS -I$with_cuda/include"
+                                      CPPFLAGS="$CPPFLAGS -I$with_cuda/include"
+                                      LDFLAGS="$LDFLAGS -L$with_cuda/lib64 -L$with_cuda/lib"
+                                      CUDA_LIBS="-lcudart"
+                                      AC_SUBST([CUDA_LIBS])
+                                      AC_DEFINE([HAVE_CUDA], [1], [Enable the use of CUDA])
+                                      transports="${transports},cuda"
+                                      cuda_happy="yes"],
+                                     [AS_IF([test "x$with_cuda" != xguess],
+                                            [AC_MSG_WARN([CUDA runtime library not found])])
+                                      AC_DEFINE([HAVE_CUDA], [0], [Disable the use of CUDA])],
+                                     [-L$with_cuda/lib64 -L$with_cuda/lib])],
+                       [AS_IF([test "x$with_cuda" != xguess],
+                              [AC_MSG_WARN([CUDA requested but not found])])
+                        AC_DEFINE([HAVE_CUDA], [0], [Disable the use of CUDA])])],
+      [AC_DEFINE([HAVE_CUDA], [0], [Disable the use of CUDA])]
+)
+
+AM_CONDITIONAL([HAVE_CUDA], [test "x$cuda_happy" != xno])
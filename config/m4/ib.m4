@@ -154,13 +154,19 @@ AS_IF([test "x$with_ib" == xyes],
                        IBV_EVENT_GID_CHANGE],
                       [], [], [[#include <infiniband/verbs.h>]])
 
+       # CQ event moderation (interrupt coalescing)
+       AC_CHECK_DECLS([ibv_modify_cq],
+                      [], [], [[#include <infiniband/verbs.h>]])
+
        AC_CHECK_DECLS([IBV_EXP_CQ_IGNORE_OVERRUN,
+                       IBV_EXP_CQ_COMPRESSED_CQE,
                        IBV_EXP_ACCESS_ALLOCATE_MR,
                        IBV_EXP_ACCESS_ON_DEMAND,
                        IBV_EXP_DEVICE_MR_ALLOCATE,
                        IBV_EXP_WR_NOP,
                        IBV_EXP_DEVICE_DC_TRANSPORT,
                        IBV_EXP_ATOMIC_HCA_REPLY_BE,
+                       IBV_EXP_ODP_SUPPORT_IMPLICIT,
                        IBV_EXP_PREFETCH_WRITE_ACCESS,
                        ibv_exp_reg_mr,
                        ibv_exp_create_qp,
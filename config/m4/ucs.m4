@@ -24,6 +24,22 @@ AS_IF([test "x$enable_profiling" == xyes],
 AM_CONDITIONAL([HAVE_PROFILING],[test "x$HAVE_PROFILING" = "xyes"])
 
 
+#
+# Static tracepoints (SystemTap/USDT). Each probe compiles to a single nop
+# until a tracer attaches, so they are on by default whenever sys/sdt.h is
+# present.
+#
+AC_ARG_ENABLE([tracepoints],
+	AS_HELP_STRING([--disable-tracepoints], [Disable static USDT tracepoints, default: NO]),
+	[],
+	[enable_tracepoints=yes])
+
+AS_IF([test "x$enable_tracepoints" == xyes],
+	[AC_CHECK_HEADERS([sys/sdt.h])],
+	[:]
+)
+
+
 #
 # Detailed backtrace with debug information.
 # This option requires binutils-devel package.
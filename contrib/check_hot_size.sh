@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+#
+# See file LICENSE for terms.
+#
+# Check the code size of hot-path entry points against per-function budgets,
+# to catch error/trace handling creeping back into the fast path. Run it on
+# an optimized build:
+#
+#   contrib/check_hot_size.sh src/ucp/.libs/libucp.so
+#
+# Budgets are in bytes and intentionally loose; the goal is to flag order-of-
+# magnitude regressions, not to pin the exact layout of every compiler.
+
+lib=${1:?usage: $0 <library>}
+
+# <symbol> <budget>
+budgets="
+ucp_tag_send_nb      1536
+ucp_tag_send_sync_nb 1536
+ucp_tag_recv_nb      4096
+ucp_put_nbi          1024
+ucp_get_nbi          1024
+ucp_worker_progress  1024
+"
+
+rc=0
+while read sym budget; do
+    [ -z "$sym" ] && continue
+    hexsize=$(nm --print-size --defined-only "$lib" 2>/dev/null | \
+              awk -v s="$sym" '($4 == s) { print $2 }')
+    if [ -z "$hexsize" ]; then
+        echo "SKIP $sym (not found in $lib)"
+        continue
+    fi
+    size=$((0x$hexsize))
+    if [ "$size" -gt "$budget" ]; then
+        echo "FAIL $sym is $size bytes, budget is $budget"
+        rc=1
+    else
+        echo "OK   $sym is $size bytes (budget $budget)"
+    fi
+done <<EOF
+$budgets
+EOF
+
+exit $rc
@@ -12,6 +12,13 @@
 #include <ucs/debug/log.h>
 #include <ucs/async/async.h>
 #include <ucs/sys/string.h>
+#include <ucs/sys/sys.h>
+#include <ucs/sys/topo.h>
+
+
+/* Message size assumed by the wireup rendezvous score function, see
+ * src/ucp/wireup/select.c */
+#define PERF_EST_RNDV_MSG_SIZE   262144
 
 
 #define PRINT_CAP(_name, _cap_flags, _max) \
@@ -87,8 +94,54 @@ static const char *size_limit_to_str(size_t min_size, size_t max_size)
     return buf;
 }
 
+/* Predict single-peer performance from the same attributes the wireup
+ * selector consumes, with the local interface standing in for the remote
+ * peer. The score triplet matches what select.c would compute for a
+ * loopback pair, so comparing it across devices shows which transport
+ * each lane type would pick. */
+static void print_perf_estimation(uct_md_h md, const uct_iface_attr_t *iface_attr)
+{
+    double latency, rndv_time, numa_factor;
+    uct_md_attr_t md_attr;
+    ucs_status_t status;
+    int node;
+
+    status = uct_md_query(md, &md_attr);
+    if (status != UCS_OK) {
+        return;
+    }
+
+    /* single peer; ucp scales the growth term by the estimated ep count */
+    latency   = iface_attr->latency.overhead + iface_attr->latency.growth;
+    rndv_time = (PERF_EST_RNDV_MSG_SIZE / iface_attr->bandwidth) + latency +
+                iface_attr->overhead + md_attr.reg_cost.overhead +
+                (PERF_EST_RNDV_MSG_SIZE * md_attr.reg_cost.growth);
+
+    numa_factor = 1.0;
+    node        = ucs_sys_get_numa_node();
+    if ((node >= 0) && (iface_attr->numa_node >= 0)) {
+        numa_factor = (double)UCS_TOPO_DISTANCE_LOCAL /
+                      ucs_topo_numa_distance(node, iface_attr->numa_node);
+    }
+
+    printf("#\n");
+    printf("#      estimated performance:\n");
+    printf("#        short latency: %.0f nsec\n",
+           (latency + (2 * iface_attr->overhead)) * 1e9);
+    printf("#         message rate: %.2f Mmsg/sec\n",
+           1e-6 / iface_attr->overhead);
+    printf("#      256kb bandwidth: %.2f MB/sec\n",
+           (PERF_EST_RNDV_MSG_SIZE / rndv_time) / UCS_MBYTE);
+    printf("#         wireup score: am %.3f, rma %.3f, rndv %.3f%s\n",
+           numa_factor * 1e-3 / (latency + (2 * iface_attr->overhead)),
+           numa_factor * 1e-3 / (latency + iface_attr->overhead +
+                                 (4096.0 / iface_attr->bandwidth)),
+           numa_factor / rndv_time,
+           (numa_factor < 1.0) ? " (scaled by numa distance)" : "");
+}
+
 static void print_iface_info(uct_worker_h worker, uct_md_h md,
-                             uct_tl_resource_desc_t *resource)
+                             uct_tl_resource_desc_t *resource, int print_opts)
 {
     uct_iface_config_t *iface_config;
     uct_iface_attr_t iface_attr;
@@ -239,6 +292,10 @@ static void print_iface_info(uct_worker_h worker, uct_md_h md,
             strncat(buf, " none", sizeof(buf) - 1);
         }
         printf("#       error handling:%s\n", buf);
+
+        if (print_opts & PRINT_PERF_EST) {
+            print_perf_estimation(md, &iface_attr);
+        }
     }
 
     uct_iface_close(iface);
@@ -276,7 +333,7 @@ static ucs_status_t print_tl_info(uct_md_h md, const char *tl_name,
     }
     for (i = 0; i < num_resources; ++i) {
         ucs_assert(!strcmp(tl_name, resources[i].tl_name));
-        print_iface_info(worker, md, &resources[i]);
+        print_iface_info(worker, md, &resources[i], print_opts);
     }
 
     uct_worker_destroy(worker);
@@ -19,6 +19,7 @@ static void usage() {
     printf("  -v         Version\n");
     printf("  -s         System\n");
     printf("  -d         Devices\n");
+    printf("  -E         Estimated performance of each device\n");
     printf("  -c         Configuration\n");
     printf("  -p         UCP context\n");
     printf("  -w         UCP worker\n");
@@ -52,7 +53,7 @@ int main(int argc, char **argv)
     tl_name      = NULL;
     ucp_features = 0;
     ucp_num_eps  = 1;
-    while ((c = getopt(argc, argv, "fahvcydbswpet:n:u:")) != -1) {
+    while ((c = getopt(argc, argv, "fahvcydbswpeEt:n:u:")) != -1) {
         switch (c) {
         case 'f':
             print_flags |= UCS_CONFIG_PRINT_CONFIG | UCS_CONFIG_PRINT_HEADER | UCS_CONFIG_PRINT_DOC;
@@ -69,6 +70,9 @@ int main(int argc, char **argv)
         case 'd':
             print_opts |= PRINT_DEVICES;
             break;
+        case 'E':
+            print_opts |= PRINT_DEVICES | PRINT_PERF_EST;
+            break;
         case 'b':
             print_opts |= PRINT_BUILD_CONFIG;
             break;
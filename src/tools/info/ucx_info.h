@@ -19,7 +19,8 @@ enum {
     PRINT_DEVICES        = UCS_BIT(4),
     PRINT_UCP_CONTEXT    = UCS_BIT(5),
     PRINT_UCP_WORKER     = UCS_BIT(6),
-    PRINT_UCP_EP         = UCS_BIT(7)
+    PRINT_UCP_EP         = UCS_BIT(7),
+    PRINT_PERF_EST       = UCS_BIT(8)
 
 };
 
@@ -13,6 +13,15 @@
 #include <string.h>
 #include <malloc.h>
 #include <unistd.h>
+#include <dlfcn.h>
+
+
+const char *ucx_perf_mem_type_names[] = {
+    [UCX_PERF_MEM_TYPE_HOST]      = "host",
+    [UCX_PERF_MEM_TYPE_CUDA]      = "cuda",
+    [UCX_PERF_MEM_TYPE_CUDA_HOST] = "cuda-host",
+    [UCX_PERF_MEM_TYPE_LAST]      = NULL
+};
 
 
 typedef struct {
@@ -89,6 +98,150 @@ static ucs_time_t __find_median_quick_select(ucs_time_t arr[], int n)
     }
 }
 
+/*
+ * CUDA runtime shim. The runtime is loaded with dlopen() on first use, so
+ * the tool builds and runs on machines without CUDA, and tests requesting
+ * GPU memory fail cleanly when the runtime is absent. Device memory is
+ * allocated as managed memory - it resides on the GPU, but the test harness
+ * can still write and poll sequence numbers in it from the CPU.
+ */
+
+/* cudaMemAttachGlobal */
+#define UCX_PERF_CUDA_MEM_ATTACH_GLOBAL  0x01
+
+typedef struct {
+    void  *handle;                                      /* dlopen() handle */
+    int  (*malloc_managed)(void**, size_t, unsigned);   /* cudaMallocManaged */
+    int  (*host_alloc)(void**, size_t, unsigned);       /* cudaHostAlloc */
+    int  (*mem_free)(void*);                            /* cudaFree */
+    int  (*host_free)(void*);                           /* cudaFreeHost */
+} ucx_perf_cuda_rt_t;
+
+static ucx_perf_cuda_rt_t ucx_perf_cuda_rt;
+
+static ucs_status_t ucx_perf_cuda_rt_load(void)
+{
+    static const char *libs[] = {"libcudart.so", "libcudart.so.8.0",
+                                 "libcudart.so.7.5", NULL};
+    ucx_perf_cuda_rt_t *rt = &ucx_perf_cuda_rt;
+    const char **lib;
+
+    if (rt->handle != NULL) {
+        return UCS_OK;
+    }
+
+    for (lib = libs; *lib != NULL; ++lib) {
+        rt->handle = dlopen(*lib, RTLD_LAZY | RTLD_LOCAL);
+        if (rt->handle != NULL) {
+            break;
+        }
+    }
+    if (rt->handle == NULL) {
+        ucs_error("failed to load the CUDA runtime: %s", dlerror());
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    rt->malloc_managed = (int (*)(void**, size_t, unsigned))
+                             dlsym(rt->handle, "cudaMallocManaged");
+    rt->host_alloc     = (int (*)(void**, size_t, unsigned))
+                             dlsym(rt->handle, "cudaHostAlloc");
+    rt->mem_free       = (int (*)(void*))dlsym(rt->handle, "cudaFree");
+    rt->host_free      = (int (*)(void*))dlsym(rt->handle, "cudaFreeHost");
+    if ((rt->malloc_managed == NULL) || (rt->host_alloc == NULL) ||
+        (rt->mem_free == NULL) || (rt->host_free == NULL))
+    {
+        ucs_error("missing symbols in the CUDA runtime");
+        dlclose(rt->handle);
+        rt->handle = NULL;
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t ucx_perf_mem_alloc(ucx_perf_mem_type_t mem_type,
+                                       size_t length, void **address_p)
+{
+    ucs_status_t status;
+    int cuda_err;
+
+    status = ucx_perf_cuda_rt_load();
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    switch (mem_type) {
+    case UCX_PERF_MEM_TYPE_CUDA:
+        cuda_err = ucx_perf_cuda_rt.malloc_managed(address_p, length,
+                                                   UCX_PERF_CUDA_MEM_ATTACH_GLOBAL);
+        break;
+    case UCX_PERF_MEM_TYPE_CUDA_HOST:
+        cuda_err = ucx_perf_cuda_rt.host_alloc(address_p, length, 0);
+        break;
+    default:
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if (cuda_err != 0) {
+        ucs_error("failed to allocate %zu bytes of %s memory: cuda error %d",
+                  length, ucx_perf_mem_type_names[mem_type], cuda_err);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    return UCS_OK;
+}
+
+static void ucx_perf_mem_free(ucx_perf_mem_type_t mem_type, void *address)
+{
+    switch (mem_type) {
+    case UCX_PERF_MEM_TYPE_CUDA:
+        ucx_perf_cuda_rt.mem_free(address);
+        break;
+    case UCX_PERF_MEM_TYPE_CUDA_HOST:
+        ucx_perf_cuda_rt.host_free(address);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Allocate a test buffer of the requested memory type and register it with
+ * the memory domain, mimicking what uct_iface_mem_alloc() produces */
+static ucs_status_t
+uct_perf_test_alloc_mem_type(ucx_perf_context_t *perf,
+                             ucx_perf_mem_type_t mem_type, size_t length,
+                             unsigned flags, uct_allocated_memory_t *mem)
+{
+    ucs_status_t status;
+
+    status = ucx_perf_mem_alloc(mem_type, length, &mem->address);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = uct_md_mem_reg(perf->uct.md, mem->address, length, flags,
+                            &mem->memh);
+    if (status != UCS_OK) {
+        ucs_error("failed to register %s memory: %s",
+                  ucx_perf_mem_type_names[mem_type], ucs_status_string(status));
+        ucx_perf_mem_free(mem_type, mem->address);
+        return status;
+    }
+
+    mem->length = length;
+    mem->method = UCT_ALLOC_METHOD_MD;
+    mem->md     = perf->uct.md;
+    return UCS_OK;
+}
+
+static void uct_perf_test_free_mem_type(ucx_perf_context_t *perf,
+                                        ucx_perf_mem_type_t mem_type,
+                                        uct_allocated_memory_t *mem)
+{
+    uct_md_mem_dereg(perf->uct.md, mem->memh);
+    ucx_perf_mem_free(mem_type, mem->address);
+}
+
 static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
                                             ucx_perf_params_t *params)
 {
@@ -108,9 +261,15 @@ static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
                     UCT_MD_MEM_FLAG_NONBLOCK : 0;
 
     /* Allocate send buffer memory */
-    status = uct_iface_mem_alloc(perf->uct.iface, 
-                                 buffer_size * params->thread_count,
-                                 flags, "perftest", &perf->uct.send_mem);
+    if (params->mem_type == UCX_PERF_MEM_TYPE_HOST) {
+        status = uct_iface_mem_alloc(perf->uct.iface,
+                                     buffer_size * params->thread_count,
+                                     flags, "perftest", &perf->uct.send_mem);
+    } else {
+        status = uct_perf_test_alloc_mem_type(perf, params->mem_type,
+                                              buffer_size * params->thread_count,
+                                              flags, &perf->uct.send_mem);
+    }
     if (status != UCS_OK) {
         ucs_error("Failed allocate send buffer: %s", ucs_status_string(status));
         goto err;
@@ -120,9 +279,15 @@ static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
     perf->send_buffer = perf->uct.send_mem.address;
 
     /* Allocate receive buffer memory */
-    status = uct_iface_mem_alloc(perf->uct.iface, 
-                                 buffer_size * params->thread_count,
-                                 flags, "perftest", &perf->uct.recv_mem);
+    if (params->mem_type == UCX_PERF_MEM_TYPE_HOST) {
+        status = uct_iface_mem_alloc(perf->uct.iface,
+                                     buffer_size * params->thread_count,
+                                     flags, "perftest", &perf->uct.recv_mem);
+    } else {
+        status = uct_perf_test_alloc_mem_type(perf, params->mem_type,
+                                              buffer_size * params->thread_count,
+                                              flags, &perf->uct.recv_mem);
+    }
     if (status != UCS_OK) {
         ucs_error("Failed allocate receive buffer: %s", ucs_status_string(status));
         goto err_free_send;
@@ -150,15 +315,26 @@ static ucs_status_t uct_perf_test_alloc_mem(ucx_perf_context_t *perf,
     return UCS_OK;
 
 err_free_send:
-    uct_iface_mem_free(&perf->uct.send_mem);
+    if (params->mem_type == UCX_PERF_MEM_TYPE_HOST) {
+        uct_iface_mem_free(&perf->uct.send_mem);
+    } else {
+        uct_perf_test_free_mem_type(perf, params->mem_type, &perf->uct.send_mem);
+    }
 err:
     return status;
 }
 
 static void uct_perf_test_free_mem(ucx_perf_context_t *perf)
 {
-    uct_iface_mem_free(&perf->uct.send_mem);
-    uct_iface_mem_free(&perf->uct.recv_mem);
+    if (perf->params.mem_type == UCX_PERF_MEM_TYPE_HOST) {
+        uct_iface_mem_free(&perf->uct.send_mem);
+        uct_iface_mem_free(&perf->uct.recv_mem);
+    } else {
+        uct_perf_test_free_mem_type(perf, perf->params.mem_type,
+                                    &perf->uct.send_mem);
+        uct_perf_test_free_mem_type(perf, perf->params.mem_type,
+                                    &perf->uct.recv_mem);
+    }
     free(perf->uct.iov);
 }
 
@@ -195,6 +371,103 @@ static void ucx_perf_test_reset(ucx_perf_context_t *perf,
     for (i = 0; i < TIMING_QUEUE_SIZE; ++i) {
         perf->timing_queue[i] = 0;
     }
+    memset(perf->lat_hist, 0, sizeof(perf->lat_hist));
+    perf->lat_samples       = NULL;
+    perf->num_lat_samples   = 0;
+    perf->max_lat_samples   = 0;
+}
+
+/* Lower end of a histogram bucket plus half of the bucket width, the
+ * inverse of ucx_perf_hist_bucket() */
+static ucs_time_t ucx_perf_hist_bucket_value(unsigned bucket)
+{
+    unsigned k, sub;
+
+    if (bucket < 2 * UCX_PERF_HIST_NUM_SUB) {
+        return bucket;
+    }
+    k   = bucket >> UCX_PERF_HIST_SUB_BITS;
+    sub = bucket & (UCX_PERF_HIST_NUM_SUB - 1);
+    return ((ucs_time_t)(UCX_PERF_HIST_NUM_SUB + sub) << (k - 1)) +
+           (((ucs_time_t)1 << (k - 1)) / 2);
+}
+
+static double ucx_perf_hist_percentile(ucx_perf_context_t *perf, double fraction)
+{
+    ucx_perf_counter_t total, target, count;
+    unsigned bucket;
+
+    total = 0;
+    for (bucket = 0; bucket < UCX_PERF_HIST_BUCKETS; ++bucket) {
+        total += perf->lat_hist[bucket];
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    target = (ucx_perf_counter_t)(total * fraction);
+    count  = 0;
+    for (bucket = 0; bucket < UCX_PERF_HIST_BUCKETS; ++bucket) {
+        count += perf->lat_hist[bucket];
+        if (count > target) {
+            break;
+        }
+    }
+    return (double)ucx_perf_hist_bucket_value(ucs_min(bucket,
+                                                      UCX_PERF_HIST_BUCKETS - 1));
+}
+
+static void ucx_perf_lat_dump_alloc(ucx_perf_context_t *perf)
+{
+    /* Bound the sample buffer so a time-limited run cannot grow it forever */
+    const size_t max_samples = 16 * 1024 * 1024;
+
+    if (perf->params.lat_dump_file[0] == '\0') {
+        return;
+    }
+
+    perf->max_lat_samples = ucs_min(perf->max_iter, max_samples);
+    perf->num_lat_samples = 0;
+    perf->lat_samples     = malloc(perf->max_lat_samples *
+                                   sizeof(*perf->lat_samples));
+    if (perf->lat_samples == NULL) {
+        ucs_warn("failed to allocate %zu latency samples, dump is disabled",
+                 perf->max_lat_samples);
+    }
+}
+
+/* Write the raw samples collected during the test, one value per line, in
+ * usec. tid >= 0 appends a per-thread suffix to the file name */
+static void ucx_perf_lat_dump(ucx_perf_context_t *perf, int tid)
+{
+    char filename[sizeof(perf->params.lat_dump_file) + 16];
+    size_t i;
+    FILE *f;
+
+    if (perf->lat_samples == NULL) {
+        return;
+    }
+
+    if (tid >= 0) {
+        snprintf(filename, sizeof(filename), "%s.%d",
+                 perf->params.lat_dump_file, tid);
+    } else {
+        snprintf(filename, sizeof(filename), "%s",
+                 perf->params.lat_dump_file);
+    }
+
+    f = fopen(filename, "w");
+    if (f == NULL) {
+        ucs_warn("failed to open latency dump file '%s': %m", filename);
+    } else {
+        for (i = 0; i < perf->num_lat_samples; ++i) {
+            fprintf(f, "%.3f\n", ucs_time_to_usec(perf->lat_samples[i]));
+        }
+        fclose(f);
+    }
+
+    free(perf->lat_samples);
+    perf->lat_samples = NULL;
 }
 
 void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result)
@@ -232,6 +505,16 @@ void ucx_perf_calc_result(ucx_perf_context_t *perf, ucx_perf_result_t *result)
         / sec_value
         / factor;
 
+    result->latency.percentile_99 =
+        ucx_perf_hist_percentile(perf, 0.99)
+        / sec_value
+        / factor;
+
+    result->latency.percentile_999 =
+        ucx_perf_hist_percentile(perf, 0.999)
+        / sec_value
+        / factor;
+
 
     /* Bandwidth */
 
@@ -765,8 +1048,17 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf, ucx_perf_p
         buffer_size           = ucx_perf_get_message_size(params);
     }
 
-    /* Allocate send buffer memory */
+    /* Allocate send buffer memory. For non-host memory types the buffer is
+     * allocated here and only registered by ucp_mem_map(). */
     perf->send_buffer         = NULL;
+    if (params->mem_type != UCX_PERF_MEM_TYPE_HOST) {
+        status = ucx_perf_mem_alloc(params->mem_type,
+                                    buffer_size * params->thread_count,
+                                    &perf->send_buffer);
+        if (status != UCS_OK) {
+            goto err;
+        }
+    }
 
     mem_map_params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
                                 UCP_MEM_MAP_PARAM_FIELD_LENGTH |
@@ -775,12 +1067,14 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf, ucx_perf_p
     mem_map_params.length     = buffer_size * params->thread_count;
     mem_map_params.flags      = (params->flags & UCX_PERF_TEST_FLAG_MAP_NONBLOCK) ?
                                  UCP_MEM_MAP_NONBLOCK : 0;
-    mem_map_params.flags     |= UCP_MEM_MAP_ALLOCATE;
+    if (params->mem_type == UCX_PERF_MEM_TYPE_HOST) {
+        mem_map_params.flags |= UCP_MEM_MAP_ALLOCATE;
+    }
 
     status = ucp_mem_map(perf->ucp.context, &mem_map_params,
                          &perf->ucp.send_memh);
     if (status != UCS_OK) {
-        goto err;
+        goto err_free_send_mem;
     }
 
     mem_attr.field_mask = UCP_MEM_ATTR_FIELD_ADDRESS;
@@ -793,17 +1087,26 @@ static ucs_status_t ucp_perf_test_alloc_mem(ucx_perf_context_t *perf, ucx_perf_p
 
     /* Allocate receive buffer memory */
     perf->recv_buffer = NULL;
+    if (params->mem_type != UCX_PERF_MEM_TYPE_HOST) {
+        status = ucx_perf_mem_alloc(params->mem_type,
+                                    buffer_size * params->thread_count,
+                                    &perf->recv_buffer);
+        if (status != UCS_OK) {
+            goto err_free_send_buffer;
+        }
+    }
 
     mem_map_params.field_mask = UCP_MEM_MAP_PARAM_FIELD_ADDRESS |
                                 UCP_MEM_MAP_PARAM_FIELD_LENGTH |
                                 UCP_MEM_MAP_PARAM_FIELD_FLAGS;
     mem_map_params.address    = perf->recv_buffer;
     mem_map_params.length     = buffer_size * params->thread_count;
-    mem_map_params.flags      = UCP_MEM_MAP_ALLOCATE;
+    mem_map_params.flags      = (params->mem_type == UCX_PERF_MEM_TYPE_HOST) ?
+                                UCP_MEM_MAP_ALLOCATE : 0;
 
     status = ucp_mem_map(perf->ucp.context, &mem_map_params, &perf->ucp.recv_memh);
     if (status != UCS_OK) {
-        goto err_free_send_buffer;
+        goto err_free_recv_mem;
     }
 
     mem_attr.field_mask = UCP_MEM_ATTR_FIELD_ADDRESS;
@@ -836,8 +1139,16 @@ err_free_send_iov_buffers:
     free(perf->ucp.send_iov);
 err_free_buffers:
     ucp_mem_unmap(perf->ucp.context, perf->ucp.recv_memh);
+err_free_recv_mem:
+    if (params->mem_type != UCX_PERF_MEM_TYPE_HOST) {
+        ucx_perf_mem_free(params->mem_type, perf->recv_buffer);
+    }
 err_free_send_buffer:
     ucp_mem_unmap(perf->ucp.context, perf->ucp.send_memh);
+err_free_send_mem:
+    if (params->mem_type != UCX_PERF_MEM_TYPE_HOST) {
+        ucx_perf_mem_free(params->mem_type, perf->send_buffer);
+    }
 err:
     return UCS_ERR_NO_MEMORY;
 }
@@ -848,6 +1159,10 @@ static void ucp_perf_test_free_mem(ucx_perf_context_t *perf)
     free(perf->ucp.send_iov);
     ucp_mem_unmap(perf->ucp.context, perf->ucp.recv_memh);
     ucp_mem_unmap(perf->ucp.context, perf->ucp.send_memh);
+    if (perf->params.mem_type != UCX_PERF_MEM_TYPE_HOST) {
+        ucx_perf_mem_free(perf->params.mem_type, perf->recv_buffer);
+        ucx_perf_mem_free(perf->params.mem_type, perf->send_buffer);
+    }
 }
 
 static void ucp_perf_test_destroy_eps(ucx_perf_context_t* perf,
@@ -1250,8 +1565,144 @@ static struct {
     [UCX_PERF_API_UCP] = {ucp_perf_setup, ucp_perf_cleanup, ucp_perf_test_dispatch}
 };
 
-static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
-                                 ucx_perf_result_t* result);
+static ucs_status_t ucx_perf_thread_spawn(ucx_perf_context_t *perf,
+                                          ucx_perf_result_t* result);
+
+static const char *uct_perf_data_layout_names[] = {
+    [UCT_PERF_DATA_LAYOUT_SHORT] = "short",
+    [UCT_PERF_DATA_LAYOUT_BCOPY] = "bcopy",
+    [UCT_PERF_DATA_LAYOUT_ZCOPY] = "zcopy"
+};
+
+size_t ucx_perf_sweep_next_size(const ucx_perf_params_t *params, size_t size)
+{
+    size_t next = ucs_max(size + 1, (size_t)((size * params->sweep_factor) + 0.5));
+    return ucs_min(next, params->sweep_max);
+}
+
+size_t ucx_perf_sweep_num_sizes(const ucx_perf_params_t *params)
+{
+    size_t size, count;
+
+    count = 1;
+    for (size = params->sweep_min; size < params->sweep_max;
+         size = ucx_perf_sweep_next_size(params, size))
+    {
+        ++count;
+    }
+    return count;
+}
+
+static ucs_status_t ucx_perf_sweep_check_params(ucx_perf_params_t *params)
+{
+    if ((params->sweep_min < 1) || (params->sweep_max < params->sweep_min) ||
+        (params->sweep_factor <= 1.0)) {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Invalid sweep range, need max >= min >= 1 and factor > 1");
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if (params->msg_size_cnt != 1) {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Sweep cannot be combined with a message size list");
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if (params->thread_mode != UCS_THREAD_MODE_SINGLE) {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Sweep supports only a single thread");
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    if ((params->flags & UCX_PERF_TEST_FLAG_CALIBRATE) &&
+        (params->api != UCX_PERF_API_UCT)) {
+        if (params->flags & UCX_PERF_TEST_FLAG_VERBOSE) {
+            ucs_error("Calibration works on the UCT API only");
+        }
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    return UCS_OK;
+}
+
+/* Run the whole message size series (for calibration - once per data layout)
+ * over the connections established by a single setup. Both sides execute this
+ * loop from the same exchanged parameters, so they advance in lockstep.
+ */
+static ucs_status_t ucx_perf_sweep_run(ucx_perf_context_t *perf,
+                                       ucx_perf_params_t *params,
+                                       ucx_perf_result_t *result)
+{
+    uct_perf_data_layout_t layouts[UCT_PERF_DATA_LAYOUT_LAST];
+    uct_perf_data_layout_t orig_layout;
+    unsigned li, num_layouts;
+    ucs_status_t status;
+    char label[64];
+    size_t size, ri;
+
+    orig_layout = params->uct.data_layout;
+    if (params->flags & UCX_PERF_TEST_FLAG_CALIBRATE) {
+        layouts[0]  = UCT_PERF_DATA_LAYOUT_SHORT;
+        layouts[1]  = UCT_PERF_DATA_LAYOUT_BCOPY;
+        layouts[2]  = UCT_PERF_DATA_LAYOUT_ZCOPY;
+        num_layouts = 3;
+    } else {
+        layouts[0]  = orig_layout;
+        num_layouts = 1;
+    }
+
+    ri     = 0;
+    status = UCS_OK;
+    for (li = 0; li < num_layouts; ++li) {
+        params->uct.data_layout = layouts[li];
+        size = params->sweep_min;
+        for (;;) {
+            params->msg_size_list[0] = size;
+
+            if (params->warmup_iter > 0) {
+                ucx_perf_test_reset(perf, params);
+                ucx_perf_set_warmup(perf, params);
+                status = ucx_perf_funcs[params->api].run(perf);
+                if (status != UCS_OK) {
+                    goto out;
+                }
+                rte_call(perf, barrier);
+            }
+
+            ucx_perf_test_reset(perf, params);
+            status = ucx_perf_funcs[params->api].run(perf);
+            rte_call(perf, barrier);
+            if (status != UCS_OK) {
+                goto out;
+            }
+
+            ucx_perf_calc_result(perf, result);
+            if (num_layouts > 1) {
+                snprintf(label, sizeof(label), "%s %zu",
+                         uct_perf_data_layout_names[layouts[li]], size);
+            } else {
+                snprintf(label, sizeof(label), "%zu", size);
+            }
+            rte_call(perf, report, result, perf->params.report_arg, label, 1);
+            if (params->sweep_results != NULL) {
+                params->sweep_results[ri] = *result;
+            }
+            ++ri;
+
+            if (size >= params->sweep_max) {
+                break;
+            }
+            size = ucx_perf_sweep_next_size(params, size);
+        }
+    }
+
+out:
+    params->uct.data_layout = orig_layout;
+    return status;
+}
 
 ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result)
 {
@@ -1270,6 +1721,16 @@ ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result)
         goto out;
     }
 
+    if (params->sweep_min > 0) {
+        status = ucx_perf_sweep_check_params(params);
+        if (status != UCS_OK) {
+            goto out;
+        }
+        /* Allocate buffers and check capabilities at the largest size, so the
+         * connections established here serve the whole series */
+        params->msg_size_list[0] = params->sweep_max;
+    }
+
     perf = malloc(sizeof(*perf));
     if (perf == NULL) {
         status = UCS_ERR_NO_MEMORY;
@@ -1278,12 +1739,17 @@ ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result)
 
     ucx_perf_test_reset(perf, params);
 
-    status = ucx_perf_funcs[params->api].setup(perf, params);
-    if (status != UCS_OK) {
-        goto out_free;
-    }
-
     if (UCS_THREAD_MODE_SINGLE == params->thread_mode) {
+        status = ucx_perf_funcs[params->api].setup(perf, params);
+        if (status != UCS_OK) {
+            goto out_free;
+        }
+
+        if (params->sweep_min > 0) {
+            status = ucx_perf_sweep_run(perf, params, result);
+            goto out_cleanup;
+        }
+
         if (params->warmup_iter > 0) {
             ucx_perf_set_warmup(perf, params);
             status = ucx_perf_funcs[params->api].run(perf);
@@ -1296,18 +1762,21 @@ ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result)
         }
 
         /* Run test */
+        ucx_perf_lat_dump_alloc(perf);
         status = ucx_perf_funcs[params->api].run(perf);
         rte_call(perf, barrier);
         if (status == UCS_OK) {
             ucx_perf_calc_result(perf, result);
-            rte_call(perf, report, result, perf->params.report_arg, 1);
+            rte_call(perf, report, result, perf->params.report_arg, "", 1);
         }
+        ucx_perf_lat_dump(perf, -1);
+
+out_cleanup:
+        ucx_perf_funcs[params->api].cleanup(perf);
     } else {
         status = ucx_perf_thread_spawn(perf, result);
     }
 
-out_cleanup:
-    ucx_perf_funcs[params->api].cleanup(perf);
 out_free:
     free(perf);
 out:
@@ -1315,11 +1784,11 @@ out:
 }
 
 #if _OPENMP
-/* multiple threads sharing the same worker/iface */
+/* multiple threads driving the same test, either sharing one worker/iface or
+ * each with its own (UCX_PERF_TEST_FLAG_THREAD_WORKER) */
 #include <omp.h>
 
 typedef struct {
-    pthread_t           pt;
     int                 tid;
     int                 ntid;
     ucs_status_t*       statuses;
@@ -1331,10 +1800,10 @@ typedef struct {
 static void* ucx_perf_thread_run_test(void* arg)
 {
     ucx_perf_thread_context_t* tctx = (ucx_perf_thread_context_t*) arg;
-    ucx_perf_result_t* result = &tctx->result;
     ucx_perf_context_t* perf = &tctx->perf;
     ucx_perf_params_t* params = &perf->params;
     ucs_status_t* statuses = tctx->statuses;
+    ptrdiff_t offset = perf->offset;
     int tid = tctx->tid;
     int i;
 
@@ -1347,11 +1816,12 @@ static void* ucx_perf_thread_run_test(void* arg)
                 goto out;
             }
         }
-#pragma omp master
         ucx_perf_test_reset(perf, params);
+        perf->offset = offset; /* reset() zeroes the thread's buffer offset */
     }
 
     /* Run test */
+    ucx_perf_lat_dump_alloc(perf);
 #pragma omp barrier
     statuses[tid] = ucx_perf_funcs[params->api].run(perf);
     rte_call(perf, barrier);
@@ -1360,21 +1830,56 @@ static void* ucx_perf_thread_run_test(void* arg)
             goto out;
         }
     }
-#pragma omp master
-    {
-        /* Assuming all threads are fairly treated, reporting only tid==0
-            TODO: aggregate reports */
-        ucx_perf_calc_result(perf, result);
-        rte_call(perf, report, result, perf->params.report_arg, 1);
-    }
+    ucx_perf_calc_result(perf, &tctx->result);
 
 out:
+    ucx_perf_lat_dump(perf, tid);
     return &statuses[tid];
 }
 
-static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
-                                 ucx_perf_result_t* result)
+/* Report every thread separately, then an aggregate where bandwidth and
+ * message rate are summed over the threads and latency is averaged */
+static void ucx_perf_thread_report_aggregated(ucx_perf_context_t *perf,
+                                              ucx_perf_thread_context_t *tctx,
+                                              int nti, ucx_perf_result_t *result)
 {
+    ucx_perf_result_t *tres;
+    char extra_info[32];
+    int ti;
+
+    memset(result, 0, sizeof(*result));
+    for (ti = 0; ti < nti; ti++) {
+        tres = &tctx[ti].result;
+        snprintf(extra_info, sizeof(extra_info), "thread %d", ti);
+        rte_call(perf, report, tres, perf->params.report_arg, extra_info, 1);
+
+        result->iters                    += tres->iters;
+        result->bytes                    += tres->bytes;
+        result->elapsed_time              = ucs_max(result->elapsed_time,
+                                                    tres->elapsed_time);
+        result->latency.typical          += tres->latency.typical / nti;
+        result->latency.moment_average   += tres->latency.moment_average / nti;
+        result->latency.total_average    += tres->latency.total_average / nti;
+        result->latency.percentile_99     = ucs_max(result->latency.percentile_99,
+                                                    tres->latency.percentile_99);
+        result->latency.percentile_999    = ucs_max(result->latency.percentile_999,
+                                                    tres->latency.percentile_999);
+        result->bandwidth.typical        += tres->bandwidth.typical;
+        result->bandwidth.moment_average += tres->bandwidth.moment_average;
+        result->bandwidth.total_average  += tres->bandwidth.total_average;
+        result->msgrate.typical          += tres->msgrate.typical;
+        result->msgrate.moment_average   += tres->msgrate.moment_average;
+        result->msgrate.total_average    += tres->msgrate.total_average;
+    }
+
+    snprintf(extra_info, sizeof(extra_info), "total (%d threads)", nti);
+    rte_call(perf, report, result, perf->params.report_arg, extra_info, 1);
+}
+
+static ucs_status_t ucx_perf_thread_spawn(ucx_perf_context_t *perf,
+                                          ucx_perf_result_t* result)
+{
+    int thread_worker = perf->params.flags & UCX_PERF_TEST_FLAG_THREAD_WORKER;
     ucx_perf_thread_context_t* tctx;
     ucs_status_t* statuses;
     size_t message_size;
@@ -1392,17 +1897,48 @@ static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
         goto out_free;
     }
 
+    for (ti = 0; ti < nti; ti++) {
+        tctx[ti].tid      = ti;
+        tctx[ti].ntid     = nti;
+        tctx[ti].statuses = statuses;
+    }
+
+    if (thread_worker) {
+        /* Bring up a worker and connections per thread. The setups run one at
+         * a time so the address exchanges over the RTE pair up with the same
+         * thread on the remote side. Each worker is driven by a single thread,
+         * so it does not need a thread-safe progress engine */
+        for (ti = 0; ti < nti; ti++) {
+            tctx[ti].perf                     = *perf;
+            tctx[ti].perf.params.thread_mode  = UCS_THREAD_MODE_SINGLE;
+            tctx[ti].perf.params.thread_count = 1;
+            status = ucx_perf_funcs[perf->params.api].setup(&tctx[ti].perf,
+                                                            &tctx[ti].perf.params);
+            if (status != UCS_OK) {
+                while (ti-- > 0) {
+                    ucx_perf_funcs[perf->params.api].cleanup(&tctx[ti].perf);
+                }
+                goto out_free;
+            }
+        }
+    } else {
+        status = ucx_perf_funcs[perf->params.api].setup(perf, &perf->params);
+        if (status != UCS_OK) {
+            goto out_free;
+        }
+
+        for (ti = 0; ti < nti; ti++) {
+            tctx[ti].perf = *perf;
+            /* Doctor the src and dst buffers to make them thread specific */
+            tctx[ti].perf.send_buffer += ti * message_size;
+            tctx[ti].perf.recv_buffer += ti * message_size;
+            tctx[ti].perf.offset = ti * message_size;
+        }
+    }
+
 #pragma omp parallel private(ti)
 {
     ti = omp_get_thread_num();
-    tctx[ti].tid = ti;
-    tctx[ti].ntid = nti;
-    tctx[ti].statuses = statuses;
-    tctx[ti].perf = *perf;
-    /* Doctor the src and dst buffers to make them thread specific */
-    tctx[ti].perf.send_buffer += ti * message_size;
-    tctx[ti].perf.recv_buffer += ti * message_size;
-    tctx[ti].perf.offset = ti * message_size;
     ucx_perf_thread_run_test((void*)&tctx[ti]);
 }
 
@@ -1415,14 +1951,26 @@ static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
         }
     }
 
+    if (UCS_OK == status) {
+        ucx_perf_thread_report_aggregated(perf, tctx, nti, result);
+    }
+
+    if (thread_worker) {
+        for (ti = 0; ti < nti; ti++) {
+            ucx_perf_funcs[perf->params.api].cleanup(&tctx[ti].perf);
+        }
+    } else {
+        ucx_perf_funcs[perf->params.api].cleanup(perf);
+    }
+
 out_free:
     free(statuses);
     free(tctx);
     return status;
 }
 #else
-static int ucx_perf_thread_spawn(ucx_perf_context_t *perf,
-                                 ucx_perf_result_t* result) {
+static ucs_status_t ucx_perf_thread_spawn(ucx_perf_context_t *perf,
+                                          ucx_perf_result_t* result) {
     ucs_error("Invalid test parameter (thread mode requested without OpenMP capabilities)");
     return UCS_ERR_INVALID_PARAM;
 }
@@ -36,6 +36,9 @@ typedef enum {
     UCX_PERF_CMD_SWAP,
     UCX_PERF_CMD_CSWAP,
     UCX_PERF_CMD_TAG,
+    UCX_PERF_CMD_PUT_FLUSH,   /* Put burst followed by endpoint flush */
+    UCX_PERF_CMD_PUT_WFLUSH,  /* Put burst followed by worker flush */
+    UCX_PERF_CMD_PUT_FENCE,   /* Fence-separated put chain */
     UCX_PERF_CMD_LAST
 } ucx_perf_cmd_t;
 
@@ -62,6 +65,18 @@ typedef enum {
 } uct_perf_data_layout_t;
 
 
+typedef enum {
+    UCX_PERF_MEM_TYPE_HOST,          /* Regular host memory */
+    UCX_PERF_MEM_TYPE_CUDA,          /* GPU device memory (CUDA managed) */
+    UCX_PERF_MEM_TYPE_CUDA_HOST,     /* Pinned host memory (CUDA host alloc) */
+    UCX_PERF_MEM_TYPE_LAST
+} ucx_perf_mem_type_t;
+
+
+/* Memory type names, indexed by ucx_perf_mem_type_t */
+extern const char *ucx_perf_mem_type_names[];
+
+
 typedef enum {
     UCX_PERF_WAIT_MODE_PROGRESS,     /* Repeatedly call progress */
     UCX_PERF_WAIT_MODE_SLEEP,        /* Go to sleep */
@@ -77,7 +92,12 @@ enum ucx_perf_test_flags {
     UCX_PERF_TEST_FLAG_MAP_NONBLOCK = UCS_BIT(3), /* Map memory in non-blocking mode */
     UCX_PERF_TEST_FLAG_TAG_WILDCARD = UCS_BIT(4), /* For tag tests, use wildcard mask */
     UCX_PERF_TEST_FLAG_TAG_SYNC     = UCS_BIT(5), /* For tag tests, use sync send */
-    UCX_PERF_TEST_FLAG_VERBOSE      = UCS_BIT(7)  /* Print error messages */
+    UCX_PERF_TEST_FLAG_THREAD_WORKER= UCS_BIT(6), /* Each test thread creates its own
+                                                     worker and connections */
+    UCX_PERF_TEST_FLAG_VERBOSE      = UCS_BIT(7), /* Print error messages */
+    UCX_PERF_TEST_FLAG_CALIBRATE    = UCS_BIT(8)  /* In sweep mode, measure all UCT data
+                                                     layouts to find the protocol
+                                                     crossover points */
 };
 
 enum {
@@ -100,12 +120,19 @@ typedef struct ucx_perf_result {
     ucx_perf_counter_t      iters;
     double                  elapsed_time;
     ucx_perf_counter_t      bytes;
+    struct {
+        double              typical;
+        double              moment_average; /* Average since last report */
+        double              total_average;  /* Average of the whole test */
+        double              percentile_99;  /* 99th percentile of the whole test */
+        double              percentile_999; /* 99.9th percentile of the whole test */
+    } latency;
     struct {
         double              typical;
         double              moment_average; /* Average since last report */
         double              total_average;  /* Average of the whole test */
     }
-    latency, bandwidth, msgrate;
+    bandwidth, msgrate;
 } ucx_perf_result_t;
 
 
@@ -129,9 +156,10 @@ typedef struct ucx_perf_rte {
                         void *req);
     void        (*exchange_vec)(void *rte_group, void *req);
 
-    /* Handle results */
+    /* Handle results. extra_info annotates the result (e.g which thread it
+     * belongs to), and is an empty string for a plain report */
     void        (*report)(void *rte_group, const ucx_perf_result_t *result,
-                          void *arg, int is_final);
+                          void *arg, const char *extra_info, int is_final);
 
 } ucx_perf_rte_t;
 
@@ -158,11 +186,22 @@ typedef struct ucx_perf_params {
                                                similar to UCT uct_iov_t type stride */
     size_t                 am_hdr_size;     /* Active message header size (included in message size) */
     size_t                 alignment;       /* Message buffer alignment */
+    ucx_perf_mem_type_t    mem_type;        /* Memory type for the test buffers */
     unsigned               max_outstanding; /* Maximal number of outstanding sends */
     ucx_perf_counter_t     warmup_iter;     /* Number of warm-up iterations */
     ucx_perf_counter_t     max_iter;        /* Iterations limit, 0 - unlimited */
     double                 max_time;        /* Time limit (seconds), 0 - unlimited */
     double                 report_interval; /* Interval at which to call the report callback */
+    char                   lat_dump_file[256]; /* If non-empty, path of a file to dump
+                                                  the raw latency samples to */
+
+    size_t                 sweep_min;       /* Sweep mode: smallest message size
+                                               (0 - sweep disabled) */
+    size_t                 sweep_max;       /* Sweep mode: largest message size */
+    double                 sweep_factor;    /* Geometric step between sweep sizes */
+    ucx_perf_result_t      *sweep_results;  /* If non-NULL, filled with one result per
+                                               sweep point, sizes innermost. Local
+                                               side only - not sent to the peer */
 
     void                   *rte_group;      /* Opaque RTE group handle */
     ucx_perf_rte_t         *rte;            /* RTE functions used to exchange data */
@@ -190,6 +229,14 @@ typedef struct ucx_perf_params {
 ucs_status_t ucx_perf_run(ucx_perf_params_t *params, ucx_perf_result_t *result);
 
 
+/**
+ * Next message size of a sweep series, and the number of sizes in it.
+ */
+size_t ucx_perf_sweep_next_size(const ucx_perf_params_t *params, size_t size);
+
+size_t ucx_perf_sweep_num_sizes(const ucx_perf_params_t *params);
+
+
 END_C_DECLS
 
 #endif /* UCX_PERF_H_ */
@@ -15,11 +15,19 @@ BEGIN_C_DECLS
 
 #include <ucs/time/time.h>
 #include <ucs/async/async.h>
+#include <ucs/arch/bitops.h>
 
 
 #define TIMING_QUEUE_SIZE    2048
 #define UCT_PERF_TEST_AM_ID  5
 
+/* Log-bucketed latency histogram: every power of two is split into
+ * 2^UCX_PERF_HIST_SUB_BITS sub-buckets, so the relative error of a bucket is
+ * bounded and recording a sample is a handful of integer operations */
+#define UCX_PERF_HIST_SUB_BITS  3
+#define UCX_PERF_HIST_NUM_SUB   (1 << UCX_PERF_HIST_SUB_BITS)
+#define UCX_PERF_HIST_BUCKETS   512
+
 
 typedef struct ucx_perf_context  ucx_perf_context_t;
 typedef struct uct_peer          uct_peer_t;
@@ -49,6 +57,10 @@ struct ucx_perf_context {
 
     ucs_time_t                   timing_queue[TIMING_QUEUE_SIZE];
     unsigned                     timing_queue_head;
+    ucx_perf_counter_t           lat_hist[UCX_PERF_HIST_BUCKETS];
+    ucs_time_t                   *lat_samples;
+    size_t                       num_lat_samples;
+    size_t                       max_lat_samples;
 
     union {
         struct {
@@ -118,23 +130,43 @@ static UCS_F_ALWAYS_INLINE int ucx_perf_context_done(ucx_perf_context_t *perf)
 }
 
 
+static UCS_F_ALWAYS_INLINE unsigned ucx_perf_hist_bucket(ucs_time_t sample)
+{
+    unsigned log;
+
+    if (sample < 2 * UCX_PERF_HIST_NUM_SUB) {
+        return sample;
+    }
+    log = ucs_ilog2(sample);
+    return ((log - UCX_PERF_HIST_SUB_BITS + 1) << UCX_PERF_HIST_SUB_BITS) +
+           ((sample >> (log - UCX_PERF_HIST_SUB_BITS)) - UCX_PERF_HIST_NUM_SUB);
+}
+
+
 static inline void ucx_perf_update(ucx_perf_context_t *perf, ucx_perf_counter_t iters,
                                    size_t bytes)
 {
     ucx_perf_result_t result;
+    ucs_time_t sample;
 
     perf->current.time   = ucs_get_time();
     perf->current.iters += iters;
     perf->current.bytes += bytes;
     perf->current.msgs  += 1;
 
-    perf->timing_queue[perf->timing_queue_head++] = perf->current.time - perf->prev_time;
+    sample = perf->current.time - perf->prev_time;
+    perf->timing_queue[perf->timing_queue_head++] = sample;
     perf->timing_queue_head %= TIMING_QUEUE_SIZE;
+    ++perf->lat_hist[ucx_perf_hist_bucket(sample)];
+    if (ucs_unlikely(perf->lat_samples != NULL) &&
+        (perf->num_lat_samples < perf->max_lat_samples)) {
+        perf->lat_samples[perf->num_lat_samples++] = sample;
+    }
     perf->prev_time = perf->current.time;
 
     if (perf->current.time - perf->prev.time >= perf->report_interval) {
         ucx_perf_calc_result(perf, &result);
-        rte_call(perf, report, &result, perf->params.report_arg, 0);
+        rte_call(perf, report, &result, perf->params.report_arg, "", 0);
         perf->prev = perf->current;
     }
 }
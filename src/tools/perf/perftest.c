@@ -27,7 +27,9 @@
 #include <getopt.h>
 #include <string.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <locale.h>
+#include <pthread.h>
 #if HAVE_MPI
 #  include <mpi.h>
 #elif HAVE_RTE
@@ -43,7 +45,9 @@ enum {
     TEST_FLAG_SET_AFFINITY  = UCS_BIT(8),
     TEST_FLAG_NUMERIC_FMT   = UCS_BIT(9),
     TEST_FLAG_PRINT_FINAL   = UCS_BIT(10),
-    TEST_FLAG_PRINT_CSV     = UCS_BIT(11)
+    TEST_FLAG_PRINT_CSV     = UCS_BIT(11),
+    TEST_FLAG_LOOPBACK_MATRIX = UCS_BIT(12),
+    TEST_FLAG_SKIP_HEADER   = UCS_BIT(13)
 };
 
 typedef struct sock_rte_group {
@@ -75,10 +79,12 @@ struct perftest_context {
     char                         *batch_files[MAX_BATCH_FILES];
     char                         *test_names[MAX_BATCH_FILES];
 
+    unsigned                     num_clients;
+
     sock_rte_group_t             sock_rte_group;
 };
 
-#define TEST_PARAMS_ARGS   "t:n:s:W:O:w:D:i:H:oSCqM:T:d:x:A:B"
+#define TEST_PARAMS_ARGS   "t:n:s:W:O:w:D:i:H:oSCqM:T:d:x:A:BR:z:ya:"
 
 
 test_type_t tests[] = {
@@ -139,6 +145,15 @@ test_type_t tests[] = {
     {"ucp_cswap", UCX_PERF_API_UCP, UCX_PERF_CMD_CSWAP, UCX_PERF_TEST_TYPE_STREAM_UNI,
      "UCP atomic compare-and-swap latency / bandwidth / message rate"},
 
+    {"ucp_put_flush", UCX_PERF_API_UCP, UCX_PERF_CMD_PUT_FLUSH, UCX_PERF_TEST_TYPE_STREAM_UNI,
+     "UCP put burst + endpoint flush latency (burst size set by -O)"},
+
+    {"ucp_put_wflush", UCX_PERF_API_UCP, UCX_PERF_CMD_PUT_WFLUSH, UCX_PERF_TEST_TYPE_STREAM_UNI,
+     "UCP put burst + worker flush latency (burst size set by -O)"},
+
+    {"ucp_put_fence", UCX_PERF_API_UCP, UCX_PERF_CMD_PUT_FENCE, UCX_PERF_TEST_TYPE_STREAM_UNI,
+     "UCP fence-separated put chain latency (chain length set by -O)"},
+
     {NULL}
 };
 
@@ -176,11 +191,11 @@ static int safe_recv(int sock, void *data, size_t size)
 
 static void print_progress(char **test_names, unsigned num_names,
                            const ucx_perf_result_t *result, unsigned flags,
-                           int final)
+                           const char *extra_info, int final)
 {
-    static const char *fmt_csv     =  "%.0f,%.3f,%.3f,%.3f,%.2f,%.2f,%.0f,%.0f\n";
-    static const char *fmt_numeric =  "%'14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %'11.0f %'11.0f\n";
-    static const char *fmt_plain   =  "%14.0f %9.3f %9.3f %9.3f %10.2f %10.2f %11.0f %11.0f\n";
+    static const char *fmt_csv     =  "%.0f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%.0f,%.0f";
+    static const char *fmt_numeric =  "%'14.0f %9.3f %9.3f %9.3f %9.3f %9.3f %10.2f %10.2f %'11.0f %'11.0f";
+    static const char *fmt_plain   =  "%14.0f %9.3f %9.3f %9.3f %9.3f %9.3f %10.2f %10.2f %11.0f %11.0f";
     unsigned i;
 
     if (!(flags & TEST_FLAG_PRINT_RESULTS) ||
@@ -202,10 +217,16 @@ static void print_progress(char **test_names, unsigned num_names,
            result->latency.typical * 1000000.0,
            result->latency.moment_average * 1000000.0,
            result->latency.total_average * 1000000.0,
+           result->latency.percentile_99 * 1000000.0,
+           result->latency.percentile_999 * 1000000.0,
            result->bandwidth.moment_average / (1024.0 * 1024.0),
            result->bandwidth.total_average / (1024.0 * 1024.0),
            result->msgrate.moment_average,
            result->msgrate.total_average);
+    if ((extra_info != NULL) && (extra_info[0] != '\0')) {
+        printf((flags & TEST_FLAG_PRINT_CSV) ? ",%s" : "  %s", extra_info);
+    }
+    printf("\n");
     fflush(stdout);
 }
 
@@ -216,6 +237,10 @@ static void print_header(struct perftest_context *ctx)
     test_type_t *test;
     unsigned i;
 
+    if (ctx->flags & TEST_FLAG_SKIP_HEADER) {
+        return;
+    }
+
     if (ctx->flags & TEST_FLAG_PRINT_TEST) {
         for (test = tests; test->name; ++test) {
             if ((test->command == ctx->params.command) && (test->test_type == ctx->params.test_type)) {
@@ -250,6 +275,8 @@ static void print_header(struct perftest_context *ctx)
             printf("| API:          %-60s               |\n", test_api_str);
             printf("| Test:         %-60s               |\n", test->desc);
             printf("| Data layout:  %-60s               |\n", test_data_str);
+            printf("| Memory type:  %-60s               |\n",
+                   ucx_perf_mem_type_names[ctx->params.mem_type]);
             printf("| Message size: %-60zu               |\n", ucx_perf_get_message_size(&ctx->params));
         }
     }
@@ -259,15 +286,15 @@ static void print_header(struct perftest_context *ctx)
             for (i = 0; i < ctx->num_batch_files; ++i) {
                 printf("%s,", basename(ctx->batch_files[i]));
             }
-            printf("iterations,typical_lat,avg_lat,overall_lat,avg_bw,overall_bw,avg_mr,overall_mr\n");
+            printf("iterations,typical_lat,avg_lat,overall_lat,p99_lat,p999_lat,avg_bw,overall_bw,avg_mr,overall_mr\n");
         }
     } else {
         if (ctx->flags & TEST_FLAG_PRINT_RESULTS) {
-            printf("+--------------+-----------------------------+---------------------+-----------------------+\n");
-            printf("|              |       latency (usec)        |   bandwidth (MB/s)  |  message rate (msg/s) |\n");
-            printf("+--------------+---------+---------+---------+----------+----------+-----------+-----------+\n");
-            printf("| # iterations | typical | average | overall |  average |  overall |   average |   overall |\n");
-            printf("+--------------+---------+---------+---------+----------+----------+-----------+-----------+\n");
+            printf("+--------------+-------------------------------------------------+---------------------+-----------------------+\n");
+            printf("|              |                  latency (usec)                 |   bandwidth (MB/s)  |  message rate (msg/s) |\n");
+            printf("+--------------+---------+---------+---------+---------+---------+----------+----------+-----------+-----------+\n");
+            printf("| # iterations | typical | average | overall |   99.0%% |   99.9%% |  average |  overall |   average |   overall |\n");
+            printf("+--------------+---------+---------+---------+---------+---------+----------+----------+-----------+-----------+\n");
         } else if (ctx->flags & TEST_FLAG_PRINT_TEST) {
             printf("+------------------------------------------------------------------------------------------+\n");
         }
@@ -280,7 +307,7 @@ static void print_test_name(struct perftest_context *ctx)
     unsigned i, pos;
 
     if (!(ctx->flags & TEST_FLAG_PRINT_CSV) && (ctx->num_batch_files > 0)) {
-        strcpy(buf, "+--------------+---------+---------+---------+----------+----------+-----------+-----------+");
+        strcpy(buf, "+--------------+---------+---------+---------+---------+---------+----------+----------+-----------+-----------+");
 
         pos = 1;
         for (i = 0; i < ctx->num_batch_files; ++i) {
@@ -327,6 +354,12 @@ static void usage(struct perftest_context *ctx, const char *program)
     printf("                                contig : Use continuous datatype in UCP tests.\n");
     printf("                                   iov : Use IOV datatype in UCP tests.\n");
     printf("\n");
+    printf("     -a <mem>       Memory type for the test buffers. (host)\n");
+    printf("                        host       : Plain host memory.\n");
+    printf("                        cuda       : GPU memory, allocated with the CUDA runtime.\n");
+    printf("                        cuda-host  : Pinned host memory, allocated with the CUDA runtime.\n");
+    printf("                    The CUDA runtime is loaded at run time - the tool works\n");
+    printf("                    without it as long as only host memory is used.\n");
     printf("     -d <device>    Device to use for testing.\n");
     printf("     -x <tl>        Transport to use for testing.\n");
     printf("     -c <cpu>       Set affinity to this CPU. (off)\n");
@@ -358,12 +391,29 @@ static void usage(struct perftest_context *ctx, const char *program)
     printf("                        single     : Only the master thread can access.\n");
     printf("                        serialized : One thread can access at a time.\n");
     printf("                        multi      : Multiple threads can access.\n");
-    printf("     -T <threads>   Number of threads in the test (1); "
+    printf("     -T <threads>[,<workers>]  Number of threads in the test (1); "
                                 "also implies \"-M multi\".\n");
+    printf("                        shared     : All threads drive one worker (default).\n");
+    printf("                        private    : Each thread creates its own worker.\n");
+    printf("     -I <count>     Many-to-one (incast) mode - accept this number of client\n");
+    printf("                    connections and run one test per client. Server side only. (1)\n");
+    printf("     -m             Run the test over every local (transport, device) pair\n");
+    printf("                    against a forked loopback server, pinned near and far\n");
+    printf("                    from each device when its NUMA node is known. Standalone\n");
+    printf("                    mode - do not pass a server hostname.\n");
     printf("     -A <mode>      Async progress mode. (thread)\n");
     printf("                        thread     : Use separate progress thread.\n");
     printf("                        signal     : Use signal based timer.\n"); 
     printf("     -B             Register memory with NONBLOCK flag.\n");
+    printf("     -R <file>      Dump the raw latency samples to this file, one value\n");
+    printf("                    per line, in usec. Multi-thread tests append a .<tid>\n");
+    printf("                    suffix to the file name. (off)\n");
+    printf("     -z <min>:<max>[:<factor>]  Sweep mode - run the test once per message\n");
+    printf("                    size in a geometric series from min to max, reusing the\n");
+    printf("                    same connections for the whole series. (factor 2.0)\n");
+    printf("     -y             With -z, measure every UCT data layout and print the\n");
+    printf("                    measured protocol crossovers as UCX_ environment\n");
+    printf("                    settings. UCT tests only.\n");
     printf("     -C             Use wildcard for tag tests.\n");
     printf("     -S             Use synchronous mode for tag sends.\n");
 #if HAVE_MPI
@@ -452,9 +502,15 @@ static void init_test_params(ucx_perf_params_t *params)
     params->warmup_iter     = 10000;
     params->am_hdr_size     = 8;
     params->alignment       = ucs_get_page_size();
+    params->mem_type        = UCX_PERF_MEM_TYPE_HOST;
     params->max_iter        = 1000000l;
     params->max_time        = 0.0;
     params->report_interval = 1.0;
+    params->lat_dump_file[0] = '\0';
+    params->sweep_min       = 0;
+    params->sweep_max       = 0;
+    params->sweep_factor    = 2.0;
+    params->sweep_results   = NULL;
     params->flags           = UCX_PERF_TEST_FLAG_VERBOSE;
     params->uct.fc_window   = UCT_PERF_TEST_MAX_FC_WINDOW;
     params->uct.data_layout = UCT_PERF_DATA_LAYOUT_SHORT;
@@ -474,6 +530,7 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
 {
     test_type_t *test;
     char *optarg2 = NULL;
+    unsigned i;
 
     switch (opt) {
     case 'd':
@@ -522,6 +579,15 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
     case 'i':
         params->iov_stride = atol(optarg);
         return UCS_OK;
+    case 'a':
+        for (i = 0; i < UCX_PERF_MEM_TYPE_LAST; ++i) {
+            if (0 == strcmp(optarg, ucx_perf_mem_type_names[i])) {
+                params->mem_type = i;
+                return UCS_OK;
+            }
+        }
+        ucs_error("Invalid option argument for -a");
+        return UCS_ERR_INVALID_PARAM;
     case 'n':
         params->max_iter = atol(optarg);
         return UCS_OK;
@@ -571,6 +637,32 @@ static ucs_status_t parse_test_params(ucx_perf_params_t *params, char opt, const
     case 'T':
         params->thread_count = atoi(optarg);
         params->thread_mode = UCS_THREAD_MODE_MULTI;
+        optarg2 = strchr(optarg, ',');
+        if (optarg2 == NULL) {
+            return UCS_OK;
+        } else if (0 == strcmp(optarg2 + 1, "shared")) {
+            params->flags &= ~UCX_PERF_TEST_FLAG_THREAD_WORKER;
+            return UCS_OK;
+        } else if (0 == strcmp(optarg2 + 1, "private")) {
+            params->flags |= UCX_PERF_TEST_FLAG_THREAD_WORKER;
+            return UCS_OK;
+        } else {
+            ucs_error("Invalid option argument for -T");
+            return UCS_ERR_INVALID_PARAM;
+        }
+    case 'R':
+        ucs_snprintf_zero(params->lat_dump_file, sizeof(params->lat_dump_file),
+                          "%s", optarg);
+        return UCS_OK;
+    case 'z':
+        if (sscanf(optarg, "%zu:%zu:%lf", &params->sweep_min, &params->sweep_max,
+                   &params->sweep_factor) < 2) {
+            ucs_error("Invalid option argument for -z");
+            return UCS_ERR_INVALID_PARAM;
+        }
+        return UCS_OK;
+    case 'y':
+        params->flags |= UCX_PERF_TEST_FLAG_CALIBRATE;
         return UCS_OK;
     case 'A':
         if (0 == strcmp(optarg, "thread")) {
@@ -640,17 +732,24 @@ static ucs_status_t parse_opts(struct perftest_context *ctx, int argc, char **ar
     ctx->server_addr            = NULL;
     ctx->num_batch_files        = 0;
     ctx->port                   = 13337;
+    ctx->num_clients            = 1;
     ctx->flags                  = 0;
 #if HAVE_MPI
     ctx->mpi                    = !isatty(0);
 #endif
 
     optind = 1;
-    while ((c = getopt (argc, argv, "p:b:Nfvc:P:h" TEST_PARAMS_ARGS)) != -1) {
+    while ((c = getopt (argc, argv, "p:b:Nfvc:P:I:mh" TEST_PARAMS_ARGS)) != -1) {
         switch (c) {
         case 'p':
             ctx->port = atoi(optarg);
             break;
+        case 'I':
+            ctx->num_clients = atoi(optarg);
+            break;
+        case 'm':
+            ctx->flags |= TEST_FLAG_LOOPBACK_MATRIX;
+            break;
         case 'b':
             if (ctx->num_batch_files < MAX_BATCH_FILES) {
                 ctx->batch_files[ctx->num_batch_files++] = strdup(optarg);
@@ -761,11 +860,11 @@ static void sock_rte_recv(void *rte_group, unsigned src, void *buffer,
 }
 
 static void sock_rte_report(void *rte_group, const ucx_perf_result_t *result,
-                            void *arg, int is_final)
+                            void *arg, const char *extra_info, int is_final)
 {
     struct perftest_context *ctx = arg;
     print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+                   extra_info, is_final);
 }
 
 static ucx_perf_rte_t sock_rte = {
@@ -833,6 +932,7 @@ static ucs_status_t setup_sock_rte(struct perftest_context *ctx)
 
         close(sockfd);
         safe_recv(connfd, &ctx->params, sizeof(ctx->params));
+        ctx->params.sweep_results = NULL; /* results are collected locally */
         if (ctx->params.msg_size_cnt) {
             ctx->params.msg_size_list = malloc(sizeof(*ctx->params.msg_size_list) *
                                                ctx->params.msg_size_cnt);
@@ -975,11 +1075,11 @@ static void mpi_rte_recv(void *rte_group, unsigned src, void *buffer, size_t max
 }
 
 static void mpi_rte_report(void *rte_group, const ucx_perf_result_t *result,
-                           void *arg, int is_final)
+                           void *arg, const char *extra_info, int is_final)
 {
     struct perftest_context *ctx = arg;
     print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+                   extra_info, is_final);
 }
 
 static ucx_perf_rte_t mpi_rte = {
@@ -1093,11 +1193,11 @@ static void ext_rte_exchange_vec(void *rte_group, void * req)
 }
 
 static void ext_rte_report(void *rte_group, const ucx_perf_result_t *result,
-                           void *arg, int is_final)
+                           void *arg, const char *extra_info, int is_final)
 {
     struct perftest_context *ctx = arg;
     print_progress(ctx->test_names, ctx->num_batch_files, result, ctx->flags,
-                   is_final);
+                   extra_info, is_final);
 }
 
 static ucx_perf_rte_t ext_rte = {
@@ -1207,6 +1307,76 @@ static ucs_status_t check_system(struct perftest_context *ctx)
     return UCS_OK;
 }
 
+/* Derive protocol thresholds from a calibration sweep. The results array holds
+ * one full size series per UCT data layout, in enum order. */
+static void print_calibration(const ucx_perf_params_t *params,
+                              const ucx_perf_result_t *results)
+{
+    const ucx_perf_result_t *res_short, *res_bcopy, *res_zcopy;
+    size_t bcopy_cross, zcopy_cross, rndv_thresh;
+    size_t num_sizes, i, size, *sizes;
+    double peak_bw;
+
+    num_sizes = ucx_perf_sweep_num_sizes(params);
+    sizes     = malloc(num_sizes * sizeof(*sizes));
+    if (sizes == NULL) {
+        return;
+    }
+
+    size = params->sweep_min;
+    for (i = 0; i < num_sizes; ++i) {
+        sizes[i] = size;
+        size     = ucx_perf_sweep_next_size(params, size);
+    }
+
+    res_short = results + (UCT_PERF_DATA_LAYOUT_SHORT * num_sizes);
+    res_bcopy = results + (UCT_PERF_DATA_LAYOUT_BCOPY * num_sizes);
+    res_zcopy = results + (UCT_PERF_DATA_LAYOUT_ZCOPY * num_sizes);
+
+    /* A layout "wins" from the first size where its latency drops below the
+     * cheaper layout's */
+    bcopy_cross = zcopy_cross = rndv_thresh = 0;
+    for (i = 0; i < num_sizes; ++i) {
+        if ((bcopy_cross == 0) && (res_bcopy[i].latency.total_average <
+                                   res_short[i].latency.total_average)) {
+            bcopy_cross = sizes[i];
+        }
+        if ((zcopy_cross == 0) && (res_zcopy[i].latency.total_average <
+                                   res_bcopy[i].latency.total_average)) {
+            zcopy_cross = sizes[i];
+        }
+    }
+
+    /* Rendezvous pays off once zero-copy runs close to its peak bandwidth */
+    peak_bw = 0.0;
+    for (i = 0; i < num_sizes; ++i) {
+        peak_bw = ucs_max(peak_bw, res_zcopy[i].bandwidth.total_average);
+    }
+    for (i = 0; i < num_sizes; ++i) {
+        if (res_zcopy[i].bandwidth.total_average >= (0.9 * peak_bw)) {
+            rndv_thresh = sizes[i];
+            break;
+        }
+    }
+
+    printf("\n# Protocol crossovers measured by the sweep:\n");
+    if (bcopy_cross != 0) {
+        printf("#   short -> bcopy at %zu bytes\n", bcopy_cross);
+    } else {
+        printf("#   short -> bcopy beyond the swept range\n");
+    }
+    if (zcopy_cross != 0) {
+        printf("UCX_ZCOPY_THRESH=%zu\n", zcopy_cross);
+    } else {
+        printf("#   bcopy -> zcopy beyond the swept range\n");
+    }
+    if (rndv_thresh != 0) {
+        printf("UCX_RNDV_THRESH=%zu\n", rndv_thresh);
+    }
+
+    free(sizes);
+}
+
 static ucs_status_t run_test_recurs(struct perftest_context *ctx,
                                     ucx_perf_params_t *parent_params,
                                     unsigned depth)
@@ -1214,13 +1384,35 @@ static ucs_status_t run_test_recurs(struct perftest_context *ctx,
     ucx_perf_params_t params;
     ucx_perf_result_t result;
     ucs_status_t status;
+    size_t num_results;
     FILE *batch_file;
 
     ucs_trace_func("depth=%u, num_files=%u", depth, ctx->num_batch_files);
 
     if (depth >= ctx->num_batch_files) {
         print_test_name(ctx);
-        return ucx_perf_run(parent_params, &result);
+        if (parent_params->sweep_min > 0) {
+            num_results = ucx_perf_sweep_num_sizes(parent_params);
+            if (parent_params->flags & UCX_PERF_TEST_FLAG_CALIBRATE) {
+                num_results *= UCT_PERF_DATA_LAYOUT_LAST; /* a series per layout */
+            }
+            parent_params->sweep_results = calloc(num_results,
+                                                  sizeof(*parent_params->sweep_results));
+            if (parent_params->sweep_results == NULL) {
+                return UCS_ERR_NO_MEMORY;
+            }
+        }
+
+        status = ucx_perf_run(parent_params, &result);
+
+        if ((status == UCS_OK) && (parent_params->sweep_results != NULL) &&
+            (parent_params->flags & UCX_PERF_TEST_FLAG_CALIBRATE) &&
+            (ctx->flags & TEST_FLAG_PRINT_RESULTS)) {
+            print_calibration(parent_params, parent_params->sweep_results);
+        }
+        free(parent_params->sweep_results);
+        parent_params->sweep_results = NULL;
+        return status;
     }
 
     batch_file = fopen(ctx->batch_files[depth], "r");
@@ -1262,6 +1454,423 @@ static ucs_status_t run_test(struct perftest_context *ctx)
     return status;
 }
 
+typedef struct incast_client {
+    pthread_t                    thread;
+    struct perftest_context      ctx;
+    ucs_status_t                 status;
+} incast_client_t;
+
+static void *incast_client_func(void *arg)
+{
+    incast_client_t *client = arg;
+
+    client->status = run_test(&client->ctx);
+    cleanup_sock_rte(&client->ctx);
+    return NULL;
+}
+
+static ucs_status_t run_incast_server(struct perftest_context *ctx)
+{
+    struct sockaddr_in inaddr;
+    incast_client_t *clients, *client;
+    ucs_status_t status;
+    int optval = 1;
+    int sockfd, connfd;
+    unsigned i, num_conns;
+    int ret;
+
+    clients = calloc(ctx->num_clients, sizeof(*clients));
+    if (clients == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd < 0) {
+        ucs_error("socket() failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_free_clients;
+    }
+
+    ret = setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+    if (ret < 0) {
+        ucs_error("setsockopt(SO_REUSEADDR) failed: %m");
+        status = UCS_ERR_INVALID_PARAM;
+        goto err_close_sockfd;
+    }
+
+    inaddr.sin_family      = AF_INET;
+    inaddr.sin_port        = htons(ctx->port);
+    inaddr.sin_addr.s_addr = INADDR_ANY;
+    memset(inaddr.sin_zero, 0, sizeof(inaddr.sin_zero));
+    ret = bind(sockfd, (struct sockaddr*)&inaddr, sizeof(inaddr));
+    if (ret < 0) {
+        ucs_error("bind() failed: %m");
+        status = UCS_ERR_INVALID_ADDR;
+        goto err_close_sockfd;
+    }
+
+    ret = listen(sockfd, ctx->num_clients);
+    if (ret < 0) {
+        ucs_error("listen() failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_close_sockfd;
+    }
+
+    printf("Waiting for %u connections...\n", ctx->num_clients);
+
+    num_conns = 0;
+    for (i = 0; i < ctx->num_clients; ++i) {
+        connfd = accept(sockfd, NULL, NULL);
+        if (connfd < 0) {
+            ucs_error("accept() failed: %m");
+            status = UCS_ERR_IO_ERROR;
+            goto err_close_conns;
+        }
+
+        client      = &clients[i];
+        client->ctx = *ctx;
+        safe_recv(connfd, &client->ctx.params, sizeof(client->ctx.params));
+        client->ctx.params.msg_size_list = NULL;
+        client->ctx.params.sweep_results = NULL;
+        if (client->ctx.params.msg_size_cnt) {
+            client->ctx.params.msg_size_list =
+                malloc(sizeof(*client->ctx.params.msg_size_list) *
+                       client->ctx.params.msg_size_cnt);
+            if (NULL == client->ctx.params.msg_size_list) {
+                close(connfd);
+                status = UCS_ERR_NO_MEMORY;
+                goto err_close_conns;
+            }
+            safe_recv(connfd, client->ctx.params.msg_size_list,
+                      sizeof(*client->ctx.params.msg_size_list) *
+                      client->ctx.params.msg_size_cnt);
+        }
+
+        client->ctx.sock_rte_group.connfd    = connfd;
+        client->ctx.sock_rte_group.is_server = 1;
+        if (i == 0) {
+            client->ctx.flags |= TEST_FLAG_PRINT_TEST;
+        }
+        client->ctx.params.rte_group  = &client->ctx.sock_rte_group;
+        client->ctx.params.rte        = &sock_rte;
+        client->ctx.params.report_arg = &client->ctx;
+        ++num_conns;
+    }
+
+    close(sockfd);
+
+    /* Run all the server sides concurrently - the simultaneous senders
+     * converging on this node are what produces the incast */
+    for (i = 0; i < ctx->num_clients; ++i) {
+        ret = pthread_create(&clients[i].thread, NULL, incast_client_func,
+                             &clients[i]);
+        if (ret) {
+            ucs_error("pthread_create() failed: %s", strerror(ret));
+            break;
+        }
+    }
+
+    status = UCS_OK;
+    while (i-- > 0) {
+        pthread_join(clients[i].thread, NULL);
+        if (clients[i].status != UCS_OK) {
+            status = clients[i].status;
+        }
+        free(clients[i].ctx.params.msg_size_list);
+    }
+
+    free(clients);
+    return status;
+
+err_close_conns:
+    for (i = 0; i < num_conns; ++i) {
+        close(clients[i].ctx.sock_rte_group.connfd);
+        free(clients[i].ctx.params.msg_size_list);
+    }
+err_close_sockfd:
+    close(sockfd);
+err_free_clients:
+    free(clients);
+err:
+    return status;
+}
+
+typedef struct matrix_entry {
+    char                         tl_name[UCT_TL_NAME_MAX];
+    char                         dev_name[UCT_DEVICE_NAME_MAX];
+} matrix_entry_t;
+
+static int read_first_int(const char *path)
+{
+    int value = -1;
+    FILE *f;
+
+    f = fopen(path, "r");
+    if (f != NULL) {
+        if (fscanf(f, "%d", &value) != 1) {
+            value = -1;
+        }
+        fclose(f);
+    }
+    return value;
+}
+
+/* NUMA node the device hangs off, or -1 when sysfs does not tell */
+static int matrix_device_numa_node(const char *dev_name)
+{
+    char ib_dev[UCT_DEVICE_NAME_MAX];
+    char path[128];
+    char *p;
+
+    ucs_snprintf_zero(ib_dev, sizeof(ib_dev), "%s", dev_name);
+    p = strchr(ib_dev, ':'); /* strip the port suffix of IB device names */
+    if (p != NULL) {
+        *p = '\0';
+    }
+
+    snprintf(path, sizeof(path), "/sys/class/infiniband/%s/device/numa_node",
+             ib_dev);
+    return read_first_int(path);
+}
+
+/* First cpu of a NUMA node (the cpulist file starts with its number) */
+static int matrix_node_first_cpu(int node)
+{
+    char path[128];
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+    return read_first_int(path);
+}
+
+static int matrix_remote_cpu(int dev_node)
+{
+    char path[128];
+    int node;
+
+    for (node = 0; ; ++node) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+                 node);
+        if (access(path, R_OK) != 0) {
+            return -1;
+        }
+        if (node != dev_node) {
+            return read_first_int(path);
+        }
+    }
+}
+
+static ucs_status_t matrix_enum_resources(matrix_entry_t **entries_p,
+                                          unsigned *num_entries_p)
+{
+    uct_md_resource_desc_t *md_resources;
+    uct_tl_resource_desc_t *tl_resources;
+    unsigned i, num_md_resources;
+    unsigned j, num_tl_resources;
+    matrix_entry_t *entries, *new_entries;
+    unsigned num_entries;
+    uct_md_config_t *md_config;
+    ucs_status_t status;
+    uct_md_h md;
+
+    status = uct_query_md_resources(&md_resources, &num_md_resources);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    entries     = NULL;
+    num_entries = 0;
+    for (i = 0; i < num_md_resources; ++i) {
+        status = uct_md_config_read(md_resources[i].md_name, NULL, NULL,
+                                    &md_config);
+        if (status != UCS_OK) {
+            goto err;
+        }
+
+        status = uct_md_open(md_resources[i].md_name, md_config, &md);
+        uct_config_release(md_config);
+        if (status != UCS_OK) {
+            goto err;
+        }
+
+        status = uct_md_query_tl_resources(md, &tl_resources,
+                                           &num_tl_resources);
+        if (status != UCS_OK) {
+            uct_md_close(md);
+            goto err;
+        }
+
+        new_entries = realloc(entries, (num_entries + num_tl_resources) *
+                              sizeof(*entries));
+        if (new_entries == NULL) {
+            uct_release_tl_resource_list(tl_resources);
+            uct_md_close(md);
+            status = UCS_ERR_NO_MEMORY;
+            goto err;
+        }
+        entries = new_entries;
+
+        for (j = 0; j < num_tl_resources; ++j) {
+            ucs_snprintf_zero(entries[num_entries].tl_name,
+                              sizeof(entries[num_entries].tl_name), "%s",
+                              tl_resources[j].tl_name);
+            ucs_snprintf_zero(entries[num_entries].dev_name,
+                              sizeof(entries[num_entries].dev_name), "%s",
+                              tl_resources[j].dev_name);
+            ++num_entries;
+        }
+
+        uct_release_tl_resource_list(tl_resources);
+        uct_md_close(md);
+    }
+
+    uct_release_md_resource_list(md_resources);
+    *entries_p     = entries;
+    *num_entries_p = num_entries;
+    return UCS_OK;
+
+err:
+    free(entries);
+    uct_release_md_resource_list(md_resources);
+    return status;
+}
+
+/* Run one (transport, device) pair against a forked loopback server. The
+ * child inherits our listening-free state and just serves a single
+ * connection; the parent optionally pins itself before connecting. */
+static ucs_status_t run_matrix_pair(struct perftest_context *ctx,
+                                    const matrix_entry_t *entry, int cpu,
+                                    const char *placement, unsigned run_index)
+{
+    struct perftest_context run_ctx;
+    cpu_set_t orig_cpuset, cpuset;
+    ucs_status_t status;
+    int retries;
+    pid_t pid;
+
+    fflush(stdout); /* do not let the child inherit buffered output */
+    pid = fork();
+    if (pid < 0) {
+        ucs_error("fork() failed: %m");
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    if (pid == 0) {
+        /* The parent side prints everything - keep the server quiet */
+        if (freopen("/dev/null", "w", stdout) == NULL) {
+            ucs_warn("freopen(/dev/null) failed: %m");
+        }
+        run_ctx             = *ctx;
+        run_ctx.server_addr = NULL;
+        run_ctx.port        = ctx->port + run_index;
+        run_ctx.flags      &= ~(TEST_FLAG_PRINT_RESULTS | TEST_FLAG_PRINT_TEST);
+        status = setup_sock_rte(&run_ctx);
+        if (status == UCS_OK) {
+            status = run_test(&run_ctx);
+            cleanup_sock_rte(&run_ctx);
+        }
+        exit((status == UCS_OK) ? 0 : 1);
+    }
+
+    run_ctx             = *ctx;
+    run_ctx.server_addr = "localhost";
+    run_ctx.port        = ctx->port + run_index;
+    run_ctx.flags      |= TEST_FLAG_SKIP_HEADER;
+    ucs_snprintf_zero(run_ctx.params.uct.tl_name,
+                      sizeof(run_ctx.params.uct.tl_name), "%s", entry->tl_name);
+    ucs_snprintf_zero(run_ctx.params.uct.dev_name,
+                      sizeof(run_ctx.params.uct.dev_name), "%s",
+                      entry->dev_name);
+
+    sched_getaffinity(0, sizeof(orig_cpuset), &orig_cpuset);
+    if (cpu >= 0) {
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        if (sched_setaffinity(0, sizeof(cpuset), &cpuset)) {
+            ucs_warn("sched_setaffinity(cpu=%d) failed: %m", cpu);
+        }
+    }
+
+    if (cpu >= 0) {
+        printf("%s/%s cpu %d (%s):\n", entry->tl_name, entry->dev_name, cpu,
+               placement);
+    } else {
+        printf("%s/%s:\n", entry->tl_name, entry->dev_name);
+    }
+    fflush(stdout);
+
+    /* Give the child time to listen before connecting */
+    status  = UCS_ERR_UNREACHABLE;
+    retries = 10;
+    while (retries-- > 0) {
+        usleep(100 * 1000);
+        status = setup_sock_rte(&run_ctx);
+        if (status == UCS_OK) {
+            break;
+        }
+    }
+
+    if (status == UCS_OK) {
+        status = run_test(&run_ctx);
+        cleanup_sock_rte(&run_ctx);
+    }
+
+    sched_setaffinity(0, sizeof(orig_cpuset), &orig_cpuset);
+    waitpid(pid, NULL, 0);
+    return status;
+}
+
+static ucs_status_t run_matrix(struct perftest_context *ctx)
+{
+    matrix_entry_t *entries;
+    unsigned i, num_entries, run_index;
+    int dev_node, local_cpu, remote_cpu;
+    ucs_status_t status;
+
+    status = matrix_enum_resources(&entries, &num_entries);
+    if (status != UCS_OK) {
+        ucs_error("Failed to query transport resources: %s",
+                  ucs_status_string(status));
+        return status;
+    }
+
+    if (num_entries == 0) {
+        ucs_error("No transport resources found");
+        return UCS_ERR_NO_DEVICE;
+    }
+
+    ctx->flags |= TEST_FLAG_PRINT_RESULTS;
+    print_header(ctx);
+
+    /* A failing pair is part of the answer - report it and keep going */
+    run_index = 1;
+    for (i = 0; i < num_entries; ++i) {
+        dev_node   = matrix_device_numa_node(entries[i].dev_name);
+        local_cpu  = (dev_node >= 0) ? matrix_node_first_cpu(dev_node) : -1;
+        remote_cpu = (dev_node >= 0) ? matrix_remote_cpu(dev_node)     : -1;
+
+        status = run_matrix_pair(ctx, &entries[i], local_cpu,
+                                 "numa local", run_index++);
+        if (status != UCS_OK) {
+            printf("  failed: %s\n", ucs_status_string(status));
+            fflush(stdout);
+        }
+
+        if (remote_cpu >= 0) {
+            status = run_matrix_pair(ctx, &entries[i], remote_cpu,
+                                     "numa remote", run_index++);
+            if (status != UCS_OK) {
+                printf("  failed: %s\n", ucs_status_string(status));
+                fflush(stdout);
+            }
+        }
+    }
+
+    free(entries);
+    return UCS_OK;
+}
+
 int main(int argc, char **argv)
 {
     struct perftest_context ctx;
@@ -1295,6 +1904,21 @@ int main(int argc, char **argv)
         goto out;
     }
 
+    /* Topology matrix: enumerate the node's transports and run the test
+     * over each of them in loopback */
+    if (!rte && (ctx.server_addr == NULL) &&
+        (ctx.flags & TEST_FLAG_LOOPBACK_MATRIX)) {
+        ret = (run_matrix(&ctx) == UCS_OK) ? 0 : -1;
+        goto out;
+    }
+
+    /* Many-to-one mode: every client connection gets its own server-side
+     * test thread */
+    if (!rte && (ctx.server_addr == NULL) && (ctx.num_clients > 1)) {
+        ret = (run_incast_server(&ctx) == UCS_OK) ? 0 : -1;
+        goto out;
+    }
+
     /* Create RTE */
     status = (rte) ? setup_mpi_rte(&ctx) : setup_sock_rte(&ctx);
     if (status != UCS_OK) {
@@ -332,6 +332,80 @@ public:
         return UCS_OK;
     }
 
+    /*
+     * Measure synchronization cost rather than data path cost: every
+     * iteration posts a burst of non-blocking puts and then waits for their
+     * completion with the primitive selected by CMD, so each histogram
+     * sample covers the full burst-plus-synchronization time. The burst
+     * size comes from max_outstanding (-O), which makes the flush/fence
+     * cost visible as a function of the number of outstanding operations.
+     */
+    ucs_status_t run_put_sync()
+    {
+        unsigned my_index, i, burst;
+        ucp_worker_h worker;
+        ucp_ep_h ep;
+        uint64_t remote_addr;
+        ucp_rkey_h rkey;
+        ucs_status_t status;
+        size_t length;
+
+        length = ucx_perf_get_message_size(&m_perf.params);
+        ucs_assert(length >= sizeof(psn_t));
+
+        burst  = m_max_outstanding;
+
+        rte_call(&m_perf, barrier);
+
+        my_index    = rte_call(&m_perf, group_index);
+
+        ucx_perf_test_start_clock(&m_perf);
+
+        worker      = m_perf.ucp.worker;
+        ep          = m_perf.ucp.peers[1 - my_index].ep;
+        remote_addr = m_perf.ucp.peers[1 - my_index].remote_addr + m_perf.offset;
+        rkey        = m_perf.ucp.peers[1 - my_index].rkey;
+
+        if (my_index == 0) {
+            /* The target side only needs to keep its worker progressing */
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                progress_responder();
+                ucx_perf_update(&m_perf, 1, burst * length);
+            }
+        } else if (my_index == 1) {
+            UCX_PERF_TEST_FOREACH(&m_perf) {
+                for (i = 0; i < burst; ++i) {
+                    status = ucp_put_nbi(ep, m_perf.send_buffer, length,
+                                         remote_addr, rkey);
+                    if (status < 0) {
+                        return status;
+                    }
+                    if (UCX_PERF_CMD_PUT_FENCE == CMD) {
+                        /* Order every put in the chain after the previous one */
+                        ucp_worker_fence(worker);
+                    }
+                }
+                /* coverity[switch_selector_expr_is_constant] */
+                switch (CMD) {
+                case UCX_PERF_CMD_PUT_FLUSH:
+                    ucp_ep_flush(ep);
+                    break;
+                case UCX_PERF_CMD_PUT_WFLUSH:
+                case UCX_PERF_CMD_PUT_FENCE:
+                    ucp_worker_flush(worker);
+                    break;
+                default:
+                    return UCS_ERR_INVALID_PARAM;
+                }
+                ucx_perf_update(&m_perf, 1, burst * length);
+            }
+        }
+
+        ucp_worker_flush(m_perf.ucp.worker);
+        rte_call(&m_perf, barrier);
+        return UCS_OK;
+    }
+
     ucs_status_t run()
     {
         /* coverity[switch_selector_expr_is_constant] */
@@ -339,6 +413,11 @@ public:
         case UCX_PERF_TEST_TYPE_PINGPONG:
             return run_pingpong();
         case UCX_PERF_TEST_TYPE_STREAM_UNI:
+            if ((UCX_PERF_CMD_PUT_FLUSH  == CMD) ||
+                (UCX_PERF_CMD_PUT_WFLUSH == CMD) ||
+                (UCX_PERF_CMD_PUT_FENCE  == CMD)) {
+                return run_put_sync();
+            }
             return run_stream_uni();
         case UCX_PERF_TEST_TYPE_STREAM_BI:
         default:
@@ -391,7 +470,10 @@ ucs_status_t ucp_perf_test_dispatch(ucx_perf_context_t *perf)
         (UCX_PERF_CMD_ADD,   UCX_PERF_TEST_TYPE_STREAM_UNI),
         (UCX_PERF_CMD_FADD,  UCX_PERF_TEST_TYPE_STREAM_UNI),
         (UCX_PERF_CMD_SWAP,  UCX_PERF_TEST_TYPE_STREAM_UNI),
-        (UCX_PERF_CMD_CSWAP, UCX_PERF_TEST_TYPE_STREAM_UNI)
+        (UCX_PERF_CMD_CSWAP, UCX_PERF_TEST_TYPE_STREAM_UNI),
+        (UCX_PERF_CMD_PUT_FLUSH,  UCX_PERF_TEST_TYPE_STREAM_UNI),
+        (UCX_PERF_CMD_PUT_WFLUSH, UCX_PERF_TEST_TYPE_STREAM_UNI),
+        (UCX_PERF_CMD_PUT_FENCE,  UCX_PERF_TEST_TYPE_STREAM_UNI)
         );
     UCS_PP_FOREACH(TEST_CASE_ALL_TAG, perf,
         (UCX_PERF_CMD_TAG,   UCX_PERF_TEST_TYPE_PINGPONG),
@@ -0,0 +1,193 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include <uct/base/uct_capture.h>
+
+#include <sys/fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <libgen.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+
+#define HEX_BYTES_PER_LINE 16
+
+
+typedef struct options {
+    const char *filename;
+    int        dump_payload;
+} options_t;
+
+
+static const char *record_type_names[] = {
+    [UCT_AM_TRACE_TYPE_SEND]      = "SEND",
+    [UCT_AM_TRACE_TYPE_RECV]      = "RECV",
+    [UCT_AM_TRACE_TYPE_SEND_DROP] = "SEND_DROP",
+    [UCT_AM_TRACE_TYPE_RECV_DROP] = "RECV_DROP"
+};
+
+
+static const char *record_type_name(uint8_t type)
+{
+    if (type < UCT_AM_TRACE_TYPE_LAST) {
+        return record_type_names[type];
+    }
+    return "UNKNOWN";
+}
+
+static void dump_payload(const uct_capture_record_t *rec)
+{
+    unsigned i, j;
+    char c;
+
+    for (i = 0; i < rec->caplen; i += HEX_BYTES_PER_LINE) {
+        printf("        ");
+        for (j = i; j < i + HEX_BYTES_PER_LINE; ++j) {
+            if (j < rec->caplen) {
+                printf("%02x ", (unsigned char)rec->payload[j]);
+            } else {
+                printf("   ");
+            }
+        }
+        printf(" ");
+        for (j = i; (j < i + HEX_BYTES_PER_LINE) && (j < rec->caplen); ++j) {
+            c = rec->payload[j];
+            printf("%c", isprint((unsigned char)c) ? c : '.');
+        }
+        printf("\n");
+    }
+}
+
+static int read_capture_file(const options_t *opts)
+{
+    const uct_capture_header_t *hdr;
+    const uct_capture_record_t *records, *rec;
+    uint64_t first, count, i, index;
+    struct stat stt;
+    const void *ptr;
+    int ret;
+    int fd;
+
+    fd = open(opts->filename, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "failed to open '%s': %m\n", opts->filename);
+        return -1;
+    }
+
+    ret = fstat(fd, &stt);
+    if (ret < 0) {
+        fprintf(stderr, "fstat('%s') failed: %m\n", opts->filename);
+        close(fd);
+        return -1;
+    }
+
+    ptr = mmap(NULL, stt.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        fprintf(stderr, "failed to map '%s': %m\n", opts->filename);
+        return -1;
+    }
+
+    hdr = ptr;
+    if (((size_t)stt.st_size < sizeof(*hdr)) ||
+        (hdr->magic != UCT_CAPTURE_MAGIC)) {
+        fprintf(stderr, "'%s' is not a wire capture file\n", opts->filename);
+        goto err_unmap;
+    }
+
+    if (hdr->version != UCT_CAPTURE_VERSION) {
+        fprintf(stderr, "'%s' has capture version %u, expected %u\n",
+                opts->filename, hdr->version, UCT_CAPTURE_VERSION);
+        goto err_unmap;
+    }
+
+    if (hdr->record_size != sizeof(uct_capture_record_t)) {
+        fprintf(stderr, "'%s' has %u-byte records, expected %zu\n",
+                opts->filename, hdr->record_size,
+                sizeof(uct_capture_record_t));
+        goto err_unmap;
+    }
+
+    printf("# interface   : %s\n", hdr->name);
+    printf("# pid         : %u\n", hdr->pid);
+    printf("# ring size   : %lu records\n", (unsigned long)hdr->num_records);
+    printf("# captured    : %lu messages%s\n", (unsigned long)hdr->total_count,
+           (hdr->total_count > hdr->num_records) ? " (ring wrapped)" : "");
+
+    records = (const uct_capture_record_t*)(hdr + 1);
+
+    /* when the ring wrapped, the oldest surviving record is at total_count */
+    count = (hdr->total_count < hdr->num_records) ? hdr->total_count :
+                                                    hdr->num_records;
+    first = hdr->total_count - count;
+
+    for (i = 0; i < count; ++i) {
+        index = first + i;
+        rec   = &records[index & (hdr->num_records - 1)];
+        printf("%10lu  %15.6f  %-9s  am_id %3u  len %u (captured %u)\n",
+               (unsigned long)index,
+               (double)(rec->timestamp - hdr->start_time) / hdr->one_second,
+               record_type_name(rec->type), rec->am_id, rec->length,
+               rec->caplen);
+        if (opts->dump_payload) {
+            dump_payload(rec);
+        }
+    }
+
+    munmap((void*)ptr, stt.st_size);
+    return 0;
+
+err_unmap:
+    munmap((void*)ptr, stt.st_size);
+    return -1;
+}
+
+static int parse_args(int argc, char **argv, options_t *opts)
+{
+    int c;
+
+    opts->filename     = NULL;
+    opts->dump_payload = 0;
+
+    while ((c = getopt(argc, argv, "xh")) != -1) {
+        switch (c) {
+        case 'x':
+            opts->dump_payload = 1;
+            break;
+        case 'h':
+        default:
+            return -1;
+        }
+    }
+
+    if (optind >= argc) {
+        fprintf(stderr, "missing capture file argument\n");
+        return -1;
+    }
+
+    opts->filename = argv[optind];
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    options_t opts;
+
+    if (parse_args(argc, argv, &opts) < 0) {
+        printf("Usage: %s [options] <file>\n", basename(argv[0]));
+        printf("Options:\n");
+        printf("      -x             dump the captured payload bytes in hex\n");
+        printf("\n");
+        return -1;
+    }
+
+    return read_capture_file(&opts);
+}
@@ -6,6 +6,7 @@
 
 #include <ucs/debug/profile.h>
 #include <ucs/datastruct/khash.h>
+#include <ucs/sys/math.h>
 
 #include <sys/signal.h>
 #include <sys/fcntl.h>
@@ -45,16 +46,24 @@ typedef enum {
 typedef struct options {
     const char                   *filename;
     int                          raw;
+    int                          log;
+    int                          flame;
     time_units_t                 time_units;
 } options_t;
 
 
+typedef struct {
+    const ucs_profile_thread_header_t *header;
+    const ucs_profile_record_t        *records;
+} profile_thread_data_t;
+
+
 typedef struct {
     void                         *mem;
     size_t                       length;
     const ucs_profile_header_t   *header;
     const ucs_profile_location_t *locations;
-    const ucs_profile_record_t   *records;
+    profile_thread_data_t        *threads;
 } profile_data_t;
 
 
@@ -73,7 +82,9 @@ static const char* time_units_str[] = {
 
 static int read_profile_data(const char *file_name, profile_data_t *data)
 {
+    const ucs_profile_thread_header_t *thread_hdr;
     struct stat stat;
+    uint32_t i;
     int ret, fd;
 
     fd = open(file_name, O_RDONLY);
@@ -100,10 +111,28 @@ static int read_profile_data(const char *file_name, profile_data_t *data)
 
     data->header    = data->mem;
     data->locations = (const void*)(data->header + 1);
-    data->records   = (const void*)(data->locations + data->header->num_locations);
+
+    /* Index the per-thread sections */
+    data->threads = calloc(data->header->num_threads, sizeof(*data->threads));
+    if (data->threads == NULL) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        ret = -1;
+        goto out_unmap;
+    }
+
+    thread_hdr = (const void*)(data->locations + data->header->num_locations);
+    for (i = 0; i < data->header->num_threads; ++i) {
+        data->threads[i].header  = thread_hdr;
+        data->threads[i].records = (const void*)(thread_hdr + 1);
+        thread_hdr = (const void*)(data->threads[i].records +
+                                   thread_hdr->num_records);
+    }
 
     ret = 0;
+    goto out_close;
 
+out_unmap:
+    munmap(data->mem, data->length);
 out_close:
     close(fd);
 out:
@@ -112,6 +141,7 @@ out:
 
 static void release_profile_data(profile_data_t *data)
 {
+    free(data->threads);
     munmap(data->mem, data->length);
 }
 
@@ -188,11 +218,224 @@ static void show_profile_data_accum(profile_data_t *data, options_t *opts)
     free(sorted_locations);
 }
 
+#define MAX_STACK_DEPTH    (UCS_PROFILE_STACK_MAX * 2)
+#define NUM_HIST_BUCKETS   64
+#define MAX_STACK_PATH     4096
+
+
+typedef struct {
+    const ucs_profile_record_t   *begin;       /* scope begin record */
+    uint64_t                     child_time;   /* time of completed children */
+} stack_frame_t;
+
+
+/* Aggregated data of one location, built in a single pass over the records */
+typedef struct {
+    uint64_t                     count;
+    uint64_t                     total_time;
+    uint64_t                     min_time;
+    uint64_t                     max_time;
+    uint64_t                     hist[NUM_HIST_BUCKETS]; /* log2 duration histogram */
+} location_stats_t;
+
+
+KHASH_MAP_INIT_STR(stacks, uint64_t)
+
+static unsigned duration_bucket(uint64_t time)
+{
+    return 63 - __builtin_clzll(time | 1);
+}
+
+static uint64_t hist_percentile(const location_stats_t *stats, double ratio)
+{
+    uint64_t limit = (uint64_t)(stats->count * ratio);
+    uint64_t sum   = 0;
+    unsigned bucket;
+
+    for (bucket = 0; bucket < NUM_HIST_BUCKETS; ++bucket) {
+        sum += stats->hist[bucket];
+        if (sum > limit) {
+            return 1ull << bucket;
+        }
+    }
+    return 0;
+}
+
+static void add_collapsed_stack(profile_data_t *data, khash_t(stacks) *flame,
+                                const stack_frame_t *stack, int top,
+                                uint64_t self_time)
+{
+    char path[MAX_STACK_PATH];
+    size_t offset;
+    khiter_t hash_it;
+    int hash_extra_status;
+    const char *function;
+    char *key;
+    int i;
+
+    /* Build the collapsed stack string from the functions of all open scopes */
+    offset = 0;
+    for (i = 0; (i <= top) && (offset < sizeof(path)); ++i) {
+        function = data->locations[stack[i].begin->location].function;
+        offset  += snprintf(path + offset, sizeof(path) - offset, "%s%s",
+                            (i > 0) ? ";" : "", function);
+    }
+
+    hash_it = kh_put(stacks, flame, path, &hash_extra_status);
+    if (hash_extra_status < 0) {
+        return;
+    } else if (hash_extra_status == 0) {
+        kh_value(flame, hash_it) += self_time;
+    } else {
+        key = strdup(path);
+        if (key == NULL) {
+            kh_del(stacks, flame, hash_it);
+            return;
+        }
+        kh_key(flame, hash_it)   = key;
+        kh_value(flame, hash_it) = self_time;
+    }
+}
+
+/* Walk the records of one thread once, matching scope begins with scope ends.
+ * Optionally collects per-location aggregates and/or collapsed stacks. */
+static void scan_thread_records(profile_data_t *data,
+                                const profile_thread_data_t *thread,
+                                location_stats_t *stats, khash_t(stacks) *flame)
+{
+    stack_frame_t stack[MAX_STACK_DEPTH];
+    const ucs_profile_record_t *rec;
+    const ucs_profile_location_t *loc;
+    location_stats_t *loc_stats;
+    uint64_t duration, self_time;
+    int top = -1;
+
+    for (rec = thread->records;
+         rec < thread->records + thread->header->num_records; ++rec)
+    {
+        loc = &data->locations[rec->location];
+        switch (loc->type) {
+        case UCS_PROFILE_TYPE_SCOPE_BEGIN:
+            if (top < MAX_STACK_DEPTH - 1) {
+                ++top;
+                stack[top].begin      = rec;
+                stack[top].child_time = 0;
+            }
+            break;
+        case UCS_PROFILE_TYPE_SCOPE_END:
+            if (top < 0) {
+                /* scope began before the log started */
+                break;
+            }
+
+            duration  = rec->timestamp - stack[top].begin->timestamp;
+            self_time = duration - stack[top].child_time;
+
+            if (stats != NULL) {
+                loc_stats              = &stats[rec->location];
+                loc_stats->count      += 1;
+                loc_stats->total_time += duration;
+                loc_stats->min_time    = ucs_min(loc_stats->min_time, duration);
+                loc_stats->max_time    = ucs_max(loc_stats->max_time, duration);
+                ++loc_stats->hist[duration_bucket(duration)];
+            }
+
+            if (flame != NULL) {
+                add_collapsed_stack(data, flame, stack, top, self_time);
+            }
+
+            --top;
+            if (top >= 0) {
+                stack[top].child_time += duration;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+static void show_profile_stats_log(profile_data_t *data, options_t *opts)
+{
+    uint32_t num_locations = data->header->num_locations;
+    const ucs_profile_location_t *loc;
+    location_stats_t *stats, *loc_stats;
+    uint32_t i, location;
+
+    stats = calloc(num_locations, sizeof(*stats));
+    if (stats == NULL) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return;
+    }
+
+    for (location = 0; location < num_locations; ++location) {
+        stats[location].min_time = UINT64_MAX;
+    }
+
+    for (i = 0; i < data->header->num_threads; ++i) {
+        scan_thread_records(data, &data->threads[i], stats, NULL);
+    }
+
+    printf("%25s %10s %12s %10s %10s %10s %10s %10s   FILE     FUNCTION\n",
+           "NAME", "COUNT", "TOTAL", "AVG", "MIN", "~P50", "~P99", "MAX");
+    for (location = 0; location < num_locations; ++location) {
+        loc_stats = &stats[location];
+        if (loc_stats->count == 0) {
+            continue;
+        }
+
+        loc = &data->locations[location];
+        printf("%25s %10ld %12.0f %10.3f %10.3f %10.3f %10.3f %10.3f %8s:%-4d %s()\n",
+               loc->name,
+               (long)loc_stats->count,
+               time_to_usec(data, opts, loc_stats->total_time),
+               time_to_usec(data, opts, loc_stats->total_time) / loc_stats->count,
+               time_to_usec(data, opts, loc_stats->min_time),
+               time_to_usec(data, opts, hist_percentile(loc_stats, 0.50)),
+               time_to_usec(data, opts, hist_percentile(loc_stats, 0.99)),
+               time_to_usec(data, opts, loc_stats->max_time),
+               loc->file, loc->line, loc->function);
+    }
+
+    free(stats);
+}
+
+/* Print collapsed call stacks consumable by flame graph tools: one line per
+ * distinct stack, with the self time in nanoseconds as the sample value */
+static void dump_collapsed_stacks(profile_data_t *data)
+{
+    khash_t(stacks) flame;
+    khiter_t hash_it;
+    uint64_t time_ns;
+    uint32_t i;
+
+    kh_init_inplace(stacks, &flame);
+
+    for (i = 0; i < data->header->num_threads; ++i) {
+        scan_thread_records(data, &data->threads[i], NULL, &flame);
+    }
+
+    for (hash_it = kh_begin(&flame); hash_it != kh_end(&flame); ++hash_it) {
+        if (!kh_exist(&flame, hash_it)) {
+            continue;
+        }
+        time_ns = (uint64_t)(kh_value(&flame, hash_it) * 1e9 /
+                             data->header->one_second);
+        printf("%s %llu\n", kh_key(&flame, hash_it),
+               (unsigned long long)time_ns);
+        free((char*)kh_key(&flame, hash_it));
+    }
+
+    kh_destroy_inplace(stacks, &flame);
+}
+
 KHASH_MAP_INIT_INT64(request_ids, int)
 
-static void show_profile_data_log(profile_data_t *data, options_t *opts)
+static void show_profile_data_log(profile_data_t *data, options_t *opts,
+                                  const profile_thread_data_t *thread)
 {
-    size_t num_recods               = data->header->num_records;
+    size_t num_recods               = thread->header->num_records;
+    const ucs_profile_record_t *records = thread->records;
     const ucs_profile_record_t **stack[UCS_PROFILE_STACK_MAX * 2];
     const ucs_profile_record_t **scope_ends;
     const ucs_profile_location_t *loc;
@@ -234,11 +477,11 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
     /* Find the first record with minimal nesting level, which is the base of call stack */
     nesting         = 0;
     min_nesting     = 0;
-    for (rec = data->records; rec < data->records + num_recods; ++rec) {
+    for (rec = records; rec < records + num_recods; ++rec) {
         loc = &data->locations[rec->location];
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            stack[nesting + UCS_PROFILE_STACK_MAX] = &scope_ends[rec - data->records];
+            stack[nesting + UCS_PROFILE_STACK_MAX] = &scope_ends[rec - records];
             ++nesting;
             break;
         case UCS_PROFILE_TYPE_SCOPE_END:
@@ -257,7 +500,7 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
     }
 
     if (num_recods > 0) {
-        prev_time = data->records[0].timestamp;
+        prev_time = records[0].timestamp;
     } else {
         prev_time = 0;
     }
@@ -266,11 +509,11 @@ static void show_profile_data_log(profile_data_t *data, options_t *opts)
 
     /* Display records */
     nesting = -min_nesting;
-    for (rec = data->records; rec < data->records + num_recods; ++rec) {
+    for (rec = records; rec < records + num_recods; ++rec) {
         loc = &data->locations[rec->location];
         switch (loc->type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            se = scope_ends[rec - data->records];
+            se = scope_ends[rec - records];
             if (se != NULL) {
                 snprintf(buf, sizeof(buf), RECORD_FMT"  %s%s%s %s%.3f%s {",
                          RECORD_ARG(rec->timestamp - prev_time),
@@ -352,7 +595,7 @@ static void close_pipes()
     close(output_pipefds[1]);
 }
 
-static int redirect_output(const ucs_profile_header_t *hdr)
+static int redirect_output(const ucs_profile_header_t *hdr, options_t *opts)
 {
     char *less_argv[] = {LESS_COMMAND,
                          "-R" /* show colors */,
@@ -372,7 +615,9 @@ static int redirect_output(const ucs_profile_header_t *hdr)
                 ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) ?
                                 (hdr->num_locations + 2) : 0) +
                 ((hdr->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) ?
-                                (hdr->num_records    + 1) : 0) +
+                                (hdr->num_locations + 2) : 0) +
+                ((opts->log && (hdr->mode & UCS_BIT(UCS_PROFILE_MODE_LOG))) ?
+                                (hdr->num_records + 2 * hdr->num_threads) : 0) +
                 1; /* footer */
 
     if (num_lines <= wsz.ws_row) {
@@ -431,10 +676,16 @@ static void show_header(profile_data_t *data, options_t *opts)
 
 static int show_profile_data(profile_data_t *data, options_t *opts)
 {
+    uint32_t i;
     int ret;
 
+    if (opts->flame) {
+        dump_collapsed_stacks(data);
+        return 0;
+    }
+
     if (!opts->raw) {
-        ret = redirect_output(data->header);
+        ret = redirect_output(data->header, opts);
         if (ret < 0) {
             return ret;
         }
@@ -448,8 +699,16 @@ static int show_profile_data(profile_data_t *data, options_t *opts)
     }
 
     if (data->header->mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        show_profile_data_log(data, opts);
+        show_profile_stats_log(data, opts);
         printf("\n");
+
+        if (opts->log) {
+            for (i = 0; i < data->header->num_threads; ++i) {
+                printf("thread %d:\n", data->threads[i].header->tid);
+                show_profile_data_log(data, opts, &data->threads[i]);
+                printf("\n");
+            }
+        }
     }
 
     return 0;
@@ -460,13 +719,21 @@ int parse_args(int argc, char **argv, options_t *opts)
     int c;
 
     opts->raw         = !isatty(fileno(stdout));
+    opts->log         = 0;
+    opts->flame       = 0;
     opts->time_units  = TIME_UNITS_USEC;
 
-    while ( (c = getopt(argc, argv, "hrt:")) != -1 ) {
+    while ( (c = getopt(argc, argv, "hlFrt:")) != -1 ) {
         switch (c) {
         case 'r':
             opts->raw = 1;
             break;
+        case 'l':
+            opts->log = 1;
+            break;
+        case 'F':
+            opts->flame = 1;
+            break;
         case 't':
             if (!strcasecmp(optarg, "sec")) {
                 opts->time_units = TIME_UNITS_SEC;
@@ -504,6 +771,8 @@ int main(int argc, char **argv)
         printf("Usage: %s [options] <file>\n", basename(argv[0]));
         printf("Options:\n");
         printf("      -r             raw output\n");
+        printf("      -l             print the full record log, not only aggregates\n");
+        printf("      -F             print collapsed call stacks for flame graph tools\n");
         printf("      -t UNITS       select time units (sec/msec/usec/nsec)\n");
         printf("\n");
         return -1;
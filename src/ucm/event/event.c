@@ -18,8 +18,10 @@
 #include <ucm/util/sys.h>
 #include <ucs/arch/cpu.h>
 
+#include <ucs/arch/atomic.h>
 #include <sys/mman.h>
 #include <pthread.h>
+#include <sched.h>
 #include <sys/shm.h>
 #include <sys/ipc.h>
 #include <stdlib.h>
@@ -27,7 +29,27 @@
 #include <errno.h>
 
 
-static pthread_rwlock_t ucm_event_lock = PTHREAD_RWLOCK_INITIALIZER;
+/*
+ * Dispatching an intercepted call must not take a lock - the allocation fast
+ * path of the application runs through here. Handlers are kept on a list which
+ * changes only at init/cleanup time; every change builds a flat snapshot array
+ * and publishes it RCU-style. Readers count themselves in and out with a
+ * single atomic; a writer publishes the new snapshot first, then waits for the
+ * reader count to drain before freeing the old one, so any reader which could
+ * still hold the old pointer has left.
+ */
+typedef struct ucm_event_snapshot {
+    unsigned                 count;
+    struct {
+        int                  events;
+        ucm_event_callback_t cb;
+        void                 *arg;
+    } entries[0];
+} ucm_event_snapshot_t;
+
+static pthread_mutex_t ucm_event_write_lock = PTHREAD_MUTEX_INITIALIZER;
+static ucm_event_snapshot_t *volatile ucm_event_snapshot = NULL;
+static volatile uint32_t ucm_event_readers = 0;
 static ucs_list_link_t ucm_event_handlers;
 static int ucm_external_events = 0;
 
@@ -113,39 +135,95 @@ static ucs_list_link_t ucm_event_handlers =
 
 static void ucm_event_dispatch(ucm_event_type_t event_type, ucm_event_t *event)
 {
-    ucm_event_handler_t *handler;
-
-    ucs_list_for_each(handler, &ucm_event_handlers, list) {
-        if (handler->events & event_type) {
-            handler->cb(event_type, event, handler->arg);
+    ucm_event_snapshot_t *snapshot;
+    unsigned i;
+
+    snapshot = ucm_event_snapshot;
+    if (snapshot == NULL) {
+        /* No handler was added yet - only the pass-through exists. This also
+         * covers the window inside ucm_set_event_handler() where the hooks
+         * are already installed but the first handler is not on the list. */
+        if (ucm_event_orig_handler.events & event_type) {
+            ucm_event_call_orig(event_type, event, NULL);
         }
+        return;
     }
-}
 
-#define ucm_event_lock(_lock_func) \
-    { \
-        int ret; \
-        do { \
-            ret = _lock_func(&ucm_event_lock); \
-        } while (ret == EAGAIN); \
-        if (ret != 0) { \
-            ucm_fatal("%s() failed: %s", #_lock_func, strerror(ret)); \
-        } \
+    for (i = 0; i < snapshot->count; ++i) {
+        if (snapshot->entries[i].events & event_type) {
+            snapshot->entries[i].cb(event_type, event,
+                                    snapshot->entries[i].arg);
+        }
     }
+}
 
 static void ucm_event_enter()
 {
-    ucm_event_lock(pthread_rwlock_rdlock);
+    /* The atomic add is a full barrier, so the snapshot loads which follow
+     * cannot move before the count is visible to a publishing writer */
+    ucs_atomic_add32(&ucm_event_readers, 1);
+}
+
+static void ucm_event_leave()
+{
+    ucs_atomic_add32(&ucm_event_readers, (uint32_t)-1);
 }
 
 static void ucm_event_enter_exclusive()
 {
-    ucm_event_lock(pthread_rwlock_wrlock);
+    int ret;
+
+    ret = pthread_mutex_lock(&ucm_event_write_lock);
+    if (ret != 0) {
+        ucm_fatal("pthread_mutex_lock() failed: %s", strerror(ret));
+    }
 }
 
-static void ucm_event_leave()
+static void ucm_event_leave_exclusive()
 {
-    pthread_rwlock_unlock(&ucm_event_lock);
+    pthread_mutex_unlock(&ucm_event_write_lock);
+}
+
+/* Build a snapshot of the handler list and publish it. Called with the write
+ * lock held; the old snapshot is freed once all readers which could have
+ * picked it up are gone. */
+static void ucm_event_snapshot_publish()
+{
+    ucm_event_snapshot_t *snapshot, *old_snapshot;
+    ucm_event_handler_t *handler;
+    unsigned count;
+
+    count = 0;
+    ucs_list_for_each(handler, &ucm_event_handlers, list) {
+        ++count;
+    }
+
+    snapshot = malloc(sizeof(*snapshot) +
+                      (count * sizeof(snapshot->entries[0])));
+    if (snapshot == NULL) {
+        ucm_fatal("failed to allocate event handler snapshot");
+    }
+
+    snapshot->count = 0;
+    ucs_list_for_each(handler, &ucm_event_handlers, list) {
+        snapshot->entries[snapshot->count].events = handler->events;
+        snapshot->entries[snapshot->count].cb     = handler->cb;
+        snapshot->entries[snapshot->count].arg    = handler->arg;
+        ++snapshot->count;
+    }
+
+    ucs_memory_cpu_store_fence();
+    old_snapshot       = ucm_event_snapshot;
+    ucm_event_snapshot = snapshot;
+
+    if (old_snapshot != NULL) {
+        /* Once the reader count hits zero, every reader which started before
+         * the new snapshot was published has left the dispatch */
+        while (ucm_event_readers != 0) {
+            sched_yield();
+        }
+        free(old_snapshot);
+    }
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -269,12 +347,13 @@ void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
     ucm_event_t event;
     size_t size;
 
+    /* The segment size query is a syscall - keep it off the dispatch path */
+    size = ucm_shm_size(shmid);
+
     ucm_event_enter();
 
     ucm_trace("ucm_shmat(shmid=%d shmaddr=%p shmflg=0x%x)",
               shmid, shmaddr, shmflg);
-
-    size = ucm_shm_size(shmid);
     event.shmat.result  = MAP_FAILED;
     event.shmat.shmid   = shmid;
     event.shmat.shmaddr = shmaddr;
@@ -293,12 +372,16 @@ void *ucm_shmat(int shmid, const void *shmaddr, int shmflg)
 int ucm_shmdt(const void *shmaddr)
 {
     ucm_event_t event;
+    size_t size;
+
+    /* The attached-segment bookkeeping lookup stays off the dispatch path */
+    size = ucm_get_shm_seg_size(shmaddr);
 
     ucm_event_enter();
 
     ucm_debug("ucm_shmdt(shmaddr=%p)", shmaddr);
 
-    ucm_dispatch_vm_munmap((void*)shmaddr, ucm_get_shm_seg_size(shmaddr));
+    ucm_dispatch_vm_munmap((void*)shmaddr, size);
 
     event.shmdt.result  = -1;
     event.shmdt.shmaddr = shmaddr;
@@ -342,20 +425,23 @@ void ucm_event_handler_add(ucm_event_handler_t *handler)
     ucs_list_for_each(elem, &ucm_event_handlers, list) {
         if (handler->priority < elem->priority) {
             ucs_list_insert_before(&elem->list, &handler->list);
-            ucm_event_leave();
-            return;
+            goto out_publish;
         }
     }
 
     ucs_list_add_tail(&ucm_event_handlers, &handler->list);
-    ucm_event_leave();
+
+out_publish:
+    ucm_event_snapshot_publish();
+    ucm_event_leave_exclusive();
 }
 
 void ucm_event_handler_remove(ucm_event_handler_t *handler)
 {
     ucm_event_enter_exclusive();
     ucs_list_del(&handler->list);
-    ucm_event_leave();
+    ucm_event_snapshot_publish();
+    ucm_event_leave_exclusive();
 }
 
 static ucs_status_t ucm_event_install(int events)
@@ -435,14 +521,14 @@ void ucm_set_external_event(int events)
 {
     ucm_event_enter_exclusive();
     ucm_external_events |= events;
-    ucm_event_leave();
+    ucm_event_leave_exclusive();
 }
 
 void ucm_unset_external_event(int events)
 {
     ucm_event_enter_exclusive();
     ucm_external_events &= ~events;
-    ucm_event_leave();
+    ucm_event_leave_exclusive();
 }
 
 void ucm_unset_event_handler(int events, ucm_event_callback_t cb, void *arg)
@@ -460,7 +546,8 @@ void ucm_unset_event_handler(int events, ucm_event_callback_t cb, void *arg)
             }
         }
     }
-    ucm_event_leave();
+    ucm_event_snapshot_publish();
+    ucm_event_leave_exclusive();
 
     /* Do not release memory while we hold event lock - may deadlock */
     while (!ucs_list_is_empty(&gc_list)) {
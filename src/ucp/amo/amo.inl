@@ -94,6 +94,15 @@ UCP_POST_AMO_DECL(uint32_t, uct_ep_atomic_add32)
         } \
         \
         UCP_THREAD_CS_ENTER_CONDITIONAL(&(_ep)->worker->mt_lock); \
+        \
+        if (ucs_unlikely((_ep)->worker->context->config.ext.amo_combine) && \
+            ucp_worker_amo_combine((_ep)->worker, _ep, _rkey, _remote_addr, \
+                                   _param, _size)) \
+        { \
+            status = UCS_OK; \
+            goto out_unlock; \
+        } \
+        \
         for (;;) { \
             status = UCP_RKEY_RESOLVE(_rkey, _ep, amo); \
             if (status != UCS_OK) { \
@@ -13,6 +13,108 @@
 #include <ucs/debug/profile.h>
 #include <inttypes.h>
 
+/*
+ * Issue the accumulated sum of a combine entry as a single wire atomic.
+ * Must be called with the worker lock held.
+ */
+static ucs_status_t ucp_amo_combine_issue(const ucp_amo_combine_entry_t *entry)
+{
+    ucp_rkey_h rkey = entry->rkey;
+    ucp_ep_h ep     = entry->ep;
+    ucs_status_t status;
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, amo);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    if (entry->op_size == sizeof(uint32_t)) {
+        return UCS_PROFILE_CALL(uct_ep_atomic_add32,
+                                ep->uct_eps[rkey->cache.amo_lane],
+                                (uint32_t)entry->value, entry->remote_addr,
+                                rkey->cache.amo_rkey);
+    } else {
+        return UCS_PROFILE_CALL(uct_ep_atomic_add64,
+                                ep->uct_eps[rkey->cache.amo_lane],
+                                entry->value, entry->remote_addr,
+                                rkey->cache.amo_rkey);
+    }
+}
+
+int ucp_worker_amo_combine(ucp_worker_h worker, ucp_ep_h ep, ucp_rkey_h rkey,
+                           uint64_t remote_addr, uint64_t value, size_t op_size)
+{
+    ucp_amo_combine_entry_t *entry;
+    int is_new;
+
+    entry = ucp_amo_combine_hash_get(&worker->amo_combine, remote_addr);
+    if (entry != NULL) {
+        if ((entry->ep == ep) && (entry->op_size == op_size)) {
+            /* Addition is modular, so the sum of the deltas lands the remote
+             * variable on the same value as issuing every add separately -
+             * including 32-bit wraparound */
+            entry->value += value;
+            return 1;
+        }
+
+        /* Same address reached through a different endpoint or operand width -
+         * put the pending sum on the wire first to keep the per-address order,
+         * then reuse the entry */
+        if (ucp_amo_combine_issue(entry) != UCS_OK) {
+            return 0;
+        }
+    } else {
+        entry = ucp_amo_combine_hash_put(&worker->amo_combine, remote_addr,
+                                         &is_new);
+        if (entry == NULL) {
+            return 0;
+        }
+    }
+
+    entry->ep          = ep;
+    entry->rkey        = rkey;
+    entry->remote_addr = remote_addr;
+    entry->value       = value;
+    entry->op_size     = op_size;
+    return 1;
+}
+
+void ucp_worker_amo_combine_drain(ucp_worker_h worker, int block)
+{
+    ucp_amo_combine_hash_t *hash = &worker->amo_combine;
+    ucp_amo_combine_hash_bucket_t *bucket;
+    ucp_amo_combine_entry_t entry;
+    ucs_status_t status;
+
+    while (hash->count > 0) {
+        for (bucket = hash->buckets; bucket->dist == 0; ++bucket);
+
+        /* Copy the entry out and remove it before issuing - a blocking issue
+         * progresses the worker, which may insert into the table and move
+         * buckets under our feet */
+        entry = bucket->value;
+        ucp_amo_combine_hash_del(hash, bucket->key);
+
+        while ((status = ucp_amo_combine_issue(&entry)) ==
+               UCS_ERR_NO_RESOURCE) {
+            if (!block) {
+                /* Leave the sum pending for the next drain. The insertion
+                 * cannot fail - the slot was freed just above */
+                ucp_worker_amo_combine(worker, entry.ep, entry.rkey,
+                                       entry.remote_addr, entry.value,
+                                       entry.op_size);
+                return;
+            }
+            ucp_worker_progress(worker);
+        }
+
+        if (status != UCS_OK) {
+            ucs_error("failed to issue combined atomic add to 0x%"PRIx64": %s",
+                      entry.remote_addr, ucs_status_string(status));
+        }
+    }
+}
+
 #define UCP_AMO_WITH_RESULT(_ep, _params, _remote_addr, _rkey, _result, _uct_func, _size) \
     { \
         uct_completion_t comp; \
@@ -24,6 +126,12 @@
         } \
         \
         UCP_THREAD_CS_ENTER_CONDITIONAL(&(_ep)->worker->mt_lock); \
+        \
+        /* A fetching atomic must observe every earlier combined add */ \
+        if (ucs_unlikely((_ep)->worker->amo_combine.count > 0)) { \
+            ucp_worker_amo_combine_drain((_ep)->worker, 1); \
+        } \
+        \
         comp.count = 2; \
         \
         for (;;) { \
@@ -118,3 +226,73 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_cswap64,
     UCP_AMO_WITH_RESULT(ep, (compare, swap), remote_addr, rkey, result,
                         uct_ep_atomic_cswap64, sizeof(uint64_t));
 }
+
+/*
+ * Floating-point fetch-add, emulated with a compare-swap loop over the bit
+ * pattern. The current value is fetched with an integer fadd of zero, and
+ * retries under contention are driven from here - so the application pays
+ * one round-trip per retry, never an application-level loop over the network.
+ */
+UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_fadd_fp32,
+                 (ep, add, remote_addr, rkey, result),
+                 ucp_ep_h ep, float add, uint64_t remote_addr, ucp_rkey_h rkey,
+                 float *result)
+{
+    union {
+        float    f;
+        uint32_t u;
+    } cur, next;
+    ucs_status_t status;
+    uint32_t prev;
+
+    status = ucp_atomic_fadd32(ep, 0, remote_addr, rkey, &cur.u);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    for (;;) {
+        next.f = cur.f + add;
+        status = ucp_atomic_cswap32(ep, cur.u, next.u, remote_addr, rkey,
+                                    &prev);
+        if (status != UCS_OK) {
+            return status;
+        }
+        if (prev == cur.u) {
+            *result = cur.f;
+            return UCS_OK;
+        }
+        cur.u = prev;
+    }
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_atomic_fadd_fp64,
+                 (ep, add, remote_addr, rkey, result),
+                 ucp_ep_h ep, double add, uint64_t remote_addr, ucp_rkey_h rkey,
+                 double *result)
+{
+    union {
+        double   f;
+        uint64_t u;
+    } cur, next;
+    ucs_status_t status;
+    uint64_t prev;
+
+    status = ucp_atomic_fadd64(ep, 0, remote_addr, rkey, &cur.u);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    for (;;) {
+        next.f = cur.f + add;
+        status = ucp_atomic_cswap64(ep, cur.u, next.u, remote_addr, rkey,
+                                    &prev);
+        if (status != UCS_OK) {
+            return status;
+        }
+        if (prev == cur.u) {
+            *result = cur.f;
+            return UCS_OK;
+        }
+        cur.u = prev;
+    }
+}
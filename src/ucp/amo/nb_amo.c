@@ -22,6 +22,12 @@ ucs_status_ptr_t ucp_atomic_fetch_nb(ucp_ep_h ep, ucp_atomic_fetch_op_t opcode,
     ucs_status_ptr_t status;
     UCP_RMA_CHECK_ATOMIC_PTR(remote_addr, op_size);
     UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    /* A fetching atomic must observe every earlier combined add */
+    if (ucs_unlikely(ep->worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(ep->worker, 1);
+    }
+
     req = ucp_request_get(ep->worker);
     if (ucs_unlikely(NULL == req)) {
         UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
@@ -53,6 +59,13 @@ ucs_status_t ucp_atomic_post(ucp_ep_h ep, ucp_atomic_post_op_t opcode, uint64_t
     if (status != UCS_OK) {
         goto out;
     }
+    if (ucs_unlikely(ep->worker->context->config.ext.amo_combine) &&
+        ucp_worker_amo_combine(ep->worker, ep, rkey, remote_addr, value,
+                               op_size))
+    {
+        status = UCS_OK;
+        goto out;
+    }
     if (op_size == sizeof(uint32_t)) {
         status = UCS_PROFILE_CALL(uct_ep_atomic_add32, ep->uct_eps[rkey->cache.amo_lane],
                                   (uint32_t)value, remote_addr, rkey->cache.amo_rkey);
@@ -15,6 +15,7 @@
 #include <ucs/type/cpu_set.h>
 #include <ucs/config/types.h>
 #include <stdio.h>
+#include <sys/socket.h>
 
 
 /**
@@ -228,7 +229,9 @@ enum ucp_context_attr_field {
  * present. It is used for the enablement of backward compatibility support.
  */
 enum ucp_worker_attr_field {
-    UCP_WORKER_ATTR_FIELD_THREAD_MODE = UCS_BIT(0)  /**< UCP thread mode */
+    UCP_WORKER_ATTR_FIELD_THREAD_MODE   = UCS_BIT(0), /**< UCP thread mode */
+    UCP_WORKER_ATTR_FIELD_MEM_FOOTPRINT = UCS_BIT(1)  /**< Buffer pool memory
+                                                           footprint */
 };
 
 /**
@@ -596,6 +599,12 @@ typedef struct ucp_worker_attr {
      * Thread safe level of the worker.
      */
     ucs_thread_mode_t     thread_mode;
+
+    /**
+     * Total memory, in bytes, currently held by the worker's communication
+     * buffer pools. See UCX_WORKER_MEM_BUDGET.
+     */
+    size_t                mem_footprint;
 } ucp_worker_attr_t;
 
 
@@ -746,6 +755,29 @@ struct ucp_tag_recv_info {
 };
 
 
+/**
+ * @ingroup UCP_CONTEXT
+ * @brief UCP receive operation descriptor
+ *
+ * Describes a single receive operation in a batch passed to
+ * @ref ucp_tag_recv_nb_multi "ucp_tag_recv_nb_multi". Each element carries
+ * the same arguments which would otherwise be passed to an individual
+ * @ref ucp_tag_recv_nb "ucp_tag_recv_nb" call.
+ */
+struct ucp_tag_recv_item {
+    /** Pointer to the buffer to receive the data to */
+    void                                   *buffer;
+    /** Number of elements to receive */
+    size_t                                 count;
+    /** Datatype descriptor for the elements in the buffer */
+    ucp_datatype_t                         datatype;
+    /** Message tag to expect */
+    ucp_tag_t                              tag;
+    /** Bit mask for matching the incoming tag against the expected tag */
+    ucp_tag_t                              tag_mask;
+};
+
+
 /**
  * @ingroup UCP_CONFIG
  * @brief Read UCP configuration descriptor
@@ -1093,6 +1125,126 @@ void ucp_worker_release_address(ucp_worker_h worker, ucp_address_t *address);
 void ucp_worker_progress(ucp_worker_h worker);
 
 
+/**
+ * @ingroup UCP_WORKER
+ * @brief Operation code of an injected operation descriptor.
+ */
+typedef enum ucp_inject_opcode {
+    UCP_INJECT_OP_TAG_SEND,       /**< Contiguous tagged send */
+    UCP_INJECT_OP_PUT,            /**< Contiguous remote memory put */
+    UCP_INJECT_OP_FLUSH           /**< Flush the endpoint */
+} ucp_inject_opcode_t;
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Injected operation descriptor.
+ *
+ * Describes one operation deposited by @ref ucp_worker_inject. Fields which
+ * are not used by the given @a opcode are ignored.
+ */
+typedef struct ucp_inject_op {
+    ucp_inject_opcode_t      opcode;      /**< Operation to perform */
+    ucp_ep_h                 ep;          /**< Destination endpoint */
+    const void               *buffer;     /**< Data to send (send/put) */
+    size_t                   length;      /**< Data length, in bytes */
+    ucp_tag_t                tag;         /**< Message tag (tag send) */
+    uint64_t                 remote_addr; /**< Remote address (put) */
+    ucp_rkey_h               rkey;        /**< Remote memory key (put) */
+} ucp_inject_op_t;
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Deposit an operation for execution by the worker progress thread.
+ *
+ * This routine may be called from any thread, without holding any lock, on a
+ * worker created with @ref UCS_THREAD_MODE_SINGLE. The descriptor is copied
+ * to a bounded lock-free ring and executed by the next call to @ref
+ * ucp_worker_progress "ucp_worker_progress()" - normally made by the single
+ * thread which owns the worker. This gives multi-threaded applications
+ * serialized submission without taking a per-worker lock on every operation,
+ * as @ref UCS_THREAD_MODE_MULTI would.
+ *
+ * The operations are fire-and-forget: @a buffer must remain valid until a
+ * subsequently injected @ref UCP_INJECT_OP_FLUSH on the same endpoint
+ * completes.
+ *
+ * @param [in]  worker    Worker to deposit the operation to.
+ * @param [in]  op        Operation descriptor; copied by this call.
+ *
+ * @return UCS_OK               - Operation was deposited.
+ * @return UCS_ERR_NO_RESOURCE  - The ring is full; retry after the progress
+ *                                thread has drained it.
+ * @return UCS_ERR_UNSUPPORTED  - The worker was created with
+ *                                @ref UCS_THREAD_MODE_MULTI.
+ */
+ucs_status_t ucp_worker_inject(ucp_worker_h worker, const ucp_inject_op_t *op);
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Pre-establish endpoints to a known set of peers.
+ *
+ * This routine creates endpoints to all peers in @a addresses and warms up the
+ * worker internal resource pools, so that the first message to any of the
+ * peers is sent at steady-state latency. Connection establishment proceeds in
+ * the background, driven by the worker async thread, while the application
+ * continues its own initialization; the application does not have to call
+ * @ref ucp_worker_progress for the warm-up to complete.
+ *
+ * A subsequent @ref ucp_ep_create to one of the peers returns the endpoint
+ * which was established by this routine.
+ *
+ * @param [in]  worker      Worker to warm up.
+ * @param [in]  num_addrs   Number of entries in @a addresses.
+ * @param [in]  addresses   Array of remote worker addresses, as obtained from
+ *                          @ref ucp_worker_get_address on the remote side.
+ *
+ * @return Error code as defined by @ref ucs_status_t. Endpoints which were
+ *         created before a failure remain established.
+ */
+ucs_status_t ucp_worker_warmup(ucp_worker_h worker, unsigned num_addrs,
+                               const ucp_address_t * const *addresses);
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Save the addresses of all connected peers to a file.
+ *
+ * This routine serializes the packed addresses of every peer the worker is
+ * connected to into a file, which a related process - typically a child of
+ * the current one, sharing the same hardware view - can pass to
+ * @ref ucp_worker_address_book_load to connect to the same peer set without
+ * repeating the address exchange. Place the file on node-local storage, such
+ * as /dev/shm, to make the hand-off a memory copy. The file is written
+ * atomically, so concurrent readers see either the old or the new content.
+ *
+ * @param [in]  worker   Worker whose peer addresses to save.
+ * @param [in]  path     File to write.
+ *
+ * @return Error code as defined by @ref ucs_status_t.
+ */
+ucs_status_t ucp_worker_address_book_save(ucp_worker_h worker, const char *path);
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Connect to all peers saved by @ref ucp_worker_address_book_save.
+ *
+ * This routine reads a peer address file and establishes endpoints to all
+ * peers recorded in it, warming up in the background as described in
+ * @ref ucp_worker_warmup. It is typically called by a forked or spawned
+ * child instead of performing its own address exchange.
+ *
+ * @param [in]  worker   Worker to connect.
+ * @param [in]  path     File written by @ref ucp_worker_address_book_save.
+ *
+ * @return Error code as defined by @ref ucs_status_t.
+ */
+ucs_status_t ucp_worker_address_book_load(ucp_worker_h worker, const char *path);
+
+
 /**
  * @ingroup UCP_WAKEUP
  * @brief Obtain an event file descriptor for event notification.
@@ -1266,6 +1418,104 @@ ucs_status_t ucp_ep_create(ucp_worker_h worker, const ucp_ep_params_t *params,
                            ucp_ep_h *ep_p);
 
 
+/**
+ * @ingroup UCP_ENDPOINT
+ * @brief Create and connect multiple endpoints.
+ *
+ * This routine creates and connects a batch of @ref ucp_ep_h "endpoints", one
+ * for each entry of the parameters array, as if @ref ucp_ep_create was called
+ * in a loop. It is intended for bootstrap phases which connect to many remote
+ * workers at once: the whole batch shares the unpacking scratch space and
+ * internal caches, which makes it considerably faster than creating the
+ * endpoints one by one. Like @ref ucp_ep_create, this function is non-blocking.
+ *
+ * @param [in]  worker      Handle to the worker; the endpoints
+ *                          are associated with the worker.
+ * @param [in]  num_eps     Number of endpoints to create.
+ * @param [in]  params      Array of @c num_eps user defined
+ *                          @ref ucp_ep_params_t configurations, one per
+ *                          endpoint.
+ * @param [out] eps         Array of @c num_eps handles, filled with the
+ *                          created endpoints.
+ *
+ * @return Error code as defined by @ref ucs_status_t. On error, endpoints
+ *         which were already created remain valid in the beginning of @a eps,
+ *         and the remaining entries are untouched.
+ */
+ucs_status_t ucp_ep_create_multi(ucp_worker_h worker, unsigned num_eps,
+                                 const ucp_ep_params_t *params, ucp_ep_h *eps);
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Create a listener which accepts connection requests.
+ *
+ * This routine binds a @ref ucp_listener_h "listener" to the given socket
+ * address and starts accepting connection requests on it. For each accepted
+ * request, a fully wired @ref ucp_ep_h "endpoint" to the requesting client
+ * is created and reported through @a accept_cb. The listening socket is only
+ * used to bootstrap the connection - it carries the packed worker addresses
+ * of the two sides - and all subsequent communication goes through the
+ * regular transport lanes, so there is no need for an out-of-band address
+ * exchange. The listener is progressed by @ref ucp_worker_progress.
+ *
+ * @param [in]  worker      Worker to create the listener on.
+ * @param [in]  addr        Local socket address to listen on.
+ * @param [in]  addrlen     Length of the socket address.
+ * @param [in]  accept_cb   Callback invoked for each accepted connection.
+ * @param [in]  arg         User argument passed to @a accept_cb.
+ * @param [out] listener_p  A handle to the created listener.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_listener_create(ucp_worker_h worker,
+                                 const struct sockaddr *addr, socklen_t addrlen,
+                                 ucp_listener_accept_callback_t accept_cb,
+                                 void *arg, ucp_listener_h *listener_p);
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Stop accepting connection requests and destroy the listener.
+ *
+ * Endpoints which were already created from accepted connection requests are
+ * not affected and must be destroyed separately.
+ *
+ * @param [in]  listener    Listener to destroy.
+ */
+void ucp_listener_destroy(ucp_listener_h listener);
+
+
+/**
+ * @ingroup UCP_ENDPOINT
+ * @brief Create and connect an endpoint to a remote listener.
+ *
+ * This routine connects to a @ref ucp_listener_h "listener" bound on the
+ * remote side, exchanges the packed worker addresses of the two sides over
+ * the bootstrap socket in a single round trip, and creates an endpoint to
+ * the remote worker as if @ref ucp_ep_create was called with the remote
+ * address. The remote side receives a matching endpoint through the accept
+ * callback of its listener. The bootstrap exchange is blocking; the returned
+ * endpoint behaves exactly like one created by @ref ucp_ep_create.
+ *
+ * @param [in]  worker      Handle to the worker on which the endpoint
+ *                          is created.
+ * @param [in]  addr        Socket address the remote listener is bound to.
+ * @param [in]  addrlen     Length of the socket address.
+ * @param [in]  params      Optional @ref ucp_ep_params_t endpoint tuning
+ *                          parameters; the remote address field is filled in
+ *                          by this routine. May be NULL.
+ * @param [out] ep_p        A handle to the created endpoint.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_ep_create_sockaddr(ucp_worker_h worker,
+                                    const struct sockaddr *addr,
+                                    socklen_t addrlen,
+                                    const ucp_ep_params_t *params,
+                                    ucp_ep_h *ep_p);
+
+
 /**
  * @ingroup UCP_ENDPOINT
  *
@@ -1325,6 +1575,35 @@ void ucp_ep_print_info(ucp_ep_h ep, FILE *stream);
 ucs_status_t ucp_ep_flush(ucp_ep_h ep);
 
 
+/**
+ * @ingroup UCP_ENDPOINT
+ *
+ * @brief Non-blocking flush of outstanding AMO and RMA operations on the
+ * @ref ucp_ep_h "endpoint".
+ *
+ * This routine flushes all outstanding AMO and RMA communications on the
+ * @ref ucp_ep_h "endpoint". All the AMO and RMA operations issued on the
+ * @a ep prior to this call are completed both at the origin and at the target
+ * @ref ucp_ep_h "endpoint" when the returned request completes. Unlike
+ * @ref ucp_ep_flush "ucp_ep_flush()", this routine returns immediately and the
+ * flush is progressed by @ref ucp_worker_progress "ucp_worker_progress()", so
+ * the flush latency can be overlapped with other work, and several flush
+ * epochs can be kept in flight.
+ *
+ * @param [in] ep        UCP endpoint.
+ * @param [in] cb        Callback which is invoked when the flush completes.
+ *
+ * @return NULL             - The flush was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The flush operation failed.
+ * @return otherwise        - Flush started, and a request handle is returned
+ *                          to the application in order to track its progress.
+ *                          The application is responsible to release the
+ *                          handle using @ref ucp_request_free
+ *                          "ucp_request_free()" routine.
+ */
+ucs_status_ptr_t ucp_ep_flush_nb(ucp_ep_h ep, ucp_send_callback_t cb);
+
+
 /**
  * @ingroup UCP_MEM
  * @brief Map or allocate memory for zero-copy operations.
@@ -1403,6 +1682,55 @@ ucs_status_t ucp_mem_map(ucp_context_h context, const ucp_mem_map_params_t *para
                          ucp_mem_h *memh_p);
 
 
+/**
+ * @ingroup UCP_MEM
+ * @brief Map or allocate memory without blocking on registration
+ *
+ * This routine is equivalent to @ref ucp_mem_map "ucp_mem_map()", except that
+ * when registering memory provided by the user, the per-transport registration
+ * is performed on a background thread and the routine returns immediately.
+ * Registering a large buffer can take hundreds of milliseconds, and this
+ * routine takes that time off the caller's critical path. The returned handle
+ * becomes usable on each transport as its registration completes; completion
+ * of the whole handle can be checked with @ref ucp_mem_map_test
+ * "ucp_mem_map_test()". When memory is also allocated (@ref
+ * UCP_MEM_MAP_ALLOCATE), the mapping is performed synchronously, since the
+ * allocated address must be available when the routine returns.
+ *
+ * @note A remote key packed from the handle before registration completes
+ * covers only the transports registered so far, so a peer should pack rkeys
+ * only after @ref ucp_mem_map_test "ucp_mem_map_test()" returns @ref UCS_OK.
+ *
+ * @param [in]     context    Application @ref ucp_context_h "context" to map
+ *                            (register) and allocate the memory on.
+ * @param [in]     params     User defined @ref ucp_mem_map_params_t configurations
+ *                            for the @ref ucp_mem_h "UCP memory handle".
+ * @param [out]    memh_p     UCP @ref ucp_mem_h "handle" for the allocated
+ *                            segment.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_mem_map_nb(ucp_context_h context,
+                            const ucp_mem_map_params_t *params,
+                            ucp_mem_h *memh_p);
+
+
+/**
+ * @ingroup UCP_MEM
+ * @brief Check whether a nonblocking memory mapping has completed
+ *
+ * @param [in]  memh        @ref ucp_mem_h "Handle" to memory region, returned
+ *                          from @ref ucp_mem_map_nb "ucp_mem_map_nb()".
+ *
+ * @return UCS_OK           - The memory is registered on all transports.
+ * @return UCS_INPROGRESS   - Registration is still in progress.
+ * @return Otherwise        - Error code of the failed registration. The handle
+ *                            must still be released with @ref ucp_mem_unmap
+ *                            "ucp_mem_unmap()".
+ */
+ucs_status_t ucp_mem_map_test(ucp_mem_h memh);
+
+
 /**
  * @ingroup UCP_MEM
  * @brief Unmap memory segment
@@ -1593,6 +1921,27 @@ void ucp_rkey_buffer_release(void *rkey_buffer);
 ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, void *rkey_buffer, ucp_rkey_h *rkey_p);
 
 
+/**
+ * @ingroup UCP_MEM
+ * @brief Create remote access keys from an array of packed buffers.
+ *
+ * This routine unpacks an array of packed remote keys, as if by calling
+ * @ref ucp_ep_rkey_unpack "ucp_ep_rkey_unpack()" for every buffer. It is a
+ * convenience routine for unpacking a table of remote memory windows in one
+ * pass. If unpacking one of the buffers fails, the keys unpacked so far are
+ * destroyed and no keys are returned.
+ *
+ * @param [in]  ep            Endpoint to access using the remote keys.
+ * @param [in]  rkey_buffers  Array of packed rkeys.
+ * @param [in]  num_buffers   Number of elements in @a rkey_buffers.
+ * @param [out] rkeys         Filled with @a num_buffers remote key handles.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_ep_rkey_unpack_multi(ucp_ep_h ep, void **rkey_buffers,
+                                      size_t num_buffers, ucp_rkey_h *rkeys);
+
+
 /**
  * @ingroup UCP_MEM
  * @brief Destroy the remote key
@@ -1685,6 +2034,37 @@ ucs_status_ptr_t ucp_tag_send_nb(ucp_ep_h ep, const void *buffer, size_t count,
                                  ucp_send_callback_t cb);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking tagged-send operation with user-provided request.
+ *
+ * Same as @ref ucp_tag_send_nb, except the request storage is allocated by
+ * the application and there is no completion callback: the UCP library never
+ * touches the request mpool. If the routine returns UCS_INPROGRESS, the
+ * application monitors completion of the operation with @ref ucp_request_test
+ * on @a req; any other return value means the operation completed in place
+ * and @a req was not used.
+ *
+ * @param [in]  ep          Destination endpoint handle.
+ * @param [in]  buffer      Pointer to the message buffer (payload).
+ * @param [in]  count       Number of elements to send
+ * @param [in]  datatype    Datatype descriptor for the elements in the buffer.
+ * @param [in]  tag         Message tag.
+ * @param [in]  req         Request handle allocated by the user. There should
+ *                          be at least UCP request size bytes of available
+ *                          space before the @a req. The size of UCP request
+ *                          can be obtained by @ref ucp_context_query function.
+ *
+ * @return UCS_OK           - The send operation was completed immediately.
+ * @return UCS_INPROGRESS   - The send was scheduled and can be completed at
+ *                          any point in time; poll @a req to track it.
+ * @return otherwise        - Error code as defined by @ref ucs_status_t.
+ */
+ucs_status_t ucp_tag_send_nbr(ucp_ep_h ep, const void *buffer, size_t count,
+                              ucp_datatype_t datatype, ucp_tag_t tag,
+                              void *req);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Non-blocking synchronous tagged-send operation.
@@ -1797,6 +2177,40 @@ ucs_status_t ucp_tag_recv_nbr(ucp_worker_h worker, void *buffer, size_t count,
                               ucp_tag_t tag_mask, void *req);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking batched tagged-receive operation.
+ *
+ * This routine posts a batch of receive operations, each described by an
+ * element of the @a items array, in a single call. Posting many receives at
+ * once amortizes the per-call overhead (locking and request setup) over the
+ * whole batch, which matters for applications which pre-post large numbers
+ * of receive buffers. Every element is processed exactly as if it was passed
+ * to @ref ucp_tag_recv_nb "ucp_tag_recv_nb", in array order, and the
+ * resulting request handle (or error pointer) is returned in the
+ * corresponding element of @a reqs.
+ *
+ * @param [in]  worker      UCP worker that is used for the receive operations.
+ * @param [in]  items       Array of receive operation descriptors.
+ * @param [in]  num_items   Number of elements in @a items and @a reqs.
+ * @param [in]  cb          Callback function that is invoked whenever a
+ *                          receive operation from the batch is completed and
+ *                          the data is ready in its receive buffer.
+ * @param [out] reqs        Array filled with one request handle per element,
+ *                          with the same semantics as the return value of
+ *                          @ref ucp_tag_recv_nb "ucp_tag_recv_nb".
+ *
+ * @return UCS_OK           - All operations in the batch were posted.
+ * @return otherwise        - At least one operation could not be started; the
+ *                            failed elements of @a reqs hold the error, and
+ *                            the remaining operations are still posted.
+ */
+ucs_status_t ucp_tag_recv_nb_multi(ucp_worker_h worker,
+                                   const ucp_tag_recv_item_t *items,
+                                   size_t num_items, ucp_tag_recv_callback_t cb,
+                                   ucs_status_ptr_t *reqs);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Non-blocking probe and return a message.
@@ -1881,6 +2295,50 @@ ucs_status_ptr_t ucp_tag_msg_recv_nb(ucp_worker_h worker, void *buffer,
                                      ucp_tag_recv_callback_t cb);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Borrow the data of a probed message without copying it.
+ *
+ * This routine returns a pointer to the payload of a message matched by @ref
+ * ucp_tag_probe_nb "ucp_tag_probe_nb()" (with remove == 1), inside the receive
+ * descriptor held by the UCP library. It is an alternative to @ref
+ * ucp_tag_msg_recv_nb "ucp_tag_msg_recv_nb()" for consumers which read the
+ * data once and discard it, and saves the copy to a user buffer. The data is
+ * valid until the message handle is released with @ref ucp_tag_msg_release
+ * "ucp_tag_msg_release()", which must be called exactly once afterwards.
+ *
+ * Only messages which arrived in a single fragment can be borrowed. If the
+ * routine returns UCS_ERR_UNSUPPORTED the message handle is left untouched,
+ * and the application must receive it with @ref ucp_tag_msg_recv_nb
+ * "ucp_tag_msg_recv_nb()" instead.
+ *
+ * @param [in]  worker      UCP worker on which the message was matched.
+ * @param [in]  message     Message handle returned by @ref ucp_tag_probe_nb.
+ * @param [out] data        Filled with a pointer to the message payload.
+ * @param [out] length      Filled with the payload length, in bytes.
+ *
+ * @return UCS_OK              - The payload pointer is valid.
+ * @return UCS_ERR_UNSUPPORTED - The message spans several fragments or is a
+ *                               rendezvous message, and cannot be borrowed.
+ */
+ucs_status_t ucp_tag_msg_data(ucp_worker_h worker, ucp_tag_message_h message,
+                              void **data, size_t *length);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Release a message borrowed with @ref ucp_tag_msg_data.
+ *
+ * This routine returns the receive descriptor of a borrowed message to the
+ * library. The payload pointer obtained from @ref ucp_tag_msg_data
+ * "ucp_tag_msg_data()" must not be accessed afterwards.
+ *
+ * @param [in]  worker      UCP worker on which the message was matched.
+ * @param [in]  message     Message handle whose data was borrowed.
+ */
+void ucp_tag_msg_release(ucp_worker_h worker, ucp_tag_message_h message);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Blocking remote memory put operation.
@@ -1935,6 +2393,179 @@ ucs_status_t ucp_put_nbi(ucp_ep_h ep, const void *buffer, size_t length,
                          uint64_t remote_addr, ucp_rkey_h rkey);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking implicit put with an ordered notification write.
+ *
+ * This routine stores the contiguous block of data described by @a buffer in
+ * the remote memory at @a remote_addr, and then writes the 8-byte value
+ * @a notify_value to @a notify_addr in the same registered remote region.
+ * The payload and the notification are issued as one ordered transport
+ * sequence on a single lane, so the target is guaranteed to observe the
+ * notification only after the whole payload - without the flush which a
+ * separate put + flush + put pattern would require. Intended for
+ * producer-consumer handoffs where the consumer polls on the notification
+ * word.
+ *
+ * The routine returns immediately and @b does @b not guarantee re-usability
+ * of the source address @e buffer; use @ref ucp_ep_flush "ucp_ep_flush()" or
+ * @ref ucp_worker_flush "ucp_worker_flush()" for that, as with
+ * @ref ucp_put_nbi "ucp_put_nbi()".
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  buffer       Pointer to the local source address.
+ * @param [in]  length       Length of the data (in bytes) stored under the
+ *                           source address.
+ * @param [in]  remote_addr  Pointer to the destination remote address
+ *                           to write to.
+ * @param [in]  rkey         Remote memory key associated with both the
+ *                           remote address and the notification address.
+ * @param [in]  notify_value Value to write to @a notify_addr after the
+ *                           payload.
+ * @param [in]  notify_addr  Remote address of the notification word.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_put_notify_nbi(ucp_ep_h ep, const void *buffer, size_t length,
+                                uint64_t remote_addr, ucp_rkey_h rkey,
+                                uint64_t notify_value, uint64_t notify_addr);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Flags for @ref ucp_put_nb "ucp_put_nb()".
+ */
+enum ucp_put_flags {
+    /**
+     * Complete the request only when the data reached the target memory,
+     * rather than when the source buffer may be reused. Provides
+     * per-operation delivery semantics for producer-consumer signaling,
+     * without flushing unrelated operations like @ref ucp_ep_flush
+     * "ucp_ep_flush()" would.
+     */
+    UCP_PUT_FLAG_REMOTE_COMPLETE = UCS_BIT(0)
+};
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking remote memory put operation.
+ *
+ * This routine initiates a storage of contiguous block of data that is
+ * described by the local address @a buffer in the remote contiguous memory
+ * region described by @a remote_addr address and the @ref ucp_rkey_h "memory
+ * handle" @a rkey. The routine returns immediately; by default the returned
+ * request completes when the source address @e buffer can be reused. With
+ * @ref UCP_PUT_FLAG_REMOTE_COMPLETE the request completes only when the data
+ * was delivered to the target memory.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  buffer       Pointer to the local source address.
+ * @param [in]  length       Length of the data (in bytes) stored under the
+ *                           source address.
+ * @param [in]  remote_addr  Pointer to the destination remote address
+ *                           to write to.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote address.
+ * @param [in]  flags        Flags from @ref ucp_put_flags.
+ * @param [in]  cb           Callback which is invoked when the put completes.
+ *
+ * @return NULL             - The operation was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The operation failed.
+ * @return otherwise        - Operation was scheduled and a request handle is
+ *                          returned to the application in order to track its
+ *                          progress. The application is responsible to
+ *                          release the handle using @ref ucp_request_free
+ *                          "ucp_request_free()" routine.
+ */
+ucs_status_ptr_t ucp_put_nb(ucp_ep_h ep, const void *buffer, size_t length,
+                            uint64_t remote_addr, ucp_rkey_h rkey,
+                            unsigned flags, ucp_send_callback_t cb);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Put burst context.
+ *
+ * Holds the transport dispatch state resolved once by @ref
+ * ucp_put_burst_begin "ucp_put_burst_begin()" and reused by every @ref
+ * ucp_put_burst "ucp_put_burst()" in the bracket. The structure is typically
+ * placed on the caller's stack; all fields are private to the library.
+ */
+typedef struct ucp_put_burst {
+    ucp_ep_h                ep;            /**< @internal Endpoint of the burst */
+    ucp_rkey_h              rkey;          /**< @internal Remote key of the burst */
+    uint16_t                cfg_index;     /**< @internal Endpoint configuration
+                                                the cache was resolved for */
+    uint8_t                 lane;          /**< @internal Resolved lane */
+    void                    *uct_ep;       /**< @internal Resolved transport
+                                                endpoint */
+    uintptr_t               uct_rkey;      /**< @internal Resolved transport
+                                                remote key */
+    size_t                  max_put_short; /**< @internal Short put size limit */
+    size_t                  max_put_bcopy; /**< @internal Bcopy put size limit */
+} ucp_put_burst_t;
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Open a bracket of remote memory put operations.
+ *
+ * This routine resolves the transport endpoint, lane and remote key for
+ * @a rkey once, so that a subsequent burst of @ref ucp_put_burst
+ * "ucp_put_burst()" calls to the same destination skips the per-operation
+ * dispatch. Intended for PGAS-style codes which issue many small puts
+ * between synchronization points.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  rkey         Remote memory key the burst will write through.
+ * @param [out] burst        Burst context to initialize.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_put_burst_begin(ucp_ep_h ep, ucp_rkey_h rkey,
+                                 ucp_put_burst_t *burst);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Non-blocking put inside a burst bracket.
+ *
+ * Same semantics as @ref ucp_put_nbi "ucp_put_nbi()", using the dispatch
+ * state cached in @a burst. The routine @b does @b not track per-operation
+ * completion; re-usability of @a buffer and remote completion of all the
+ * puts of the bracket are guaranteed only by @ref ucp_put_burst_end
+ * "ucp_put_burst_end()".
+ *
+ * @param [in]  burst        Burst context opened by @ref ucp_put_burst_begin
+ *                           "ucp_put_burst_begin()".
+ * @param [in]  buffer       Pointer to the local source address.
+ * @param [in]  length       Length of the data (in bytes) stored under the
+ *                           source address.
+ * @param [in]  remote_addr  Pointer to the destination remote address
+ *                           to write to.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_put_burst(ucp_put_burst_t *burst, const void *buffer,
+                           size_t length, uint64_t remote_addr);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Close a bracket of remote memory put operations.
+ *
+ * This routine flushes the single lane used by the burst and returns when
+ * all the puts issued within the bracket are remotely completed. It is the
+ * only completion point of the bracket.
+ *
+ * @param [in]  burst        Burst context to close.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_put_burst_end(ucp_put_burst_t *burst);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Blocking remote memory get operation.
@@ -2238,6 +2869,64 @@ ucs_status_t ucp_atomic_cswap64(ucp_ep_h ep, uint64_t compare, uint64_t swap,
                                 uint64_t *result);
 
 
+/**
+ * @ingroup UCP_COMM
+ * @brief Blocking atomic fetch and add operation for single-precision floats
+ *
+ * This routine atomically adds @a add to the single-precision float value at
+ * the remote memory address @a remote_addr, described together with the
+ * @ref ucp_rkey_h "remote memory handle" @a rkey. When the operation
+ * completes, the original remote value is stored in the local memory
+ * @a result, and the sum is stored in remote memory.
+ *
+ * Transports do not provide floating-point atomics, so the operation is
+ * emulated with a compare-swap loop over the bit pattern, executed entirely
+ * inside the library - a retry under contention costs one additional
+ * round-trip, never an application-level loop.
+ *
+ * @note The remote address must be aligned to 32 bit.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  add          Value to add.
+ * @param [in]  remote_addr  Pointer to the destination remote address
+ *                           of the atomic variable.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote address.
+ * @param [out] result       Pointer to the address that is used to store
+ *                           the previous value of the atomic variable described
+ *                           by the @a remote_addr
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_atomic_fadd_fp32(ucp_ep_h ep, float add, uint64_t remote_addr,
+                                  ucp_rkey_h rkey, float *result);
+
+
+/**
+ * @ingroup UCP_COMM
+ * @brief Blocking atomic fetch and add operation for double-precision floats
+ *
+ * Same semantics as @ref ucp_atomic_fadd_fp32 "ucp_atomic_fadd_fp32()", for
+ * double-precision values.
+ *
+ * @note The remote address must be aligned to 64 bit.
+ *
+ * @param [in]  ep           Remote endpoint handle.
+ * @param [in]  add          Value to add.
+ * @param [in]  remote_addr  Pointer to the destination remote address
+ *                           of the atomic variable.
+ * @param [in]  rkey         Remote memory key associated with the
+ *                           remote address.
+ * @param [out] result       Pointer to the address that is used to store
+ *                           the previous value of the atomic variable described
+ *                           by the @a remote_addr
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_atomic_fadd_fp64(ucp_ep_h ep, double add, uint64_t remote_addr,
+                                  ucp_rkey_h rkey, double *result);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief Post an atomic memory operation.
@@ -2399,6 +3088,43 @@ ucs_status_t ucp_dt_create_generic(const ucp_generic_dt_ops_t *ops, void *contex
                                    ucp_datatype_t *datatype_p);
 
 
+/**
+ * @ingroup UCP_DATATYPE
+ * @brief Create a strided datatype.
+ *
+ * This routine creates a strided datatype object, describing a regular layout
+ * of equal-size contiguous blocks: @a count blocks of @a block_length bytes,
+ * whose start addresses are @a stride bytes apart. A second dimension of
+ * @a outer_count rows, @a outer_stride bytes apart, allows expressing 2D
+ * layouts such as sub-matrices; pass @a outer_count as 1 for a flat stride,
+ * in which case @a outer_stride is ignored. Unlike @ref ucp_dt_iov_t, the
+ * layout is described by a handful of scalars regardless of the number of
+ * blocks, and is packed without walking a descriptor list.
+ * The base address of the data is the buffer passed to the communication
+ * routine; the @a count argument of the routine gives the number of strided
+ * elements, laid out back-to-back with an extent of
+ * <i>outer_stride * outer_count</i> bytes.
+ * The application is responsible to release the @a datatype_p object using
+ * @ref ucp_dt_destroy "ucp_dt_destroy()" routine.
+ *
+ * @param [in]  block_length Length of every contiguous block, in bytes.
+ * @param [in]  stride       Distance between starts of consecutive blocks,
+ *                           in bytes. Must be at least @a block_length.
+ * @param [in]  count        Number of blocks in a row.
+ * @param [in]  outer_stride Distance between starts of consecutive rows, in
+ *                           bytes. Must be at least @a stride * @a count,
+ *                           unless @a outer_count is 1.
+ * @param [in]  outer_count  Number of rows.
+ * @param [out] datatype_p   A pointer to datatype object.
+ *
+ * @return Error code as defined by @ref ucs_status_t
+ */
+ucs_status_t ucp_dt_create_strided(size_t block_length, size_t stride,
+                                   size_t count, size_t outer_stride,
+                                   size_t outer_count,
+                                   ucp_datatype_t *datatype_p);
+
+
 /**
  * @ingroup UCP_DATATYPE
  * @brief Destroy a datatype and release its resources.
@@ -2406,7 +3132,8 @@ ucs_status_t ucp_dt_create_generic(const ucp_generic_dt_ops_t *ops, void *contex
  * This routine destroys the @a datatype object and
  * releases any resources that are associated with the object.
  * The @a datatype object must be allocated using @ref ucp_dt_create_generic
- * "ucp_dt_create_generic()" routine.
+ * "ucp_dt_create_generic()" or @ref ucp_dt_create_strided
+ * "ucp_dt_create_strided()" routines.
  *
  * @warning
  * @li Once the @a datatype object is released an access to this object may
@@ -2464,6 +3191,35 @@ ucs_status_t ucp_worker_fence(ucp_worker_h worker);
 ucs_status_t ucp_worker_flush(ucp_worker_h worker);
 
 
+/**
+ * @ingroup UCP_WORKER
+ *
+ * @brief Non-blocking flush of outstanding AMO and RMA operations on the
+ * @ref ucp_worker_h "worker".
+ *
+ * This routine flushes all outstanding AMO and RMA communications on the
+ * @ref ucp_worker_h "worker". All the AMO and RMA operations issued on the
+ * @a worker prior to this call are completed both at the origin and at the
+ * target when the returned request completes. Unlike @ref ucp_worker_flush
+ * "ucp_worker_flush()", this routine returns immediately and the flush is
+ * progressed by @ref ucp_worker_progress "ucp_worker_progress()", so the
+ * flush latency can be overlapped with other work, and several flush epochs
+ * can be kept in flight.
+ *
+ * @param [in] worker    UCP worker.
+ * @param [in] cb        Callback which is invoked when the flush completes.
+ *
+ * @return NULL             - The flush was completed immediately.
+ * @return UCS_PTR_IS_ERR(_ptr) - The flush operation failed.
+ * @return otherwise        - Flush started, and a request handle is returned
+ *                          to the application in order to track its progress.
+ *                          The application is responsible to release the
+ *                          handle using @ref ucp_request_free
+ *                          "ucp_request_free()" routine.
+ */
+ucs_status_ptr_t ucp_worker_flush_nb(ucp_worker_h worker, ucp_send_callback_t cb);
+
+
 /**
  * @example ucp_hello_world.c
  * UCP hello world client / server example utility.
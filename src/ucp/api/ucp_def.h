@@ -19,6 +19,7 @@
  * @brief Forward declarations
  */
 typedef struct ucp_tag_recv_info         ucp_tag_recv_info_t;
+typedef struct ucp_tag_recv_item         ucp_tag_recv_item_t;
 
 
 /**
@@ -200,6 +201,33 @@ enum ucp_mem_attr_field {
  typedef struct ucp_worker                *ucp_worker_h;
 
 
+/**
+ * @ingroup UCP_WORKER
+ * @brief UCP Listener
+ *
+ * UCP listener is an opaque object which accepts connection requests on a
+ * bound socket address, as created by @ref ucp_listener_create, and creates
+ * a fully wired @ref ucp_ep_h "endpoint" for each of them.
+ */
+typedef struct ucp_listener              *ucp_listener_h;
+
+
+/**
+ * @ingroup UCP_WORKER
+ * @brief Callback to process an incoming connection request.
+ *
+ * This callback routine is invoked on the server side of a @ref
+ * ucp_listener_h "listener" whenever a connection request was accepted and
+ * the corresponding endpoint was created. The callback is invoked from the
+ * context of @ref ucp_worker_progress, so no locking is required to use the
+ * worker from it.
+ *
+ * @param [in]  ep      Endpoint connected to the requesting client.
+ * @param [in]  arg     User argument passed to @ref ucp_listener_create.
+ */
+typedef void (*ucp_listener_accept_callback_t)(ucp_ep_h ep, void *arg);
+
+
 /**
  * @ingroup UCP_COMM
  * @brief UCP Tag Identifier
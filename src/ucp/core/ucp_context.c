@@ -15,8 +15,13 @@
 #include <ucs/debug/log.h>
 #include <ucs/sys/compiler.h>
 #include <ucs/sys/string.h>
+#include <ucs/sys/sys.h>
 #include <ucs/arch/bitops.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 
 ucp_am_handler_t ucp_am_handlers[UCP_AM_ID_LAST] = {{0, NULL, NULL}};
@@ -28,6 +33,19 @@ static const char *ucp_atomic_modes[] = {
     [UCP_ATOMIC_MODE_LAST]   = NULL,
 };
 
+static const char *ucp_rndv_modes[] = {
+    [UCP_RNDV_MODE_AUTO]      = "auto",
+    [UCP_RNDV_MODE_GET_ZCOPY] = "get_zcopy",
+    [UCP_RNDV_MODE_PUT_ZCOPY] = "put_zcopy",
+    [UCP_RNDV_MODE_LAST]      = NULL,
+};
+
+static const char *ucp_eager_rail_orders[] = {
+    [UCP_EAGER_RAIL_ORDER_TAG]  = "tag",
+    [UCP_EAGER_RAIL_ORDER_NONE] = "none",
+    [UCP_EAGER_RAIL_ORDER_LAST] = NULL,
+};
+
 static const char * ucp_device_type_names[] = {
     [UCT_DEVICE_TYPE_NET]  = "network",
     [UCT_DEVICE_TYPE_SHM]  = "intra-node",
@@ -87,6 +105,19 @@ static ucs_config_field_t ucp_config_table[] = {
    "Threshold for switching from eager to rendezvous protocol",
    ucs_offsetof(ucp_config_t, ctx.rndv_thresh), UCS_CONFIG_TYPE_MEMUNITS},
 
+  {"WORKER_MEM_BUDGET", "inf",
+   "Per-worker memory budget for communication buffer pools. When the total\n"
+   "footprint of a worker's pools exceeds this value, unused pool chunks are\n"
+   "returned to the system from the progress slow path.",
+   ucs_offsetof(ucp_config_t, ctx.worker_mem_budget), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"EAGER_FC_WND", "inf",
+   "Per-endpoint window, in bytes, of eager tag data which may be sent without\n"
+   "credits from the receiver. Messages exceeding the remaining window are sent\n"
+   "with the rendezvous protocol, which is receiver-paced; credits are returned\n"
+   "as the receiver consumes the messages. 'inf' disables flow control.",
+   ucs_offsetof(ucp_config_t, ctx.eager_fc_wnd), UCS_CONFIG_TYPE_MEMUNITS},
+
   {"RNDV_THRESH_FALLBACK", "inf",
    "Message size to start using the rendezvous protocol in case the calculated threshold "
    "is zero or negative",
@@ -97,6 +128,29 @@ static ucs_config_field_t ucp_config_table[] = {
    "the eager_zcopy protocol",
    ucs_offsetof(ucp_config_t, ctx.rndv_perf_diff), UCS_CONFIG_TYPE_DOUBLE},
 
+  {"RNDV_PIPELINE_THRESH", "auto",
+   "Threshold for registering the rendezvous receive buffer chunk-by-chunk,\n"
+   "overlapping the registration of the next chunk with the transfer of the\n"
+   "current one. auto - several maximal-size GET fragments.",
+   ucs_offsetof(ucp_config_t, ctx.rndv_pipeline_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"RNDV_SCHEME", "auto",
+   "Rendezvous data transfer scheme.\n"
+   " get_zcopy - the receiver reads the data from the sender with get_zcopy.\n"
+   " put_zcopy - the receiver advertises its buffer and the sender writes the\n"
+   "             data with put_zcopy, skipping the receive-side copy.\n"
+   " auto      - select the scheme based on the capabilities of the rendezvous\n"
+   "             lane.",
+   ucs_offsetof(ucp_config_t, ctx.rndv_mode), UCS_CONFIG_TYPE_ENUM(ucp_rndv_modes)},
+
+  {"RNDV_ADAPT", "n",
+   "Adapt the eager/rendezvous thresholds per endpoint at runtime. The achieved\n"
+   "bandwidth of eager and rendezvous transfers near the crossover is tracked\n"
+   "for every endpoint, and the thresholds are periodically re-derived within a\n"
+   "bounded range around the configured values, so that intra-node, cross-fabric\n"
+   "and congested peers each converge to their own crossover point.",
+   ucs_offsetof(ucp_config_t, ctx.rndv_adapt), UCS_CONFIG_TYPE_BOOL},
+
   {"ZCOPY_THRESH", "auto",
    "Threshold for switching from buffer copy to zero copy protocol",
    ucs_offsetof(ucp_config_t, ctx.zcopy_thresh), UCS_CONFIG_TYPE_MEMUNITS},
@@ -125,6 +179,60 @@ static ucs_config_field_t ucp_config_table[] = {
    "y      - Use mutex for multithreading support in UCP.\n",
    ucs_offsetof(ucp_config_t, ctx.use_mt_mutex), UCS_CONFIG_TYPE_BOOL},
 
+  {"DEFERRED_COMPLETIONS", "n",
+   "Queue completion callbacks on the worker and deliver them in a batch at\n"
+   "the end of ucp_worker_progress(), instead of calling them from inside\n"
+   "transport progress. Keeps the progress loop tight when callbacks are heavy.",
+   ucs_offsetof(ucp_config_t, ctx.deferred_cb), UCS_CONFIG_TYPE_BOOL},
+
+  {"ATOMIC_COMBINE", "n",
+   "Combine atomic add operations to the same remote address, issued within\n"
+   "one worker progress window, into a single wire atomic of the summed\n"
+   "delta. Applies only to adds without a result; the pending sums are issued\n"
+   "at the next progress call, and always before a flush, a fence or any\n"
+   "fetching atomic, so flush ordering is preserved. Reduces responder-side\n"
+   "serialization when many ranks hammer the same hot counter.",
+   ucs_offsetof(ucp_config_t, ctx.amo_combine), UCS_CONFIG_TYPE_BOOL},
+
+  {"TAG_COALESCE", "n",
+   "Coalesce small eager tag sends to the same destination, issued within one\n"
+   "worker progress window, into a single multi-message transport frame. The\n"
+   "staged messages are sent at the next progress call, and always before any\n"
+   "other operation to the same endpoint, so message order is preserved.\n"
+   "Amortizes per-packet overhead when many small messages target one peer.\n"
+   "Disables hardware tag matching offload for the coalesced messages.",
+   ucs_offsetof(ucp_config_t, ctx.tag_coalesce), UCS_CONFIG_TYPE_BOOL},
+
+  {"TAG_COALESCE_SIZE", "8k",
+   "Capacity of the per-endpoint coalescing staging buffer. Effectively\n"
+   "capped by the maximal bcopy size of the active message transport.",
+   ucs_offsetof(ucp_config_t, ctx.tag_coalesce_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"EAGER_RAILS", "1",
+   "Maximal number of lanes for spraying single-fragment eager tag messages.\n"
+   "Additional active-message lanes are brought up next to the primary one,\n"
+   "and messages are distributed over them in proportion to lane bandwidth,\n"
+   "so the aggregate message rate approaches the sum of the rails.\n"
+   "1 - send all eager messages on the primary active-message lane.",
+   ucs_offsetof(ucp_config_t, ctx.max_eager_rails), UCS_CONFIG_TYPE_UINT},
+
+  {"EAGER_RAIL_ORDER", "tag",
+   "Ordering guarantee maintained when spraying eager messages over rails.\n"
+   " tag  - messages with the same tag stay on one rail and arrive in send order.\n"
+   " none - weighted round-robin over all rails; tag matching still works, but\n"
+   "        same-tag messages may arrive out of send order.",
+   ucs_offsetof(ucp_config_t, ctx.eager_rail_order),
+   UCS_CONFIG_TYPE_ENUM(ucp_eager_rail_orders)},
+
+  {"RESOURCE_CACHE", "",
+   "Path to a file caching the discovered transport resources. The first\n"
+   "process performs full device discovery and writes the cache; subsequent\n"
+   "processes map it read-only and skip the discovery queries. The file is\n"
+   "validated against the host name and format version, and should reside on\n"
+   "node-local storage (e.g. /dev/shm). Remove the file after changing the\n"
+   "hardware configuration. Empty - disable caching.",
+   ucs_offsetof(ucp_config_t, rsc_cache_path), UCS_CONFIG_TYPE_STRING},
+
   {NULL}
 };
 
@@ -219,7 +327,7 @@ static int ucp_config_is_tl_enabled(const ucp_config_t *config, const char *tl_n
            (ucp_str_array_search(names, config->tls.count, "all"  ) >= 0);
 }
 
-static int ucp_is_resource_in_device_list(uct_tl_resource_desc_t *resource,
+static int ucp_is_resource_in_device_list(const uct_tl_resource_desc_t *resource,
                                           const ucs_config_names_array_t *devices,
                                           uint64_t *masks, int index)
 {
@@ -250,7 +358,7 @@ static int ucp_is_resource_in_device_list(uct_tl_resource_desc_t *resource,
     return device_enabled;
 }
 
-static int ucp_is_resource_enabled(uct_tl_resource_desc_t *resource,
+static int ucp_is_resource_enabled(const uct_tl_resource_desc_t *resource,
                                    const ucp_config_t *config,
                                    uint64_t *masks)
 {
@@ -295,27 +403,19 @@ static int ucp_is_resource_enabled(uct_tl_resource_desc_t *resource,
 static ucs_status_t ucp_add_tl_resources(ucp_context_h context, ucp_tl_md_t *md,
                                          ucp_rsc_index_t md_index,
                                          const ucp_config_t *config,
+                                         const uct_tl_resource_desc_t *tl_resources,
+                                         unsigned num_tl_resources,
                                          unsigned *num_resources_p,
                                          uint64_t *masks)
 {
-    uct_tl_resource_desc_t *tl_resources;
     ucp_tl_resource_desc_t *tmp;
-    unsigned num_tl_resources;
-    ucs_status_t status;
     ucp_rsc_index_t i;
 
     *num_resources_p = 0;
 
-    /* check what are the available uct resources */
-    status = uct_md_query_tl_resources(md->md, &tl_resources, &num_tl_resources);
-    if (status != UCS_OK) {
-        ucs_error("Failed to query resources: %s", ucs_status_string(status));
-        goto err;
-    }
-
     if (num_tl_resources == 0) {
         ucs_debug("No tl resources found for md %s", md->rsc.md_name);
-        goto out_free_resources;
+        return UCS_OK;
     }
 
     tmp = ucs_realloc(context->tl_rscs,
@@ -323,8 +423,7 @@ static ucs_status_t ucp_add_tl_resources(ucp_context_h context, ucp_tl_md_t *md,
                       "ucp resources");
     if (tmp == NULL) {
         ucs_error("Failed to allocate resources");
-        status = UCS_ERR_NO_MEMORY;
-        goto err_free_resources;
+        return UCS_ERR_NO_MEMORY;
     }
 
     /* print configuration */
@@ -345,14 +444,7 @@ static ucs_status_t ucp_add_tl_resources(ucp_context_h context, ucp_tl_md_t *md,
         }
     }
 
-out_free_resources:
-    uct_release_tl_resource_list(tl_resources);
     return UCS_OK;
-
-err_free_resources:
-    uct_release_tl_resource_list(tl_resources);
-err:
-    return status;
 }
 
 static void ucp_report_unavailable_devices(const ucs_config_names_array_t *devices,
@@ -552,15 +644,225 @@ static ucs_status_t ucp_check_resources(ucp_context_h context,
     return ucp_check_tl_names(context);
 }
 
-static ucs_status_t ucp_fill_resources(ucp_context_h context,
-                                       const ucp_config_t *config)
+/*
+ * Transport resource discovery cache.
+ *
+ * Device discovery - listing the memory domains and querying the
+ * communication resources of each - costs milliseconds per process and
+ * returns identical results for every rank on a node. The raw, pre-filtering
+ * query results are serialized into a file which subsequent processes map
+ * read-only. Memory domains are still opened by every process; only the
+ * discovery queries are skipped. User-level filtering (UCX_TLS etc.) is
+ * applied per process, so the cache stays valid across configuration changes.
+ */
+
+#define UCP_RSC_CACHE_MAGIC    0x52584355u /* "UCXR" */
+#define UCP_RSC_CACHE_VERSION  1
+
+typedef struct {
+    uint32_t               magic;
+    uint32_t               version;
+    uint32_t               digest;  /* Host identity digest */
+    uint32_t               num_mds;
+    /* Followed by num_mds md records */
+} ucp_rsc_cache_hdr_t;
+
+typedef struct {
+    uct_md_resource_desc_t rsc;
+    uint32_t               num_tls;
+    /* Followed by num_tls tl resource descriptors */
+} ucp_rsc_cache_md_t;
+
+static uint32_t ucp_rsc_cache_digest(void)
 {
+    const char *host  = ucs_get_host_name();
+    uint32_t sizes[2] = { sizeof(uct_md_resource_desc_t),
+                          sizeof(uct_tl_resource_desc_t) };
+
+    return ucs_crc32(ucs_crc32(0, host, strlen(host)), sizes, sizeof(sizes));
+}
+
+static ucs_status_t ucp_rsc_cache_map(const char *path, void **buffer_p,
+                                      size_t *size_p)
+{
+    ucp_rsc_cache_hdr_t *hdr;
+    struct stat st;
+    void *buffer;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return UCS_ERR_NO_ELEM;
+    }
+
+    if (fstat(fd, &st) || ((size_t)st.st_size < sizeof(*hdr))) {
+        close(fd);
+        return UCS_ERR_NO_ELEM;
+    }
+
+    buffer = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (buffer == MAP_FAILED) {
+        return UCS_ERR_NO_ELEM;
+    }
+
+    hdr = buffer;
+    if ((hdr->magic   != UCP_RSC_CACHE_MAGIC) ||
+        (hdr->version != UCP_RSC_CACHE_VERSION) ||
+        (hdr->digest  != ucp_rsc_cache_digest()))
+    {
+        ucs_debug("resource cache %s is stale or from another host - ignoring",
+                  path);
+        munmap(buffer, st.st_size);
+        return UCS_ERR_NO_ELEM;
+    }
+
+    *buffer_p = buffer;
+    *size_p   = st.st_size;
+    return UCS_OK;
+}
+
+/* Locate the md_idx-th record in the mapped cache, validating that it lies
+ * entirely inside the mapping */
+static ucs_status_t
+ucp_rsc_cache_get(void *buffer, size_t size, unsigned md_idx,
+                  const uct_md_resource_desc_t **md_rsc_p,
+                  const uct_tl_resource_desc_t **tl_rscs_p,
+                  unsigned *num_tls_p)
+{
+    ucp_rsc_cache_hdr_t *hdr = buffer;
+    ucp_rsc_cache_md_t *md_rec;
+    size_t offset;
+    unsigned i;
+
+    if (md_idx >= hdr->num_mds) {
+        return UCS_ERR_NO_ELEM;
+    }
+
+    offset = sizeof(*hdr);
+    for (i = 0; ; ++i) {
+        if (offset + sizeof(*md_rec) > size) {
+            return UCS_ERR_NO_ELEM; /* truncated file */
+        }
+        md_rec  = buffer + offset;
+        offset += sizeof(*md_rec);
+        if (offset + (md_rec->num_tls * sizeof(uct_tl_resource_desc_t)) > size) {
+            return UCS_ERR_NO_ELEM;
+        }
+        if (i == md_idx) {
+            break;
+        }
+        offset += md_rec->num_tls * sizeof(uct_tl_resource_desc_t);
+    }
+
+    *md_rsc_p  = &md_rec->rsc;
+    *tl_rscs_p = (const uct_tl_resource_desc_t*)((char*)buffer + offset);
+    *num_tls_p = md_rec->num_tls;
+    return UCS_OK;
+}
+
+/* Return a heap copy of the cached md resource list, compatible with
+ * uct_release_md_resource_list() */
+static ucs_status_t ucp_rsc_cache_read_mds(void *buffer, size_t size,
+                                           uct_md_resource_desc_t **md_rscs_p,
+                                           unsigned *num_mds_p)
+{
+    ucp_rsc_cache_hdr_t *hdr = buffer;
+    const uct_tl_resource_desc_t *tl_rscs;
+    const uct_md_resource_desc_t *md_rsc;
+    uct_md_resource_desc_t *md_rscs;
+    unsigned i, num_tls;
+    ucs_status_t status;
+
+    md_rscs = ucs_calloc(hdr->num_mds, sizeof(*md_rscs), "ucp_rsc_cache_mds");
+    if (md_rscs == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    for (i = 0; i < hdr->num_mds; ++i) {
+        status = ucp_rsc_cache_get(buffer, size, i, &md_rsc, &tl_rscs, &num_tls);
+        if (status != UCS_OK) {
+            ucs_free(md_rscs);
+            return status;
+        }
+        md_rscs[i] = *md_rsc;
+    }
+
+    *md_rscs_p = md_rscs;
+    *num_mds_p = hdr->num_mds;
+    return UCS_OK;
+}
+
+static void ucp_rsc_cache_write(const char *path,
+                                const uct_md_resource_desc_t *md_rscs,
+                                unsigned num_mds,
+                                uct_tl_resource_desc_t **tl_lists,
+                                const unsigned *tl_counts)
+{
+    ucp_rsc_cache_hdr_t hdr;
+    ucp_rsc_cache_md_t md_rec;
+    char tmp_path[PATH_MAX];
+    unsigned i;
+    FILE *fp;
+
+    ucs_snprintf_zero(tmp_path, sizeof(tmp_path), "%s.%d", path, getpid());
+    fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        ucs_debug("failed to create resource cache %s: %m", tmp_path);
+        return;
+    }
+
+    hdr.magic   = UCP_RSC_CACHE_MAGIC;
+    hdr.version = UCP_RSC_CACHE_VERSION;
+    hdr.digest  = ucp_rsc_cache_digest();
+    hdr.num_mds = num_mds;
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {
+        goto err;
+    }
+
+    for (i = 0; i < num_mds; ++i) {
+        memset(&md_rec, 0, sizeof(md_rec));
+        md_rec.rsc     = md_rscs[i];
+        md_rec.num_tls = tl_counts[i];
+        if ((fwrite(&md_rec, sizeof(md_rec), 1, fp) != 1) ||
+            ((tl_counts[i] > 0) &&
+             (fwrite(tl_lists[i], sizeof(*tl_lists[i]), tl_counts[i], fp) !=
+              tl_counts[i])))
+        {
+            goto err;
+        }
+    }
+
+    fclose(fp);
+
+    /* Publish atomically - concurrent writers race benignly, last one wins */
+    if (rename(tmp_path, path)) {
+        ucs_debug("failed to publish resource cache %s: %m", path);
+        unlink(tmp_path);
+    }
+    return;
+
+err:
+    ucs_debug("failed to write resource cache %s: %m", tmp_path);
+    fclose(fp);
+    unlink(tmp_path);
+}
+
+static ucs_status_t ucp_do_fill_resources(ucp_context_h context,
+                                          const ucp_config_t *config,
+                                          void *cache_buf, size_t cache_size)
+{
+    const uct_md_resource_desc_t *cache_md_rsc;
+    const uct_tl_resource_desc_t *tl_rscs;
+    uct_tl_resource_desc_t **query_tls = NULL;
+    unsigned *query_tl_counts = NULL;
     unsigned num_tl_resources;
     unsigned num_md_resources;
     uct_md_resource_desc_t *md_rscs;
     ucs_status_t status;
     ucp_rsc_index_t i;
     unsigned md_index;
+    unsigned num_tls;
     uint64_t masks[UCT_DEVICE_TYPE_LAST] = {0};
 
     context->tl_mds      = NULL;
@@ -573,8 +875,13 @@ static ucs_status_t ucp_fill_resources(ucp_context_h context,
         goto err;
     }
 
-    /* List memory domain resources */
-    status = uct_query_md_resources(&md_rscs, &num_md_resources);
+    /* List memory domain resources, from the cache or by full discovery */
+    if (cache_buf != NULL) {
+        status = ucp_rsc_cache_read_mds(cache_buf, cache_size, &md_rscs,
+                                        &num_md_resources);
+    } else {
+        status = uct_query_md_resources(&md_rscs, &num_md_resources);
+    }
     if (status != UCS_OK) {
         goto err;
     }
@@ -594,6 +901,19 @@ static ucs_status_t ucp_fill_resources(ucp_context_h context,
         goto err_release_md_resources;
     }
 
+    /* When discovering, the raw query results are kept around so they can be
+     * written to the cache after all MDs were processed */
+    if (cache_buf == NULL) {
+        query_tls       = ucs_calloc(num_md_resources, sizeof(*query_tls),
+                                     "ucp_query_tls");
+        query_tl_counts = ucs_calloc(num_md_resources, sizeof(*query_tl_counts),
+                                     "ucp_query_tl_counts");
+        if ((query_tls == NULL) || (query_tl_counts == NULL)) {
+            status = UCS_ERR_NO_MEMORY;
+            goto err_free_context_resources;
+        }
+    }
+
     /* Open all memory domains */
     md_index = 0;
     for (i = 0; i < num_md_resources; ++i) {
@@ -602,9 +922,27 @@ static ucs_status_t ucp_fill_resources(ucp_context_h context,
             goto err_free_context_resources;
         }
 
+        /* Get communication resources of this MD */
+        if (cache_buf != NULL) {
+            status = ucp_rsc_cache_get(cache_buf, cache_size, i, &cache_md_rsc,
+                                       &tl_rscs, &num_tls);
+        } else {
+            status = uct_md_query_tl_resources(context->tl_mds[md_index].md,
+                                               &query_tls[i],
+                                               &query_tl_counts[i]);
+            tl_rscs = query_tls[i];
+            num_tls = query_tl_counts[i];
+        }
+        if (status != UCS_OK) {
+            ucs_error("Failed to query resources: %s", ucs_status_string(status));
+            uct_md_close(context->tl_mds[md_index].md);
+            goto err_free_context_resources;
+        }
+
         /* Add communication resources of each MD */
         status = ucp_add_tl_resources(context, &context->tl_mds[md_index],
-                                      md_index, config, &num_tl_resources, masks);
+                                      md_index, config, tl_rscs, num_tls,
+                                      &num_tl_resources, masks);
         if (status != UCS_OK) {
             uct_md_close(context->tl_mds[md_index].md);
             goto err_free_context_resources;
@@ -627,21 +965,62 @@ static ucs_status_t ucp_fill_resources(ucp_context_h context,
         goto err_free_context_resources;
     }
 
-    uct_release_md_resource_list(md_rscs);
+    if ((cache_buf == NULL) && (strlen(config->rsc_cache_path) > 0)) {
+        ucp_rsc_cache_write(config->rsc_cache_path, md_rscs, num_md_resources,
+                            query_tls, query_tl_counts);
+    }
 
     /* Notify the user if there are devices from the command line that are not available */
     ucp_report_unavailable_devices(config->devices, masks);
 
-    return UCS_OK;
+    status = UCS_OK;
+    goto out_release_md_resources;
 
 err_free_context_resources:
     ucp_free_resources(context);
 err_release_md_resources:
+out_release_md_resources:
+    if (query_tls != NULL) {
+        for (i = 0; i < num_md_resources; ++i) {
+            if (query_tls[i] != NULL) {
+                uct_release_tl_resource_list(query_tls[i]);
+            }
+        }
+    }
+    ucs_free(query_tl_counts);
+    ucs_free(query_tls);
     uct_release_md_resource_list(md_rscs);
 err:
     return status;
 }
 
+static ucs_status_t ucp_fill_resources(ucp_context_h context,
+                                       const ucp_config_t *config)
+{
+    void *cache_buf  = NULL;
+    size_t cache_size = 0;
+    ucs_status_t status;
+
+    if (strlen(config->rsc_cache_path) > 0) {
+        ucp_rsc_cache_map(config->rsc_cache_path, &cache_buf, &cache_size);
+    }
+
+    if (cache_buf != NULL) {
+        status = ucp_do_fill_resources(context, config, cache_buf, cache_size);
+        munmap(cache_buf, cache_size);
+        if (status == UCS_OK) {
+            return UCS_OK;
+        }
+
+        /* A stale cache (e.g. after a hardware change) must not fail
+         * initialization - fall back to full discovery */
+        ucs_debug("filling resources from cache failed (%s) - rediscovering",
+                  ucs_status_string(status));
+    }
+
+    return ucp_do_fill_resources(context, config, NULL, 0);
+}
+
 static void ucp_apply_params(ucp_context_h context, const ucp_params_t *params,
                              ucp_mt_type_t mt_type)
 {
@@ -814,7 +1193,7 @@ ucs_status_t ucp_init_version(unsigned api_major_version, unsigned api_minor_ver
     }
 
     /* initialize tag matching */
-    status = ucp_tag_match_init(&context->tm);
+    status = ucp_tag_match_init(&context->tm, context->config.tag_sender_mask);
     if (status != UCS_OK) {
         goto err_free_resources;
     }
@@ -25,12 +25,24 @@ typedef struct ucp_context_config {
     size_t                                 bcopy_thresh;
     /** Threshold for switching UCP to rendezvous protocol */
     size_t                                 rndv_thresh;
+    /** Per-worker memory budget for communication buffer pools */
+    size_t                                 worker_mem_budget;
+    /** Per-endpoint eager byte window for credit flow control */
+    size_t                                 eager_fc_wnd;
     /** Threshold for switching UCP to rendezvous protocol in case the calculated
      *  threshold is zero or negative */
     size_t                                 rndv_thresh_fallback;
     /** The percentage allowed for performance difference between rendezvous
      *  and the eager_zcopy protocol */
     double                                 rndv_perf_diff;
+    /** Transfer size above which the rendezvous receive buffer is registered
+     *  chunk-by-chunk, overlapping registration with the GET transfers */
+    size_t                                 rndv_pipeline_thresh;
+    /** Rendezvous data transfer scheme */
+    ucp_rndv_mode_t                        rndv_mode;
+    /** Adapt the eager/rendezvous thresholds per endpoint from measured
+     *  transfer performance */
+    int                                    rndv_adapt;
     /** Threshold for switching UCP to zero copy protocol */
     size_t                                 zcopy_thresh;
     /** Estimation of bcopy bandwidth */
@@ -41,6 +53,21 @@ typedef struct ucp_context_config {
     ucp_atomic_mode_t                      atomic_mode;
     /** If use mutex for MT support or not */
     int                                    use_mt_mutex;
+    /** Queue completion callbacks and deliver them in a batch at the end of
+     *  ucp_worker_progress(), instead of from inside transport progress */
+    int                                    deferred_cb;
+    /** Combine atomic adds to the same remote address within one worker
+     *  progress window into a single wire atomic of the summed delta */
+    int                                    amo_combine;
+    /** Coalesce small eager tag sends to the same endpoint within one worker
+     *  progress window into a single multi-message frame */
+    int                                    tag_coalesce;
+    /** Capacity of the per-endpoint coalescing staging buffer */
+    size_t                                 tag_coalesce_size;
+    /** Maximal number of lanes for spraying single-fragment eager messages */
+    unsigned                               max_eager_rails;
+    /** Ordering guarantee maintained when spraying eager messages */
+    ucp_eager_rail_order_t                 eager_rail_order;
 } ucp_context_config_t;
 
 
@@ -53,6 +80,8 @@ struct ucp_config {
     ucs_config_names_array_t               tls;
     /** Array of memory allocation methods */
     UCS_CONFIG_STRING_ARRAY_FIELD(methods) alloc_prio;
+    /** Path to the transport resource discovery cache, empty - disabled */
+    char                                   *rsc_cache_path;
     /** Configuration saved directly in the context */
     ucp_context_config_t                   ctx;
 };
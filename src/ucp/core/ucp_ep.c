@@ -14,7 +14,9 @@
 #include <ucp/tag/eager.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/debug/log.h>
+#include <ucs/sys/math.h>
 #include <ucs/sys/string.h>
+#include <ucs/time/time.h>
 #include <string.h>
 
 
@@ -25,12 +27,32 @@ static ucs_stats_class_t ucp_ep_stats_class = {
     .counter_names  = {
         [UCP_EP_STAT_TAG_TX_EAGER]      = "tx_eager",
         [UCP_EP_STAT_TAG_TX_EAGER_SYNC] = "tx_eager_sync",
-        [UCP_EP_STAT_TAG_TX_RNDV]       = "tx_rndv"
+        [UCP_EP_STAT_TAG_TX_RNDV]       = "tx_rndv",
+        [UCP_EP_STAT_ADAPT_THRESH_UP]   = "adapt_thresh_up",
+        [UCP_EP_STAT_ADAPT_THRESH_DOWN] = "adapt_thresh_down",
+        [UCP_EP_STAT_EAGER_RAIL + 0]    = "tx_eager_rail0",
+        [UCP_EP_STAT_EAGER_RAIL + 1]    = "tx_eager_rail1",
+        [UCP_EP_STAT_EAGER_RAIL + 2]    = "tx_eager_rail2",
+        [UCP_EP_STAT_EAGER_RAIL + 3]    = "tx_eager_rail3",
+        [UCP_EP_STAT_EAGER_RAIL + 4]    = "tx_eager_rail4",
+        [UCP_EP_STAT_EAGER_RAIL + 5]    = "tx_eager_rail5",
+        [UCP_EP_STAT_EAGER_RAIL + 6]    = "tx_eager_rail6",
+        [UCP_EP_STAT_EAGER_RAIL + 7]    = "tx_eager_rail7"
     }
 };
 #endif
 
 
+/* Samples between threshold re-derivations */
+#define UCP_EP_ADAPT_PERIOD         256
+
+/* Required relative bandwidth advantage before moving a threshold */
+#define UCP_EP_ADAPT_BW_DIFF        1.15
+
+/* Thresholds stay within [config >> shift, config << shift] */
+#define UCP_EP_ADAPT_BOUND_SHIFT    2
+
+
 void ucp_ep_config_key_reset(ucp_ep_config_key_t *key)
 {
     memset(key, 0, sizeof(*key));
@@ -41,6 +63,85 @@ void ucp_ep_config_key_reset(ucp_ep_config_key_t *key)
     key->reachable_md_map = 0;
     memset(key->rma_lanes, UCP_NULL_LANE, sizeof(key->rma_lanes));
     memset(key->amo_lanes, UCP_NULL_LANE, sizeof(key->amo_lanes));
+    memset(key->am_rails,  UCP_NULL_LANE, sizeof(key->am_rails));
+}
+
+void ucp_ep_adapt_reset(ucp_ep_h ep)
+{
+    ucp_ep_config_t *config = ucp_ep_config(ep);
+
+    ep->adapt.rma_thresh  = config->rndv.rma_thresh;
+    ep->adapt.am_thresh   = config->rndv.am_thresh;
+    ep->adapt.eager_bw    = 0.0;
+    ep->adapt.rndv_bw     = 0.0;
+    ep->adapt.num_samples = 0;
+}
+
+static size_t ucp_ep_adapt_scale(size_t thresh, size_t base, int up)
+{
+    if (base >= (SIZE_MAX >> UCP_EP_ADAPT_BOUND_SHIFT)) {
+        /* the protocol is effectively disabled - nothing to adapt */
+        return thresh;
+    }
+
+    if (up) {
+        return ucs_min(thresh + (thresh / 4), base << UCP_EP_ADAPT_BOUND_SHIFT);
+    } else {
+        return ucs_max(thresh - (thresh / 4), base >> UCP_EP_ADAPT_BOUND_SHIFT);
+    }
+}
+
+void ucp_ep_adapt_sample(ucp_request_t *req)
+{
+    ucp_ep_h ep             = req->send.ep;
+    ucp_ep_config_t *config = ucp_ep_config(ep);
+    ucs_time_t elapsed;
+    double bw, *est;
+
+    elapsed = ucs_get_time() - req->send.start_time;
+    if (elapsed == 0) {
+        return;
+    }
+
+    /* Exponential moving average of the achieved bandwidth per protocol */
+    bw  = req->send.length / ucs_time_to_sec(elapsed);
+    est = (req->flags & UCP_REQUEST_FLAG_RNDV) ? &ep->adapt.rndv_bw :
+                                                 &ep->adapt.eager_bw;
+    if (*est == 0.0) {
+        *est = bw;
+    } else {
+        *est += (bw - *est) / 16;
+    }
+
+    if (++ep->adapt.num_samples < UCP_EP_ADAPT_PERIOD) {
+        return;
+    }
+    ep->adapt.num_samples = 0;
+
+    if ((ep->adapt.eager_bw == 0.0) || (ep->adapt.rndv_bw == 0.0)) {
+        /* both protocols must be observed before they can be compared */
+        return;
+    }
+
+    if (ep->adapt.rndv_bw > (ep->adapt.eager_bw * UCP_EP_ADAPT_BW_DIFF)) {
+        /* rendezvous is winning near the crossover - switch to it earlier */
+        ep->adapt.rma_thresh = ucp_ep_adapt_scale(ep->adapt.rma_thresh,
+                                                  config->rndv.rma_thresh, 0);
+        ep->adapt.am_thresh  = ucp_ep_adapt_scale(ep->adapt.am_thresh,
+                                                  config->rndv.am_thresh, 0);
+        UCS_STATS_UPDATE_COUNTER(ep->stats, UCP_EP_STAT_ADAPT_THRESH_DOWN, 1);
+    } else if (ep->adapt.eager_bw > (ep->adapt.rndv_bw * UCP_EP_ADAPT_BW_DIFF)) {
+        ep->adapt.rma_thresh = ucp_ep_adapt_scale(ep->adapt.rma_thresh,
+                                                  config->rndv.rma_thresh, 1);
+        ep->adapt.am_thresh  = ucp_ep_adapt_scale(ep->adapt.am_thresh,
+                                                  config->rndv.am_thresh, 1);
+        UCS_STATS_UPDATE_COUNTER(ep->stats, UCP_EP_STAT_ADAPT_THRESH_UP, 1);
+    }
+
+    ucs_trace("ep %p: adapt rndv thresholds rma %zu am %zu "
+              "(eager %.2f MB/s rndv %.2f MB/s)", ep, ep->adapt.rma_thresh,
+              ep->adapt.am_thresh, ep->adapt.eager_bw / UCS_MBYTE,
+              ep->adapt.rndv_bw / UCS_MBYTE);
 }
 
 ucs_status_t ucp_ep_new(ucp_worker_h worker, uint64_t dest_uuid,
@@ -49,23 +150,30 @@ ucs_status_t ucp_ep_new(ucp_worker_h worker, uint64_t dest_uuid,
 {
     ucs_status_t status;
     ucp_ep_config_key_t key;
-    ucp_ep_h ep;
-    khiter_t hash_it;
-    int hash_extra_status = 0;
+    ucp_ep_h ep, *hash_val;
+    int is_new;
 
-    ep = ucs_calloc(1, sizeof(*ep), "ucp ep");
+    ep = ucs_mpool_get(&worker->ep_mp);
     if (ep == NULL) {
         ucs_error("Failed to allocate ep");
         status = UCS_ERR_NO_MEMORY;
         goto err;
     }
 
+    memset(ep, 0, sizeof(*ep));
+
     ucp_ep_config_key_reset(&key);
     ep->worker           = worker;
     ep->dest_uuid        = dest_uuid;
     ep->cfg_index        = ucp_worker_get_ep_config(worker, &key);
     ep->am_lane          = UCP_NULL_LANE;
     ep->flags            = 0;
+    ep->fc_wnd           = (worker->context->config.ext.eager_fc_wnd ==
+                            UCS_CONFIG_MEMUNITS_INF) ?
+                           0 : worker->context->config.ext.eager_fc_wnd;
+    ep->eager_rail       = 0;
+    ep->eager_credit     = 0;
+    ucp_ep_adapt_reset(ep);
 #if ENABLE_DEBUG_DATA
     ucs_snprintf_zero(ep->peer_name, UCP_WORKER_NAME_MAX, "%s", peer_name);
 #endif
@@ -77,16 +185,15 @@ ucs_status_t ucp_ep_new(ucp_worker_h worker, uint64_t dest_uuid,
         goto err_free_ep;
     }
 
-    hash_it = kh_put(ucp_worker_ep_hash, &worker->ep_hash, dest_uuid,
-                     &hash_extra_status);
-    if (ucs_unlikely(hash_it == kh_end(&worker->ep_hash))) {
-        ucs_error("Hash failed with ep %p to %s 0x%"PRIx64"->0x%"PRIx64" %s "
-                  "with status %d", ep, peer_name, worker->uuid, ep->dest_uuid,
-                  message, hash_extra_status);
+    hash_val = ucp_worker_ep_hash_put(&worker->ep_hash, dest_uuid, &is_new);
+    if (ucs_unlikely(hash_val == NULL)) {
+        ucs_error("Hash failed with ep %p to %s 0x%"PRIx64"->0x%"PRIx64" %s",
+                  ep, peer_name, worker->uuid, ep->dest_uuid, message);
         status = UCS_ERR_NO_RESOURCE;
         goto err_free_stats;
     }
-    kh_value(&worker->ep_hash, hash_it) = ep;
+    *hash_val = ep;
+    ucp_worker_ep_cache_invalidate(worker, dest_uuid);
 
     *ep_p = ep;
     ucs_debug("created ep %p to %s 0x%"PRIx64"->0x%"PRIx64" %s", ep, peer_name,
@@ -96,26 +203,23 @@ ucs_status_t ucp_ep_new(ucp_worker_h worker, uint64_t dest_uuid,
 err_free_stats:
     UCS_STATS_NODE_FREE(ep->stats);
 err_free_ep:
-    ucs_free(ep);
+    ucs_mpool_put(ep);
 err:
     return status;
 }
 
 static void ucp_ep_delete_from_hash(ucp_ep_h ep)
 {
-    khiter_t hash_it;
-
-    hash_it = kh_get(ucp_worker_ep_hash, &ep->worker->ep_hash, ep->dest_uuid);
-    if (hash_it != kh_end(&ep->worker->ep_hash)) {
-        kh_del(ucp_worker_ep_hash, &ep->worker->ep_hash, hash_it);
-    }
+    ucp_worker_ep_hash_del(&ep->worker->ep_hash, ep->dest_uuid);
+    ucp_worker_ep_cache_invalidate(ep->worker, ep->dest_uuid);
 }
 
 static void ucp_ep_delete(ucp_ep_h ep)
 {
     ucp_ep_delete_from_hash(ep);
     UCS_STATS_NODE_FREE(ep->stats);
-    ucs_free(ep);
+    ucs_free(ep->remote_address);
+    ucs_mpool_put(ep);
 }
 
 ucs_status_t ucp_ep_create_stub(ucp_worker_h worker, uint64_t dest_uuid,
@@ -142,6 +246,7 @@ ucs_status_t ucp_ep_create_stub(ucp_worker_h worker, uint64_t dest_uuid,
 
     ep->cfg_index        = ucp_worker_get_ep_config(worker, &key);
     ep->am_lane          = 0;
+    ucp_ep_adapt_reset(ep);
 
     status = ucp_stub_ep_create(ep, &ep->uct_eps[0]);
     if (status != UCS_OK) {
@@ -158,14 +263,35 @@ err:
     return status;
 }
 
+ucs_status_t ucp_ep_set_remote_address(ucp_ep_h ep, const void *address)
+{
+    size_t length;
+    void *copy;
+
+    if (ep->remote_address != NULL) {
+        return UCS_OK; /* Already retained */
+    }
+
+    length = ucp_address_buffer_size(address);
+    copy   = ucs_malloc(length, "ep_remote_address");
+    if (copy == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    memcpy(copy, address, length);
+    ep->remote_address        = copy;
+    ep->remote_address_length = length;
+    return UCS_OK;
+}
+
 int ucp_ep_is_stub(ucp_ep_h ep)
 {
     return ucp_ep_get_rsc_index(ep, 0) == UCP_NULL_RESOURCE;
 }
 
-ucs_status_t ucp_ep_create(ucp_worker_h worker,
-                           const ucp_ep_params_t *params,
-                           ucp_ep_h *ep_p)
+static ucs_status_t ucp_ep_create_one(ucp_worker_h worker,
+                                      const ucp_ep_params_t *params,
+                                      ucp_ep_h *ep_p)
 {
     char peer_name[UCP_WORKER_NAME_MAX];
     uint8_t addr_indices[UCP_MAX_LANES];
@@ -175,12 +301,9 @@ ucs_status_t ucp_ep_create(ucp_worker_h worker,
     uint64_t dest_uuid;
     ucp_ep_h ep;
 
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-
-    UCS_ASYNC_BLOCK(&worker->async);
-
     if (params->field_mask & UCP_EP_PARAM_FIELD_REMOTE_ADDRESS) {
-        status = ucp_address_unpack(params->address, &dest_uuid, peer_name, sizeof(peer_name),
+        status = ucp_address_unpack(worker, params->address, &dest_uuid,
+                                    peer_name, sizeof(peer_name),
                                     &address_count, &address_list);
         if (status != UCS_OK) {
             ucs_error("failed to unpack remote address: %s", ucs_status_string(status));
@@ -206,6 +329,10 @@ ucs_status_t ucp_ep_create(ucp_worker_h worker,
         goto out_free_address;
     }
 
+    /* Retain the peer address for lane failover and address inheritance.
+     * Failing to retain it only loses those abilities */
+    ucp_ep_set_remote_address(ep, params->address);
+
     /* initialize transport endpoints */
     status = ucp_wireup_init_lanes(ep, address_count, address_list, addr_indices);
     if (status != UCS_OK) {
@@ -221,6 +348,7 @@ ucs_status_t ucp_ep_create(ucp_worker_h worker,
     } else {
         ucp_ep_config(ep)->err_mode = UCP_ERR_HANDLING_MODE_NONE;
     }
+    ucp_ep_adapt_reset(ep);
 
     /* send initial wireup message */
     if (!(ep->flags & UCP_EP_FLAG_LOCAL_CONNECTED)) {
@@ -236,13 +364,56 @@ ucs_status_t ucp_ep_create(ucp_worker_h worker,
 err_destroy_ep:
     ucp_ep_destroy(ep);
 out_free_address:
-    ucs_free(address_list);
+    /* Releases the address list and all wireup transients at once */
+    ucs_arena_reset(&worker->ctl_arena);
 out:
+    return status;
+}
+
+ucs_status_t ucp_ep_create(ucp_worker_h worker,
+                           const ucp_ep_params_t *params,
+                           ucp_ep_h *ep_p)
+{
+    ucs_status_t status;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+    UCS_ASYNC_BLOCK(&worker->async);
+
+    status = ucp_ep_create_one(worker, params, ep_p);
+
     UCS_ASYNC_UNBLOCK(&worker->async);
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     return status;
 }
 
+ucs_status_t ucp_ep_create_multi(ucp_worker_h worker, unsigned num_eps,
+                                 const ucp_ep_params_t *params, ucp_ep_h *eps)
+{
+    ucs_status_t status = UCS_OK;
+    unsigned i;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    /* Create all endpoints under a single lock, so the whole batch reuses the
+     * same warm control arena for address unpacking, and repeated peer classes
+     * hit the worker's lane selection cache. Wireup requests are non-blocking,
+     * so they are issued back-to-back; the async context is unblocked between
+     * endpoints to avoid starving timers on very large batches. */
+    for (i = 0; i < num_eps; ++i) {
+        UCS_ASYNC_BLOCK(&worker->async);
+        status = ucp_ep_create_one(worker, &params[i], &eps[i]);
+        UCS_ASYNC_UNBLOCK(&worker->async);
+        if (status != UCS_OK) {
+            ucs_error("failed to create endpoint [%u/%u]: %s", i, num_eps,
+                      ucs_status_string(status));
+            break;
+        }
+    }
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
+}
+
 static void ucp_ep_flush_error(ucp_request_t *req, ucs_status_t status)
 {
     ucs_error("error during flush: %s", ucs_status_string(status));
@@ -288,7 +459,7 @@ static void ucp_ep_flush_progress(ucp_request_t *req)
                 break;
             }
 
-            status = uct_ep_pending_add(uct_ep, &req->send.uct);
+            status = uct_ep_pending_add(uct_ep, &req->send.uct, 0);
             ucs_trace("adding pending flush on ep %p lane[%d]: %s", ep, lane,
                       ucs_status_string(status));
             if (status == UCS_OK) {
@@ -416,6 +587,61 @@ static void ucp_ep_flush_completion(uct_completion_t *self, ucs_status_t status)
     ucp_flush_check_completion(req);
 }
 
+ucs_status_ptr_t ucp_ep_flush_nb(ucp_ep_h ep, ucp_send_callback_t cb)
+{
+    ucp_worker_h worker = ep->worker;
+    ucp_request_t *req;
+    void *ret;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    /* The flush must cover the pending combined atomic adds and the
+     * coalesced eager frame staged for this endpoint */
+    if (ucs_unlikely(worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(worker, 1);
+    }
+    if (ucs_unlikely(worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_flush_ep(worker, ep, 1);
+    }
+
+    req = ucs_mpool_get(&worker->req_mp);
+    if (req == NULL) {
+        ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+        goto out;
+    }
+
+    req->flags                  = 0;
+    req->status                 = UCS_OK;
+    req->send.ep                = ep;
+    req->send.flush.flushed_cb  = (ucp_request_callback_t)ucs_empty_function;
+    req->send.flush.lanes       = UCS_MASK(ucp_ep_num_lanes(ep));
+    req->send.flush.cbq_elem.cb = ucp_ep_flushed_slow_path_callback;
+    req->send.flush.cbq_elem_on = 0;
+    req->send.lane              = UCP_NULL_LANE;
+    req->send.uct.func          = ucp_ep_flush_progress_pending;
+    req->send.uct_comp.func     = ucp_ep_flush_completion;
+    req->send.uct_comp.count    = ucp_ep_num_lanes(ep);
+
+    ucp_ep_flush_progress(req);
+
+    if (req->send.uct_comp.count == 0) {
+        ret = UCS_STATUS_PTR(req->status);
+        ucs_trace_req("ep %p: releasing flush request %p, returning status %s",
+                      ep, req, ucs_status_string(req->status));
+        ucs_mpool_put(req);
+        goto out;
+    }
+
+    ucp_request_set_callback(req, send.cb, cb);
+    ucs_trace_req("ep %p: return inprogress flush request %p (%p)", ep, req,
+                  req + 1);
+    ret = req + 1;
+
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return ret;
+}
+
 static void ucp_destroyed_ep_pending_purge(uct_pending_req_t *self, void *arg)
 {
     ucs_bug("pending request %p on ep %p should have been flushed", self, arg);
@@ -436,11 +662,14 @@ void ucp_ep_destroy_internal(ucp_ep_h ep, const char *message)
 
         uct_ep_pending_purge(uct_ep, ucp_destroyed_ep_pending_purge, ep);
         ucs_debug("destroy ep %p lane[%d]=%p", ep, lane, uct_ep);
-        uct_ep_destroy(uct_ep);
+        if (!ucp_worker_iface_ep_put(ep->worker, uct_ep)) {
+            uct_ep_destroy(uct_ep);
+        }
     }
 
     UCS_STATS_NODE_FREE(ep->stats);
-    ucs_free(ep);
+    ucs_free(ep->remote_address);
+    ucs_mpool_put(ep);
 }
 
 static void ucp_ep_disconnected(ucp_request_t *req)
@@ -518,6 +747,15 @@ ucs_status_ptr_t ucp_disconnect_nb(ucp_ep_h ep)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
+    /* The disconnect flush must cover the pending combined atomic adds and
+     * the coalesced eager frame staged for this endpoint */
+    if (ucs_unlikely(worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(worker, 1);
+    }
+    if (ucs_unlikely(worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_flush_ep(worker, ep, 1);
+    }
+
     UCS_ASYNC_BLOCK(&worker->async);
     request = ucp_disconnect_nb_internal(ep);
     UCS_ASYNC_UNBLOCK(&worker->async);
@@ -564,6 +802,7 @@ int ucp_ep_config_is_equal(const ucp_ep_config_key_t *key1,
     if ((key1->num_lanes        != key2->num_lanes) ||
         memcmp(key1->rma_lanes, key2->rma_lanes, sizeof(key1->rma_lanes)) ||
         memcmp(key1->amo_lanes, key2->amo_lanes, sizeof(key1->amo_lanes)) ||
+        memcmp(key1->am_rails,  key2->am_rails,  sizeof(key1->am_rails))  ||
         (key1->reachable_md_map != key2->reachable_md_map) ||
         (key1->am_lane          != key2->am_lane) ||
         (key1->rndv_lane        != key2->rndv_lane) ||
@@ -656,6 +895,114 @@ static void ucp_ep_config_set_am_rndv_thresh(ucp_context_h context, uct_iface_at
     config->rndv.am_thresh = rndv_thresh;
 }
 
+/* Collect the lanes which can stripe a single rendezvous get_zcopy transfer.
+ * Only lanes which share the memory domain (and therefore the memh and the
+ * remote key) with the primary rndv lane can participate. */
+static void ucp_ep_config_init_rndv_lanes(ucp_worker_h worker,
+                                          ucp_ep_config_t *config)
+{
+    ucp_context_h context      = worker->context;
+    ucp_lane_index_t rndv_lane = config->key.rndv_lane;
+    uct_iface_attr_t *iface_attr;
+    ucp_rsc_index_t rsc_index;
+    ucp_lane_index_t lane;
+
+    config->rndv.lanes[0]  = rndv_lane;
+    config->rndv.num_lanes = 1;
+
+    for (lane = 0; lane < config->key.num_lanes; ++lane) {
+        rsc_index = config->key.lanes[lane].rsc_index;
+        if ((lane == rndv_lane) || (rsc_index == UCP_NULL_RESOURCE)) {
+            continue;
+        }
+
+        iface_attr = &worker->iface_attrs[rsc_index];
+        if (!(iface_attr->cap.flags & UCT_IFACE_FLAG_GET_ZCOPY)) {
+            continue;
+        }
+
+        if ((context->tl_rscs[rsc_index].md_index !=
+             context->tl_rscs[config->key.lanes[rndv_lane].rsc_index].md_index) ||
+            (config->key.lanes[lane].dst_md_index !=
+             config->key.lanes[rndv_lane].dst_md_index)) {
+            continue;
+        }
+
+        config->rndv.lanes[config->rndv.num_lanes++] = lane;
+        config->rndv.max_get_zcopy = ucs_min(config->rndv.max_get_zcopy,
+                                             iface_attr->cap.get.max_zcopy);
+    }
+
+    if (config->rndv.num_lanes > 1) {
+        ucs_debug("rendezvous transfers will be striped over %d lanes",
+                  config->rndv.num_lanes);
+    }
+}
+
+/* Total bytes in one spray round over all rails; each rail's quantum is its
+ * bandwidth share of this value */
+#define UCP_EP_EAGER_RAIL_ROUND  65536
+
+/* Collect the lanes which can spray single-fragment eager messages. Only
+ * lanes which wireup selected with the active-message criteria participate,
+ * and only if any message which fits in a single fragment on the am lane
+ * fits on them as well - the protocol thresholds are derived from the am
+ * lane alone. */
+static void ucp_ep_config_init_eager_lanes(ucp_worker_h worker,
+                                           ucp_ep_config_t *config)
+{
+    ucp_lane_index_t am_lane = config->key.am_lane;
+    double bw[UCP_MAX_LANES], bw_total;
+    uct_iface_attr_t *iface_attr;
+    ucp_rsc_index_t rsc_index;
+    ucp_lane_index_t lane, rail;
+
+    config->eager.lanes[0]  = am_lane;
+    config->eager.num_lanes = 1;
+
+    for (lane = 0; lane < config->key.num_lanes; ++lane) {
+        rsc_index = config->key.lanes[lane].rsc_index;
+        if ((lane == am_lane) || (rsc_index == UCP_NULL_RESOURCE) ||
+            (config->key.am_rails[lane] == UCP_NULL_LANE))
+        {
+            continue;
+        }
+
+        iface_attr = &worker->iface_attrs[rsc_index];
+        if (iface_attr->cap.am.max_bcopy < config->am.max_bcopy) {
+            continue;
+        }
+
+        config->eager.lanes[config->eager.num_lanes++] = lane;
+    }
+
+    /* bandwidth-proportional quanta and per-rail short limits */
+    bw_total = 0.0;
+    for (rail = 0; rail < config->eager.num_lanes; ++rail) {
+        lane       = config->eager.lanes[rail];
+        iface_attr = &worker->iface_attrs[config->key.lanes[lane].rsc_index];
+        bw[rail]   = iface_attr->bandwidth;
+        bw_total  += bw[rail];
+
+        if (iface_attr->cap.flags & UCT_IFACE_FLAG_AM_SHORT) {
+            config->eager.max_short[rail] = iface_attr->cap.am.max_short -
+                                            sizeof(ucp_eager_hdr_t);
+        } else {
+            config->eager.max_short[rail] = -1;
+        }
+    }
+
+    for (rail = 0; rail < config->eager.num_lanes; ++rail) {
+        config->eager.quantum[rail] =
+            ucs_max((size_t)(UCP_EP_EAGER_RAIL_ROUND * (bw[rail] / bw_total)), 1);
+    }
+
+    if (config->eager.num_lanes > 1) {
+        ucs_debug("eager messages will be sprayed over %d lanes",
+                  config->eager.num_lanes);
+    }
+}
+
 void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
 {
     ucp_context_h context = worker->context;
@@ -675,7 +1022,10 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
     config->bcopy_thresh          = context->config.ext.bcopy_thresh;
     config->rndv.rma_thresh       = SIZE_MAX;
     config->rndv.max_get_zcopy    = SIZE_MAX;
+    config->rndv.max_put_zcopy    = SIZE_MAX;
     config->rndv.am_thresh        = SIZE_MAX;
+    config->rndv.num_lanes        = 0;
+    config->eager.num_lanes       = 0;
     config->p2p_lanes             = 0;
 
     /* Collect p2p lanes */
@@ -736,6 +1086,9 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
 
             /* calculate an rndv threshold for AM Rendezvous */
             ucp_ep_config_set_am_rndv_thresh(context, iface_attr, md_attr, config);
+
+            /* collect additional rails for spraying eager messages */
+            ucp_ep_config_init_eager_lanes(worker, config);
         } else {
             config->am.max_bcopy = UCP_MIN_BCOPY; /* Stub endpoint */
         }
@@ -798,7 +1151,8 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
         if (rsc_index != UCP_NULL_RESOURCE) {
             iface_attr = &worker->iface_attrs[rsc_index];
             md_attr    = &context->tl_mds[context->tl_rscs[rsc_index].md_index].attr;
-            ucs_assert_always(iface_attr->cap.flags & UCT_IFACE_FLAG_GET_ZCOPY);
+            ucs_assert_always(iface_attr->cap.flags & (UCT_IFACE_FLAG_GET_ZCOPY |
+                                                       UCT_IFACE_FLAG_PUT_ZCOPY));
 
             if (context->config.ext.rndv_thresh == UCS_CONFIG_MEMUNITS_AUTO) {
                 /* auto - Make UCX calculate the RMA (get_zcopy) rndv threshold on its own.*/
@@ -812,13 +1166,27 @@ void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config)
                 rndv_thresh = context->config.ext.rndv_thresh;
             }
 
-            /* use rendezvous only starting from minimal zero-copy get size */
-            ucs_assert(iface_attr->cap.get.min_zcopy <= iface_attr->cap.get.max_zcopy);
-            rndv_thresh                = ucs_max(rndv_thresh,
-                                                 iface_attr->cap.get.min_zcopy);
+            if (iface_attr->cap.flags & UCT_IFACE_FLAG_GET_ZCOPY) {
+                /* use rendezvous only starting from minimal zero-copy get size */
+                ucs_assert(iface_attr->cap.get.min_zcopy <= iface_attr->cap.get.max_zcopy);
+                rndv_thresh                = ucs_max(rndv_thresh,
+                                                     iface_attr->cap.get.min_zcopy);
+                config->rndv.max_get_zcopy = iface_attr->cap.get.max_zcopy;
+            } else {
+                /* the sender pushes the data with put_zcopy, so the minimal
+                 * zero-copy put size limits the rendezvous threshold instead */
+                ucs_assert(iface_attr->cap.put.min_zcopy <= iface_attr->cap.put.max_zcopy);
+                rndv_thresh                = ucs_max(rndv_thresh,
+                                                     iface_attr->cap.put.min_zcopy);
+            }
+
+            if (iface_attr->cap.flags & UCT_IFACE_FLAG_PUT_ZCOPY) {
+                config->rndv.max_put_zcopy = iface_attr->cap.put.max_zcopy;
+            }
 
-            config->rndv.max_get_zcopy = iface_attr->cap.get.max_zcopy;
             config->rndv.rma_thresh    = rndv_thresh;
+
+            ucp_ep_config_init_rndv_lanes(worker, config);
         } else {
             ucs_debug("rendezvous (get_zcopy) protocol is not supported ");
         }
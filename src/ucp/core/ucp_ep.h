@@ -39,7 +39,11 @@ enum {
     UCP_EP_STAT_TAG_TX_EAGER,
     UCP_EP_STAT_TAG_TX_EAGER_SYNC,
     UCP_EP_STAT_TAG_TX_RNDV,
-    UCP_EP_STAT_LAST
+    UCP_EP_STAT_ADAPT_THRESH_UP,
+    UCP_EP_STAT_ADAPT_THRESH_DOWN,
+    /* Eager messages sprayed to each rail; rail 0 is the am lane */
+    UCP_EP_STAT_EAGER_RAIL,
+    UCP_EP_STAT_LAST = UCP_EP_STAT_EAGER_RAIL + UCP_MAX_LANES
 };
 
 
@@ -71,6 +75,10 @@ typedef struct ucp_ep_config_key {
     /* Lanes for atomic operations, sorted by priority, highest first */
     ucp_lane_index_t       amo_lanes[UCP_MAX_LANES];
 
+    /* Lanes usable for spraying eager messages (selected with the same
+     * criteria as the am lane, which is always one of them) */
+    ucp_lane_index_t       am_rails[UCP_MAX_LANES];
+
     /* Bitmap of remote mds which are reachable from this endpoint (with any set
      * of transports which could be selected in the future).
      */
@@ -127,17 +135,53 @@ typedef struct ucp_ep_config {
     struct {
         /* Maximal total size of rndv_get_zcopy */
         size_t                 max_get_zcopy;
+        /* Maximal total size of rndv_put_zcopy */
+        size_t                 max_put_zcopy;
         /* Threshold for switching from eager to RMA based rendezvous */
         size_t                 rma_thresh;
         /* Threshold for switching from eager to AM based rendezvous */
         size_t                 am_thresh;
+        /* Lanes for striping a single rendezvous transfer. The primary rndv
+         * lane is lanes[0]; the others reach the same remote memory domain,
+         * so the rkey from the RTS is valid on all of them. */
+        ucp_lane_index_t       lanes[UCP_MAX_LANES];
+        ucp_lane_index_t       num_lanes;
     } rndv;
 
+    struct {
+        /* Lanes for spraying single-fragment eager messages. Rail 0 is the
+         * am lane; the others are extra active-message lanes brought up by
+         * wireup when UCX_EAGER_RAILS > 1. */
+        ucp_lane_index_t       lanes[UCP_MAX_LANES];
+        ucp_lane_index_t       num_lanes;
+        /* Round-robin byte quantum per rail, proportional to the rail's
+         * share of the total rail bandwidth */
+        size_t                 quantum[UCP_MAX_LANES];
+        /* Maximal am_short payload per rail, -1 if short is unsupported */
+        ssize_t                max_short[UCP_MAX_LANES];
+    } eager;
+
     /* Error handling mode */
     ucp_err_handling_mode_t    err_mode;
 } ucp_ep_config_t;
 
 
+/*
+ * Online protocol threshold adaptation state (UCX_RNDV_ADAPT). The shared
+ * ucp_ep_config_t thresholds are derived once from static interface
+ * attributes; the right crossover differs per peer and drifts with
+ * congestion, so each endpoint keeps its own copy which is periodically
+ * re-derived from measured transfer bandwidth.
+ */
+typedef struct ucp_ep_adapt {
+    size_t                 rma_thresh;   /* Per-ep eager/rndv-RMA crossover */
+    size_t                 am_thresh;    /* Per-ep eager/rndv-AM crossover */
+    double                 eager_bw;     /* Achieved eager bandwidth (EWMA) */
+    double                 rndv_bw;      /* Achieved rendezvous bandwidth (EWMA) */
+    unsigned               num_samples;  /* Samples since last re-derivation */
+} ucp_ep_adapt_t;
+
+
 /**
  * Remote protocol layer endpoint
  */
@@ -148,8 +192,25 @@ typedef struct ucp_ep {
     ucp_lane_index_t              am_lane;       /* Cached value */
     uint8_t                       flags;         /* Endpoint flags */
 
+    ucp_lane_index_t              eager_rail;    /* Current eager spray rail */
+    ssize_t                       eager_credit;  /* Remaining byte quantum on
+                                                    the current rail */
+
     uint64_t                      dest_uuid;     /* Destination worker uuid */
 
+    ssize_t                       fc_wnd;        /* Remaining eager byte window
+                                                    when credit flow control is
+                                                    enabled */
+
+    void                          *remote_address; /* Retained copy of the peer's
+                                                      packed address, for lane
+                                                      failover and address
+                                                      inheritance. NULL if not
+                                                      available */
+    size_t                        remote_address_length; /* Length of remote_address */
+
+    ucp_ep_adapt_t                adapt;         /* Adaptive protocol thresholds */
+
     UCS_STATS_NODE_DECLARE(stats);
 
 #if ENABLE_DEBUG_DATA
@@ -182,6 +243,8 @@ void ucp_ep_destroy_internal(ucp_ep_h ep, const char *message);
 
 int ucp_ep_is_stub(ucp_ep_h ep);
 
+ucs_status_t ucp_ep_set_remote_address(ucp_ep_h ep, const void *address);
+
 void ucp_ep_config_init(ucp_worker_h worker, ucp_ep_config_t *config);
 
 int ucp_ep_config_is_equal(const ucp_ep_config_key_t *key1,
@@ -190,6 +253,10 @@ int ucp_ep_config_is_equal(const ucp_ep_config_key_t *key1,
 int ucp_ep_config_get_rma_prio(const ucp_lane_index_t *lanes,
                                ucp_lane_index_t lane);
 
+void ucp_ep_adapt_reset(ucp_ep_h ep);
+
+void ucp_ep_adapt_sample(ucp_request_t *req);
+
 size_t ucp_ep_config_get_zcopy_auto_thresh(size_t iovcnt,
                                            const uct_linear_growth_t *reg_cost,
                                            const ucp_context_h context,
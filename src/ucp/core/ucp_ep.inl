@@ -11,8 +11,11 @@
 #include "ucp_ep.h"
 #include "ucp_worker.h"
 #include "ucp_context.h"
+#include "ucp_request.h"
 
 #include <ucs/arch/bitops.h>
+#include <ucs/sys/math.h>
+#include <ucs/time/time.h>
 
 
 static inline ucp_ep_config_t *ucp_ep_config(ucp_ep_h ep)
@@ -26,6 +29,52 @@ static inline ucp_lane_index_t ucp_ep_get_am_lane(ucp_ep_h ep)
     return ep->am_lane;
 }
 
+/*
+ * Pick the lane for a single-fragment eager message. With a single rail this
+ * is just the am lane. With UCX_EAGER_RAILS > 1, either same-tag messages are
+ * hashed to one rail (preserving their arrival order), or messages are
+ * sprayed round-robin with a per-rail byte quantum proportional to the rail
+ * bandwidth. A short which exceeds the chosen rail's am_short limit falls
+ * back to rail 0 - the am lane, from which the protocol thresholds were
+ * derived, so it always fits there.
+ */
+static UCS_F_ALWAYS_INLINE ucp_lane_index_t
+ucp_ep_get_eager_lane(ucp_ep_h ep, ucp_tag_t tag, size_t length, int is_short)
+{
+    ucp_ep_config_t *config = ucp_ep_config(ep);
+    ucp_lane_index_t rail;
+
+    if (ucs_likely(config->eager.num_lanes <= 1)) {
+        return ucp_ep_get_am_lane(ep);
+    }
+
+    if (ep->worker->context->config.ext.eager_rail_order ==
+        UCP_EAGER_RAIL_ORDER_TAG)
+    {
+        /* fold the tag so rails are used even when only one field varies */
+        rail = (ucp_lane_index_t)((tag ^ (tag >> 21) ^ (tag >> 43)) %
+                                  config->eager.num_lanes);
+    } else {
+        rail = ep->eager_rail;
+        if (ucs_unlikely(rail >= config->eager.num_lanes)) {
+            rail = 0; /* the endpoint was reconfigured with fewer rails */
+        }
+        /* +1 so that zero-length messages advance the round-robin as well */
+        ep->eager_credit -= (ssize_t)length + 1;
+        if (ep->eager_credit <= 0) {
+            ep->eager_rail   = (rail + 1) % config->eager.num_lanes;
+            ep->eager_credit = config->eager.quantum[ep->eager_rail];
+        }
+    }
+
+    if (is_short && ((ssize_t)length > config->eager.max_short[rail])) {
+        rail = 0;
+    }
+
+    UCS_STATS_UPDATE_COUNTER(ep->stats, UCP_EP_STAT_EAGER_RAIL + rail, 1);
+    return config->eager.lanes[rail];
+}
+
 static inline ucp_lane_index_t ucp_ep_get_wireup_msg_lane(ucp_ep_h ep)
 {
     ucp_lane_index_t lane = ucp_ep_config(ep)->key.wireup_lane;
@@ -106,4 +155,42 @@ static inline const char* ucp_ep_peer_name(ucp_ep_h ep)
 #endif
 }
 
+static inline size_t ucp_ep_rndv_rma_thresh(ucp_ep_h ep)
+{
+    return ep->worker->context->config.ext.rndv_adapt ?
+           ep->adapt.rma_thresh : ucp_ep_config(ep)->rndv.rma_thresh;
+}
+
+static inline size_t ucp_ep_rndv_am_thresh(ucp_ep_h ep)
+{
+    return ep->worker->context->config.ext.rndv_adapt ?
+           ep->adapt.am_thresh : ucp_ep_config(ep)->rndv.am_thresh;
+}
+
+/*
+ * Timestamp a send request whose size is close to the eager/rendezvous
+ * crossover, so that its completion contributes a bandwidth sample to the
+ * adaptive threshold machinery. Transfers far from the crossover carry no
+ * information about where it should be.
+ */
+static inline void ucp_ep_adapt_req_start(ucp_request_t *req)
+{
+    ucp_ep_h ep = req->send.ep;
+    size_t thresh;
+
+    if (ucs_likely(!ep->worker->context->config.ext.rndv_adapt)) {
+        return;
+    }
+
+    thresh = ucs_min(ep->adapt.rma_thresh, ep->adapt.am_thresh);
+    if ((thresh >= (SIZE_MAX / 4)) ||
+        (req->send.length < (thresh / 4)) ||
+        (req->send.length > (thresh * 4))) {
+        return;
+    }
+
+    req->flags          |= UCP_REQUEST_FLAG_ADAPT;
+    req->send.start_time = ucs_get_time();
+}
+
 #endif
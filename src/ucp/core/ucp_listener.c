@@ -0,0 +1,316 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "ucp_listener.h"
+#include "ucp_worker.h"
+
+#include <ucs/debug/log.h>
+#include <ucs/sys/sys.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+/* Sanity bound for the packed worker address in the bootstrap handshake */
+#define UCP_LISTENER_MAX_ADDR_LENGTH  65536
+
+
+/*
+ * Bootstrap handshake, one round trip on the accepted/connected socket:
+ *
+ *   client -> server:  uint32_t length, packed client worker address
+ *   server -> client:  uint32_t length, packed server worker address
+ *
+ * Both sides create the endpoint with the regular ucp_ep_create() path, so
+ * the result is indistinguishable from an out-of-band address exchange.
+ */
+
+static ucs_status_t ucp_listener_sock_send(int fd, const void *buf, size_t length)
+{
+    size_t offset = 0;
+    ssize_t ret;
+
+    while (offset < length) {
+        ret = send(fd, (const char*)buf + offset, length - offset, MSG_NOSIGNAL);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ucs_error("failed to send on bootstrap socket: %m");
+            return UCS_ERR_IO_ERROR;
+        }
+        offset += ret;
+    }
+    return UCS_OK;
+}
+
+static ucs_status_t ucp_listener_sock_recv(int fd, void *buf, size_t length)
+{
+    size_t offset = 0;
+    ssize_t ret;
+
+    while (offset < length) {
+        ret = recv(fd, (char*)buf + offset, length - offset, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ucs_error("failed to receive on bootstrap socket: %m");
+            return UCS_ERR_IO_ERROR;
+        } else if (ret == 0) {
+            ucs_error("bootstrap connection closed by remote peer");
+            return UCS_ERR_IO_ERROR;
+        }
+        offset += ret;
+    }
+    return UCS_OK;
+}
+
+static ucs_status_t ucp_listener_send_worker_address(ucp_worker_h worker, int fd)
+{
+    ucp_address_t *address;
+    size_t address_length;
+    uint32_t length;
+    ucs_status_t status;
+
+    status = ucp_worker_get_address(worker, &address, &address_length);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    length = address_length;
+    status = ucp_listener_sock_send(fd, &length, sizeof(length));
+    if (status == UCS_OK) {
+        status = ucp_listener_sock_send(fd, address, address_length);
+    }
+
+    ucp_worker_release_address(worker, address);
+    return status;
+}
+
+static ucs_status_t ucp_listener_recv_worker_address(int fd, ucp_address_t **address_p)
+{
+    ucp_address_t *address;
+    uint32_t length;
+    ucs_status_t status;
+
+    status = ucp_listener_sock_recv(fd, &length, sizeof(length));
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    if ((length == 0) || (length > UCP_LISTENER_MAX_ADDR_LENGTH)) {
+        ucs_error("invalid worker address length %u in bootstrap handshake",
+                  length);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    address = ucs_malloc(length, "ucp bootstrap address");
+    if (address == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    status = ucp_listener_sock_recv(fd, address, length);
+    if (status != UCS_OK) {
+        ucs_free(address);
+        return status;
+    }
+
+    *address_p = address;
+    return UCS_OK;
+}
+
+static ucs_status_t
+ucp_listener_ep_create(ucp_worker_h worker, const ucp_address_t *address,
+                       const ucp_ep_params_t *user_params, ucp_ep_h *ep_p)
+{
+    ucp_ep_params_t params;
+
+    if (user_params != NULL) {
+        params = *user_params;
+    } else {
+        params.field_mask = 0;
+    }
+    params.field_mask |= UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
+    params.address     = address;
+
+    return ucp_ep_create(worker, &params, ep_p);
+}
+
+/*
+ * Accept pending connection requests on the listening socket. Called from
+ * worker progress; the listening socket is non-blocking, so the common case
+ * of no pending request costs one accept() call. The handshake on the
+ * accepted socket is blocking, but bounded: both messages are a few hundred
+ * bytes of packed worker address.
+ */
+static void ucp_listener_progress(void *arg)
+{
+    ucp_listener_t *listener = arg;
+    ucp_worker_h worker      = listener->worker;
+    ucp_address_t *address;
+    ucs_status_t status;
+    ucp_ep_h ep;
+    int fd;
+
+    fd = accept(listener->fd, NULL, NULL);
+    if (fd < 0) {
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            ucs_warn("accept() failed on ucp listener %p: %m", listener);
+        }
+        return;
+    }
+
+    status = ucp_listener_recv_worker_address(fd, &address);
+    if (status != UCS_OK) {
+        goto out_close;
+    }
+
+    status = ucp_listener_ep_create(worker, address, NULL, &ep);
+    ucs_free(address);
+    if (status != UCS_OK) {
+        ucs_error("failed to create endpoint for connection request: %s",
+                  ucs_status_string(status));
+        goto out_close;
+    }
+
+    status = ucp_listener_send_worker_address(worker, fd);
+    if (status != UCS_OK) {
+        ucp_ep_destroy(ep);
+        goto out_close;
+    }
+
+    close(fd);
+    listener->accept_cb(ep, listener->arg);
+    return;
+
+out_close:
+    close(fd);
+}
+
+ucs_status_t ucp_listener_create(ucp_worker_h worker,
+                                 const struct sockaddr *addr, socklen_t addrlen,
+                                 ucp_listener_accept_callback_t accept_cb,
+                                 void *arg, ucp_listener_h *listener_p)
+{
+    ucp_listener_t *listener;
+    ucs_status_t status;
+    int ret, on = 1;
+
+    listener = ucs_malloc(sizeof(*listener), "ucp listener");
+    if (listener == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    listener->worker    = worker;
+    listener->accept_cb = accept_cb;
+    listener->arg       = arg;
+
+    listener->fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (listener->fd < 0) {
+        ucs_error("failed to create listening socket: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_free;
+    }
+
+    ret = setsockopt(listener->fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (ret < 0) {
+        ucs_warn("failed to set SO_REUSEADDR on listening socket: %m");
+    }
+
+    ret = bind(listener->fd, addr, addrlen);
+    if (ret < 0) {
+        ucs_error("failed to bind listening socket: %m");
+        status = UCS_ERR_INVALID_ADDR;
+        goto err_close;
+    }
+
+    ret = listen(listener->fd, SOMAXCONN);
+    if (ret < 0) {
+        ucs_error("listen() failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_close;
+    }
+
+    ret = fcntl(listener->fd, F_SETFL, O_NONBLOCK);
+    if (ret < 0) {
+        ucs_error("failed to set listening socket non-blocking: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_close;
+    }
+
+    uct_worker_progress_register(worker->uct, ucp_listener_progress, listener);
+
+    ucs_debug("created ucp listener %p on worker %p fd %d", listener, worker,
+              listener->fd);
+    *listener_p = listener;
+    return UCS_OK;
+
+err_close:
+    close(listener->fd);
+err_free:
+    ucs_free(listener);
+    return status;
+}
+
+void ucp_listener_destroy(ucp_listener_h listener)
+{
+    ucs_debug("destroy ucp listener %p", listener);
+    uct_worker_progress_unregister(listener->worker->uct, ucp_listener_progress,
+                                   listener);
+    close(listener->fd);
+    ucs_free(listener);
+}
+
+ucs_status_t ucp_ep_create_sockaddr(ucp_worker_h worker,
+                                    const struct sockaddr *addr,
+                                    socklen_t addrlen,
+                                    const ucp_ep_params_t *params,
+                                    ucp_ep_h *ep_p)
+{
+    ucp_address_t *address;
+    ucs_status_t status;
+    int fd, ret, on = 1;
+
+    fd = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+        ucs_error("failed to create bootstrap socket: %m");
+        return UCS_ERR_IO_ERROR;
+    }
+
+    ret = setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    if (ret < 0) {
+        ucs_warn("failed to set TCP_NODELAY on bootstrap socket: %m");
+    }
+
+    ret = connect(fd, addr, addrlen);
+    if (ret < 0) {
+        ucs_error("failed to connect bootstrap socket: %m");
+        status = UCS_ERR_UNREACHABLE;
+        goto out_close;
+    }
+
+    status = ucp_listener_send_worker_address(worker, fd);
+    if (status != UCS_OK) {
+        goto out_close;
+    }
+
+    status = ucp_listener_recv_worker_address(fd, &address);
+    if (status != UCS_OK) {
+        goto out_close;
+    }
+
+    status = ucp_listener_ep_create(worker, address, params, ep_p);
+    ucs_free(address);
+
+out_close:
+    close(fd);
+    return status;
+}
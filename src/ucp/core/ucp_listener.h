@@ -0,0 +1,29 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_LISTENER_H_
+#define UCP_LISTENER_H_
+
+#include "ucp_types.h"
+
+#include <ucp/api/ucp.h>
+
+
+/**
+ * UCP listener - accepts connection requests on a bound socket address and
+ * creates fully wired endpoints for them. The listening socket itself is only
+ * a bootstrap channel; all subsequent communication goes through the regular
+ * transport lanes selected by wireup.
+ */
+typedef struct ucp_listener {
+    ucp_worker_h                   worker;    /* Worker the listener belongs to */
+    int                            fd;        /* Non-blocking listening socket */
+    ucp_listener_accept_callback_t accept_cb; /* User callback for new endpoints */
+    void                           *arg;      /* User argument for accept_cb */
+} ucp_listener_t;
+
+
+#endif
@@ -14,13 +14,39 @@
 #include <string.h>
 #include <inttypes.h>
 
+#if HAVE_CUDA
+#include <cuda_runtime.h>
+#endif
+
+
+#if HAVE_CUDA
+int ucp_memory_is_cuda(const void *address)
+{
+    struct cudaPointerAttributes attr;
+
+    if (cudaPointerGetAttributes(&attr, address) != cudaSuccess) {
+        /* Pointer unknown to the CUDA runtime - plain host memory */
+        (void)cudaGetLastError();
+        return 0;
+    }
+    return attr.memoryType == cudaMemoryTypeDevice;
+}
+#else
+int ucp_memory_is_cuda(const void *address)
+{
+    return 0;
+}
+#endif
+
 
 static ucp_mem_t ucp_mem_dummy_handle = {
     .address      = NULL,
     .length       = 0,
     .alloc_method = UCT_ALLOC_METHOD_LAST,
     .alloc_md     = NULL,
-    .md_map       = 0
+    .md_map       = 0,
+    .reg_status   = UCS_OK,
+    .context      = NULL
 };
 
 /**
@@ -261,6 +287,7 @@ ucs_status_t ucp_mem_map(ucp_context_h context, const ucp_mem_map_params_t *para
     ucs_status_t            status;
     ucp_mem_h               memh;
     ucp_mem_map_params_t    mem_params;
+    unsigned                uct_flags;
 
     /* always acquire context lock */
     UCP_THREAD_CS_ENTER(&context->mt_lock);
@@ -289,6 +316,8 @@ ucs_status_t ucp_mem_map(ucp_context_h context, const ucp_mem_map_params_t *para
 
     memh->address      = mem_params.address;
     memh->length       = mem_params.length;
+    memh->reg_status   = UCS_OK;
+    memh->context      = NULL;
 
     if (ucp_mem_map_is_allocate(&mem_params)) {
         ucs_debug("allocation user memory at %p length %zu", mem_params.address,
@@ -304,8 +333,13 @@ ucs_status_t ucp_mem_map(ucp_context_h context, const ucp_mem_map_params_t *para
                   mem_params.length);
         memh->alloc_method = UCT_ALLOC_METHOD_LAST;
         memh->alloc_md     = NULL;
-        status = ucp_memh_reg_mds(context, memh,
-                                  ucp_mem_map_params2uct_flags(&mem_params),
+        uct_flags          = ucp_mem_map_params2uct_flags(&mem_params);
+        if (ucp_memory_is_cuda(mem_params.address)) {
+            /* GPU memory cannot be backed by on-demand paging - take an
+             * eager peer-direct registration instead */
+            uct_flags &= ~UCT_MD_MEM_FLAG_NONBLOCK;
+        }
+        status = ucp_memh_reg_mds(context, memh, uct_flags,
                                   UCT_MEM_HANDLE_NULL);
         if (status != UCS_OK) {
             goto err_free_memh;
@@ -326,12 +360,126 @@ out:
     return status;
 }
 
+static void *ucp_mem_map_reg_thread_func(void *arg)
+{
+    ucp_mem_h memh         = arg;
+    ucp_context_h context  = memh->context;
+    unsigned uct_memh_count = 0;
+    ucs_status_t status;
+    unsigned md_index;
+    uct_mem_h uct_memh;
+
+    for (md_index = 0; md_index < context->num_mds; ++md_index) {
+        if (!(context->tl_mds[md_index].attr.cap.flags & UCT_MD_FLAG_REG)) {
+            continue;
+        }
+
+        status = uct_md_mem_reg(context->tl_mds[md_index].md, memh->address,
+                                memh->length, memh->uct_flags, &uct_memh);
+        if (status != UCS_OK) {
+            ucs_error("Failed to reg address %p length %zu with md %s: %s",
+                      memh->address, memh->length,
+                      context->tl_mds[md_index].rsc.md_name,
+                      ucs_status_string(status));
+            memh->reg_status = status;
+            return NULL;
+        }
+
+        /* Publish every handle as soon as its MD is done, so the memory is
+         * usable on the MDs which completed while the rest still register.
+         * The MDs already registered stay valid on failure, and are released
+         * by ucp_mem_unmap() as usual. */
+        UCP_THREAD_CS_ENTER(&context->mt_lock);
+        memh->uct[uct_memh_count++] = uct_memh;
+        memh->md_map               |= UCS_BIT(md_index);
+        UCP_THREAD_CS_EXIT(&context->mt_lock);
+    }
+
+    memh->reg_status = UCS_OK;
+    return NULL;
+}
+
+ucs_status_t ucp_mem_map_nb(ucp_context_h context,
+                            const ucp_mem_map_params_t *params,
+                            ucp_mem_h *memh_p)
+{
+    ucp_mem_map_params_t mem_params;
+    ucs_status_t status;
+    ucp_mem_h memh;
+    int ret;
+
+    mem_params = *params;
+    status = ucp_mem_map_check_and_adjust_params(&mem_params);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    /* Allocation has to produce the buffer address before returning to the
+     * user, so only the registration of existing memory is taken off the
+     * caller's critical path */
+    if (ucp_mem_map_is_allocate(&mem_params) || (mem_params.length == 0)) {
+        return ucp_mem_map(context, params, memh_p);
+    }
+
+    ucs_assert(context->num_mds > 0);
+    memh = ucs_malloc(sizeof(*memh) + context->num_mds * sizeof(memh->uct[0]),
+                      "ucp_memh");
+    if (memh == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    memh->address      = mem_params.address;
+    memh->length       = mem_params.length;
+    memh->alloc_method = UCT_ALLOC_METHOD_LAST;
+    memh->alloc_md     = NULL;
+    memh->md_map       = 0;
+    memh->reg_status   = UCS_INPROGRESS;
+    memh->context      = context;
+    memh->uct_flags    = ucp_mem_map_params2uct_flags(&mem_params);
+
+    ucs_debug("registering user memory at %p length %zu in the background",
+              mem_params.address, mem_params.length);
+
+    ret = pthread_create(&memh->reg_thread, NULL, ucp_mem_map_reg_thread_func,
+                         memh);
+    if (ret != 0) {
+        /* Could not start a thread - fall back to registering synchronously */
+        ucs_warn("failed to create registration thread: %s", strerror(ret));
+        memh->context    = NULL;
+        memh->reg_status = UCS_OK;
+
+        UCP_THREAD_CS_ENTER(&context->mt_lock);
+        status = ucp_memh_reg_mds(context, memh, memh->uct_flags,
+                                  UCT_MEM_HANDLE_NULL);
+        UCP_THREAD_CS_EXIT(&context->mt_lock);
+        if (status != UCS_OK) {
+            ucs_free(memh);
+            return status;
+        }
+    }
+
+    *memh_p = memh;
+    return UCS_OK;
+}
+
+ucs_status_t ucp_mem_map_test(ucp_mem_h memh)
+{
+    return memh->reg_status;
+}
+
 ucs_status_t ucp_mem_unmap(ucp_context_h context, ucp_mem_h memh)
 {
     uct_allocated_memory_t mem;
     uct_mem_h alloc_md_memh;
     ucs_status_t status;
 
+    /* Reap the background registration thread, if there was one. This must
+     * happen before taking the context lock, which the thread takes to
+     * publish handles. */
+    if (memh->context != NULL) {
+        pthread_join(memh->reg_thread, NULL);
+    }
+
     /* always acquire context lock */
     UCP_THREAD_CS_ENTER(&context->mt_lock);
 
@@ -15,6 +15,12 @@
 #include <ucs/debug/log.h>
 
 #include <inttypes.h>
+#include <pthread.h>
+
+
+/* Maximal number of same-device lanes to stripe RMA fragments over, e.g the
+ * two ports of a dual-port HCA. */
+#define UCP_RKEY_MAX_RAILS        2
 
 
 /**
@@ -32,8 +38,26 @@ typedef struct ucp_rkey {
         unsigned                  max_put_short;/* Cached value of max_put_short */
         uct_rkey_t                rma_rkey;     /* Key to use for RMAs */
         uct_rkey_t                amo_rkey;     /* Key to use for AMOs */
+        uct_rkey_bundle_t         *rkey_bundle; /* Bundle of the RMA lane, when its
+                                                   MD supports direct access to the
+                                                   remote memory (uct_rkey_ptr),
+                                                   NULL otherwise */
+
+        /* RMA lanes which share the memory domains of rma_lane, on both
+         * sides, so the same local memh and remote key are valid on all of
+         * them. Multi-fragment operations alternate between these rails. */
+        ucp_lane_index_t          rma_rails[UCP_RKEY_MAX_RAILS];
+        ucp_lane_index_t          num_rma_rails;
     } cache;
     ucp_md_map_t                  md_map;  /* Which *remote* MDs have valid memory handles */
+    uint32_t                      refcount;/* User handles sharing this rkey
+                                              through the worker rkey cache */
+    uint64_t                      hash_key;/* Worker rkey cache key */
+    void                          *packed; /* Copy of the packed buffer, to
+                                              verify cache hits exactly */
+    size_t                        packed_size;
+    ucp_worker_h                  worker;  /* Worker whose cache holds this
+                                              rkey, NULL if not cached */
     uct_rkey_bundle_t             uct[0];  /* Remote key for every MD */
 } ucp_rkey_t;
 
@@ -50,6 +74,14 @@ typedef struct ucp_mem {
     uct_alloc_method_t            alloc_method; /* Method used to allocate the memory */
     uct_md_h                      alloc_md;     /* MD used to allocated the memory */
     ucp_md_map_t                  md_map;       /* Which MDs have valid memory handles */
+    volatile ucs_status_t         reg_status;   /* UCS_INPROGRESS while a background
+                                                   thread is still registering */
+    ucp_context_h                 context;      /* Context of the background
+                                                   registration, NULL for handles
+                                                   mapped synchronously */
+    unsigned                      uct_flags;    /* Registration flags for the
+                                                   background thread */
+    pthread_t                     reg_thread;   /* Background registration thread */
     uct_mem_h                     uct[0];       /* Valid memory handles, as popcount(md_map) */
 } ucp_mem_t;
 
@@ -57,6 +89,13 @@ typedef struct ucp_mem {
 void ucp_rkey_resolve_inner(ucp_rkey_h rkey, ucp_ep_h ep);
 
 
+/**
+ * Check whether a buffer resides in GPU device memory. Always 0 when built
+ * without CUDA.
+ */
+int ucp_memory_is_cuda(const void *address);
+
+
 #define UCP_RKEY_RESOLVE(_rkey, _ep, _op_type) \
     ({ \
         ucs_status_t status = UCS_OK; \
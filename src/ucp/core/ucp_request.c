@@ -8,6 +8,9 @@
 #include "ucp_worker.h"
 #include "ucp_request.inl"
 
+#include <ucp/proto/proto.h>
+#include <ucp/tag/offload.h>
+#include <ucp/tag/rndv.h>
 #include <ucp/tag/tag_match.h>
 #include <ucs/datastruct/mpool.inl>
 #include <ucs/debug/debug.h>
@@ -17,6 +20,14 @@
 int ucp_request_is_completed(void *request)
 {
     ucp_request_t *req = (ucp_request_t*)request - 1;
+
+    /* The request mpool aligns every request to a cache line; keep the fields
+     * written on every operation - status, flags and the head of the send/recv
+     * union - together in the first one */
+    UCS_STATIC_ASSERT(ucs_offsetof(ucp_request_t, flags) < UCS_SYS_CACHE_LINE_SIZE);
+    UCS_STATIC_ASSERT(ucs_offsetof(ucp_request_t, send)  < UCS_SYS_CACHE_LINE_SIZE);
+    UCS_STATIC_ASSERT(ucs_offsetof(ucp_request_t, recv)  < UCS_SYS_CACHE_LINE_SIZE);
+
     return !!(req->flags & UCP_REQUEST_FLAG_COMPLETED);
 }
 
@@ -77,7 +88,8 @@ UCS_PROFILE_FUNC_VOID(ucp_request_cancel, (worker, request),
 {
     ucp_request_t *req = (ucp_request_t*)request - 1;
 
-    if (req->flags & UCP_REQUEST_FLAG_COMPLETED) {
+    /* A deferred request is already completed - only its callback is pending */
+    if (req->flags & (UCP_REQUEST_FLAG_COMPLETED | UCP_REQUEST_FLAG_DEFERRED)) {
         return;
     }
 
@@ -85,7 +97,12 @@ UCS_PROFILE_FUNC_VOID(ucp_request_cancel, (worker, request),
         UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
         UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
 
-        ucp_tag_exp_remove(&worker->context->tm, req);
+        if (req->flags & UCP_REQUEST_FLAG_OFFLOADED) {
+            ucp_tag_offload_cancel(worker, req, 1);
+            req->flags &= ~UCP_REQUEST_FLAG_OFFLOADED;
+        } else {
+            ucp_tag_exp_remove(&worker->context->tm, req);
+        }
         ucp_request_complete_recv(req, UCS_ERR_CANCELED);
 
         UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
@@ -128,6 +145,22 @@ void ucp_request_release_pending_send(uct_pending_req_t *self, void *arg)
     ucp_request_complete_send(req, UCS_ERR_CANCELED);
 }
 
+/* Small protocol replies - RTR and ATS of the rendezvous handshake, eager
+ * sync ack - are queued on the transport control tier, so they are not stuck
+ * behind previously queued bulk fragments. Only replies may be promoted: a
+ * message-initiating send (eager first fragment, RTS) establishes the tag
+ * matching order and must stay in queue order. */
+static unsigned ucp_request_pending_flags(ucp_request_t *req)
+{
+    if ((req->send.uct.func == ucp_proto_progress_rndv_rtr)     ||
+        (req->send.uct.func == ucp_proto_progress_rndv_rtr_put) ||
+        (req->send.uct.func == ucp_proto_progress_am_bcopy_single))
+    {
+        return UCT_PENDING_FLAG_CTRL;
+    }
+    return 0;
+}
+
 int ucp_request_pending_add(ucp_request_t *req, ucs_status_t *req_status)
 {
     ucs_status_t status;
@@ -136,8 +169,12 @@ int ucp_request_pending_add(ucp_request_t *req, ucs_status_t *req_status)
     ucs_assertv(req->send.lane != UCP_NULL_LANE, "%s() did not set req->send.lane",
                 ucs_debug_get_symbol_name(req->send.uct.func));
 
+    /* The request is parked with send.state intact, so a partially sent
+     * multi-fragment message resumes from its current offset when the
+     * transport dispatches the pending queue. */
     uct_ep = req->send.ep->uct_eps[req->send.lane];
-    status = uct_ep_pending_add(uct_ep, &req->send.uct);
+    status = uct_ep_pending_add(uct_ep, &req->send.uct,
+                                ucp_request_pending_flags(req));
     if (status == UCS_OK) {
         ucs_trace_data("ep %p: added pending uct request %p to lane[%d]=%p",
                        req->send.ep, req, req->send.lane, uct_ep);
@@ -173,8 +210,10 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_request_send_buffer_reg, (req, lane),
     ucp_dt_state_t *state = &req->send.state;
     size_t iov_it, iovcnt;
     const ucp_dt_iov_t *iov;
+    ucp_dt_strided_t *dt_strided;
     uct_mem_h *memh;
     ucs_status_t status;
+    size_t nelem;
 
     status = UCS_OK;
     switch (req->send.datatype & UCP_DATATYPE_CLASS_MASK) {
@@ -182,6 +221,15 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_request_send_buffer_reg, (req, lane),
         status = uct_md_mem_reg(uct_md, (void *)req->send.buffer, req->send.length,
                                 0, &state->dt.contig.memh);
         break;
+    case UCP_DATATYPE_STRIDED:
+        /* one registration covering the whole span, shared by all blocks */
+        dt_strided = ucp_dt_strided(req->send.datatype);
+        nelem      = req->send.length / dt_strided->length;
+        status     = uct_md_mem_reg(uct_md, (void *)req->send.buffer,
+                                    ((nelem - 1) * dt_strided->extent) +
+                                    ucp_dt_strided_span(dt_strided),
+                                    0, &state->dt.strided.memh);
+        break;
     case UCP_DATATYPE_IOV:
         iovcnt = state->dt.iov.iovcnt;
         iov    = req->send.buffer;
@@ -236,6 +284,11 @@ UCS_PROFILE_FUNC_VOID(ucp_request_send_buffer_dereg, (req, lane),
             uct_md_mem_dereg(uct_md, state->dt.contig.memh);
         }
         break;
+    case UCP_DATATYPE_STRIDED:
+        if (state->dt.strided.memh != UCT_MEM_HANDLE_NULL) {
+            uct_md_mem_dereg(uct_md, state->dt.strided.memh);
+        }
+        break;
     case UCP_DATATYPE_IOV:
         memh = state->dt.iov.memh;
         for (iov_it = 0; iov_it < state->dt.iov.iovcnt; ++iov_it) {
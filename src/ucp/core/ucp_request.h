@@ -15,6 +15,7 @@
 #include <uct/api/uct.h>
 #include <ucs/datastruct/mpool.h>
 #include <ucs/datastruct/queue_types.h>
+#include <ucs/time/time.h>
 #include <ucp/dt/dt.h>
 #include <ucp/wireup/wireup.h>
 
@@ -33,6 +34,9 @@ enum {
     UCP_REQUEST_FLAG_RECV                 = UCS_BIT(7),
     UCP_REQUEST_FLAG_SYNC                 = UCS_BIT(8),
     UCP_REQUEST_FLAG_RNDV                 = UCS_BIT(9),
+    UCP_REQUEST_FLAG_OFFLOADED            = UCS_BIT(10),
+    UCP_REQUEST_FLAG_DEFERRED             = UCS_BIT(11),
+    UCP_REQUEST_FLAG_ADAPT                = UCS_BIT(12),
 
 #if ENABLE_ASSERT
     UCP_REQUEST_DEBUG_FLAG_EXTERNAL       = UCS_BIT(15)
@@ -51,7 +55,8 @@ enum {
     UCP_RECV_DESC_FLAG_EAGER    = UCS_BIT(2),
     UCP_RECV_DESC_FLAG_SYNC     = UCS_BIT(3),
     UCP_RECV_DESC_FLAG_RNDV     = UCS_BIT(4),
-    UCP_RECV_DESC_FLAG_UCT_DESC = UCS_BIT(5)
+    UCP_RECV_DESC_FLAG_UCT_DESC = UCS_BIT(5),
+    UCP_RECV_DESC_FLAG_FC       = UCS_BIT(6)
 };
 
 
@@ -59,8 +64,9 @@ enum {
  * Receive descriptor list pointers
  */
 enum {
-    UCP_RDESC_HASH_LIST = 0,
-    UCP_RDESC_ALL_LIST  = 1
+    UCP_RDESC_HASH_LIST   = 0,
+    UCP_RDESC_ALL_LIST    = 1,
+    UCP_RDESC_SENDER_LIST = 2
 };
 
 
@@ -90,6 +96,17 @@ struct ucp_request {
                 struct {
                     uint64_t      remote_addr; /* Remote address */
                     ucp_rkey_h    rkey;     /* Remote memory key */
+                    ucp_lane_index_t rail;  /* Next rail for fragment striping,
+                                               reused as the next rail to read
+                                               the delivery ack on */
+                    uint8_t       remote_comp; /* Complete only on remote
+                                                  delivery */
+                    uint8_t       ack;      /* Scratch for the delivery ack
+                                               read-back */
+                    uint8_t       notify;   /* Notification write still to be
+                                               sent behind the payload */
+                    uint64_t      notify_value; /* Notification value */
+                    uint64_t      notify_addr;  /* Notification address */
                 } rma;
 
                 struct {
@@ -97,6 +114,8 @@ struct ucp_request {
                     uint8_t       am_id;
                     ucs_status_t  status;
                     uintptr_t     rreq_ptr; /* receive request ptr on the recv side */
+                    void          *ppln;    /* staging buffers for pipelined
+                                               rndv bcopy of a generic datatype */
                 } proto;
 
                 struct {
@@ -109,14 +128,33 @@ struct ucp_request {
                     uintptr_t     remote_request; /* pointer to the sender's send request */
                     uct_rkey_bundle_t rkey_bundle;
                     ucp_request_t *rreq;    /* receive request on the recv side */
+                    ucp_lane_index_t lane_idx; /* Round-robin index over the
+                                                  rndv stripe lanes */
                 } rndv_get;
 
+                struct {
+                    uint64_t      remote_address; /* address of the receiver's data buffer */
+                    uintptr_t     rreq_ptr; /* pointer to the receiver's rndv request,
+                                               sent back in the ATP */
+                    uct_rkey_bundle_t rkey_bundle;
+                } rndv_put;
+
                 struct {
                     ucp_request_callback_t    flushed_cb;/* Called when flushed */
                     ucs_callbackq_slow_elem_t cbq_elem;  /* Slow-path callback */
                     uint8_t                   cbq_elem_on;
                     ucp_lane_map_t            lanes;     /* Which lanes need to be flushed */
                 } flush;
+
+                struct {
+                    ucs_callbackq_slow_elem_t cbq_elem;  /* Slow-path callback
+                                                            for retrying */
+                    uint8_t                   cbq_elem_on;
+                    ucp_rsc_index_t           rsc_index; /* Next interface to
+                                                            start flushing */
+                    ucp_worker_h              worker;    /* Worker being flushed */
+                } worker_flush;
+
                 struct {
                     uint64_t              remote_addr; /* Remote address */
                     ucp_atomic_fetch_op_t op; /* Requested AMO */
@@ -130,6 +168,8 @@ struct ucp_request {
             ucp_dt_state_t        state;    /* Position in the send buffer */
             uct_pending_req_t     uct;      /* UCT pending request */
             uct_completion_t      uct_comp; /* UCT completion */
+            ucs_time_t            start_time; /* Timestamp of protocol selection,
+                                                 valid with FLAG_ADAPT */
         } send;
 
         struct {
@@ -143,8 +183,14 @@ struct ucp_request {
             ucp_tag_recv_callback_t cb;     /* Completion callback */
             ucp_tag_recv_info_t   info;     /* Completion info to fill */
             ucp_dt_state_t        state;
+            ucp_worker_h          worker;   /* Worker, when posted to HW tag
+                                               matching */
+            uct_tag_context_t     uct_ctx;  /* Transport offload context */
         } recv;
     };
+
+    ucs_queue_elem_t              defer;    /* Element in the worker completion
+                                               queue, in deferred-callback mode */
 };
 
 
@@ -152,7 +198,7 @@ struct ucp_request {
  * Unexpected receive descriptor.
  */
 typedef struct ucp_recv_desc {
-    ucs_list_link_t               list[2];  /* Hash list element */
+    ucs_list_link_t               list[3];  /* Hash list element */
     size_t                        length;   /* Received length */
     uint16_t                      hdr_len;  /* Header size */
     uint16_t                      flags;    /* Flags */
@@ -11,7 +11,9 @@
 #include <ucp/core/ucp_worker.h>
 #include <ucp/dt/dt.h>
 #include <ucs/debug/profile.h>
+#include <ucs/debug/usdt.h>
 #include <ucs/datastruct/mpool.inl>
+#include <ucs/datastruct/queue.h>
 #include <inttypes.h>
 
 
@@ -33,7 +35,7 @@
 /* defined as a macro to print the call site */
 #define ucp_request_get(_worker) \
     ({ \
-        ucp_request_t *_req = ucs_mpool_get_inline(&(_worker)->req_mp); \
+        ucp_request_t *_req = ucs_mpool_get(&(_worker)->req_mp); \
         if (_req != NULL) { \
             VALGRIND_MAKE_MEM_DEFINED(_req + 1, \
                                       (_worker)->context->config.request.size); \
@@ -88,6 +90,7 @@ ucp_request_try_send(ucp_request_t *req, ucs_status_t *req_status)
 
     /* No send resources, try to add to pending queue */
     ucs_assert(status == UCS_ERR_NO_RESOURCE);
+    UCS_USDT_PROBE2(req_no_resource, req, req->send.uct.func);
     return ucp_request_pending_add(req, req_status);
 }
 
@@ -113,7 +116,32 @@ ucp_request_put(ucp_request_t *req)
 {
     ucs_trace_req("put request %p", req);
     UCS_PROFILE_REQUEST_FREE(req);
-    ucs_mpool_put_inline(req);
+    /* Goes through the thread-local magazines on multi-threaded workers */
+    ucs_mpool_put(req);
+}
+
+/*
+ * In deferred-callback mode, park the request on the worker completion queue
+ * instead of firing its callback from inside transport progress; the queue is
+ * drained at the end of ucp_worker_progress().
+ *
+ * @return Whether the completion was deferred.
+ */
+static UCS_F_ALWAYS_INLINE int
+ucp_request_complete_deferred(ucp_request_t *req, ucs_status_t status)
+{
+    ucp_worker_h worker = ucs_container_of(ucs_mpool_obj_owner(req),
+                                           ucp_worker_t, req_mp);
+
+    if (ucs_likely(!worker->context->config.ext.deferred_cb)) {
+        return 0;
+    }
+
+    ucs_assert(!(req->flags & UCP_REQUEST_FLAG_DEFERRED));
+    req->status = status;
+    req->flags |= UCP_REQUEST_FLAG_DEFERRED;
+    ucs_queue_push(&worker->comp_q, &req->defer);
+    return 1;
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -123,6 +151,12 @@ ucp_request_complete_send(ucp_request_t *req, ucs_status_t status)
                   req, req + 1, UCP_REQUEST_FLAGS_ARG(req->flags),
                   ucs_status_string(status));
     UCS_PROFILE_REQUEST_EVENT(req, "complete_send", status);
+    if (ucs_unlikely(req->flags & UCP_REQUEST_FLAG_ADAPT)) {
+        ucp_ep_adapt_sample(req);
+    }
+    if (ucs_unlikely(ucp_request_complete_deferred(req, status))) {
+        return;
+    }
     ucp_request_complete(req, send.cb, status);
 }
 
@@ -135,9 +169,34 @@ ucp_request_complete_recv(ucp_request_t *req, ucs_status_t status)
                   req->recv.info.sender_tag, req->recv.info.length,
                   ucs_status_string(status));
     UCS_PROFILE_REQUEST_EVENT(req, "complete_recv", status);
+    if (ucs_unlikely(ucp_request_complete_deferred(req, status))) {
+        return;
+    }
     ucp_request_complete(req, recv.cb, status, &req->recv.info);
 }
 
+/*
+ * Deliver completion callbacks which were deferred during transport progress.
+ * A callback may complete further requests inline; those are appended to the
+ * queue and drained by the same loop.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucp_worker_deliver_completions(ucp_worker_h worker)
+{
+    ucp_request_t *req;
+
+    while (!ucs_queue_is_empty(&worker->comp_q)) {
+        req = ucs_queue_pull_elem_non_empty(&worker->comp_q, ucp_request_t,
+                                            defer);
+        req->flags &= ~UCP_REQUEST_FLAG_DEFERRED;
+        if (req->flags & UCP_REQUEST_FLAG_RECV) {
+            ucp_request_complete(req, recv.cb, req->status, &req->recv.info);
+        } else {
+            ucp_request_complete(req, send.cb, req->status);
+        }
+    }
+}
+
 static UCS_F_ALWAYS_INLINE
 void ucp_request_send_generic_dt_finish(ucp_request_t *req)
 {
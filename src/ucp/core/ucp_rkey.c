@@ -6,6 +6,7 @@
 
 #include "ucp_mm.h"
 #include "ucp_request.h"
+#include "ucp_worker.h"
 #include "ucp_ep.inl"
 
 #include <inttypes.h>
@@ -110,7 +111,35 @@ void ucp_rkey_buffer_release(void *rkey_buffer)
     ucs_free(rkey_buffer);
 }
 
-ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, void *rkey_buffer, ucp_rkey_h *rkey_p)
+/* Size of the packed buffer and its hash, seeded with the endpoint pointer -
+ * the unpacked handle depends on the endpoint configuration as well */
+static uint64_t ucp_rkey_buffer_hash(ucp_ep_h ep, const void *rkey_buffer,
+                                     size_t *size_p)
+{
+    const uint8_t *p = rkey_buffer;
+    ucp_md_map_t md_map;
+    uint64_t hash;
+    size_t size, i;
+
+    md_map = *(ucp_md_map_t*)p;
+    size   = sizeof(ucp_md_map_t);
+    while (md_map > 0) {
+        size   += sizeof(uint8_t) + p[size]; /* (md_size, rkey) per MD */
+        md_map &= md_map - 1;
+    }
+
+    /* FNV-1a */
+    hash = 0xcbf29ce484222325ul ^ (uintptr_t)ep;
+    for (i = 0; i < size; ++i) {
+        hash = (hash ^ p[i]) * 0x100000001b3ul;
+    }
+
+    *size_p = size;
+    return hash;
+}
+
+static ucs_status_t ucp_rkey_unpack_uncached(ucp_ep_h ep, void *rkey_buffer,
+                                             ucp_rkey_h *rkey_p)
 {
     unsigned remote_md_index, remote_md_gap;
     unsigned rkey_index;
@@ -129,12 +158,6 @@ ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, void *rkey_buffer, ucp_rkey_h *rkey
 
     ucs_trace("unpacking rkey with md_map 0x%lx", md_map);
 
-    if (md_map == 0) {
-        /* Dummy key return ok */
-        *rkey_p = &ucp_mem_dummy_rkey;
-        return UCS_OK;
-    }
-
     md_count = ucs_count_one_bits(md_map);
     p       += sizeof(ucp_md_map_t);
 
@@ -147,9 +170,13 @@ ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, void *rkey_buffer, ucp_rkey_h *rkey
         goto err;
     }
 
-    rkey->md_map    = 0;
-    remote_md_index = 0; /* Index of remote MD */
-    rkey_index      = 0; /* Index of the rkey in the array */
+    rkey->md_map      = 0;
+    rkey->refcount    = 1;
+    rkey->packed      = NULL;
+    rkey->packed_size = 0;
+    rkey->worker      = NULL;
+    remote_md_index   = 0; /* Index of remote MD */
+    rkey_index        = 0; /* Index of the rkey in the array */
 
     /* Unpack rkey of each UCT MD */
     while (md_map > 0) {
@@ -205,8 +232,98 @@ err:
     return status;
 }
 
+ucs_status_t ucp_ep_rkey_unpack(ucp_ep_h ep, void *rkey_buffer, ucp_rkey_h *rkey_p)
+{
+    ucp_worker_h worker = ep->worker;
+    ucs_status_t status;
+    ucp_rkey_h rkey, *hash_val;
+    uint64_t hash_key;
+    size_t size;
+    int is_new;
+
+    if (*(ucp_md_map_t*)rkey_buffer == 0) {
+        /* Dummy key return ok */
+        *rkey_p = &ucp_mem_dummy_rkey;
+        return UCS_OK;
+    }
+
+    hash_key = ucp_rkey_buffer_hash(ep, rkey_buffer, &size);
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    hash_val = ucp_worker_rkey_hash_get(&worker->rkey_hash, hash_key);
+    if (hash_val != NULL) {
+        rkey = *hash_val;
+        if ((rkey->packed_size == size) &&
+            !memcmp(rkey->packed, rkey_buffer, size))
+        {
+            /* Same buffer unpacked before on this endpoint - share the
+             * existing handle */
+            ++rkey->refcount;
+            *rkey_p = rkey;
+            status  = UCS_OK;
+            goto out;
+        }
+
+        /* Hash collision with a different buffer - return an uncached handle */
+        status = ucp_rkey_unpack_uncached(ep, rkey_buffer, rkey_p);
+        goto out;
+    }
+
+    status = ucp_rkey_unpack_uncached(ep, rkey_buffer, &rkey);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
+    /* Cache the new handle; keep a copy of the packed buffer so hits can be
+     * verified exactly. If the copy cannot be allocated, the handle is simply
+     * not cached. */
+    rkey->packed = ucs_malloc(size, "ucp_rkey_packed");
+    if (rkey->packed != NULL) {
+        memcpy(rkey->packed, rkey_buffer, size);
+        rkey->packed_size = size;
+        rkey->hash_key    = hash_key;
+
+        hash_val = ucp_worker_rkey_hash_put(&worker->rkey_hash, hash_key,
+                                            &is_new);
+        if (hash_val != NULL) {
+            *hash_val    = rkey;
+            rkey->worker = worker;
+        } else {
+            ucs_free(rkey->packed);
+            rkey->packed = NULL;
+        }
+    }
+
+    *rkey_p = rkey;
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
+}
+
+ucs_status_t ucp_ep_rkey_unpack_multi(ucp_ep_h ep, void **rkey_buffers,
+                                      size_t num_buffers, ucp_rkey_h *rkeys)
+{
+    ucs_status_t status;
+    size_t i;
+
+    for (i = 0; i < num_buffers; ++i) {
+        status = ucp_ep_rkey_unpack(ep, rkey_buffers[i], &rkeys[i]);
+        if (status != UCS_OK) {
+            while (i-- > 0) {
+                ucp_rkey_destroy(rkeys[i]);
+            }
+            return status;
+        }
+    }
+
+    return UCS_OK;
+}
+
 void ucp_rkey_destroy(ucp_rkey_h rkey)
 {
+    ucp_worker_h worker;
+    ucp_rkey_h *hash_val;
     unsigned num_rkeys;
     unsigned i;
 
@@ -214,6 +331,26 @@ void ucp_rkey_destroy(ucp_rkey_h rkey)
         return;
     }
 
+    worker = rkey->worker;
+    if (worker != NULL) {
+        UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+        if (--rkey->refcount > 0) {
+            UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+            return;
+        }
+
+        hash_val = ucp_worker_rkey_hash_get(&worker->rkey_hash,
+                                            rkey->hash_key);
+        if ((hash_val != NULL) && (*hash_val == rkey)) {
+            ucp_worker_rkey_hash_del(&worker->rkey_hash, rkey->hash_key);
+        }
+        UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+        ucs_free(rkey->packed);
+    } else if (--rkey->refcount > 0) {
+        /* Handle was shared and later detached from the worker cache */
+        return;
+    }
+
     num_rkeys = ucs_count_one_bits(rkey->md_map);
 
     for (i = 0; i < num_rkeys; ++i) {
@@ -250,6 +387,39 @@ static ucp_lane_index_t ucp_config_find_rma_lane(const ucp_ep_config_t *config,
     return UCP_NULL_LANE;
 }
 
+/* Collect RMA lanes which are interchangeable with the primary lane - same
+ * local and destination memory domains - so fragments can be striped over
+ * them with a single memh/rkey. This is the case for lanes running on
+ * different ports of the same HCA. */
+static void ucp_rkey_resolve_rma_rails(ucp_rkey_h rkey, ucp_ep_h ep)
+{
+    ucp_ep_config_t *config    = ucp_ep_config(ep);
+    ucp_lane_index_t prim_lane = rkey->cache.rma_lane;
+    ucp_lane_index_t lane;
+    int prio;
+
+    rkey->cache.rma_rails[0] = prim_lane;
+    rkey->cache.num_rma_rails = 1;
+
+    for (prio = 0; prio < UCP_MAX_LANES; ++prio) {
+        lane = config->key.rma_lanes[prio];
+        if (lane == UCP_NULL_LANE) {
+            break;
+        } else if ((lane == prim_lane) ||
+                   (config->key.lanes[lane].dst_md_index !=
+                    config->key.lanes[prim_lane].dst_md_index) ||
+                   (ucp_ep_md_index(ep, lane) !=
+                    ucp_ep_md_index(ep, prim_lane))) {
+            continue;
+        }
+
+        rkey->cache.rma_rails[rkey->cache.num_rma_rails++] = lane;
+        if (rkey->cache.num_rma_rails == UCP_RKEY_MAX_RAILS) {
+            break;
+        }
+    }
+}
+
 void ucp_rkey_resolve_inner(ucp_rkey_h rkey, ucp_ep_h ep)
 {
     ucp_ep_config_t *config = ucp_ep_config(ep);
@@ -257,9 +427,17 @@ void ucp_rkey_resolve_inner(ucp_rkey_h rkey, ucp_ep_h ep)
 
     rkey->cache.rma_lane = ucp_config_find_rma_lane(config, config->key.rma_lanes,
                                                     rkey->md_map, &rkey_index);
+    rkey->cache.num_rma_rails = 0;
+    rkey->cache.rkey_bundle   = NULL;
     if (rkey->cache.rma_lane != UCP_NULL_LANE) {
         rkey->cache.rma_rkey      = rkey->uct[rkey_index].rkey;
         rkey->cache.max_put_short = config->rma[rkey->cache.rma_lane].max_put_short;
+        if (ucp_ep_md_attr(ep, rkey->cache.rma_lane)->cap.flags &
+            UCT_MD_FLAG_RKEY_PTR) {
+            /* the remote memory is mapped locally - RMA can access it directly */
+            rkey->cache.rkey_bundle = &rkey->uct[rkey_index];
+        }
+        ucp_rkey_resolve_rma_rails(rkey, ep);
     }
 
     rkey->cache.amo_lane = ucp_config_find_rma_lane(config, config->key.amo_lanes,
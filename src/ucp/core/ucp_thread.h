@@ -72,6 +72,15 @@ typedef struct ucp_mt_lock {
             ucs_spin_unlock(&((_lock_ptr)->lock.mt_spinlock));          \
         }                                                               \
     }
+#define UCP_THREAD_CS_TRY_ENTER(_lock_ptr, _success)                    \
+    {                                                                   \
+        if ((_lock_ptr)->mt_type == UCP_MT_TYPE_MUTEX) {                \
+            (_success) =                                                \
+                (pthread_mutex_trylock(&((_lock_ptr)->lock.mt_mutex)) == 0); \
+        } else {                                                        \
+            (_success) = ucs_spin_trylock(&((_lock_ptr)->lock.mt_spinlock)); \
+        }                                                               \
+    }
 
 #else
 
@@ -80,6 +89,7 @@ typedef struct ucp_mt_lock {
 #define UCP_THREAD_LOCK_FINALIZE(_lock_ptr)              {}
 #define UCP_THREAD_CS_ENTER(_lock_ptr)                   {}
 #define UCP_THREAD_CS_EXIT(_lock_ptr)                    {}
+#define UCP_THREAD_CS_TRY_ENTER(_lock_ptr, _success)     { (_success) = 1; }
 
 #endif
 
@@ -95,5 +105,13 @@ typedef struct ucp_mt_lock {
             UCP_THREAD_CS_EXIT(_lock_ptr);                              \
         }                                                               \
     }
+#define UCP_THREAD_CS_TRY_ENTER_CONDITIONAL(_lock_ptr, _success)        \
+    {                                                                   \
+        if (UCP_THREAD_IS_REQUIRED(_lock_ptr)) {                        \
+            UCP_THREAD_CS_TRY_ENTER(_lock_ptr, _success);               \
+        } else {                                                        \
+            (_success) = 1;                                             \
+        }                                                               \
+    }
 
 #endif
@@ -65,6 +65,17 @@ enum {
                                           rndv (bcopy) */
     UCP_AM_ID_RNDV_DATA_LAST    =  13, /* The last rndv data fragment when using
                                           software rndv (bcopy) */
+    UCP_AM_ID_RNDV_ATP          =  14, /* Ack-to-Put after the sender finished
+                                          all the put operations */
+
+    UCP_AM_ID_EAGER_FC_ONLY     =  15, /* Single packet eager with credit
+                                          flow control */
+    UCP_AM_ID_EAGER_FC_FIRST    =  16, /* First eager fragment with credit
+                                          flow control */
+    UCP_AM_ID_EAGER_FC_GRANT    =  17, /* Credit grant from the receiver */
+
+    UCP_AM_ID_EAGER_BATCH       =  18, /* Frame of coalesced single packet
+                                          eager messages */
     UCP_AM_ID_LAST
 };
 
@@ -81,6 +92,31 @@ typedef enum {
 } ucp_atomic_mode_t;
 
 
+/**
+ * Rendezvous data transfer scheme.
+ */
+typedef enum {
+    UCP_RNDV_MODE_AUTO,      /* Select the scheme based on the transport
+                              * capabilities of the rendezvous lane */
+    UCP_RNDV_MODE_GET_ZCOPY, /* Receiver reads the data with get_zcopy */
+    UCP_RNDV_MODE_PUT_ZCOPY, /* Receiver advertises its buffer and the sender
+                              * writes the data with put_zcopy */
+    UCP_RNDV_MODE_LAST
+} ucp_rndv_mode_t;
+
+
+/**
+ * Ordering guarantee maintained when spraying eager messages over several
+ * active-message lanes.
+ */
+typedef enum {
+    UCP_EAGER_RAIL_ORDER_TAG,  /* Same-tag messages stay on one rail, so they
+                                * arrive in send order */
+    UCP_EAGER_RAIL_ORDER_NONE, /* Weighted round-robin over all rails */
+    UCP_EAGER_RAIL_ORDER_LAST
+} ucp_eager_rail_order_t;
+
+
 /**
  * Active message tracer.
  */
@@ -6,15 +6,31 @@
 */
 
 #include "ucp_worker.h"
+#include "ucp_mm.h"
 #include "ucp_request.inl"
 
 #include <ucp/wireup/address.h>
 #include <ucp/wireup/stub_ep.h>
 #include <ucp/tag/eager.h>
+#include <ucp/tag/offload.h>
+#include <ucs/algorithm/crc.h>
 #include <ucs/datastruct/mpool.inl>
+#include <uct/base/uct_md.h>
 #include <ucs/type/cpu_set.h>
 #include <ucs/sys/string.h>
-
+#include <sched.h>
+
+
+static const char *ucp_worker_stat_names[] = {
+    [UCP_WORKER_STAT_TAG_RX_EAGER_MSG]         = "rx_eager_msg",
+    [UCP_WORKER_STAT_TAG_RX_EAGER_SYNC_MSG]    = "rx_sync_msg",
+    [UCP_WORKER_STAT_TAG_RX_EAGER_CHUNK_EXP]   = "rx_eager_chunk_exp",
+    [UCP_WORKER_STAT_TAG_RX_EAGER_CHUNK_UNEXP] = "rx_eager_chunk_unexp",
+    [UCP_WORKER_STAT_TAG_RX_RNDV_EXP]          = "rx_rndv_rts_exp",
+    [UCP_WORKER_STAT_TAG_RX_RNDV_UNEXP]        = "rx_rndv_rts_unexp",
+    [UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_POOL]   = "rx_unexp_desc",
+    [UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_SPILL]  = "rx_unexp_desc_spill"
+};
 
 #if ENABLE_STATS
 static ucs_stats_class_t ucp_worker_stats_class = {
@@ -26,7 +42,9 @@ static ucs_stats_class_t ucp_worker_stats_class = {
         [UCP_WORKER_STAT_TAG_RX_EAGER_CHUNK_EXP]   = "rx_eager_chunk_exp",
         [UCP_WORKER_STAT_TAG_RX_EAGER_CHUNK_UNEXP] = "rx_eager_chunk_unexp",
         [UCP_WORKER_STAT_TAG_RX_RNDV_EXP]          = "rx_rndv_rts_exp",
-        [UCP_WORKER_STAT_TAG_RX_RNDV_UNEXP]        = "rx_rndv_rts_unexp"
+        [UCP_WORKER_STAT_TAG_RX_RNDV_UNEXP]        = "rx_rndv_rts_unexp",
+        [UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_POOL]   = "rx_unexp_desc",
+        [UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_SPILL]  = "rx_unexp_desc_spill"
     }
 };
 #endif
@@ -247,6 +265,10 @@ static ucs_status_t ucp_worker_add_iface(ucp_worker_h worker,
     iface_params.stats_root  = UCS_STATS_RVAL(worker->stats);
     iface_params.rx_headroom = rx_headroom;
     iface_params.cpu_mask    = *cpu_mask_param;
+    iface_params.eager_arg   = worker;
+    iface_params.eager_cb    = ucp_tag_offload_unexp_eager;
+    iface_params.rndv_arg    = worker;
+    iface_params.rndv_cb     = ucp_tag_offload_unexp_rndv;
 
     /* Open UCT interface */
     status = uct_iface_open(context->tl_mds[resource->md_index].md, worker->uct,
@@ -264,6 +286,14 @@ static ucs_status_t ucp_worker_add_iface(ucp_worker_h worker,
 
     attr = &worker->iface_attrs[tl_id];
 
+    /* Route expected receives to the first interface with HW tag matching;
+     * wildcard receives always stay in software */
+    if ((attr->cap.flags & UCT_IFACE_FLAG_TAG_EAGER_BCOPY) &&
+        (worker->tm_offload_iface == NULL)) {
+        worker->tm_offload_iface      = iface;
+        worker->tm_offload_iface_attr = attr;
+    }
+
     /* Set active message handlers for tag matching */
     if ((attr->cap.flags & (UCT_IFACE_FLAG_AM_SHORT|UCT_IFACE_FLAG_AM_BCOPY|UCT_IFACE_FLAG_AM_ZCOPY))) {
         status = ucp_worker_set_am_handlers(worker, iface, attr);
@@ -477,6 +507,28 @@ static ucs_status_t ucp_worker_init_am_mpool(ucp_worker_h worker,
                           &ucp_am_mpool_ops, "ucp_am_bufs");
 }
 
+/* Dedicated pool for small unexpected messages, so that descriptor churn
+ * under heavy incast does not grow the (maximal-AM-sized) generic pool */
+static ucs_status_t ucp_worker_init_rdesc_mpool(ucp_worker_h worker)
+{
+    return ucs_mpool_init(&worker->rdesc_mp, 0,
+                          sizeof(ucp_recv_desc_t) + UCP_WORKER_UNEXP_DESC_SIZE,
+                          0, UCS_SYS_CACHE_LINE_SIZE, 128,
+                          UCP_WORKER_UNEXP_DESC_MAX_ELEMS,
+                          &ucp_am_mpool_ops, "ucp_unexp_rdescs");
+}
+
+/* Staging buffers for coalesced eager tag sends (UCX_TAG_COALESCE). One
+ * buffer holds one pending frame, so only a few are in flight at a time */
+static ucs_status_t ucp_worker_init_tag_coalesce_mpool(ucp_worker_h worker)
+{
+    return ucs_mpool_init(&worker->tag_coalesce_mp, 0,
+                          sizeof(ucp_tag_coalesce_entry_t) +
+                          worker->context->config.ext.tag_coalesce_size,
+                          0, UCS_SYS_CACHE_LINE_SIZE, 8, UINT_MAX,
+                          &ucp_am_mpool_ops, "ucp_tag_coalesce");
+}
+
 /* All the ucp endpoints will share the configurations. No need for every ep to
  * have it's own configuration (to save memory footprint). Same config can be used
  * by different eps.
@@ -525,6 +577,7 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     ucs_cpu_set_t empty_cpu_mask;
     ucs_thread_mode_t thread_mode;
     ucp_wakeup_event_t events;
+    char shm_slot_name[UCS_STATS_SHM_NAME_MAX];
     const size_t rx_headroom = sizeof(ucp_recv_desc_t);
 
     config_count = ucs_min((context->num_tls + 1) * (context->num_tls + 1) * context->num_tls,
@@ -556,7 +609,10 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     worker->context         = context;
     worker->uuid            = ucs_generate_uuid((uintptr_t)worker);
     worker->stub_pend_count = 0;
+    ucs_list_head_init(&worker->stub_retired);
     worker->inprogress      = 0;
+    worker->idle_streak     = 0;
+    worker->warmup_timer_id = -1;
     worker->ep_config_max   = config_count;
     worker->ep_config_count = 0;
 
@@ -565,7 +621,15 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     ucs_snprintf_zero(worker->name, name_length, "%s:%d", ucs_get_host_name(),
                       getpid());
 
-    kh_init_inplace(ucp_worker_ep_hash, &worker->ep_hash);
+    ucp_worker_ep_hash_init(&worker->ep_hash);
+    ucp_worker_rkey_hash_init(&worker->rkey_hash);
+    ucp_worker_wireup_hash_init(&worker->wireup_hash);
+    ucp_worker_ifep_hash_init(&worker->ifep_hash);
+    ucp_worker_ifep_hash_init(&worker->ifep_ptr_hash);
+    ucp_amo_combine_hash_init(&worker->amo_combine);
+    ucp_tag_coalesce_hash_init(&worker->tag_coalesce);
+    ucs_queue_head_init(&worker->comp_q);
+    ucs_arena_init(&worker->ctl_arena, UCP_WORKER_CTL_ARENA_CHUNK);
 
     worker->ifaces = ucs_calloc(context->num_tls, sizeof(*worker->ifaces),
                                 "ucp iface");
@@ -588,6 +652,12 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_free_attrs;
     }
 
+    /* Always-on counters, published in shared memory */
+    ucs_snprintf_zero(shm_slot_name, sizeof(shm_slot_name), "worker-%p", worker);
+    worker->stats_shm = ucs_stats_shm_slot_alloc(shm_slot_name,
+                                                 ucp_worker_stat_names,
+                                                 UCP_WORKER_STAT_LAST);
+
     status = ucp_worker_wakeup_context_init(&worker->wakeup, context->num_tls);
     if (status != UCS_OK) {
         goto err_free_stats;
@@ -604,6 +674,8 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_destroy_async;
     }
 
+    uct_worker_set_mem_budget(worker->uct, context->config.ext.worker_mem_budget);
+
     /* Create memory pool for requests */
     status = ucs_mpool_init(&worker->req_mp, 0,
                             sizeof(ucp_request_t) + context->config.request.size,
@@ -612,6 +684,24 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
     if (status != UCS_OK) {
         goto err_destroy_uct_worker;
     }
+    uct_worker_mpool_track(worker->uct, &worker->req_mp);
+
+    /* Requests are released by application threads, possibly concurrently with
+     * the progress thread - give the pool its own thread safety */
+    if (worker->mt_lock.mt_type != UCP_MT_TYPE_NONE) {
+        status = ucs_mpool_enable_mt(&worker->req_mp);
+        if (status != UCS_OK) {
+            goto err_destroy_req_mpool;
+        }
+    }
+
+    /* Create memory pool for endpoints */
+    status = ucs_mpool_init(&worker->ep_mp, 0, sizeof(ucp_ep_t), 0,
+                            UCS_SYS_CACHE_LINE_SIZE, 32, UINT_MAX,
+                            &ucp_am_mpool_ops, "ucp_eps");
+    if (status != UCS_OK) {
+        goto err_destroy_req_mpool;
+    }
 
     if (params->field_mask & UCP_WORKER_PARAM_FIELD_EVENTS) {
         events = params->events;
@@ -640,14 +730,40 @@ ucs_status_t ucp_worker_create(ucp_context_h context,
         goto err_close_ifaces;
     }
 
+    /* Init unexpected receive descriptors memory pool */
+    status = ucp_worker_init_rdesc_mpool(worker);
+    if (status != UCS_OK) {
+        goto err_destroy_am_mpool;
+    }
+
+    /* Init coalesced eager send staging buffers memory pool */
+    status = ucp_worker_init_tag_coalesce_mpool(worker);
+    if (status != UCS_OK) {
+        goto err_destroy_rdesc_mpool;
+    }
+
+    /* Init cross-thread operation injection ring */
+    status = ucs_mpmc_queue_init(&worker->inject_q, UCP_WORKER_INJECT_RING_SIZE);
+    if (status != UCS_OK) {
+        goto err_destroy_tag_coalesce_mpool;
+    }
+
     /* Select atomic resources */
     ucp_worker_init_atomic_tls(worker);
 
     *worker_p = worker;
     return UCS_OK;
 
+err_destroy_tag_coalesce_mpool:
+    ucs_mpool_cleanup(&worker->tag_coalesce_mp, 1);
+err_destroy_rdesc_mpool:
+    ucs_mpool_cleanup(&worker->rdesc_mp, 1);
+err_destroy_am_mpool:
+    ucs_mpool_cleanup(&worker->am_mp, 1);
 err_close_ifaces:
     ucp_worker_close_ifaces(worker);
+    ucs_mpool_cleanup(&worker->ep_mp, 1);
+err_destroy_req_mpool:
     ucs_mpool_cleanup(&worker->req_mp, 1);
 err_destroy_uct_worker:
     uct_worker_destroy(worker->uct);
@@ -656,6 +772,7 @@ err_destroy_async:
 err_free_wakeup:
     ucp_worker_wakeup_context_cleanup(&worker->wakeup);
 err_free_stats:
+    ucs_stats_shm_slot_free(worker->stats_shm);
     UCS_STATS_NODE_FREE(worker->stats);
 err_free_attrs:
     ucs_free(worker->iface_attrs);
@@ -669,28 +786,292 @@ err_free:
 
 static void ucp_worker_destroy_eps(ucp_worker_h worker)
 {
-    ucp_ep_h ep;
+    ucp_worker_ep_hash_bucket_t *bucket;
 
     ucs_debug("worker %p: destroy all endpoints", worker);
-    kh_foreach_value(&worker->ep_hash, ep,
-                     ucp_ep_destroy_internal(ep, " from worker destroy"));
+
+    /* Destroying an endpoint removes it from the hash, which shifts other
+     * entries around - so restart the scan instead of iterating */
+    while (worker->ep_hash.count > 0) {
+        for (bucket = worker->ep_hash.buckets; bucket->dist == 0; ++bucket);
+        ucp_ep_destroy_internal(bucket->value, " from worker destroy");
+    }
+}
+
+/* Detach cached rkeys which the user still holds - they become plain
+ * uncached handles and are freed by ucp_rkey_destroy() as usual */
+static void ucp_worker_rkey_cache_cleanup(ucp_worker_h worker)
+{
+    ucp_rkey_h rkey;
+
+    ucs_ohash_foreach_value(ucp_worker_rkey_hash, &worker->rkey_hash, rkey, {
+        ucs_free(rkey->packed);
+        rkey->packed = NULL;
+        rkey->worker = NULL;
+    });
+    ucp_worker_rkey_hash_cleanup(&worker->rkey_hash);
+}
+
+ucs_status_t ucp_worker_iface_ep_get(ucp_worker_h worker,
+                                     ucp_rsc_index_t rsc_index,
+                                     const uct_device_addr_t *dev_addr,
+                                     size_t dev_addr_len,
+                                     const uct_iface_addr_t *iface_addr,
+                                     size_t iface_addr_len, uct_ep_h *ep_p)
+{
+    ucp_worker_iface_ep_t **entry_p, *entry;
+    ucs_status_t status;
+    uct_ep_h uct_ep;
+    uint64_t digest;
+    int is_new;
+
+    digest = ((uint64_t)rsc_index << 32) |
+             ucs_crc32(ucs_crc32(0, dev_addr, dev_addr_len), iface_addr,
+                       iface_addr_len);
+
+    entry_p = ucp_worker_ifep_hash_get(&worker->ifep_hash, digest);
+    if (entry_p != NULL) {
+        entry = *entry_p;
+        if ((entry->rsc_index == rsc_index) &&
+            (entry->addr_len == (dev_addr_len + iface_addr_len)) &&
+            !memcmp(entry->addr, dev_addr, dev_addr_len) &&
+            !memcmp(entry->addr + dev_addr_len, iface_addr, iface_addr_len))
+        {
+            ++entry->refcount;
+            *ep_p = entry->uct_ep;
+            ucs_trace("worker %p: reusing uct_ep %p for rsc[%d] (refcount %u)",
+                      worker, entry->uct_ep, rsc_index, entry->refcount);
+            return UCS_OK;
+        }
+    }
+
+    status = uct_ep_create_connected(worker->ifaces[rsc_index], dev_addr,
+                                     iface_addr, &uct_ep);
+    if (status != UCS_OK) {
+        return status;
+    }
+    *ep_p = uct_ep;
+
+    if (entry_p != NULL) {
+        /* Digest collision with a different remote address - leave the new
+         * endpoint unshared; ucp_worker_iface_ep_put() will not find it and
+         * the owner destroys it directly */
+        return UCS_OK;
+    }
+
+    /* Failure to track the endpoint only loses sharing, not correctness */
+    entry = ucs_malloc(sizeof(*entry) + dev_addr_len + iface_addr_len,
+                       "worker_iface_ep");
+    if (entry == NULL) {
+        return UCS_OK;
+    }
+
+    entry->uct_ep    = uct_ep;
+    entry->digest    = digest;
+    entry->refcount  = 1;
+    entry->rsc_index = rsc_index;
+    entry->addr_len  = dev_addr_len + iface_addr_len;
+    memcpy(entry->addr, dev_addr, dev_addr_len);
+    memcpy(entry->addr + dev_addr_len, iface_addr, iface_addr_len);
+
+    entry_p = ucp_worker_ifep_hash_put(&worker->ifep_hash, digest, &is_new);
+    if (entry_p == NULL) {
+        ucs_free(entry);
+        return UCS_OK;
+    }
+    ucs_assert(is_new);
+    *entry_p = entry;
+
+    entry_p = ucp_worker_ifep_hash_put(&worker->ifep_ptr_hash,
+                                       (uintptr_t)uct_ep, &is_new);
+    if (entry_p == NULL) {
+        ucp_worker_ifep_hash_del(&worker->ifep_hash, digest);
+        ucs_free(entry);
+        return UCS_OK;
+    }
+    ucs_assert(is_new);
+    *entry_p = entry;
+    return UCS_OK;
+}
+
+int ucp_worker_iface_ep_put(ucp_worker_h worker, uct_ep_h uct_ep)
+{
+    ucp_worker_iface_ep_t **entry_p, *entry;
+
+    entry_p = ucp_worker_ifep_hash_get(&worker->ifep_ptr_hash,
+                                       (uintptr_t)uct_ep);
+    if (entry_p == NULL) {
+        return 0;
+    }
+
+    entry = *entry_p;
+    if (--entry->refcount > 0) {
+        ucs_trace("worker %p: detach from uct_ep %p (refcount %u)", worker,
+                  uct_ep, entry->refcount);
+        return 1;
+    }
+
+    uct_ep_destroy(uct_ep);
+    ucp_worker_ifep_hash_del(&worker->ifep_ptr_hash, (uintptr_t)uct_ep);
+    ucp_worker_ifep_hash_del(&worker->ifep_hash, entry->digest);
+    ucs_free(entry);
+    return 1;
+}
+
+static void ucp_worker_iface_ep_cleanup(ucp_worker_h worker)
+{
+    ucp_worker_iface_ep_t *entry;
+
+    /* All endpoints were destroyed by now, so any remaining entry is a leaked
+     * reference - reclaim it before the interfaces are closed */
+    ucs_ohash_foreach_value(ucp_worker_ifep_hash, &worker->ifep_hash, entry, {
+        ucs_warn("worker %p: shared uct_ep %p has %u dangling references",
+                 worker, entry->uct_ep, entry->refcount);
+        uct_ep_destroy(entry->uct_ep);
+        ucs_free(entry);
+    });
+    ucp_worker_ifep_hash_cleanup(&worker->ifep_hash);
+    ucp_worker_ifep_hash_cleanup(&worker->ifep_ptr_hash);
+}
+
+static void ucp_worker_wireup_cache_cleanup(ucp_worker_h worker)
+{
+    ucp_wireup_select_result_t *sel;
+
+    ucs_ohash_foreach_value(ucp_worker_wireup_hash, &worker->wireup_hash, sel, {
+        ucs_free(sel);
+    });
+    ucp_worker_wireup_hash_cleanup(&worker->wireup_hash);
+}
+
+static void ucp_worker_inject_send_cb(void *request, ucs_status_t status)
+{
+    ucp_request_free(request);
+}
+
+static void ucp_worker_inject_exec(ucp_worker_h worker, ucp_inject_op_t *op)
+{
+    ucs_status_ptr_t sreq;
+    ucs_status_t status;
+
+    switch (op->opcode) {
+    case UCP_INJECT_OP_TAG_SEND:
+        sreq = ucp_tag_send_nb(op->ep, op->buffer, op->length,
+                               ucp_dt_make_contig(1), op->tag,
+                               ucp_worker_inject_send_cb);
+        if (UCS_PTR_IS_ERR(sreq)) {
+            ucs_warn("injected tag send failed: %s",
+                     ucs_status_string(UCS_PTR_STATUS(sreq)));
+        }
+        break;
+    case UCP_INJECT_OP_PUT:
+        status = ucp_put_nbi(op->ep, op->buffer, op->length, op->remote_addr,
+                             op->rkey);
+        if (status < 0) {
+            ucs_warn("injected put failed: %s", ucs_status_string(status));
+        }
+        break;
+    case UCP_INJECT_OP_FLUSH:
+        sreq = ucp_ep_flush_nb(op->ep, ucp_worker_inject_send_cb);
+        if (UCS_PTR_IS_ERR(sreq)) {
+            ucs_warn("injected flush failed: %s",
+                     ucs_status_string(UCS_PTR_STATUS(sreq)));
+        }
+        break;
+    default:
+        ucs_warn("invalid injected operation code %d", op->opcode);
+        break;
+    }
+}
+
+static void ucp_worker_inject_drain(ucp_worker_h worker)
+{
+    ucp_inject_op_t *op;
+
+    while (ucs_mpmc_queue_pull(&worker->inject_q, (void**)&op) == UCS_OK) {
+        ucp_worker_inject_exec(worker, op);
+        ucs_free(op);
+    }
+}
+
+static void ucp_worker_inject_purge(ucp_worker_h worker)
+{
+    ucp_inject_op_t *op;
+    unsigned count = 0;
+
+    while (ucs_mpmc_queue_pull(&worker->inject_q, (void**)&op) == UCS_OK) {
+        ucs_free(op);
+        ++count;
+    }
+
+    if (count > 0) {
+        ucs_debug("worker %p: discarded %u injected operations", worker, count);
+    }
+    ucs_mpmc_queue_cleanup(&worker->inject_q);
+}
+
+ucs_status_t ucp_worker_inject(ucp_worker_h worker, const ucp_inject_op_t *op)
+{
+    ucp_inject_op_t *copy;
+    ucs_status_t status;
+
+    if (UCP_THREAD_IS_REQUIRED(&worker->mt_lock)) {
+        /* A multi-threaded worker serializes at the lock anyway - submit
+         * through the regular API instead */
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    copy = ucs_malloc(sizeof(*copy), "ucp inject op");
+    if (copy == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    *copy  = *op;
+    status = ucs_mpmc_queue_push(&worker->inject_q, copy);
+    if (status != UCS_OK) {
+        ucs_free(copy);
+        return UCS_ERR_NO_RESOURCE; /* Ring full - retry after a progress call */
+    }
+
+    return UCS_OK;
 }
 
 void ucp_worker_destroy(ucp_worker_h worker)
 {
     ucs_trace_func("worker=%p", worker);
+    if (worker->warmup_timer_id != -1) {
+        ucs_async_remove_handler(worker->warmup_timer_id, 1);
+        worker->warmup_timer_id = -1;
+    }
+    ucp_worker_inject_purge(worker);
+    /* Push out pending combined atomic adds and coalesced eager frames while
+     * the endpoints are alive */
+    ucp_worker_amo_combine_drain(worker, 1);
+    ucp_tag_coalesce_drain(worker, 1);
     ucp_worker_remove_am_handlers(worker);
     ucp_worker_destroy_eps(worker);
+    ucp_stub_ep_retired_cleanup(worker);
+    ucp_worker_iface_ep_cleanup(worker);
+    ucs_mpool_cleanup(&worker->ep_mp, 1);
+    ucs_mpool_cleanup(&worker->tag_coalesce_mp, 1);
+    ucs_mpool_cleanup(&worker->rdesc_mp, 1);
     ucs_mpool_cleanup(&worker->am_mp, 1);
     ucp_worker_close_ifaces(worker);
+    ucp_worker_deliver_completions(worker);
     ucs_mpool_cleanup(&worker->req_mp, 1);
     uct_worker_destroy(worker->uct);
     ucs_async_context_cleanup(&worker->async);
     ucp_worker_wakeup_context_cleanup(&worker->wakeup);
     ucs_free(worker->iface_attrs);
     ucs_free(worker->ifaces);
-    kh_destroy_inplace(ucp_worker_ep_hash, &worker->ep_hash);
+    ucp_worker_ep_hash_cleanup(&worker->ep_hash);
+    ucp_amo_combine_hash_cleanup(&worker->amo_combine);
+    ucp_tag_coalesce_hash_cleanup(&worker->tag_coalesce);
+    ucp_worker_rkey_cache_cleanup(worker);
+    ucp_worker_wireup_cache_cleanup(worker);
+    ucs_arena_cleanup(&worker->ctl_arena);
     UCP_THREAD_LOCK_FINALIZE(&worker->mt_lock);
+    ucs_stats_shm_slot_free(worker->stats_shm);
     UCS_STATS_NODE_FREE(worker->stats);
     ucs_free(worker);
 }
@@ -706,16 +1087,47 @@ ucs_status_t ucp_worker_query(ucp_worker_h worker,
         }
     }
 
+    if (attr->field_mask & UCP_WORKER_ATTR_FIELD_MEM_FOOTPRINT) {
+        attr->mem_footprint = uct_worker_mem_footprint(worker->uct);
+    }
+
     return UCS_OK;
 }
 
 void ucp_worker_progress(ucp_worker_h worker)
 {
+    unsigned activity;
+    int locked;
+
+    /* If another thread is progressing this worker right now, don't pile up
+     * behind the lock - that call drains the same completion queues, and
+     * blocked callers would only convoy behind it */
+    UCP_THREAD_CS_TRY_ENTER_CONDITIONAL(&worker->mt_lock, locked);
+    if (!locked) {
+        return;
+    }
+
+    /* Execute operations deposited by other threads since the last call */
+    if (ucs_unlikely(!ucs_mpmc_queue_is_empty(&worker->inject_q))) {
+        ucp_worker_inject_drain(worker);
+    }
+
+    /* Combined atomic adds accumulated since the last progress call go on
+     * the wire before the transports are polled */
+    if (ucs_unlikely(worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(worker, 0);
+    }
+
+    /* Same for coalesced eager frames staged since the last progress call */
+    if (ucs_unlikely(worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_drain(worker, 0);
+    }
+
+    activity = uct_worker_activity_count(worker->uct);
+
     /* worker->inprogress is used only for assertion check.
      * coverity[assert_side_effect]
      */
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-
     ucs_assert(worker->inprogress++ == 0);
     uct_worker_progress(worker->uct);
     ucs_async_check_miss(&worker->async);
@@ -723,7 +1135,301 @@ void ucp_worker_progress(ucp_worker_h worker)
     /* coverity[assert_side_effect] */
     ucs_assert(--worker->inprogress == 0);
 
+    /* Deliver completion callbacks which were deferred during progress */
+    ucp_worker_deliver_completions(worker);
+
+    /* Track how long the worker has been idle. Any arriving message snaps
+     * back to full-rate polling; a long idle streak yields the CPU between
+     * polls so it is not burned on an idle worker */
+    if (uct_worker_activity_count(worker->uct) != activity) {
+        worker->idle_streak = 0;
+    } else {
+        ++worker->idle_streak;
+    }
+
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+
+    if (ucs_unlikely(worker->idle_streak >= UCP_WORKER_IDLE_STREAK_YIELD)) {
+        sched_yield();
+    }
+}
+
+/* Grow a memory pool ahead of time by taking and returning elements, so the
+ * first messages do not hit the chunk allocation slow path */
+static void ucp_worker_warmup_mpool(ucs_mpool_t *mp, unsigned count)
+{
+    void **objs;
+    unsigned i, n;
+
+    objs = ucs_malloc(count * sizeof(*objs), "warmup_mpool");
+    if (objs == NULL) {
+        return;
+    }
+
+    for (n = 0; n < count; ++n) {
+        objs[n] = ucs_mpool_get(mp);
+        if (objs[n] == NULL) {
+            break;
+        }
+    }
+    for (i = 0; i < n; ++i) {
+        ucs_mpool_put(objs[i]);
+    }
+    ucs_free(objs);
+}
+
+static int ucp_worker_warmup_done(ucp_worker_h worker)
+{
+    ucp_worker_ep_hash_bucket_t *bucket;
+    ucp_lane_index_t lane;
+    ucp_ep_h ep;
+    unsigned i;
+
+    for (i = 0; i < worker->ep_hash.capacity; ++i) {
+        bucket = &worker->ep_hash.buckets[i];
+        if (bucket->dist == 0) {
+            continue;
+        }
+
+        ep = bucket->value;
+        for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
+            /* Deferred lanes connect on first use by design, so they do not
+             * hold the warm-up open */
+            if ((ep->uct_eps[lane] != NULL) &&
+                ucp_stub_ep_test(ep->uct_eps[lane]) &&
+                !ucp_stub_ep_is_deferred(ep->uct_eps[lane]))
+            {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+static void ucp_worker_warmup_timer_cb(int id, void *arg)
+{
+    ucp_worker_h worker = arg;
+
+    ucp_worker_progress(worker);
+    if (ucp_worker_warmup_done(worker)) {
+        ucs_debug("worker %p: warmup completed", worker);
+        ucs_async_remove_handler(id, 0);
+        worker->warmup_timer_id = -1;
+    }
+}
+
+ucs_status_t ucp_worker_warmup(ucp_worker_h worker, unsigned num_addrs,
+                               const ucp_address_t * const *addresses)
+{
+    ucp_ep_params_t params;
+    ucs_status_t status;
+    unsigned i;
+    ucp_ep_h ep;
+
+    /* Establish all endpoints up front. Wireup handshakes are sent
+     * asynchronously, so the requests to all peers are already in flight when
+     * the loop ends, and complete in the background below. */
+    for (i = 0; i < num_addrs; ++i) {
+        params.field_mask = UCP_EP_PARAM_FIELD_REMOTE_ADDRESS;
+        params.address    = addresses[i];
+        status = ucp_ep_create(worker, &params, &ep);
+        if (status != UCS_OK) {
+            ucs_error("warmup failed to create ep to peer %u/%u: %s", i,
+                      num_addrs, ucs_status_string(status));
+            return status;
+        }
+    }
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    ucp_worker_warmup_mpool(&worker->req_mp, num_addrs);
+    ucp_worker_warmup_mpool(&worker->am_mp, num_addrs);
+    ucp_worker_warmup_mpool(&worker->rdesc_mp, num_addrs);
+
+    /* Drive the remaining handshakes from the async thread, so the warm-up
+     * completes while the application initializes without progressing */
+    status = UCS_OK;
+    if ((worker->warmup_timer_id == -1) && !ucp_worker_warmup_done(worker)) {
+        status = ucs_async_add_timer(worker->async.mode,
+                                     ucs_time_from_msec(1),
+                                     ucp_worker_warmup_timer_cb, worker,
+                                     &worker->async,
+                                     &worker->warmup_timer_id);
+    }
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
+}
+
+/*
+ * Peer address book - the packed addresses of all connected peers, saved to a
+ * file so that a related process (e.g. a forked child with the same hardware
+ * view) can connect to the same peer set without repeating the address
+ * exchange. Format: header, then one length-prefixed packed address per peer.
+ */
+
+#define UCP_ADDRESS_BOOK_MAGIC    0x41584355u /* "UCXA" */
+#define UCP_ADDRESS_BOOK_VERSION  1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_peers;
+    uint32_t reserved;
+} ucp_address_book_hdr_t;
+
+ucs_status_t ucp_worker_address_book_save(ucp_worker_h worker, const char *path)
+{
+    ucp_worker_ep_hash_bucket_t *bucket;
+    ucp_address_book_hdr_t hdr;
+    char tmp_path[PATH_MAX];
+    ucs_status_t status;
+    uint32_t length;
+    unsigned i;
+    ucp_ep_h ep;
+    FILE *fp;
+
+    hdr.magic     = UCP_ADDRESS_BOOK_MAGIC;
+    hdr.version   = UCP_ADDRESS_BOOK_VERSION;
+    hdr.num_peers = 0;
+    hdr.reserved  = 0;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    ucs_snprintf_zero(tmp_path, sizeof(tmp_path), "%s.%d", path, getpid());
+    fp = fopen(tmp_path, "w");
+    if (fp == NULL) {
+        ucs_error("failed to create address book %s: %m", tmp_path);
+        status = UCS_ERR_IO_ERROR;
+        goto out;
+    }
+
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1) {
+        goto err_write;
+    }
+
+    for (i = 0; i < worker->ep_hash.capacity; ++i) {
+        bucket = &worker->ep_hash.buckets[i];
+        if (bucket->dist == 0) {
+            continue;
+        }
+
+        ep = bucket->value;
+        if (ep->remote_address == NULL) {
+            continue; /* Address was not retained for this peer */
+        }
+
+        length = ep->remote_address_length;
+        if ((fwrite(&length, sizeof(length), 1, fp) != 1) ||
+            (fwrite(ep->remote_address, 1, length, fp) != length))
+        {
+            goto err_write;
+        }
+        ++hdr.num_peers;
+    }
+
+    /* Update the header with the actual peer count */
+    if (fseek(fp, 0, SEEK_SET) || (fwrite(&hdr, sizeof(hdr), 1, fp) != 1)) {
+        goto err_write;
+    }
+
+    fclose(fp);
+
+    /* Publish atomically, so readers see either the old or the new content */
+    if (rename(tmp_path, path)) {
+        ucs_error("failed to publish address book %s: %m", path);
+        unlink(tmp_path);
+        status = UCS_ERR_IO_ERROR;
+        goto out;
+    }
+
+    ucs_debug("worker %p: saved %u peer addresses to %s", worker,
+              hdr.num_peers, path);
+    status = UCS_OK;
+
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
+
+err_write:
+    ucs_error("failed to write address book %s: %m", tmp_path);
+    fclose(fp);
+    unlink(tmp_path);
+    status = UCS_ERR_IO_ERROR;
+    goto out;
+}
+
+ucs_status_t ucp_worker_address_book_load(ucp_worker_h worker, const char *path)
+{
+    ucp_address_t **addresses;
+    ucp_address_book_hdr_t hdr;
+    ucs_status_t status;
+    uint32_t i, count, length;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        ucs_error("failed to open address book %s: %m", path);
+        return UCS_ERR_NO_ELEM;
+    }
+
+    if ((fread(&hdr, sizeof(hdr), 1, fp) != 1) ||
+        (hdr.magic != UCP_ADDRESS_BOOK_MAGIC) ||
+        (hdr.version != UCP_ADDRESS_BOOK_VERSION))
+    {
+        ucs_error("address book %s has invalid format", path);
+        fclose(fp);
+        return UCS_ERR_NO_ELEM;
+    }
+
+    addresses = ucs_calloc(hdr.num_peers, sizeof(*addresses), "address_book");
+    if (addresses == NULL) {
+        fclose(fp);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    for (count = 0; count < hdr.num_peers; ++count) {
+        if (fread(&length, sizeof(length), 1, fp) != 1) {
+            goto err_format;
+        }
+
+        addresses[count] = ucs_malloc(length, "address_book_entry");
+        if (addresses[count] == NULL) {
+            status = UCS_ERR_NO_MEMORY;
+            goto out_free;
+        }
+
+        if (fread(addresses[count], 1, length, fp) != length) {
+            ++count; /* Release the truncated entry as well */
+            goto err_format;
+        }
+    }
+
+    fclose(fp);
+    fp = NULL;
+
+    /* Establish endpoints to all inherited peers, completing in the
+     * background like a regular warm-up */
+    status = ucp_worker_warmup(worker, hdr.num_peers,
+                               (const ucp_address_t* const*)addresses);
+    if (status == UCS_OK) {
+        ucs_debug("worker %p: connected to %u peers from %s", worker,
+                  hdr.num_peers, path);
+    }
+    goto out_free;
+
+err_format:
+    ucs_error("address book %s is truncated", path);
+    status = UCS_ERR_NO_ELEM;
+out_free:
+    for (i = 0; i < count; ++i) {
+        ucs_free(addresses[i]);
+    }
+    ucs_free(addresses);
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    return status;
 }
 
 ucs_status_t ucp_worker_get_efd(ucp_worker_h worker, int *fd)
@@ -785,31 +1491,45 @@ ucs_status_t ucp_worker_arm(ucp_worker_h worker)
 {
     int res;
     char buf;
+    int signaled;
     ucs_status_t status;
     uct_wakeup_h wakeup;
     ucp_rsc_index_t tl_id;
     ucp_context_h context = worker->context;
 
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
     for (tl_id = 0; tl_id < context->num_tls; ++tl_id) {
         wakeup = worker->wakeup.iface_wakeups[tl_id];
         if (wakeup != NULL) {
             status = uct_wakeup_efd_arm(wakeup);
             if (status != UCS_OK) {
-                return status;
+                goto out;
             }
         }
     }
 
+    /* Drain the signal pipe. Any byte found means ucp_worker_signal() was
+     * called since the last progress - the caller must progress again before
+     * sleeping, otherwise the signal would be lost */
+    signaled = 0;
     do {
         res = read(worker->wakeup.wakeup_pipe[0], &buf, 1);
+        signaled |= (res == 1);
     } while (res != -1);
 
     if (errno != EAGAIN) {
         ucs_error("Read from internal pipe failed: %m");
-        return UCS_ERR_IO_ERROR;
+        status = UCS_ERR_IO_ERROR;
+    } else if (signaled) {
+        status = UCS_ERR_BUSY;
+    } else {
+        status = UCS_OK;
     }
 
-    return UCS_OK;
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return status;
 }
 
 void ucp_worker_wait_mem(ucp_worker_h worker, void *address)
@@ -825,8 +1545,9 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
     struct epoll_event *events;
     ucp_context_h context = worker->context;
 
-    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
-
+    /* Not taking the worker lock here - ucp_worker_get_efd() and
+     * ucp_worker_arm() lock internally, and blocking in epoll_wait() while
+     * holding the lock would stall every other thread using this worker */
     status = ucp_worker_get_efd(worker, &epoll_fd);
     if (status != UCS_OK) {
         goto out;
@@ -852,7 +1573,7 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
         res = epoll_wait(epoll_fd, events, context->num_tls, -1);
     } while ((res == -1) && (errno == EINTR));
 
-    free(events);
+    ucs_free(events);
 
     if (res == -1) {
         ucs_error("Polling internally for events failed: %m");
@@ -862,7 +1583,6 @@ ucs_status_t ucp_worker_wait(ucp_worker_h worker)
 
     status = UCS_OK;
 out:
-    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     return status;
 }
 
@@ -893,6 +1613,7 @@ ucs_status_t ucp_worker_get_address(ucp_worker_h worker, ucp_address_t **address
 
     status = ucp_address_pack(worker, NULL, -1, NULL, address_length_p,
                               (void**)address_p);
+    ucs_arena_reset(&worker->ctl_arena);
 
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
 
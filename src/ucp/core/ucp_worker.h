@@ -11,11 +11,70 @@
 #include "ucp_ep.h"
 #include "ucp_thread.h"
 
+#include <ucs/datastruct/arena.h>
+#include <ucs/datastruct/mpmc.h>
+#include <ucs/datastruct/list.h>
 #include <ucs/datastruct/mpool.h>
-#include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/ohash.h>
+#include <ucs/datastruct/queue_types.h>
 #include <ucs/async/async.h>
+#include <ucs/stats/stats_shm.h>
 
-KHASH_MAP_INIT_INT64(ucp_worker_ep_hash, ucp_ep_t *);
+/* Cached wireup lane selection result, defined in wireup/select.c */
+typedef struct ucp_wireup_select_result ucp_wireup_select_result_t;
+
+UCS_OHASH_IMPL(ucp_worker_ep_hash, uint64_t, ucp_ep_t *, ucs_ohash_hash64)
+UCS_OHASH_IMPL(ucp_worker_rkey_hash, uint64_t, ucp_rkey_h, ucs_ohash_hash64)
+/**
+ * Interface-connected transport endpoint shared between lanes. Such endpoints
+ * are fully determined by the resource and the remote address, so every lane
+ * which resolves to the same pair - whether on one ucp_ep or on several -
+ * attaches to a single refcounted uct_ep instead of creating its own.
+ */
+typedef struct ucp_worker_iface_ep {
+    uct_ep_h                  uct_ep;     /* Shared transport endpoint */
+    uint64_t                  digest;     /* Digest of (resource, remote address) */
+    uint32_t                  refcount;   /* Number of lanes attached */
+    ucp_rsc_index_t           rsc_index;  /* Resource the endpoint was created on */
+    uint16_t                  addr_len;   /* Remote address length */
+    char                      addr[0];    /* Remote device+iface address copy */
+} ucp_worker_iface_ep_t;
+
+UCS_OHASH_IMPL(ucp_worker_ifep_hash, uint64_t, ucp_worker_iface_ep_t *,
+               ucs_ohash_hash64)
+UCS_OHASH_IMPL(ucp_worker_wireup_hash, uint64_t, ucp_wireup_select_result_t *,
+               ucs_ohash_hash64)
+
+/**
+ * Atomic adds to one remote address accumulated within a worker progress
+ * window, combined into a single wire atomic of the summed delta when
+ * UCX_ATOMIC_COMBINE is enabled. Keyed by the remote address.
+ */
+typedef struct ucp_amo_combine_entry {
+    ucp_ep_h                  ep;          /* Endpoint of the combined adds */
+    ucp_rkey_h                rkey;        /* Remote key of the target */
+    uint64_t                  remote_addr; /* Target address */
+    uint64_t                  value;       /* Accumulated delta (modular) */
+    uint8_t                   op_size;     /* Operand size, 4 or 8 */
+} ucp_amo_combine_entry_t;
+
+UCS_OHASH_IMPL(ucp_amo_combine_hash, uint64_t, ucp_amo_combine_entry_t,
+               ucs_ohash_hash64)
+
+/**
+ * Staging buffer of small eager tag sends to one endpoint, accumulated within
+ * a worker progress window and sent as a single EAGER_BATCH frame when
+ * UCX_TAG_COALESCE is enabled. Keyed by the endpoint pointer.
+ */
+typedef struct ucp_tag_coalesce_entry {
+    ucp_ep_h                  ep;          /* Destination endpoint */
+    size_t                    length;      /* Staged bytes */
+    unsigned                  count;       /* Staged sub-messages */
+    char                      data[0];     /* Sub-headers and payloads */
+} ucp_tag_coalesce_entry_t;
+
+UCS_OHASH_IMPL(ucp_tag_coalesce_hash, uint64_t, ucp_tag_coalesce_entry_t *,
+               ucs_ohash_hash64)
 
 
 enum {
@@ -49,23 +108,65 @@ enum {
 
     UCP_WORKER_STAT_TAG_RX_RNDV_EXP,
     UCP_WORKER_STAT_TAG_RX_RNDV_UNEXP,
+
+    /* Unexpected receive descriptors taken from the dedicated pool, and
+     * allocations which spilled over to the generic AM pool because the
+     * message was too long or the pool reached its limit */
+    UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_POOL,
+    UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_SPILL,
     UCP_WORKER_STAT_LAST
 };
 
 
+/* Payload size of a descriptor in the dedicated pool for unexpected
+ * messages. Longer messages spill over to the generic AM pool. */
+#define UCP_WORKER_UNEXP_DESC_SIZE      1024
+
+/* Limit on the number of descriptors in the dedicated pool, to bound the
+ * memory held by unexpected messages under heavy incast */
+#define UCP_WORKER_UNEXP_DESC_MAX_ELEMS 16384
+
+/* After this many consecutive progress calls without any incoming traffic,
+ * yield the CPU between polls so oversubscribed compute threads can run. The
+ * first arriving message snaps back to full-rate polling */
+#define UCP_WORKER_IDLE_STREAK_YIELD    256
+
+/* Size of the direct-mapped cache in front of the endpoint hash. Must be a
+ * power of 2 */
+#define UCP_WORKER_EP_CACHE_SIZE        16
+
+/* Chunk size of the control-path arena. Large enough for the wireup
+ * transients of a typical endpoint, so creating one endpoint does not hit
+ * the heap at all once the arena is warm */
+#define UCP_WORKER_CTL_ARENA_CHUNK      8192
+
+/* Capacity of the cross-thread operation injection ring (ucp_worker_inject).
+ * Rounded up to a power of 2 by the MPMC queue */
+#define UCP_WORKER_INJECT_RING_SIZE     1024
+
+
+/* Count into both the full statistics node (debug builds) and the always-on
+ * shared memory slot */
+#define UCP_WORKER_STAT_COUNT(_worker, _counter) \
+    { \
+        UCS_STATS_UPDATE_COUNTER((_worker)->stats, (_counter), 1); \
+        ucs_stats_shm_count((_worker)->stats_shm, (_counter), 1); \
+    }
+
 #define UCP_WORKER_STAT_EAGER_MSG(_worker, _flags) \
-    UCS_STATS_UPDATE_COUNTER((_worker)->stats, \
-                             (_flags & UCP_RECV_DESC_FLAG_SYNC) ? \
-                             UCP_WORKER_STAT_TAG_RX_EAGER_SYNC_MSG : \
-                             UCP_WORKER_STAT_TAG_RX_EAGER_MSG, 1);
+    UCP_WORKER_STAT_COUNT(_worker, \
+                          (_flags & UCP_RECV_DESC_FLAG_SYNC) ? \
+                          UCP_WORKER_STAT_TAG_RX_EAGER_SYNC_MSG : \
+                          UCP_WORKER_STAT_TAG_RX_EAGER_MSG);
 
 #define UCP_WORKER_STAT_EAGER_CHUNK(_worker, _is_exp) \
-    UCS_STATS_UPDATE_COUNTER((_worker)->stats, \
-                             UCP_WORKER_STAT_TAG_RX_EAGER_CHUNK_##_is_exp, 1);
+    UCP_WORKER_STAT_COUNT(_worker, UCP_WORKER_STAT_TAG_RX_EAGER_CHUNK_##_is_exp);
 
 #define UCP_WORKER_STAT_RNDV(_worker, _is_exp) \
-    UCS_STATS_UPDATE_COUNTER((_worker)->stats, \
-                             UCP_WORKER_STAT_TAG_RX_RNDV_##_is_exp, 1);
+    UCP_WORKER_STAT_COUNT(_worker, UCP_WORKER_STAT_TAG_RX_RNDV_##_is_exp);
+
+#define UCP_WORKER_STAT_UNEXP_DESC(_worker, _source) \
+    UCP_WORKER_STAT_COUNT(_worker, UCP_WORKER_STAT_TAG_RX_UNEXP_DESC_##_source);
 
 
 /**
@@ -87,19 +188,69 @@ typedef struct ucp_worker {
     uint64_t                      uuid;          /* Unique ID for wireup */
     uct_worker_h                  uct;           /* UCT worker handle */
     ucs_mpool_t                   req_mp;        /* Memory pool for requests */
+    ucs_mpool_t                   ep_mp;         /* Memory pool for endpoints,
+                                                    reused across connect and
+                                                    disconnect cycles */
+    ucs_queue_head_t              comp_q;        /* Requests whose completion
+                                                    callbacks are deferred */
+    ucs_mpmc_queue_t              inject_q;      /* Operations deposited by
+                                                    other threads, executed at
+                                                    the top of progress */
     ucp_worker_wakeup_t           wakeup;        /* Wakeup-related context */
     uint64_t                      atomic_tls;    /* Which resources can be used for atomics */
 
     int                           inprogress;
+    unsigned                      idle_streak;   /* Consecutive progress calls
+                                                    which found no traffic */
     char                          name[UCP_WORKER_NAME_MAX]; /* Worker name */
 
     unsigned                      stub_pend_count;/* Number of pending requests on stub endpoints*/
+    ucs_list_link_t               stub_retired;  /* Stub endpoints whose lane
+                                                    already switched to the real
+                                                    transport, awaiting
+                                                    destruction from the slow
+                                                    path */
+    int                           warmup_timer_id;/* Async timer driving background
+                                                     warm-up, -1 if inactive */
 
-    khash_t(ucp_worker_ep_hash)   ep_hash;       /* Hash table of all endpoints */
+    ucp_worker_ep_hash_t          ep_hash;       /* Hash table of all endpoints */
+    struct {
+        uint64_t                  dest_uuid;     /* Cached lookup key */
+        ucp_ep_h                  ep;            /* Cached endpoint, NULL if
+                                                    the entry is invalid */
+    }                             ep_cache[UCP_WORKER_EP_CACHE_SIZE];
+    ucp_worker_rkey_hash_t        rkey_hash;     /* Cache of unpacked remote
+                                                    keys, keyed by buffer hash */
+    ucp_worker_wireup_hash_t      wireup_hash;   /* Cache of lane selection
+                                                    results, keyed by a digest
+                                                    of the selection inputs */
+    ucp_worker_ifep_hash_t        ifep_hash;     /* Shared iface-connected
+                                                    endpoints, keyed by a digest
+                                                    of (resource, remote address) */
+    ucp_worker_ifep_hash_t        ifep_ptr_hash; /* Same entries, keyed by the
+                                                    uct_ep pointer for release */
+    ucp_amo_combine_hash_t        amo_combine;   /* Pending combined atomic
+                                                    adds, keyed by the remote
+                                                    address */
+    ucp_tag_coalesce_hash_t       tag_coalesce;  /* Pending coalesced eager
+                                                    frames, keyed by the
+                                                    endpoint pointer */
+    ucs_mpool_t                   tag_coalesce_mp; /* Pool of coalescing
+                                                      staging buffers */
+    ucs_arena_t                   ctl_arena;     /* Arena for control-path
+                                                    transients (wireup, address
+                                                    packing); reset wholesale
+                                                    when the operation ends */
     uct_iface_h                   *ifaces;       /* Array of interfaces, one for each resource */
     uct_iface_attr_t              *iface_attrs;  /* Array of interface attributes */
+    uct_iface_h                   tm_offload_iface; /* Interface with HW tag matching,
+                                                       or NULL */
+    const uct_iface_attr_t        *tm_offload_iface_attr;
     ucs_mpool_t                   am_mp;         /* Memory pool for AM receives */
+    ucs_mpool_t                   rdesc_mp;      /* Bounded memory pool for small
+                                                    unexpected receive descriptors */
     UCS_STATS_NODE_DECLARE(stats);
+    ucs_stats_shm_slot_t          *stats_shm;    /* Always-on counters slot */
     unsigned                      ep_config_max; /* Maximal number of configurations */
     unsigned                      ep_config_count; /* Current number of configurations */
     ucp_mt_lock_t                 mt_lock; /* All configurations about multithreading support */
@@ -114,6 +265,56 @@ ucp_request_t *ucp_worker_allocate_reply(ucp_worker_h worker, uint64_t dest_uuid
 unsigned ucp_worker_get_ep_config(ucp_worker_h worker,
                                   const ucp_ep_config_key_t *key);
 
+ucs_status_t ucp_worker_iface_ep_get(ucp_worker_h worker,
+                                     ucp_rsc_index_t rsc_index,
+                                     const uct_device_addr_t *dev_addr,
+                                     size_t dev_addr_len,
+                                     const uct_iface_addr_t *iface_addr,
+                                     size_t iface_addr_len, uct_ep_h *ep_p);
+
+int ucp_worker_iface_ep_put(ucp_worker_h worker, uct_ep_h uct_ep);
+
+/**
+ * Try to absorb an atomic add into the pending combine table, to be issued as
+ * part of a single summed atomic at the next drain point.
+ *
+ * @return Nonzero if the add was absorbed, 0 if the caller must issue it
+ *         directly (table full, or flushing a colliding entry failed).
+ */
+int ucp_worker_amo_combine(ucp_worker_h worker, ucp_ep_h ep, ucp_rkey_h rkey,
+                           uint64_t remote_addr, uint64_t value, size_t op_size);
+
+/**
+ * Issue all pending combined atomic adds. If @a block is nonzero, progress the
+ * worker until every entry is on the wire; otherwise entries which hit
+ * UCS_ERR_NO_RESOURCE stay pending for the next drain.
+ */
+void ucp_worker_amo_combine_drain(ucp_worker_h worker, int block);
+
+/**
+ * Try to absorb a small eager tag send into the endpoint's coalescing buffer,
+ * to go on the wire as part of one multi-message frame at the next drain
+ * point. An absorbed message is complete from the caller's point of view.
+ *
+ * @return Nonzero if the message was absorbed, 0 if the caller must send it
+ *         directly (message too large, or no staging buffer available).
+ */
+int ucp_tag_coalesce_push(ucp_worker_h worker, ucp_ep_h ep, ucp_tag_t tag,
+                          const void *buffer, size_t length);
+
+/**
+ * Send the coalesced frame staged for @a ep, if any. If @a block is nonzero,
+ * progress the worker until the frame is on the wire; otherwise a frame which
+ * hits UCS_ERR_NO_RESOURCE stays pending for the next drain.
+ */
+void ucp_tag_coalesce_flush_ep(ucp_worker_h worker, ucp_ep_h ep, int block);
+
+/**
+ * Send all staged coalesced frames, with the same blocking semantics as
+ * ucp_tag_coalesce_flush_ep().
+ */
+void ucp_tag_coalesce_drain(ucp_worker_h worker, int block);
+
 static inline const char* ucp_worker_get_name(ucp_worker_h worker)
 {
     return worker->name;
@@ -121,14 +322,35 @@ static inline const char* ucp_worker_get_name(ucp_worker_h worker)
 
 static inline ucp_ep_h ucp_worker_ep_find(ucp_worker_h worker, uint64_t dest_uuid)
 {
-    khiter_t hash_it;
+    unsigned cache_idx = dest_uuid % UCP_WORKER_EP_CACHE_SIZE;
+    ucp_ep_h *ep_p, ep;
+
+    /* Direct-mapped cache of recent lookups, so repeated messages from the
+     * same peer do not walk the hash table */
+    if (ucs_likely((worker->ep_cache[cache_idx].ep != NULL) &&
+                   (worker->ep_cache[cache_idx].dest_uuid == dest_uuid))) {
+        return worker->ep_cache[cache_idx].ep;
+    }
 
-    hash_it = kh_get(ucp_worker_ep_hash, &worker->ep_hash, dest_uuid);
-    if (ucs_unlikely(hash_it == kh_end(&worker->ep_hash))) {
+    ep_p = ucp_worker_ep_hash_get(&worker->ep_hash, dest_uuid);
+    if (ucs_unlikely(ep_p == NULL)) {
         return NULL;
     }
 
-    return kh_value(&worker->ep_hash, hash_it);
+    ep = *ep_p;
+    worker->ep_cache[cache_idx].dest_uuid = dest_uuid;
+    worker->ep_cache[cache_idx].ep        = ep;
+    return ep;
+}
+
+static inline void ucp_worker_ep_cache_invalidate(ucp_worker_h worker,
+                                                  uint64_t dest_uuid)
+{
+    unsigned cache_idx = dest_uuid % UCP_WORKER_EP_CACHE_SIZE;
+
+    if (worker->ep_cache[cache_idx].dest_uuid == dest_uuid) {
+        worker->ep_cache[cache_idx].ep = NULL;
+    }
 }
 
 #endif
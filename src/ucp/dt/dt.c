@@ -7,6 +7,16 @@
 #include "dt.h"
 
 
+/*
+ * Pack the next @a length bytes of a non-contiguous buffer into @a dest.
+ *
+ * This is invoked from inside uct_ep_am_bcopy() pack callbacks, with @a dest
+ * pointing into the transport-provided segment - so every datatype, including
+ * iov, strided and generic, is packed straight onto the wire buffer with a
+ * single copy. Callers must not stage the data through a scratch buffer
+ * first (the pipelined rendezvous path does, deliberately, to overlap the
+ * generic pack callback with wire time).
+ */
 size_t ucp_dt_pack(ucp_datatype_t datatype, void *dest, const void *src,
                    ucp_dt_state_t *state, size_t length)
 {
@@ -23,6 +33,12 @@ size_t ucp_dt_pack(ucp_datatype_t datatype, void *dest, const void *src,
         result_len = length;
         break;
 
+    case UCP_DATATYPE_STRIDED:
+        UCS_PROFILE_CALL_VOID(ucp_dt_strided_gather, dest, src,
+                              ucp_dt_strided(datatype), length, state->offset);
+        result_len = length;
+        break;
+
     case UCP_DATATYPE_IOV:
         UCS_PROFILE_CALL_VOID(ucp_dt_iov_gather, dest, src, length,
                               &state->dt.iov.iov_offset,
@@ -9,6 +9,7 @@
 #define UCP_DT_H_
 
 #include "dt_contig.h"
+#include "dt_strided.h"
 #include "dt_iov.h"
 #include "dt_generic.h"
 
@@ -26,6 +27,9 @@ typedef struct ucp_dt_state {
         struct {
             uct_mem_h             memh;
         } contig;
+        struct {
+            uct_mem_h             memh;           /* Covers the whole span */
+        } strided;
         struct {
             size_t                iov_offset;     /* Offset in the IOV item */
             size_t                iovcnt_offset;  /* The IOV item to start copy */
@@ -52,6 +56,9 @@ size_t ucp_dt_length(ucp_datatype_t datatype, size_t count,
     case UCP_DATATYPE_CONTIG:
         return ucp_contig_dt_length(datatype, count);
 
+    case UCP_DATATYPE_STRIDED:
+        return ucp_dt_strided_length(ucp_dt_strided(datatype), count);
+
     case UCP_DATATYPE_IOV:
         ucs_assert(NULL != iov);
         return ucp_dt_iov_length(iov, count);
@@ -96,6 +103,12 @@ ucp_dt_unpack(ucp_datatype_t datatype, void *buffer, size_t buffer_size,
                                recv_data, recv_length);
         return UCS_OK;
 
+    case UCP_DATATYPE_STRIDED:
+        UCS_PROFILE_CALL_VOID(ucp_dt_strided_scatter, buffer,
+                              ucp_dt_strided(datatype), recv_data, recv_length,
+                              offset);
+        return UCS_OK;
+
     case UCP_DATATYPE_IOV:
         UCS_PROFILE_CALL(ucp_dt_iov_scatter, buffer, state->dt.iov.iovcnt,
                          recv_data, recv_length, &state->dt.iov.iov_offset,
@@ -5,6 +5,7 @@
  */
 #include "dt_iov.h"
 
+#include <ucs/arch/cpu.h>
 #include <ucs/debug/log.h>
 #include <ucs/sys/math.h>
 
@@ -12,11 +13,47 @@
 #include <unistd.h>
 
 
+/* Above this total size, a gather/scatter would displace a large share of a
+ * typical last-level cache, and the copied data is handed to the transport
+ * rather than read back by the CPU - so stream it with non-temporal stores. */
+#define UCP_DT_IOV_BULK_THRESH    UCS_MBYTE
+
+
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_iov_copy(void *dest, const void *src, size_t length, int bulk)
+{
+    if (bulk && (length >= UCS_ARCH_CACHE_LINE_SIZE)) {
+        ucs_arch_memcpy_nontemporal(dest, src, length);
+        return;
+    }
+
+    /* fixed-size cases compile to straight (vector) move sequences for the
+     * common power-of-two segment sizes of strided layouts */
+    switch (length) {
+    case 64:
+        memcpy(dest, src, 64);
+        break;
+    case 128:
+        memcpy(dest, src, 128);
+        break;
+    case 256:
+        memcpy(dest, src, 256);
+        break;
+    case 512:
+        memcpy(dest, src, 512);
+        break;
+    default:
+        memcpy(dest, src, length);
+        break;
+    }
+}
+
 void ucp_dt_iov_gather(void *dest, const ucp_dt_iov_t *iov, size_t length,
                        size_t *iov_offset, size_t *iovcnt_offset)
 {
     size_t item_len, item_reminder, item_len_to_copy;
     size_t length_it = 0;
+    int bulk         = length >= UCP_DT_IOV_BULK_THRESH;
 
     ucs_assert(length > 0);
     while (length_it < length) {
@@ -25,8 +62,9 @@ void ucp_dt_iov_gather(void *dest, const ucp_dt_iov_t *iov, size_t length,
 
         item_len_to_copy = item_reminder -
                            ucs_max((ssize_t)((length_it + item_reminder) - length), 0);
-        memcpy(dest + length_it, iov[*iovcnt_offset].buffer + *iov_offset,
-               item_len_to_copy);
+        ucp_dt_iov_copy(dest + length_it,
+                        iov[*iovcnt_offset].buffer + *iov_offset,
+                        item_len_to_copy, bulk);
         length_it += item_len_to_copy;
 
         ucs_assert(length_it <= length);
@@ -44,6 +82,7 @@ size_t ucp_dt_iov_scatter(ucp_dt_iov_t *iov, size_t iovcnt, const void *src,
 {
     size_t item_len, item_len_to_copy;
     size_t length_it = 0;
+    int bulk         = length >= UCP_DT_IOV_BULK_THRESH;
 
     while ((length_it < length) && (*iovcnt_offset < iovcnt)) {
         item_len         = iov[*iovcnt_offset].length;
@@ -51,8 +90,8 @@ size_t ucp_dt_iov_scatter(ucp_dt_iov_t *iov, size_t iovcnt, const void *src,
                                    length - length_it);
         ucs_assert(*iov_offset <= item_len);
 
-        memcpy(iov[*iovcnt_offset].buffer + *iov_offset, src + length_it,
-               item_len_to_copy);
+        ucp_dt_iov_copy(iov[*iovcnt_offset].buffer + *iov_offset,
+                        src + length_it, item_len_to_copy, bulk);
         length_it += item_len_to_copy;
 
         ucs_assert(length_it <= length);
@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "dt_strided.h"
+
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+
+#include <string.h>
+
+
+ucs_status_t ucp_dt_create_strided(size_t block_length, size_t stride,
+                                   size_t count, size_t outer_stride,
+                                   size_t outer_count,
+                                   ucp_datatype_t *datatype_p)
+{
+    ucp_dt_strided_t *dt;
+
+    if ((block_length == 0) || (count == 0) || (outer_count == 0) ||
+        (stride < block_length) ||
+        ((outer_count > 1) && (outer_stride < count * stride)))
+    {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    dt = ucs_memalign(UCS_BIT(UCP_DATATYPE_SHIFT), sizeof(*dt), "strided_dt");
+    if (dt == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    dt->block_length = block_length;
+    dt->stride       = stride;
+    dt->count        = count;
+    dt->outer_stride = (outer_count > 1) ? outer_stride : count * stride;
+    dt->outer_count  = outer_count;
+    dt->length       = block_length * count * outer_count;
+    dt->extent       = dt->outer_stride * outer_count;
+
+    *datatype_p = ((uintptr_t)dt) | UCP_DATATYPE_STRIDED;
+    return UCS_OK;
+}
+
+void ucp_dt_strided_gather(void *dest, const void *src,
+                           const ucp_dt_strided_t *dt, size_t length,
+                           size_t offset)
+{
+    size_t elem, row, blk, within, copy_length;
+    size_t length_it = 0;
+
+    ucs_assert(length > 0);
+    ucp_dt_strided_seek(dt, offset, &elem, &row, &blk, &within);
+    while (length_it < length) {
+        copy_length = ucs_min(dt->block_length - within, length - length_it);
+        memcpy(dest + length_it,
+               src + ucp_dt_strided_block_offset(dt, elem, row, blk) + within,
+               copy_length);
+        length_it += copy_length;
+        within     = 0;
+        ucp_dt_strided_advance(dt, &elem, &row, &blk);
+    }
+}
+
+void ucp_dt_strided_scatter(void *dest, const ucp_dt_strided_t *dt,
+                            const void *src, size_t length, size_t offset)
+{
+    size_t elem, row, blk, within, copy_length;
+    size_t length_it = 0;
+
+    ucp_dt_strided_seek(dt, offset, &elem, &row, &blk, &within);
+    while (length_it < length) {
+        copy_length = ucs_min(dt->block_length - within, length - length_it);
+        memcpy(dest + ucp_dt_strided_block_offset(dt, elem, row, blk) + within,
+               src + length_it, copy_length);
+        length_it += copy_length;
+        within     = 0;
+        ucp_dt_strided_advance(dt, &elem, &row, &blk);
+    }
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+
+#ifndef UCP_DT_STRIDED_H_
+#define UCP_DT_STRIDED_H_
+
+#include <ucp/api/ucp.h>
+#include <ucs/debug/log.h>
+
+
+/**
+ * Strided datatype structure.
+ *
+ * Describes a regular layout of equal-size contiguous blocks: @a count blocks
+ * of @a block_length bytes, each @a stride bytes apart. A second dimension
+ * (@a outer_count rows, @a outer_stride bytes apart) allows expressing 2D
+ * halos; a flat stride has outer_count == 1.
+ */
+typedef struct ucp_dt_strided {
+    size_t                   block_length;  /* Bytes in every contiguous block */
+    size_t                   stride;        /* Distance between block starts */
+    size_t                   count;         /* Number of blocks in a row */
+    size_t                   outer_stride;  /* Distance between row starts */
+    size_t                   outer_count;   /* Number of rows */
+    size_t                   length;        /* Total payload of one element */
+    size_t                   extent;        /* Distance between consecutive
+                                               elements of this datatype */
+} ucp_dt_strided_t;
+
+
+#define UCP_DT_IS_STRIDED(_datatype) \
+          (((_datatype) & UCP_DATATYPE_CLASS_MASK) == UCP_DATATYPE_STRIDED)
+
+
+static inline ucp_dt_strided_t* ucp_dt_strided(ucp_datatype_t datatype)
+{
+    return (ucp_dt_strided_t*)(void*)(datatype & ~UCP_DATATYPE_CLASS_MASK);
+}
+
+/**
+ * Get the total length of the data described by @a count strided elements
+ */
+static inline size_t ucp_dt_strided_length(const ucp_dt_strided_t *dt,
+                                           size_t count)
+{
+    return count * dt->length;
+}
+
+/**
+ * Get the memory span of one strided element, from the first byte of the
+ * first block to the last byte of the last block
+ */
+static inline size_t ucp_dt_strided_span(const ucp_dt_strided_t *dt)
+{
+    return ((dt->outer_count - 1) * dt->outer_stride) +
+           ((dt->count - 1) * dt->stride) + dt->block_length;
+}
+
+/*
+ * Convert a payload offset to a position in the strided layout. The layout is
+ * regular, so the position is a pure function of the offset - this is what
+ * allows the pack state to be a single offset, and multiple fragments to be
+ * built without walking a descriptor list.
+ */
+static inline void ucp_dt_strided_seek(const ucp_dt_strided_t *dt, size_t offset,
+                                       size_t *elem, size_t *row, size_t *blk,
+                                       size_t *within)
+{
+    size_t row_length = dt->block_length * dt->count;
+
+    *elem   = offset / dt->length;
+    offset %= dt->length;
+    *row    = offset / row_length;
+    offset %= row_length;
+    *blk    = offset / dt->block_length;
+    *within = offset % dt->block_length;
+}
+
+/*
+ * Advance a position in the strided layout to the start of the next block
+ */
+static inline void ucp_dt_strided_advance(const ucp_dt_strided_t *dt,
+                                          size_t *elem, size_t *row,
+                                          size_t *blk)
+{
+    if (++(*blk) == dt->count) {
+        *blk = 0;
+        if (++(*row) == dt->outer_count) {
+            *row = 0;
+            ++(*elem);
+        }
+    }
+}
+
+/*
+ * Offset in memory, relative to the base address, of a block position
+ */
+static inline size_t ucp_dt_strided_block_offset(const ucp_dt_strided_t *dt,
+                                                 size_t elem, size_t row,
+                                                 size_t blk)
+{
+    return (elem * dt->extent) + (row * dt->outer_stride) + (blk * dt->stride);
+}
+
+/**
+ * Copy strided data from @a src to contiguous buffer @a dest, starting at
+ * payload offset @a offset of the strided layout
+ *
+ * @param [in]  dest     Destination contiguous buffer
+ * @param [in]  src      Base address of the strided data
+ * @param [in]  dt       Strided datatype descriptor
+ * @param [in]  length   Total data length to copy in bytes
+ * @param [in]  offset   Payload offset to start copying from. Unlike iov,
+ *                       the position in memory is computed from the offset,
+ *                       so no auxiliary state is needed.
+ */
+void ucp_dt_strided_gather(void *dest, const void *src,
+                           const ucp_dt_strided_t *dt, size_t length,
+                           size_t offset);
+
+/**
+ * Copy contiguous buffer @a src into strided data at @a dest, starting at
+ * payload offset @a offset of the strided layout
+ *
+ * @param [in]  dest     Base address of the strided data
+ * @param [in]  dt       Strided datatype descriptor
+ * @param [in]  src      Source contiguous buffer
+ * @param [in]  length   Total data length to copy in bytes
+ * @param [in]  offset   Payload offset to start copying to
+ */
+void ucp_dt_strided_scatter(void *dest, const ucp_dt_strided_t *dt,
+                            const void *src, size_t length, size_t offset);
+
+
+#endif
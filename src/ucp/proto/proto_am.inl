@@ -13,15 +13,53 @@
 typedef void (*ucp_req_complete_func_t)(ucp_request_t *req);
 
 
+/*
+ * Resumable pending state. A multi-fragment send which fails with
+ * UCS_ERR_NO_RESOURCE is parked on the pending queue with send.state intact,
+ * so the next dispatch continues from send.state.offset instead of repacking
+ * data which was already sent. Around each fragment attempt we save and, on
+ * failure, restore only the fields the pack callbacks may mutate - copying
+ * the whole ucp_dt_state_t on every fragment is measurable overhead under
+ * sustained backpressure.
+ */
+typedef struct ucp_dt_resume_state {
+    size_t                        offset;         /* send.state.offset */
+    size_t                        iov_offset;     /* IOV datatype only */
+    size_t                        iovcnt_offset;  /* IOV datatype only */
+} ucp_dt_resume_state_t;
+
+
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_resume_state_save(const ucp_dt_state_t *state, ucp_datatype_t datatype,
+                         ucp_dt_resume_state_t *resume)
+{
+    /* the iov fields are saved unconditionally - reading them is harmless for
+     * other datatypes, and it keeps the fast path branchless */
+    resume->offset        = state->offset;
+    resume->iov_offset    = state->dt.iov.iov_offset;
+    resume->iovcnt_offset = state->dt.iov.iovcnt_offset;
+}
+
+static UCS_F_ALWAYS_INLINE void
+ucp_dt_resume_state_restore(const ucp_dt_resume_state_t *resume,
+                            ucp_datatype_t datatype, ucp_dt_state_t *state)
+{
+    state->offset = resume->offset;
+    if (UCP_DT_IS_IOV(datatype)) {
+        state->dt.iov.iov_offset    = resume->iov_offset;
+        state->dt.iov.iovcnt_offset = resume->iovcnt_offset;
+    }
+}
+
 static UCS_F_ALWAYS_INLINE ucs_status_t
-ucp_do_am_bcopy_single(uct_pending_req_t *self, uint8_t am_id,
-                       uct_pack_callback_t pack_cb)
+ucp_do_am_bcopy_single_lane(uct_pending_req_t *self, uint8_t am_id,
+                            ucp_lane_index_t lane, uct_pack_callback_t pack_cb)
 {
     ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
     ucp_ep_t *ep       = req->send.ep;
     ssize_t packed_len;
 
-    req->send.lane = ucp_ep_get_am_lane(ep);
+    req->send.lane = lane;
     packed_len     = uct_ep_am_bcopy(ep->uct_eps[req->send.lane], am_id, pack_cb, req);
     if (packed_len < 0) {
         return packed_len;
@@ -30,6 +68,17 @@ ucp_do_am_bcopy_single(uct_pending_req_t *self, uint8_t am_id,
     return UCS_OK;
 }
 
+static UCS_F_ALWAYS_INLINE ucs_status_t
+ucp_do_am_bcopy_single(uct_pending_req_t *self, uint8_t am_id,
+                       uct_pack_callback_t pack_cb)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+
+    return ucp_do_am_bcopy_single_lane(self, am_id,
+                                       ucp_ep_get_am_lane(req->send.ep),
+                                       pack_cb);
+}
+
 static UCS_F_ALWAYS_INLINE
 ucs_status_t ucp_do_am_bcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
                                    uint8_t am_id_middle, uint8_t am_id_last,
@@ -44,9 +93,9 @@ ucs_status_t ucp_do_am_bcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
     ssize_t packed_len;
     uct_ep_h uct_ep;
     size_t offset;
-    ucp_dt_state_t saved_state;
+    ucp_dt_resume_state_t saved_state;
 
-    saved_state    = req->send.state;
+    ucp_dt_resume_state_save(&req->send.state, req->send.datatype, &saved_state);
     offset         = req->send.state.offset;
     req->send.lane = ucp_ep_get_am_lane(ep);
     uct_ep         = ep->uct_eps[req->send.lane];
@@ -84,7 +133,10 @@ ucs_status_t ucp_do_am_bcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
     }
 
 err:
-    req->send.state = saved_state; /* need to restore the offsets state */
+    /* restore the offsets state; the request keeps it while parked on the
+     * pending queue and resumes from here on the next dispatch */
+    ucp_dt_resume_state_restore(&saved_state, req->send.datatype,
+                                &req->send.state);
     return packed_len;
 }
 
@@ -94,6 +146,8 @@ size_t ucp_dt_iov_copy_uct(uct_iov_t *iov, size_t *iovcnt, size_t max_dst_iov,
                            ucp_datatype_t datatype, size_t length_max)
 {
     size_t iov_offset, max_src_iov, src_it, dst_it;
+    size_t elem, row, blk, within;
+    const ucp_dt_strided_t *dt_strided;
     const uct_mem_h *memh;
     size_t length_it = 0;
 
@@ -108,6 +162,31 @@ size_t ucp_dt_iov_copy_uct(uct_iov_t *iov, size_t *iovcnt, size_t max_dst_iov,
         *iovcnt   = 1;
         length_it = iov[0].length;
         break;
+    case UCP_DATATYPE_STRIDED:
+        /* every contiguous block becomes one uct iov entry; the position is
+         * derived from the overall offset, which the caller advances */
+        dt_strided = ucp_dt_strided(datatype);
+        ucp_dt_strided_seek(dt_strided, state->offset, &elem, &row, &blk,
+                            &within);
+        dst_it = 0;
+        while ((dst_it < max_dst_iov) && (length_it < length_max)) {
+            iov[dst_it].buffer = (void *)src_iov +
+                                 ucp_dt_strided_block_offset(dt_strided, elem,
+                                                             row, blk) + within;
+            iov[dst_it].length = ucs_min(dt_strided->block_length - within,
+                                         length_max - length_it);
+            iov[dst_it].memh   = state->dt.strided.memh;
+            iov[dst_it].stride = 0;
+            iov[dst_it].count  = 1;
+            length_it         += iov[dst_it].length;
+
+            ++dst_it;
+            within = 0;
+            ucp_dt_strided_advance(dt_strided, &elem, &row, &blk);
+        }
+
+        *iovcnt = dst_it;
+        break;
     case UCP_DATATYPE_IOV:
         memh                        = state->dt.iov.memh;
         iov_offset                  = state->dt.iov.iov_offset;
@@ -156,10 +235,10 @@ ucs_status_t ucp_do_am_zcopy_single(uct_pending_req_t *self, uint8_t am_id,
     size_t max_iov     = ucp_ep_config(ep)->am.max_iovcnt;
     uct_iov_t *iov     = ucs_alloca(max_iov * sizeof(uct_iov_t));
     size_t iovcnt      = 0;
-    ucp_dt_state_t saved_state;
+    ucp_dt_resume_state_t saved_state;
     ucs_status_t status;
 
-    saved_state    = req->send.state;
+    ucp_dt_resume_state_save(&req->send.state, req->send.datatype, &saved_state);
     req->send.lane = ucp_ep_get_am_lane(ep);
 
     ucp_dt_iov_copy_uct(iov, &iovcnt, max_iov, &req->send.state, req->send.buffer,
@@ -170,7 +249,9 @@ ucs_status_t ucp_do_am_zcopy_single(uct_pending_req_t *self, uint8_t am_id,
     if (status == UCS_OK) {
         complete(req);
     } else if (status < 0) {
-        req->send.state = saved_state; /* need to restore the offsets state */
+        /* need to restore the offsets state */
+        ucp_dt_resume_state_restore(&saved_state, req->send.datatype,
+                                    &req->send.state);
         return status;
     } else {
         ucs_assert(status == UCS_INPROGRESS);
@@ -194,12 +275,12 @@ ucs_status_t ucp_do_am_zcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
     ucp_dt_state_t *state = &req->send.state;
     unsigned flag_iov_mid   = 0;
     size_t iovcnt           = 0;
-    ucp_dt_state_t saved_state;
+    ucp_dt_resume_state_t saved_state;
     size_t offset, length_it;
     ucs_status_t status;
     uct_ep_h uct_ep;
 
-    saved_state             = req->send.state;
+    ucp_dt_resume_state_save(state, req->send.datatype, &saved_state);
     offset                  = state->offset;
     req->send.lane          = ucp_ep_get_am_lane(ep);
     uct_ep                  = ep->uct_eps[req->send.lane];
@@ -209,6 +290,14 @@ ucs_status_t ucp_do_am_zcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
         /* This flag should guarantee middle stage usage if iovcnt exceeded */
         flag_iov_mid = ((state->dt.iov.iovcnt_offset + max_iov) <
                         state->dt.iov.iovcnt);
+    } else if (UCP_DT_IS_STRIDED(req->send.datatype)) {
+        /* same, counting blocks - each block takes one iov entry, and the
+         * payload offset advances by block_length per block */
+        flag_iov_mid = (((state->offset /
+                          ucp_dt_strided(req->send.datatype)->block_length) +
+                         max_iov) <
+                        (req->send.length /
+                         ucp_dt_strided(req->send.datatype)->block_length));
     }
 
     if (offset == 0) {
@@ -265,6 +354,8 @@ ucs_status_t ucp_do_am_zcopy_multi(uct_pending_req_t *self, uint8_t am_id_first,
     }
 
 err:
-    req->send.state = saved_state; /* need to restore the offsets state */
+    /* restore the offsets state; the request keeps it while parked on the
+     * pending queue and resumes from here on the next dispatch */
+    ucp_dt_resume_state_restore(&saved_state, req->send.datatype, state);
     return status;
 }
@@ -40,6 +40,9 @@
  *  send_completed;cb called;req free(ooops);
  *  next_partial_send; (oops req already freed)
  */
+static void ucp_rma_request_put_ack_init(ucp_request_t *req);
+static ucs_status_t ucp_progress_put_notify_fin(uct_pending_req_t *self);
+
 static UCS_F_ALWAYS_INLINE ucs_status_t
 ucp_rma_request_advance(ucp_request_t *req, ssize_t frag_length,
                         ucs_status_t status)
@@ -47,16 +50,28 @@ ucp_rma_request_advance(ucp_request_t *req, ssize_t frag_length,
     if (ucs_likely((status == UCS_OK) || (status == UCS_INPROGRESS))) {
         req->send.length -= frag_length;
         if (req->send.length == 0) {
+            if (ucs_unlikely(req->send.rma.notify)) {
+                /* The whole payload was posted - chase it with the
+                 * notification write on the same lane */
+                req->send.uct.func = ucp_progress_put_notify_fin;
+                return UCS_INPROGRESS;
+            }
             /* bcopy is the fast path */
             if (ucs_likely(req->send.uct_comp.count == 0)) {
-                if (ucs_unlikely(req->send.state.dt.contig.memh != 
+                if (ucs_unlikely(req->send.state.dt.contig.memh !=
                                  UCT_MEM_HANDLE_NULL)) {
                     ucp_request_send_buffer_dereg(req, req->send.lane);
                 }
+                if (ucs_unlikely(req->send.rma.remote_comp)) {
+                    /* The data is on the wire - keep driving the request to
+                     * read back the delivery acknowledgement */
+                    ucp_rma_request_put_ack_init(req);
+                    return UCS_INPROGRESS;
+                }
                 ucp_request_complete_send(req, UCS_OK);
             }
             return UCS_OK;
-        } 
+        }
         req->send.buffer          += frag_length;
         req->send.rma.remote_addr += frag_length;
         return UCS_INPROGRESS;
@@ -65,13 +80,47 @@ ucp_rma_request_advance(ucp_request_t *req, ssize_t frag_length,
     }
 }
 
+static ucs_status_t ucp_progress_put_ack(uct_pending_req_t *self);
+
+/* All fragments are sent and locally completed - release the registration,
+ * and either complete the request or start the delivery read-back */
+static void ucp_rma_request_send_done(ucp_request_t *req)
+{
+    ucs_status_t status;
+
+    if (ucs_unlikely(req->send.state.dt.contig.memh != UCT_MEM_HANDLE_NULL)) {
+        ucp_request_send_buffer_dereg(req, req->send.lane);
+    }
+
+    if (ucs_likely(!req->send.rma.remote_comp)) {
+        ucp_request_complete_send(req, UCS_OK);
+        return;
+    }
+
+    /* Nobody is driving the request anymore, so push the acknowledgement
+     * reads ourselves, falling back to the pending queue on no-resource */
+    ucp_rma_request_put_ack_init(req);
+    for (;;) {
+        status = ucp_progress_put_ack(&req->send.uct);
+        if (status != UCS_ERR_NO_RESOURCE) {
+            break;
+        }
+        if (ucp_request_pending_add(req, &status)) {
+            if (status != UCS_INPROGRESS) {
+                ucp_request_complete_send(req, status);
+            }
+            break;
+        }
+    }
+}
+
 static void ucp_rma_request_bcopy_completion(uct_completion_t *self,
                                              ucs_status_t status)
 {
     ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct_comp);
 
-    if (ucs_likely(req->send.length == 0)) {
-        ucp_request_complete_send(req, UCS_OK);
+    if (ucs_likely(req->send.length == 0) && !req->send.rma.notify) {
+        ucp_rma_request_send_done(req);
     }
 }
 
@@ -80,9 +129,8 @@ static void ucp_rma_request_zcopy_completion(uct_completion_t *self,
 {
     ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct_comp);
 
-    if (ucs_likely(req->send.length == 0)) {
-        ucp_request_send_buffer_dereg(req, req->send.lane);
-        ucp_request_complete_send(req, UCS_OK);
+    if (ucs_likely(req->send.length == 0) && !req->send.rma.notify) {
+        ucp_rma_request_send_done(req);
     }
 }
 
@@ -98,6 +146,9 @@ ucp_rma_request_init(ucp_request_t *req, ucp_ep_h ep, const void *buffer,
     req->send.length          = length;
     req->send.rma.remote_addr = remote_addr;
     req->send.rma.rkey        = rkey;
+    req->send.rma.rail        = 0;
+    req->send.rma.remote_comp = 0;
+    req->send.rma.notify      = 0;
     req->send.uct.func        = cb;
     req->send.lane            = rkey->cache.rma_lane;
     req->send.uct_comp.count  = 0; 
@@ -114,18 +165,148 @@ ucp_rma_request_init(ucp_request_t *req, ucp_ep_h ep, const void *buffer,
     }
 }
 
+/* Pick the lane for the next fragment. Multi-fragment operations alternate
+ * between the interchangeable rails of the rkey (e.g. two ports of the same
+ * HCA), so a large transfer is striped across them. A fragment which fails
+ * with NO_RESOURCE is retried on the next rail. */
+static UCS_F_ALWAYS_INLINE ucp_lane_index_t
+ucp_rma_request_next_lane(ucp_request_t *req, ucp_rkey_h rkey)
+{
+    if (ucs_likely(rkey->cache.num_rma_rails <= 1) || req->send.rma.notify) {
+        /* Notified puts stay on one lane to keep write ordering */
+        return req->send.lane;
+    }
+    return rkey->cache.rma_rails[req->send.rma.rail++ %
+                                 rkey->cache.num_rma_rails];
+}
+
+static void ucp_rma_request_put_ack_completion(uct_completion_t *self,
+                                               ucs_status_t status)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct_comp);
+    ucp_rkey_h rkey    = req->send.rma.rkey;
+
+    if (req->send.rma.rail < ucs_max(rkey->cache.num_rma_rails, 1)) {
+        /* Reads on the remaining rails were not issued yet - the pending
+         * callback will issue them and complete the request */
+        return;
+    }
+    ucp_request_complete_send(req, status);
+}
+
+/*
+ * Read back the last byte of the put on every rail which may have carried a
+ * fragment. The read is ordered after the preceding writes on the same
+ * transport endpoint, and is responded from the target memory - so its
+ * completion guarantees the data was delivered remotely, without draining
+ * unrelated operations the way a full endpoint flush does.
+ */
+static ucs_status_t ucp_progress_put_ack(uct_pending_req_t *self)
+{
+    ucp_request_t *req         = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_t *ep               = req->send.ep;
+    ucp_rkey_h rkey            = req->send.rma.rkey;
+    ucp_lane_index_t num_rails = ucs_max(rkey->cache.num_rma_rails, 1);
+    ucp_lane_index_t lane;
+    ucs_status_t status;
+
+    ucs_assert(rkey->cache.ep_cfg_index == ep->cfg_index);
+
+    while (req->send.rma.rail < num_rails) {
+        lane = (num_rails == 1) ? req->send.lane :
+               rkey->cache.rma_rails[req->send.rma.rail];
+
+        ++req->send.uct_comp.count;
+        status = UCS_PROFILE_CALL(uct_ep_get_bcopy,
+                                  ep->uct_eps[lane],
+                                  (uct_unpack_callback_t)memcpy,
+                                  &req->send.rma.ack, 1,
+                                  req->send.rma.remote_addr - 1,
+                                  rkey->cache.rma_rkey,
+                                  &req->send.uct_comp);
+        if (status == UCS_INPROGRESS) {
+            ++req->send.rma.rail;
+        } else if (status == UCS_OK) {
+            /* The read completed inline, so delivery is already confirmed */
+            --req->send.uct_comp.count;
+            ++req->send.rma.rail;
+        } else {
+            --req->send.uct_comp.count;
+            if (status == UCS_ERR_NO_RESOURCE) {
+                req->send.lane = lane; /* Pending queue for the retry */
+                return UCS_ERR_NO_RESOURCE;
+            }
+            ucp_request_complete_send(req, status);
+            return UCS_OK;
+        }
+    }
+
+    if (req->send.uct_comp.count == 0) {
+        ucp_request_complete_send(req, UCS_OK);
+    }
+    return UCS_OK;
+}
+
+static void ucp_rma_request_put_ack_init(ucp_request_t *req)
+{
+    req->send.rma.rail      = 0;
+    req->send.uct.func      = ucp_progress_put_ack;
+    req->send.uct_comp.func = ucp_rma_request_put_ack_completion;
+}
+
+/*
+ * Final stage of a notified put: write the 8-byte notification behind the
+ * payload. Every payload fragment was posted on req->send.lane, and the
+ * transport delivers writes on one endpoint in order - so the target observes
+ * the notification only after the whole payload, with no fence or flush in
+ * between.
+ */
+static ucs_status_t ucp_progress_put_notify_fin(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_t *ep       = req->send.ep;
+    ucp_rkey_h rkey    = req->send.rma.rkey;
+    ucs_status_t status;
+
+    ucs_assert(rkey->cache.ep_cfg_index == ep->cfg_index);
+
+    status = UCS_PROFILE_CALL(uct_ep_put_short,
+                              ep->uct_eps[req->send.lane],
+                              &req->send.rma.notify_value,
+                              sizeof(req->send.rma.notify_value),
+                              req->send.rma.notify_addr,
+                              rkey->cache.rma_rkey);
+    if (status == UCS_ERR_NO_RESOURCE) {
+        return status;
+    }
+
+    req->send.rma.notify = 0;
+    if (ucs_unlikely(status != UCS_OK)) {
+        if (req->send.uct_comp.count == 0) {
+            ucp_request_complete_send(req, status);
+        }
+        return UCS_OK;
+    }
+
+    if (req->send.uct_comp.count == 0) {
+        /* All payload fragments are locally complete as well */
+        ucp_rma_request_send_done(req);
+    }
+    return UCS_OK;
+}
+
 static ucs_status_t ucp_progress_put(uct_pending_req_t *self)
 {
     ucp_request_t *req              = ucs_container_of(self, ucp_request_t, send.uct);
     ucp_ep_t *ep                    = req->send.ep;
     ucp_rkey_h rkey                 = req->send.rma.rkey;
-    ucp_lane_index_t lane           = req->send.lane;
+    ucp_lane_index_t lane           = ucp_rma_request_next_lane(req, rkey);
     ucp_ep_rma_config_t *rma_config = &ucp_ep_config(ep)->rma[lane];
     ucs_status_t status;
     ssize_t packed_len;
 
     ucs_assert(rkey->cache.ep_cfg_index == ep->cfg_index);
-    ucs_assert(rkey->cache.rma_lane == lane);
+    ucs_assert(rkey->cache.rma_lane == req->send.lane);
 
     if (req->send.length <= ucp_ep_config(ep)->bcopy_thresh) {
         packed_len = ucs_min(req->send.length, rma_config->max_put_short);
@@ -176,13 +357,13 @@ static ucs_status_t ucp_progress_get(uct_pending_req_t *self)
     ucp_request_t *req              = ucs_container_of(self, ucp_request_t, send.uct);
     ucp_ep_t *ep                    = req->send.ep;
     ucp_rkey_h rkey                 = req->send.rma.rkey;
-    ucp_lane_index_t lane           = req->send.lane;
+    ucp_lane_index_t lane           = ucp_rma_request_next_lane(req, rkey);
     ucp_ep_rma_config_t *rma_config = &ucp_ep_config(ep)->rma[lane];
     ucs_status_t status;
     size_t frag_length;
 
     ucs_assert(rkey->cache.ep_cfg_index == ep->cfg_index);
-    ucs_assert(rkey->cache.rma_lane == lane);
+    ucs_assert(rkey->cache.rma_lane == req->send.lane);
 
     ++req->send.uct_comp.count;
     if (ucs_likely(req->send.length < rma_config->get_zcopy_thresh)) {
@@ -326,6 +507,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_get, (ep, buffer, length, remote_addr, rkey),
 {
     ucp_ep_rma_config_t *rma_config;
     ucs_status_t status;
+    void *rptr;
 
     UCP_RMA_CHECK_PARAMS(buffer, length);
     UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
@@ -335,8 +517,18 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_get, (ep, buffer, length, remote_addr, rkey),
         goto out_unlock;
     }
 
+    /* the remote memory of a shared memory peer is mapped locally - read it
+     * directly instead of going through the transport and the progress engine */
+    if (ucs_likely(rkey->cache.rkey_bundle != NULL)) {
+        status = uct_rkey_ptr(rkey->cache.rkey_bundle, remote_addr, &rptr);
+        if (ucs_likely(status == UCS_OK)) {
+            UCS_PROFILE_NAMED_CALL("get_rkey_ptr", memcpy, buffer, rptr, length);
+            goto out_unlock;
+        }
+    }
+
     rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
-    status = ucp_rma_blocking(ep, buffer, length, remote_addr, rkey, 
+    status = ucp_rma_blocking(ep, buffer, length, remote_addr, rkey,
                               ucp_progress_get, rma_config->get_zcopy_thresh);
 out_unlock:
     UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
@@ -374,11 +566,227 @@ out_unlock:
     return status;
 }
 
+ucs_status_t ucp_put_notify_nbi(ucp_ep_h ep, const void *buffer, size_t length,
+                                uint64_t remote_addr, ucp_rkey_h rkey,
+                                uint64_t notify_value, uint64_t notify_addr)
+{
+    ucp_ep_rma_config_t *rma_config;
+    ucs_status_t status;
+    ucp_request_t *req;
+
+    if (ENABLE_PARAMS_CHECK && (buffer == NULL) && (length != 0)) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, rma);
+    if (status != UCS_OK) {
+        goto out_unlock;
+    }
+
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto out_unlock;
+    }
+
+    rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
+    status = ucp_rma_request_init(req, ep, buffer, length, remote_addr, rkey,
+                                  ucp_progress_put,
+                                  rma_config->put_zcopy_thresh,
+                                  UCP_REQUEST_FLAG_RELEASED);
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(req);
+        goto out_unlock;
+    }
+
+    req->send.rma.notify       = 1;
+    req->send.rma.notify_value = notify_value;
+    req->send.rma.notify_addr  = notify_addr;
+    if (length == 0) {
+        /* Degenerate case - only the notification write */
+        req->send.uct.func = ucp_progress_put_notify_fin;
+    }
+
+    status = ucp_request_start_send(req);
+
+out_unlock:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return status;
+}
+
+ucs_status_ptr_t ucp_put_nb(ucp_ep_h ep, const void *buffer, size_t length,
+                            uint64_t remote_addr, ucp_rkey_h rkey,
+                            unsigned flags, ucp_send_callback_t cb)
+{
+    ucp_ep_rma_config_t *rma_config;
+    ucp_request_t *req;
+    ucs_status_t status;
+    void *ret;
+
+    if (length == 0) {
+        return UCS_STATUS_PTR(UCS_OK);
+    }
+    if (ENABLE_PARAMS_CHECK && (buffer == NULL)) {
+        return UCS_STATUS_PTR(UCS_ERR_INVALID_PARAM);
+    }
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, rma);
+    if (status != UCS_OK) {
+        ret = UCS_STATUS_PTR(status);
+        goto out_unlock;
+    }
+
+    req = ucp_request_get(ep->worker);
+    if (req == NULL) {
+        ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+        goto out_unlock;
+    }
+
+    rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
+    status = ucp_rma_request_init(req, ep, buffer, length, remote_addr, rkey,
+                                  ucp_progress_put,
+                                  rma_config->put_zcopy_thresh, 0);
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(req);
+        ret = UCS_STATUS_PTR(status);
+        goto out_unlock;
+    }
+    req->send.rma.remote_comp = !!(flags & UCP_PUT_FLAG_REMOTE_COMPLETE);
+
+    status = ucp_request_start_send(req);
+    if (req->flags & UCP_REQUEST_FLAG_COMPLETED) {
+        ucs_trace_req("releasing put request %p, returning status %s", req,
+                      ucs_status_string(status));
+        ucs_mpool_put(req);
+        ret = UCS_STATUS_PTR(status);
+        goto out_unlock;
+    }
+
+    ucp_request_set_callback(req, send.cb, cb);
+    ret = req + 1;
+
+out_unlock:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return ret;
+}
+
+static ucs_status_t ucp_put_burst_resolve(ucp_put_burst_t *burst)
+{
+    ucp_ep_h ep     = burst->ep;
+    ucp_rkey_h rkey = burst->rkey;
+    ucs_status_t status;
+
+    status = UCP_RKEY_RESOLVE(rkey, ep, rma);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    burst->cfg_index     = ep->cfg_index;
+    burst->lane          = rkey->cache.rma_lane;
+    burst->uct_ep        = ep->uct_eps[burst->lane];
+    burst->uct_rkey      = rkey->cache.rma_rkey;
+    burst->max_put_short = rkey->cache.max_put_short;
+    burst->max_put_bcopy = ucp_ep_config(ep)->rma[burst->lane].max_put_bcopy;
+    return UCS_OK;
+}
+
+ucs_status_t ucp_put_burst_begin(ucp_ep_h ep, ucp_rkey_h rkey,
+                                 ucp_put_burst_t *burst)
+{
+    ucs_status_t status;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+    burst->ep   = ep;
+    burst->rkey = rkey;
+    status      = ucp_put_burst_resolve(burst);
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return status;
+}
+
+ucs_status_t ucp_put_burst(ucp_put_burst_t *burst, const void *buffer,
+                           size_t length, uint64_t remote_addr)
+{
+    ucp_ep_h ep = burst->ep;
+    ucp_memcpy_pack_context_t pack_ctx;
+    ucs_status_t status;
+    ssize_t packed_len;
+
+    UCP_RMA_CHECK_PARAMS(buffer, length);
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    if (ucs_unlikely(burst->cfg_index != ep->cfg_index)) {
+        /* a wireup transport switch changed the lanes - re-resolve */
+        status = ucp_put_burst_resolve(burst);
+        if (status != UCS_OK) {
+            goto out_unlock;
+        }
+    }
+
+    if (ucs_likely(length <= burst->max_put_short)) {
+        status = UCS_PROFILE_CALL(uct_ep_put_short, burst->uct_ep, buffer,
+                                  length, remote_addr, burst->uct_rkey);
+        if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+            goto out_unlock;
+        }
+    } else if (length <= burst->max_put_bcopy) {
+        pack_ctx.src    = buffer;
+        pack_ctx.length = length;
+        packed_len = UCS_PROFILE_CALL(uct_ep_put_bcopy, burst->uct_ep,
+                                      ucp_memcpy_pack, &pack_ctx, remote_addr,
+                                      burst->uct_rkey);
+        status = (packed_len > 0) ? UCS_OK : (ucs_status_t)packed_len;
+        if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+            goto out_unlock;
+        }
+    }
+
+    /* out of resources, or too large for a single fragment - take the full
+     * per-operation path, which can fragment and queue on the pending queue */
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return ucp_put_nbi(ep, buffer, length, remote_addr, burst->rkey);
+
+out_unlock:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return status;
+}
+
+ucs_status_t ucp_put_burst_end(ucp_put_burst_t *burst)
+{
+    ucp_ep_h ep = burst->ep;
+    ucs_status_t status;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    if (ucs_unlikely(burst->cfg_index != ep->cfg_index)) {
+        status = ucp_put_burst_resolve(burst);
+        if (status != UCS_OK) {
+            goto out_unlock;
+        }
+    }
+
+    /* remote completion of the whole burst is tied to this single flush */
+    while ((status = uct_ep_flush(ep->uct_eps[burst->lane], 0, NULL)) != UCS_OK) {
+        if ((status != UCS_ERR_NO_RESOURCE) && (status != UCS_INPROGRESS)) {
+            break;
+        }
+        ucp_worker_progress(ep->worker);
+    }
+
+out_unlock:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return status;
+}
+
 ucs_status_t ucp_get_nbi(ucp_ep_h ep, void *buffer, size_t length,
                          uint64_t remote_addr, ucp_rkey_h rkey)
 {
     ucp_ep_rma_config_t *rma_config;
     ucs_status_t status;
+    void *rptr;
 
     UCP_RMA_CHECK_PARAMS(buffer, length);
     UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
@@ -388,6 +796,15 @@ ucs_status_t ucp_get_nbi(ucp_ep_h ep, void *buffer, size_t length,
         goto out_unlock;
     }
 
+    /* Fast path for shared memory - read the remote memory directly */
+    if (ucs_likely(rkey->cache.rkey_bundle != NULL)) {
+        status = uct_rkey_ptr(rkey->cache.rkey_bundle, remote_addr, &rptr);
+        if (ucs_likely(status == UCS_OK)) {
+            UCS_PROFILE_NAMED_CALL("get_rkey_ptr", memcpy, buffer, rptr, length);
+            goto out_unlock;
+        }
+    }
+
     rma_config = &ucp_ep_config(ep)->rma[rkey->cache.rma_lane];
     status = ucp_rma_nonblocking(ep, buffer, length, remote_addr, rkey,
                          ucp_progress_get, rma_config->get_zcopy_thresh);
@@ -403,6 +820,15 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_fence, (worker), ucp_worker_h worker)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
+    /* Combined atomic adds and coalesced eager frames belong to the
+     * pre-fence epoch */
+    if (ucs_unlikely(worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(worker, 1);
+    }
+    if (ucs_unlikely(worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_drain(worker, 1);
+    }
+
     for (rsc_index = 0; rsc_index < worker->context->num_tls; ++rsc_index) {
         if (worker->ifaces[rsc_index] == NULL) {
             continue;
@@ -426,6 +852,15 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_flush, (worker), ucp_worker_h worker)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
 
+    /* Pending combined atomic adds and coalesced eager frames are covered by
+     * the flush guarantee */
+    if (ucs_unlikely(worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(worker, 1);
+    }
+    if (ucs_unlikely(worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_drain(worker, 1);
+    }
+
     while (worker->stub_pend_count > 0) {
         ucp_worker_progress(worker);
     }
@@ -446,6 +881,137 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_worker_flush, (worker), ucp_worker_h worker)
     return UCS_OK;
 }
 
+/*
+ * Start flushing the interfaces which were not started yet, beginning at
+ * worker_flush.rsc_index. Every interface holds one unit of uct_comp.count
+ * until its flush is known to be done, so the count reaches zero only when
+ * all interfaces were started and completed.
+ */
+static void ucp_worker_flush_req_progress(ucp_request_t *req);
+
+static void ucp_worker_flush_resume_slow_path_callback(ucs_callbackq_slow_elem_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t,
+                                          send.worker_flush.cbq_elem);
+    ucp_worker_h worker = req->send.worker_flush.worker;
+
+    uct_worker_slowpath_progress_unregister(worker->uct,
+                                            &req->send.worker_flush.cbq_elem);
+    req->send.worker_flush.cbq_elem_on = 0;
+
+    ucp_worker_flush_req_progress(req);
+    if (req->send.uct_comp.count == 0) {
+        ucp_request_complete_send(req, req->status);
+    }
+}
+
+static void ucp_worker_flush_req_progress(ucp_request_t *req)
+{
+    ucp_worker_h worker = req->send.worker_flush.worker;
+    ucs_status_t status;
+    uct_iface_h iface;
+
+    while (req->send.worker_flush.rsc_index < worker->context->num_tls) {
+        iface = worker->ifaces[req->send.worker_flush.rsc_index];
+        if (iface == NULL) {
+            ++req->send.worker_flush.rsc_index;
+            --req->send.uct_comp.count;
+            continue;
+        }
+
+        status = uct_iface_flush(iface, 0, &req->send.uct_comp);
+        ucs_trace("flushing worker %p iface %p: %s", worker, iface,
+                  ucs_status_string(status));
+        if (status == UCS_OK) {
+            ++req->send.worker_flush.rsc_index;
+            --req->send.uct_comp.count;
+        } else if (status == UCS_INPROGRESS) {
+            ++req->send.worker_flush.rsc_index;
+        } else if (status == UCS_ERR_NO_RESOURCE) {
+            /* Retry the remaining interfaces from slow-path progress */
+            if (!req->send.worker_flush.cbq_elem_on) {
+                req->send.worker_flush.cbq_elem.cb =
+                        ucp_worker_flush_resume_slow_path_callback;
+                req->send.worker_flush.cbq_elem_on = 1;
+                uct_worker_slowpath_progress_register(
+                        worker->uct, &req->send.worker_flush.cbq_elem);
+            }
+            return;
+        } else {
+            ucs_error("error during worker flush: %s",
+                      ucs_status_string(status));
+            req->status = status;
+            ++req->send.worker_flush.rsc_index;
+            --req->send.uct_comp.count;
+        }
+    }
+}
+
+static void ucp_worker_flush_completion(uct_completion_t *self,
+                                        ucs_status_t status)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct_comp);
+
+    ucs_assert(!(req->flags & UCP_REQUEST_FLAG_COMPLETED));
+
+    if (status != UCS_OK) {
+        req->status = status;
+    }
+    ucp_request_complete_send(req, req->status);
+}
+
+ucs_status_ptr_t ucp_worker_flush_nb(ucp_worker_h worker, ucp_send_callback_t cb)
+{
+    ucp_request_t *req;
+    void *ret;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+
+    /* Pending combined atomic adds and coalesced eager frames are covered by
+     * the flush guarantee */
+    if (ucs_unlikely(worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(worker, 1);
+    }
+    if (ucs_unlikely(worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_drain(worker, 1);
+    }
+
+    req = ucp_request_get(worker);
+    if (req == NULL) {
+        ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+        goto out;
+    }
+
+    req->flags                         = 0;
+    req->status                        = UCS_OK;
+    req->send.ep                       = NULL;
+    req->send.worker_flush.worker      = worker;
+    req->send.worker_flush.rsc_index   = 0;
+    req->send.worker_flush.cbq_elem_on = 0;
+    req->send.uct_comp.func            = ucp_worker_flush_completion;
+    req->send.uct_comp.count           = worker->context->num_tls;
+
+    ucp_worker_flush_req_progress(req);
+
+    if (req->send.uct_comp.count == 0) {
+        ret = UCS_STATUS_PTR(req->status);
+        ucs_trace_req("worker %p: releasing flush request %p, returning "
+                      "status %s", worker, req,
+                      ucs_status_string(req->status));
+        ucs_mpool_put(req);
+        goto out;
+    }
+
+    ucp_request_set_callback(req, send.cb, cb);
+    ucs_trace_req("worker %p: return inprogress flush request %p (%p)", worker,
+                  req, req + 1);
+    ret = req + 1;
+
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return ret;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_ep_flush, (ep), ucp_ep_h ep)
 {
     ucp_lane_index_t lane;
@@ -453,6 +1019,15 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_ep_flush, (ep), ucp_ep_h ep)
 
     UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
 
+    /* Pending combined atomic adds and the coalesced eager frame for this
+     * endpoint are covered by the flush guarantee */
+    if (ucs_unlikely(ep->worker->amo_combine.count > 0)) {
+        ucp_worker_amo_combine_drain(ep->worker, 1);
+    }
+    if (ucs_unlikely(ep->worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_flush_ep(ep->worker, ep, 1);
+    }
+
     for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
         for (;;) {
             status = uct_ep_flush(ep->uct_eps[lane], 0, NULL);
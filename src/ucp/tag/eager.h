@@ -34,6 +34,43 @@ typedef struct {
 } UCS_S_PACKED ucp_eager_first_hdr_t;
 
 
+/*
+ * EAGER_FC_ONLY
+ */
+typedef struct {
+    ucp_eager_hdr_t           super;
+    uint64_t                  sender_uuid;
+} UCS_S_PACKED ucp_eager_fc_hdr_t;
+
+
+/*
+ * EAGER_FC_FIRST
+ */
+typedef struct {
+    ucp_eager_first_hdr_t     super;
+    uint64_t                  sender_uuid;
+} UCS_S_PACKED ucp_eager_fc_first_hdr_t;
+
+
+/*
+ * EAGER_FC_GRANT
+ */
+typedef struct {
+    uint64_t                  ep_uuid;  /* uuid of the granting worker */
+    size_t                    length;   /* granted credits, in bytes */
+} UCS_S_PACKED ucp_eager_fc_grant_hdr_t;
+
+
+/*
+ * EAGER_BATCH - sub-header of one message inside a coalesced frame. The
+ * sub-messages are laid back-to-back; the frame length delimits the walk.
+ */
+typedef struct {
+    ucp_eager_hdr_t           super;
+    uint16_t                  length;   /* payload length of this sub-message */
+} UCS_S_PACKED ucp_eager_batch_hdr_t;
+
+
 /*
  * EAGER_SYNC_ONLY
  */
@@ -54,6 +91,7 @@ typedef struct {
 
 extern const ucp_proto_t ucp_tag_eager_proto;
 extern const ucp_proto_t ucp_tag_eager_sync_proto;
+extern const ucp_proto_t ucp_tag_eager_fc_proto;
 
 
 void ucp_tag_eager_sync_send_ack(ucp_worker_h worker, uint64_t sender_uuid,
@@ -61,14 +99,25 @@ void ucp_tag_eager_sync_send_ack(ucp_worker_h worker, uint64_t sender_uuid,
 
 void ucp_tag_eager_sync_completion(ucp_request_t *req, uint16_t flag);
 
+void ucp_tag_eager_fc_grant(ucp_worker_h worker, uint64_t sender_uuid,
+                            size_t length);
+
+
+/* Whether eager sends on this endpoint are subject to credit flow control */
+static UCS_F_ALWAYS_INLINE int ucp_ep_fc_enabled(ucp_ep_h ep)
+{
+    return ep->worker->context->config.ext.eager_fc_wnd !=
+           UCS_CONFIG_MEMUNITS_INF;
+}
+
 
 static inline ucs_status_t ucp_tag_send_eager_short(ucp_ep_t *ep, ucp_tag_t tag,
                                                     const void *buffer, size_t length)
 {
     UCS_STATIC_ASSERT(sizeof(ucp_tag_t) == sizeof(ucp_eager_hdr_t));
     UCS_STATIC_ASSERT(sizeof(ucp_tag_t) == sizeof(uint64_t));
-    return uct_ep_am_short(ucp_ep_get_am_uct_ep(ep), UCP_AM_ID_EAGER_ONLY, tag,
-                           buffer, length);
+    return uct_ep_am_short(ep->uct_eps[ucp_ep_get_eager_lane(ep, tag, length, 1)],
+                           UCP_AM_ID_EAGER_ONLY, tag, buffer, length);
 }
 
 static UCS_F_ALWAYS_INLINE size_t
@@ -111,6 +160,15 @@ ucp_eager_unexp_match(ucp_worker_h worker, ucp_recv_desc_t *rdesc, ucp_tag_t tag
             ucp_tag_eager_sync_send_ack(worker, req_hdr->sender_uuid,
                                         req_hdr->reqptr);
         }
+
+        if (ucs_unlikely(flags & UCP_RECV_DESC_FLAG_FC)) {
+            /* The message left the unexpected queue - return its credits */
+            ucp_tag_eager_fc_grant(worker,
+                                   (flags & UCP_RECV_DESC_FLAG_LAST) ?
+                                   ((ucp_eager_fc_hdr_t*)data)->sender_uuid :
+                                   ((ucp_eager_fc_first_hdr_t*)data)->sender_uuid,
+                                   info->length);
+        }
         UCP_WORKER_STAT_EAGER_MSG(worker, flags);
     }
 
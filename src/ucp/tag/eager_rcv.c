@@ -91,6 +91,20 @@ ucp_eager_handler(void *arg, void *data, size_t length, unsigned am_flags,
             ucp_eager_sync_send_handler(arg, data, flags);
         }
 
+        if (ucs_unlikely(flags & UCP_RECV_DESC_FLAG_FC)) {
+            /* Expected message - consumed immediately, return its credits.
+             * Do not touch the request here, it may be released already. */
+            if (flags & UCP_RECV_DESC_FLAG_LAST) {
+                ucp_tag_eager_fc_grant(worker,
+                                       ((ucp_eager_fc_hdr_t*)data)->sender_uuid,
+                                       recv_len);
+            } else {
+                ucp_tag_eager_fc_grant(worker,
+                                       ((ucp_eager_fc_first_hdr_t*)data)->sender_uuid,
+                                       eager_first_hdr->total_len);
+            }
+        }
+
         status = UCS_OK;
     } else {
         status = ucp_tag_unexp_recv(&context->tm, worker, data, length, am_flags,
@@ -158,6 +172,75 @@ static ucs_status_t ucp_eager_sync_first_handler(void *arg, void *data,
                              sizeof(ucp_eager_sync_first_hdr_t));
 }
 
+static ucs_status_t ucp_eager_fc_only_handler(void *arg, void *data,
+                                              size_t length, unsigned am_flags)
+{
+    return ucp_eager_handler(arg, data, length, am_flags,
+                             UCP_RECV_DESC_FLAG_EAGER|
+                             UCP_RECV_DESC_FLAG_FIRST|
+                             UCP_RECV_DESC_FLAG_LAST|
+                             UCP_RECV_DESC_FLAG_FC,
+                             sizeof(ucp_eager_fc_hdr_t));
+}
+
+static ucs_status_t ucp_eager_fc_first_handler(void *arg, void *data,
+                                               size_t length, unsigned am_flags)
+{
+    return ucp_eager_handler(arg, data, length, am_flags,
+                             UCP_RECV_DESC_FLAG_EAGER|
+                             UCP_RECV_DESC_FLAG_FIRST|
+                             UCP_RECV_DESC_FLAG_FC,
+                             sizeof(ucp_eager_fc_first_hdr_t));
+}
+
+static ucs_status_t ucp_eager_fc_grant_handler(void *arg, void *data,
+                                               size_t length, unsigned am_flags)
+{
+    ucp_worker_h worker           = arg;
+    ucp_eager_fc_grant_hdr_t *hdr = data;
+    ucp_context_h context         = worker->context;
+    ucp_ep_h ep;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
+
+    ep = ucp_worker_ep_find(worker, hdr->ep_uuid);
+    if (ucs_likely(ep != NULL)) {
+        /* Clamp to the configured window - a message which was diverted to
+         * rendezvous after consuming credits would otherwise inflate it */
+        ep->fc_wnd = ucs_min(ep->fc_wnd + (ssize_t)hdr->length,
+                             (ssize_t)context->config.ext.eager_fc_wnd);
+    }
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+    return UCS_OK;
+}
+
+static ucs_status_t ucp_eager_batch_handler(void *arg, void *data, size_t length,
+                                            unsigned am_flags)
+{
+    ucp_eager_batch_hdr_t *hdr;
+    size_t sub_length;
+
+    /* The sub-messages share the transport receive buffer, so none of them
+     * may keep it - clear the desc flag and let the unexpected path copy
+     * each one out */
+    while (length > 0) {
+        hdr        = data;
+        sub_length = sizeof(*hdr) + hdr->length;
+        ucs_assertv(sub_length <= length, "sub_length=%zu length=%zu",
+                    sub_length, length);
+        ucp_eager_handler(arg, hdr, sub_length,
+                          am_flags & ~UCT_CB_FLAG_DESC,
+                          UCP_RECV_DESC_FLAG_EAGER|
+                          UCP_RECV_DESC_FLAG_FIRST|
+                          UCP_RECV_DESC_FLAG_LAST,
+                          sizeof(*hdr));
+        data    += sub_length;
+        length  -= sub_length;
+    }
+    return UCS_OK;
+}
+
 static ucs_status_t ucp_eager_sync_ack_handler(void *arg, void *data,
                                                size_t length, unsigned am_flags)
 {
@@ -177,6 +260,10 @@ static void ucp_eager_dump(ucp_worker_h worker, uct_am_trace_type_t type,
     const ucp_eager_hdr_t *eager_hdr             = data;
     const ucp_eager_sync_first_hdr_t *eagers_first_hdr = data;
     const ucp_eager_sync_hdr_t *eagers_hdr       = data;
+    const ucp_eager_fc_first_hdr_t *eagerf_first_hdr = data;
+    const ucp_eager_fc_hdr_t *eagerf_hdr         = data;
+    const ucp_eager_fc_grant_hdr_t *grant_hdr    = data;
+    const ucp_eager_batch_hdr_t *batch_hdr       = data;
     const ucp_reply_hdr_t *rep_hdr               = data;
     size_t header_len;
     char *p;
@@ -218,6 +305,28 @@ static void ucp_eager_dump(ucp_worker_h worker, uct_am_trace_type_t type,
                  ucs_status_string(rep_hdr->status));
         header_len = sizeof(*rep_hdr);
         break;
+    case UCP_AM_ID_EAGER_FC_ONLY:
+        snprintf(buffer, max, "EGRF tag %"PRIx64" uuid %"PRIx64,
+                 eagerf_hdr->super.super.tag, eagerf_hdr->sender_uuid);
+        header_len = sizeof(*eagerf_hdr);
+        break;
+    case UCP_AM_ID_EAGER_FC_FIRST:
+        snprintf(buffer, max, "EGRF_F tag %"PRIx64" len %zu uuid %"PRIx64,
+                 eagerf_first_hdr->super.super.super.tag,
+                 eagerf_first_hdr->super.total_len,
+                 eagerf_first_hdr->sender_uuid);
+        header_len = sizeof(*eagerf_first_hdr);
+        break;
+    case UCP_AM_ID_EAGER_FC_GRANT:
+        snprintf(buffer, max, "EGRF_G uuid %"PRIx64" len %zu",
+                 grant_hdr->ep_uuid, grant_hdr->length);
+        header_len = sizeof(*grant_hdr);
+        break;
+    case UCP_AM_ID_EAGER_BATCH:
+        snprintf(buffer, max, "EGR_B tag %"PRIx64" sub_len %u",
+                 batch_hdr->super.super.tag, batch_hdr->length);
+        header_len = sizeof(*batch_hdr);
+        break;
     default:
         return;
     }
@@ -241,3 +350,11 @@ UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_SYNC_FIRST, ucp_eager_sync_first_
               ucp_eager_dump, UCT_AM_CB_FLAG_SYNC);
 UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_SYNC_ACK, ucp_eager_sync_ack_handler,
               ucp_eager_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_FC_ONLY, ucp_eager_fc_only_handler,
+              ucp_eager_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_FC_FIRST, ucp_eager_fc_first_handler,
+              ucp_eager_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_FC_GRANT, ucp_eager_fc_grant_handler,
+              ucp_eager_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_EAGER_BATCH, ucp_eager_batch_handler,
+              ucp_eager_dump, UCT_AM_CB_FLAG_SYNC);
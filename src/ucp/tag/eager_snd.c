@@ -125,7 +125,7 @@ static ucs_status_t ucp_tag_eager_contig_short(uct_pending_req_t *self)
     ucp_ep_t *ep = req->send.ep;
     ucs_status_t status;
 
-    req->send.lane = ucp_ep_get_am_lane(ep);
+    req->send.lane = ucp_ep_get_eager_lane(ep, req->send.tag, req->send.length, 1);
     status = uct_ep_am_short(ep->uct_eps[req->send.lane], UCP_AM_ID_EAGER_ONLY,
                              req->send.tag, req->send.buffer, req->send.length);
     if (status != UCS_OK) {
@@ -138,10 +138,15 @@ static ucs_status_t ucp_tag_eager_contig_short(uct_pending_req_t *self)
 
 static ucs_status_t ucp_tag_eager_bcopy_single(uct_pending_req_t *self)
 {
-    ucs_status_t status = ucp_do_am_bcopy_single(self, UCP_AM_ID_EAGER_ONLY,
-                                                 ucp_tag_pack_eager_single_dt);
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucs_status_t status;
+
+    status = ucp_do_am_bcopy_single_lane(self, UCP_AM_ID_EAGER_ONLY,
+                                         ucp_ep_get_eager_lane(req->send.ep,
+                                                               req->send.tag,
+                                                               req->send.length, 0),
+                                         ucp_tag_pack_eager_single_dt);
     if (status == UCS_OK) {
-        ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
         ucp_request_send_generic_dt_finish(req);
         ucp_request_complete_send(req, UCS_OK);
     }
@@ -318,3 +323,193 @@ const ucp_proto_t ucp_tag_eager_sync_proto = {
     .first_hdr_size          = sizeof(ucp_eager_sync_first_hdr_t),
     .mid_hdr_size            = sizeof(ucp_eager_hdr_t)
 };
+
+/* eager with credit flow control */
+
+static size_t ucp_tag_pack_eager_fc_single_dt(void *dest, void *arg)
+{
+    ucp_eager_fc_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+    size_t length;
+
+    hdr->super.super.tag = req->send.tag;
+    hdr->sender_uuid     = req->send.ep->worker->uuid;
+
+    ucs_assert(req->send.state.offset == 0);
+    length = ucp_dt_pack(req->send.datatype, hdr + 1, req->send.buffer,
+                         &req->send.state, req->send.length);
+    ucs_assert(length == req->send.length);
+    return sizeof(*hdr) + length;
+}
+
+static size_t ucp_tag_pack_eager_fc_first_dt(void *dest, void *arg)
+{
+    ucp_eager_fc_first_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+    size_t length;
+
+    length                     = ucp_ep_config(req->send.ep)->am.max_bcopy -
+                                 sizeof(*hdr);
+    hdr->super.super.super.tag = req->send.tag;
+    hdr->super.total_len       = req->send.length;
+    hdr->sender_uuid           = req->send.ep->worker->uuid;
+
+    ucs_debug("pack eager_fc_first paylen %zu", length);
+    ucs_assert(req->send.state.offset == 0);
+    ucs_assert(req->send.length > length);
+    return sizeof(*hdr) + ucp_dt_pack(req->send.datatype, hdr + 1,
+                                      req->send.buffer, &req->send.state,
+                                      length);
+}
+
+/* The window is consumed when the first fragment goes out and returned if it
+ * could not be sent; the receiver grants the credits back as it consumes the
+ * message. */
+static UCS_F_ALWAYS_INLINE void ucp_tag_eager_fc_consume(ucp_request_t *req)
+{
+    req->send.ep->fc_wnd -= req->send.length;
+}
+
+static UCS_F_ALWAYS_INLINE void ucp_tag_eager_fc_restore(ucp_request_t *req)
+{
+    req->send.ep->fc_wnd += req->send.length;
+}
+
+static ucs_status_t ucp_tag_eager_fc_bcopy_single(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucs_status_t status;
+
+    ucp_tag_eager_fc_consume(req);
+    status = ucp_do_am_bcopy_single(self, UCP_AM_ID_EAGER_FC_ONLY,
+                                    ucp_tag_pack_eager_fc_single_dt);
+    if (status == UCS_OK) {
+        ucp_request_send_generic_dt_finish(req);
+        ucp_request_complete_send(req, UCS_OK);
+    } else {
+        ucp_tag_eager_fc_restore(req);
+    }
+    return status;
+}
+
+static ucs_status_t ucp_tag_eager_fc_bcopy_multi(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    int first          = (req->send.state.offset == 0);
+    ucs_status_t status;
+
+    if (first) {
+        ucp_tag_eager_fc_consume(req);
+    }
+    status = ucp_do_am_bcopy_multi(self,
+                                   UCP_AM_ID_EAGER_FC_FIRST,
+                                   UCP_AM_ID_EAGER_MIDDLE,
+                                   UCP_AM_ID_EAGER_LAST,
+                                   sizeof(ucp_eager_hdr_t),
+                                   ucp_tag_pack_eager_fc_first_dt,
+                                   ucp_tag_pack_eager_middle_dt,
+                                   ucp_tag_pack_eager_last_dt);
+    if (status == UCS_OK) {
+        ucp_request_send_generic_dt_finish(req);
+        ucp_request_complete_send(req, UCS_OK);
+    } else if (first && (status != UCS_INPROGRESS)) {
+        ucp_tag_eager_fc_restore(req);
+    }
+    return status;
+}
+
+static ucs_status_t ucp_tag_eager_fc_zcopy_single(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_eager_fc_hdr_t hdr;
+    ucs_status_t status;
+
+    hdr.super.super.tag = req->send.tag;
+    hdr.sender_uuid     = req->send.ep->worker->uuid;
+
+    ucp_tag_eager_fc_consume(req);
+    status = ucp_do_am_zcopy_single(self, UCP_AM_ID_EAGER_FC_ONLY, &hdr,
+                                    sizeof(hdr),
+                                    ucp_tag_eager_zcopy_req_complete);
+    if (status != UCS_OK) {
+        ucp_tag_eager_fc_restore(req);
+    }
+    return status;
+}
+
+static ucs_status_t ucp_tag_eager_fc_zcopy_multi(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    int first          = (req->send.state.offset == 0);
+    ucp_eager_fc_first_hdr_t first_hdr;
+    ucs_status_t status;
+
+    first_hdr.super.super.super.tag = req->send.tag;
+    first_hdr.super.total_len       = req->send.length;
+    first_hdr.sender_uuid           = req->send.ep->worker->uuid;
+
+    if (first) {
+        ucp_tag_eager_fc_consume(req);
+    }
+    status = ucp_do_am_zcopy_multi(self,
+                                   UCP_AM_ID_EAGER_FC_FIRST,
+                                   UCP_AM_ID_EAGER_MIDDLE,
+                                   UCP_AM_ID_EAGER_LAST,
+                                   &first_hdr, sizeof(first_hdr),
+                                   &first_hdr.super.super,
+                                   sizeof(first_hdr.super.super),
+                                   ucp_tag_eager_zcopy_req_complete);
+    if (first && (status != UCS_OK) && (status != UCS_INPROGRESS)) {
+        ucp_tag_eager_fc_restore(req);
+    }
+    return status;
+}
+
+static size_t ucp_tag_pack_eager_fc_grant(void *dest, void *arg)
+{
+    ucp_eager_fc_grant_hdr_t *hdr = dest;
+    ucp_request_t *req = arg;
+
+    hdr->ep_uuid = req->send.ep->worker->uuid;
+    hdr->length  = req->send.length;
+    return sizeof(*hdr);
+}
+
+static ucs_status_t ucp_tag_eager_fc_grant_progress(uct_pending_req_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucs_status_t status;
+
+    status = ucp_do_am_bcopy_single(self, UCP_AM_ID_EAGER_FC_GRANT,
+                                    ucp_tag_pack_eager_fc_grant);
+    if (status == UCS_OK) {
+        ucp_request_put(req);
+    }
+    return status;
+}
+
+void ucp_tag_eager_fc_grant(ucp_worker_h worker, uint64_t sender_uuid,
+                            size_t length)
+{
+    ucp_request_t *req;
+
+    ucs_trace_req("eager_fc_grant sender_uuid %"PRIx64" length %zu",
+                  sender_uuid, length);
+
+    req = ucp_worker_allocate_reply(worker, sender_uuid);
+    req->send.uct.func = ucp_tag_eager_fc_grant_progress;
+    req->send.length   = length;
+    ucp_request_start_send(req);
+}
+
+const ucp_proto_t ucp_tag_eager_fc_proto = {
+    .contig_short            = NULL,
+    .bcopy_single            = ucp_tag_eager_fc_bcopy_single,
+    .bcopy_multi             = ucp_tag_eager_fc_bcopy_multi,
+    .zcopy_single            = ucp_tag_eager_fc_zcopy_single,
+    .zcopy_multi             = ucp_tag_eager_fc_zcopy_multi,
+    .zcopy_completion        = ucp_tag_eager_zcopy_completion,
+    .only_hdr_size           = sizeof(ucp_eager_fc_hdr_t),
+    .first_hdr_size          = sizeof(ucp_eager_fc_first_hdr_t),
+    .mid_hdr_size            = sizeof(ucp_eager_hdr_t)
+};
@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#include "offload.h"
+#include "eager.h"
+#include "rndv.h"
+#include "tag_match.inl"
+
+#include <ucp/core/ucp_worker.h>
+#include <ucp/core/ucp_request.inl>
+#include <ucs/datastruct/mpool.inl>
+
+
+/* Matched by the transport; the data is being placed directly in the user
+ * buffer and completed_cb/rndv_cb will follow */
+static void ucp_tag_offload_tag_consumed(uct_tag_context_t *self)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, recv.uct_ctx);
+
+    ucs_trace_req("tag consumed by the transport, req %p tag %"PRIx64, req,
+                  req->recv.tag);
+}
+
+static void ucp_tag_offload_completed(uct_tag_context_t *self, uct_tag_t stag,
+                                      uint64_t imm, size_t length,
+                                      ucs_status_t status)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, recv.uct_ctx);
+
+    req->flags               &= ~UCP_REQUEST_FLAG_OFFLOADED;
+    req->recv.info.sender_tag = stag;
+    req->recv.info.length     = length;
+    ucp_request_complete_recv(req, status);
+}
+
+static void ucp_tag_offload_rndv_cb(uct_tag_context_t *self, uct_tag_t stag,
+                                    const void *header, unsigned header_length,
+                                    ucs_status_t status)
+{
+    ucp_request_t *req = ucs_container_of(self, ucp_request_t, recv.uct_ctx);
+
+    req->flags &= ~UCP_REQUEST_FLAG_OFFLOADED;
+    if (status != UCS_OK) {
+        ucp_request_complete_recv(req, status);
+        return;
+    }
+
+    /* The sender puts the software RTS in the rendezvous header, so the
+     * transfer continues with the software rendezvous protocol */
+    ucs_assert(header_length >= sizeof(ucp_rndv_rts_hdr_t));
+    ucp_rndv_matched(req->recv.worker, req, (ucp_rndv_rts_hdr_t*)header);
+    UCP_WORKER_STAT_RNDV(req->recv.worker, EXP);
+}
+
+int ucp_tag_offload_post(ucp_worker_h worker, ucp_request_t *req)
+{
+    uct_iov_t iov;
+    ucs_status_t status;
+
+    if (ucs_likely(worker->tm_offload_iface == NULL)) {
+        return 0;
+    }
+
+    if ((req->recv.tag_mask != UCP_TAG_MASK_FULL) ||
+        ((req->recv.datatype & UCP_DATATYPE_CLASS_MASK) != UCP_DATATYPE_CONTIG) ||
+        (req->recv.length < worker->tm_offload_iface_attr->cap.tag.recv.min_recv)) {
+        /* Hardware cannot match wildcards, and non-contig unpack must go
+         * through the software path */
+        return 0;
+    }
+
+    iov.buffer = req->recv.buffer;
+    iov.length = req->recv.length;
+    iov.memh   = UCT_MEM_HANDLE_NULL;
+    iov.stride = 0;
+    iov.count  = 1;
+
+    req->recv.worker                  = worker;
+    req->recv.uct_ctx.tag_consumed_cb = ucp_tag_offload_tag_consumed;
+    req->recv.uct_ctx.completed_cb    = ucp_tag_offload_completed;
+    req->recv.uct_ctx.rndv_cb         = ucp_tag_offload_rndv_cb;
+
+    status = uct_iface_tag_recv_zcopy(worker->tm_offload_iface, req->recv.tag,
+                                      req->recv.tag_mask, &iov, 1,
+                                      &req->recv.uct_ctx);
+    if (status != UCS_OK) {
+        /* For example, the transport ran out of hardware tag list entries */
+        ucs_trace_req("tag offload post failed, req %p tag %"PRIx64": %s", req,
+                      req->recv.tag, ucs_status_string(status));
+        return 0;
+    }
+
+    req->flags |= UCP_REQUEST_FLAG_OFFLOADED;
+    ucs_trace_req("tag offload posted req %p tag %"PRIx64" buffer %p length %zu",
+                  req, req->recv.tag, req->recv.buffer, req->recv.length);
+    return 1;
+}
+
+void ucp_tag_offload_cancel(ucp_worker_h worker, ucp_request_t *req, int force)
+{
+    ucs_status_t status;
+
+    ucs_assert(req->flags & UCP_REQUEST_FLAG_OFFLOADED);
+    status = uct_iface_tag_recv_cancel(worker->tm_offload_iface,
+                                       &req->recv.uct_ctx, force);
+    if (status != UCS_OK) {
+        ucs_error("failed to cancel tag offload req %p: %s", req,
+                  ucs_status_string(status));
+    }
+}
+
+ucs_status_t ucp_tag_offload_unexp_eager(void *arg, void *data, size_t length,
+                                         unsigned flags, uct_tag_t stag,
+                                         uint64_t imm)
+{
+    const uint16_t recv_flags = UCP_RECV_DESC_FLAG_EAGER |
+                                UCP_RECV_DESC_FLAG_FIRST |
+                                UCP_RECV_DESC_FLAG_LAST;
+    ucp_worker_h worker   = arg;
+    ucp_context_h context = worker->context;
+    ucp_recv_desc_t *rdesc;
+    ucp_eager_hdr_t *hdr;
+    ucs_status_t status;
+    ucp_request_t *req;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&context->mt_lock);
+
+    req = ucp_tag_exp_search(&context->tm, stag, length, recv_flags);
+    if (req != NULL) {
+        UCS_PROFILE_REQUEST_EVENT(req, "eager_offload_recv", length);
+        status = ucp_dt_unpack(req->recv.datatype, req->recv.buffer,
+                               req->recv.length, &req->recv.state, data,
+                               length, 1);
+        req->recv.info.sender_tag = stag;
+        req->recv.info.length     = length;
+        ucp_request_complete_recv(req, status);
+        status = UCS_OK;
+        goto out;
+    }
+
+    /* The tag arrives out-of-band on the offload path, so synthesize an
+     * eager-only header in front of the payload and enqueue the descriptor
+     * the same way as a software unexpected message */
+    rdesc = (ucp_recv_desc_t*)ucs_mpool_get_inline(&worker->am_mp);
+    if (rdesc == NULL) {
+        ucs_error("ucp recv descriptor is not allocated");
+        status = UCS_ERR_NO_MEMORY;
+        goto out;
+    }
+
+    hdr            = (ucp_eager_hdr_t*)(rdesc + 1);
+    hdr->super.tag = stag;
+    memcpy(hdr + 1, data, length);
+
+    rdesc->flags   = recv_flags;
+    rdesc->length  = length + sizeof(*hdr);
+    rdesc->hdr_len = sizeof(*hdr);
+    ucs_list_add_tail(ucp_tag_unexp_get_list_for_tag(&context->tm, stag),
+                      &rdesc->list[UCP_RDESC_HASH_LIST]);
+    ucs_list_add_tail(&context->tm.unexpected.all,
+                      &rdesc->list[UCP_RDESC_ALL_LIST]);
+    ++context->tm.unexpected.count;
+    status = UCS_OK;
+
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&context->mt_lock);
+    return status;
+}
+
+ucs_status_t ucp_tag_offload_unexp_rndv(void *arg, unsigned flags,
+                                        uint64_t stag, const void *hdr,
+                                        unsigned hdr_length,
+                                        uint64_t remote_addr, size_t length,
+                                        const void *rkey_buf)
+{
+    ucp_worker_h worker               = arg;
+    ucp_rndv_rts_hdr_t *rndv_rts_hdr  = (ucp_rndv_rts_hdr_t*)hdr;
+
+    /* The rendezvous header is the software RTS, so it can be fed into the
+     * regular RTS handler */
+    ucs_assert(hdr_length >= sizeof(*rndv_rts_hdr));
+    ucs_assert(rndv_rts_hdr->super.tag == stag);
+    return ucp_rndv_rts_handler(worker, (void*)hdr, hdr_length, 0);
+}
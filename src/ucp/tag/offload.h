@@ -0,0 +1,45 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCP_TAG_OFFLOAD_H_
+#define UCP_TAG_OFFLOAD_H_
+
+#include <ucp/core/ucp_request.h>
+#include <uct/api/uct.h>
+
+
+/**
+ * Post an expected receive request to the transport tag-matching hardware.
+ *
+ * @return Nonzero if the request was handed to the transport, 0 if the caller
+ *         should fall back to software matching (wildcard mask, non-contig
+ *         datatype, no capable interface, or the transport refused the post).
+ */
+int ucp_tag_offload_post(ucp_worker_h worker, ucp_request_t *req);
+
+/**
+ * Cancel a receive request which was posted to the hardware.
+ */
+void ucp_tag_offload_cancel(ucp_worker_h worker, ucp_request_t *req, int force);
+
+/**
+ * Transport callback for eager messages which were not matched in hardware.
+ */
+ucs_status_t ucp_tag_offload_unexp_eager(void *arg, void *data, size_t length,
+                                         unsigned flags, uct_tag_t stag,
+                                         uint64_t imm);
+
+/**
+ * Transport callback for rendezvous requests which were not matched in
+ * hardware. The header is the software rendezvous RTS.
+ */
+ucs_status_t ucp_tag_offload_unexp_rndv(void *arg, unsigned flags,
+                                        uint64_t stag, const void *hdr,
+                                        unsigned hdr_length,
+                                        uint64_t remote_addr, size_t length,
+                                        const void *rkey_buf);
+
+#endif
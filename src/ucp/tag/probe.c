@@ -17,12 +17,28 @@ static UCS_F_ALWAYS_INLINE ucp_recv_desc_t*
 ucp_tag_probe_search(ucp_context_h context, ucp_tag_t tag, uint64_t tag_mask,
                      ucp_tag_recv_info_t *info, int remove)
 {
+    ucs_list_link_t *list;
     ucp_recv_desc_t *rdesc;
     ucp_tag_hdr_t *hdr;
     ucp_tag_t recv_tag;
     unsigned flags;
+    int i_list;
 
-    ucs_list_for_each(rdesc, &context->tm.unexpected.all, list[UCP_RDESC_ALL_LIST]) {
+    /* Narrow the scan the same way a posted receive does - to the tag's hash
+     * bucket for a full mask, or to the sender's messages when the mask pins
+     * down the sender bits */
+    if (tag_mask == UCP_TAG_MASK_FULL) {
+        list   = ucp_tag_unexp_get_list_for_tag(&context->tm, tag);
+        i_list = UCP_RDESC_HASH_LIST;
+    } else if (ucp_tag_unexp_use_sender_hash(&context->tm, tag_mask)) {
+        list   = ucp_tag_unexp_get_sender_list(&context->tm, tag);
+        i_list = UCP_RDESC_SENDER_LIST;
+    } else {
+        list   = &context->tm.unexpected.all;
+        i_list = UCP_RDESC_ALL_LIST;
+    }
+
+    ucs_list_for_each_pf(rdesc, list, list[i_list]) {
         hdr      = (void*)(rdesc + 1);
         recv_tag = hdr->tag;
         flags    = rdesc->flags;
@@ -43,7 +59,7 @@ ucp_tag_probe_search(ucp_context_h context, ucp_tag_t tag, uint64_t tag_mask,
             }
 
             if (remove) {
-                ucp_tag_unexp_remove(rdesc);
+                ucp_tag_unexp_remove(&context->tm, rdesc);
             }
             return rdesc;
         }
@@ -8,16 +8,32 @@
 #include "tag_match.inl"
 
 #include <ucp/proto/proto_am.inl>
+#include <ucp/core/ucp_mm.h>
 #include <ucp/core/ucp_request.inl>
+#include <uct/base/uct_iface.h>
 #include <ucs/datastruct/queue.h>
+#include <ucs/debug/usdt.h>
 
+#if HAVE_CUDA
+#include <cuda_runtime.h>
+#endif
+
+
+static uint64_t ucp_tag_rndv_iface_flags(ucp_ep_h ep)
+{
+    ucp_rsc_index_t rsc_index = ucp_ep_get_rsc_index(ep,
+                                                     ucp_ep_get_rndv_get_lane(ep));
+
+    return ep->worker->iface_attrs[rsc_index].cap.flags;
+}
 
 static int ucp_tag_rndv_is_get_op_possible(ucp_ep_h ep, uct_rkey_t rkey)
 {
     uint64_t md_flags;
 
     ucs_assert(!ucp_ep_is_stub(ep));
-    if (ucp_ep_is_rndv_lane_present(ep)) {
+    if (ucp_ep_is_rndv_lane_present(ep) &&
+        (ucp_tag_rndv_iface_flags(ep) & UCT_IFACE_FLAG_GET_ZCOPY)) {
         md_flags = ucp_ep_rndv_md_flags(ep);
         return (((rkey != UCT_INVALID_RKEY) && (md_flags & UCT_MD_FLAG_REG)) ||
                 !(md_flags & UCT_MD_FLAG_NEED_RKEY));
@@ -26,6 +42,28 @@ static int ucp_tag_rndv_is_get_op_possible(ucp_ep_h ep, uct_rkey_t rkey)
     }
 }
 
+static int ucp_tag_rndv_is_put_rndv(ucp_ep_h ep)
+{
+    ucp_rndv_mode_t rndv_mode = ep->worker->context->config.ext.rndv_mode;
+    uint64_t cap_flags;
+
+    if (!ucp_ep_is_rndv_lane_present(ep)) {
+        return 0;
+    }
+
+    cap_flags = ucp_tag_rndv_iface_flags(ep);
+    if (!(cap_flags & UCT_IFACE_FLAG_PUT_ZCOPY) ||
+        (rndv_mode == UCP_RNDV_MODE_GET_ZCOPY)) {
+        return 0;
+    }
+
+    /* ask the sender to push the data with put_zcopy when the scheme is forced
+     * by the configuration, or when the rndv lane cannot read the data with
+     * get_zcopy (e.g. ugni) */
+    return (rndv_mode == UCP_RNDV_MODE_PUT_ZCOPY) ||
+           !(cap_flags & UCT_IFACE_FLAG_GET_ZCOPY);
+}
+
 static void ucp_rndv_rma_request_send_buffer_dereg(ucp_request_t *sreq)
 {
     if ((UCP_DT_IS_CONTIG(sreq->send.datatype)) &&
@@ -102,6 +140,10 @@ static size_t ucp_tag_rndv_rtr_pack(void *dest, void *arg)
     /* rreq_ptr holds the recv req on the recv side */
     rndv_rtr_hdr->rreq_ptr = rndv_req->send.proto.rreq_ptr;
 
+    /* the sender should send the data with AM messages */
+    rndv_rtr_hdr->address  = 0;
+    rndv_rtr_hdr->flags    = 0;
+
     return sizeof(*rndv_rtr_hdr);
 }
 
@@ -120,6 +162,44 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_rtr, (self),
     return status;
 }
 
+static size_t ucp_tag_rndv_rtr_put_pack(void *dest, void *arg)
+{
+    ucp_request_t *rndv_req          = arg;   /* the receive's rndv_req */
+    ucp_rndv_rtr_hdr_t *rndv_rtr_hdr = dest;
+    ucp_ep_h ep                      = rndv_req->send.ep;
+    size_t packed_len                = sizeof(*rndv_rtr_hdr);
+
+    /* sreq_ptr holds the sender's send req */
+    rndv_rtr_hdr->sreq_ptr = rndv_req->send.rndv_get.remote_request;
+
+    /* the rndv_req itself is sent back in the ATP, to find the recv request
+     * and to deregister the receive buffer */
+    rndv_rtr_hdr->rreq_ptr = (uintptr_t)rndv_req;
+    rndv_rtr_hdr->address  = (uintptr_t)rndv_req->send.buffer;
+    rndv_rtr_hdr->flags    = 0;
+
+    /* if the receive buffer was registered, send the rkey */
+    if (rndv_req->send.state.dt.contig.memh != UCT_MEM_HANDLE_NULL) {
+        UCS_PROFILE_CALL(uct_md_mkey_pack,
+                         ucp_ep_md(ep, ucp_ep_get_rndv_get_lane(ep)),
+                         rndv_req->send.state.dt.contig.memh, rndv_rtr_hdr + 1);
+        rndv_rtr_hdr->flags |= UCP_RNDV_RTR_FLAG_PACKED_RKEY;
+        packed_len += ucp_ep_md_attr(ep, ucp_ep_get_rndv_get_lane(ep))->rkey_packed_size;
+    }
+
+    return packed_len;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_rtr_put, (self),
+                 uct_pending_req_t *self)
+{
+    /* send the RTR with the address (and rkey) of the receive buffer. unlike
+     * the AM flavor of the RTR, the rndv_req is kept alive until the ATP
+     * arrives, since it holds the receive buffer registration */
+    return ucp_do_am_bcopy_single(self, UCP_AM_ID_RNDV_RTR,
+                                  ucp_tag_rndv_rtr_put_pack);
+}
+
 void ucp_tag_send_start_rndv(ucp_request_t *sreq)
 {
     ucs_trace_req("starting rndv. sreq: %p. buffer: %p, length: %zu",
@@ -133,6 +213,8 @@ void ucp_tag_send_start_rndv(ucp_request_t *sreq)
     }
 
     sreq->send.uct.func = ucp_proto_progress_rndv_rts;
+    UCS_USDT_PROBE3(rndv_rts_send, sreq->send.ep, sreq->send.tag,
+                    sreq->send.length);
 }
 
 static void ucp_rndv_send_ats(ucp_request_t *rndv_req, uintptr_t remote_request)
@@ -173,6 +255,53 @@ static void ucp_rndv_complete_rndv_get(ucp_request_t *rndv_req)
     ucp_rndv_send_ats(rndv_req, rndv_req->send.rndv_get.remote_request);
 }
 
+/* Number of maximal-size GET fragments above which chunk-by-chunk
+ * registration is used when RNDV_PIPELINE_THRESH is "auto" */
+#define UCP_RNDV_PIPELINE_AUTO_FRAGS    4
+
+/*
+ * Tracks one chunk of a pipelined rendezvous get - the chunk is registered
+ * right before its GET is issued and deregistered when the GET completes,
+ * so registration of the next chunk overlaps the wire time of this one.
+ */
+typedef struct {
+    uct_completion_t      uct_comp; /* Completion of this chunk's GET */
+    ucp_request_t         *rndv_req;
+    uct_md_h              md;
+    uct_mem_h             memh;
+} ucp_rndv_get_frag_t;
+
+static void ucp_rndv_get_frag_completion(uct_completion_t *self,
+                                         ucs_status_t status)
+{
+    ucp_rndv_get_frag_t *frag = ucs_container_of(self, ucp_rndv_get_frag_t,
+                                                 uct_comp);
+    ucp_request_t *rndv_req   = frag->rndv_req;
+
+    uct_md_mem_dereg(frag->md, frag->memh);
+    ucs_free(frag);
+
+    uct_invoke_completion_n(&rndv_req->send.uct_comp, 1, status);
+}
+
+/* Chunk-by-chunk registration pays off only when the registration latency of
+ * the whole buffer is large compared to the wire time of one fragment */
+static int ucp_rndv_is_get_pipeline(ucp_request_t *rndv_req)
+{
+    ucp_context_h context = rndv_req->send.ep->worker->context;
+    size_t thresh         = context->config.ext.rndv_pipeline_thresh;
+    size_t max_frag       = ucp_ep_config(rndv_req->send.ep)->rndv.max_get_zcopy;
+
+    if (thresh == UCS_CONFIG_MEMUNITS_AUTO) {
+        if (max_frag >= (SIZE_MAX / UCP_RNDV_PIPELINE_AUTO_FRAGS)) {
+            return 0;
+        }
+        thresh = max_frag * UCP_RNDV_PIPELINE_AUTO_FRAGS;
+    }
+
+    return rndv_req->send.length >= thresh;
+}
+
 static ucs_status_t ucp_rndv_truncated(uct_pending_req_t *self)
 {
     ucp_request_t *rndv_req = ucs_container_of(self, ucp_request_t, send.uct);
@@ -213,10 +342,13 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_get_zcopy, (self),
                  uct_pending_req_t *self)
 {
     ucp_request_t *rndv_req = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_rndv_get_frag_t *frag = NULL;
     ucs_status_t status;
     size_t offset, length, ucp_mtu, align;
     uct_iov_t iov[1];
     ucp_rsc_index_t rsc_index;
+    ucp_ep_config_t *config;
+    int pipeline;
 
     if (ucp_ep_is_stub(rndv_req->send.ep)) {
         return UCS_ERR_NO_RESOURCE;
@@ -235,8 +367,13 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_get_zcopy, (self),
         return UCS_INPROGRESS;
     }
 
-    /* reset the lane to rndv since it might have been set to 0 since it was stub on RTS receive */
-    rndv_req->send.lane = ucp_ep_get_rndv_get_lane(rndv_req->send.ep);
+    /* stripe the fragments round-robin over the rndv lanes; they all share
+     * a memory domain with the primary rndv lane, so the same memh and rkey
+     * are valid on every lane */
+    config = ucp_ep_config(rndv_req->send.ep);
+    rndv_req->send.lane =
+            config->rndv.lanes[rndv_req->send.rndv_get.lane_idx %
+                               config->rndv.num_lanes];
     rsc_index = ucp_ep_get_rsc_index(rndv_req->send.ep, rndv_req->send.lane);
     align     = rndv_req->send.ep->worker->iface_attrs[rsc_index].cap.get.opt_zcopy_align;
     ucp_mtu   = rndv_req->send.ep->worker->iface_attrs[rsc_index].cap.get.align_mtu;
@@ -244,8 +381,11 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_get_zcopy, (self),
     ucs_trace_data("ep: %p try to progress get_zcopy for rndv get. rndv_req: %p. lane: %d",
                    rndv_req->send.ep, rndv_req, rndv_req->send.lane);
 
+    pipeline = ucp_rndv_is_get_pipeline(rndv_req);
+
     /* rndv_req is the internal request to perform the get operation */
-    if (rndv_req->send.state.dt.contig.memh == UCT_MEM_HANDLE_NULL) {
+    if (!pipeline &&
+        (rndv_req->send.state.dt.contig.memh == UCT_MEM_HANDLE_NULL)) {
         /* TODO Not all UCTs need registration on the recv side */
         UCS_PROFILE_REQUEST_EVENT(rndv_req->send.rndv_get.rreq, "rndv_recv_reg", 0);
         status = ucp_request_send_buffer_reg(rndv_req, rndv_req->send.lane);
@@ -266,37 +406,66 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_get_zcopy, (self),
                    offset, (uintptr_t)rndv_req->send.buffer % align,
                    (void*)rndv_req->send.buffer + offset, length);
 
+    if (pipeline) {
+        /* register only the current chunk, so the next chunk's registration
+         * overlaps this chunk's wire time */
+        frag = ucs_malloc(sizeof(*frag), "rndv_get_frag");
+        if (frag == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+        frag->rndv_req       = rndv_req;
+        frag->md             = ucp_ep_md(rndv_req->send.ep, rndv_req->send.lane);
+        frag->uct_comp.func  = ucp_rndv_get_frag_completion;
+        frag->uct_comp.count = 1;
+        UCS_PROFILE_REQUEST_EVENT(rndv_req->send.rndv_get.rreq, "rndv_recv_reg",
+                                  length);
+        status = uct_md_mem_reg(frag->md,
+                                (void*)rndv_req->send.buffer + offset, length,
+                                0, &frag->memh);
+        ucs_assert_always(status == UCS_OK);
+    }
+
     iov[0].buffer = (void*)rndv_req->send.buffer + offset;
     iov[0].length = length;
-    iov[0].memh   = rndv_req->send.state.dt.contig.memh;
+    iov[0].memh   = pipeline ? frag->memh : rndv_req->send.state.dt.contig.memh;
     iov[0].count  = 1;
     iov[0].stride = 0;
     rndv_req->send.uct_comp.count++;
-    status = uct_ep_get_zcopy(ucp_ep_get_rndv_data_uct_ep(rndv_req->send.ep),
+    status = uct_ep_get_zcopy(rndv_req->send.ep->uct_eps[rndv_req->send.lane],
                               iov, 1,
                               rndv_req->send.rndv_get.remote_address + offset,
                               rndv_req->send.rndv_get.rkey_bundle.rkey,
-                              &rndv_req->send.uct_comp);
+                              pipeline ? &frag->uct_comp :
+                                         &rndv_req->send.uct_comp);
 
     if ((status == UCS_OK) || (status == UCS_INPROGRESS)) {
         UCS_PROFILE_REQUEST_EVENT(rndv_req->send.rndv_get.rreq, "rndv_get_zcopy",
                                   iov[0].length);
         rndv_req->send.state.offset += length;
+        rndv_req->send.rndv_get.lane_idx++;
+        if ((status == UCS_OK) && pipeline) {
+            /* the zcopy operation was locally-completed, so the frag's uct_comp
+             * callback won't be called - release the chunk here. the initial
+             * count of 1 keeps the request alive until all fragments are sent */
+            ucp_rndv_get_frag_completion(&frag->uct_comp, UCS_OK);
+        }
         if (rndv_req->send.state.offset == rndv_req->send.length) {
-            rndv_req->send.uct_comp.count--; /* sent all fragments */
-            if (status == UCS_OK) {
-                /* if the zcopy operation was locally-completed, the uct_comp callback
-                 * won't be called, so do the completion procedure here */
-                rndv_req->send.uct_comp.count--;
-            }
-            if (rndv_req->send.uct_comp.count == 0) {
-                ucp_rndv_complete_rndv_get(rndv_req);
-            }
+            /* all fragments were sent; if the last zcopy operation was
+             * locally-completed its uct_comp callback won't be called, so
+             * retire it here together with the initial refcount, in one
+             * update of the shared counter */
+            uct_invoke_completion_n(&rndv_req->send.uct_comp,
+                                    ((status == UCS_OK) && !pipeline) ? 2 : 1,
+                                    UCS_OK);
             return UCS_OK;
         } else {
             return UCS_INPROGRESS;
         }
     } else {
+       if (pipeline) {
+           uct_md_mem_dereg(frag->md, frag->memh);
+           ucs_free(frag);
+       }
        rndv_req->send.uct_comp.count--;
        return status;
     }
@@ -311,6 +480,138 @@ UCS_PROFILE_FUNC_VOID(ucp_rndv_get_completion, (self, status),
     ucp_rndv_complete_rndv_get(rndv_req);
 }
 
+static size_t ucp_rndv_atp_pack(void *dest, void *arg)
+{
+    ucp_reply_hdr_t *atp_hdr = dest;
+    ucp_request_t *sreq      = arg;
+
+    atp_hdr->reqptr = sreq->send.proto.remote_request;
+    atp_hdr->status = sreq->send.proto.status;
+    return sizeof(*atp_hdr);
+}
+
+static ucs_status_t ucp_rndv_progress_atp(uct_pending_req_t *self)
+{
+    ucp_request_t *sreq = ucs_container_of(self, ucp_request_t, send.uct);
+    ucs_status_t status;
+
+    /* send the ATP, and complete the original send request */
+    status = ucp_do_am_bcopy_single(self, UCP_AM_ID_RNDV_ATP, ucp_rndv_atp_pack);
+    if (status == UCS_OK) {
+        ucp_request_complete_send(sreq, UCS_OK);
+    }
+
+    return status;
+}
+
+static void ucp_rndv_complete_rndv_put(ucp_request_t *sreq)
+{
+    uintptr_t rreq_ptr = sreq->send.rndv_put.rreq_ptr;
+
+    ucs_assertv(sreq->send.state.offset == sreq->send.length,
+                "sreq=%p offset=%zu length=%zu", sreq,
+                sreq->send.state.offset, sreq->send.length);
+
+    ucs_trace_data("ep: %p rndv put completed", sreq->send.ep);
+
+    UCS_PROFILE_REQUEST_EVENT(sreq, "complete_rndv_put", 0);
+
+    if (sreq->send.rndv_put.rkey_bundle.rkey != UCT_INVALID_RKEY) {
+        uct_rkey_release(&sreq->send.rndv_put.rkey_bundle);
+    }
+
+    ucp_rndv_rma_request_send_buffer_dereg(sreq);
+
+    /* send the ATP so that the receiver would complete its receive request */
+    sreq->send.lane                 = ucp_ep_get_am_lane(sreq->send.ep);
+    sreq->send.uct.func             = ucp_rndv_progress_atp;
+    sreq->send.proto.remote_request = rreq_ptr;
+    sreq->send.proto.status         = UCS_OK;
+    ucp_request_start_send(sreq);
+}
+
+UCS_PROFILE_FUNC_VOID(ucp_rndv_put_completion, (self, status),
+                      uct_completion_t *self, ucs_status_t status)
+{
+    ucp_request_t *sreq = ucs_container_of(self, ucp_request_t, send.uct_comp);
+
+    ucs_trace_req("completed rndv put operation sreq: %p", sreq);
+    ucp_rndv_complete_rndv_put(sreq);
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_proto_progress_rndv_put_zcopy, (self),
+                 uct_pending_req_t *self)
+{
+    ucp_request_t *sreq = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_h ep         = sreq->send.ep;
+    ucs_status_t status;
+    size_t offset, length, ucp_mtu, align;
+    uct_iov_t iov[1];
+    ucp_rsc_index_t rsc_index;
+
+    rsc_index = ucp_ep_get_rsc_index(ep, sreq->send.lane);
+    align     = ep->worker->iface_attrs[rsc_index].cap.put.opt_zcopy_align;
+    ucp_mtu   = ep->worker->iface_attrs[rsc_index].cap.put.align_mtu;
+
+    ucs_trace_data("ep: %p try to progress put_zcopy for rndv put. sreq: %p. lane: %d",
+                   ep, sreq, sreq->send.lane);
+
+    /* register the send buffer, unless it was already registered for the RTS */
+    if (sreq->send.state.dt.contig.memh == UCT_MEM_HANDLE_NULL) {
+        UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_send_reg", 0);
+        status = ucp_request_send_buffer_reg(sreq, sreq->send.lane);
+        ucs_assert_always(status == UCS_OK);
+    }
+
+    offset = sreq->send.state.offset;
+
+    if ((offset == 0) && ((uintptr_t)sreq->send.buffer % align) &&
+        (sreq->send.length > ucp_mtu )) {
+        length = ucp_mtu - ((uintptr_t)sreq->send.buffer % align);
+    } else {
+        length = ucs_min(sreq->send.length - offset,
+                         ucp_ep_config(ep)->rndv.max_put_zcopy);
+    }
+
+    ucs_trace_data("offset %zu remainder %zu. write from %p len %zu",
+                   offset, (uintptr_t)sreq->send.buffer % align,
+                   (void*)sreq->send.buffer + offset, length);
+
+    iov[0].buffer = (void*)sreq->send.buffer + offset;
+    iov[0].length = length;
+    iov[0].memh   = sreq->send.state.dt.contig.memh;
+    iov[0].count  = 1;
+    iov[0].stride = 0;
+    sreq->send.uct_comp.count++;
+    status = uct_ep_put_zcopy(ep->uct_eps[sreq->send.lane],
+                              iov, 1,
+                              sreq->send.rndv_put.remote_address + offset,
+                              sreq->send.rndv_put.rkey_bundle.rkey,
+                              &sreq->send.uct_comp);
+
+    if ((status == UCS_OK) || (status == UCS_INPROGRESS)) {
+        UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_put_zcopy", iov[0].length);
+        sreq->send.state.offset += length;
+        if (sreq->send.state.offset == sreq->send.length) {
+            sreq->send.uct_comp.count--; /* sent all fragments */
+            if (status == UCS_OK) {
+                /* if the zcopy operation was locally-completed, the uct_comp callback
+                 * won't be called, so do the completion procedure here */
+                sreq->send.uct_comp.count--;
+            }
+            if (sreq->send.uct_comp.count == 0) {
+                ucp_rndv_complete_rndv_put(sreq);
+            }
+            return UCS_OK;
+        } else {
+            return UCS_INPROGRESS;
+        }
+    } else {
+       sreq->send.uct_comp.count--;
+       return status;
+    }
+}
+
 static void ucp_rndv_handle_recv_contig(ucp_request_t *rndv_req, ucp_request_t *rreq,
                                         ucp_rndv_rts_hdr_t *rndv_rts_hdr)
 {
@@ -323,6 +624,7 @@ static void ucp_rndv_handle_recv_contig(ucp_request_t *rndv_req, ucp_request_t *
     rndv_req->send.rndv_get.remote_request = rndv_rts_hdr->sreq.reqptr;
     rndv_req->send.rndv_get.remote_address = rndv_rts_hdr->address;
     rndv_req->send.rndv_get.rreq = rreq;
+    rndv_req->send.rndv_get.lane_idx = 0;
 
     if (ucs_unlikely(rreq->recv.length < rndv_rts_hdr->size)) {
         ucs_trace_req("rndv msg truncated: rndv_req: %p. received %zu. "
@@ -349,6 +651,49 @@ static void ucp_rndv_handle_recv_contig(ucp_request_t *rndv_req, ucp_request_t *
     ucp_request_start_send(rndv_req);
 }
 
+static void ucp_rndv_handle_recv_put(ucp_request_t *rndv_req, ucp_request_t *rreq,
+                                     ucp_rndv_rts_hdr_t *rndv_rts_hdr)
+{
+    ucp_ep_h ep = rndv_req->send.ep;
+    ucs_status_t status;
+
+    ucs_trace_req("ucp_rndv_handle_recv_put rndv_req %p rreq %p", rndv_req,
+                  rreq);
+
+    if (ucs_unlikely(rreq->recv.length < rndv_rts_hdr->size)) {
+        ucs_trace_req("rndv msg truncated: rndv_req: %p. received %zu. "
+                      "expected %zu on rreq: %p ",
+                      rndv_req, rndv_rts_hdr->size, rreq->recv.length, rreq);
+        rndv_req->send.uct.func  = ucp_rndv_truncated;
+        rndv_req->send.lane      = ucp_ep_get_am_lane(ep);
+        rndv_req->send.proto.remote_request = rndv_rts_hdr->sreq.reqptr;
+        rndv_req->send.proto.rreq_ptr       = (uintptr_t) rreq;
+        ucp_request_start_send(rndv_req);
+        return;
+    }
+
+    /* rndv_req is the request that would send the RTR message to the sender,
+     * and hold the receive buffer registration until the ATP arrives */
+    rndv_req->send.uct.func   = ucp_proto_progress_rndv_rtr_put;
+    rndv_req->send.lane       = ucp_ep_get_am_lane(ep);
+    rndv_req->send.buffer     = rreq->recv.buffer;
+    rndv_req->send.datatype   = ucp_dt_make_contig(1);
+    rndv_req->send.length     = rndv_rts_hdr->size;
+    rndv_req->send.rndv_get.remote_request = rndv_rts_hdr->sreq.reqptr;
+    rndv_req->send.rndv_get.rreq           = rreq;
+    rndv_req->send.state.dt.contig.memh    = UCT_MEM_HANDLE_NULL;
+
+    /* register the receive buffer, so its rkey would be sent in the RTR */
+    if (ucp_ep_rndv_md_flags(ep) & UCT_MD_FLAG_NEED_RKEY) {
+        UCS_PROFILE_REQUEST_EVENT(rreq, "rndv_recv_reg", 0);
+        status = ucp_request_send_buffer_reg(rndv_req,
+                                             ucp_ep_get_rndv_get_lane(ep));
+        ucs_assert_always(status == UCS_OK);
+    }
+
+    ucp_request_start_send(rndv_req);
+}
+
 static void ucp_rndv_handle_recv_am(ucp_request_t *rndv_req, ucp_request_t *rreq,
                                     ucp_rndv_rts_hdr_t *rndv_rts_hdr)
 {
@@ -370,6 +715,8 @@ UCS_PROFILE_FUNC_VOID(ucp_rndv_matched, (worker, rreq, rndv_rts_hdr),
     UCS_ASYNC_BLOCK(&worker->async);
 
     UCS_PROFILE_REQUEST_EVENT(rreq, "rndv_match", 0);
+    UCS_USDT_PROBE3(rndv_matched, rreq, rndv_rts_hdr->super.tag,
+                    rndv_rts_hdr->size);
 
     /* rreq is the receive request on the receiver's side */
     rreq->recv.info.sender_tag = rndv_rts_hdr->super.tag;
@@ -397,7 +744,12 @@ UCS_PROFILE_FUNC_VOID(ucp_rndv_matched, (worker, rreq, rndv_rts_hdr),
     }
 
     if (UCP_DT_IS_CONTIG(rreq->recv.datatype)) {
-        if ((rndv_rts_hdr->address != 0) && ucp_ep_is_rndv_lane_present(ep)) {
+        if ((rndv_rts_hdr->address != 0) && !ucp_ep_is_stub(ep) &&
+            ucp_tag_rndv_is_put_rndv(ep)) {
+            /* the rndv lane can't read the data with get_zcopy - ask the
+             * sender to write it with put_zcopy instead */
+            ucp_rndv_handle_recv_put(rndv_req, rreq, rndv_rts_hdr);
+        } else if ((rndv_rts_hdr->address != 0) && ucp_ep_is_rndv_lane_present(ep)) {
             /* read the data from the sender with a get_zcopy operation on the
              * rndv lane */
             ucp_rndv_handle_recv_contig(rndv_req, rreq, rndv_rts_hdr);
@@ -457,6 +809,7 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_ats_handler,
 
     /* dereg the original send request and set it to complete */
     UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_ats_recv", 0);
+    UCS_USDT_PROBE2(rndv_ats_recv, sreq, sreq->send.length);
     ucp_rndv_rma_request_send_buffer_dereg(sreq);
     ucp_request_send_generic_dt_finish(sreq);
     ucp_request_complete_send(sreq, UCS_OK);
@@ -506,6 +859,304 @@ static size_t ucp_rndv_pack_multi_data_last(void *dest, void *arg)
                                       length);
 }
 
+/*
+ * Pipelined bcopy send of a generic datatype: one fragment is staged in one
+ * half of a bounce buffer while the other half holds the fragment currently
+ * being sent. The next fragment is packed right after the current one is
+ * handed to the transport, so the (potentially expensive) generic pack
+ * callback overlaps the wire time of the preceding fragment instead of
+ * serializing with it.
+ */
+typedef struct {
+    size_t                    frag_size;   /* Fragment payload size */
+    size_t                    frag_length; /* Bytes staged for the next send */
+    size_t                    send_offset; /* Payload offset of the staged fragment */
+    unsigned                  stage_idx;   /* Buffer half holding the staged fragment */
+    char                      buffer[0];   /* Two halves of frag_size bytes each */
+} ucp_rndv_ppln_t;
+
+static size_t ucp_rndv_ppln_frag_size(ucp_ep_h ep)
+{
+    ucp_worker_h worker          = ep->worker;
+    ucp_rsc_index_t rsc_index    = ucp_ep_get_rsc_index(ep,
+                                                        ucp_ep_get_am_lane(ep));
+    uct_iface_attr_t *iface_attr = &worker->iface_attrs[rsc_index];
+    size_t max_frag              = ucp_ep_config(ep)->am.max_bcopy -
+                                   sizeof(ucp_rndv_data_hdr_t);
+    double bdp;
+
+    /* a fragment should cover roughly the bandwidth-delay product, so one
+     * fragment is on the wire while the next one is being packed */
+    bdp = iface_attr->bandwidth *
+          (ucp_tl_iface_latency(worker->context, iface_attr) +
+           iface_attr->overhead);
+    return ucs_min(ucs_max((size_t)bdp, UCS_KBYTE), max_frag);
+}
+
+static void ucp_rndv_ppln_stage(ucp_request_t *sreq)
+{
+    ucp_rndv_ppln_t *ppln = sreq->send.proto.ppln;
+
+    ppln->send_offset = sreq->send.state.offset;
+    ppln->frag_length = ucp_dt_pack(sreq->send.datatype,
+                                    ppln->buffer +
+                                    (ppln->stage_idx * ppln->frag_size),
+                                    sreq->send.buffer, &sreq->send.state,
+                                    ucs_min(ppln->frag_size,
+                                            sreq->send.length -
+                                            sreq->send.state.offset));
+}
+
+static size_t ucp_rndv_ppln_copy_data(void *dest, void *arg)
+{
+    ucp_rndv_data_hdr_t *hdr = dest;
+    ucp_request_t *sreq = arg;
+    ucp_rndv_ppln_t *ppln = sreq->send.proto.ppln;
+
+    hdr->rreq_ptr = sreq->send.proto.rreq_ptr;
+    memcpy(hdr + 1, ppln->buffer + (ppln->stage_idx * ppln->frag_size),
+           ppln->frag_length);
+    return sizeof(*hdr) + ppln->frag_length;
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_progress_bcopy_pipeline, (self),
+                 uct_pending_req_t *self)
+{
+    ucp_request_t *sreq   = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_t *ep          = sreq->send.ep;
+    ucp_rndv_ppln_t *ppln = sreq->send.proto.ppln;
+    ssize_t packed_len;
+    int last;
+
+    sreq->send.lane = ucp_ep_get_am_lane(ep);
+
+    last       = (ppln->send_offset + ppln->frag_length) == sreq->send.length;
+    packed_len = uct_ep_am_bcopy(ep->uct_eps[sreq->send.lane],
+                                 last ? UCP_AM_ID_RNDV_DATA_LAST :
+                                        UCP_AM_ID_RNDV_DATA,
+                                 ucp_rndv_ppln_copy_data, sreq);
+    if (packed_len < 0) {
+        /* the staged fragment is kept - a retry resends it without repacking */
+        return packed_len;
+    }
+
+    UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_ppln_frag", packed_len);
+
+    if (last) {
+        ucs_free(ppln);
+        sreq->send.proto.ppln = NULL;
+        ucp_request_send_generic_dt_finish(sreq);
+        ucp_request_complete_send(sreq, UCS_OK);
+        return UCS_OK;
+    }
+
+    /* pack the next fragment while the one just posted is on the wire */
+    ppln->stage_idx ^= 1;
+    ucp_rndv_ppln_stage(sreq);
+    return UCS_INPROGRESS;
+}
+
+static void ucp_rndv_ppln_start(ucp_request_t *sreq)
+{
+    size_t frag_size = ucp_rndv_ppln_frag_size(sreq->send.ep);
+    ucp_rndv_ppln_t *ppln;
+
+    ppln = ucs_malloc(sizeof(*ppln) + (2 * frag_size), "rndv_ppln");
+    if (ppln == NULL) {
+        /* keep the serialized pack-and-send fallback */
+        return;
+    }
+
+    ppln->frag_size       = frag_size;
+    ppln->stage_idx       = 0;
+    sreq->send.proto.ppln = ppln;
+    ucp_rndv_ppln_stage(sreq);
+    sreq->send.uct.func   = ucp_rndv_progress_bcopy_pipeline;
+}
+
+#if HAVE_CUDA
+/*
+ * Staged GPU pipeline: the send buffer lives in device memory and the data
+ * cannot go straight from the GPU to the wire, so fragments are streamed
+ * through a pinned host bounce buffer - the device-to-host copy of one
+ * fragment overlaps the wire time of the previous one. Each stage moves
+ * every byte exactly once, so throughput converges to the slower of PCIe
+ * and the wire instead of their serialized sum.
+ */
+typedef struct {
+    size_t              frag_size;      /* Fragment payload size */
+    size_t              frag_length[2]; /* Bytes staged in each half */
+    size_t              send_offset[2]; /* Payload offset of each half */
+    size_t              stage_offset;   /* Next payload offset to stage */
+    unsigned            send_idx;       /* Half to be sent next */
+    cudaStream_t        stream;         /* Staging copies, in order */
+    cudaEvent_t         event[2];       /* Completion of each half's copy */
+    char                *buffer;        /* Pinned host buffer, two halves */
+} ucp_rndv_cuda_ppln_t;
+
+static size_t ucp_rndv_cuda_ppln_frag_size(ucp_ep_h ep)
+{
+    ucp_worker_h worker          = ep->worker;
+    ucp_rsc_index_t rsc_index    = ucp_ep_get_rsc_index(ep,
+                                                        ucp_ep_get_am_lane(ep));
+    uct_iface_attr_t *iface_attr = &worker->iface_attrs[rsc_index];
+    size_t max_frag              = ucp_ep_config(ep)->am.max_bcopy -
+                                   sizeof(ucp_rndv_data_hdr_t);
+    double bdp;
+
+    /* a fragment covers the bandwidth-delay product of the wire, with a
+     * higher floor than the CPU pipeline - PCIe copies need larger chunks
+     * before the DMA engine reaches full bandwidth */
+    bdp = iface_attr->bandwidth *
+          (ucp_tl_iface_latency(worker->context, iface_attr) +
+           iface_attr->overhead);
+    return ucs_min(ucs_max((size_t)bdp, 64 * UCS_KBYTE), max_frag);
+}
+
+static void ucp_rndv_cuda_ppln_destroy(ucp_request_t *sreq)
+{
+    ucp_rndv_cuda_ppln_t *ppln = sreq->send.proto.ppln;
+
+    cudaEventDestroy(ppln->event[0]);
+    cudaEventDestroy(ppln->event[1]);
+    cudaStreamDestroy(ppln->stream);
+    cudaFreeHost(ppln->buffer);
+    ucs_free(ppln);
+    sreq->send.proto.ppln = NULL;
+}
+
+static void ucp_rndv_cuda_ppln_stage(ucp_request_t *sreq, unsigned idx)
+{
+    ucp_rndv_cuda_ppln_t *ppln = sreq->send.proto.ppln;
+    size_t length = ucs_min(ppln->frag_size,
+                            sreq->send.length - ppln->stage_offset);
+
+    ppln->send_offset[idx] = ppln->stage_offset;
+    ppln->frag_length[idx] = length;
+    cudaMemcpyAsync(ppln->buffer + (idx * ppln->frag_size),
+                    sreq->send.buffer + ppln->stage_offset, length,
+                    cudaMemcpyDeviceToHost, ppln->stream);
+    cudaEventRecord(ppln->event[idx], ppln->stream);
+    ppln->stage_offset += length;
+}
+
+static size_t ucp_rndv_cuda_ppln_pack_data(void *dest, void *arg)
+{
+    ucp_rndv_data_hdr_t *hdr = dest;
+    ucp_request_t *sreq = arg;
+    ucp_rndv_cuda_ppln_t *ppln = sreq->send.proto.ppln;
+    unsigned idx = ppln->send_idx;
+
+    hdr->rreq_ptr = sreq->send.proto.rreq_ptr;
+    memcpy(hdr + 1, ppln->buffer + (idx * ppln->frag_size),
+           ppln->frag_length[idx]);
+    return sizeof(*hdr) + ppln->frag_length[idx];
+}
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_progress_cuda_pipeline, (self),
+                 uct_pending_req_t *self)
+{
+    ucp_request_t *sreq        = ucs_container_of(self, ucp_request_t, send.uct);
+    ucp_ep_t *ep               = sreq->send.ep;
+    ucp_rndv_cuda_ppln_t *ppln = sreq->send.proto.ppln;
+    unsigned idx               = ppln->send_idx;
+    ssize_t packed_len;
+    cudaError_t result;
+    int last;
+
+    sreq->send.lane = ucp_ep_get_am_lane(ep);
+
+    result = cudaEventQuery(ppln->event[idx]);
+    if (result == cudaErrorNotReady) {
+        /* the fragment is still crossing PCIe - try again on the next
+         * progress pass */
+        return UCS_INPROGRESS;
+    } else if (result != cudaSuccess) {
+        ucs_error("cuda staging copy failed: %s", cudaGetErrorString(result));
+        ucp_rndv_cuda_ppln_destroy(sreq);
+        ucp_request_complete_send(sreq, UCS_ERR_IO_ERROR);
+        return UCS_OK;
+    }
+
+    last       = (ppln->send_offset[idx] + ppln->frag_length[idx]) ==
+                 sreq->send.length;
+    packed_len = uct_ep_am_bcopy(ep->uct_eps[sreq->send.lane],
+                                 last ? UCP_AM_ID_RNDV_DATA_LAST :
+                                        UCP_AM_ID_RNDV_DATA,
+                                 ucp_rndv_cuda_ppln_pack_data, sreq);
+    if (packed_len < 0) {
+        /* the staged fragment is kept - a retry resends it without restaging */
+        return packed_len;
+    }
+
+    UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_cuda_frag", packed_len);
+
+    if (last) {
+        ucp_rndv_cuda_ppln_destroy(sreq);
+        ucp_request_complete_send(sreq, UCS_OK);
+        return UCS_OK;
+    }
+
+    if (ppln->stage_offset < sreq->send.length) {
+        /* refill the half just sent while the wire drains the other one */
+        ucp_rndv_cuda_ppln_stage(sreq, idx);
+    }
+    ppln->send_idx = idx ^ 1;
+    return UCS_INPROGRESS;
+}
+
+static ucs_status_t ucp_rndv_cuda_ppln_start(ucp_request_t *sreq)
+{
+    size_t frag_size = ucp_rndv_cuda_ppln_frag_size(sreq->send.ep);
+    ucp_rndv_cuda_ppln_t *ppln;
+
+    ppln = ucs_malloc(sizeof(*ppln), "rndv_cuda_ppln");
+    if (ppln == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    if (cudaHostAlloc((void**)&ppln->buffer, 2 * frag_size,
+                      cudaHostAllocDefault) != cudaSuccess) {
+        goto err_free_ppln;
+    }
+    if (cudaStreamCreateWithFlags(&ppln->stream,
+                                  cudaStreamNonBlocking) != cudaSuccess) {
+        goto err_free_buffer;
+    }
+    if (cudaEventCreateWithFlags(&ppln->event[0],
+                                 cudaEventDisableTiming) != cudaSuccess) {
+        goto err_destroy_stream;
+    }
+    if (cudaEventCreateWithFlags(&ppln->event[1],
+                                 cudaEventDisableTiming) != cudaSuccess) {
+        goto err_destroy_event;
+    }
+
+    ppln->frag_size       = frag_size;
+    ppln->stage_offset    = 0;
+    ppln->send_idx        = 0;
+    sreq->send.proto.ppln = ppln;
+
+    /* keep both halves in flight from the start */
+    ucp_rndv_cuda_ppln_stage(sreq, 0);
+    if (ppln->stage_offset < sreq->send.length) {
+        ucp_rndv_cuda_ppln_stage(sreq, 1);
+    }
+    sreq->send.uct.func = ucp_rndv_progress_cuda_pipeline;
+    return UCS_OK;
+
+err_destroy_event:
+    cudaEventDestroy(ppln->event[0]);
+err_destroy_stream:
+    cudaStreamDestroy(ppln->stream);
+err_free_buffer:
+    cudaFreeHost(ppln->buffer);
+err_free_ppln:
+    ucs_free(ppln);
+    return UCS_ERR_NO_MEMORY;
+}
+#endif
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_progress_bcopy_send, (self),
                  uct_pending_req_t *self)
 {
@@ -621,6 +1272,32 @@ static void ucp_rndv_prepare_zcopy(ucp_request_t *sreq, ucp_ep_h ep)
     }
 }
 
+static void ucp_rndv_handle_rtr_put(ucp_request_t *sreq,
+                                    ucp_rndv_rtr_hdr_t *rndv_rtr_hdr)
+{
+    ucp_ep_h ep = sreq->send.ep;
+
+    ucs_trace_req("ucp_rndv_handle_rtr_put sreq %p", sreq);
+
+    ucs_assert_always(ucp_tag_rndv_iface_flags(ep) & UCT_IFACE_FLAG_PUT_ZCOPY);
+
+    sreq->send.rndv_put.remote_address = rndv_rtr_hdr->address;
+    sreq->send.rndv_put.rreq_ptr       = rndv_rtr_hdr->rreq_ptr;
+    if (rndv_rtr_hdr->flags & UCP_RNDV_RTR_FLAG_PACKED_RKEY) {
+        UCS_PROFILE_CALL(uct_rkey_unpack, rndv_rtr_hdr + 1,
+                         &sreq->send.rndv_put.rkey_bundle);
+    } else {
+        sreq->send.rndv_put.rkey_bundle.rkey = UCT_INVALID_RKEY;
+    }
+
+    sreq->send.lane           = ucp_ep_get_rndv_get_lane(ep);
+    sreq->send.uct.func       = ucp_proto_progress_rndv_put_zcopy;
+    sreq->send.uct_comp.func  = ucp_rndv_put_completion;
+    sreq->send.uct_comp.count = 1; /* start from 1 for avoid completion
+                                      until all fragments are sent */
+    sreq->send.state.offset   = 0;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_rtr_handler,
                  (arg, data, length, flags),
                  void *arg, void *data, size_t length, unsigned flags)
@@ -628,29 +1305,77 @@ UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_rtr_handler,
     ucp_rndv_rtr_hdr_t *rndv_rtr_hdr = data;
     ucp_request_t *sreq = (ucp_request_t*) rndv_rtr_hdr->sreq_ptr;
     ucp_ep_h ep = sreq->send.ep;
+#if HAVE_CUDA
+    ucs_status_t status;
+#endif
 
     /* make sure that the ep on which the rtr was received on is connected */
     ucs_assert_always(!ucp_ep_is_stub(ep));
     ucs_trace_req("RTR received. start sending on sreq %p", sreq);
 
-    if ((UCP_DT_IS_CONTIG(sreq->send.datatype)) &&
-        (sreq->send.length >= ucp_ep_config(ep)->am.zcopy_thresh[0])) {
+    UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_rtr_recv", 0);
+
+    if ((rndv_rtr_hdr->address != 0) &&
+        (UCP_DT_IS_CONTIG(sreq->send.datatype)) &&
+        ucp_ep_is_rndv_lane_present(ep)) {
+        /* the receiver provided the address of its buffer - write the data
+         * to it with put_zcopy operations on the rndv lane */
+        ucp_rndv_handle_rtr_put(sreq, rndv_rtr_hdr);
+#if HAVE_CUDA
+    } else if ((UCP_DT_IS_CONTIG(sreq->send.datatype)) &&
+               ucs_unlikely(ucp_memory_is_cuda(sreq->send.buffer))) {
+        /* the receiver cannot pull the data and there is no peer-direct
+         * push path - stream the device memory through pinned host
+         * fragments. The CPU can neither pack it nor register it for the
+         * am zcopy path below */
+        ucp_rndv_rma_request_send_buffer_dereg(sreq);
+        sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
+        status = ucp_rndv_cuda_ppln_start(sreq);
+        if (status != UCS_OK) {
+            ucp_request_complete_send(sreq, status);
+            return UCS_OK;
+        }
+#endif
+    } else if ((UCP_DT_IS_CONTIG(sreq->send.datatype)) &&
+               (sreq->send.length >= ucp_ep_config(ep)->am.zcopy_thresh[0])) {
         /* send with zcopy */
         ucp_rndv_prepare_zcopy(sreq, ep);
+        sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
     } else {
         /* send with bcopy */
         /* deregister the sender's buffer if it was registered */
         ucp_rndv_rma_request_send_buffer_dereg(sreq);
 
-        sreq->send.uct.func = ucp_rndv_progress_bcopy_send;
+        sreq->send.uct.func       = ucp_rndv_progress_bcopy_send;
+        sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
+        if (UCP_DT_IS_GENERIC(sreq->send.datatype) &&
+            (sreq->send.length > ucp_ep_config(ep)->am.max_bcopy -
+                                 sizeof(ucp_rndv_data_hdr_t))) {
+            /* multiple fragments of a generic datatype - pipeline the pack */
+            ucp_rndv_ppln_start(sreq);
+        }
     }
 
-    UCS_PROFILE_REQUEST_EVENT(sreq, "rndv_rtr_recv", 0);
-    sreq->send.proto.rreq_ptr = rndv_rtr_hdr->rreq_ptr;
     ucp_request_start_send(sreq);
     return UCS_OK;
 }
 
+UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_atp_handler,
+                 (arg, data, length, flags),
+                 void *arg, void *data, size_t length, unsigned flags)
+{
+    ucp_reply_hdr_t *rep_hdr = data;
+    ucp_request_t *rndv_req  = (ucp_request_t*) rep_hdr->reqptr;
+    ucp_request_t *rreq      = rndv_req->send.rndv_get.rreq;
+
+    /* the sender completed all of its put operations - the data has arrived */
+    UCS_PROFILE_REQUEST_EVENT(rreq, "rndv_atp_recv", 0);
+    ucp_rndv_rma_request_send_buffer_dereg(rndv_req);
+    ucp_request_complete_recv(rreq, UCS_OK);
+    ucp_request_put(rndv_req);
+    return UCS_OK;
+}
+
 UCS_PROFILE_FUNC(ucs_status_t, ucp_rndv_data_handler,
                  (arg, data, length, flags),
                  void *arg, void *data, size_t length, unsigned flags)
@@ -732,8 +1457,15 @@ static void ucp_rndv_dump(ucp_worker_h worker, uct_am_trace_type_t type,
                  rep_hdr->reqptr, ucs_status_string(rep_hdr->status));
         break;
     case UCP_AM_ID_RNDV_RTR:
-        snprintf(buffer, max, "RNDV_RTR sreq 0x%lx rreq 0x%lx",
-                 rndv_rtr_hdr->sreq_ptr, rndv_rtr_hdr->rreq_ptr);
+        snprintf(buffer, max, "RNDV_RTR sreq 0x%lx rreq 0x%lx "
+                 "address 0x%"PRIx64" rkey ", rndv_rtr_hdr->sreq_ptr,
+                 rndv_rtr_hdr->rreq_ptr, rndv_rtr_hdr->address);
+        ucs_log_dump_hex((void*)rndv_rtr_hdr + sizeof(*rndv_rtr_hdr), length,
+                         buffer + strlen(buffer), max - strlen(buffer));
+        break;
+    case UCP_AM_ID_RNDV_ATP:
+        snprintf(buffer, max, "RNDV_ATP rreq 0x%lx status '%s'",
+                 rep_hdr->reqptr, ucs_status_string(rep_hdr->status));
         break;
     case UCP_AM_ID_RNDV_DATA:
         snprintf(buffer, max, "RNDV_DATA rreq 0x%"PRIx64,
@@ -758,3 +1490,5 @@ UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_DATA, ucp_rndv_data_handler,
               ucp_rndv_dump, UCT_AM_CB_FLAG_SYNC);
 UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_DATA_LAST, ucp_rndv_data_last_handler,
               ucp_rndv_dump, UCT_AM_CB_FLAG_SYNC);
+UCP_DEFINE_AM(UCP_FEATURE_TAG, UCP_AM_ID_RNDV_ATP, ucp_rndv_atp_handler,
+              ucp_rndv_dump, UCT_AM_CB_FLAG_SYNC);
@@ -17,6 +17,10 @@ enum {
     UCP_RNDV_RTS_FLAG_PACKED_RKEY  = UCS_BIT(0)
 };
 
+enum {
+    UCP_RNDV_RTR_FLAG_PACKED_RKEY  = UCS_BIT(0)
+};
+
 /*
  * Rendezvous RTS
  */
@@ -35,6 +39,11 @@ typedef struct {
 typedef struct {
     uintptr_t                 sreq_ptr; /* request on the rndv initiator side - sender */
     uintptr_t                 rreq_ptr; /* request on the rndv receiver side */
+    uint64_t                  address;  /* holds the address of the data buffer on the
+                                           receiver's side, 0 if the sender should
+                                           send the data with AM messages */
+    uint16_t                  flags;
+    /* packed rkey follows */
 } UCS_S_PACKED ucp_rndv_rtr_hdr_t;
 
 /*
@@ -52,6 +61,13 @@ void ucp_rndv_matched(ucp_worker_h worker, ucp_request_t *req,
 
 ucs_status_t ucp_proto_progress_rndv_get_zcopy(uct_pending_req_t *self);
 
+ucs_status_t ucp_proto_progress_rndv_rtr(uct_pending_req_t *self);
+
+ucs_status_t ucp_proto_progress_rndv_rtr_put(uct_pending_req_t *self);
+
+ucs_status_t ucp_rndv_rts_handler(void *arg, void *data, size_t length,
+                                  unsigned am_flags);
+
 static inline size_t ucp_rndv_total_len(ucp_rndv_rts_hdr_t *hdr)
 {
     return hdr->size;
@@ -7,13 +7,33 @@
 #include "tag_match.inl"
 
 
-ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm)
+/* How many old buckets to drain on every migration slow-path call, in
+ * addition to the bucket of the tag being accessed */
+#define UCP_TAG_MATCH_MIGRATE_BURST    16
+
+/* Buckets in the per-sender hash of unexpected descriptors. The table is
+ * fixed-size - the number of peers is bounded by the job size, and collisions
+ * only make a lookup walk a few extra descriptors */
+#define UCP_TAG_MATCH_SENDER_HASH_SIZE 4096
+
+
+ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm, uint64_t sender_mask)
 {
     size_t hash_size, bucket;
 
-    hash_size = ucs_roundup_pow2(UCP_TAG_MATCH_HASH_SIZE);
+    hash_size = UCP_TAG_MATCH_HASH_SIZE_MIN;
 
-    tm->expected.sn   = 0;
+    tm->expected.sn               = 0;
+    tm->expected.hash_size        = hash_size;
+    tm->expected.old_hash         = NULL;
+    tm->expected.old_hash_size    = 0;
+    tm->expected.migrate_bucket   = 0;
+    tm->expected.count            = 0;
+    tm->unexpected.hash_size      = hash_size;
+    tm->unexpected.old_hash       = NULL;
+    tm->unexpected.old_hash_size  = 0;
+    tm->unexpected.migrate_bucket = 0;
+    tm->unexpected.count          = 0;
     ucs_queue_head_init(&tm->expected.wildcard);
     ucs_list_head_init(&tm->unexpected.all);
 
@@ -35,11 +55,36 @@ ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm)
         ucs_list_head_init(&tm->unexpected.hash[bucket]);
     }
 
+    /* If the application told us which tag bits identify the sender, keep a
+     * secondary index of unexpected descriptors keyed by those bits, so that
+     * lookups whose mask covers them touch only one peer's messages */
+    tm->unexpected.sender_mask      = sender_mask;
+    tm->unexpected.sender_hash      = NULL;
+    tm->unexpected.sender_hash_size = 0;
+    if (sender_mask != 0) {
+        tm->unexpected.sender_hash =
+            ucs_malloc(sizeof(*tm->unexpected.sender_hash) *
+                       UCP_TAG_MATCH_SENDER_HASH_SIZE, "ucp_tm_sender_hash");
+        if (tm->unexpected.sender_hash == NULL) {
+            ucs_free(tm->unexpected.hash);
+            ucs_free(tm->expected.hash);
+            return UCS_ERR_NO_MEMORY;
+        }
+
+        tm->unexpected.sender_hash_size = UCP_TAG_MATCH_SENDER_HASH_SIZE;
+        for (bucket = 0; bucket < tm->unexpected.sender_hash_size; ++bucket) {
+            ucs_list_head_init(&tm->unexpected.sender_hash[bucket]);
+        }
+    }
+
     return UCS_OK;
 }
 
 void ucp_tag_match_cleanup(ucp_tag_match_t *tm)
 {
+    ucs_free(tm->unexpected.sender_hash);
+    ucs_free(tm->unexpected.old_hash);
+    ucs_free(tm->expected.old_hash);
     ucs_free(tm->unexpected.hash);
     ucs_free(tm->expected.hash);
 }
@@ -49,15 +94,178 @@ int ucp_tag_unexp_is_empty(ucp_tag_match_t *tm)
     return ucs_list_is_empty(&tm->unexpected.all);
 }
 
+/* Insert an expected request into a bucket, keeping it sorted by sequence
+ * number. Used when draining an old hash table - migrated requests always
+ * predate the ones pushed to the current table, so in practice they land
+ * in front of them. */
+static void ucp_tag_exp_queue_insert_sorted(ucs_queue_head_t *queue,
+                                            ucp_request_t *req)
+{
+    ucs_queue_iter_t iter;
+    ucp_request_t *qreq;
+
+    for (iter = ucs_queue_iter_begin(queue);
+         !ucs_queue_iter_end(queue, iter);
+         iter = ucs_queue_iter_next(iter))
+    {
+        qreq = ucs_container_of(*iter, ucp_request_t, recv.queue);
+        if (qreq->recv.sn > req->recv.sn) {
+            req->recv.queue.next = *iter;
+            *iter                = &req->recv.queue;
+            return;
+        }
+    }
+
+    ucs_queue_push(queue, &req->recv.queue);
+}
+
+static void ucp_tag_exp_hash_drain_bucket(ucp_tag_match_t *tm, size_t bucket)
+{
+    ucs_queue_head_t *queue = &tm->expected.old_hash[bucket];
+    ucs_queue_elem_t *elem;
+    ucp_request_t *req;
+
+    while (!ucs_queue_is_empty(queue)) {
+        elem = ucs_queue_pull_non_empty(queue);
+        req  = ucs_container_of(elem, ucp_request_t, recv.queue);
+        ucp_tag_exp_queue_insert_sorted(
+                        ucp_tag_exp_get_queue_for_tag(tm, req->recv.tag), req);
+    }
+}
+
+static void ucp_tag_unexp_hash_drain_bucket(ucp_tag_match_t *tm, size_t bucket)
+{
+    ucs_list_link_t *list = &tm->unexpected.old_hash[bucket];
+    ucs_list_link_t *link;
+    ucp_recv_desc_t *rdesc;
+    size_t new_bucket;
+
+    /* Walk from the tail and prepend, so that old descriptors keep preceding
+     * the ones already hashed into the current table */
+    while (!ucs_list_is_empty(list)) {
+        link       = list->prev;
+        rdesc      = ucs_container_of(link, ucp_recv_desc_t,
+                                      list[UCP_RDESC_HASH_LIST]);
+        new_bucket = ucp_tag_match_calc_hash(ucp_rdesc_get_tag(rdesc),
+                                             tm->unexpected.hash_size);
+        ucs_list_del(link);
+        ucs_list_add_head(&tm->unexpected.hash[new_bucket], link);
+    }
+}
+
+void ucp_tag_exp_hash_resize(ucp_tag_match_t *tm, size_t new_size)
+{
+    ucs_queue_head_t *hash;
+    size_t bucket;
+
+    hash = ucs_malloc(sizeof(*hash) * new_size, "ucp_tm_exp_hash");
+    if (hash == NULL) {
+        /* Not fatal - keep using the current table */
+        ucs_trace("tm %p: failed to allocate expected hash of %zu buckets",
+                  tm, new_size);
+        return;
+    }
+
+    for (bucket = 0; bucket < new_size; ++bucket) {
+        ucs_queue_head_init(&hash[bucket]);
+    }
+
+    ucs_trace("tm %p: resize expected hash %zu -> %zu (count %zu)", tm,
+              tm->expected.hash_size, new_size, tm->expected.count);
+
+    tm->expected.old_hash       = tm->expected.hash;
+    tm->expected.old_hash_size  = tm->expected.hash_size;
+    tm->expected.migrate_bucket = 0;
+    tm->expected.hash           = hash;
+    tm->expected.hash_size      = new_size;
+}
+
+void ucp_tag_unexp_hash_resize(ucp_tag_match_t *tm, size_t new_size)
+{
+    ucs_list_link_t *hash;
+    size_t bucket;
+
+    hash = ucs_malloc(sizeof(*hash) * new_size, "ucp_tm_unexp_hash");
+    if (hash == NULL) {
+        ucs_trace("tm %p: failed to allocate unexpected hash of %zu buckets",
+                  tm, new_size);
+        return;
+    }
+
+    for (bucket = 0; bucket < new_size; ++bucket) {
+        ucs_list_head_init(&hash[bucket]);
+    }
+
+    ucs_trace("tm %p: resize unexpected hash %zu -> %zu (count %zu)", tm,
+              tm->unexpected.hash_size, new_size, tm->unexpected.count);
+
+    tm->unexpected.old_hash       = tm->unexpected.hash;
+    tm->unexpected.old_hash_size  = tm->unexpected.hash_size;
+    tm->unexpected.migrate_bucket = 0;
+    tm->unexpected.hash           = hash;
+    tm->unexpected.hash_size      = new_size;
+}
+
+void ucp_tag_exp_hash_migrate(ucp_tag_match_t *tm, ucp_tag_t tag)
+{
+    size_t bucket, last;
+
+    /* Drain the bucket the caller is about to search */
+    ucp_tag_exp_hash_drain_bucket(tm,
+                    ucp_tag_match_calc_hash(tag, tm->expected.old_hash_size));
+
+    /* Advance the sequential sweep by a bounded amount */
+    last = ucs_min(tm->expected.migrate_bucket + UCP_TAG_MATCH_MIGRATE_BURST,
+                   tm->expected.old_hash_size);
+    for (bucket = tm->expected.migrate_bucket; bucket < last; ++bucket) {
+        ucp_tag_exp_hash_drain_bucket(tm, bucket);
+    }
+    tm->expected.migrate_bucket = last;
+
+    if (last == tm->expected.old_hash_size) {
+        ucs_free(tm->expected.old_hash);
+        tm->expected.old_hash      = NULL;
+        tm->expected.old_hash_size = 0;
+    }
+}
+
+void ucp_tag_unexp_hash_migrate(ucp_tag_match_t *tm, ucp_tag_t tag)
+{
+    size_t bucket, last;
+
+    ucp_tag_unexp_hash_drain_bucket(tm,
+                    ucp_tag_match_calc_hash(tag, tm->unexpected.old_hash_size));
+
+    last = ucs_min(tm->unexpected.migrate_bucket + UCP_TAG_MATCH_MIGRATE_BURST,
+                   tm->unexpected.old_hash_size);
+    for (bucket = tm->unexpected.migrate_bucket; bucket < last; ++bucket) {
+        ucp_tag_unexp_hash_drain_bucket(tm, bucket);
+    }
+    tm->unexpected.migrate_bucket = last;
+
+    if (last == tm->unexpected.old_hash_size) {
+        ucs_free(tm->unexpected.old_hash);
+        tm->unexpected.old_hash      = NULL;
+        tm->unexpected.old_hash_size = 0;
+    }
+}
+
 void ucp_tag_exp_remove(ucp_tag_match_t *tm, ucp_request_t *req)
 {
-    ucs_queue_head_t *queue = ucp_tag_exp_get_req_queue(tm, req);
+    ucs_queue_head_t *queue;
     ucs_queue_iter_t iter;
     ucp_request_t *qreq;
 
-    ucs_queue_for_each_safe(qreq, iter, queue, recv.queue) {
+    if (ucs_unlikely(tm->expected.old_hash != NULL) &&
+        (req->recv.tag_mask == UCP_TAG_MASK_FULL)) {
+        ucp_tag_exp_hash_migrate(tm, req->recv.tag);
+    }
+
+    queue = ucp_tag_exp_get_req_queue(tm, req);
+    ucs_queue_for_each_safe_pf(qreq, iter, queue, recv.queue) {
         if (qreq == req) {
             ucs_queue_del_iter(queue, iter);
+            --tm->expected.count;
             return;
         }
     }
@@ -101,6 +309,7 @@ ucp_tag_exp_search_all(ucp_tag_match_t *tm, ucs_queue_head_t *hash_queue,
         }
 
         req = ucs_container_of(**iter, ucp_request_t, recv.queue);
+        ucs_prefetch(ucs_container_of((**iter)->next, ucp_request_t, recv.queue));
         if (ucp_tag_recv_is_match(recv_tag, recv_flags, req->recv.tag,
                                   req->recv.tag_mask, req->recv.state.offset,
                                   req->recv.info.sender_tag))
@@ -109,6 +318,7 @@ ucp_tag_exp_search_all(ucp_tag_match_t *tm, ucs_queue_head_t *hash_queue,
                               req->recv.tag_mask, req->recv.state.offset, "expected");
             if (recv_flags & UCP_RECV_DESC_FLAG_LAST) {
                 ucs_queue_del_iter(queue, *iter);
+                --tm->expected.count;
             }
             return req;
         }
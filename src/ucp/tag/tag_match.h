@@ -26,26 +26,59 @@ typedef struct {
 
 /**
  * Tag-matching context
+ *
+ * The expected and unexpected hash tables are resized on-the-fly according to
+ * the number of elements they hold. A resize keeps the previous table around
+ * and migrates its buckets incrementally - a bounded number of buckets on
+ * every insert, and the bucket of the searched tag on every lookup - so a
+ * single progress call never pays for a full rehash.
  */
 typedef struct ucp_tag_match {
     struct {
         ucs_queue_head_t      wildcard;   /* Expected wildcard requests */
         ucs_queue_head_t      *hash;      /* Hash table of expected non-wild tags */
+        size_t                hash_size;  /* Buckets in hash, power of 2 */
+        ucs_queue_head_t      *old_hash;  /* Table being drained, or NULL */
+        size_t                old_hash_size;
+        size_t                migrate_bucket; /* Next old bucket to drain */
+        size_t                count;      /* Requests in hash + old_hash */
         uint64_t              sn;
     } expected;
     struct {
         ucs_list_link_t       all;        /* Linked list of all tags */
         ucs_list_link_t       *hash;      /* Hash table of unexpected tags */
+        size_t                hash_size;  /* Buckets in hash, power of 2 */
+        ucs_list_link_t       *old_hash;  /* Table being drained, or NULL */
+        size_t                old_hash_size;
+        size_t                migrate_bucket; /* Next old bucket to drain */
+        size_t                count;      /* Descriptors in hash + old_hash */
+        uint64_t              sender_mask; /* Tag bits which identify the
+                                              sender, or 0 if unknown */
+        ucs_list_link_t       *sender_hash; /* Hash table keyed by the sender
+                                               bits of the tag, or NULL */
+        size_t                sender_hash_size; /* Buckets in sender_hash,
+                                                   power of 2 */
     } unexpected;
 } ucp_tag_match_t;
 
 
-ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm);
+ucs_status_t ucp_tag_match_init(ucp_tag_match_t *tm, uint64_t sender_mask);
 
 void ucp_tag_match_cleanup(ucp_tag_match_t *tm);
 
 void ucp_tag_exp_remove(ucp_tag_match_t *tm, ucp_request_t *req);
 
+/* Resize slow path - allocate a new table and start incremental migration */
+void ucp_tag_exp_hash_resize(ucp_tag_match_t *tm, size_t new_size);
+
+void ucp_tag_unexp_hash_resize(ucp_tag_match_t *tm, size_t new_size);
+
+/* Migration slow path - drain the old bucket of 'tag' plus a bounded burst
+ * of other buckets, and release the old table once it is empty */
+void ucp_tag_exp_hash_migrate(ucp_tag_match_t *tm, ucp_tag_t tag);
+
+void ucp_tag_unexp_hash_migrate(ucp_tag_match_t *tm, ucp_tag_t tag);
+
 int ucp_tag_unexp_is_empty(ucp_tag_match_t *tm);
 
 ucp_request_t*
@@ -12,14 +12,21 @@
 #include <ucp/core/ucp_request.h>
 #include <ucp/dt/dt.h>
 #include <ucs/debug/log.h>
+#include <ucs/debug/usdt.h>
 #include <ucs/datastruct/queue.h>
 #include <ucs/datastruct/mpool.inl>
 #include <inttypes.h>
 
 
-/* Hash size is a prime number just below 1024. Prime number for even distribution,
- * and small enough to fit L1 cache. */
-#define UCP_TAG_MATCH_HASH_SIZE     1021
+/* Initial (and minimal) hash size - small enough to fit L1 cache. The table
+ * grows and shrinks by powers of 2 according to the load factor. */
+#define UCP_TAG_MATCH_HASH_SIZE_MIN     1024
+
+/* Grow when the average chain exceeds this many elements per bucket */
+#define UCP_TAG_MATCH_HASH_GROW_FACTOR  2
+
+/* Shrink when less than 1/8 of the buckets would be occupied on average */
+#define UCP_TAG_MATCH_HASH_SHRINK_FACTOR 8
 
 
 
@@ -56,17 +63,19 @@ int ucp_tag_recv_is_match(ucp_tag_t recv_tag, unsigned recv_flags,
 }
 
 static UCS_F_ALWAYS_INLINE size_t
-ucp_tag_match_calc_hash(ucp_tag_t tag)
+ucp_tag_match_calc_hash(ucp_tag_t tag, size_t hash_size)
 {
-    /* Compute two 32-bit modulo and combine their result */
-    return ((uint32_t)tag % UCP_TAG_MATCH_HASH_SIZE) ^
-           ((uint32_t)(tag >> 32) % UCP_TAG_MATCH_HASH_SIZE);
+    /* Fold to 32 bits and scramble with a multiplicative constant;
+     * hash_size is a power of 2 */
+    return (((uint32_t)tag ^ (uint32_t)(tag >> 32)) * 2654435761u) &
+           (hash_size - 1);
 }
 
 static UCS_F_ALWAYS_INLINE ucs_queue_head_t*
 ucp_tag_exp_get_queue_for_tag(ucp_tag_match_t *tm, ucp_tag_t tag)
 {
-    return &tm->expected.hash[ucp_tag_match_calc_hash(tag)];
+    return &tm->expected.hash[ucp_tag_match_calc_hash(tag,
+                                                      tm->expected.hash_size)];
 }
 
 static UCS_F_ALWAYS_INLINE ucs_queue_head_t*
@@ -90,6 +99,22 @@ ucp_tag_exp_push(ucp_tag_match_t *tm, ucs_queue_head_t *queue, ucp_request_t *re
 {
     req->recv.sn = tm->expected.sn++;
     ucs_queue_push(queue, &req->recv.queue);
+
+    ++tm->expected.count;
+    if (ucs_unlikely(tm->expected.old_hash != NULL)) {
+        /* Keep an ongoing migration moving */
+        ucp_tag_exp_hash_migrate(tm, req->recv.tag);
+    } else if (ucs_unlikely(tm->expected.count >
+                            (tm->expected.hash_size *
+                             UCP_TAG_MATCH_HASH_GROW_FACTOR))) {
+        ucp_tag_exp_hash_resize(tm, tm->expected.hash_size * 2);
+    } else if (ucs_unlikely((tm->expected.hash_size >
+                             UCP_TAG_MATCH_HASH_SIZE_MIN) &&
+                            (tm->expected.count <
+                             (tm->expected.hash_size /
+                              UCP_TAG_MATCH_HASH_SHRINK_FACTOR)))) {
+        ucp_tag_exp_hash_resize(tm, tm->expected.hash_size / 2);
+    }
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -106,28 +131,48 @@ ucp_tag_exp_search(ucp_tag_match_t *tm, ucp_tag_t recv_tag, size_t recv_len,
     ucs_queue_iter_t iter;
     ucp_request_t *req;
 
+    if (ucs_unlikely(tm->expected.old_hash != NULL)) {
+        /* Make sure older requests for this tag are back in the hash bucket
+         * before searching it */
+        ucp_tag_exp_hash_migrate(tm, recv_tag);
+    }
+
     if (ucs_unlikely(!ucs_queue_is_empty(&tm->expected.wildcard))) {
         queue = ucp_tag_exp_get_queue_for_tag(tm, recv_tag);
         return ucp_tag_exp_search_all(tm, queue, recv_tag, recv_len, recv_flags);
     }
 
-    /* fast path - wildcard queue is empty, search only the specific queue */
+    /* fast path - the wildcard queue is empty, so every request in the hash
+     * bucket has a full tag mask and matching degenerates to tag equality,
+     * with no mask or sequence number arithmetic */
     queue = ucp_tag_exp_get_queue_for_tag(tm, recv_tag);
-    ucs_queue_for_each_safe(req, iter, queue, recv.queue) {
+    ucs_queue_for_each_safe_pf(req, iter, queue, recv.queue) {
         req = ucs_container_of(*iter, ucp_request_t, recv.queue);
-        ucs_trace_data("checking req %p tag %"PRIx64"/%"PRIx64" with recv_tag %"PRIx64,
-                       req, req->recv.tag, req->recv.tag_mask, recv_tag);
-        if (ucp_tag_recv_is_match(recv_tag, recv_flags, req->recv.tag,
-                                  req->recv.tag_mask, req->recv.state.offset,
-                                  req->recv.info.sender_tag))
-        {
-            ucp_tag_log_match(recv_tag, recv_len, req, req->recv.tag,
-                              req->recv.tag_mask, req->recv.state.offset, "expected");
-            if (recv_flags & UCP_RECV_DESC_FLAG_LAST) {
-                ucs_queue_del_iter(queue, iter);
+        ucs_assert(req->recv.tag_mask == UCP_TAG_MASK_FULL);
+        ucs_trace_data("checking req %p tag %"PRIx64" with recv_tag %"PRIx64,
+                       req, req->recv.tag, recv_tag);
+        if (recv_flags & UCP_RECV_DESC_FLAG_FIRST) {
+            /* first fragment - search for a not-yet-started request */
+            if ((req->recv.state.offset != 0) || (recv_tag != req->recv.tag)) {
+                continue;
+            }
+        } else {
+            /* subsequent fragment - search for the request with the same
+             * sender tag */
+            if ((req->recv.state.offset == 0) ||
+                (recv_tag != req->recv.info.sender_tag)) {
+                continue;
             }
-            return req;
         }
+
+        ucp_tag_log_match(recv_tag, recv_len, req, req->recv.tag,
+                          req->recv.tag_mask, req->recv.state.offset, "expected");
+        UCS_USDT_PROBE3(tag_recv_match, req, recv_tag, recv_len);
+        if (recv_flags & UCP_RECV_DESC_FLAG_LAST) {
+            ucs_queue_del_iter(queue, iter);
+            --tm->expected.count;
+        }
+        return req;
     }
     return NULL;
 }
@@ -140,14 +185,43 @@ static UCS_F_ALWAYS_INLINE ucp_tag_t ucp_rdesc_get_tag(ucp_recv_desc_t *rdesc)
 static UCS_F_ALWAYS_INLINE ucs_list_link_t*
 ucp_tag_unexp_get_list_for_tag(ucp_tag_match_t *tm, ucp_tag_t tag)
 {
-    return &tm->unexpected.hash[ucp_tag_match_calc_hash(tag)];
+    if (ucs_unlikely(tm->unexpected.old_hash != NULL)) {
+        /* Make sure older descriptors for this tag are back in the hash
+         * bucket before it is searched */
+        ucp_tag_unexp_hash_migrate(tm, tag);
+    }
+    return &tm->unexpected.hash[ucp_tag_match_calc_hash(tag,
+                                                        tm->unexpected.hash_size)];
+}
+
+static UCS_F_ALWAYS_INLINE ucs_list_link_t*
+ucp_tag_unexp_get_sender_list(ucp_tag_match_t *tm, ucp_tag_t tag)
+{
+    return &tm->unexpected.sender_hash[
+                    ucp_tag_match_calc_hash(tag & tm->unexpected.sender_mask,
+                                            tm->unexpected.sender_hash_size)];
+}
+
+static UCS_F_ALWAYS_INLINE int
+ucp_tag_unexp_use_sender_hash(ucp_tag_match_t *tm, ucp_tag_t tag_mask)
+{
+    /* The sender index can serve a lookup only if the posted mask fully covers
+     * the sender bits - then every possibly-matching descriptor has the same
+     * sender slice as the expected tag, i.e. lands in the same bucket */
+    return (tm->unexpected.sender_hash != NULL) &&
+           ((tag_mask & tm->unexpected.sender_mask) ==
+            tm->unexpected.sender_mask);
 }
 
 static UCS_F_ALWAYS_INLINE void
-ucp_tag_unexp_remove(ucp_recv_desc_t *rdesc)
+ucp_tag_unexp_remove(ucp_tag_match_t *tm, ucp_recv_desc_t *rdesc)
 {
     ucs_list_del(&rdesc->list[UCP_RDESC_HASH_LIST]);
     ucs_list_del(&rdesc->list[UCP_RDESC_ALL_LIST] );
+    if (ucs_unlikely(tm->unexpected.sender_hash != NULL)) {
+        ucs_list_del(&rdesc->list[UCP_RDESC_SENDER_LIST]);
+    }
+    --tm->unexpected.count;
 }
 
 static UCS_F_ALWAYS_INLINE ucs_status_t
@@ -164,10 +238,23 @@ ucp_tag_unexp_recv(ucp_tag_match_t *tm, ucp_worker_h worker, void *data,
         rdesc->flags = flags | UCP_RECV_DESC_FLAG_UCT_DESC;
         status = UCS_INPROGRESS;
     } else {
-        rdesc = (ucp_recv_desc_t*)ucs_mpool_get_inline(&worker->am_mp);
-        if (rdesc == NULL) {
-            ucs_error("ucp recv descriptor is not allocated");
-            return UCS_ERR_NO_MEMORY;
+        if (ucs_likely(length <= UCP_WORKER_UNEXP_DESC_SIZE)) {
+            rdesc = (ucp_recv_desc_t*)ucs_mpool_get_inline(&worker->rdesc_mp);
+        } else {
+            rdesc = NULL;
+        }
+
+        if (ucs_likely(rdesc != NULL)) {
+            UCP_WORKER_STAT_UNEXP_DESC(worker, POOL);
+        } else {
+            /* the message is too long for the dedicated pool, or the pool
+             * reached its limit - spill over to the generic AM pool */
+            rdesc = (ucp_recv_desc_t*)ucs_mpool_get_inline(&worker->am_mp);
+            if (rdesc == NULL) {
+                ucs_error("ucp recv descriptor is not allocated");
+                return UCS_ERR_NO_MEMORY;
+            }
+            UCP_WORKER_STAT_UNEXP_DESC(worker, SPILL);
         }
 
         rdesc->flags = flags;
@@ -175,6 +262,8 @@ ucp_tag_unexp_recv(ucp_tag_match_t *tm, ucp_worker_h worker, void *data,
         status = UCS_OK;
     }
 
+    UCS_USDT_PROBE2(tag_recv_unexp, ((ucp_tag_hdr_t*)data)->tag, length);
+
     ucs_trace_req("unexp recv %c%c%c%c%c tag %"PRIx64" length %zu desc %p",
                   (flags & UCP_RECV_DESC_FLAG_FIRST) ? 'f' : '-',
                   (flags & UCP_RECV_DESC_FLAG_LAST)  ? 'l' : '-',
@@ -188,6 +277,26 @@ ucp_tag_unexp_recv(ucp_tag_match_t *tm, ucp_worker_h worker, void *data,
     hash_list = ucp_tag_unexp_get_list_for_tag(tm, ucp_rdesc_get_tag(rdesc));
     ucs_list_add_tail(hash_list,           &rdesc->list[UCP_RDESC_HASH_LIST]);
     ucs_list_add_tail(&tm->unexpected.all, &rdesc->list[UCP_RDESC_ALL_LIST]);
+    if (ucs_unlikely(tm->unexpected.sender_hash != NULL)) {
+        ucs_list_add_tail(ucp_tag_unexp_get_sender_list(tm,
+                                                        ucp_rdesc_get_tag(rdesc)),
+                          &rdesc->list[UCP_RDESC_SENDER_LIST]);
+    }
+
+    ++tm->unexpected.count;
+    if (ucs_unlikely((tm->unexpected.old_hash == NULL) &&
+                     (tm->unexpected.count >
+                      (tm->unexpected.hash_size *
+                       UCP_TAG_MATCH_HASH_GROW_FACTOR)))) {
+        ucp_tag_unexp_hash_resize(tm, tm->unexpected.hash_size * 2);
+    } else if (ucs_unlikely((tm->unexpected.old_hash == NULL) &&
+                            (tm->unexpected.hash_size >
+                             UCP_TAG_MATCH_HASH_SIZE_MIN) &&
+                            (tm->unexpected.count <
+                             (tm->unexpected.hash_size /
+                              UCP_TAG_MATCH_HASH_SHRINK_FACTOR)))) {
+        ucp_tag_unexp_hash_resize(tm, tm->unexpected.hash_size / 2);
+    }
     return status;
 }
 
@@ -5,6 +5,7 @@
  */
 
 #include "eager.h"
+#include "offload.h"
 #include "rndv.h"
 #include "tag_match.inl"
 
@@ -46,6 +47,15 @@ ucp_tag_search_unexp(ucp_worker_h worker, void *buffer, size_t buffer_size,
         }
 
         i_list = UCP_RDESC_HASH_LIST;
+    } else if (ucp_tag_unexp_use_sender_hash(&context->tm, tag_mask)) {
+        /* partial mask which still pins down the sender - scan only that
+         * peer's messages */
+        list   = ucp_tag_unexp_get_sender_list(&context->tm, tag);
+        if (ucs_list_is_empty(list)) {
+            return UCS_INPROGRESS;
+        }
+
+        i_list = UCP_RDESC_SENDER_LIST;
     } else {
         list   = &context->tm.unexpected.all;
         i_list = UCP_RDESC_ALL_LIST;
@@ -53,6 +63,9 @@ ucp_tag_search_unexp(ucp_worker_h worker, void *buffer, size_t buffer_size,
 
     rdesc = ucs_list_head(list, ucp_recv_desc_t, list[i_list]);
     do {
+        /* the scan is a dependent-load chain - overlap the next descriptor
+         * fetch with matching the current one */
+        ucs_prefetch(ucp_tag_unexp_list_next(rdesc, i_list));
         recv_tag = ucp_rdesc_get_tag(rdesc);
         flags    = rdesc->flags;
         ucs_trace_req("searching for %"PRIx64"/%"PRIx64"/%"PRIx64" offset %zu, "
@@ -69,7 +82,7 @@ ucp_tag_search_unexp(ucp_worker_h worker, void *buffer, size_t buffer_size,
         {
             ucp_tag_log_match(recv_tag, rdesc->length - rdesc->hdr_len, req, tag,
                               tag_mask, req->recv.state.offset, "unexpected");
-            ucp_tag_unexp_remove(rdesc);
+            ucp_tag_unexp_remove(&context->tm, rdesc);
             if (rdesc->flags & UCP_RECV_DESC_FLAG_EAGER) {
                 UCS_PROFILE_REQUEST_EVENT(req, "eager_match", 0);
                 status = ucp_eager_unexp_match(worker, rdesc, recv_tag, flags,
@@ -194,14 +207,19 @@ ucp_tag_recv_common(ucp_worker_h worker, void *buffer, size_t buffer_size,
         /* If not found on unexpected, wait until it arrives.
          * If was found but need this receive request for later completion, save it */
         context            = worker->context;
-        queue              = ucp_tag_exp_get_queue(&context->tm, tag, tag_mask);
         req->recv.buffer   = buffer;
         req->recv.length   = buffer_size;
         req->recv.datatype = datatype;
         req->recv.tag      = tag;
         req->recv.tag_mask = tag_mask;
         req->recv.cb       = cb;
-        ucp_tag_exp_push(&context->tm, queue, req);
+
+        /* Post fully-specified receives to the transport tag-matching
+         * hardware; wildcards and everything else stay in software */
+        if (!ucp_tag_offload_post(worker, req)) {
+            queue = ucp_tag_exp_get_queue(&context->tm, tag, tag_mask);
+            ucp_tag_exp_push(&context->tm, queue, req);
+        }
         ucs_trace_req("%s returning expected request %p (%p)", debug_name, req,
                       req + 1);
     }
@@ -275,6 +293,56 @@ out:
     return ret;
 }
 
+UCS_PROFILE_FUNC(ucs_status_t, ucp_tag_recv_nb_multi,
+                 (worker, items, num_items, cb, reqs),
+                 ucp_worker_h worker, const ucp_tag_recv_item_t *items,
+                 size_t num_items, ucp_tag_recv_callback_t cb,
+                 ucs_status_ptr_t *reqs)
+{
+    const ucp_tag_recv_item_t *item;
+    ucs_status_t status, ret;
+    size_t buffer_size;
+    ucp_request_t *req;
+    size_t i;
+
+    ret = UCS_OK;
+
+    /* Take the locks once for the whole batch, so the per-call overhead is
+     * paid only once no matter how many receives are posted */
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
+
+    for (i = 0; i < num_items; ++i) {
+        item = &items[i];
+
+        req = ucp_tag_recv_request_get(worker, item->buffer, item->count,
+                                       item->datatype);
+        if (ucs_unlikely(req == NULL)) {
+            reqs[i] = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
+            ret     = UCS_ERR_NO_MEMORY;
+            continue;
+        }
+
+        buffer_size = ucp_dt_length(item->datatype, item->count, item->buffer,
+                                    &req->recv.state);
+
+        status = ucp_tag_recv_common(worker, item->buffer, buffer_size,
+                                     item->datatype, item->tag, item->tag_mask,
+                                     req, cb, "recv_nb_multi");
+        if (status != UCS_INPROGRESS) {
+            cb(req + 1, status, &req->recv.info);
+            ucp_tag_recv_request_completed(req, status, &req->recv.info,
+                                           "recv_nb_multi");
+        }
+
+        reqs[i] = req + 1;
+    }
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return ret;
+}
+
 UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_msg_recv_nb,
                  (worker, buffer, count, datatype, message, cb),
                  ucp_worker_h worker, void *buffer, size_t count,
@@ -362,3 +430,66 @@ out:
     UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
     return ret;
 }
+
+UCS_PROFILE_FUNC(ucs_status_t, ucp_tag_msg_data,
+                 (worker, message, data, length),
+                 ucp_worker_h worker, ucp_tag_message_h message, void **data,
+                 size_t *length)
+{
+    ucp_recv_desc_t *rdesc = message;
+    unsigned flags         = rdesc->flags;
+    void *hdr              = rdesc + 1;
+    ucp_request_hdr_t *req_hdr;
+
+    if (!ucs_test_all_flags(flags, UCP_RECV_DESC_FLAG_EAGER|
+                                   UCP_RECV_DESC_FLAG_FIRST|
+                                   UCP_RECV_DESC_FLAG_LAST)) {
+        /* Multi-fragment and rendezvous messages need a contiguous user
+         * buffer - the caller falls back to ucp_tag_msg_recv_nb */
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
+
+    ucs_trace_req("msg_data message %p length %zu", message,
+                  rdesc->length - rdesc->hdr_len);
+
+    /* The descriptor stays with the application until ucp_tag_msg_release, but
+     * the message is consumed - complete the sender-visible effects now */
+    if (ucs_unlikely(flags & UCP_RECV_DESC_FLAG_SYNC)) {
+        req_hdr = &((ucp_eager_sync_hdr_t*)hdr)->req;
+        ucp_tag_eager_sync_send_ack(worker, req_hdr->sender_uuid,
+                                    req_hdr->reqptr);
+    }
+
+    if (ucs_unlikely(flags & UCP_RECV_DESC_FLAG_FC)) {
+        ucp_tag_eager_fc_grant(worker, ((ucp_eager_fc_hdr_t*)hdr)->sender_uuid,
+                               rdesc->length - rdesc->hdr_len);
+    }
+
+    UCP_WORKER_STAT_EAGER_MSG(worker, flags);
+    UCP_WORKER_STAT_EAGER_CHUNK(worker, UNEXP);
+
+    *data   = hdr + rdesc->hdr_len;
+    *length = rdesc->length - rdesc->hdr_len;
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+    return UCS_OK;
+}
+
+UCS_PROFILE_FUNC_VOID(ucp_tag_msg_release, (worker, message),
+                      ucp_worker_h worker, ucp_tag_message_h message)
+{
+    ucp_recv_desc_t *rdesc = message;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->mt_lock);
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&worker->context->mt_lock);
+
+    ucs_trace_req("release receive descriptor %p", rdesc);
+    ucp_tag_unexp_desc_release(rdesc);
+
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->context->mt_lock);
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&worker->mt_lock);
+}
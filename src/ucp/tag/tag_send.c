@@ -11,8 +11,10 @@
 #include <ucp/core/ucp_ep.h>
 #include <ucp/core/ucp_worker.h>
 #include <ucp/core/ucp_context.h>
+#include <ucp/core/ucp_mm.h>
 #include <ucp/core/ucp_request.inl>
 #include <ucs/datastruct/mpool.inl>
+#include <ucs/debug/usdt.h>
 #include <string.h>
 
 
@@ -27,13 +29,15 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
     ucp_worker_h worker       = req->send.ep->worker;
     size_t only_hdr_size      = proto->only_hdr_size;
     unsigned flag_iov_single  = 1;
+    ucp_dt_strided_t *dt_strided;
     ucp_rsc_index_t rsc_index;
-    unsigned is_iov;
+    unsigned is_iov, is_strided;
     size_t zcopy_thresh;
     ucs_status_t status;
-    size_t length;
+    size_t length, nblocks;
 
-    is_iov = UCP_DT_IS_IOV(req->send.datatype);
+    is_iov     = UCP_DT_IS_IOV(req->send.datatype);
+    is_strided = UCP_DT_IS_STRIDED(req->send.datatype);
     if (ucs_unlikely(is_iov)) {
         length = ucp_dt_length(req->send.datatype, count, req->send.buffer,
                                &req->send.state);
@@ -58,6 +62,29 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
                                worker->context,
                                worker->iface_attrs[rsc_index].bandwidth);
         }
+    } else if (ucs_unlikely(is_strided)) {
+        /* like iov, except the entry count is the number of blocks */
+        dt_strided      = ucp_dt_strided(req->send.datatype);
+        length          = ucp_dt_strided_length(dt_strided, count);
+        nblocks         = length / dt_strided->block_length;
+        flag_iov_single = (nblocks <= config->am.max_iovcnt);
+        if (0 == count) {
+            /* disable zcopy */
+            zcopy_thresh = SIZE_MAX;
+        } else if (!config->am.zcopy_auto_thresh) {
+            /* The user defined threshold or no zcopy enabled */
+            zcopy_thresh = zcopy_thresh_arr[0];
+        } else if (nblocks <= UCP_MAX_IOV) {
+            /* Using pre-calculated thresholds */
+            zcopy_thresh = zcopy_thresh_arr[nblocks - 1];
+        } else {
+            /* Calculate threshold */
+            rsc_index    = config->key.lanes[lane].rsc_index;
+            zcopy_thresh = ucp_ep_config_get_zcopy_auto_thresh(nblocks,
+                               &ucp_ep_md_attr(req->send.ep, lane)->reg_cost,
+                               worker->context,
+                               worker->iface_attrs[rsc_index].bandwidth);
+        }
     } else {
         length       = ucp_contig_dt_length(req->send.datatype, count);
         zcopy_thresh = count ? zcopy_thresh_arr[0] : SIZE_MAX;
@@ -70,18 +97,25 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
                   req, req->send.datatype, req->send.buffer, length, max_short,
                   rndv_rma_thresh, rndv_am_thresh, zcopy_thresh);
 
-    if (((ssize_t)length <= max_short) && !is_iov) {
+    if (!is_iov && !is_strided && (length > 0) &&
+        ucs_unlikely(ucp_memory_is_cuda(req->send.buffer))) {
+        /* Device memory cannot be packed by the CPU - hand it to the
+         * rendezvous, which pulls straight from the GPU with get_zcopy */
+        ucp_tag_send_start_rndv(req);
+        UCS_PROFILE_REQUEST_EVENT(req, "start_rndv", req->send.length);
+    } else if (((ssize_t)length <= max_short) && !is_iov && !is_strided) {
         /* short */
         req->send.uct.func = proto->contig_short;
         UCS_PROFILE_REQUEST_EVENT(req, "start_contig_short", req->send.length);
     } else if ((((config->key.rndv_lane != UCP_NULL_RESOURCE) &&
                (length >= rndv_rma_thresh)) ||
-               (length >= rndv_am_thresh)) && !is_iov) {
+               (length >= rndv_am_thresh)) && !is_iov && !is_strided) {
         /* RMA/AM rendezvous */
         ucp_tag_send_start_rndv(req);
         UCS_PROFILE_REQUEST_EVENT(req, "start_rndv", req->send.length);
     } else if (length < zcopy_thresh) {
         /* bcopy */
+start_bcopy:
         if (length <= (config->am.max_bcopy - only_hdr_size)) {
             req->send.uct.func   = proto->bcopy_single;
             UCS_PROFILE_REQUEST_EVENT(req, "start_egr_bcopy_single", req->send.length);
@@ -93,7 +127,11 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
         /* eager zcopy */
         status = ucp_request_send_buffer_reg(req, lane);
         if (status != UCS_OK) {
-            return status;
+            /* the buffer could not be registered - send with a copy instead
+             * of failing the request */
+            ucs_trace_req("send request %p falling back to eager bcopy: %s",
+                          req, ucs_status_string(status));
+            goto start_bcopy;
         }
 
         req->send.uct_comp.func  = proto->zcopy_completion;
@@ -108,6 +146,10 @@ static ucs_status_t ucp_tag_req_start(ucp_request_t *req, size_t count,
             UCS_PROFILE_REQUEST_EVENT(req, "start_egr_zcopy_multi", req->send.length);
         }
     }
+
+    /* the progress function identifies the chosen protocol */
+    UCS_USDT_PROBE4(tag_send_start, req->send.ep, req->send.tag, length,
+                    req->send.uct.func);
     return UCS_OK;
 }
 
@@ -152,20 +194,28 @@ static void ucp_send_req_stat(ucp_request_t *req)
     }
 }
 
-static inline ucs_status_ptr_t
-ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
-                 size_t *zcopy_thresh, size_t rndv_rma_thresh, size_t rndv_am_thresh,
-                 ucp_send_callback_t cb, const ucp_proto_t *proto)
+static UCS_F_COLD UCS_F_NOINLINE ucs_status_t
+ucp_tag_send_req_invalid_dt(ucp_request_t *req)
+{
+    ucs_error("Invalid data type 0x%lx", req->send.datatype);
+    return UCS_ERR_INVALID_PARAM;
+}
+
+static inline ucs_status_t
+ucp_tag_send_req_start_proto(ucp_request_t *req, size_t count, ssize_t max_short,
+                             size_t *zcopy_thresh, size_t rndv_rma_thresh,
+                             size_t rndv_am_thresh, const ucp_proto_t *proto)
 {
     ucs_status_t status;
 
     switch (req->send.datatype & UCP_DATATYPE_CLASS_MASK) {
     case UCP_DATATYPE_CONTIG:
+    case UCP_DATATYPE_STRIDED:
     case UCP_DATATYPE_IOV:
         status = ucp_tag_req_start(req, count, max_short, zcopy_thresh,
                                    rndv_rma_thresh, rndv_am_thresh, proto);
         if (status != UCS_OK) {
-            return UCS_STATUS_PTR(status);
+            return status;
         }
         break;
 
@@ -175,11 +225,27 @@ ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
         break;
 
     default:
-        ucs_error("Invalid data type");
-        return UCS_STATUS_PTR(UCS_ERR_INVALID_PARAM);
+        return ucp_tag_send_req_invalid_dt(req);
     }
 
     ucp_send_req_stat(req);
+    ucp_ep_adapt_req_start(req);
+    return UCS_OK;
+}
+
+static inline ucs_status_ptr_t
+ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
+                 size_t *zcopy_thresh, size_t rndv_rma_thresh, size_t rndv_am_thresh,
+                 ucp_send_callback_t cb, const ucp_proto_t *proto)
+{
+    ucs_status_t status;
+
+    status = ucp_tag_send_req_start_proto(req, count, max_short, zcopy_thresh,
+                                          rndv_rma_thresh, rndv_am_thresh,
+                                          proto);
+    if (status != UCS_OK) {
+        return UCS_STATUS_PTR(status);
+    }
 
     /*
      * Start the request.
@@ -199,6 +265,76 @@ ucp_tag_send_req(ucp_request_t *req, size_t count, ssize_t max_short,
     return req + 1;
 }
 
+/*
+ * Same as ucp_tag_send_req, but for caller-provided request storage: the
+ * request is never returned to the mpool and has no completion callback -
+ * the application polls it with ucp_request_test.
+ */
+static inline ucs_status_t
+ucp_tag_send_req_nbr(ucp_request_t *req, size_t count, ssize_t max_short,
+                     size_t *zcopy_thresh, size_t rndv_rma_thresh,
+                     size_t rndv_am_thresh, const ucp_proto_t *proto)
+{
+    ucs_status_t status;
+
+    status = ucp_tag_send_req_start_proto(req, count, max_short, zcopy_thresh,
+                                          rndv_rma_thresh, rndv_am_thresh,
+                                          proto);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = ucp_request_start_send(req);
+    if (req->flags & UCP_REQUEST_FLAG_COMPLETED) {
+        ucs_trace_req("external send request %p completed with status %s", req,
+                      ucs_status_string(status));
+        return status;
+    }
+
+    ucs_trace_req("returning external send request %p in progress", req);
+    return UCS_INPROGRESS;
+}
+
+/*
+ * Credit flow control: the peer must be able to send grants back, and messages
+ * exceeding the remaining window are diverted to rendezvous, which is
+ * receiver-paced by design. The window is consumed when the message is
+ * actually sent (eager_snd.c) and granted back as the receiver consumes it.
+ */
+static UCS_F_NOINLINE ucs_status_ptr_t
+ucp_tag_send_req_fc(ucp_request_t *req, size_t count, ucp_send_callback_t cb)
+{
+    ucp_ep_h ep    = req->send.ep;
+    ssize_t fc_wnd = ucs_max(ep->fc_wnd, 0);
+
+    ucp_ep_connect_remote(ep);
+    return ucp_tag_send_req(req, count,
+                            -1, /* disable short method */
+                            ucp_ep_config(ep)->am.zcopy_thresh,
+                            ucs_min(ucp_ep_rndv_rma_thresh(ep),
+                                    (size_t)fc_wnd),
+                            ucs_min(ucp_ep_rndv_am_thresh(ep),
+                                    (size_t)fc_wnd),
+                            cb, &ucp_tag_eager_fc_proto);
+}
+
+static UCS_F_NOINLINE ucs_status_t
+ucp_tag_send_req_fc_nbr(ucp_request_t *req, size_t count)
+{
+    ucp_ep_h ep    = req->send.ep;
+    ssize_t fc_wnd = ucs_max(ep->fc_wnd, 0);
+
+    ucp_ep_connect_remote(ep);
+    return ucp_tag_send_req_nbr(req, count,
+                                -1, /* disable short method */
+                                ucp_ep_config(ep)->am.zcopy_thresh,
+                                ucs_min(ucp_ep_rndv_rma_thresh(ep),
+                                        (size_t)fc_wnd),
+                                ucs_min(ucp_ep_rndv_am_thresh(ep),
+                                        (size_t)fc_wnd),
+                                &ucp_tag_eager_fc_proto);
+}
+
 static void ucp_tag_send_req_init(ucp_request_t* req, ucp_ep_h ep,
                                   const void* buffer, uintptr_t datatype,
                                   ucp_tag_t tag, uint16_t flags)
@@ -214,6 +350,144 @@ static void ucp_tag_send_req_init(ucp_request_t* req, ucp_ep_h ep,
 #endif
 }
 
+static size_t ucp_tag_coalesce_pack(void *dest, void *arg)
+{
+    ucp_tag_coalesce_entry_t *entry = arg;
+
+    memcpy(dest, entry->data, entry->length);
+    return entry->length;
+}
+
+static ucs_status_t ucp_tag_coalesce_issue(ucp_tag_coalesce_entry_t *entry)
+{
+    ssize_t packed;
+
+    packed = uct_ep_am_bcopy(ucp_ep_get_am_uct_ep(entry->ep),
+                             UCP_AM_ID_EAGER_BATCH, ucp_tag_coalesce_pack,
+                             entry);
+    if (packed < 0) {
+        return (ucs_status_t)packed;
+    }
+
+    ucs_assertv(packed == (ssize_t)entry->length, "packed=%zd length=%zu",
+                packed, entry->length);
+    return UCS_OK;
+}
+
+int ucp_tag_coalesce_push(ucp_worker_h worker, ucp_ep_h ep, ucp_tag_t tag,
+                          const void *buffer, size_t length)
+{
+    ucp_tag_coalesce_entry_t *entry, **entry_p;
+    ucp_eager_batch_hdr_t *hdr;
+    size_t capacity;
+    int is_new;
+
+    /* Hardware tag matching bypasses the software unexpected queue, which is
+     * where the batched sub-messages land on the receiver */
+    if (ucs_unlikely(worker->tm_offload_iface != NULL)) {
+        return 0;
+    }
+
+    capacity = ucs_min(worker->context->config.ext.tag_coalesce_size,
+                       ucp_ep_config(ep)->am.max_bcopy);
+    if (ucs_unlikely((sizeof(*hdr) + length > capacity) ||
+                     (length > UINT16_MAX))) {
+        return 0;
+    }
+
+    entry_p = ucp_tag_coalesce_hash_get(&worker->tag_coalesce, (uintptr_t)ep);
+    if (entry_p != NULL) {
+        entry = *entry_p;
+        if (entry->length + sizeof(*hdr) + length > capacity) {
+            /* Frame is full - send it now, keeping message order, and stage
+             * the new message into an empty buffer */
+            ucp_tag_coalesce_flush_ep(worker, ep, 1);
+            return ucp_tag_coalesce_push(worker, ep, tag, buffer, length);
+        }
+    } else {
+        entry = ucs_mpool_get_inline(&worker->tag_coalesce_mp);
+        if (entry == NULL) {
+            return 0;
+        }
+
+        entry_p = ucp_tag_coalesce_hash_put(&worker->tag_coalesce,
+                                            (uintptr_t)ep, &is_new);
+        if (entry_p == NULL) {
+            ucs_mpool_put_inline(entry);
+            return 0;
+        }
+
+        *entry_p      = entry;
+        entry->ep     = ep;
+        entry->length = 0;
+        entry->count  = 0;
+    }
+
+    hdr                  = (ucp_eager_batch_hdr_t*)(entry->data + entry->length);
+    hdr->super.super.tag = tag;
+    hdr->length          = length;
+    memcpy(hdr + 1, buffer, length);
+    entry->length       += sizeof(*hdr) + length;
+    ++entry->count;
+
+    ucs_trace_req("coalesce tag %"PRIx64" length %zu to %s (%u staged)",
+                  tag, length, ucp_ep_peer_name(ep), entry->count);
+    return 1;
+}
+
+void ucp_tag_coalesce_flush_ep(ucp_worker_h worker, ucp_ep_h ep, int block)
+{
+    ucp_tag_coalesce_entry_t *entry, **entry_p;
+    ucs_status_t status;
+    int is_new;
+
+    entry_p = ucp_tag_coalesce_hash_get(&worker->tag_coalesce, (uintptr_t)ep);
+    if (entry_p == NULL) {
+        return;
+    }
+
+    /* Remove before issuing - a blocking issue progresses the worker, which
+     * may stage new messages and move the hash buckets under our feet */
+    entry = *entry_p;
+    ucp_tag_coalesce_hash_del(&worker->tag_coalesce, (uintptr_t)ep);
+
+    while ((status = ucp_tag_coalesce_issue(entry)) == UCS_ERR_NO_RESOURCE) {
+        if (!block) {
+            /* the slot was freed just above, reinsertion cannot fail */
+            *ucp_tag_coalesce_hash_put(&worker->tag_coalesce, (uintptr_t)ep,
+                                       &is_new) = entry;
+            return;
+        }
+        ucp_worker_progress(worker);
+    }
+
+    if (status != UCS_OK) {
+        ucs_error("failed to send coalesced frame to %s: %s",
+                  ucp_ep_peer_name(ep), ucs_status_string(status));
+    }
+
+    ucs_mpool_put_inline(entry);
+}
+
+void ucp_tag_coalesce_drain(ucp_worker_h worker, int block)
+{
+    ucp_tag_coalesce_hash_t *hash = &worker->tag_coalesce;
+    ucp_tag_coalesce_hash_bucket_t *bucket;
+    unsigned count;
+
+    while (hash->count > 0) {
+        for (bucket = hash->buckets; bucket->dist == 0; ++bucket);
+
+        count = hash->count;
+        ucp_tag_coalesce_flush_ep(worker, bucket->value->ep, block);
+        if (hash->count == count) {
+            /* the frame stayed pending on no-resource - retry next drain */
+            ucs_assert(!block);
+            return;
+        }
+    }
+}
+
 UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_nb,
                  (ep, buffer, count, datatype, tag, cb),
                  ucp_ep_h ep, const void *buffer, size_t count,
@@ -229,9 +503,18 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_nb,
     ucs_trace_req("send_nb buffer %p count %zu tag %"PRIx64" to %s cb %p",
                   buffer, count, tag, ucp_ep_peer_name(ep), cb);
 
-    if (ucs_likely(UCP_DT_IS_CONTIG(datatype))) {
+    if (ucs_likely(UCP_DT_IS_CONTIG(datatype) && !ucp_ep_fc_enabled(ep))) {
         length = ucp_contig_dt_length(datatype, count);
         if (ucs_likely((ssize_t)length <= ucp_ep_config(ep)->am.max_eager_short)) {
+            if (ucs_unlikely(ep->worker->context->config.ext.tag_coalesce)) {
+                if (ucp_tag_coalesce_push(ep->worker, ep, tag, buffer, length)) {
+                    UCP_EP_STAT_TAG_OP(ep, EAGER);
+                    ret = UCS_STATUS_PTR(UCS_OK);
+                    goto out;
+                }
+                /* not absorbed - staged messages must go first to keep order */
+                ucp_tag_coalesce_flush_ep(ep->worker, ep, 1);
+            }
             status = UCS_PROFILE_CALL(ucp_tag_send_eager_short, ep, tag, buffer,
                                       length);
             if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
@@ -242,6 +525,11 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_nb,
         }
     }
 
+    /* Messages which bypass the coalescing buffer must not overtake it */
+    if (ucs_unlikely(ep->worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_flush_ep(ep->worker, ep, 1);
+    }
+
     req = ucp_request_get(ep->worker);
     if (req == NULL) {
         ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
@@ -250,17 +538,81 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_nb,
 
     ucp_tag_send_req_init(req, ep, buffer, datatype, tag, 0);
 
+    if (ucs_unlikely(ucp_ep_fc_enabled(ep))) {
+        ret = ucp_tag_send_req_fc(req, count, cb);
+        goto out;
+    }
+
     ret = ucp_tag_send_req(req, count,
                            ucp_ep_config(ep)->am.max_eager_short,
                            ucp_ep_config(ep)->am.zcopy_thresh,
-                           ucp_ep_config(ep)->rndv.rma_thresh,
-                           ucp_ep_config(ep)->rndv.am_thresh,
+                           ucp_ep_rndv_rma_thresh(ep),
+                           ucp_ep_rndv_am_thresh(ep),
                            cb, &ucp_tag_eager_proto);
 out:
     UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
     return ret;
 }
 
+UCS_PROFILE_FUNC(ucs_status_t, ucp_tag_send_nbr,
+                 (ep, buffer, count, datatype, tag, request),
+                 ucp_ep_h ep, const void *buffer, size_t count,
+                 uintptr_t datatype, ucp_tag_t tag, void *request)
+{
+    ucp_request_t *req = (ucp_request_t *)request - 1;
+    ucs_status_t status;
+    size_t length;
+
+    UCP_THREAD_CS_ENTER_CONDITIONAL(&ep->worker->mt_lock);
+
+    ucs_trace_req("send_nbr buffer %p count %zu tag %"PRIx64" to %s request %p",
+                  buffer, count, tag, ucp_ep_peer_name(ep), request);
+
+    if (ucs_likely(UCP_DT_IS_CONTIG(datatype) && !ucp_ep_fc_enabled(ep))) {
+        length = ucp_contig_dt_length(datatype, count);
+        if (ucs_likely((ssize_t)length <= ucp_ep_config(ep)->am.max_eager_short)) {
+            if (ucs_unlikely(ep->worker->context->config.ext.tag_coalesce)) {
+                if (ucp_tag_coalesce_push(ep->worker, ep, tag, buffer, length)) {
+                    UCP_EP_STAT_TAG_OP(ep, EAGER);
+                    status = UCS_OK;
+                    goto out;
+                }
+                /* not absorbed - staged messages must go first to keep order */
+                ucp_tag_coalesce_flush_ep(ep->worker, ep, 1);
+            }
+            status = UCS_PROFILE_CALL(ucp_tag_send_eager_short, ep, tag, buffer,
+                                      length);
+            if (ucs_likely(status != UCS_ERR_NO_RESOURCE)) {
+                UCP_EP_STAT_TAG_OP(ep, EAGER);
+                goto out;
+            }
+        }
+    }
+
+    /* Messages which bypass the coalescing buffer must not overtake it */
+    if (ucs_unlikely(ep->worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_flush_ep(ep->worker, ep, 1);
+    }
+
+    ucp_tag_send_req_init(req, ep, buffer, datatype, tag,
+                          UCP_REQUEST_DEBUG_FLAG_EXTERNAL);
+
+    if (ucs_unlikely(ucp_ep_fc_enabled(ep))) {
+        status = ucp_tag_send_req_fc_nbr(req, count);
+        goto out;
+    }
+
+    status = ucp_tag_send_req_nbr(req, count,
+                                  ucp_ep_config(ep)->am.max_eager_short,
+                                  ucp_ep_config(ep)->am.zcopy_thresh,
+                                  ucp_ep_rndv_rma_thresh(ep),
+                                  ucp_ep_rndv_am_thresh(ep),
+                                  &ucp_tag_eager_proto);
+out:
+    UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
+    return status;
+}
+
 UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_sync_nb,
                  (ep, buffer, count, datatype, tag, cb),
                  ucp_ep_h ep, const void *buffer, size_t count,
@@ -279,6 +631,11 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_sync_nb,
         goto out;
     }
 
+    /* Sync sends must not overtake the coalescing buffer */
+    if (ucs_unlikely(ep->worker->tag_coalesce.count > 0)) {
+        ucp_tag_coalesce_flush_ep(ep->worker, ep, 1);
+    }
+
     req = ucp_request_get(ep->worker);
     if (req == NULL) {
         ret = UCS_STATUS_PTR(UCS_ERR_NO_MEMORY);
@@ -293,8 +650,8 @@ UCS_PROFILE_FUNC(ucs_status_ptr_t, ucp_tag_send_sync_nb,
     ret = ucp_tag_send_req(req, count,
                            -1, /* disable short method */
                            ucp_ep_config(ep)->am.sync_zcopy_thresh,
-                           ucp_ep_config(ep)->rndv.rma_thresh,
-                           ucp_ep_config(ep)->rndv.am_thresh,
+                           ucp_ep_rndv_rma_thresh(ep),
+                           ucp_ep_rndv_am_thresh(ep),
                            cb, &ucp_tag_eager_sync_proto);
 out:
     UCP_THREAD_CS_EXIT_CONDITIONAL(&ep->worker->mt_lock);
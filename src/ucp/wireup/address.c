@@ -45,9 +45,9 @@ typedef struct {
 
 
 typedef struct {
-    float            overhead;
-    float            bandwidth;
     uint32_t         prio_cap_flags; /* 8 lsb: prio, 24 msb - cap flags */
+    uint16_t         overhead;       /* Interface overhead, bfloat16 */
+    uint16_t         bandwidth;      /* Interface bandwidth, bfloat16 */
 } ucp_address_packed_iface_attr_t;
 
 
@@ -59,6 +59,31 @@ typedef struct {
                                         UCP_ADDRESS_FLAG_MD_ALLOC | \
                                         UCP_ADDRESS_FLAG_MD_REG)
 
+/* Pack a non-negative performance value as bfloat16 - the upper half of its
+ * IEEE single-precision representation, rounded to nearest. The ~0.4% relative
+ * precision is more than enough for transport scoring, at half the size. */
+static uint16_t ucp_address_pack_bfloat16(double value)
+{
+    union {
+        float    f;
+        uint32_t i;
+    } u;
+
+    u.f = value;
+    return (u.i + 0x8000) >> 16;
+}
+
+static double ucp_address_unpack_bfloat16(uint16_t packed)
+{
+    union {
+        float    f;
+        uint32_t i;
+    } u;
+
+    u.i = (uint32_t)packed << 16;
+    return u.f;
+}
+
 static size_t ucp_address_string_packed_size(const char *s)
 {
     return strlen(s) + 1;
@@ -119,11 +144,14 @@ ucp_address_gather_devices(ucp_worker_h worker, uint64_t tl_bitmap, int has_ep,
     ucp_rsc_index_t i;
     uint64_t mask;
 
-    devices = ucs_calloc(context->num_tls, sizeof(*devices), "packed_devices");
+    devices = ucs_arena_alloc(&worker->ctl_arena,
+                              context->num_tls * sizeof(*devices));
     if (devices == NULL) {
         return UCS_ERR_NO_MEMORY;
     }
 
+    memset(devices, 0, context->num_tls * sizeof(*devices));
+
     num_devices = 0;
     for (i = 0; i < context->num_tls; ++i) {
         mask = UCS_BIT(i);
@@ -232,8 +260,8 @@ static void ucp_address_pack_iface_attr(ucp_address_packed_iface_attr_t *packed,
     }
 
     packed->prio_cap_flags = ((uint8_t)iface_attr->priority);
-    packed->overhead       = iface_attr->overhead;
-    packed->bandwidth      = iface_attr->bandwidth;
+    packed->overhead       = ucp_address_pack_bfloat16(iface_attr->overhead);
+    packed->bandwidth      = ucp_address_pack_bfloat16(iface_attr->bandwidth);
 
     /* Keep only the bits defined by UCP_ADDRESS_IFACE_FLAGS, to shrink address. */
     packed_flag = UCS_BIT(8);
@@ -258,8 +286,8 @@ ucp_address_unpack_iface_attr(ucp_address_iface_attr_t *iface_attr,
 
     iface_attr->cap_flags = 0;
     iface_attr->priority  = packed->prio_cap_flags & UCS_MASK(8);
-    iface_attr->overhead  = packed->overhead;
-    iface_attr->bandwidth = packed->bandwidth;
+    iface_attr->overhead  = ucp_address_unpack_bfloat16(packed->overhead);
+    iface_attr->bandwidth = ucp_address_unpack_bfloat16(packed->bandwidth);
 
     packed_flag = UCS_BIT(8);
     bit         = 1;
@@ -422,11 +450,12 @@ ucs_status_t ucp_address_pack(ucp_worker_h worker, ucp_ep_h ep, uint64_t tl_bitm
     /* Calculate packed size */
     size = ucp_address_packed_size(worker, devices, num_devices);
 
-    /* Allocate address */
+    /* Allocate address. The buffer outlives this call (it may be attached to
+     * a pending wireup request), so it cannot come from the arena. */
     buffer = ucs_malloc(size, "ucp_address");
     if (buffer == NULL) {
         status = UCS_ERR_NO_MEMORY;
-        goto out_free_devices;
+        goto out;
     }
 
     memset(buffer, 0, size);
@@ -436,7 +465,7 @@ ucs_status_t ucp_address_pack(ucp_worker_h worker, ucp_ep_h ep, uint64_t tl_bitm
                                  devices, num_devices);
     if (status != UCS_OK) {
         ucs_free(buffer);
-        goto out_free_devices;
+        goto out;
     }
 
     VALGRIND_CHECK_MEM_IS_DEFINED(buffer, size);
@@ -445,13 +474,13 @@ ucs_status_t ucp_address_pack(ucp_worker_h worker, ucp_ep_h ep, uint64_t tl_bitm
     *buffer_p = buffer;
     status    = UCS_OK;
 
-out_free_devices:
-    ucs_free(devices);
 out:
+    /* The devices array is released when the caller resets the arena */
     return status;
 }
 
-ucs_status_t ucp_address_unpack(const void *buffer, uint64_t *remote_uuid_p,
+ucs_status_t ucp_address_unpack(ucp_worker_h worker, const void *buffer,
+                                uint64_t *remote_uuid_p,
                                 char *remote_name, size_t max,
                                 unsigned *address_count_p,
                                 ucp_address_entry_t **address_list_p)
@@ -514,13 +543,22 @@ ucs_status_t ucp_address_unpack(const void *buffer, uint64_t *remote_uuid_p,
     } while (!last_dev);
 
 
-    /* Allocate address list */
-    address_list = ucs_calloc(address_count, sizeof(*address_list),
-                              "ucp_address_list");
+    /* Allocate address list. Callers which are themselves a control-path
+     * operation take it from the worker arena; others (e.g. tracing, which
+     * can run in the middle of such an operation) fall back to the heap */
+    if (worker != NULL) {
+        address_list = ucs_arena_alloc(&worker->ctl_arena,
+                                       address_count * sizeof(*address_list));
+    } else {
+        address_list = ucs_malloc(address_count * sizeof(*address_list),
+                                  "ucp_address_list");
+    }
     if (address_list == NULL) {
         return UCS_ERR_NO_MEMORY;
     }
 
+    memset(address_list, 0, address_count * sizeof(*address_list));
+
     /* Unpack addresses */
     address = address_list;
     ptr     = aptr;
@@ -583,3 +621,46 @@ ucs_status_t ucp_address_unpack(const void *buffer, uint64_t *remote_uuid_p,
     return UCS_OK;
 }
 
+size_t ucp_address_buffer_size(const void *buffer)
+{
+    size_t dev_addr_len, tl_addr_len;
+    int last_dev, last_tl;
+    int empty_dev;
+    const void *ptr;
+
+    ptr  = buffer;
+    ptr += sizeof(uint64_t);               /* worker uuid */
+    ptr += 1 + *(const uint8_t*)ptr;       /* worker name */
+
+    do {
+        if (*(uint8_t*)ptr == UCP_NULL_RESOURCE) {
+            ++ptr;                         /* empty address marker */
+            break;
+        }
+
+        /* md_index */
+        empty_dev    = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_EMPTY;
+        ++ptr;
+
+        /* device address */
+        dev_addr_len = (*(uint8_t*)ptr) & ~UCP_ADDRESS_FLAG_LAST;
+        last_dev     = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_LAST;
+        ++ptr;
+        ptr += dev_addr_len;
+
+        last_tl = empty_dev;
+        while (!last_tl) {
+            ptr += sizeof(uint16_t);                        /* tl_name_csum */
+            ptr += sizeof(ucp_address_packed_iface_attr_t); /* iface attr */
+
+            /* tl address */
+            tl_addr_len = (*(uint8_t*)ptr) & ~UCP_ADDRESS_FLAG_LAST;
+            last_tl     = (*(uint8_t*)ptr) & UCP_ADDRESS_FLAG_LAST;
+            ++ptr;
+            ptr += tl_addr_len;
+        }
+    } while (!last_dev);
+
+    return ptr - buffer;
+}
+
@@ -92,23 +92,40 @@ ucs_status_t ucp_address_pack(ucp_worker_h worker, ucp_ep_h ep, uint64_t tl_bitm
 /**
  * Unpack a list of addresses.
  *
+ * @param [in]  worker           Worker whose control-path arena to allocate
+ *                                the list from. If NULL, the list is allocated
+ *                                from the heap and should be released by
+ *                                ucs_free() - for callers which may run in the
+ *                                middle of another control-path operation.
  * @param [in]  buffer           Buffer with data to unpack.
  * @param [out] remote_uuid_p    Filled with remote worker uuid.
  * @param [out] remote_name      Filled with remote worker name.
  * @param [in]  max              Maximal length on @a remote_name.
  * @param [out] address_count_p  Filled with amount of addresses in the list.
  * @param [out] address_list_p   Filled with pointer to unpacked address list.
- *                                It should be released by ucs_free().
  *
  * @note Entries in the address list could point into the data buffer, so it
  *       should not be released as long as the list is used.
  *
- * @note The address list should be released by ucs_free().
+ * @note When allocated from the worker arena, the list is released by the
+ *       arena reset at the end of the operation, not individually.
  */
-ucs_status_t ucp_address_unpack(const void *buffer, uint64_t *remote_uuid_p,
+ucs_status_t ucp_address_unpack(ucp_worker_h worker, const void *buffer,
+                                uint64_t *remote_uuid_p,
                                 char *remote_name, size_t max,
                                 unsigned *address_count_p,
                                 ucp_address_entry_t **address_list_p);
 
 
+/**
+ * Return the total size of a packed address, by walking its structure. Used
+ * to retain or copy a packed address whose length was not passed along.
+ *
+ * @param [in]  buffer  Buffer with a packed address.
+ *
+ * @return Size of the packed address, in bytes.
+ */
+size_t ucp_address_buffer_size(const void *buffer);
+
+
 #endif
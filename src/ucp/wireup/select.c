@@ -7,7 +7,12 @@
 #include "wireup.h"
 #include "address.h"
 
+#include <ucp/core/ucp_worker.h>
+#include <ucs/algorithm/crc.h>
 #include <ucs/algorithm/qsort_r.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/sys.h>
+#include <ucs/sys/topo.h>
 #include <ucp/core/ucp_ep.inl>
 #include <string.h>
 #include <inttypes.h>
@@ -15,10 +20,11 @@
 #define UCP_WIREUP_RNDV_TEST_MSG_SIZE       262144
 
 enum {
-    UCP_WIREUP_LANE_USAGE_AM   = UCS_BIT(0),
-    UCP_WIREUP_LANE_USAGE_RMA  = UCS_BIT(1),
-    UCP_WIREUP_LANE_USAGE_AMO  = UCS_BIT(2),
-    UCP_WIREUP_LANE_USAGE_RNDV = UCS_BIT(3)
+    UCP_WIREUP_LANE_USAGE_AM      = UCS_BIT(0),
+    UCP_WIREUP_LANE_USAGE_RMA     = UCS_BIT(1),
+    UCP_WIREUP_LANE_USAGE_AMO     = UCS_BIT(2),
+    UCP_WIREUP_LANE_USAGE_RNDV    = UCS_BIT(3),
+    UCP_WIREUP_LANE_USAGE_AM_RAIL = UCS_BIT(4)
 };
 
 
@@ -32,6 +38,27 @@ typedef struct {
 } ucp_wireup_lane_desc_t;
 
 
+/*
+ * Cached result of ucp_wireup_select_lanes(). Selection is a pure function of
+ * the remote capability/performance attributes and of which local resources
+ * can reach each address entry, so all peers with the same "selection inputs"
+ * resolve to the same lanes. The canonical serialization of these inputs is
+ * kept after the struct, to verify cache hits exactly on hash collision.
+ */
+struct ucp_wireup_select_result {
+    size_t              input_size;
+    ucp_ep_config_key_t key;
+    uint8_t             addr_indices[UCP_MAX_LANES];
+    char                input[0];
+};
+
+/* Per address entry: tl_name_csum, md_index, md_flags, cap_flags, overhead,
+ * bandwidth, priority, local reachability bitmap */
+#define UCP_WIREUP_SELECT_INPUT_SIZE \
+    (sizeof(uint16_t) + 1 + sizeof(uint64_t) + sizeof(uint64_t) + \
+     sizeof(double) + sizeof(double) + sizeof(uint32_t) + sizeof(uint64_t))
+
+
 static const char *ucp_wireup_md_flags[] = {
     [ucs_ilog2(UCT_MD_FLAG_ALLOC)]               = "memory allocation",
     [ucs_ilog2(UCT_MD_FLAG_REG)]                 = "memory registration",
@@ -121,6 +148,67 @@ static int ucp_wireup_is_reachable(ucp_worker_h worker, ucp_rsc_index_t rsc_inde
            uct_iface_is_reachable(worker->ifaces[rsc_index], ae->dev_addr, ae->iface_addr);
 }
 
+/* Serialize everything lane selection depends on for each remote address
+ * entry. The device/transport address bytes themselves do not enter the
+ * digest - they differ between peers of the same class - only the resulting
+ * reachability bitmap does. */
+static void ucp_wireup_select_pack_inputs(ucp_ep_h ep, unsigned address_count,
+                                          const ucp_address_entry_t *address_list,
+                                          void *buffer)
+{
+    ucp_worker_h worker   = ep->worker;
+    ucp_context_h context = worker->context;
+    const ucp_address_entry_t *ae;
+    ucp_rsc_index_t rsc_index;
+    uint64_t reachable;
+    void *ptr;
+
+    ptr = buffer;
+    for (ae = address_list; ae < address_list + address_count; ++ae) {
+        reachable = 0;
+        for (rsc_index = 0; rsc_index < context->num_tls; ++rsc_index) {
+            if (ucp_wireup_is_reachable(worker, rsc_index, ae)) {
+                reachable |= UCS_BIT(rsc_index);
+            }
+        }
+
+        *(uint16_t*)ptr = ae->tl_name_csum;
+        ptr += sizeof(uint16_t);
+        *(uint8_t*)ptr  = ae->md_index;
+        ptr += 1;
+        *(uint64_t*)ptr = ae->md_flags;
+        ptr += sizeof(uint64_t);
+        *(uint64_t*)ptr = ae->iface_attr.cap_flags;
+        ptr += sizeof(uint64_t);
+        *(double*)ptr   = ae->iface_attr.overhead;
+        ptr += sizeof(double);
+        *(double*)ptr   = ae->iface_attr.bandwidth;
+        ptr += sizeof(double);
+        *(uint32_t*)ptr = ae->iface_attr.priority;
+        ptr += sizeof(uint32_t);
+        *(uint64_t*)ptr = reachable;
+        ptr += sizeof(uint64_t);
+    }
+
+    ucs_assert(ptr == buffer + (address_count * UCP_WIREUP_SELECT_INPUT_SIZE));
+}
+
+/* Scale a transport score by the distance between its device and the NUMA
+ * node the calling thread is running on, so a process pinned to one socket
+ * does not pick a device attached to another socket when an equivalent local
+ * device exists. Unknown locality leaves the score untouched. */
+static double ucp_wireup_numa_score_factor(const uct_iface_attr_t *iface_attr)
+{
+    int node = ucs_sys_get_numa_node();
+
+    if ((node < 0) || (iface_attr->numa_node < 0)) {
+        return 1.0;
+    }
+
+    return (double)UCS_TOPO_DISTANCE_LOCAL /
+           ucs_topo_numa_distance(node, iface_attr->numa_node);
+}
+
 /**
  * Select a local and remote transport
  */
@@ -239,7 +327,8 @@ ucp_wireup_select_transport(ucp_ep_h ep, const ucp_address_entry_t *address_list
             reachable = 1;
 
             score = criteria->calc_score(context, md_attr, iface_attr,
-                                         &ae->iface_attr);
+                                         &ae->iface_attr) *
+                    ucp_wireup_numa_score_factor(iface_attr);
             ucs_assert(score >= 0.0);
 
             priority = iface_attr->priority + ae->iface_attr.priority;
@@ -379,9 +468,11 @@ ucp_wireup_add_memaccess_lanes(ucp_ep_h ep, unsigned address_count,
 
     remote_md_map = -1;
 
-    /* Create a copy of the address list */
+    /* Create a copy of the address list on the worker's control-path arena;
+     * it is released when the whole wireup operation resets the arena */
     address_list_size = sizeof(*address_list_copy) * address_count;
-    address_list_copy = ucs_malloc(address_list_size, "rma address list");
+    address_list_copy = ucs_arena_alloc(&ep->worker->ctl_arena,
+                                        address_list_size);
     if (address_list_copy == NULL) {
         status = UCS_ERR_NO_MEMORY;
         goto out;
@@ -397,7 +488,7 @@ ucp_wireup_add_memaccess_lanes(ucp_ep_h ep, unsigned address_count,
                                          &mem_criteria, tl_bitmap, remote_md_map,
                                          1, &rsc_index, &addr_index, &score);
     if (status != UCS_OK) {
-        goto out_free_address_list;
+        goto out;
     }
 
     dst_md_index = address_list_copy[addr_index].md_index;
@@ -435,8 +526,6 @@ ucp_wireup_add_memaccess_lanes(ucp_ep_h ep, unsigned address_count,
 
     status = UCS_OK;
 
-out_free_address_list:
-    ucs_free(address_list_copy);
 out:
     return status;
 }
@@ -565,6 +654,8 @@ static ucs_status_t ucp_wireup_add_am_lane(ucp_ep_h ep, unsigned address_count,
     ucp_lane_index_t lane;
     ucs_status_t status;
     unsigned addr_index;
+    unsigned num_rails;
+    uint64_t tl_bitmap;
     double score;
     int need_am;
 
@@ -603,6 +694,29 @@ static ucs_status_t ucp_wireup_add_am_lane(ucp_ep_h ep, unsigned address_count,
     ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
                              address_list[addr_index].md_index, score,
                              UCP_WIREUP_LANE_USAGE_AM);
+
+    /* Bring up additional active-message lanes on other devices, for spraying
+     * eager messages. Each rail must be a distinct local resource, otherwise
+     * it would just share the injection rate of an existing rail. */
+    tl_bitmap = ~UCS_BIT(rsc_index);
+    for (num_rails = 1;
+         (num_rails < ep->worker->context->config.ext.max_eager_rails) &&
+         (*num_lanes_p < UCP_MAX_LANES);
+         ++num_rails)
+    {
+        status = ucp_wireup_select_transport(ep, address_list, address_count,
+                                             &criteria, tl_bitmap, -1, 0,
+                                             &rsc_index, &addr_index, &score);
+        if (status != UCS_OK) {
+            break;
+        }
+
+        ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
+                                 address_list[addr_index].md_index, score,
+                                 UCP_WIREUP_LANE_USAGE_AM_RAIL);
+        tl_bitmap &= ~UCS_BIT(rsc_index);
+    }
+
     return UCS_OK;
 }
 
@@ -637,11 +751,31 @@ static ucs_status_t ucp_wireup_add_rndv_lane(ucp_ep_h ep, unsigned address_count
     status = ucp_wireup_select_transport(ep, address_list, address_count, &criteria,
                                          -1, -1, 0, &rsc_index, &addr_index, &score);
     if ((status == UCS_OK) &&
-        /* a temporary workaround to prevent the ugni uct from using rndv */
+        /* a temporary workaround to prevent the ugni uct from using get-based rndv */
         (strstr(ep->worker->context->tl_rscs[rsc_index].tl_rsc.tl_name, "ugni") == NULL)) {
          ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
                                  address_list[addr_index].md_index, score,
                                  UCP_WIREUP_LANE_USAGE_RNDV);
+         return UCS_OK;
+    }
+
+    /* no transport can read the data with get_zcopy - look for one on which the
+     * sender can push it with put_zcopy instead (e.g. ugni) */
+    criteria.title              = "rendezvous put";
+    criteria.remote_iface_flags = UCT_IFACE_FLAG_PUT_ZCOPY |
+                                  UCT_IFACE_FLAG_PENDING;
+    criteria.local_iface_flags  = UCT_IFACE_FLAG_PUT_ZCOPY;
+
+    if (ucs_test_all_flags(ucp_ep_get_context_features(ep), UCP_FEATURE_WAKEUP)) {
+        criteria.remote_iface_flags |= UCT_IFACE_FLAG_WAKEUP;
+    }
+
+    status = ucp_wireup_select_transport(ep, address_list, address_count, &criteria,
+                                         -1, -1, 0, &rsc_index, &addr_index, &score);
+    if (status == UCS_OK) {
+        ucp_wireup_add_lane_desc(lane_descs, num_lanes_p, rsc_index, addr_index,
+                                 address_list[addr_index].md_index, score,
+                                 UCP_WIREUP_LANE_USAGE_RNDV);
     }
 
     return UCS_OK;
@@ -714,8 +848,39 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
 {
     ucp_worker_h worker            = ep->worker;
     ucp_wireup_lane_desc_t lane_descs[UCP_MAX_LANES];
+    ucp_wireup_select_result_t *sel, **hash_val;
     ucp_lane_index_t lane;
     ucs_status_t status;
+    size_t input_size;
+    uint64_t hash_key;
+    void *input;
+    int is_new;
+
+    /* In a homogeneous cluster most peers present the same selection inputs,
+     * so the full score loop below runs once per peer class instead of once
+     * per endpoint. Look up the cached result by a digest of the inputs. */
+    hash_key   = 0;
+    input_size = address_count * UCP_WIREUP_SELECT_INPUT_SIZE;
+    input      = ucs_arena_alloc(&worker->ctl_arena, input_size);
+    if (input != NULL) {
+        ucp_wireup_select_pack_inputs(ep, address_count, address_list, input);
+        hash_key = ucs_crc32(0, input, input_size);
+        hash_val = ucp_worker_wireup_hash_get(&worker->wireup_hash, hash_key);
+        if (hash_val != NULL) {
+            sel = *hash_val;
+            if ((sel->input_size == input_size) &&
+                !memcmp(sel->input, input, input_size))
+            {
+                *key = sel->key;
+                memcpy(addr_indices, sel->addr_indices, key->num_lanes);
+                ucs_trace("ep %p: reusing cached lane selection", ep);
+                return UCS_OK;
+            }
+
+            /* Hash collision with different inputs - select uncached */
+            input = NULL;
+        }
+    }
 
     memset(lane_descs, 0, sizeof(lane_descs));
     ucp_ep_config_key_reset(key);
@@ -766,6 +931,10 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
             ucs_assert(key->am_lane == UCP_NULL_LANE);
             key->am_lane = lane;
         }
+        if (lane_descs[lane].usage & (UCP_WIREUP_LANE_USAGE_AM |
+                                      UCP_WIREUP_LANE_USAGE_AM_RAIL)) {
+            key->am_rails[lane] = lane;
+        }
         if (lane_descs[lane].usage & UCP_WIREUP_LANE_USAGE_RNDV) {
             ucs_assert(key->rndv_lane == UCP_NULL_LANE);
             key->rndv_lane = lane;
@@ -792,6 +961,28 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
     key->wireup_lane  = ucp_wireup_select_wireup_msg_lane(worker, address_list,
                                                           lane_descs, key->num_lanes);
 
+    /* Cache the result for subsequent endpoints to the same peer class. A
+     * failed allocation just means this selection is not cached. */
+    if (input != NULL) {
+        sel = ucs_malloc(sizeof(*sel) + input_size, "wireup_select_cache");
+        if (sel != NULL) {
+            sel->input_size = input_size;
+            sel->key        = *key;
+            memset(sel->addr_indices, 0, sizeof(sel->addr_indices));
+            memcpy(sel->addr_indices, addr_indices, key->num_lanes);
+            memcpy(sel->input, input, input_size);
+
+            hash_val = ucp_worker_wireup_hash_put(&worker->wireup_hash,
+                                                  hash_key, &is_new);
+            if (hash_val != NULL) {
+                ucs_assert(is_new);
+                *hash_val = sel;
+            } else {
+                ucs_free(sel);
+            }
+        }
+    }
+
     return UCS_OK;
 }
 
@@ -817,3 +1008,75 @@ ucs_status_t ucp_wireup_select_aux_transport(ucp_ep_h ep,
                                        &ucp_wireup_aux_criteria, -1, -1, 1,
                                        rsc_index_p, addr_index_p, &score);
 }
+
+/*
+ * Select a replacement transport for a single lane, satisfying every role the
+ * lane plays in the current configuration. Used for failover, where only the
+ * failed lane is re-selected and the rest of the configuration stays intact.
+ */
+ucs_status_t
+ucp_wireup_select_lane_replacement(ucp_ep_h ep, ucp_lane_index_t lane,
+                                   unsigned address_count,
+                                   const ucp_address_entry_t *address_list,
+                                   uint64_t tl_bitmap,
+                                   ucp_rsc_index_t *rsc_index_p,
+                                   unsigned *addr_index_p)
+{
+    ucp_context_h context          = ep->worker->context;
+    const ucp_ep_config_key_t *key = &ucp_ep_config(ep)->key;
+    ucp_wireup_criteria_t criteria;
+    ucp_lane_index_t i;
+    uint64_t amo_flags;
+    double score;
+
+    criteria.title              = "lane replacement";
+    criteria.local_md_flags     = 0;
+    criteria.remote_md_flags    = 0;
+    criteria.remote_iface_flags = 0;
+    criteria.local_iface_flags  = 0;
+    criteria.calc_score         = ucp_wireup_amo_score_func; /* pure latency */
+
+    for (i = 0; (i < UCP_MAX_LANES) && (key->rma_lanes[i] != UCP_NULL_LANE);
+         ++i) {
+        if (key->rma_lanes[i] == lane) {
+            criteria.remote_iface_flags |= UCT_IFACE_FLAG_PUT_SHORT |
+                                           UCT_IFACE_FLAG_PUT_BCOPY |
+                                           UCT_IFACE_FLAG_GET_BCOPY;
+            criteria.local_iface_flags  |= UCT_IFACE_FLAG_PUT_SHORT |
+                                           UCT_IFACE_FLAG_PUT_BCOPY |
+                                           UCT_IFACE_FLAG_GET_BCOPY |
+                                           UCT_IFACE_FLAG_PENDING;
+            criteria.calc_score          = ucp_wireup_rma_score_func;
+        }
+    }
+
+    for (i = 0; (i < UCP_MAX_LANES) && (key->amo_lanes[i] != UCP_NULL_LANE);
+         ++i) {
+        if (key->amo_lanes[i] == lane) {
+            amo_flags = ucp_context_uct_atomic_iface_flags(context);
+            criteria.remote_iface_flags |= amo_flags;
+            criteria.local_iface_flags  |= amo_flags |
+                                           UCT_IFACE_FLAG_PENDING;
+        }
+    }
+
+    if (lane == key->rndv_lane) {
+        criteria.local_md_flags     |= UCT_MD_FLAG_REG;
+        criteria.remote_md_flags    |= UCT_MD_FLAG_REG;
+        criteria.remote_iface_flags |= UCT_IFACE_FLAG_GET_ZCOPY |
+                                       UCT_IFACE_FLAG_PENDING;
+        criteria.local_iface_flags  |= UCT_IFACE_FLAG_GET_ZCOPY;
+        criteria.calc_score          = ucp_wireup_rndv_score_func;
+    }
+
+    if ((lane == key->am_lane) || (key->am_rails[lane] != UCP_NULL_LANE)) {
+        criteria.remote_iface_flags |= UCT_IFACE_FLAG_AM_BCOPY |
+                                       UCT_IFACE_FLAG_AM_CB_SYNC;
+        criteria.local_iface_flags  |= UCT_IFACE_FLAG_AM_BCOPY;
+        criteria.calc_score          = ucp_wireup_am_score_func;
+    }
+
+    return ucp_wireup_select_transport(ep, address_list, address_count,
+                                       &criteria, tl_bitmap, -1, 1,
+                                       rsc_index_p, addr_index_p, &score);
+}
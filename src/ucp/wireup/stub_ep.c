@@ -65,6 +65,16 @@ static void ucp_stub_ep_progress(ucs_callbackq_slow_elem_t *elem)
     UCS_ASYNC_BLOCK(&ep->worker->async);
 
     ucs_assert(stub_ep->flags & UCP_STUB_EP_FLAG_READY);
+
+    if (stub_ep->flags & UCP_STUB_EP_FLAG_RETIRED) {
+        /* The lane switched to the transport endpoint at establishment time;
+         * only the stub shell remains to be destroyed from the main thread */
+        ucs_list_del(&stub_ep->retired_list);
+        uct_ep_destroy(&stub_ep->super);
+        UCS_ASYNC_UNBLOCK(&ep->worker->async);
+        return;
+    }
+
     ucs_assert(stub_ep->next_ep != NULL);
 
     /* If we still have pending wireup messages, send them out first */
@@ -99,24 +109,79 @@ static void ucp_stub_ep_progress(ucs_callbackq_slow_elem_t *elem)
     uct_ep_destroy(&stub_ep->super);
     stub_ep = NULL;
 
-    /* Replay pending requests */
+    /* Splice the queued requests into the transport pending arbiter in
+     * order, without dispatching each of them inline under the async lock;
+     * the transport schedules the whole batch on its next progress pass. A
+     * transport which has send resources available refuses the pending add
+     * with BUSY - dispatch those directly. New sends cannot overtake the
+     * spliced requests: if the transport accepted them, it is out of
+     * resources and queues everything else behind them. */
     ucs_queue_for_each_extract(uct_req, &tmp_pending_queue, priv, 1) {
         req = ucs_container_of(uct_req, ucp_request_t, send.uct);
         ucs_assert(req->send.ep == ep);
-        ucp_request_start_send(req);
+        if (uct_ep_pending_add(uct_ep, uct_req, 0) != UCS_OK) {
+            ucp_request_start_send(req);
+        }
         --ep->worker->stub_pend_count;
     }
 
     UCS_ASYNC_UNBLOCK(&ep->worker->async);
 }
 
+/*
+ * First use of a lane whose connection establishment was deferred - create the
+ * connected transport endpoint now. The send function still fails with
+ * NO_RESOURCE; the caller progresses the worker, which switches the lane to
+ * the real endpoint through the regular slow-path callback, and retries.
+ */
+static void ucp_stub_ep_lazy_connect(ucp_stub_ep_t *stub_ep)
+{
+    ucp_worker_h worker = stub_ep->ep->worker;
+    ucs_status_t status;
+    uct_ep_h next_ep;
+
+    if (ucs_likely(stub_ep->lazy_addr == NULL)) {
+        return;
+    }
+
+    UCS_ASYNC_BLOCK(&worker->async);
+    if (stub_ep->lazy_addr == NULL) {
+        goto out; /* Raced with another sender */
+    }
+
+    ucs_trace("ep %p: stub ep %p connecting deferred lane", stub_ep->ep, stub_ep);
+
+    status = ucp_worker_iface_ep_get(worker, stub_ep->lazy_rsc_index,
+                                     stub_ep->lazy_addr,
+                                     stub_ep->lazy_dev_addr_len,
+                                     stub_ep->lazy_addr + stub_ep->lazy_dev_addr_len,
+                                     stub_ep->lazy_tl_addr_len, &next_ep);
+    if (status != UCS_OK) {
+        /* Reachability was verified when the lane was selected, so failing
+         * here means transport resources ran out, and a send routine has no
+         * way to report that to the caller */
+        ucs_fatal("ep %p: failed to connect deferred lane: %s", stub_ep->ep,
+                  ucs_status_string(status));
+    }
+
+    ucs_free(stub_ep->lazy_addr);
+    stub_ep->lazy_addr = NULL;
+
+    ucp_stub_ep_set_next_ep(&stub_ep->super, next_ep);
+    ucp_stub_ep_remote_connected(&stub_ep->super);
+out:
+    UCS_ASYNC_UNBLOCK(&worker->async);
+}
+
 static ucs_status_t ucp_stub_ep_send_func(uct_ep_h uct_ep)
 {
+    ucp_stub_ep_lazy_connect(ucs_derived_of(uct_ep, ucp_stub_ep_t));
     return UCS_ERR_NO_RESOURCE;
 }
 
 static ssize_t ucp_stub_ep_bcopy_send_func(uct_ep_h uct_ep)
 {
+    ucp_stub_ep_lazy_connect(ucs_derived_of(uct_ep, ucp_stub_ep_t));
     return UCS_ERR_NO_RESOURCE;
 }
 
@@ -165,7 +230,8 @@ static void ucp_stub_ep_pending_req_release(uct_pending_req_t *self,
     ucp_request_put(proxy_req);
 }
 
-static ucs_status_t ucp_stub_pending_add(uct_ep_h uct_ep, uct_pending_req_t *req)
+static ucs_status_t ucp_stub_pending_add(uct_ep_h uct_ep, uct_pending_req_t *req,
+                                         unsigned flags)
 {
     ucp_stub_ep_t *stub_ep = ucs_derived_of(uct_ep, ucp_stub_ep_t);
     ucp_ep_h ep = stub_ep->ep;
@@ -187,7 +253,8 @@ static ucs_status_t ucp_stub_pending_add(uct_ep_h uct_ep, uct_pending_req_t *req
         proxy_req->send.proxy.req     = req;
         proxy_req->send.proxy.stub_ep = stub_ep;
 
-        status = uct_ep_pending_add(wireup_msg_ep, &proxy_req->send.uct);
+        status = uct_ep_pending_add(wireup_msg_ep, &proxy_req->send.uct,
+                                    UCT_PENDING_FLAG_CTRL);
         if (status == UCS_OK) {
             ucs_atomic_add32(&stub_ep->pending_count, +1);
         } else {
@@ -220,6 +287,24 @@ static void ucp_stub_pending_purge(uct_ep_h uct_ep,
     }
 }
 
+static ucs_status_t ucp_stub_ep_flush(uct_ep_h uct_ep, unsigned flags,
+                                      uct_completion_t *comp)
+{
+    ucp_stub_ep_t *stub_ep = ucs_derived_of(uct_ep, ucp_stub_ep_t);
+
+    /* A deferred lane with nothing queued has nothing to flush - returning
+     * NO_RESOURCE here would make flush/disconnect spin forever on a lane
+     * which will never progress on its own */
+    if ((stub_ep->lazy_addr != NULL) &&
+        ucs_queue_is_empty(&stub_ep->pending_q) &&
+        (stub_ep->pending_count == 0))
+    {
+        return UCS_OK;
+    }
+
+    return UCS_ERR_NO_RESOURCE;
+}
+
 static ssize_t ucp_stub_ep_am_bcopy(uct_ep_h uct_ep, uint8_t id,
                                     uct_pack_callback_t pack_cb, void *arg)
 {
@@ -237,7 +322,7 @@ static uct_iface_t ucp_stub_iface = {
     .ops = {
         .ep_get_address       = ucp_stub_ep_get_address,
         .ep_connect_to_ep     = ucp_stub_ep_connect_to_ep,
-        .ep_flush             = (void*)ucs_empty_function_return_no_resource,
+        .ep_flush             = ucp_stub_ep_flush,
         .ep_destroy           = UCS_CLASS_DELETE_FUNC_NAME(ucp_stub_ep_t),
         .ep_pending_add       = ucp_stub_pending_add,
         .ep_pending_purge     = ucp_stub_pending_purge,
@@ -306,6 +391,10 @@ UCS_CLASS_INIT_FUNC(ucp_stub_ep_t, ucp_ep_h ep)
     self->aux_ep        = NULL;
     self->next_ep       = NULL;
     self->aux_rsc_index = UCP_NULL_RESOURCE;
+    self->lazy_rsc_index = UCP_NULL_RESOURCE;
+    self->lazy_addr     = NULL;
+    self->lazy_dev_addr_len = 0;
+    self->lazy_tl_addr_len  = 0;
     self->pending_count = 0;
     self->flags         = 0;
     self->elem.cb       = ucp_stub_ep_progress;
@@ -328,8 +417,11 @@ static UCS_CLASS_CLEANUP_FUNC(ucp_stub_ep_t)
     if (self->aux_ep != NULL) {
         uct_ep_destroy(self->aux_ep);
     }
+    ucs_free(self->lazy_addr);
     if (self->next_ep != NULL) {
-        uct_ep_destroy(self->next_ep);
+        if (!ucp_worker_iface_ep_put(self->ep->worker, self->next_ep)) {
+            uct_ep_destroy(self->next_ep);
+        }
     }
 }
 
@@ -384,6 +476,38 @@ err:
     return status;
 }
 
+ucs_status_t ucp_stub_ep_defer_connect(uct_ep_h uct_ep, ucp_rsc_index_t rsc_index,
+                                       const ucp_address_entry_t *address)
+{
+    ucp_stub_ep_t *stub_ep = ucs_derived_of(uct_ep, ucp_stub_ep_t);
+    void *addr_buf;
+
+    ucs_assert(ucp_stub_ep_test(uct_ep));
+    ucs_assert(stub_ep->next_ep == NULL);
+
+    /* The address list is released when the control operation ends, so keep a
+     * private copy of the device and interface addresses until first use */
+    addr_buf = ucs_malloc(address->dev_addr_len + address->tl_addr_len,
+                          "stub_ep_lazy_addr");
+    if (addr_buf == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    memcpy(addr_buf, address->dev_addr, address->dev_addr_len);
+    memcpy(addr_buf + address->dev_addr_len, address->iface_addr,
+           address->tl_addr_len);
+
+    stub_ep->lazy_rsc_index    = rsc_index;
+    stub_ep->lazy_dev_addr_len = address->dev_addr_len;
+    stub_ep->lazy_tl_addr_len  = address->tl_addr_len;
+    stub_ep->lazy_addr         = addr_buf;
+
+    ucs_trace("ep %p: stub ep %p defers connection on "UCT_TL_RESOURCE_DESC_FMT,
+              stub_ep->ep, stub_ep,
+              UCT_TL_RESOURCE_DESC_ARG(&stub_ep->ep->worker->context->tl_rscs[rsc_index].tl_rsc));
+    return UCS_OK;
+}
+
 void ucp_stub_ep_set_next_ep(uct_ep_h uct_ep, uct_ep_h next_ep)
 {
     ucp_stub_ep_t *stub_ep = ucs_derived_of(uct_ep, ucp_stub_ep_t);
@@ -397,6 +521,8 @@ void ucp_stub_ep_set_next_ep(uct_ep_h uct_ep, uct_ep_h next_ep)
 void ucp_stub_ep_remote_connected(uct_ep_h uct_ep)
 {
     ucp_stub_ep_t *stub_ep = ucs_derived_of(uct_ep, ucp_stub_ep_t);
+    ucp_ep_h ep            = stub_ep->ep;
+    ucp_lane_index_t lane;
 
     ucs_assert(ucp_stub_ep_test(uct_ep));
     ucs_assert(stub_ep->next_ep != NULL);
@@ -404,6 +530,27 @@ void ucp_stub_ep_remote_connected(uct_ep_h uct_ep)
 
     ucs_trace("ep %p: stub ep %p is remote-connected", stub_ep->ep, stub_ep);
     stub_ep->flags |= UCP_STUB_EP_FLAG_READY;
+
+    /* When nothing is queued on the stub, the lane can switch to the real
+     * transport endpoint right here with a single pointer store, so sends
+     * issued after establishment never see the proxy. All callers run with
+     * the async context blocked, which excludes concurrent lane access; only
+     * the destruction of the stub itself must wait for the slow-path
+     * callback, which is guaranteed to run from the main thread. */
+    if ((stub_ep->pending_count == 0) &&
+        ucs_queue_is_empty(&stub_ep->pending_q)) {
+        for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
+            if (ep->uct_eps[lane] == uct_ep) {
+                ep->uct_eps[lane] = stub_ep->next_ep;
+                stub_ep->next_ep  = NULL;
+                stub_ep->flags   |= UCP_STUB_EP_FLAG_RETIRED;
+                ucs_list_add_tail(&ep->worker->stub_retired,
+                                  &stub_ep->retired_list);
+                break;
+            }
+        }
+    }
+
     uct_worker_slowpath_progress_register(stub_ep->ep->worker->uct,
                                           &stub_ep->elem);
 }
@@ -412,3 +559,21 @@ int ucp_stub_ep_test(uct_ep_h uct_ep)
 {
     return uct_ep->iface == &ucp_stub_iface;
 }
+
+void ucp_stub_ep_retired_cleanup(ucp_worker_h worker)
+{
+    ucp_stub_ep_t *stub_ep;
+
+    while (!ucs_list_is_empty(&worker->stub_retired)) {
+        stub_ep = ucs_list_extract_head(&worker->stub_retired, ucp_stub_ep_t,
+                                        retired_list);
+        stub_ep->flags &= ~UCP_STUB_EP_FLAG_RETIRED;
+        uct_ep_destroy(&stub_ep->super);
+    }
+}
+
+int ucp_stub_ep_is_deferred(uct_ep_h uct_ep)
+{
+    return ucp_stub_ep_test(uct_ep) &&
+           (ucs_derived_of(uct_ep, ucp_stub_ep_t)->lazy_addr != NULL);
+}
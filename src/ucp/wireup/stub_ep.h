@@ -13,6 +13,7 @@
 #include <uct/api/uct.h>
 #include <ucp/api/ucp.h>
 #include <ucp/core/ucp_ep.h>
+#include <ucs/datastruct/list.h>
 #include <ucs/datastruct/queue_types.h>
 
 
@@ -22,6 +23,9 @@
 enum {
     UCP_STUB_EP_FLAG_READY           = UCS_BIT(0), /**< next_ep is fully connected */
     UCP_STUB_EP_FLAG_LOCAL_CONNECTED = UCS_BIT(1), /**< Debug: next_ep connected to remote */
+    UCP_STUB_EP_FLAG_RETIRED         = UCS_BIT(2), /**< The lane already switched to
+                                                        next_ep; only the stub shell
+                                                        remains to be destroyed */
 };
 
 
@@ -37,9 +41,20 @@ struct ucp_stub_ep {
     uct_ep_h                  aux_ep;        /**< Used to wireup the "real" endpoint */
     uct_ep_h                  next_ep;       /**< Next transport being wired up */
     ucp_rsc_index_t           aux_rsc_index; /**< Index of auxiliary transport */
+    ucp_rsc_index_t           lazy_rsc_index;/**< Resource for deferred connection */
+    void                      *lazy_addr;    /**< Saved remote device+iface address
+                                                  for deferred connection, NULL if
+                                                  the lane is not deferred */
+    size_t                    lazy_dev_addr_len; /**< Device address length inside
+                                                      lazy_addr */
+    size_t                    lazy_tl_addr_len; /**< Interface address length
+                                                     inside lazy_addr */
     volatile uint32_t         pending_count; /**< Number of pending wireup operations */
     volatile uint32_t         flags;         /**< Connection state flags */
     ucs_callbackq_slow_elem_t elem;          /**< Slow-path callback */
+    ucs_list_link_t           retired_list;  /**< Element in the worker list of
+                                                  retired stubs, valid when the
+                                                  RETIRED flag is set */
 };
 
 
@@ -70,10 +85,35 @@ ucs_status_t ucp_stub_ep_connect(uct_ep_h uct_ep, ucp_rsc_index_t rsc_index,
                                  int connect_aux, unsigned address_count,
                                  const ucp_address_entry_t *address_list);
 
+/**
+ * Defer connection establishment of an iface-connected lane until its first
+ * use. The remote address is copied into the stub endpoint; the connected
+ * transport endpoint is created when a send operation first hits the stub.
+ *
+ * @param [in]  uct_ep       Stub endpoint which holds the lane.
+ * @param [in]  rsc_index    Resource of the real transport.
+ * @param [in]  address      Remote address entry to connect to later.
+ */
+ucs_status_t ucp_stub_ep_defer_connect(uct_ep_h uct_ep, ucp_rsc_index_t rsc_index,
+                                       const ucp_address_entry_t *address);
+
 void ucp_stub_ep_set_next_ep(uct_ep_h uct_ep, uct_ep_h next_ep);
 
 void ucp_stub_ep_remote_connected(uct_ep_h uct_ep);
 
 int ucp_stub_ep_test(uct_ep_h uct_ep);
 
+/**
+ * Destroy retired stub endpoints whose slow-path callback did not get a chance
+ * to run before the worker is torn down.
+ */
+void ucp_stub_ep_retired_cleanup(ucp_worker_h worker);
+
+/**
+ * @return Nonzero if the endpoint is a stub whose connection establishment is
+ *   deliberately deferred to the first send, so it should not be considered
+ *   "still connecting".
+ */
+int ucp_stub_ep_is_deferred(uct_ep_h uct_ep);
+
 #endif
@@ -190,12 +190,22 @@ static void ucp_wireup_process_request(ucp_worker_h worker, const ucp_wireup_msg
         }
     }
 
+    /* Retain the peer address for lane failover and address inheritance */
+    ucp_ep_set_remote_address(ep, msg + 1);
+
     /* Initialize lanes (possible destroy existing lanes) */
     status = ucp_wireup_init_lanes(ep, address_count, address_list, addr_indices);
     if (status != UCS_OK) {
         return;
     }
 
+    /* The peer sent this request from an endpoint it already holds towards us,
+     * so it is able to receive replies - a discovery request of our own would
+     * carry no new information. When both sides create endpoints to each other
+     * over fully-addressed transports, each pair now exchanges at most one
+     * wireup message instead of two. */
+    ep->flags |= UCP_EP_FLAG_CONNECT_REQ_SENT;
+
     /* Connect p2p addresses to remote endpoint */
     if (!(ep->flags & UCP_EP_FLAG_LOCAL_CONNECTED)) {
         status = ucp_wireup_connect_local(ep, addr_indices, address_count,
@@ -308,8 +318,9 @@ static ucs_status_t ucp_wireup_msg_handler(void *arg, void *data,
 
     UCS_ASYNC_BLOCK(&worker->async);
 
-    status = ucp_address_unpack(msg + 1, &uuid, peer_name, UCP_WORKER_NAME_MAX,
-                                &address_count, &address_list);
+    status = ucp_address_unpack(worker, msg + 1, &uuid, peer_name,
+                                UCP_WORKER_NAME_MAX, &address_count,
+                                &address_list);
     if (status != UCS_OK) {
         ucs_error("failed to unpack address: %s", ucs_status_string(status));
         goto out;
@@ -327,7 +338,9 @@ static ucs_status_t ucp_wireup_msg_handler(void *arg, void *data,
         ucs_bug("invalid wireup message");
     }
 
-    ucs_free(address_list);
+    /* Releases the address list and any transients allocated while
+     * processing the message */
+    ucs_arena_reset(&worker->ctl_arena);
 
 out:
     UCS_ASYNC_UNBLOCK(&worker->async);
@@ -352,10 +365,34 @@ static ucs_status_t ucp_wireup_connect_lane(ucp_ep_h ep, ucp_lane_index_t lane,
     if ((iface_attr->cap.flags & UCT_IFACE_FLAG_CONNECT_TO_IFACE) &&
         ((ep->uct_eps[lane] == NULL) || ucp_stub_ep_test(ep->uct_eps[lane])))
     {
-        /* create an endpoint connected to the remote interface */
-        status = uct_ep_create_connected(worker->ifaces[rsc_index],
+        /* Lanes serving only one-sided operations are not connected here -
+         * the remote address is stashed on a stub endpoint and the real
+         * endpoint is created on first use. The am, wireup and rndv lanes
+         * stay eagerly connected, since they carry the two-sided traffic
+         * every job exercises right after startup. */
+        if ((ep->uct_eps[lane] == NULL) &&
+            (lane != ucp_ep_get_am_lane(ep)) &&
+            (lane != ucp_ep_get_wireup_msg_lane(ep)) &&
+            (lane != ucp_ep_config(ep)->key.rndv_lane))
+        {
+            status = ucp_stub_ep_create(ep, &ep->uct_eps[lane]);
+            if (status != UCS_OK) {
+                return status;
+            }
+
+            ucs_trace("ep %p: defer connect of uct_ep[%d]=%p", ep, lane,
+                      ep->uct_eps[lane]);
+            return ucp_stub_ep_defer_connect(ep->uct_eps[lane], rsc_index,
+                                             &address_list[addr_index]);
+        }
+
+        /* create an endpoint connected to the remote interface, shared with
+         * any other lane which resolves to the same remote address */
+        status = ucp_worker_iface_ep_get(worker, rsc_index,
                                          address_list[addr_index].dev_addr,
+                                         address_list[addr_index].dev_addr_len,
                                          address_list[addr_index].iface_addr,
+                                         address_list[addr_index].tl_addr_len,
                                          &new_uct_ep);
         if (status != UCS_OK) {
             /* coverity[leaked_storage] */
@@ -475,6 +512,7 @@ ucs_status_t ucp_wireup_init_lanes(ucp_ep_h ep, unsigned address_count,
 
     ep->cfg_index = new_cfg_index;
     ep->am_lane   = key.am_lane;
+    ucp_ep_adapt_reset(ep);
 
     snprintf(str, sizeof(str), "ep %p", ep);
     ucp_wireup_print_config(worker->context, &ucp_ep_config(ep)->key, str,
@@ -501,13 +539,138 @@ ucs_status_t ucp_wireup_init_lanes(ucp_ep_h ep, unsigned address_count,
 err:
     for (lane = 0; lane < ucp_ep_num_lanes(ep); ++lane) {
         if (ep->uct_eps[lane] != NULL) {
-            uct_ep_destroy(ep->uct_eps[lane]);
+            if (!ucp_worker_iface_ep_put(worker, ep->uct_eps[lane])) {
+                uct_ep_destroy(ep->uct_eps[lane]);
+            }
             ep->uct_eps[lane] = NULL;
         }
     }
     return status;
 }
 
+static void ucp_wireup_replace_pending_cb(uct_pending_req_t *self, void *arg)
+{
+    uct_ep_h stub_ep = arg;
+    ucs_status_t status;
+
+    status = uct_ep_pending_add(stub_ep, self, 0);
+    ucs_assertv_always(status == UCS_OK,
+                       "failed to move pending request %p to stub ep %p: %s",
+                       self, stub_ep, ucs_status_string(status));
+}
+
+/*
+ * Replace a single failed lane without tearing down the endpoint: re-select a
+ * transport for the roles this lane plays, splice the new endpoint in behind
+ * a stub, and move the pending queue over. Only lanes which can be replaced
+ * one-sidedly (connected to a remote interface) are supported - replacing a
+ * p2p lane would require the remote side to reconfigure as well.
+ */
+ucs_status_t ucp_wireup_replace_lane(ucp_ep_h ep, ucp_lane_index_t lane,
+                                     const ucp_address_t *address)
+{
+    ucp_worker_h worker = ep->worker;
+    char peer_name[UCP_WORKER_NAME_MAX];
+    ucp_address_entry_t *address_list;
+    ucp_ep_config_key_t key;
+    uct_ep_h failed_ep, stub_ep, new_uct_ep;
+    ucp_rsc_index_t rsc_index;
+    unsigned address_count;
+    unsigned addr_index;
+    uint64_t tl_bitmap;
+    ucs_status_t status;
+    uint64_t uuid;
+
+    ucs_assert_always(lane < ucp_ep_num_lanes(ep));
+
+    UCS_ASYNC_BLOCK(&worker->async);
+
+    status = ucp_address_unpack(worker, address, &uuid, peer_name,
+                                UCP_WORKER_NAME_MAX, &address_count,
+                                &address_list);
+    if (status != UCS_OK) {
+        ucs_error("failed to unpack remote address: %s",
+                  ucs_status_string(status));
+        goto out;
+    }
+
+    if (uuid != ep->dest_uuid) {
+        ucs_error("ep %p: lane replacement address belongs to peer 0x%"PRIx64
+                  ", expected 0x%"PRIx64, ep, uuid, ep->dest_uuid);
+        status = UCS_ERR_INVALID_PARAM;
+        goto out;
+    }
+
+    /* Exclude the failed resource, and restrict the selection to transports
+     * which connect without a handshake */
+    tl_bitmap = 0;
+    for (rsc_index = 0; rsc_index < worker->context->num_tls; ++rsc_index) {
+        if ((rsc_index != ucp_ep_get_rsc_index(ep, lane)) &&
+            !ucp_worker_is_tl_p2p(worker, rsc_index))
+        {
+            tl_bitmap |= UCS_BIT(rsc_index);
+        }
+    }
+
+    status = ucp_wireup_select_lane_replacement(ep, lane, address_count,
+                                                address_list, tl_bitmap,
+                                                &rsc_index, &addr_index);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
+    status = ucp_stub_ep_create(ep, &stub_ep);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
+    status = ucp_worker_iface_ep_get(worker, rsc_index,
+                                     address_list[addr_index].dev_addr,
+                                     address_list[addr_index].dev_addr_len,
+                                     address_list[addr_index].iface_addr,
+                                     address_list[addr_index].tl_addr_len,
+                                     &new_uct_ep);
+    if (status != UCS_OK) {
+        uct_ep_destroy(stub_ep);
+        goto out;
+    }
+
+    ucp_stub_ep_set_next_ep(stub_ep, new_uct_ep);
+
+    /* Swap in the stub, move the pending queue of the failed endpoint onto it
+     * and retire the failed endpoint. Wireup messages are forwarded to the
+     * already-connected next_ep, other requests queue on the stub and replay
+     * when it switches the lane over. */
+    failed_ep         = ep->uct_eps[lane];
+    ep->uct_eps[lane] = stub_ep;
+    if (failed_ep != NULL) {
+        uct_ep_pending_purge(failed_ep, ucp_wireup_replace_pending_cb, stub_ep);
+        if (!ucp_worker_iface_ep_put(worker, failed_ep)) {
+            uct_ep_destroy(failed_ep);
+        }
+    }
+
+    /* Update the endpoint configuration with the replacement resource */
+    key                          = ucp_ep_config(ep)->key;
+    key.lanes[lane].rsc_index    = rsc_index;
+    key.lanes[lane].dst_md_index = address_list[addr_index].md_index;
+    ep->cfg_index                = ucp_worker_get_ep_config(worker, &key);
+
+    ucs_debug("ep %p: replaced lane[%d] with " UCT_TL_RESOURCE_DESC_FMT, ep,
+              lane, UCT_TL_RESOURCE_DESC_ARG(
+                        &worker->context->tl_rscs[rsc_index].tl_rsc));
+
+    /* Release queued sends onto the new endpoint through the regular
+     * slow-path switchover */
+    ucp_stub_ep_remote_connected(stub_ep);
+    status = UCS_OK;
+
+out:
+    ucs_arena_reset(&worker->ctl_arena);
+    UCS_ASYNC_UNBLOCK(&worker->async);
+    return status;
+}
+
 ucs_status_t ucp_wireup_send_request(ucp_ep_h ep)
 {
     ucp_worker_h worker = ep->worker;
@@ -561,7 +724,9 @@ static void ucp_wireup_msg_dump(ucp_worker_h worker, uct_am_trace_type_t type,
     uint64_t uuid;
     char *p, *end;
 
-    ucp_address_unpack(msg + 1, &uuid, peer_name, sizeof(peer_name),
+    /* Tracing can run in the middle of a control-path operation, so the
+     * address list must not come from the worker arena */
+    ucp_address_unpack(NULL, msg + 1, &uuid, peer_name, sizeof(peer_name),
                        &address_count, &address_list);
 
     p   = buffer;
@@ -89,6 +89,17 @@ ucs_status_t ucp_wireup_select_lanes(ucp_ep_h ep, unsigned address_count,
                                      uint8_t *addr_indices,
                                      ucp_ep_config_key_t *key);
 
+ucs_status_t
+ucp_wireup_select_lane_replacement(ucp_ep_h ep, ucp_lane_index_t lane,
+                                   unsigned address_count,
+                                   const ucp_address_entry_t *address_list,
+                                   uint64_t tl_bitmap,
+                                   ucp_rsc_index_t *rsc_index_p,
+                                   unsigned *addr_index_p);
+
+ucs_status_t ucp_wireup_replace_lane(ucp_ep_h ep, ucp_lane_index_t lane,
+                                     const ucp_address_t *address);
+
 static inline int ucp_worker_is_tl_p2p(ucp_worker_h worker, ucp_rsc_index_t rsc_index)
 {
     return !(worker->iface_attrs[rsc_index].cap.flags & UCT_IFACE_FLAG_CONNECT_TO_IFACE);
@@ -6,8 +6,17 @@
 
 #include "crc.h"
 
+#include <ucs/arch/cpu.h>
 #include <string.h>
 
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+
+/* CRC32-C (Castagnoli) polynomial, bit-reflected */
+#define UCS_CRC32C_POLY    0x82f63b78u
+
 
 uint16_t ucs_crc16(const void *buffer, size_t size)
 {
@@ -40,3 +49,95 @@ uint16_t ucs_crc16_string(const char *s)
 {
     return ucs_crc16((char*)s, strlen(s));
 }
+
+#if defined(__x86_64__)
+
+static uint32_t ucs_crc32_hw(uint32_t result, const void *buffer, size_t size)
+{
+    const uint8_t *p = buffer;
+    uint64_t crc     = result;
+
+    while ((size > 0) && ((uintptr_t)p & 7)) {
+        asm ("crc32b %1, %0" : "+r" (crc) : "rm" (*p));
+        ++p;
+        --size;
+    }
+    while (size >= sizeof(uint64_t)) {
+        asm ("crc32q %1, %0" : "+r" (crc) : "rm" (*(const uint64_t*)p));
+        p    += sizeof(uint64_t);
+        size -= sizeof(uint64_t);
+    }
+    while (size > 0) {
+        asm ("crc32b %1, %0" : "+r" (crc) : "rm" (*p));
+        ++p;
+        --size;
+    }
+
+    return crc;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+static uint32_t ucs_crc32_hw(uint32_t result, const void *buffer, size_t size)
+{
+    const uint8_t *p = buffer;
+
+    while ((size > 0) && ((uintptr_t)p & 7)) {
+        result = __crc32cb(result, *p);
+        ++p;
+        --size;
+    }
+    while (size >= sizeof(uint64_t)) {
+        result = __crc32cd(result, *(const uint64_t*)p);
+        p     += sizeof(uint64_t);
+        size  -= sizeof(uint64_t);
+    }
+    while (size > 0) {
+        result = __crc32cb(result, *p);
+        ++p;
+        --size;
+    }
+
+    return result;
+}
+
+#endif
+
+#if !(defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+static uint32_t ucs_crc32_sw(uint32_t result, const void *buffer, size_t size)
+{
+    const uint8_t *p;
+    uint8_t data;
+    int bit;
+
+    for (p = buffer; p < (const uint8_t*)(buffer + size); ++p) {
+        data = *p;
+        for (bit = 0; bit < 8; ++bit) {
+            if ((result ^ data) & 1) {
+                result = (result >> 1) ^ UCS_CRC32C_POLY;
+            } else {
+                result >>= 1;
+            }
+            data >>= 1;
+        }
+    }
+
+    return result;
+}
+#endif
+
+uint32_t ucs_crc32(uint32_t crc, const void *buffer, size_t size)
+{
+    uint32_t result = ~crc;
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    return ~ucs_crc32_hw(result, buffer, size);
+#else
+#  if defined(__x86_64__)
+    if (ucs_arch_get_cpu_flag() & UCS_CPU_FLAG_SSE42) {
+        return ~ucs_crc32_hw(result, buffer, size);
+    }
+#  endif
+    return ~ucs_crc32_sw(result, buffer, size);
+#endif
+}
@@ -27,4 +27,19 @@ uint16_t ucs_crc16(const void *buffer, size_t size);
 uint16_t ucs_crc16_string(const char *s);
 
 
+/**
+ * Calculate CRC32-C (Castagnoli) of an arbitrary buffer, using the CPU crc32
+ * instruction when it is available.
+ *
+ * @param [in]  crc     Initial checksum value. Pass 0 to checksum a whole
+ *                      buffer, or the result of the previous call to continue
+ *                      the checksum of a buffer split to several chunks.
+ * @param [in]  buffer  Buffer to compute crc for.
+ * @param [in]  size    Buffer size.
+ *
+ * @return crc32() function of the buffer.
+ */
+uint32_t ucs_crc32(uint32_t crc, const void *buffer, size_t size);
+
+
 #endif
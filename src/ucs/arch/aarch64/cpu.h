@@ -30,6 +30,9 @@
 #define ucs_memory_cpu_store_fence()  asm volatile ("dmb ishst" ::: "memory");
 #define ucs_memory_cpu_load_fence()   asm volatile ("dmb ishld" ::: "memory");
 
+/* relax the cpu while busy-waiting, to reduce power and pipeline flushes */
+#define ucs_cpu_relax()               asm volatile ("yield" ::: "memory")
+
 #if HAVE_HW_TIMER
 static inline uint64_t ucs_arch_read_hres_clock(void)
 {
@@ -73,3 +76,5 @@ static inline void ucs_arch_wait_mem(void *address)
                           : "=&r"(tmp)
                           : "r"(address));
 }
+
+#define ucs_arch_memcpy_nontemporal ucs_arch_generic_memcpy_nontemporal
@@ -0,0 +1,78 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <ucs/arch/cpu.h>
+#include <ucs/sys/compiler.h>
+#include <ucs/sys/math.h>
+#include <ucs/sys/sys.h>
+#include <stdlib.h>
+
+
+/* Do not use streaming stores below this size, even with a tiny LLC */
+#define UCS_MEMCPY_NT_THRESH_MIN   (256 * UCS_KBYTE)
+
+/* Assumed LLC size, when it cannot be read from sysfs */
+#define UCS_MEMCPY_LLC_DEFAULT     (8 * UCS_MBYTE)
+
+
+static void ucs_memcpy_libc(void *dst, const void *src, size_t len)
+{
+    memcpy(dst, src, len);
+}
+
+void (*ucs_memcpy_bulk)(void *dst, const void *src, size_t len) = ucs_memcpy_libc;
+size_t ucs_memcpy_nt_threshold = SIZE_MAX;
+
+
+static size_t ucs_memcpy_llc_size()
+{
+    char buf[32];
+    size_t size;
+    char *endp;
+    int index;
+
+    /* the highest cache index present is the last-level cache */
+    for (index = 3; index >= 2; --index) {
+        if (ucs_read_file(buf, sizeof(buf), 1,
+                          "/sys/devices/system/cpu/cpu0/cache/index%d/size",
+                          index) <= 0) {
+            continue;
+        }
+
+        size = strtoul(buf, &endp, 10);
+        if (*endp == 'K') {
+            size *= UCS_KBYTE;
+        } else if (*endp == 'M') {
+            size *= UCS_MBYTE;
+        }
+        if (size > 0) {
+            return size;
+        }
+    }
+
+    return UCS_MEMCPY_LLC_DEFAULT;
+}
+
+static void UCS_F_CTOR ucs_memcpy_dispatch_init()
+{
+#if defined(__x86_64__)
+    /* With enhanced "rep movsb", the microcoded copy beats a software loop
+     * from ~128 bytes up, without the dispatch overhead of libc memcpy */
+    if (ucs_arch_get_cpu_flag() & UCS_CPU_FLAG_ERMS) {
+        ucs_memcpy_bulk = ucs_x86_memcpy_erms;
+    }
+#endif
+
+    /* Streaming stores pay off once a single copy would wipe a large part of
+     * the LLC; below that, cached copies win because the data is usually
+     * consumed right away on the same socket */
+    ucs_memcpy_nt_threshold = ucs_max(ucs_memcpy_llc_size() / 2,
+                                      UCS_MEMCPY_NT_THRESH_MIN);
+}
@@ -36,7 +36,8 @@ typedef enum ucs_cpu_flag {
     UCS_CPU_FLAG_SSE41      = UCS_BIT(7),
     UCS_CPU_FLAG_SSE42      = UCS_BIT(8),
     UCS_CPU_FLAG_AVX        = UCS_BIT(9),
-    UCS_CPU_FLAG_AVX2       = UCS_BIT(10)
+    UCS_CPU_FLAG_AVX2       = UCS_BIT(10),
+    UCS_CPU_FLAG_ERMS       = UCS_BIT(11)
 } ucs_cpu_flag_t;
 
 
@@ -62,4 +63,71 @@ typedef enum ucs_cpu_flag {
 #define UCS_SYS_CACHE_LINE_SIZE    UCS_ARCH_CACHE_LINE_SIZE
 #endif
 
+
+/* Copies up to this size take the inline small path, with no dispatch */
+#define UCS_MEMCPY_SMALL_MAX       64
+
+
+/* Bulk copy kernel, selected once at startup according to the CPU */
+extern void (*ucs_memcpy_bulk)(void *dst, const void *src, size_t len);
+
+/* Copies of at least this size use non-temporal stores, to avoid wiping the
+ * last-level cache. Set at startup to a fraction of the LLC size. */
+extern size_t ucs_memcpy_nt_threshold;
+
+
+/* Copy up to UCS_MEMCPY_SMALL_MAX bytes as a short sequence of register-width
+ * moves, expanded inline at the call site */
+static UCS_F_ALWAYS_INLINE void
+ucs_memcpy_small(void *dst, const void *src, size_t len)
+{
+    char *d       = (char*)dst;
+    const char *s = (const char*)src;
+    uint64_t v64;
+    uint32_t v32;
+    uint16_t v16;
+
+    while (len >= sizeof(v64)) {
+        memcpy(&v64, s, sizeof(v64));
+        memcpy(d, &v64, sizeof(v64));
+        d   += sizeof(v64);
+        s   += sizeof(v64);
+        len -= sizeof(v64);
+    }
+    if (len & sizeof(v32)) {
+        memcpy(&v32, s, sizeof(v32));
+        memcpy(d, &v32, sizeof(v32));
+        d += sizeof(v32);
+        s += sizeof(v32);
+    }
+    if (len & sizeof(v16)) {
+        memcpy(&v16, s, sizeof(v16));
+        memcpy(d, &v16, sizeof(v16));
+        d += sizeof(v16);
+        s += sizeof(v16);
+    }
+    if (len & 1) {
+        *(uint8_t*)d = *(const uint8_t*)s;
+    }
+}
+
+
+/**
+ * Copy non-overlapping buffers, like memcpy(), using a kernel matched to the
+ * CPU and to the copy size: small copies are expanded inline, medium ones go
+ * through the dispatched bulk kernel, and copies large enough to trash the
+ * last-level cache use non-temporal stores.
+ */
+static UCS_F_ALWAYS_INLINE void
+ucs_memcpy_relaxed(void *dst, const void *src, size_t len)
+{
+    if (ucs_likely(len <= UCS_MEMCPY_SMALL_MAX)) {
+        ucs_memcpy_small(dst, src, len);
+    } else if (ucs_likely(len < ucs_memcpy_nt_threshold)) {
+        ucs_memcpy_bulk(dst, src, len);
+    } else {
+        ucs_arch_memcpy_nontemporal(dst, src, len);
+    }
+}
+
 #endif
@@ -9,6 +9,7 @@
 #define UCS_GENERIC_CPU_H_
 
 #include <sys/time.h>
+#include <string.h>
 
 static inline uint64_t ucs_arch_generic_read_hres_clock(void)
 {
@@ -30,4 +31,10 @@ static inline void ucs_arch_generic_wait_mem(void *address)
     /* NOP */
 }
 
+static inline void ucs_arch_generic_memcpy_nontemporal(void *dst, const void *src,
+                                                       size_t len)
+{
+    memcpy(dst, src, len);
+}
+
 #endif
@@ -27,6 +27,9 @@
 #define ucs_memory_cpu_store_fence()  ucs_memory_bus_fence()
 #define ucs_memory_cpu_load_fence()   ucs_memory_bus_fence()
 
+/* relax the cpu while busy-waiting - drop smt thread priority */
+#define ucs_cpu_relax()               asm volatile ("or 1, 1, 1 \n or 2, 2, 2" ::: "memory")
+
 
 static inline uint64_t ucs_arch_read_hres_clock()
 {
@@ -53,4 +56,6 @@ double ucs_arch_get_clocks_per_sec();
 
 #define ucs_arch_wait_mem ucs_arch_generic_wait_mem
 
+#define ucs_arch_memcpy_nontemporal ucs_arch_generic_memcpy_nontemporal
+
 #endif
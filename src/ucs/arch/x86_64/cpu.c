@@ -216,6 +216,9 @@ int ucs_arch_get_cpu_flag()
             if ((result & UCS_CPU_FLAG_AVX) && (_ebx & (1 << 5))) {
                 result |= UCS_CPU_FLAG_AVX2;
             }
+            if (_ebx & (1 << 9)) {
+                result |= UCS_CPU_FLAG_ERMS;
+            }
         }
         cpu_flag = result;
     }
@@ -223,4 +226,13 @@ int ucs_arch_get_cpu_flag()
     return cpu_flag;
 }
 
+
+void ucs_x86_memcpy_erms(void *dst, const void *src, size_t len)
+{
+    asm volatile ("rep movsb"
+                  : "+D" (dst), "+S" (src), "+c" (len)
+                  :
+                  : "memory");
+}
+
 #endif
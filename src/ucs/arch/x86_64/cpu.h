@@ -11,7 +11,9 @@
 #include <ucs/sys/compiler.h>
 #include <ucs/arch/generic/cpu.h>
 #include <stdint.h>
+#include <string.h>
 
+#include <emmintrin.h>
 #ifdef __SSE4_1__
 #  include <smmintrin.h>
 #endif
@@ -33,6 +35,9 @@
 #define ucs_memory_cpu_store_fence()  ucs_compiler_fence()
 #define ucs_memory_cpu_load_fence()   ucs_compiler_fence()
 
+/* relax the cpu while busy-waiting, to reduce power and pipeline flushes */
+#define ucs_cpu_relax()               asm volatile ("pause" ::: "memory")
+
 
 static inline uint64_t ucs_arch_read_hres_clock()
 {
@@ -46,8 +51,61 @@ double ucs_arch_get_clocks_per_sec();
 ucs_cpu_model_t ucs_arch_get_cpu_model() UCS_F_NOOPTIMIZE;
 ucs_cpu_flag_t ucs_arch_get_cpu_flag() UCS_F_NOOPTIMIZE;
 
+/* Bulk copy with "rep movsb"; fast on CPUs with the ERMS feature */
+void ucs_x86_memcpy_erms(void *dst, const void *src, size_t len);
+
 #define ucs_arch_wait_mem ucs_arch_generic_wait_mem
 
+/**
+ * Copy using non-temporal stores, to avoid evicting the cache working set
+ * when the destination is not going to be read by the CPU soon (e.g bulk
+ * pack/unpack buffers handed off to the network).
+ */
+static inline void ucs_arch_memcpy_nontemporal(void *dst, const void *src,
+                                               size_t len)
+{
+    size_t head   = (-(uintptr_t)dst) & 0xf;
+    char *d       = (char*)dst;
+    const char *s = (const char*)src;
+
+    /* align the destination, so all streaming stores are aligned */
+    if (head != 0) {
+        if (head > len) {
+            head = len;
+        }
+        memcpy(d, s, head);
+        d   += head;
+        s   += head;
+        len -= head;
+    }
+
+    while (len >= 64) {
+        _mm_stream_si128((__m128i*)(d +  0),
+                         _mm_loadu_si128((const __m128i*)(s +  0)));
+        _mm_stream_si128((__m128i*)(d + 16),
+                         _mm_loadu_si128((const __m128i*)(s + 16)));
+        _mm_stream_si128((__m128i*)(d + 32),
+                         _mm_loadu_si128((const __m128i*)(s + 32)));
+        _mm_stream_si128((__m128i*)(d + 48),
+                         _mm_loadu_si128((const __m128i*)(s + 48)));
+        d   += 64;
+        s   += 64;
+        len -= 64;
+    }
+    while (len >= 16) {
+        _mm_stream_si128((__m128i*)d, _mm_loadu_si128((const __m128i*)s));
+        d   += 16;
+        s   += 16;
+        len -= 16;
+    }
+
+    /* make the streamed data globally observable before any subsequent store
+     * which may announce its readiness */
+    ucs_memory_bus_store_fence();
+
+    memcpy(d, s, len);
+}
+
 
 #endif
 
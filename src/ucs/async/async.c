@@ -205,7 +205,8 @@ static ucs_status_t ucs_async_handler_dispatch(ucs_async_handler_t *handler)
         ucs_trace_async("missed " UCS_ASYNC_HANDLER_FMT ", last_wakeup %lu",
                         UCS_ASYNC_HANDLER_ARG(handler), async->last_wakeup);
         if (ucs_atomic_cswap32(&handler->missed, 0, 1) == 0) {
-            status = ucs_mpmc_queue_push(&async->missed, handler->id);
+            status = ucs_mpmc_queue_push(&async->missed,
+                                         (void*)(uintptr_t)handler->id);
             if (status != UCS_OK) {
                 ucs_fatal("Failed to push event %d to miss queue: %s",
                           handler->id, ucs_status_string(status));
@@ -509,7 +510,7 @@ void __ucs_async_poll_missed(ucs_async_context_t *async)
 {
     ucs_async_handler_t *handler;
     ucs_status_t status;
-    uint32_t value;
+    void *value;
 
     ucs_trace_async("miss handler");
 
@@ -523,7 +524,7 @@ void __ucs_async_poll_missed(ucs_async_context_t *async)
         }
 
         ucs_async_method_call_all(block);
-        handler = ucs_async_handler_get(value);
+        handler = ucs_async_handler_get((int)(uintptr_t)value);
         if (handler != NULL) {
             ucs_trace_async("calling missed async handler " UCS_ASYNC_HANDLER_FMT,
                             UCS_ASYNC_HANDLER_ARG(handler));
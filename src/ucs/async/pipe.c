@@ -6,58 +6,68 @@
 
 #include "pipe.h"
 
+#include <ucs/arch/atomic.h>
 #include <ucs/debug/log.h>
 #include <ucs/sys/sys.h>
+#include <sys/eventfd.h>
 
 
 ucs_status_t ucs_async_pipe_create(ucs_async_pipe_t *p)
 {
-    int pipefds[2];
-    int ret;
+    int efd;
 
-    ret = pipe(pipefds);
-    if (ret < 0) {
-        ucs_error("pipe() returned %d: %m", ret);
+    efd = eventfd(0, 0);
+    if (efd < 0) {
+        ucs_error("eventfd() failed: %m");
         goto err;
     }
 
-    /* Set pipe to non blocking */
-    if (ucs_sys_fcntl_modfl(pipefds[0], O_NONBLOCK, 0) != UCS_OK ||
-        ucs_sys_fcntl_modfl(pipefds[1], O_NONBLOCK, 0) != UCS_OK)
-    {
-        goto err_close_pipe;
+    /* Set to non blocking, so drain can consume without risk of getting stuck */
+    if (ucs_sys_fcntl_modfl(efd, O_NONBLOCK, 0) != UCS_OK) {
+        goto err_close_efd;
     }
 
-    p->read_fd  = pipefds[0];
-    p->write_fd = pipefds[1];
+    p->efd   = efd;
+    p->armed = 0;
     return UCS_OK;
 
-err_close_pipe:
-    close(pipefds[0]);
-    close(pipefds[1]);
+err_close_efd:
+    close(efd);
 err:
     return UCS_ERR_IO_ERROR;
 }
 
 void ucs_async_pipe_destroy(ucs_async_pipe_t *p)
 {
-    close(p->read_fd);
-    close(p->write_fd);
+    close(p->efd);
 }
 
 void ucs_async_pipe_push(ucs_async_pipe_t *p)
 {
-    int dummy = 0;
+    uint64_t one = 1;
     int ret;
 
-    ret = write(p->write_fd, &dummy, sizeof(dummy));
+    /* Only the first push since the last drain pays the write syscall - the
+     * fd stays readable until the consumer drains it anyway */
+    if (ucs_atomic_cswap32(&p->armed, 0, 1) != 0) {
+        return;
+    }
+
+    ret = write(p->efd, &one, sizeof(one));
     if (ret < 0 && errno != EAGAIN) {
-        ucs_error("writing to wakeup pipe failed: %m");
+        ucs_error("writing to wakeup eventfd failed: %m");
     }
 }
 
 void ucs_async_pipe_drain(ucs_async_pipe_t *p)
 {
-    int dummy;
-    while (read(p->read_fd, &dummy, sizeof(dummy)) > 0);
+    uint64_t count;
+    int ret;
+
+    /* A single read consumes the whole eventfd counter. Disarm only after
+     * the read: a push racing with the drain may then signal twice, but is
+     * never lost. */
+    ret = read(p->efd, &count, sizeof(count));
+    (void)ret;
+    p->armed = 0;
 }
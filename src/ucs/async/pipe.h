@@ -9,13 +9,17 @@
 
 #include <ucs/type/status.h>
 
+#include <stdint.h>
+
 
 /**
- * A pipe for event signaling.
+ * An eventfd-based doorbell for event signaling. A single push makes the
+ * fd readable; further pushes are elided until the consumer drains, so a
+ * burst of events costs at most one write syscall.
  */
 typedef struct ucs_async_pipe {
-    int   read_fd;
-    int   write_fd;
+    int               efd;    /* eventfd, readable when signaled */
+    volatile uint32_t armed;  /* nonzero while a push is pending */
 } ucs_async_pipe_t ;
 
 
@@ -39,7 +43,7 @@ void ucs_async_pipe_drain(ucs_async_pipe_t *p);
  * @return File descriptor which gets the pipe events.
  */
 static inline int ucs_async_pipe_rfd(ucs_async_pipe_t *p) {
-    return p->read_fd;
+    return p->efd;
 }
 
 #endif
@@ -10,38 +10,51 @@
 
 #include "thread.h"
 #include "async_int.h"
-#include "pipe.h"
 
 #include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
+#include <ucs/config/global_opts.h>
 #include <ucs/sys/checker.h>
 #include <ucs/sys/sys.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 
 #define UCS_ASYNC_EPOLL_MAX_EVENTS      16
-#define UCS_ASYNC_EPOLL_MIN_TIMEOUT_MS  2.0
 
 
+/*
+ * A progress thread blocks only in epoll_wait(): wakeups arrive on an eventfd,
+ * and all software timers are coalesced into a single timerfd armed to the
+ * shortest interval in the thread's timer queue.
+ */
 typedef struct ucs_async_thread {
-    ucs_async_pipe_t   wakeup;
+    int                wakeup_efd;
+    int                timer_fd;
     int                epfd;
     ucs_timer_queue_t  timerq;
     pthread_t          thread_id;
     int                stop;
+    volatile uint32_t  sleeping;   /* Set while blocked in epoll_wait(), lets
+                                      wakers skip the eventfd write when the
+                                      thread is known-awake */
     uint32_t           refcnt;
 } ucs_async_thread_t;
 
 
 typedef struct ucs_async_thread_global_context {
-    ucs_async_thread_t *thread;
+    ucs_async_thread_t **threads;     /* Progress thread pool */
+    unsigned           num_threads;   /* Pool size, fixed on first use */
     unsigned           use_count;
     pthread_mutex_t    lock;
 } ucs_async_thread_global_context_t;
 
 
 static ucs_async_thread_global_context_t ucs_async_thread_global_context = {
-    .thread    = NULL,
-    .use_count = 0,
-    .lock      = PTHREAD_MUTEX_INITIALIZER
+    .threads     = NULL,
+    .num_threads = 0,
+    .use_count   = 0,
+    .lock        = PTHREAD_MUTEX_INITIALIZER
 };
 
 
@@ -54,78 +67,103 @@ static void ucs_async_thread_put(ucs_async_thread_t *thread)
 {
     if (ucs_atomic_fadd32(&thread->refcnt, -1) == 1) {
         close(thread->epfd);
-        ucs_async_pipe_destroy(&thread->wakeup);
+        close(thread->timer_fd);
+        close(thread->wakeup_efd);
         ucs_timerq_cleanup(&thread->timerq);
         ucs_free(thread);
     }
 }
 
+static void ucs_async_thread_wakeup(ucs_async_thread_t *thread)
+{
+    uint64_t one = 1;
+    int ret;
+
+    /* Pair with the fence in the thread loop: the thread publishes 'sleeping'
+     * before blocking and re-checks 'stop' after, so if we see it awake here
+     * it is guaranteed to observe our state change without a wakeup. */
+    ucs_memory_cpu_fence();
+    if (!thread->sleeping) {
+        return;
+    }
+
+    ret = write(thread->wakeup_efd, &one, sizeof(one));
+    if (ret < 0) {
+        ucs_warn("failed to signal wakeup eventfd: %m");
+    }
+}
+
+/* Re-arm the thread's timerfd to the shortest interval in its timer queue,
+ * or disarm it if the queue is empty. */
+static void ucs_async_thread_arm_timerfd(ucs_async_thread_t *thread)
+{
+    ucs_time_t interval = ucs_timerq_min_interval(&thread->timerq);
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (interval != UCS_TIME_INFINITY) {
+        ucs_sec_to_timespec(ucs_time_to_sec(interval), &its.it_interval);
+        its.it_value = its.it_interval;
+    }
+
+    if (timerfd_settime(thread->timer_fd, 0, &its, NULL) < 0) {
+        ucs_warn("timerfd_settime(fd=%d) failed: %m", thread->timer_fd);
+    }
+}
+
 static void *ucs_async_thread_func(void *arg)
 {
     ucs_async_thread_t *thread = arg;
     struct epoll_event events[UCS_ASYNC_EPOLL_MAX_EVENTS];
-    ucs_time_t last_time, curr_time, timer_interval, time_spent;
-    int i, nready, is_missed, timeout_ms;
     ucs_status_t status;
-    int fd;
-
-    is_missed  = 0;
-    curr_time  = ucs_get_time();
-    last_time  = ucs_get_time();
+    uint64_t count;
+    int i, nready;
+    int ret, fd;
 
     while (!thread->stop) {
-
-        /* If we didn't get the lock, give other threads priority */
-        if (is_missed) {
-            sched_yield();
-            is_missed = 0;
+        thread->sleeping = 1;
+        ucs_memory_cpu_fence();
+        if (thread->stop) {
+            thread->sleeping = 0;
+            break;
         }
 
-        /* Wait until the remainder of current period */
-        timer_interval = ucs_timerq_min_interval(&thread->timerq);
-        if (timer_interval == UCS_TIME_INFINITY) {
-            timeout_ms = -1;
-        } else {
-            time_spent = curr_time - last_time;
-            timeout_ms = ucs_time_to_msec(timer_interval -
-                                          ucs_min(time_spent, timer_interval));
-        }
-        nready = epoll_wait(thread->epfd, events, UCS_ASYNC_EPOLL_MAX_EVENTS,
-                            timeout_ms);
-        if ((nready < 0) && (errno != EINTR)) {
+        nready = epoll_wait(thread->epfd, events, UCS_ASYNC_EPOLL_MAX_EVENTS, -1);
+        thread->sleeping = 0;
+        if (nready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
             ucs_fatal("epoll_wait() failed: %m");
         }
-        ucs_trace_async("epoll_wait(epfd=%d, timeout=%d) returned %d",
-                        thread->epfd, timeout_ms, nready);
+        ucs_trace_async("epoll_wait(epfd=%d) returned %d", thread->epfd, nready);
 
-        /* Check ready files */
-        if (nready > 0) {
-            for (i = 0; i < nready; ++i) {
-                fd = events[i].data.fd;
+        for (i = 0; i < nready; ++i) {
+            fd = events[i].data.fd;
 
-                /* Check wakeup pipe */
-                if (fd == ucs_async_pipe_rfd(&thread->wakeup)) {
-                    ucs_trace_async("progress thread woken up");
-                    ucs_async_pipe_drain(&thread->wakeup);
-                    continue;
-                }
+            if (fd == thread->wakeup_efd) {
+                ucs_trace_async("progress thread woken up");
+                ret = read(thread->wakeup_efd, &count, sizeof(count));
+                (void)ret;
+                continue;
+            }
 
+            if (fd == thread->timer_fd) {
+                /* Consume the expiration count; per-timer deadlines are
+                 * tracked by the timer queue itself */
+                ret = read(thread->timer_fd, &count, sizeof(count));
+                (void)ret;
+                status = ucs_async_dispatch_timerq(&thread->timerq,
+                                                   ucs_get_time());
+            } else {
                 status = ucs_async_dispatch_handlers(&fd, 1);
-                if (status == UCS_ERR_NO_PROGRESS) {
-                    is_missed = 1;
-                }
             }
-        }
 
-        /* Check timers */
-        curr_time = ucs_get_time();
-        if (curr_time - last_time > timer_interval) {
-            status = ucs_async_dispatch_timerq(&thread->timerq, curr_time);
+            /* The handler went to the miss queue - let its owner make
+             * progress before polling again */
             if (status == UCS_ERR_NO_PROGRESS) {
-                 is_missed = 1;
+                sched_yield();
             }
-
-            last_time = curr_time;
         }
     }
 
@@ -133,24 +171,30 @@ static void *ucs_async_thread_func(void *arg)
     return NULL;
 }
 
-static ucs_status_t ucs_async_thread_start(ucs_async_thread_t **thread_p)
+static ucs_status_t ucs_async_thread_add_to_epoll(ucs_async_thread_t *thread,
+                                                  int fd)
 {
-    ucs_async_thread_t *thread;
     struct epoll_event event;
-    ucs_status_t status;
-    int wakeup_rfd;
     int ret;
 
-    ucs_trace_func("");
-
-    pthread_mutex_lock(&ucs_async_thread_global_context.lock);
-    if (ucs_async_thread_global_context.use_count++ > 0) {
-        /* Thread already started */
-        status = UCS_OK;
-        goto out_unlock;
+    memset(&event, 0, sizeof(event));
+    event.events  = EPOLLIN;
+    event.data.fd = fd;
+    ret = epoll_ctl(thread->epfd, EPOLL_CTL_ADD, fd, &event);
+    if (ret < 0) {
+        ucs_error("epoll_ctl(epfd=%d, ADD, fd=%d) failed: %m", thread->epfd,
+                  fd);
+        return UCS_ERR_IO_ERROR;
     }
 
-    ucs_assert_always(ucs_async_thread_global_context.thread == NULL);
+    return UCS_OK;
+}
+
+static ucs_status_t ucs_async_thread_start_one(ucs_async_thread_t **thread_p)
+{
+    ucs_async_thread_t *thread;
+    ucs_status_t status;
+    int ret;
 
     thread = ucs_malloc(sizeof(*thread), "async_thread_context");
     if (thread == NULL) {
@@ -158,37 +202,45 @@ static ucs_status_t ucs_async_thread_start(ucs_async_thread_t **thread_p)
         goto err;
     }
 
-    thread->stop   = 0;
-    thread->refcnt = 1;
+    thread->stop     = 0;
+    thread->sleeping = 0;
+    thread->refcnt   = 1;
 
     status = ucs_timerq_init(&thread->timerq);
     if (status != UCS_OK) {
         goto err_free;
     }
 
-    status = ucs_async_pipe_create(&thread->wakeup);
-    if (status != UCS_OK) {
+    thread->wakeup_efd = eventfd(0, 0);
+    if (thread->wakeup_efd < 0) {
+        ucs_error("eventfd() failed: %m");
+        status = UCS_ERR_IO_ERROR;
         goto err_timerq_cleanup;
     }
 
+    /* A single kernel timer serves all timers mapped to this thread */
+    thread->timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (thread->timer_fd < 0) {
+        ucs_error("timerfd_create() failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_close_efd;
+    }
+
     /* Create epoll set the thread will wait on */
     thread->epfd = epoll_create(1);
     if (thread->epfd < 0) {
         ucs_error("epoll_create() failed: %m");
         status = UCS_ERR_IO_ERROR;
-        goto err_close_pipe;
+        goto err_close_timerfd;
     }
 
-    /* Add wakeup pipe to epoll set */
-    wakeup_rfd    = ucs_async_pipe_rfd(&thread->wakeup);
-    memset(&event, 0, sizeof(event));
-    event.events  = EPOLLIN;
-    event.data.fd = wakeup_rfd;
-    ret = epoll_ctl(thread->epfd, EPOLL_CTL_ADD, wakeup_rfd, &event);
-    if (ret < 0) {
-        ucs_error("epoll_ctl(epfd=%d, ADD, fd=%d) failed: %m",thread->epfd,
-                  wakeup_rfd);
-        status = UCS_ERR_IO_ERROR;
+    status = ucs_async_thread_add_to_epoll(thread, thread->wakeup_efd);
+    if (status != UCS_OK) {
+        goto err_close_epfd;
+    }
+
+    status = ucs_async_thread_add_to_epoll(thread, thread->timer_fd);
+    if (status != UCS_OK) {
         goto err_close_epfd;
     }
 
@@ -199,53 +251,121 @@ static ucs_status_t ucs_async_thread_start(ucs_async_thread_t **thread_p)
         goto err_close_epfd;
     }
 
-    ucs_async_thread_global_context.thread = thread;
-    status = UCS_OK;
-    goto out_unlock;
+    *thread_p = thread;
+    return UCS_OK;
 
 err_close_epfd:
     close(thread->epfd);
-err_close_pipe:
-    ucs_async_pipe_destroy(&thread->wakeup);
+err_close_timerfd:
+    close(thread->timer_fd);
+err_close_efd:
+    close(thread->wakeup_efd);
 err_timerq_cleanup:
     ucs_timerq_cleanup(&thread->timerq);
 err_free:
     ucs_free(thread);
 err:
-    --ucs_async_thread_global_context.use_count;
+    return status;
+}
+
+static void ucs_async_thread_stop_one(ucs_async_thread_t *thread)
+{
+    ucs_async_thread_hold(thread);
+    thread->stop = 1;
+    ucs_async_thread_wakeup(thread);
+
+    if (pthread_self() == thread->thread_id) {
+        pthread_detach(thread->thread_id);
+    } else {
+        pthread_join(thread->thread_id, NULL);
+    }
+    ucs_async_thread_put(thread);
+}
+
+static ucs_status_t ucs_async_thread_pool_start()
+{
+    ucs_async_thread_global_context_t *gctx = &ucs_async_thread_global_context;
+    ucs_async_thread_t **threads;
+    unsigned i, num_threads;
+    ucs_status_t status;
+
+    ucs_trace_func("");
+
+    pthread_mutex_lock(&gctx->lock);
+    if (gctx->use_count++ > 0) {
+        /* Pool already started */
+        status = UCS_OK;
+        goto out_unlock;
+    }
+
+    ucs_assert_always(gctx->threads == NULL);
+
+    num_threads = ucs_max(1, ucs_global_opts.async_threads);
+    threads     = ucs_calloc(num_threads, sizeof(*threads), "async_thread_pool");
+    if (threads == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    for (i = 0; i < num_threads; ++i) {
+        status = ucs_async_thread_start_one(&threads[i]);
+        if (status != UCS_OK) {
+            while (i-- > 0) {
+                ucs_async_thread_stop_one(threads[i]);
+            }
+            ucs_free(threads);
+            goto err;
+        }
+    }
+
+    gctx->threads     = threads;
+    gctx->num_threads = num_threads;
+    status            = UCS_OK;
+    goto out_unlock;
+
+err:
+    --gctx->use_count;
 out_unlock:
-    ucs_assert_always(ucs_async_thread_global_context.thread != NULL);
-    *thread_p = ucs_async_thread_global_context.thread;
-    pthread_mutex_unlock(&ucs_async_thread_global_context.lock);
+    pthread_mutex_unlock(&gctx->lock);
     return status;
 }
 
-static void ucs_async_thread_stop()
+static void ucs_async_thread_pool_stop()
 {
-    ucs_async_thread_t *thread = NULL;
+    ucs_async_thread_global_context_t *gctx = &ucs_async_thread_global_context;
+    ucs_async_thread_t **threads = NULL;
+    unsigned i, num_threads = 0;
 
     ucs_trace_func("");
 
-    pthread_mutex_lock(&ucs_async_thread_global_context.lock);
-    if (--ucs_async_thread_global_context.use_count == 0) {
-        thread = ucs_async_thread_global_context.thread;
-        ucs_async_thread_hold(thread);
-        thread->stop = 1;
-        ucs_async_pipe_push(&thread->wakeup);
-        ucs_async_thread_global_context.thread = NULL;
+    pthread_mutex_lock(&gctx->lock);
+    if (--gctx->use_count == 0) {
+        threads           = gctx->threads;
+        num_threads       = gctx->num_threads;
+        gctx->threads     = NULL;
+        gctx->num_threads = 0;
     }
-    pthread_mutex_unlock(&ucs_async_thread_global_context.lock);
+    pthread_mutex_unlock(&gctx->lock);
 
-    if (thread != NULL) {
-        if (pthread_self() == thread->thread_id) {
-            pthread_detach(thread->thread_id);
-        } else {
-            pthread_join(thread->thread_id, NULL);
+    if (threads != NULL) {
+        for (i = 0; i < num_threads; ++i) {
+            ucs_async_thread_stop_one(threads[i]);
         }
-        ucs_async_thread_put(thread);
+        ucs_free(threads);
     }
 }
 
+/* Map an event fd or timer id to its progress thread. The mapping is
+ * deterministic, so removal finds the same thread as addition without extra
+ * bookkeeping, and it spreads many workers evenly over a small pool. */
+static ucs_async_thread_t *ucs_async_thread_get(int id)
+{
+    ucs_async_thread_global_context_t *gctx = &ucs_async_thread_global_context;
+
+    ucs_assert(gctx->num_threads > 0);
+    return gctx->threads[(unsigned)id % gctx->num_threads];
+}
+
 static ucs_status_t ucs_async_thread_init(ucs_async_context_t *async)
 {
 #if !(NVALGRIND)
@@ -275,11 +395,12 @@ static ucs_status_t ucs_async_thread_add_event_fd(ucs_async_context_t *async,
     ucs_status_t status;
     int ret;
 
-    status = ucs_async_thread_start(&thread);
+    status = ucs_async_thread_pool_start();
     if (status != UCS_OK) {
         goto err;
     }
 
+    thread = ucs_async_thread_get(event_fd);
     memset(&event, 0, sizeof(event));
     event.events  = events;
     event.data.fd = event_fd;
@@ -291,11 +412,12 @@ static ucs_status_t ucs_async_thread_add_event_fd(ucs_async_context_t *async,
         goto err_removed;
     }
 
-    ucs_async_pipe_push(&thread->wakeup);
+    /* No wakeup is needed - epoll_ctl() takes effect while the progress
+     * thread is blocked in epoll_wait() */
     return UCS_OK;
 
 err_removed:
-    ucs_async_thread_stop();
+    ucs_async_thread_pool_stop();
 err:
     return status;
 }
@@ -303,7 +425,7 @@ err:
 static ucs_status_t ucs_async_thread_remove_event_fd(ucs_async_context_t *async,
                                                      int event_fd)
 {
-    ucs_async_thread_t *thread = ucs_async_thread_global_context.thread;
+    ucs_async_thread_t *thread = ucs_async_thread_get(event_fd);
     int ret;
 
     ret = epoll_ctl(thread->epfd, EPOLL_CTL_DEL, event_fd, NULL);
@@ -313,7 +435,7 @@ static ucs_status_t ucs_async_thread_remove_event_fd(ucs_async_context_t *async,
         return UCS_ERR_INVALID_PARAM;
     }
 
-    ucs_async_thread_stop();
+    ucs_async_thread_pool_stop();
     return UCS_OK;
 }
 
@@ -344,21 +466,22 @@ static ucs_status_t ucs_async_thread_add_timer(ucs_async_context_t *async,
         goto err;
     }
 
-    status = ucs_async_thread_start(&thread);
+    status = ucs_async_thread_pool_start();
     if (status != UCS_OK) {
         goto err;
     }
 
+    thread = ucs_async_thread_get(timer_id);
     status = ucs_timerq_add(&thread->timerq, timer_id, interval);
     if (status != UCS_OK) {
         goto err_stop;
     }
 
-    ucs_async_pipe_push(&thread->wakeup);
+    ucs_async_thread_arm_timerfd(thread);
     return UCS_OK;
 
 err_stop:
-    ucs_async_thread_stop();
+    ucs_async_thread_pool_stop();
 err:
     return status;
 }
@@ -366,17 +489,17 @@ err:
 static ucs_status_t ucs_async_thread_remove_timer(ucs_async_context_t *async,
                                                   int timer_id)
 {
-    ucs_async_thread_t *thread = ucs_async_thread_global_context.thread;
+    ucs_async_thread_t *thread = ucs_async_thread_get(timer_id);
     ucs_timerq_remove(&thread->timerq, timer_id);
-    ucs_async_pipe_push(&thread->wakeup);
-    ucs_async_thread_stop();
+    ucs_async_thread_arm_timerfd(thread);
+    ucs_async_thread_pool_stop();
     return UCS_OK;
 }
 
 static void ucs_async_signal_global_cleanup()
 {
-    if (ucs_async_thread_global_context.thread != NULL) {
-        ucs_info("async thread still running (use count %d)",
+    if (ucs_async_thread_global_context.threads != NULL) {
+        ucs_info("async thread pool still running (use count %d)",
                  ucs_async_thread_global_context.use_count);
     }
 }
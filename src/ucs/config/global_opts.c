@@ -17,6 +17,7 @@ ucs_global_opts_t ucs_global_opts = {
     .log_file              = "",
     .log_buffer_size       = 1024,
     .log_data_size         = 0,
+    .log_async             = 0,
     .mpool_fifo            = 0,
     .handle_errors         = UCS_BIT(UCS_HANDLE_ERROR_BACKTRACE),
     .error_signals         = { NULL, 0 },
@@ -25,6 +26,7 @@ ucs_global_opts_t ucs_global_opts = {
     .gdb_command           = "gdb",
     .debug_signo           = SIGHUP,
     .async_max_events      = 64,
+    .async_threads         = 1,
     .async_signo           = SIGALRM,
     .stats_dest            = "",
     .tuning_path           = "",
@@ -32,10 +34,15 @@ ucs_global_opts_t ucs_global_opts = {
     .stats_dest            = "",
     .stats_trigger         = "exit",
     .memtrack_dest         = "",
+    .memtrack_sample       = 1,
     .profile_mode          = 0,
     .profile_file          = "",
+    .profile_sample        = 1,
+    .stats_shm             = 1,
     .stats_filter          = { NULL, 0 },
+    .md_components         = { NULL, 0 },
     .stats_format          = UCS_STATS_FULL,
+    .stats_delta           = 0,
 };
 
 static const char *ucs_handle_error_modes[] = {
@@ -73,6 +80,13 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   "How much packet payload to print, at most, in data mode.",
   ucs_offsetof(ucs_global_opts_t, log_data_size), UCS_CONFIG_TYPE_ULONG},
 
+ {"LOG_ASYNC", "n",
+  "Stage debug and trace log messages in per-thread buffers and write them to\n"
+  "the output file from a background thread. If a buffer fills up, new messages\n"
+  "are dropped and counted instead of blocking the caller. Messages of level\n"
+  "warn and higher are always written synchronously.",
+  ucs_offsetof(ucs_global_opts_t, log_async), UCS_CONFIG_TYPE_BOOL},
+
 #if ENABLE_DEBUG_DATA
  {"MPOOL_FIFO", "n",
   "Enable FIFO behavior for memory pool, instead of LIFO. Useful for\n"
@@ -114,10 +128,22 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   "Maximal number of events which can be handled from one context",
   ucs_offsetof(ucs_global_opts_t, async_max_events), UCS_CONFIG_TYPE_UINT},
 
+ {"ASYNC_THREADS", "1",
+  "Number of threads in the shared async progress thread pool (thread mode).\n"
+  "Event file descriptors and timers are spread over the pool, so processes\n"
+  "with many workers can be serviced by a few progress threads.",
+  ucs_offsetof(ucs_global_opts_t, async_threads), UCS_CONFIG_TYPE_UINT},
+
  {"ASYNC_SIGNO", "SIGALRM",
   "Signal number used for async signaling.",
   ucs_offsetof(ucs_global_opts_t, async_signo), UCS_CONFIG_TYPE_SIGNO},
 
+ {"STATS_SHM", "y",
+  "Publish always-on statistics counters in a shared memory segment\n"
+  "(/dev/shm/ucx_stats_<pid>), which an external reader can scrape while the\n"
+  "process is running. Unrelated to the full statistics infrastructure.",
+  ucs_offsetof(ucs_global_opts_t, stats_shm), UCS_CONFIG_TYPE_BOOL},
+
 #if ENABLE_STATS
  {"STATS_DEST", "",
   "Destination to send statistics to. If the value is empty, statistics are\n"
@@ -154,8 +180,24 @@ static ucs_config_field_t ucs_global_opts_table[] = {
    "  summary - all counters will be printed in the same line.",
    ucs_offsetof(ucs_global_opts_t, stats_format), UCS_CONFIG_TYPE_ENUM(ucs_stats_formats_names)},
 
+  {"STATS_DELTA", "n",
+   "Stream statistics to a UDP destination incrementally: a full dump serves\n"
+   "as the dictionary of node and counter names, then each report carries only\n"
+   "the counters which changed, as compact varint deltas. A full dump is\n"
+   "re-sent periodically to recover from lost packets. Effective only with\n"
+   "STATS_DEST=udp:<host>.",
+   ucs_offsetof(ucs_global_opts_t, stats_delta), UCS_CONFIG_TYPE_BOOL},
+
 #endif
 
+  {"MD_COMPONENTS", "*",
+   "Comma-separated list of glob patterns specifying which memory domain\n"
+   "components may probe for devices. Components not matching any pattern are\n"
+   "skipped entirely, including their device discovery system calls - for\n"
+   "example, UCX_MD_COMPONENTS=tcp,self,sysv avoids the InfiniBand probing on\n"
+   "every process start in a TCP-only deployment.",
+   ucs_offsetof(ucs_global_opts_t, md_components), UCS_CONFIG_TYPE_STRING_ARRAY},
+
 #if ENABLE_MEMTRACK
  {"MEMTRACK_DEST", "",
   "Destination to output memory tracking report to. If the value is empty,\n"
@@ -164,6 +206,11 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   "  stdout            - print to standard output.\n"
   "  stderr            - print to standard error.\n",
   ucs_offsetof(ucs_global_opts_t, memtrack_dest), UCS_CONFIG_TYPE_STRING},
+
+ {"MEMTRACK_SAMPLE", "1",
+  "Track one out of this number of allocations. Reported sizes and counts\n"
+  "reflect only the sampled allocations.",
+  ucs_offsetof(ucs_global_opts_t, memtrack_sample), UCS_CONFIG_TYPE_UINT},
 #endif
 
 #if HAVE_PROFILING
@@ -182,6 +229,12 @@ static ucs_config_field_t ucs_global_opts_table[] = {
   {"PROFILE_LOG_SIZE", "4m",
    "Maximal size of profiling log. New records will replace old records.",
    ucs_offsetof(ucs_global_opts_t, profile_log_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"PROFILE_SAMPLE", "1",
+   "Log one out of this number of top-level profile events. A sampled-out\n"
+   "scope is skipped together with everything nested in it. Accumulated\n"
+   "measurements are not affected.",
+   ucs_offsetof(ucs_global_opts_t, profile_sample), UCS_CONFIG_TYPE_UINT},
 #endif
 
  {NULL}
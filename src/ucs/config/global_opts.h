@@ -33,6 +33,9 @@ typedef struct {
     /* Maximal amount of packet data to print per packet */
     size_t                   log_data_size;
 
+    /* Offload log output to a background flusher thread */
+    int                      log_async;
+
     /* Enable FIFO behavior for memory pool, instead of LIFO. Useful for
      * debugging because object pointers are not recycled. */
     int                      mpool_fifo;
@@ -61,6 +64,9 @@ typedef struct {
     /* Max. events per context, will be removed in the future */
     unsigned                 async_max_events;
 
+    /* Number of threads in the shared async progress thread pool */
+    unsigned                 async_threads;
+
     /* Destination for statistics: udp:host:port / file:path / stdout
      */
     char                     *stats_dest;
@@ -82,6 +88,9 @@ typedef struct {
      */
     char                     *memtrack_dest;
 
+    /* Track only one in this number of allocations */
+    unsigned                 memtrack_sample;
+
     /* Profiling mode */
     unsigned                 profile_mode;
 
@@ -91,12 +100,24 @@ typedef struct {
     /* Limit for profiling log size */
      size_t                   profile_log_size;
 
+    /* Log only one of this number of top-level profile events */
+    unsigned                 profile_sample;
+
+    /* Whether to publish always-on counters in a shared memory segment */
+    int                      stats_shm;
+
     /* Counters to be included in statistics summary */
     ucs_config_names_array_t stats_filter;
 
+    /* Memory domain components allowed to probe for devices */
+    ucs_config_names_array_t md_components;
+
     /* statistics format options */
     ucs_stats_formats_t      stats_format;
 
+    /* Whether to stream statistics as delta reports over UDP */
+    int                      stats_delta;
+
 } ucs_global_opts_t;
 
 
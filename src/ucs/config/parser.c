@@ -9,17 +9,36 @@
 #endif
 #include "parser.h"
 
+#include <ucs/algorithm/crc.h>
+#include <ucs/datastruct/list.h>
 #include <ucs/sys/sys.h>
 #include <ucs/sys/string.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/debug.h>
 #include <ucs/time/time.h>
 #include <fnmatch.h>
+#include <pthread.h>
 
 
 typedef UCS_CONFIG_ARRAY_FIELD(void, data) ucs_config_array_field_t;
 
 
+/* Fully parsed copy of an options table, reused by subsequent
+ * ucs_config_parser_fill_opts_cached() calls for the same table and prefixes
+ * as long as the UCX_* environment did not change */
+typedef struct ucs_config_cached_opts {
+    ucs_list_link_t          list;
+    ucs_config_field_t       *fields;
+    char                     *env_prefix;
+    char                     *table_prefix;
+    uint32_t                 env_crc;     /* CRC of UCX_* environment strings */
+    void                     *opts;
+} ucs_config_cached_opts_t;
+
+static UCS_LIST_HEAD(ucs_config_opts_cache);
+static pthread_mutex_t ucs_config_opts_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
 /* Process environment variables */
 extern char **environ;
 
@@ -924,6 +943,124 @@ err:
     return status;
 }
 
+static uint32_t ucs_config_parser_env_crc()
+{
+    uint32_t crc = 0;
+    char **envp;
+
+    for (envp = environ; *envp != NULL; ++envp) {
+        if (!strncmp(*envp, UCS_CONFIG_PREFIX, strlen(UCS_CONFIG_PREFIX))) {
+            /* Include the terminating '\0' to delimit the strings */
+            crc = ucs_crc32(crc, *envp, strlen(*envp) + 1);
+        }
+    }
+    return crc;
+}
+
+static int ucs_config_parser_prefix_equal(const char *prefix1, const char *prefix2)
+{
+    return (prefix1 == NULL) ? (prefix2 == NULL) :
+           ((prefix2 != NULL) && !strcmp(prefix1, prefix2));
+}
+
+ucs_status_t ucs_config_parser_fill_opts_cached(void *opts,
+                                               ucs_config_field_t *fields,
+                                               size_t opts_size,
+                                               const char *env_prefix,
+                                               const char *table_prefix,
+                                               int ignore_errors)
+{
+    ucs_config_cached_opts_t *entry, *cached = NULL;
+    ucs_status_t status;
+    uint32_t env_crc;
+
+    env_crc = ucs_config_parser_env_crc();
+
+    pthread_mutex_lock(&ucs_config_opts_cache_lock);
+
+    ucs_list_for_each(entry, &ucs_config_opts_cache, list) {
+        if ((entry->fields == fields) &&
+            ucs_config_parser_prefix_equal(entry->env_prefix, env_prefix) &&
+            ucs_config_parser_prefix_equal(entry->table_prefix, table_prefix))
+        {
+            cached = entry;
+            break;
+        }
+    }
+
+    if ((cached != NULL) && (cached->env_crc == env_crc)) {
+        /* Same table and environment as before - copy the parsed values
+         * instead of going through getenv+sscanf for every field */
+        status = ucs_config_parser_clone_opts(cached->opts, opts, fields);
+        goto out;
+    }
+
+    status = ucs_config_parser_fill_opts(opts, fields, env_prefix, table_prefix,
+                                         ignore_errors);
+    if (status != UCS_OK) {
+        goto out;
+    }
+
+    /* Save a copy for the next call. Failing to cache is not an error -
+     * the caller's options are already filled */
+    if (cached == NULL) {
+        cached = ucs_malloc(sizeof(*cached), "config cache entry");
+        if (cached == NULL) {
+            goto out;
+        }
+
+        cached->fields       = fields;
+        cached->env_prefix   = (env_prefix   == NULL) ? NULL :
+                               ucs_strdup(env_prefix, "config cache env prefix");
+        cached->table_prefix = (table_prefix == NULL) ? NULL :
+                               ucs_strdup(table_prefix, "config cache tbl prefix");
+        cached->opts         = ucs_calloc(1, opts_size, "config cache opts");
+        if (((env_prefix   != NULL) && (cached->env_prefix   == NULL)) ||
+            ((table_prefix != NULL) && (cached->table_prefix == NULL)) ||
+            (cached->opts == NULL))
+        {
+            ucs_free(cached->env_prefix);
+            ucs_free(cached->table_prefix);
+            ucs_free(cached->opts);
+            ucs_free(cached);
+            goto out;
+        }
+
+        ucs_list_add_tail(&ucs_config_opts_cache, &cached->list);
+    } else {
+        ucs_config_parser_release_opts(cached->opts, fields);
+    }
+
+    if (ucs_config_parser_clone_opts(opts, cached->opts, fields) != UCS_OK) {
+        ucs_list_del(&cached->list);
+        ucs_free(cached->env_prefix);
+        ucs_free(cached->table_prefix);
+        ucs_free(cached->opts);
+        ucs_free(cached);
+        goto out;
+    }
+
+    cached->env_crc = env_crc;
+
+out:
+    pthread_mutex_unlock(&ucs_config_opts_cache_lock);
+    return status;
+}
+
+static void UCS_F_DTOR ucs_config_opts_cache_cleanup()
+{
+    ucs_config_cached_opts_t *entry, *tmp;
+
+    ucs_list_for_each_safe(entry, tmp, &ucs_config_opts_cache, list) {
+        ucs_list_del(&entry->list);
+        ucs_config_parser_release_opts(entry->opts, entry->fields);
+        ucs_free(entry->env_prefix);
+        ucs_free(entry->table_prefix);
+        ucs_free(entry->opts);
+        ucs_free(entry);
+    }
+}
+
 ucs_status_t ucs_config_parser_set_value(void *opts, ucs_config_field_t *fields,
                                         const char *name, const char *value)
 {
@@ -252,6 +252,21 @@ ucs_status_t ucs_config_parser_fill_opts(void *opts, ucs_config_field_t *fields,
                                          const char *table_prefix,
                                          int ignore_errors);
 
+/**
+ * Same as ucs_config_parser_fill_opts(), but keeps a parsed copy of the
+ * options keyed by (fields, prefixes, environment contents), so repeated
+ * reads of the same table - e.g one iface config per device - copy the
+ * cached values instead of re-parsing every environment variable.
+ *
+ * @param opts_size      Size of the options structure, for the cached copy.
+ */
+ucs_status_t ucs_config_parser_fill_opts_cached(void *opts,
+                                                ucs_config_field_t *fields,
+                                                size_t opts_size,
+                                                const char *env_prefix,
+                                                const char *table_prefix,
+                                                int ignore_errors);
+
 /**
  * Perform deep copy of the options structure.
  *
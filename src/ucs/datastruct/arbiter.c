@@ -6,28 +6,213 @@
 
 #include "arbiter.h"
 
+#include <ucs/arch/bitops.h>
 #include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+#include <string.h>
+
+#define UCS_ARBITER_MIN_CAPACITY    64
+#define UCS_ARBITER_WORD(_index)    ((_index) >> 6)
+#define UCS_ARBITER_BIT(_index)     UCS_BIT((_index) & 63)
 
-#define SENTINEL ((ucs_arbiter_elem_t*)0x1)
 
 void ucs_arbiter_init(ucs_arbiter_t *arbiter)
 {
-    arbiter->current = NULL;
+    ucs_arbiter_prio_t prio;
+
+    for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+        arbiter->prios[prio].sched     = NULL;
+        arbiter->prios[prio].sched_top = NULL;
+        arbiter->prios[prio].cursor    = 0;
+        arbiter->prios[prio].count     = 0;
+    }
+    arbiter->inuse     = NULL;
+    arbiter->groups    = NULL;
+    arbiter->capacity  = 0;
+    arbiter->count     = 0;
+    arbiter->credit    = UCS_ARBITER_BULK_WEIGHT;
+}
+
+void ucs_arbiter_cleanup(ucs_arbiter_t *arbiter)
+{
+    ucs_arbiter_prio_t prio;
+
+    ucs_assert(arbiter->count == 0);
+    ucs_free(arbiter->groups);
+    ucs_free(arbiter->inuse);
+    for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+        ucs_free(arbiter->prios[prio].sched_top);
+        ucs_free(arbiter->prios[prio].sched);
+    }
 }
 
 void ucs_arbiter_group_init(ucs_arbiter_group_t *group)
 {
-    group->tail = NULL;
+    ucs_arbiter_group_init_prio(group, UCS_ARBITER_PRIO_HIGH);
 }
 
-void ucs_arbiter_cleanup(ucs_arbiter_t *arbiter)
+void ucs_arbiter_group_init_prio(ucs_arbiter_group_t *group,
+                                 ucs_arbiter_prio_t prio)
 {
-    ucs_assert(arbiter->current == NULL);
+    group->tail  = NULL;
+    group->index = UCS_ARBITER_INDEX_INVALID;
+    group->prio  = prio;
 }
 
 void ucs_arbiter_group_cleanup(ucs_arbiter_group_t *group)
 {
-    ucs_assert(group->tail == NULL);
+    ucs_assert(group->tail  == NULL);
+    ucs_assert(group->index == UCS_ARBITER_INDEX_INVALID);
+}
+
+static void ucs_arbiter_sched_set(ucs_arbiter_t *arbiter,
+                                  ucs_arbiter_prio_t prio, unsigned index)
+{
+    unsigned word = UCS_ARBITER_WORD(index);
+
+    arbiter->prios[prio].sched[word]                       |= UCS_ARBITER_BIT(index);
+    arbiter->prios[prio].sched_top[UCS_ARBITER_WORD(word)] |= UCS_ARBITER_BIT(word);
+    ++arbiter->prios[prio].count;
+    ++arbiter->count;
+}
+
+static void ucs_arbiter_sched_clear(ucs_arbiter_t *arbiter,
+                                    ucs_arbiter_prio_t prio, unsigned index)
+{
+    unsigned word = UCS_ARBITER_WORD(index);
+
+    arbiter->prios[prio].sched[word] &= ~UCS_ARBITER_BIT(index);
+    if (arbiter->prios[prio].sched[word] == 0) {
+        arbiter->prios[prio].sched_top[UCS_ARBITER_WORD(word)] &=
+            ~UCS_ARBITER_BIT(word);
+    }
+    --arbiter->prios[prio].count;
+    --arbiter->count;
+}
+
+static int ucs_arbiter_sched_is_set(ucs_arbiter_t *arbiter,
+                                    ucs_arbiter_prio_t prio, unsigned index)
+{
+    return !!(arbiter->prios[prio].sched[UCS_ARBITER_WORD(index)] &
+              UCS_ARBITER_BIT(index));
+}
+
+/*
+ * Double the group table and the bitmaps which cover it.
+ * @return First slot of the newly added range.
+ */
+static unsigned ucs_arbiter_grow(ucs_arbiter_t *arbiter)
+{
+    unsigned capacity      = ucs_max(arbiter->capacity * 2,
+                                     (unsigned)UCS_ARBITER_MIN_CAPACITY);
+    unsigned num_words     = capacity / 64;
+    unsigned num_top_words = ucs_div_round_up(num_words, 64);
+    unsigned old_num_words = arbiter->capacity / 64;
+    unsigned old_num_top   = (arbiter->capacity == 0) ? 0 :
+                             ucs_div_round_up(old_num_words, 64);
+    uint64_t *sched, *sched_top, *inuse;
+    ucs_arbiter_group_t **groups;
+    ucs_arbiter_prio_t prio;
+
+    groups    = ucs_realloc(arbiter->groups, capacity * sizeof(*groups),
+                            "arbiter_groups");
+    inuse     = ucs_realloc(arbiter->inuse, num_words * sizeof(*inuse),
+                            "arbiter_inuse");
+    if ((groups == NULL) || (inuse == NULL)) {
+        ucs_fatal("failed to grow arbiter group table to %u slots", capacity);
+    }
+
+    memset(inuse + old_num_words, 0,
+           (num_words - old_num_words) * sizeof(*inuse));
+    arbiter->groups = groups;
+    arbiter->inuse  = inuse;
+
+    for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+        sched     = ucs_realloc(arbiter->prios[prio].sched,
+                                num_words * sizeof(*sched), "arbiter_sched");
+        sched_top = ucs_realloc(arbiter->prios[prio].sched_top,
+                                num_top_words * sizeof(*sched_top),
+                                "arbiter_sched_top");
+        if ((sched == NULL) || (sched_top == NULL)) {
+            ucs_fatal("failed to grow arbiter group table to %u slots", capacity);
+        }
+
+        memset(sched     + old_num_words, 0,
+               (num_words - old_num_words) * sizeof(*sched));
+        memset(sched_top + old_num_top, 0,
+               (num_top_words - old_num_top) * sizeof(*sched_top));
+        arbiter->prios[prio].sched     = sched;
+        arbiter->prios[prio].sched_top = sched_top;
+    }
+
+    arbiter->capacity = capacity;
+    return old_num_words * 64;
+}
+
+static unsigned ucs_arbiter_alloc_index(ucs_arbiter_t *arbiter)
+{
+    unsigned num_words = arbiter->capacity / 64;
+    unsigned word, index;
+
+    for (word = 0; word < num_words; ++word) {
+        if (arbiter->inuse[word] != (uint64_t)-1) {
+            index = (word * 64) + ucs_ffs64(~arbiter->inuse[word]);
+            goto out;
+        }
+    }
+
+    index = ucs_arbiter_grow(arbiter);
+out:
+    arbiter->inuse[UCS_ARBITER_WORD(index)] |= UCS_ARBITER_BIT(index);
+    return index;
+}
+
+/*
+ * Find the first scheduled slot of a priority tier at 'start' or after it,
+ * wrapping around. Must be called with at least one group scheduled on the
+ * tier.
+ */
+static unsigned ucs_arbiter_sched_find(ucs_arbiter_t *arbiter,
+                                       ucs_arbiter_prio_t prio, unsigned start)
+{
+    uint64_t *sched        = arbiter->prios[prio].sched;
+    uint64_t *sched_top    = arbiter->prios[prio].sched_top;
+    unsigned num_words     = arbiter->capacity / 64;
+    unsigned num_top_words = ucs_div_round_up(num_words, 64);
+    unsigned word, top_word;
+    uint64_t mask;
+
+    ucs_assert(arbiter->prios[prio].count > 0);
+
+    if (start >= arbiter->capacity) {
+        start = 0;
+    }
+
+    /* Bits at 'start' and above in the word it falls into */
+    word = UCS_ARBITER_WORD(start);
+    mask = sched[word] & ~(UCS_ARBITER_BIT(start) - 1);
+    if (mask != 0) {
+        return (word * 64) + ucs_ffs64(mask);
+    }
+
+    /* Locate the next non-zero word through the top-level bitmap */
+    ++word;
+    if (word >= num_words) {
+        word = 0;
+    }
+    top_word = UCS_ARBITER_WORD(word);
+    mask     = sched_top[top_word] & ~(UCS_ARBITER_BIT(word) - 1);
+    while (mask == 0) {
+        ++top_word;
+        if (top_word >= num_top_words) {
+            top_word = 0;
+        }
+        mask = sched_top[top_word];
+    }
+
+    word = (top_word * 64) + ucs_ffs64(mask);
+    return (word * 64) + ucs_ffs64(sched[word]);
 }
 
 void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group, ucs_arbiter_elem_t *elem)
@@ -35,8 +220,7 @@ void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group, ucs_arbiter_
     ucs_arbiter_elem_t *tail = group->tail;
 
     if (tail == NULL) {
-        elem->list.next = NULL;   /* Not scheduled yet */
-        elem->next      = elem;   /* Connect to itself */
+        elem->next = elem;        /* Connect to itself */
     } else {
         elem->next = tail->next;  /* Point to first element */
         tail->next = elem;        /* Point previous element to new one */
@@ -46,22 +230,21 @@ void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group, ucs_arbiter_
     group->tail = elem;   /* Update group tail */
 }
 
-void ucs_arbiter_group_head_desched(ucs_arbiter_t *arbiter,
-                                    ucs_arbiter_elem_t *head)
+void ucs_arbiter_group_desched_nonempty(ucs_arbiter_t *arbiter,
+                                        ucs_arbiter_group_t *group)
 {
-    ucs_arbiter_elem_t *next;
+    unsigned index = group->index;
 
-    if (head->list.next == NULL) {
-        return; /* Not scheduled */
-    }
+    ucs_assert(index != UCS_ARBITER_INDEX_INVALID);
+    ucs_assert(arbiter->groups[index] == group);
 
-    /* If this group is the next to be scheduled, skip it */
-    if (arbiter->current == head) {
-        next = ucs_list_next(&head->list, ucs_arbiter_elem_t, list);
-        arbiter->current = (next == head) ? NULL : next;
+    /* The scheduled bit may already be clear if the group is pending a
+     * reschedule inside a dispatch cycle */
+    if (ucs_arbiter_sched_is_set(arbiter, ucs_arbiter_group_prio(group), index)) {
+        ucs_arbiter_sched_clear(arbiter, ucs_arbiter_group_prio(group), index);
     }
-
-    ucs_list_del(&head->list);
+    arbiter->inuse[UCS_ARBITER_WORD(index)] &= ~UCS_ARBITER_BIT(index);
+    group->index = UCS_ARBITER_INDEX_INVALID;
 }
 
 void ucs_arbiter_group_purge(ucs_arbiter_t *arbiter, ucs_arbiter_group_t *group,
@@ -76,7 +259,12 @@ void ucs_arbiter_group_purge(ucs_arbiter_t *arbiter, ucs_arbiter_group_t *group,
     }
 
     head = tail->next;
-    ucs_arbiter_group_head_desched(arbiter, head);
+    if (head == NULL) {
+        /* Only element is being dispatched at the moment */
+        head = tail;
+    }
+
+    ucs_arbiter_group_desched(arbiter, group);
 
     next = head;
     do {
@@ -92,57 +280,68 @@ void ucs_arbiter_group_schedule_nonempty(ucs_arbiter_t *arbiter,
                                          ucs_arbiter_group_t *group)
 {
     ucs_arbiter_elem_t *tail = group->tail;
-    ucs_arbiter_elem_t *current, *head;
+    unsigned index;
 
     ucs_assert(tail != NULL);
-    head = tail->next;
 
-    if (head == NULL) {
+    if (tail->next == NULL) {
         /* it means that 1 element group is
          * scheduled during dispatch.
          * Restore next pointer.
          */
-        head = tail->next = tail;
+        tail->next = tail;
     }
 
-    if (head->list.next != NULL) {
-        return; /* Already scheduled */
+    if (group->index != UCS_ARBITER_INDEX_INVALID) {
+        return; /* Already scheduled, or pending a reschedule */
     }
 
-    current = arbiter->current;
-    if (current == NULL) {
-        ucs_list_head_init(&head->list);
-        arbiter->current = head;
-    } else {
-        ucs_list_insert_before(&current->list, &head->list);
-    }
+    index                  = ucs_arbiter_alloc_index(arbiter);
+    arbiter->groups[index] = group;
+    group->index           = index;
+    ucs_arbiter_sched_set(arbiter, ucs_arbiter_group_prio(group), index);
 }
 
 void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
                                    ucs_arbiter_callback_t cb, void *cb_arg)
 {
-    ucs_arbiter_elem_t *group_head, *last_elem, *elem, *next_elem;
-    ucs_list_link_t *elem_list_next;
-    ucs_arbiter_elem_t *next_group, *prev_group;
+    ucs_arbiter_elem_t *last_elem, *elem, *next_elem;
     ucs_arbiter_group_t *group;
     ucs_arbiter_cb_result_t result;
     unsigned group_dispatch_count;
-    UCS_LIST_HEAD(resched_groups);
-
-    next_group = arbiter->current;
-    ucs_assert(next_group != NULL);
+    unsigned index, word, num_words;
+    ucs_arbiter_prio_t prio;
+    uint64_t mask;
+
+    ucs_assert(arbiter->count > 0);
+
+    while (arbiter->count > 0) {
+        /* Pick the tier to serve: control is strict, high and bulk are
+         * interleaved by the dispatch credit so bulk cannot be starved */
+        if (arbiter->prios[UCS_ARBITER_PRIO_CTRL].count > 0) {
+            prio = UCS_ARBITER_PRIO_CTRL;
+        } else if ((arbiter->prios[UCS_ARBITER_PRIO_HIGH].count > 0) &&
+                   ((arbiter->prios[UCS_ARBITER_PRIO_BULK].count == 0) ||
+                    (arbiter->credit > 0)))
+        {
+            prio = UCS_ARBITER_PRIO_HIGH;
+            if (arbiter->prios[UCS_ARBITER_PRIO_BULK].count > 0) {
+                --arbiter->credit;
+            }
+        } else {
+            prio            = UCS_ARBITER_PRIO_BULK;
+            arbiter->credit = UCS_ARBITER_BULK_WEIGHT;
+        }
 
-    do {
-        group_head    = next_group;
-        prev_group    = ucs_list_prev(&group_head->list, ucs_arbiter_elem_t, list);
-        next_group    = ucs_list_next(&group_head->list, ucs_arbiter_elem_t, list);
-        ucs_assert(prev_group->list.next == &group_head->list);
-        ucs_assert(next_group->list.prev == &group_head->list);
+        index = ucs_arbiter_sched_find(arbiter, prio,
+                                       arbiter->prios[prio].cursor);
+        group = arbiter->groups[index];
+        ucs_assert(group->index == index);
+        ucs_assert(ucs_arbiter_group_prio(group) == prio);
 
         group_dispatch_count = 0;
-        group         = group_head->group;
-        last_elem     = group->tail;
-        next_elem     = group_head;
+        last_elem            = group->tail;
+        next_elem            = last_elem->next; /* First element in the group */
 
         do {
             elem            = next_elem;
@@ -154,8 +353,6 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
              *   rc/ud transports control.
              */
             elem->next      = NULL;
-            elem_list_next  = elem->list.next;
-            elem->list.next = NULL;
 
             ucs_assert(elem->group == group);
             ucs_trace_poll("dispatching arbiter element %p", elem);
@@ -164,107 +361,103 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
             ++group_dispatch_count;
 
             if (result == UCS_ARBITER_CB_RESULT_REMOVE_ELEM) {
-                 if (elem == last_elem) {
+                if (elem == last_elem) {
                     /* Only element */
                     group->tail = NULL; /* Group is empty now */
-                    if (group_head == prev_group) {
-                        next_group = NULL; /* No more groups */
-                    } else {
-                        /* Remove the group */
-                        prev_group->list.next = &next_group->list;
-                        next_group->list.prev = &prev_group->list;
+                    if (group->index == index) {
+                        /* The callback could have descheduled the group */
+                        ucs_arbiter_group_desched_nonempty(arbiter, group);
                     }
                 } else {
                     /* Not only element */
                     ucs_assert(elem == last_elem->next); /* first element should be removed */
-                    if (group_head == prev_group) {
-                        next_group = next_elem; /* No more groups, point arbiter
-                                                   to next element in this group */
-                        ucs_list_head_init(&next_elem->list);
-                    } else {
-                        /* Insert the next element to the arbiter list */
-                        ucs_list_insert_replace(&prev_group->list,
-                                                &next_group->list,
-                                                &next_elem->list);
-                    }
                     last_elem->next = next_elem; /* Tail points to new head */
                 }
             } else if (result == UCS_ARBITER_CB_RESULT_NEXT_GROUP) {
                 elem->next = next_elem;
-                /* avoid infinite loop */
-                elem->list.next = elem_list_next;
                 break;
             } else if ((result == UCS_ARBITER_CB_RESULT_DESCHED_GROUP) ||
                        (result == UCS_ARBITER_CB_RESULT_RESCHED_GROUP)) {
                 elem->next = next_elem;
-                if (group_head == prev_group) {
-                    next_group = NULL; /* No more groups */
-                } else {
-                    prev_group->list.next = &next_group->list;
-                    next_group->list.prev = &prev_group->list;
-                }
-                if (result == UCS_ARBITER_CB_RESULT_RESCHED_GROUP) {
-                    ucs_list_add_tail(&resched_groups, &elem->list);
+                if (group->index == index) {
+                    if (result == UCS_ARBITER_CB_RESULT_RESCHED_GROUP) {
+                        /* Keep the slot allocated but clear the scheduled
+                         * bit - such slots are picked up again when the
+                         * dispatch loop ends */
+                        ucs_arbiter_sched_clear(arbiter, prio, index);
+                    } else {
+                        ucs_arbiter_group_desched_nonempty(arbiter, group);
+                    }
                 }
                 break;
             } else if (result == UCS_ARBITER_CB_RESULT_STOP) {
                 elem->next = next_elem;
-                elem->list.next = elem_list_next;
                 /* make sure that next dispatch() will continue
                  * from the current group */
-                arbiter->current = group_head;
+                arbiter->prios[prio].cursor = index;
                 goto out;
             } else {
                 elem->next = next_elem;
-                elem->list.next = elem_list_next;
                 ucs_bug("unexpected return value from arbiter callback");
             }
         } while ((elem != last_elem) && (group_dispatch_count < per_group));
-    } while (next_group != NULL);
-    arbiter->current = NULL;
+
+        /* Round-robin - continue past this group */
+        arbiter->prios[prio].cursor = index + 1;
+    }
+
 out:
-    ucs_list_for_each_safe(elem, next_elem, &resched_groups, list) {
-        ucs_list_del(&elem->list);
-        elem->list.next = NULL;
-        ucs_trace_poll("reschedule group %p", elem->group);
-        ucs_arbiter_group_schedule_nonempty(arbiter, elem->group);
+    /* Reschedule groups whose callback returned RESCHED_GROUP - their slots
+     * are allocated but not marked as scheduled on any tier */
+    num_words = arbiter->capacity / 64;
+    for (word = 0; word < num_words; ++word) {
+        mask = arbiter->inuse[word];
+        for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+            mask &= ~arbiter->prios[prio].sched[word];
+        }
+        while (mask != 0) {
+            index = (word * 64) + ucs_ffs64(mask);
+            mask &= mask - 1;
+            group = arbiter->groups[index];
+            ucs_trace_poll("reschedule group %p", group);
+            ucs_arbiter_sched_set(arbiter, ucs_arbiter_group_prio(group), index);
+        }
     }
 }
 
 void ucs_arbiter_dump(ucs_arbiter_t *arbiter, FILE *stream)
 {
-    ucs_arbiter_elem_t *first_group, *group_head, *elem;
+    ucs_arbiter_group_t *group;
+    ucs_arbiter_elem_t *elem;
+    ucs_arbiter_prio_t prio;
+    unsigned index;
 
     fprintf(stream, "-------\n");
-    if (arbiter->current == NULL) {
+    if (arbiter->count == 0) {
         fprintf(stream, "(empty)\n");
         goto out;
     }
 
-    first_group = arbiter->current;
-    group_head = first_group;
-    do {
-        elem = group_head;
-        if (group_head == first_group) {
-            fprintf(stream, "=> ");
-        } else {
-            fprintf(stream, " * ");
-        }
-        do {
-            fprintf(stream, "[%p", elem);
-            if (elem == group_head) {
-                fprintf(stream, " prev_g:%p", elem->list.prev);
-                fprintf(stream, " next_g:%p", elem->list.next);
+    for (prio = 0; prio < UCS_ARBITER_PRIO_LAST; ++prio) {
+        for (index = 0; index < arbiter->capacity; ++index) {
+            if (!ucs_arbiter_sched_is_set(arbiter, prio, index)) {
+                continue;
             }
-            fprintf(stream, " next_e:%p grp:%p]", elem->next, elem->group);
-            if (elem->next != group_head) {
-                fprintf(stream, "->");
-            }
-            elem = elem->next;
-        } while (elem != group_head);
-        fprintf(stream, "\n");
-        group_head = ucs_list_next(&group_head->list, ucs_arbiter_elem_t, list);
-    } while (group_head != first_group);
+
+            group = arbiter->groups[index];
+            fprintf(stream, " p%d #%-3u ", prio, index);
+            elem = group->tail->next;
+            do {
+                fprintf(stream, "[%p next_e:%p grp:%p]", elem, elem->next,
+                        elem->group);
+                if (elem != group->tail) {
+                    fprintf(stream, "->");
+                }
+                elem = elem->next;
+            } while (elem != group->tail->next);
+            fprintf(stream, "\n");
+        }
+    }
 
 out:
     fprintf(stream, "-------\n");
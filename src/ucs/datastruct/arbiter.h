@@ -8,8 +8,8 @@
 #define UCS_ARBITER_H_
 
 #include <ucs/sys/compiler.h>
-#include <ucs/datastruct/list.h>
 #include <ucs/type/status.h>
+#include <stdint.h>
 #include <stdio.h>
 
 /*
@@ -20,51 +20,47 @@
  * - "Element" - a single work element.
  * - "Group"   - queue of work elements which would be dispatched in-order
  *
- * The groups and elements are arranged like this:
+ * The elements of a group from a circular singly-linked list:
  *  - every arbitrated element points to the group (head).
- *  - first element in the group points to previous and next group (list)
- *  - first element in the group points to the first element of next group (next_group).
  *  - all except last element point to the next element in same group, and the
  *    last one points to the first (next).
  *
- * Note:
- *  Every elements holds 4 pointers. It could be done with 3 pointers, so that
- *  the pointer to the previous group is put instead of "next" pointer in the last
- *  element in the group, when it is put on the arbiter queue. However in makes
- *  the code much more complicated.
+ * Scheduled groups are tracked by a two-level bitmap: every scheduled group
+ * occupies a slot in the arbiter's group table, the first-level bitmap has one
+ * bit per slot, and the second-level bitmap has one bit per first-level word
+ * which is non-zero. Locating the next group to dispatch is a find-first-set
+ * on (at most) one word of each level, so dispatch touches O(1) cache lines
+ * per group instead of walking a linked list of group heads. Round-robin
+ * fairness is kept by a cursor - the slot number the next lookup starts from.
  *
+ * Groups are divided into priority tiers, each with its own pair of bitmaps
+ * and cursor over the shared slot table. The control tier is dispatched
+ * strictly before the others - it is meant for small protocol messages which
+ * are self-limiting in volume. Between the remaining tiers dispatch is
+ * weighted, so bulk groups keep making progress while latency-sensitive
+ * groups get most of the turns.
  *
  * Arbiter:
- *   +=========+
- *   | current +-----------------------+
- *   +=========+                       |
- *                                     |
- * Elements:                           |
- *                                     |
- *   +---------------------------------]----------------------------------+
- *   |                                 V                                  |
- *   |   +------------+          +------------+          +------------+<--+
- *   +-->| list       |<-------->| list       |<-------->| list       |
- *       +------------+          +------------+          +------------+<--+
- *    +->| next       +---+   +->| next       +---+      + next       +---+
- *    |  +------------+   |   |  +------------+   |      +------------+
- *    |  | group      |   |   |  | group      |   |      | group      |
- *    |  +------------+   |   |  +------------+   |      +--------+---+
- *    |                   |   |                   |          ^    |
- *    |                   |   |                   |          |    |
- *    |  +------------+   |   |  +------------+   |          |    |
- *    |  | list       |<--+   |  | list       |<--+          |    |
- *    |  +------------+       |  +------------+              |    |
- *    +--+ next       +       +--+ next       |              |    |
- *       +------------+          +------------+              |    |
- *       | group      |          | group      |              |    |
- *       +---------+--+          +--------+---+              |    |
- *            ^    |                 ^    |                  |    |
- * Groups:    |    |                 |    |                  |    |
- *            |    |                 |    |                  |    |
- *     +------+    |          +------+    |           +------+    |
- *     | tail |<---+          | tail |<---+           | tail |<---+
- *     +------+               +------+                +------+
+ *   +========+    +-----------------+
+ *   | sched  +--->|0 1 0 ... 1 0 0 1|       first-level bitmap
+ *   +========+    +-----------------+
+ *   | groups +--+    |       |
+ *   | cursor |  |    |       |
+ *   +========+  |    v       v
+ *               +->[slot1] [slotN]          group table
+ *                     |       |
+ *                     v       v
+ * Groups:          +------+ +------+
+ *                  | tail | | tail |
+ *                  +--+---+ +------+
+ *                     |
+ * Elements:           v
+ *                  +------+    +------+    +------+
+ *               +->| next +--->| next +--->| next +--+
+ *               |  +------+    +------+    +------+  |
+ *               |  | group|    | group|    | group|  |
+ *               |  +------+    +------+    +------+  |
+ *               +------------------------------------+
  *
  */
 
@@ -73,6 +69,30 @@ typedef struct ucs_arbiter_group  ucs_arbiter_group_t;
 typedef struct ucs_arbiter_elem   ucs_arbiter_elem_t;
 
 
+/**
+ * Slot number of a group which is not scheduled.
+ */
+#define UCS_ARBITER_INDEX_INVALID    ((unsigned)-1)
+
+
+/**
+ * Group priority tiers, in dispatch order.
+ */
+typedef enum {
+    UCS_ARBITER_PRIO_CTRL,   /* Protocol control - dispatched strictly first */
+    UCS_ARBITER_PRIO_HIGH,   /* Latency-sensitive data (the default) */
+    UCS_ARBITER_PRIO_BULK,   /* Bandwidth-bound bulk data */
+    UCS_ARBITER_PRIO_LAST
+} ucs_arbiter_prio_t;
+
+
+/**
+ * How many high-tier groups are dispatched per bulk-tier group when both
+ * tiers have work.
+ */
+#define UCS_ARBITER_BULK_WEIGHT      4
+
+
 /**
  * Arbitration callback result codes.
  */
@@ -83,7 +103,7 @@ typedef enum {
                                            group. Group IS NOT descheduled */
     UCS_ARBITER_CB_RESULT_DESCHED_GROUP,/* Keep current element but remove the
                                            current group and move to next group. */
-    UCS_ARBITER_CB_RESULT_RESCHED_GROUP,/* Keep current element, do not process 
+    UCS_ARBITER_CB_RESULT_RESCHED_GROUP,/* Keep current element, do not process
                                            the group anymore during current
                                            dispatch cycle. After dispatch()
                                            is finished group automatically
@@ -111,7 +131,20 @@ typedef ucs_arbiter_cb_result_t (*ucs_arbiter_callback_t)(ucs_arbiter_t *arbiter
  * Top-level arbiter.
  */
 struct ucs_arbiter {
-    ucs_arbiter_elem_t      *current;
+    struct {
+        uint64_t            *sched;      /* First level - bit per group slot */
+        uint64_t            *sched_top;  /* Second level - bit per non-zero
+                                            word of 'sched' */
+        unsigned            cursor;      /* Slot to start the next dispatch
+                                            lookup from - round-robin fairness */
+        unsigned            count;       /* Number of scheduled groups */
+    }                       prios[UCS_ARBITER_PRIO_LAST];
+    uint64_t                *inuse;      /* Bitmap of allocated group slots */
+    ucs_arbiter_group_t     **groups;    /* Slot number -> scheduled group */
+    unsigned                capacity;    /* Group table size, multiple of 64 */
+    unsigned                count;       /* Total number of scheduled groups */
+    unsigned                credit;      /* High-tier groups to serve before
+                                            the next bulk-tier group */
 };
 
 
@@ -120,15 +153,16 @@ struct ucs_arbiter {
  */
 struct ucs_arbiter_group {
     ucs_arbiter_elem_t      *tail;
+    unsigned                index;      /* Slot in the arbiter group table, or
+                                           UCS_ARBITER_INDEX_INVALID */
+    uint8_t                 prio;       /* Priority tier of this group */
 };
 
 
 /**
  * Arbitrated work element.
- * In order to keep it small, one of the fields is a union.
  */
 struct ucs_arbiter_elem {
-    ucs_list_link_t         list;       /* List link in the scheduler queue */
     ucs_arbiter_elem_t      *next;      /* Next element, last points to head */
     ucs_arbiter_group_t     *group;     /* Always points to the group */
 };
@@ -144,13 +178,23 @@ void ucs_arbiter_cleanup(ucs_arbiter_t *arbiter);
 
 
 /**
- * Initialize a group object.
+ * Initialize a group object on the default (high) priority tier.
  *
  * @param [in]  group    Group to initialize.
  */
 void ucs_arbiter_group_init(ucs_arbiter_group_t *group);
 void ucs_arbiter_group_cleanup(ucs_arbiter_group_t *group);
 
+
+/**
+ * Initialize a group object on a given priority tier.
+ *
+ * @param [in]  group    Group to initialize.
+ * @param [in]  prio     Priority tier to dispatch the group on.
+ */
+void ucs_arbiter_group_init_prio(ucs_arbiter_group_t *group,
+                                 ucs_arbiter_prio_t prio);
+
 /**
  * Initialize an element object.
  *
@@ -164,7 +208,7 @@ static inline void ucs_arbiter_elem_init(ucs_arbiter_elem_t *elem)
 /**
  * Add a new work element to a group - internal function
  */
-void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group, 
+void ucs_arbiter_group_push_elem_always(ucs_arbiter_group_t *group,
                                         ucs_arbiter_elem_t *elem);
 
 /**
@@ -191,8 +235,8 @@ void ucs_arbiter_dispatch_nonempty(ucs_arbiter_t *arbiter, unsigned per_group,
                                    ucs_arbiter_callback_t cb, void *cb_arg);
 
 /* Internal function */
-void ucs_arbiter_group_head_desched(ucs_arbiter_t *arbiter,
-                                    ucs_arbiter_elem_t *head);
+void ucs_arbiter_group_desched_nonempty(ucs_arbiter_t *arbiter,
+                                        ucs_arbiter_group_t *group);
 
 
 /**
@@ -202,7 +246,7 @@ void ucs_arbiter_group_head_desched(ucs_arbiter_t *arbiter,
  */
 static inline int ucs_arbiter_is_empty(ucs_arbiter_t *arbiter)
 {
-    return arbiter->current == NULL;
+    return arbiter->count == 0;
 }
 
 
@@ -241,12 +285,8 @@ static inline void ucs_arbiter_group_schedule(ucs_arbiter_t *arbiter,
 static inline void ucs_arbiter_group_desched(ucs_arbiter_t *arbiter,
                                              ucs_arbiter_group_t *group)
 {
-    if (ucs_unlikely(!ucs_arbiter_group_is_empty(group))) {
-        ucs_arbiter_elem_t *head;
-
-        head = group->tail->next;
-        ucs_arbiter_group_head_desched(arbiter, head);
-        head->list.next = NULL;
+    if (ucs_unlikely(group->index != UCS_ARBITER_INDEX_INVALID)) {
+        ucs_arbiter_group_desched_nonempty(arbiter, group);
     }
 }
 
@@ -284,6 +324,8 @@ ucs_arbiter_group_push_elem(ucs_arbiter_group_t *group,
  * arbiter becomes empty or the callback returns STOP. If a group is either out
  * of elements, or its callback returns REMOVE_GROUP, it will be removed until
  * ucs_arbiter_group_schedule() is used to put it back on the arbiter.
+ * Control-tier groups are served strictly before the other tiers; high-tier
+ * and bulk-tier groups are interleaved with UCS_ARBITER_BULK_WEIGHT:1 weight.
  *
  * @param [in]  arbiter    Arbiter object to dispatch work on.
  * @param [in]  per_group  How many elements to dispatch from each group.
@@ -308,10 +350,18 @@ static inline ucs_arbiter_group_t* ucs_arbiter_elem_group(ucs_arbiter_elem_t *el
     return elem->group;
 }
 
+/**
+ * @return Priority tier of the group.
+ */
+static inline ucs_arbiter_prio_t ucs_arbiter_group_prio(ucs_arbiter_group_t *group)
+{
+    return (ucs_arbiter_prio_t)group->prio;
+}
+
 /**
  * @return true if element is the last one in the group
  */
-static inline int 
+static inline int
 ucs_arbiter_elem_is_last(ucs_arbiter_group_t *group, ucs_arbiter_elem_t *elem)
 {
     return group->tail == elem;
@@ -0,0 +1,87 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "arena.h"
+
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/math.h>
+
+
+/* Alignment of returned buffers, and of the data area within a chunk */
+#define UCS_ARENA_ALIGN       16
+
+/* Offset of the data area from the chunk header */
+#define UCS_ARENA_DATA_OFFSET ucs_align_up(sizeof(ucs_arena_chunk_t), UCS_ARENA_ALIGN)
+
+
+struct ucs_arena_chunk {
+    ucs_arena_chunk_t      *next;   /* Next (older) chunk */
+    size_t                 size;    /* Size of the data area */
+    size_t                 used;    /* Bytes already handed out */
+};
+
+
+void ucs_arena_init(ucs_arena_t *arena, size_t chunk_size)
+{
+    arena->chunks     = NULL;
+    arena->chunk_size = chunk_size;
+}
+
+void ucs_arena_cleanup(ucs_arena_t *arena)
+{
+    ucs_arena_chunk_t *chunk, *next;
+
+    for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        ucs_free(chunk);
+    }
+    arena->chunks = NULL;
+}
+
+void *ucs_arena_alloc(ucs_arena_t *arena, size_t size)
+{
+    ucs_arena_chunk_t *chunk = arena->chunks;
+    size_t chunk_size;
+    void *ptr;
+
+    size = ucs_align_up(size, UCS_ARENA_ALIGN);
+    if ((chunk == NULL) || (size > chunk->size - chunk->used)) {
+        chunk_size = ucs_max(arena->chunk_size, size);
+        chunk = ucs_malloc(UCS_ARENA_DATA_OFFSET + chunk_size, "arena_chunk");
+        if (chunk == NULL) {
+            return NULL;
+        }
+
+        chunk->size   = chunk_size;
+        chunk->used   = 0;
+        chunk->next   = arena->chunks;
+        arena->chunks = chunk;
+    }
+
+    ptr          = (void*)chunk + UCS_ARENA_DATA_OFFSET + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+void ucs_arena_reset(ucs_arena_t *arena)
+{
+    ucs_arena_chunk_t *chunk, *next;
+
+    chunk = arena->chunks;
+    if (chunk == NULL) {
+        return;
+    }
+
+    /* Keep the head chunk for reuse and release the older ones, which exist
+     * only because the head was not large enough when they were needed */
+    chunk->used = 0;
+    next        = chunk->next;
+    chunk->next = NULL;
+    for (chunk = next; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        ucs_free(chunk);
+    }
+}
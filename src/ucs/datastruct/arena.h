@@ -0,0 +1,71 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#ifndef UCS_ARENA_H_
+#define UCS_ARENA_H_
+
+#include <stddef.h>
+
+
+typedef struct ucs_arena_chunk   ucs_arena_chunk_t;
+typedef struct ucs_arena         ucs_arena_t;
+
+
+/**
+ * Bump allocator for short-lived allocations, such as control-path scratch
+ * buffers. Allocations are taken from large chunks by advancing a pointer,
+ * and are never released individually - instead, the whole arena is reset
+ * when the operation which used it completes. Not thread safe; the caller is
+ * expected to serialize access, as with the rest of the owning object.
+ */
+struct ucs_arena {
+    ucs_arena_chunk_t      *chunks;      /* Chunk list, the head is the one
+                                            allocations are taken from */
+    size_t                 chunk_size;   /* Allocation size for new chunks */
+};
+
+
+/**
+ * Initialize an arena. No memory is allocated until the first allocation
+ * request.
+ *
+ * @param [in]  arena       Arena to initialize.
+ * @param [in]  chunk_size  Size of the chunks to allocate from the heap. A
+ *                          single allocation larger than this gets a chunk
+ *                          of its own.
+ */
+void ucs_arena_init(ucs_arena_t *arena, size_t chunk_size);
+
+
+/**
+ * Release all memory held by the arena.
+ *
+ * @param [in]  arena       Arena to clean up.
+ */
+void ucs_arena_cleanup(ucs_arena_t *arena);
+
+
+/**
+ * Allocate a buffer from the arena. The buffer is valid until the arena is
+ * reset or cleaned up, and must not be freed individually.
+ *
+ * @param [in]  arena       Arena to allocate from.
+ * @param [in]  size        Size of the buffer to allocate.
+ *
+ * @return Pointer to the allocated buffer, or NULL if out of memory.
+ */
+void *ucs_arena_alloc(ucs_arena_t *arena, size_t size);
+
+
+/**
+ * Release all outstanding allocations at once. The most recent chunk is kept
+ * for reuse, so a steady-state caller stops hitting the heap altogether.
+ *
+ * @param [in]  arena       Arena to reset.
+ */
+void ucs_arena_reset(ucs_arena_t *arena);
+
+#endif
@@ -131,12 +131,18 @@ ucs_status_t ucs_callbackq_init(ucs_callbackq_t *cbq, size_t size,
     cbq->ptr->cb       = ucs_callbackq_service_cb;
     cbq->ptr->arg      = cbq;
     cbq->ptr->refcount = 1;
+#if ENABLE_STATS
+    cbq->ptr->dispatch_time  = 0;
+    cbq->ptr->dispatch_count = 0;
+    cbq->sample_countdown    = 0;
+#endif
     cbq->size          = size;
     cbq->start         = cbq->ptr + 1;
     cbq->end           = cbq->start;
     ucs_callbackq_priv(cbq)->async = async;
     ucs_spinlock_init(&ucs_callbackq_priv(cbq)->lock);
     ucs_list_head_init(&cbq->slow_path);
+    ucs_list_head_init(&cbq->slow_path_new);
     return UCS_OK;
 }
 
@@ -184,6 +190,10 @@ void ucs_callbackq_add(ucs_callbackq_t *cbq, ucs_callback_t cb, void *arg)
     elem->cb       = cb;
     elem->arg      = arg;
     elem->refcount = 1;
+#if ENABLE_STATS
+    elem->dispatch_time  = 0;
+    elem->dispatch_count = 0;
+#endif
 
     /* Make sure a thread dispatching the callbacks would see 'end' only after
      * the new element is set.
@@ -262,17 +272,23 @@ static void ucs_callbackq_slow_path_cb(void *arg)
     ucs_callbackq_t *cbq = arg;
     ucs_callbackq_slow_elem_t *elem, *tmp_elem;
 
-    ucs_callbackq_enter(cbq);
+    /* Fold elements staged by other threads into the live list. The unlocked
+     * emptiness check may miss an element which is being added concurrently,
+     * but the add also references this callback again, so the element is
+     * picked up on one of the next dispatch calls */
+    if (ucs_unlikely(!ucs_list_is_empty(&cbq->slow_path_new))) {
+        ucs_callbackq_enter(cbq);
+        ucs_list_splice_tail(&cbq->slow_path, &cbq->slow_path_new);
+        ucs_list_head_init(&cbq->slow_path_new);
+        ucs_callbackq_leave(cbq);
+    }
 
-    /* TODO avoid locks on every iteration. For instance implement
-     * lazy remove with additional list of elements to be removed. */
+    /* The live list is modified only from the dispatch context (removal is
+     * allowed only there), so it can be iterated without the lock - the
+     * progress hot path takes no lock at all */
     ucs_list_for_each_safe(elem, tmp_elem, &cbq->slow_path, list) {
-        ucs_callbackq_leave(cbq);
         elem->cb(elem);
-        ucs_callbackq_enter(cbq);
     }
-
-    ucs_callbackq_leave(cbq);
 }
 
 void ucs_callbackq_add_slow_path(ucs_callbackq_t *cbq,
@@ -283,7 +299,9 @@ void ucs_callbackq_add_slow_path(ucs_callbackq_t *cbq,
     ucs_callbackq_enter(cbq);
 
     /* Note: multiple calls with the same element are not allowed */
-    ucs_list_add_tail(&cbq->slow_path, &elem->list);
+    /* Stage the element on the side list; the dispatching thread folds it
+     * into the live list, which it iterates lock-free */
+    ucs_list_add_tail(&cbq->slow_path_new, &elem->list);
     status = ucs_callbackq_add_safe(cbq, ucs_callbackq_slow_path_cb, cbq);
     ucs_assert_always(status == UCS_OK);
 
@@ -325,5 +343,30 @@ void ucs_callbackq_purge_slow_path(ucs_callbackq_t *cbq, ucs_callback_slow_t cb,
         }
     }
 
+    /* Elements may still be staged on the side list */
+    ucs_list_for_each_safe(elem, tmp_elem, &cbq->slow_path_new, list) {
+        if (elem->cb == cb) {
+            ucs_callbackq_slow_path_remove_elem(cbq, elem);
+            if (list != NULL) {
+                ucs_list_add_tail(list, &elem->list);
+            }
+        }
+    }
+
+    ucs_callbackq_leave(cbq);
+}
+
+#if ENABLE_STATS
+void ucs_callbackq_stats_foreach(ucs_callbackq_t *cbq,
+                                 ucs_callbackq_stats_cb_t cb, void *fn_arg)
+{
+    ucs_callbackq_elem_t *elem;
+
+    ucs_callbackq_enter(cbq);
+    ucs_callbackq_for_each(elem, cbq) {
+        cb(elem->cb, elem->arg, elem->dispatch_time, elem->dispatch_count,
+           fn_arg);
+    }
     ucs_callbackq_leave(cbq);
 }
+#endif
@@ -8,10 +8,19 @@
 #ifndef UCS_CALLBACKQ_H
 #define UCS_CALLBACKQ_H
 
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
 #include <ucs/async/async_fwd.h>
 #include <ucs/datastruct/list_types.h>
 #include <stdint.h>
 
+
+/* With statistics enabled, one of this many dispatch rounds is timed with the
+ * hres clock, so the accounting overhead on the progress path stays bounded */
+#define UCS_CALLBACKQ_SAMPLE_PERIOD  64
+
 /*
  *
  * Thread-safe callback queue:
@@ -40,6 +49,13 @@ struct ucs_callbackq_elem {
     ucs_callback_t                   cb;       /**< Callback function */
     void                             *arg;     /**< Function argument */
     volatile uint32_t                refcount; /**< Reference count */
+#if ENABLE_STATS
+    uint64_t                         dispatch_time;  /**< Accumulated time of
+                                                          sampled dispatches,
+                                                          in hres clock units */
+    uint64_t                         dispatch_count; /**< Number of sampled
+                                                          dispatches */
+#endif
 };
 
 
@@ -52,8 +68,19 @@ struct ucs_callbackq {
                                                      (end of last element) */
     ucs_callbackq_elem_t             *ptr;      /**< Array of elements */
     size_t                           size;      /**< Array size */
-    ucs_list_link_t                  slow_path; /**< List of slow path callbacks */
-    char                             priv[24];  /**< Private data, which we don't want
+    ucs_list_link_t                  slow_path; /**< List of slow path callbacks,
+                                                     owned by the dispatching
+                                                     thread */
+    ucs_list_link_t                  slow_path_new; /**< Slow path elements added
+                                                         by other threads, folded
+                                                         into slow_path by the
+                                                         dispatching thread */
+#if ENABLE_STATS
+    unsigned                         sample_countdown; /**< Dispatch rounds left
+                                                            until the next timed
+                                                            sample */
+#endif
+    char                             priv[32];  /**< Private data, which we don't want
                                                      to expose in API to avoid
                                                      pulling more header files */
 };
@@ -249,4 +276,27 @@ void ucs_callbackq_remove_slow_path(ucs_callbackq_t *cbq,
 void ucs_callbackq_purge_slow_path(ucs_callbackq_t *cbq, ucs_callback_slow_t cb,
                                    ucs_list_link_t *list);
 
+
+#if ENABLE_STATS
+
+typedef void (*ucs_callbackq_stats_cb_t)(ucs_callback_t cb, void *arg,
+                                         uint64_t time, uint64_t count,
+                                         void *fn_arg);
+
+/**
+ * Iterate over the callbacks in the queue and report, for each one, the time
+ * accumulated by sampled dispatches (in hres clock units) and the number of
+ * samples taken. One dispatch round out of every
+ * @ref UCS_CALLBACKQ_SAMPLE_PERIOD is sampled, so the reported times are a
+ * statistical share of the real dispatch cost, not a total.
+ *
+ * @param  [in] cbq      Callback queue to report.
+ * @param  [in] cb       Function called for every callback in the queue.
+ * @param  [in] fn_arg   Last argument for cb.
+ */
+void ucs_callbackq_stats_foreach(ucs_callbackq_t *cbq,
+                                 ucs_callbackq_stats_cb_t cb, void *fn_arg);
+
+#endif
+
 #endif
@@ -10,6 +10,7 @@
 
 #include <ucs/arch/cpu.h> /* for memory load fence */
 #include <ucs/datastruct/callbackq.h>
+#include <ucs/sys/compiler.h>
 
 
 /**
@@ -34,6 +35,22 @@
 static inline void ucs_callbackq_dispatch(ucs_callbackq_t *cbq)
 {
     ucs_callbackq_elem_t *elem;
+#if ENABLE_STATS
+    uint64_t start;
+
+    if (ucs_unlikely(cbq->sample_countdown == 0)) {
+        /* Timed round - charge each callback with its raw tick delta */
+        cbq->sample_countdown = UCS_CALLBACKQ_SAMPLE_PERIOD - 1;
+        ucs_callbackq_for_each(elem, cbq) {
+            start = ucs_arch_read_hres_clock();
+            elem->cb(elem->arg);
+            elem->dispatch_time  += ucs_arch_read_hres_clock() - start;
+            ++elem->dispatch_count;
+        }
+        return;
+    }
+    --cbq->sample_countdown;
+#endif
 
     ucs_callbackq_for_each(elem, cbq) {
         elem->cb(elem->arg);
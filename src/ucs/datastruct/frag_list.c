@@ -7,6 +7,8 @@
 
 #include "frag_list.h"
 
+#include <ucs/debug/memtrack.h>
+
 #if ENABLE_STATS
 
 static ucs_stats_class_t ucs_frag_list_stats_class = {
@@ -23,7 +25,7 @@ static ucs_stats_class_t ucs_frag_list_stats_class = {
 #endif
 
 ucs_status_t ucs_frag_list_init(ucs_frag_list_sn_t initial_sn, ucs_frag_list_t *frag_list,
-                        int max_holes
+                        int max_holes, unsigned window_size
                         UCS_STATS_ARG(ucs_stats_node_t *stats_parent)
                         )
 {
@@ -37,11 +39,31 @@ ucs_status_t ucs_frag_list_init(ucs_frag_list_sn_t initial_sn, ucs_frag_list_t *
     ucs_queue_head_init(&frag_list->list);
     ucs_queue_head_init(&frag_list->ready_list);
 
+    frag_list->window_count = 0;
+    if (window_size > 0) {
+        frag_list->window_size = ucs_roundup_pow2(window_size);
+        frag_list->window      = ucs_calloc(frag_list->window_size,
+                                            sizeof(*frag_list->window),
+                                            "frag_list_window");
+        if (frag_list->window == NULL) {
+            frag_list->window_size = 0;
+            return UCS_ERR_NO_MEMORY;
+        }
+    } else {
+        frag_list->window_size = 0;
+        frag_list->window      = NULL;
+    }
+
 #if ENABLE_STATS
     frag_list->prev_sn = initial_sn;
 #endif
     status = UCS_STATS_NODE_ALLOC(&frag_list->stats, &ucs_frag_list_stats_class,
                                  stats_parent);
+    if (status != UCS_OK) {
+        ucs_free(frag_list->window);
+        frag_list->window      = NULL;
+        frag_list->window_size = 0;
+    }
     return status;
 }
 
@@ -49,8 +71,10 @@ void ucs_frag_list_cleanup(ucs_frag_list_t *frag_list)
 {
     ucs_assert(frag_list->elem_count == 0);
     ucs_assert(frag_list->list_count == 0);
+    ucs_assert(frag_list->window_count == 0);
     ucs_assert(ucs_queue_is_empty(&frag_list->list));
     ucs_assert(ucs_queue_is_empty(&frag_list->ready_list));
+    ucs_free(frag_list->window);
     UCS_STATS_NODE_FREE(frag_list->stats);
 }
 
@@ -224,6 +248,13 @@ ucs_frag_list_insert_head(ucs_frag_list_t *head, ucs_frag_list_elem_t *elem,
       * on INSERT_FIRST
       */
 
+     /* check that we are not hitting a stashed window element */
+     if ((head->window_count > 0) &&
+         (*ucs_frag_list_window_slot(head, sn) != NULL)) {
+         /* only sn itself can map to this slot within the window range */
+         return UCS_FRAG_LIST_INSERT_DUP;
+     }
+
      /* check that we are not hitting element on the first frag list */
      if (!ucs_queue_is_empty(&head->list)) {
          h = ucs_queue_head_elem_non_empty(&head->list, ucs_frag_list_elem_t, list);
@@ -241,6 +272,12 @@ ucs_frag_list_insert_head(ucs_frag_list_t *head, ucs_frag_list_elem_t *elem,
          return UCS_FRAG_LIST_INSERT_READY;
      }
 
+     if ((head->window_count > 0) &&
+         (*ucs_frag_list_window_slot(head, UCS_FRAG_LIST_NEXT_SN(sn)) != NULL)) {
+         /* the next element is stashed in the window - let the caller pull it */
+         return UCS_FRAG_LIST_INSERT_FIRST;
+     }
+
      if (h != NULL && UCS_FRAG_LIST_SN_CMP(h->head.first_sn, ==, sn + 1)) {
          /* do not enqueue. let know that more elems may
           * be pulled from the list.
@@ -256,7 +293,7 @@ ucs_frag_list_ooo_type_t
 ucs_frag_list_insert_slow(ucs_frag_list_t *head, ucs_frag_list_elem_t *elem,
                           ucs_frag_list_sn_t sn)
 {
-    ucs_frag_list_elem_t *h, *prevh, *nexth;
+    ucs_frag_list_elem_t *h, *prevh, *nexth, **slot;
 
     if (UCS_FRAG_LIST_SN_CMP(sn, ==, head->head_sn + 1)) {
         return ucs_frag_list_insert_head(head, elem, sn);
@@ -266,6 +303,29 @@ ucs_frag_list_insert_slow(ucs_frag_list_t *head, ucs_frag_list_elem_t *elem,
         return UCS_FRAG_LIST_INSERT_DUP;
     }
 
+    /* out-of-order element within the sliding window - stash it in its slot.
+     * all window sns are kept below the sns on the hole list, so the window
+     * is used only when the list cannot hold a smaller sn */
+    if ((head->window != NULL) &&
+        UCS_FRAG_LIST_SN_CMP(sn, <=,
+                             (ucs_frag_list_sn_t)(head->head_sn + head->window_size)) &&
+        (ucs_queue_is_empty(&head->list) ||
+         UCS_FRAG_LIST_SN_CMP(sn, <,
+                              ucs_queue_head_elem_non_empty(&head->list,
+                                                            ucs_frag_list_elem_t,
+                                                            list)->head.first_sn))) {
+        slot = ucs_frag_list_window_slot(head, sn);
+        if (*slot != NULL) {
+            /* only sn itself can map to this slot within the window range */
+            return UCS_FRAG_LIST_INSERT_DUP;
+        }
+        *slot = elem;
+        head->window_count++;
+        head->elem_count++;
+        UCS_STATS_UPDATE_COUNTER(head->stats, UCS_FRAG_LIST_STAT_GAPS, 1);
+        return UCS_FRAG_LIST_INSERT_SLOW;
+    }
+
     if (head->max_holes == 0) {
         return UCS_FRAG_LIST_INSERT_FAIL;
     }
@@ -363,17 +423,79 @@ ucs_frag_list_elem_t *ucs_frag_list_pull_slow(ucs_frag_list_t *head)
     return h;
 }
 
+ucs_frag_list_elem_t *ucs_frag_list_extract(ucs_frag_list_t *head)
+{
+    ucs_frag_list_elem_t *h;
+    unsigned i;
+
+    if (!ucs_queue_is_empty(&head->ready_list)) {
+        --head->elem_count;
+        return ucs_queue_pull_elem_non_empty(&head->ready_list,
+                                             ucs_frag_list_elem_t, list);
+    }
+
+    for (i = 0; (head->window_count > 0) && (i < head->window_size); ++i) {
+        if (head->window[i] != NULL) {
+            h = head->window[i];
+            head->window[i] = NULL;
+            --head->window_count;
+            --head->elem_count;
+            return h;
+        }
+    }
+
+    if (ucs_queue_is_empty(&head->list)) {
+        return NULL;
+    }
+
+    /* drain the chain hanging off the first hole list head before the head
+     * itself, so no element is ever orphaned */
+    h = ucs_queue_head_elem_non_empty(&head->list, ucs_frag_list_elem_t, list);
+    if (!ucs_queue_is_empty(&h->head.list)) {
+        --head->elem_count;
+        return ucs_queue_pull_elem_non_empty(&h->head.list,
+                                             ucs_frag_list_elem_t, list);
+    }
+
+    --head->elem_count;
+    --head->list_count;
+    return ucs_queue_pull_elem_non_empty(&head->list, ucs_frag_list_elem_t, list);
+}
+
+unsigned ucs_frag_list_pull_bulk(ucs_frag_list_t *head, ucs_queue_head_t *run)
+{
+    ucs_frag_list_elem_t *elem;
+    unsigned count;
+
+    count = 0;
+    while ((elem = ucs_frag_list_pull(head)) != NULL) {
+        ucs_queue_push(run, &elem->list);
+        ++count;
+    }
+    return count;
+}
+
 void ucs_frag_list_dump(ucs_frag_list_t *head, int how)
 {
     ucs_frag_list_elem_t *h, *e;
     int list_count, elem_count;
+    unsigned i, window_count;
     int cnt;
 
     list_count = 0;
     elem_count = 0;
 
+    window_count = 0;
+    for (i = 0; i < head->window_size; ++i) {
+        if (head->window[i] != NULL) {
+            window_count++;
+            elem_count++;
+        }
+    }
+    ucs_assert(head->window_count == window_count);
+
     ucs_queue_for_each(e, &head->ready_list, list) {
-       elem_count++; 
+       elem_count++;
     }
 
     ucs_queue_for_each(h, &head->list, list) {
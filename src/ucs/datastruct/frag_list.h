@@ -90,6 +90,12 @@ typedef struct ucs_frag_list {
     unsigned               elem_count;   /* total number of list elements */
     unsigned               list_count;   /* number of independent lists */
     int                    max_holes;    /* do not allow insertion if ucs_list_count >= max_holes */
+    ucs_frag_list_elem_t   **window;     /* Sliding window slot array, or NULL.
+                                            Slot sn & (window_size - 1) holds the
+                                            element with sequence number sn; a
+                                            NULL slot marks a hole */
+    unsigned               window_size;  /* Number of window slots, power of two */
+    unsigned               window_count; /* Number of occupied window slots */
     UCS_STATS_NODE_DECLARE(stats);
 #ifdef ENABLE_STATS
     ucs_frag_list_sn_t prev_sn;      /*  needed to detect busrts */
@@ -118,10 +124,15 @@ enum {
  *                    0 - allow no holes, only check sn. Out of order insert
  *                    will result either in DUP or FAIL
  *                    -1 - infinite number of holes
- *
+ * @param window_size Size of the sliding reorder window, rounded up to a power
+ *                    of two. Elements within window_size of the head sequence
+ *                    number are stored in a slot array with O(1) insert and
+ *                    pull; only elements beyond the window (or behind a
+ *                    non-empty hole list) fall back to the sorted list, which
+ *                    is still subject to max_holes. 0 disables the window.
  */
 ucs_status_t ucs_frag_list_init(ucs_frag_list_sn_t initial_sn, ucs_frag_list_t *frag_list,
-                               int max_holes
+                               int max_holes, unsigned window_size
                                UCS_STATS_ARG(ucs_stats_node_t *stats_parent));
 
 /**
@@ -143,6 +154,26 @@ ucs_frag_list_ooo_type_t ucs_frag_list_insert_slow(ucs_frag_list_t *head,
 ucs_frag_list_elem_t *ucs_frag_list_pull_slow(ucs_frag_list_t *head);
 
 
+/**
+ * Pull the whole in-order run in one call, appending the elements to a queue
+ * in sequence number order.
+ *
+ * @param head  frag_list to pull from.
+ * @param run   Queue to append the pulled elements to.
+ * @return      Number of elements appended.
+ */
+unsigned ucs_frag_list_pull_bulk(ucs_frag_list_t *head, ucs_queue_head_t *run);
+
+
+/**
+ * Remove and return any remaining element, disregarding sequence number order.
+ * Intended for releasing stashed elements before ucs_frag_list_cleanup().
+ *
+ * @return  NULL when the frag_list holds no more elements.
+ */
+ucs_frag_list_elem_t *ucs_frag_list_extract(ucs_frag_list_t *head);
+
+
 /**
  * Dump frag list structure for debug purposes.
  */
@@ -166,7 +197,15 @@ static inline unsigned ucs_frag_list_count(ucs_frag_list_t *head)
 
 static inline int ucs_frag_list_empty(ucs_frag_list_t *head)
 {
-    return ucs_queue_is_empty(&head->list) && ucs_queue_is_empty(&head->ready_list);
+    return ucs_queue_is_empty(&head->list) &&
+           ucs_queue_is_empty(&head->ready_list) &&
+           (head->window_count == 0);
+}
+
+static inline ucs_frag_list_elem_t **
+ucs_frag_list_window_slot(ucs_frag_list_t *head, ucs_frag_list_sn_t sn)
+{
+    return &head->window[sn & (head->window_size - 1)];
 }
 
 static inline ucs_frag_list_ooo_type_t
@@ -206,14 +245,30 @@ ucs_frag_list_insert(ucs_frag_list_t *head, ucs_frag_list_elem_t *elem,
 
 static inline ucs_frag_list_elem_t *ucs_frag_list_pull(ucs_frag_list_t *head)
 {
+    ucs_frag_list_elem_t **slot, *elem;
+
     if (!ucs_queue_is_empty(&head->ready_list)) {
         --head->elem_count;
         return ucs_queue_pull_elem_non_empty(&head->ready_list, ucs_frag_list_elem_t, list);
-    } else if (!ucs_queue_is_empty(&head->list)) {
+    }
+
+    if (head->window_count > 0) {
+        slot = ucs_frag_list_window_slot(head, UCS_FRAG_LIST_NEXT_SN(head->head_sn));
+        elem = *slot;
+        if (elem != NULL) {
+            *slot = NULL;
+            --head->window_count;
+            --head->elem_count;
+            head->head_sn++;
+            return elem;
+        }
+    }
+
+    if (!ucs_queue_is_empty(&head->list)) {
         return ucs_frag_list_pull_slow(head);
-    } else {
-        return NULL;
     }
+
+    return NULL;
 }
 
 #endif
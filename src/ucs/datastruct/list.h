@@ -170,6 +170,17 @@ static inline unsigned long ucs_list_length(ucs_list_link_t *head)
         &(_elem)->_member != (_head); \
         _elem = ucs_container_of((_elem)->_member.next, typeof(*_elem), _member))
 
+/**
+ * Iterate over members of the list, software-prefetching the next containing
+ * object one step ahead of the scan.
+ */
+#define ucs_list_for_each_pf(_elem, _head, _member) \
+    for (_elem = ucs_container_of((_head)->next, typeof(*_elem), _member); \
+        (&(_elem)->_member != (_head)) && \
+            (ucs_prefetch(ucs_container_of((_elem)->_member.next, \
+                                           typeof(*_elem), _member)), 1); \
+        _elem = ucs_container_of((_elem)->_member.next, typeof(*_elem), _member))
+
 /**
  * Iterate over members of the list, the user may invalidate the current entry.
  */
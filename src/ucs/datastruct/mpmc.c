@@ -18,20 +18,17 @@ ucs_status_t ucs_mpmc_queue_init(ucs_mpmc_queue_t *mpmc, uint32_t length)
     uint32_t i;
 
     mpmc->length   = ucs_roundup_pow2(length);
-    mpmc->shift    = ucs_ilog2(mpmc->length);
-    if (mpmc->length >= UCS_BIT(UCS_MPMC_VALID_SHIFT)) {
-        return UCS_ERR_INVALID_PARAM;
-    }
-
     mpmc->consumer = 0;
     mpmc->producer = 0;
-    mpmc->queue = ucs_malloc(sizeof(int) * mpmc->length, "mpmc");
+    mpmc->queue    = ucs_malloc(sizeof(*mpmc->queue) * mpmc->length, "mpmc");
     if (mpmc->queue == NULL) {
         return UCS_ERR_NO_MEMORY;
     }
 
+    /* Every slot starts at its own producer turn */
     for (i = 0; i < mpmc->length; ++i) {
-        mpmc->queue[i] = UCS_BIT(UCS_MPMC_VALID_SHIFT);
+        mpmc->queue[i].seq  = i;
+        mpmc->queue[i].data = NULL;
     }
 
     return UCS_OK;
@@ -42,52 +39,56 @@ void ucs_mpmc_queue_cleanup(ucs_mpmc_queue_t *mpmc)
     ucs_free(mpmc->queue);
 }
 
-static inline uint32_t __ucs_mpmc_queue_valid_bit(ucs_mpmc_queue_t *mpmc, uint32_t location)
-{
-    return (location >> mpmc->shift) & 1;
-}
-
-ucs_status_t ucs_mpmc_queue_push(ucs_mpmc_queue_t *mpmc, uint32_t value)
+ucs_status_t ucs_mpmc_queue_push(ucs_mpmc_queue_t *mpmc, void *value)
 {
+    ucs_mpmc_elem_t *elem;
     uint32_t location;
 
-    ucs_assert((value >> UCS_MPMC_VALID_SHIFT) == 0);
-
-    do {
+    for (;;) {
         location = mpmc->producer;
-        if (UCS_CIRCULAR_COMPARE32(location, >=, mpmc->consumer + mpmc->length)) {
-            /* Queue is full */
+        elem     = &mpmc->queue[location & (mpmc->length - 1)];
+        if (elem->seq == location) {
+            /* The slot is free - claim the producer index. On failure another
+             * producer claimed it first, so retry with the new index. */
+            if (ucs_atomic_cswap32(&mpmc->producer, location,
+                                   location + 1) == location) {
+                break;
+            }
+        } else if (UCS_CIRCULAR_COMPARE32(elem->seq, <, location)) {
+            /* The consumer of the previous lap did not release the slot yet */
             return UCS_ERR_EXCEEDS_LIMIT;
         }
-    } while (ucs_atomic_cswap32(&mpmc->producer, location, location + 1) != location);
+    }
 
-    mpmc->queue[location & (mpmc->length - 1)] = value |
-                    (__ucs_mpmc_queue_valid_bit(mpmc, location) << UCS_MPMC_VALID_SHIFT);
+    elem->data = value;
+    ucs_memory_cpu_store_fence();
+    elem->seq  = location + 1; /* Hand the slot to the consumer */
     return UCS_OK;
 }
 
-
-ucs_status_t ucs_mpmc_queue_pull(ucs_mpmc_queue_t *mpmc, uint32_t *value_p)
+ucs_status_t ucs_mpmc_queue_pull(ucs_mpmc_queue_t *mpmc, void **value_p)
 {
-    uint32_t location, value;
-
-    location = mpmc->consumer;
-    if (location == mpmc->producer) {
-        /* Producer not started yet */
-        return UCS_ERR_NO_PROGRESS;
-    }
-
-    value = mpmc->queue[location & (mpmc->length - 1)];
-    if ((value >> UCS_MPMC_VALID_SHIFT) != __ucs_mpmc_queue_valid_bit(mpmc, location)) {
-        /* Producer not finished yet */
-        return UCS_ERR_NO_PROGRESS;
-    }
+    ucs_mpmc_elem_t *elem;
+    uint32_t location;
 
-    if (ucs_atomic_cswap32(&mpmc->consumer, location, location + 1) != location) {
-        /* Someone else consumed */
-        return UCS_ERR_NO_PROGRESS;
+    for (;;) {
+        location = mpmc->consumer;
+        elem     = &mpmc->queue[location & (mpmc->length - 1)];
+        if (elem->seq == location + 1) {
+            /* The slot is filled - claim the consumer index */
+            if (ucs_atomic_cswap32(&mpmc->consumer, location,
+                                   location + 1) == location) {
+                break;
+            }
+        } else if (UCS_CIRCULAR_COMPARE32(elem->seq, <, location + 1)) {
+            /* Empty, or the producer did not finish writing yet */
+            return UCS_ERR_NO_PROGRESS;
+        }
     }
 
-    *value_p = value & UCS_MASK(UCS_MPMC_VALID_SHIFT);
+    ucs_memory_cpu_load_fence();
+    *value_p   = elem->data;
+    ucs_memory_cpu_store_fence();
+    elem->seq  = location + mpmc->length; /* Release the slot for the next lap */
     return UCS_OK;
 }
@@ -9,23 +9,34 @@
 
 #include <ucs/type/status.h>
 #include <ucs/sys/math.h>
+#include <ucs/arch/cpu.h>
 
-#define UCS_MPMC_VALID_SHIFT        31
-#define UCS_MPMC_VALUE_MAX          UCS_BIT(UCS_MPMC_VALID_SHIFT)
 
 /**
- * A Multi-producer-multi-consumer thread-safe queue.
- * Every push/pull is a single atomic operation in "good" scenario.
- * The queue can contain small integers up to UCS_MPMC_VALUE_MAX.
- *
- * TODO make the queue resizeable.
+ * One slot of the MPMC queue. The sequence number tells whose turn the slot
+ * is: a producer may fill it when seq == position, a consumer may take it
+ * when seq == position + 1.
+ */
+typedef struct ucs_mpmc_elem {
+    volatile uint32_t  seq;         /* Turn number of the slot */
+    void               *data;       /* User pointer */
+} ucs_mpmc_elem_t;
+
+
+/**
+ * A Multi-producer-multi-consumer thread-safe queue of pointers.
+ * Every push/pull is a single atomic operation in "good" scenario, and the
+ * per-slot sequence numbers keep producers and consumers from ever touching
+ * the same slot concurrently. The producer and consumer indexes live on
+ * separate cache lines, so the two sides do not bounce the same line.
  */
 typedef struct ucs_mpmc_queue {
     uint32_t           length;      /* Array size. Rounded to power of 2. */
-    int                shift;
+    ucs_mpmc_elem_t    *queue;      /* Array of slots */
+    char               pad0[UCS_SYS_CACHE_LINE_SIZE];
     volatile uint32_t  producer;    /* Producer index */
+    char               pad1[UCS_SYS_CACHE_LINE_SIZE];
     volatile uint32_t  consumer;    /* Consumer index */
-    uint32_t           *queue;      /* Array of data */
 } ucs_mpmc_queue_t;
 
 
@@ -44,22 +55,22 @@ void ucs_mpmc_queue_cleanup(ucs_mpmc_queue_t *mpmc);
 
 
 /**
- * Atomically push a value to the queue.
+ * Atomically push a pointer to the queue.
  *
- * @param value Value to push.
+ * @param value Pointer to push.
  * @return UCS_ERR_EXCEEDS_LIMIT if the queue is full.
  */
-ucs_status_t ucs_mpmc_queue_push(ucs_mpmc_queue_t *mpmc, uint32_t value);
+ucs_status_t ucs_mpmc_queue_push(ucs_mpmc_queue_t *mpmc, void *value);
 
 
 /**
- * Atomically pull a value from the queue.
+ * Atomically pull a pointer from the queue.
  *
- * @param value_p Filled with the value, if successful.
+ * @param value_p Filled with the pointer, if successful.
  * @param UCS_ERR_NO_PROGRESS if there is currently no available item to retrieve,
  *                            or another thread removed the current item.
  */
-ucs_status_t ucs_mpmc_queue_pull(ucs_mpmc_queue_t *mpmc, uint32_t *value_p);
+ucs_status_t ucs_mpmc_queue_pull(ucs_mpmc_queue_t *mpmc, void **value_p);
 
 
 /**
@@ -69,8 +69,14 @@ ucs_status_t ucs_mpool_init(ucs_mpool_t *mp, size_t priv_size,
     mp->data->chunk_size   = sizeof(ucs_mpool_chunk_t) + alignment +
                              elems_per_chunk * ucs_mpool_elem_total_size(mp->data);
     mp->data->chunks       = NULL;
+    mp->data->total_size   = 0;
+    mp->data->mp           = mp;
     mp->data->ops          = ops;
     mp->data->name         = strdup(name);
+    mp->data->mt_enabled   = 0;
+    mp->data->depot_full   = NULL;
+    mp->data->depot_empty  = NULL;
+    ucs_list_head_init(&mp->data->trim_list);
 
     VALGRIND_CREATE_MEMPOOL(mp, 0, 0);
 
@@ -79,6 +85,254 @@ ucs_status_t ucs_mpool_init(ucs_mpool_t *mp, size_t priv_size,
     return UCS_OK;
 }
 
+static ucs_mpool_mag_t *ucs_mpool_depot_pop(ucs_mpool_mag_t **stack)
+{
+    ucs_mpool_mag_t *mag = *stack;
+
+    if (mag != NULL) {
+        *stack = mag->next;
+    }
+    return mag;
+}
+
+static void ucs_mpool_depot_push(ucs_mpool_mag_t **stack, ucs_mpool_mag_t *mag)
+{
+    mag->next = *stack;
+    *stack    = mag;
+}
+
+/* Return the contents of a magazine to the freelist. Called with the pool
+ * lock held. */
+static void ucs_mpool_mag_drain(ucs_mpool_t *mp, ucs_mpool_mag_t *mag)
+{
+    while (mag->count > 0) {
+        ucs_mpool_put_inline(mag->objs[--mag->count]);
+    }
+}
+
+/* Flush the cache of an exiting thread back to the depot */
+static void ucs_mpool_tcache_destructor(void *arg)
+{
+    ucs_mpool_tcache_t *tcache = arg;
+    ucs_mpool_data_t *data     = tcache->mp->data;
+
+    ucs_spin_lock(&data->lock);
+    if (tcache->loaded != NULL) {
+        ucs_mpool_mag_drain(tcache->mp, tcache->loaded);
+        ucs_mpool_depot_push(&data->depot_empty, tcache->loaded);
+    }
+    if (tcache->prev != NULL) {
+        ucs_mpool_mag_drain(tcache->mp, tcache->prev);
+        ucs_mpool_depot_push(&data->depot_empty, tcache->prev);
+    }
+    ucs_spin_unlock(&data->lock);
+    ucs_free(tcache);
+}
+
+ucs_status_t ucs_mpool_enable_mt(ucs_mpool_t *mp)
+{
+    ucs_mpool_data_t *data = mp->data;
+    ucs_status_t status;
+    int ret;
+
+    status = ucs_spinlock_init(&data->lock);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ret = pthread_key_create(&data->tcache_key, ucs_mpool_tcache_destructor);
+    if (ret != 0) {
+        ucs_error("pthread_key_create() failed: %m");
+        ucs_spinlock_destroy(&data->lock);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    data->mt_enabled = 1;
+    return UCS_OK;
+}
+
+static ucs_mpool_tcache_t *ucs_mpool_tcache_get(ucs_mpool_t *mp)
+{
+    ucs_mpool_data_t *data = mp->data;
+    ucs_mpool_tcache_t *tcache;
+
+    tcache = pthread_getspecific(data->tcache_key);
+    if (ucs_likely(tcache != NULL)) {
+        return tcache;
+    }
+
+    tcache = ucs_malloc(sizeof(*tcache), "mpool_tcache");
+    if (tcache == NULL) {
+        return NULL;
+    }
+
+    tcache->mp     = mp;
+    tcache->loaded = NULL;
+    tcache->prev   = NULL;
+    if (pthread_setspecific(data->tcache_key, tcache) != 0) {
+        ucs_free(tcache);
+        return NULL;
+    }
+    return tcache;
+}
+
+static void *ucs_mpool_get_mt(ucs_mpool_t *mp)
+{
+    ucs_mpool_data_t *data = mp->data;
+    ucs_mpool_tcache_t *tcache;
+    ucs_mpool_mag_t *mag;
+    void *obj;
+
+    tcache = ucs_mpool_tcache_get(mp);
+    if (ucs_unlikely(tcache == NULL)) {
+        goto get_locked;
+    }
+
+    mag = tcache->loaded;
+    if (ucs_likely((mag != NULL) && (mag->count > 0))) {
+        return mag->objs[--mag->count];
+    }
+
+    if ((tcache->prev != NULL) && (tcache->prev->count > 0)) {
+        tcache->loaded = tcache->prev;
+        tcache->prev   = mag;
+        mag            = tcache->loaded;
+        return mag->objs[--mag->count];
+    }
+
+    /* Both magazines are empty - exchange one with the depot */
+    ucs_spin_lock(&data->lock);
+    mag = ucs_mpool_depot_pop(&data->depot_full);
+    if (mag != NULL) {
+        if (tcache->prev != NULL) {
+            ucs_mpool_depot_push(&data->depot_empty, tcache->prev);
+        }
+        ucs_spin_unlock(&data->lock);
+        tcache->prev   = tcache->loaded;
+        tcache->loaded = mag;
+        return mag->objs[--mag->count];
+    }
+
+    /* The depot has no full magazines - refill the loaded one from the
+     * freelist */
+    mag = tcache->loaded;
+    if (mag == NULL) {
+        mag = ucs_mpool_depot_pop(&data->depot_empty);
+    }
+    if (mag == NULL) {
+        ucs_spin_unlock(&data->lock);
+        mag = ucs_malloc(sizeof(*mag), "mpool_mag");
+        if (mag == NULL) {
+            goto get_locked;
+        }
+        mag->count = 0;
+        ucs_spin_lock(&data->lock);
+    }
+
+    while (mag->count < UCS_MPOOL_MAG_SIZE) {
+        obj = ucs_mpool_get_inline(mp);
+        if (obj == NULL) {
+            break;
+        }
+        mag->objs[mag->count++] = obj;
+    }
+    ucs_spin_unlock(&data->lock);
+
+    tcache->loaded = mag;
+    if (mag->count == 0) {
+        return NULL;
+    }
+    return mag->objs[--mag->count];
+
+get_locked:
+    ucs_spin_lock(&data->lock);
+    obj = ucs_mpool_get_inline(mp);
+    ucs_spin_unlock(&data->lock);
+    return obj;
+}
+
+static void ucs_mpool_put_mt(ucs_mpool_t *mp, void *obj)
+{
+    ucs_mpool_data_t *data = mp->data;
+    ucs_mpool_tcache_t *tcache;
+    ucs_mpool_mag_t *mag;
+
+    tcache = ucs_mpool_tcache_get(mp);
+    if (ucs_unlikely(tcache == NULL)) {
+        goto put_locked;
+    }
+
+    mag = tcache->loaded;
+    if (ucs_likely((mag != NULL) && (mag->count < UCS_MPOOL_MAG_SIZE))) {
+        mag->objs[mag->count++] = obj;
+        return;
+    }
+
+    if ((tcache->prev != NULL) && (tcache->prev->count < UCS_MPOOL_MAG_SIZE)) {
+        tcache->loaded = tcache->prev;
+        tcache->prev   = mag;
+        mag            = tcache->loaded;
+        mag->objs[mag->count++] = obj;
+        return;
+    }
+
+    /* Both magazines are full - retire one to the depot and load an empty
+     * one */
+    ucs_spin_lock(&data->lock);
+    if (tcache->prev != NULL) {
+        ucs_mpool_depot_push(&data->depot_full, tcache->prev);
+        tcache->prev = NULL;
+    }
+    mag = ucs_mpool_depot_pop(&data->depot_empty);
+    ucs_spin_unlock(&data->lock);
+
+    if (mag == NULL) {
+        mag = ucs_malloc(sizeof(*mag), "mpool_mag");
+        if (mag == NULL) {
+            goto put_locked;
+        }
+        mag->count = 0;
+    }
+
+    tcache->prev   = tcache->loaded;
+    tcache->loaded = mag;
+    mag->objs[mag->count++] = obj;
+    return;
+
+put_locked:
+    ucs_spin_lock(&data->lock);
+    ucs_mpool_put_inline(obj);
+    ucs_spin_unlock(&data->lock);
+}
+
+static void ucs_mpool_depot_cleanup(ucs_mpool_t *mp)
+{
+    ucs_mpool_data_t *data = mp->data;
+    ucs_mpool_tcache_t *tcache;
+    ucs_mpool_mag_t *mag;
+
+    /* The cache of the calling thread is not flushed by the key destructor,
+     * which runs only at thread exit */
+    tcache = pthread_getspecific(data->tcache_key);
+    if (tcache != NULL) {
+        pthread_setspecific(data->tcache_key, NULL);
+        ucs_mpool_tcache_destructor(tcache);
+    }
+
+    pthread_key_delete(data->tcache_key);
+
+    while ((mag = ucs_mpool_depot_pop(&data->depot_full)) != NULL) {
+        ucs_mpool_mag_drain(mp, mag);
+        ucs_free(mag);
+    }
+    while ((mag = ucs_mpool_depot_pop(&data->depot_empty)) != NULL) {
+        ucs_free(mag);
+    }
+
+    ucs_spinlock_destroy(&data->lock);
+    data->mt_enabled = 0;
+}
+
 void ucs_mpool_cleanup(ucs_mpool_t *mp, int leak_check)
 {
     ucs_mpool_chunk_t *chunk, *next_chunk;
@@ -86,6 +340,12 @@ void ucs_mpool_cleanup(ucs_mpool_t *mp, int leak_check)
     ucs_mpool_data_t *data = mp->data;
     void *obj;
 
+    ucs_list_del(&data->trim_list); /* Detach from a trim accountant, if any */
+
+    if (data->mt_enabled) {
+        ucs_mpool_depot_cleanup(mp);
+    }
+
     /* Cleanup all elements in the freelist and set their header to NULL to mark
      * them as released for the leak check.
      */
@@ -130,6 +390,90 @@ void ucs_mpool_cleanup(ucs_mpool_t *mp, int leak_check)
     ucs_free(data);
 }
 
+unsigned ucs_mpool_trim(ucs_mpool_t *mp)
+{
+    ucs_mpool_data_t *data = mp->data;
+    ucs_mpool_chunk_t *chunk, **chunk_p;
+    ucs_mpool_elem_t *elem, **elem_p;
+    unsigned num_released, num_free;
+    uintptr_t start, end;
+    void *obj;
+
+    if (data->mt_enabled) {
+        ucs_spin_lock(&data->lock);
+    }
+
+    num_released = 0;
+    chunk_p      = &data->chunks;
+    while ((chunk = *chunk_p) != NULL) {
+        start = (uintptr_t)chunk->elems;
+        end   = start + (chunk->num_elems * ucs_mpool_elem_total_size(data));
+
+        /* Count how many of this chunk's elements are on the free list */
+        num_free = 0;
+        for (elem = mp->freelist; elem != NULL; elem = elem->next) {
+            VALGRIND_MAKE_MEM_DEFINED(elem, sizeof *elem);
+            if (((uintptr_t)elem >= start) && ((uintptr_t)elem < end)) {
+                ++num_free;
+            }
+        }
+
+        if (num_free < chunk->num_elems) {
+            chunk_p = &chunk->next;
+            continue;
+        }
+
+        /* All elements are free - unlink them and release the chunk */
+        elem_p = &mp->freelist;
+        while ((elem = *elem_p) != NULL) {
+            VALGRIND_MAKE_MEM_DEFINED(elem, sizeof *elem);
+            if (((uintptr_t)elem >= start) && ((uintptr_t)elem < end)) {
+                if (data->ops->obj_cleanup != NULL) {
+                    obj = elem + 1;
+                    VALGRIND_MEMPOOL_ALLOC(mp, obj, data->elem_size - sizeof(ucs_mpool_elem_t));
+                    VALGRIND_MAKE_MEM_DEFINED(obj, data->elem_size - sizeof(ucs_mpool_elem_t));
+                    data->ops->obj_cleanup(mp, obj);
+                    VALGRIND_MEMPOOL_FREE(mp, obj);
+                }
+                *elem_p = elem->next;
+            } else {
+                elem_p = &elem->next;
+            }
+        }
+
+        *chunk_p = chunk->next;
+        if (data->quota != UINT_MAX) {
+            data->quota += chunk->num_elems;
+        }
+        data->total_size -= chunk->size;
+
+        ucs_debug("mpool %s: trimmed chunk %p with %u elements",
+                  ucs_mpool_name(mp), chunk, chunk->num_elems);
+        data->ops->chunk_release(mp, chunk);
+        ++num_released;
+    }
+
+    if (num_released > 0) {
+        /* Recompute the free list tail */
+        data->tail = NULL;
+        for (elem = mp->freelist; elem != NULL; elem = elem->next) {
+            VALGRIND_MAKE_MEM_DEFINED(elem, sizeof *elem);
+            data->tail = elem;
+        }
+    }
+
+    if (data->mt_enabled) {
+        ucs_spin_unlock(&data->lock);
+    }
+
+    return num_released;
+}
+
+size_t ucs_mpool_mem_size(ucs_mpool_t *mp)
+{
+    return mp->data->total_size;
+}
+
 void *ucs_mpool_priv(ucs_mpool_t *mp)
 {
     return mp->data + 1;
@@ -147,11 +491,20 @@ int ucs_mpool_is_empty(ucs_mpool_t *mp)
 
 void *ucs_mpool_get(ucs_mpool_t *mp)
 {
+    if (ucs_unlikely(mp->data->mt_enabled)) {
+        return ucs_mpool_get_mt(mp);
+    }
     return ucs_mpool_get_inline(mp);
 }
 
 void ucs_mpool_put(void *obj)
 {
+    ucs_mpool_t *mp = ucs_mpool_obj_owner(obj);
+
+    if (ucs_unlikely(mp->data->mt_enabled)) {
+        ucs_mpool_put_mt(mp, obj);
+        return;
+    }
     ucs_mpool_put_inline(obj);
 }
 
@@ -200,8 +553,10 @@ void *ucs_mpool_get_grow(ucs_mpool_t *mp)
     }
 
 
+    chunk->size  = chunk_size;
     chunk->next  = data->chunks;
     data->chunks = chunk;
+    data->total_size += chunk_size;
 
     if (data->quota == UINT_MAX) {
         /* Infinite memory pool */
@@ -214,7 +569,7 @@ void *ucs_mpool_get_grow(ucs_mpool_t *mp)
     VALGRIND_MAKE_MEM_NOACCESS(chunk + 1, chunk_size - sizeof(*chunk));
 
     ucs_assert(mp->freelist != NULL); /* Should not recurse */
-    return ucs_mpool_get(mp);
+    return ucs_mpool_get_inline(mp);
 }
 
 ucs_status_t ucs_mpool_chunk_malloc(ucs_mpool_t *mp, size_t *size_p, void **chunk_p)
@@ -236,6 +591,7 @@ typedef struct ucs_mmap_mpool_chunk_hdr {
 ucs_status_t ucs_mpool_chunk_mmap(ucs_mpool_t *mp, size_t *size_p, void **chunk_p)
 {
     ucs_mmap_mpool_chunk_hdr_t *chunk;
+    ucs_sys_alloc_attr_t attr;
     size_t real_size;
 
     real_size = ucs_align_up(*size_p + sizeof(*chunk), ucs_get_page_size());
@@ -248,6 +604,13 @@ ucs_status_t ucs_mpool_chunk_mmap(ucs_mpool_t *mp, size_t *size_p, void **chunk_
     chunk->size = real_size;
     *size_p     = real_size - sizeof(*chunk);
     *chunk_p    = chunk + 1;
+
+    /* Back the chunk with large pages if possible, and fault it in now
+     * rather than when objects are first used on the data path */
+    attr.thp       = 1;
+    attr.prefault  = 1;
+    attr.numa_node = -1;
+    ucs_sys_alloc_apply_attr(chunk, real_size, &attr);
     return UCS_OK;
 }
 
@@ -266,6 +629,7 @@ typedef struct ucs_hugetlb_mpool_chunk_hdr {
 ucs_status_t ucs_mpool_hugetlb_malloc(ucs_mpool_t *mp, size_t *size_p, void **chunk_p)
 {
     ucs_hugetlb_mpool_chunk_hdr_t *chunk;
+    ucs_sys_alloc_attr_t attr;
     void *ptr;
     ucs_status_t status;
     size_t real_size;
@@ -296,6 +660,13 @@ ucs_status_t ucs_mpool_hugetlb_malloc(ucs_mpool_t *mp, size_t *size_p, void **ch
 out_ok:
     *size_p  = real_size - sizeof(*chunk);
     *chunk_p = chunk + 1;
+
+    /* Fault the chunk in now rather than when objects are first used on the
+     * data path. The hugetlb path already allocated large pages */
+    attr.thp       = !chunk->hugetlb;
+    attr.prefault  = 1;
+    attr.numa_node = -1;
+    ucs_sys_alloc_apply_attr(chunk, real_size, &attr);
     return UCS_OK;
 }
 
@@ -8,9 +8,16 @@
 #define UCS_MPOOL_H_
 
 
+#include <ucs/datastruct/list.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/type/status.h>
+#include <ucs/type/spinlock.h>
+#include <pthread.h>
+
+
+/* How many objects fit in one magazine */
+#define UCS_MPOOL_MAG_SIZE    64
 
 
 typedef struct ucs_mpool_chunk   ucs_mpool_chunk_t;
@@ -18,6 +25,8 @@ typedef union  ucs_mpool_elem    ucs_mpool_elem_t;
 typedef struct ucs_mpool         ucs_mpool_t;
 typedef struct ucs_mpool_data    ucs_mpool_data_t;
 typedef struct ucs_mpool_ops     ucs_mpool_ops_t;
+typedef struct ucs_mpool_mag     ucs_mpool_mag_t;
+typedef struct ucs_mpool_tcache  ucs_mpool_tcache_t;
 
 
 /**
@@ -53,6 +62,8 @@ struct ucs_mpool_chunk {
     ucs_mpool_chunk_t      *next;      /* Next chunk */
     void                   *elems;     /* Array of elements */
     unsigned               num_elems;  /* How many elements */
+    size_t                 size;       /* Allocated chunk size, for footprint
+                                          accounting */
 };
 
 
@@ -76,8 +87,42 @@ struct ucs_mpool_data {
     ucs_mpool_elem_t       *tail;        /* Free list tail */
     size_t                 chunk_size;   /* Size of each chunk */
     ucs_mpool_chunk_t      *chunks;      /* List of allocated chunks */
+    size_t                 total_size;   /* Total size of allocated chunks */
+    ucs_mpool_t            *mp;          /* Back-pointer, for code which walks
+                                            pools by their trim_list link */
+    ucs_list_link_t        trim_list;    /* Membership in a trim accountant
+                                            list (e.g per-worker budget) */
     ucs_mpool_ops_t        *ops;         /* Memory pool operations */
     char                   *name;        /* Name - used for debugging */
+    int                    mt_enabled;   /* Whether per-thread caches are used */
+    pthread_key_t          tcache_key;   /* Per-thread cache (mt mode only) */
+    ucs_spinlock_t         lock;         /* Protects freelist and depot (mt mode only) */
+    ucs_mpool_mag_t        *depot_full;  /* Stack of full magazines (mt mode only) */
+    ucs_mpool_mag_t        *depot_empty; /* Stack of empty magazines (mt mode only) */
+};
+
+
+/**
+ * A magazine - fixed-size batch of objects which moves as a whole between a
+ * per-thread cache and the depot.
+ */
+struct ucs_mpool_mag {
+    ucs_mpool_mag_t        *next;        /* Next magazine in the depot stack */
+    unsigned               count;        /* Number of objects in the magazine */
+    void                   *objs[UCS_MPOOL_MAG_SIZE];
+};
+
+
+/**
+ * Per-thread cache of two magazines. Objects are taken from and returned to
+ * the loaded magazine; when it runs empty (or full) it is exchanged with the
+ * previous one, and only when both are empty (or full) the thread goes to the
+ * depot, so the lock there is taken once per UCS_MPOOL_MAG_SIZE operations.
+ */
+struct ucs_mpool_tcache {
+    ucs_mpool_t            *mp;          /* Owner pool */
+    ucs_mpool_mag_t        *loaded;      /* Magazine being allocated from */
+    ucs_mpool_mag_t        *prev;        /* Previously loaded magazine */
 };
 
 
@@ -160,6 +205,43 @@ ucs_status_t ucs_mpool_init(ucs_mpool_t *mp, size_t priv_size,
 void ucs_mpool_cleanup(ucs_mpool_t *mp, int leak_check);
 
 
+/**
+ * Release chunks all of whose elements are on the free list, returning their
+ * memory to the system. Elements cached in per-thread magazines (mt mode) keep
+ * their chunks allocated. Intended for slow-path memory reclaim after bursts.
+ *
+ * @param mp               Memory pool structure.
+ *
+ * @return Number of chunks released.
+ */
+unsigned ucs_mpool_trim(ucs_mpool_t *mp);
+
+
+/**
+ * @param mp               Memory pool structure.
+ *
+ * @return Total size of chunk memory currently allocated by the pool, bytes.
+ */
+size_t ucs_mpool_mem_size(ucs_mpool_t *mp);
+
+
+/**
+ * Make ucs_mpool_get()/ucs_mpool_put() thread safe by caching objects in
+ * per-thread magazines. The magazines are exchanged with a shared depot, so
+ * the pool lock is taken only once per UCS_MPOOL_MAG_SIZE operations.
+ * ucs_mpool_get_inline()/ucs_mpool_put_inline() bypass the caches and remain
+ * single-threaded.
+ *
+ * All threads must stop using the pool before ucs_mpool_cleanup() is called;
+ * objects cached by a thread are returned to the pool when it exits.
+ *
+ * @param mp               Memory pool structure.
+ *
+ * @return UCS status code.
+ */
+ucs_status_t ucs_mpool_enable_mt(ucs_mpool_t *mp);
+
+
 /**
  * @param mp               Memory pool structure.
  *
@@ -0,0 +1,243 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#ifndef UCS_OHASH_H_
+#define UCS_OHASH_H_
+
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/compiler.h>
+#include <ucs/type/status.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Open-addressing hash table with robin-hood linear probing.
+ *
+ * Key and value are stored inline in the same bucket, so a successful lookup
+ * touches a single cache line - unlike khash, which keeps flags, keys and
+ * values in three separate arrays. Deletion uses backward shifting instead of
+ * tombstones, so probe sequences never degrade. The capacity is a power of
+ * two and doubles when the table becomes 7/8 full.
+ *
+ * Keys must be scalar types (compared with '=='). The bucket 'dist' field
+ * holds the probe distance plus one; zero marks an empty bucket.
+ *
+ * Pointers returned by _get/_put are invalidated by any subsequent insertion
+ * or removal.
+ */
+
+#define UCS_OHASH_MIN_CAPACITY   16
+
+
+/* Mixer for 64-bit keys, to be passed as _hash_func */
+static UCS_F_ALWAYS_INLINE unsigned ucs_ohash_hash64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 29;
+    return (unsigned)key;
+}
+
+
+#define UCS_OHASH_IMPL(_name, _key_t, _val_t, _hash_func) \
+    \
+    typedef struct { \
+        _key_t    key; \
+        _val_t    value; \
+        uint8_t   dist; /* Probe distance + 1, 0 if the bucket is empty */ \
+    } _name##_bucket_t; \
+    \
+    typedef struct { \
+        _name##_bucket_t *buckets; \
+        unsigned         capacity; /* Power of two, 0 before first insert */ \
+        unsigned         count; \
+    } _name##_t; \
+    \
+    \
+    static inline void _name##_init(_name##_t *hash) \
+    { \
+        hash->buckets  = NULL; \
+        hash->capacity = 0; \
+        hash->count    = 0; \
+    } \
+    \
+    static inline void _name##_cleanup(_name##_t *hash) \
+    { \
+        ucs_free(hash->buckets); \
+        _name##_init(hash); \
+    } \
+    \
+    static inline _val_t *_name##_get(_name##_t *hash, _key_t key) \
+    { \
+        _name##_bucket_t *bucket; \
+        unsigned index, mask; \
+        uint8_t dist; \
+        \
+        if (hash->count == 0) { \
+            return NULL; \
+        } \
+        \
+        mask  = hash->capacity - 1; \
+        index = _hash_func(key) & mask; \
+        dist  = 1; \
+        for (;;) { \
+            bucket = &hash->buckets[index]; \
+            if (bucket->dist < dist) { \
+                /* Empty, or holds a key with a shorter probe distance - by \
+                 * the robin-hood invariant our key cannot be further on */ \
+                return NULL; \
+            } \
+            if ((bucket->dist == dist) && (bucket->key == key)) { \
+                return &bucket->value; \
+            } \
+            index = (index + 1) & mask; \
+            ++dist; \
+        } \
+    } \
+    \
+    static inline _val_t *_name##_put(_name##_t *hash, _key_t key, \
+                                      int *is_new_p); \
+    \
+    static inline ucs_status_t _name##_grow(_name##_t *hash) \
+    { \
+        _name##_bucket_t *old_buckets = hash->buckets; \
+        unsigned old_capacity         = hash->capacity; \
+        _name##_bucket_t *bucket; \
+        _val_t *value; \
+        int is_new; \
+        \
+        hash->capacity = (old_capacity == 0) ? UCS_OHASH_MIN_CAPACITY : \
+                                               (old_capacity * 2); \
+        hash->buckets  = (_name##_bucket_t*)ucs_calloc(hash->capacity, \
+                                                       sizeof(*hash->buckets), \
+                                                       #_name); \
+        if (hash->buckets == NULL) { \
+            hash->buckets  = old_buckets; \
+            hash->capacity = old_capacity; \
+            return UCS_ERR_NO_MEMORY; \
+        } \
+        \
+        hash->count = 0; \
+        for (bucket = old_buckets; bucket < old_buckets + old_capacity; \
+             ++bucket) \
+        { \
+            if (bucket->dist != 0) { \
+                /* Cannot fail - the new table is half full at most */ \
+                value  = _name##_put(hash, bucket->key, &is_new); \
+                *value = bucket->value; \
+            } \
+        } \
+        \
+        ucs_free(old_buckets); \
+        return UCS_OK; \
+    } \
+    \
+    static inline _val_t *_name##_put(_name##_t *hash, _key_t key, \
+                                      int *is_new_p) \
+    { \
+        _name##_bucket_t cur, tmp, *bucket, *mine = NULL; \
+        unsigned index, mask; \
+        \
+        if (ucs_unlikely(((hash->count + 1) * 8) > (hash->capacity * 7)) && \
+            (_name##_grow(hash) != UCS_OK)) \
+        { \
+            return NULL; \
+        } \
+        \
+        cur.key  = key; \
+        cur.dist = 1; \
+        mask     = hash->capacity - 1; \
+        index    = _hash_func(key) & mask; \
+        for (;;) { \
+            bucket = &hash->buckets[index]; \
+            if (bucket->dist == 0) { \
+                *bucket = cur; \
+                ++hash->count; \
+                *is_new_p = 1; \
+                return &((mine == NULL) ? bucket : mine)->value; \
+            } \
+            if ((mine == NULL) && (bucket->dist == cur.dist) && \
+                (bucket->key == key)) \
+            { \
+                *is_new_p = 0; \
+                return &bucket->value; \
+            } \
+            if (bucket->dist < cur.dist) { \
+                /* Displace the richer entry and keep inserting it */ \
+                tmp     = *bucket; \
+                *bucket = cur; \
+                cur     = tmp; \
+                if (mine == NULL) { \
+                    mine = bucket; \
+                } \
+            } \
+            ++cur.dist; \
+            index = (index + 1) & mask; \
+        } \
+    } \
+    \
+    static inline int _name##_del(_name##_t *hash, _key_t key) \
+    { \
+        _name##_bucket_t *bucket, *next_bucket; \
+        unsigned index, next, mask; \
+        uint8_t dist; \
+        \
+        if (hash->count == 0) { \
+            return 0; \
+        } \
+        \
+        mask  = hash->capacity - 1; \
+        index = _hash_func(key) & mask; \
+        dist  = 1; \
+        for (;;) { \
+            bucket = &hash->buckets[index]; \
+            if (bucket->dist < dist) { \
+                return 0; \
+            } \
+            if ((bucket->dist == dist) && (bucket->key == key)) { \
+                break; \
+            } \
+            index = (index + 1) & mask; \
+            ++dist; \
+        } \
+        \
+        /* Backward-shift the rest of the probe chain over the hole */ \
+        next = (index + 1) & mask; \
+        while (hash->buckets[next].dist > 1) { \
+            next_bucket       = &hash->buckets[next]; \
+            hash->buckets[index]  = *next_bucket; \
+            --hash->buckets[index].dist; \
+            index = next; \
+            next  = (next + 1) & mask; \
+        } \
+        hash->buckets[index].dist = 0; \
+        --hash->count; \
+        return 1; \
+    }
+
+
+/**
+ * Iterate over all values in the hash.
+ *
+ * @param _name   Hash type name, as passed to UCS_OHASH_IMPL.
+ * @param _hash   Pointer to the hash.
+ * @param _var    Variable of the value type, set for each element.
+ * @param _code   Code to execute for each element.
+ */
+#define ucs_ohash_foreach_value(_name, _hash, _var, _code) \
+    { \
+        _name##_bucket_t *_bucket; \
+        for (_bucket = (_hash)->buckets; \
+             _bucket < (_hash)->buckets + (_hash)->capacity; ++_bucket) \
+        { \
+            if (_bucket->dist != 0) { \
+                (_var) = _bucket->value; \
+                _code; \
+            } \
+        } \
+    }
+
+#endif
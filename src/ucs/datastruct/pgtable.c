@@ -354,12 +354,13 @@ no_elem:
     return UCS_ERR_NO_ELEM;
 }
 
+/* Removes a single page without shrinking the table span - the caller is
+ * expected to shrink once after it removed everything it wanted to */
 static ucs_status_t
 ucs_pgtable_remove_page(ucs_pgtable_t *pgtable, ucs_pgt_addr_t address,
                         unsigned order, ucs_pgt_region_t *region)
 {
     ucs_pgt_dir_t dummy_dir;
-    ucs_status_t status;
 
     ucs_pgtable_check_page(address, order);
 
@@ -367,14 +368,38 @@ ucs_pgtable_remove_page(ucs_pgtable_t *pgtable, ucs_pgt_addr_t address,
         return UCS_ERR_NO_ELEM;
     }
 
-    status = ucs_pgtable_remove_page_recurs(pgtable, address, order, &dummy_dir,
-                                            &pgtable->root, pgtable->shift,
-                                            region);
-    if (status != UCS_OK) {
-        return status;
+    return ucs_pgtable_remove_page_recurs(pgtable, address, order, &dummy_dir,
+                                          &pgtable->root, pgtable->shift,
+                                          region);
+}
+
+/* Remove all pages of a region, without shrinking the table span */
+static ucs_status_t
+ucs_pgtable_remove_region_pages(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region)
+{
+    ucs_pgt_addr_t address = region->start;
+    ucs_pgt_addr_t end     = region->end;
+    ucs_status_t status;
+    unsigned order;
+
+    if ((address >= end) || !ucs_pgt_is_addr_aligned(address) ||
+        !ucs_pgt_is_addr_aligned(end))
+    {
+        return UCS_ERR_NO_ELEM;
     }
 
-    while (ucs_pgtable_shrink(pgtable));
+    while (address < end) {
+        order = ucs_pgtable_get_next_page_order(address, end);
+        status = ucs_pgtable_remove_page(pgtable, address, order, region);
+        if (status != UCS_OK) {
+            ucs_assert(address == region->start); /* Cannot be partially removed */
+            return status;
+        }
+        address += 1ul << order;
+    }
+
+    ucs_assert(pgtable->num_regions > 0);
+    --pgtable->num_regions;
     return UCS_OK;
 }
 
@@ -416,41 +441,97 @@ err:
         ucs_pgtable_remove_page(pgtable, address, order, region);
         address += 1ul << order;
     }
+    while (ucs_pgtable_shrink(pgtable));
     return status;
 }
 
-ucs_status_t ucs_pgtable_remove(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region)
+ucs_status_t ucs_pgtable_insert_bulk(ucs_pgtable_t *pgtable,
+                                     ucs_pgt_region_t **regions, unsigned count)
 {
-    ucs_pgt_addr_t address = region->start;
-    ucs_pgt_addr_t end     = region->end;
+    ucs_pgt_addr_t start, end;
     ucs_status_t status;
-    unsigned order;
+    unsigned i;
 
-    ucs_trace_data("remove region " UCS_PGT_REGION_FMT, UCS_PGT_REGION_ARG(region));
+    if (count == 0) {
+        return UCS_OK;
+    }
 
-    if ((address >= end) || !ucs_pgt_is_addr_aligned(address) ||
-        !ucs_pgt_is_addr_aligned(end))
-    {
-        return UCS_ERR_NO_ELEM;
+    start = regions[0]->start;
+    end   = regions[count - 1]->end;
+
+    ucs_trace_data("bulk add %u regions [0x%lx..0x%lx]", count, start, end);
+
+    /* Expand the table once to span the whole batch, instead of expanding
+     * incrementally as regions are inserted. If the table is empty, the first
+     * insert initializes the base address */
+    if (ucs_pgt_entry_present(&pgtable->root)) {
+        while (((start       & pgtable->mask) != pgtable->base) ||
+               (((end - 1ul) & pgtable->mask) != pgtable->base))
+        {
+            ucs_pgtable_expand(pgtable);
+        }
     }
 
-    while (address < end) {
-        order = ucs_pgtable_get_next_page_order(address, end);
-        status = ucs_pgtable_remove_page(pgtable, address, order, region);
+    for (i = 0; i < count; ++i) {
+        ucs_assert((i == 0) || (regions[i]->start >= regions[i - 1]->end));
+        status = ucs_pgtable_insert(pgtable, regions[i]);
         if (status != UCS_OK) {
-            ucs_assert(address == region->start); /* Cannot be partially removed */
-            return status;
+            goto err;
         }
-        address += 1ul << order;
     }
 
-    ucs_assert(pgtable->num_regions > 0);
-    --pgtable->num_regions;
+    return UCS_OK;
+
+err:
+    /* Revert the regions inserted so far */
+    while (i-- > 0) {
+        ucs_pgtable_remove_region_pages(pgtable, regions[i]);
+    }
+    while (ucs_pgtable_shrink(pgtable));
+    return status;
+}
+
+ucs_status_t ucs_pgtable_remove(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region)
+{
+    ucs_status_t status;
+
+    ucs_trace_data("remove region " UCS_PGT_REGION_FMT, UCS_PGT_REGION_ARG(region));
+
+    status = ucs_pgtable_remove_region_pages(pgtable, region);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    while (ucs_pgtable_shrink(pgtable));
 
     ucs_pgtable_trace(pgtable, "remove");
     return UCS_OK;
 }
 
+ucs_status_t ucs_pgtable_remove_bulk(ucs_pgtable_t *pgtable,
+                                     ucs_pgt_region_t **regions, unsigned count)
+{
+    ucs_status_t status;
+    unsigned i;
+
+    ucs_trace_data("bulk remove %u regions", count);
+
+    /* Defer shrinking the table span to the end of the batch, so removing
+     * many regions does not repeatedly shrink and re-expand the tree */
+    status = UCS_OK;
+    for (i = 0; i < count; ++i) {
+        status = ucs_pgtable_remove_region_pages(pgtable, regions[i]);
+        if (status != UCS_OK) {
+            break;
+        }
+    }
+
+    while (ucs_pgtable_shrink(pgtable));
+
+    ucs_pgtable_trace(pgtable, "bulk remove");
+    return status;
+}
+
 ucs_pgt_region_t *ucs_pgtable_lookup(const ucs_pgtable_t *pgtable,
                                      ucs_pgt_addr_t address)
 {
@@ -592,9 +673,11 @@ void ucs_pgtable_purge(ucs_pgtable_t *pgtable, ucs_pgt_search_callback_t cb,
                 "next_region=%p all_regions=%p num_regions=%u",
                 next_region, all_regions, num_regions);
 
+    /* The search returns the regions sorted by address, so they can be
+     * removed as one batch */
+    ucs_pgtable_remove_bulk(pgtable, all_regions, num_regions);
     for (i = 0; i < num_regions; ++i) {
         region = all_regions[i];
-        ucs_pgtable_remove(pgtable, region);
         cb(pgtable, region, arg);
     }
 
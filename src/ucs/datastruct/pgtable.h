@@ -181,6 +181,23 @@ void ucs_pgtable_cleanup(ucs_pgtable_t *pgtable);
 ucs_status_t ucs_pgtable_insert(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region);
 
 
+/**
+ * Add a sorted batch of memory regions to the page table. The table span is
+ * expanded once to cover the whole batch, instead of incrementally per
+ * region, which amortizes the expand logic over the batch.
+ *
+ * @param [in]  pgtable     Page table to insert the regions to.
+ * @param [in]  regions     Array of regions to insert, sorted by start address
+ *                           in ascending order and non-overlapping.
+ * @param [in]  count       Number of regions in the array.
+ *
+ * @return UCS_OK - all regions were added. On error, none of the regions of
+ *         the batch remain in the table.
+ */
+ucs_status_t ucs_pgtable_insert_bulk(ucs_pgtable_t *pgtable,
+                                     ucs_pgt_region_t **regions, unsigned count);
+
+
 /**
  * Remove a memory region from the page table.
  *
@@ -196,6 +213,22 @@ ucs_status_t ucs_pgtable_insert(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region
 ucs_status_t ucs_pgtable_remove(ucs_pgtable_t *pgtable, ucs_pgt_region_t *region);
 
 
+/**
+ * Remove a batch of memory regions from the page table. The table span is
+ * shrunk only once, after the whole batch was removed.
+ *
+ * @param [in]  pgtable     Page table to remove the regions from.
+ * @param [in]  regions     Array of regions to remove. These must be the same
+ *                           pointers passed to @ref ucs_pgtable_insert.
+ * @param [in]  count       Number of regions in the array.
+ *
+ * @return UCS_OK - all regions were removed. Otherwise - the status of the
+ *         first removal which failed; regions removed before it stay removed.
+ */
+ucs_status_t ucs_pgtable_remove_bulk(ucs_pgtable_t *pgtable,
+                                     ucs_pgt_region_t **regions, unsigned count);
+
+
 /*
  * Find a region which contains the given address.
  *
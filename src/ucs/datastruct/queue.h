@@ -195,7 +195,28 @@ static inline void ucs_queue_splice(ucs_queue_head_t *queue,
 #define ucs_queue_for_each(elem, queue, member) \
     for (*(queue)->ptail = NULL, \
              elem = ucs_container_of((queue)->head, typeof(*elem), member); \
-         &elem->member != NULL; \
+         /* compare to the end sentinel instead of testing &elem->member \
+          * against NULL - the compiler is allowed to assume a member \
+          * address is never NULL and would drop that check */ \
+         elem != ucs_container_of(NULL, typeof(*elem), member); \
+         elem = ucs_container_of(elem->member.next, typeof(*elem), member))
+
+/**
+ * Iterate over queue elements, software-prefetching the next containing
+ * object one step ahead. Useful for long scans whose cost is dominated by
+ * the dependent-load chain of 'next' pointers. The queue must not be
+ * modified during the iteration.
+ *
+ * @param elem    Variable which will hold point to the element in the queue.
+ * @param queue   Queue to iterate on.
+ * @param member  Member inside 'elem' which is the queue link.
+ */
+#define ucs_queue_for_each_pf(elem, queue, member) \
+    for (*(queue)->ptail = NULL, \
+             elem = ucs_container_of((queue)->head, typeof(*elem), member); \
+         (elem != ucs_container_of(NULL, typeof(*elem), member)) && \
+             (ucs_prefetch(ucs_container_of(elem->member.next, typeof(*elem), \
+                                            member)), 1); \
          elem = ucs_container_of(elem->member.next, typeof(*elem), member))
 
 /**
@@ -214,6 +235,24 @@ static inline void ucs_queue_splice(ucs_queue_head_t *queue,
           iter = (*iter == &elem->member) ? &(*iter)->next : iter, \
             elem = ucs_container_of(*iter, typeof(*elem), member))
 
+/**
+ * Same as ucs_queue_for_each_safe(), with a software prefetch of the next
+ * containing object one step ahead of the scan.
+ *
+ * @param elem    Variable which will hold point to the element in the queue.
+ * @param iter    Iterator variable. May be passed to ucs_queue_del_iter().
+ * @param queue   Queue to iterate on.
+ * @param member  Member inside 'elem' which is the queue link.
+ */
+#define ucs_queue_for_each_safe_pf(elem, iter, queue, member) \
+    for (iter = &(queue)->head, \
+         elem = ucs_container_of(*iter, typeof(*elem), member); \
+          (iter != (queue)->ptail) && \
+          (ucs_prefetch(ucs_container_of((*iter)->next, typeof(*elem), \
+                                         member)), 1); \
+          iter = (*iter == &elem->member) ? &(*iter)->next : iter, \
+            elem = ucs_container_of(*iter, typeof(*elem), member))
+
 /**
  * Iterate and extract elements from the queue while a condition is true.
  *
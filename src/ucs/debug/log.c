@@ -7,12 +7,47 @@
 #include "log.h"
 #include "debug.h"
 
+#include <ucs/arch/cpu.h>
 #include <ucs/sys/checker.h>
 #include <ucs/sys/sys.h>
 #include <ucs/sys/math.h>
+#include <ucs/sys/string.h>
 #include <ucs/config/parser.h>
 
-#define UCS_MAX_LOG_HANDLERS    32
+#define UCS_MAX_LOG_HANDLERS           32
+
+#define UCS_LOG_ASYNC_RING_SIZE        1024    /* Records per thread */
+#define UCS_LOG_ASYNC_MSG_MAX          256     /* Message bytes per record */
+#define UCS_LOG_ASYNC_FLUSH_INTERVAL   10000   /* Flusher period, usec */
+
+
+/*
+ * A log message staged for the background flusher. The message text is
+ * formatted by the caller (format arguments may point to transient stack
+ * buffers), only the file output is deferred.
+ */
+typedef struct ucs_log_async_record {
+    struct timeval            tv;           /* Captured at the call site */
+    const char                *file;        /* Points to a string literal */
+    unsigned                  line;
+    ucs_log_level_t           level;
+    int                       thread_num;
+    char                      msg[UCS_LOG_ASYNC_MSG_MAX];
+} ucs_log_async_record_t;
+
+
+/*
+ * Per-thread staging ring. The owning thread advances 'head', the flusher
+ * advances 'tail'. When the ring is full the message is dropped and counted,
+ * the caller is never blocked.
+ */
+typedef struct ucs_log_async_ring {
+    struct ucs_log_async_ring *next;        /* Rings list, freed at cleanup */
+    volatile uint64_t         head;
+    volatile uint64_t         tail;
+    uint64_t                  num_dropped;
+    ucs_log_async_record_t    records[UCS_LOG_ASYNC_RING_SIZE];
+} ucs_log_async_ring_t;
 
 
 const char *ucs_log_level_names[] = {
@@ -41,6 +76,12 @@ static unsigned threads_count          = 0;
 static pthread_spinlock_t threads_lock = 0;
 static pthread_t threads[128]          = {0};
 
+static __thread ucs_log_async_ring_t *ucs_log_async_ring = NULL;
+static ucs_log_async_ring_t *ucs_log_async_rings         = NULL;
+static pthread_mutex_t ucs_log_async_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t ucs_log_async_thread;
+static int ucs_log_async_thread_run       = 0;
+
 
 static int ucs_log_get_thread_num(void)
 {
@@ -75,8 +116,137 @@ unlock_and_return_i:
     return i;
 }
 
+/* Called with the async lock held */
+static void ucs_log_async_drain()
+{
+    ucs_log_async_record_t *rec;
+    ucs_log_async_ring_t *ring;
+
+    if (ucs_log_file == NULL) {
+        return;
+    }
+
+    for (ring = ucs_log_async_rings; ring != NULL; ring = ring->next) {
+        while (ring->tail != ring->head) {
+            rec = &ring->records[ring->tail % UCS_LOG_ASYNC_RING_SIZE];
+            ucs_memory_cpu_load_fence();
+            fprintf(ucs_log_file,
+                    "[%lu.%06lu] [%s:%-5d:%d] %16s:%-4u %-4s %-5s %s\n",
+                    rec->tv.tv_sec, rec->tv.tv_usec, ucs_log_hostname,
+                    ucs_log_pid, rec->thread_num, rec->file, rec->line, "UCX",
+                    ucs_log_level_names[rec->level], rec->msg);
+            ++ring->tail;
+        }
+    }
+}
+
+static void *ucs_log_async_thread_func(void *arg)
+{
+    while (ucs_log_async_thread_run) {
+        usleep(UCS_LOG_ASYNC_FLUSH_INTERVAL);
+        pthread_mutex_lock(&ucs_log_async_lock);
+        ucs_log_async_drain();
+        pthread_mutex_unlock(&ucs_log_async_lock);
+    }
+    return NULL;
+}
+
+static ucs_log_async_ring_t *ucs_log_async_ring_get()
+{
+    ucs_log_async_ring_t *ring = ucs_log_async_ring;
+
+    if (ucs_likely(ring != NULL)) {
+        return ring;
+    }
+
+    /* Plain calloc - memory tracking may log and recurse into here */
+    ring = calloc(1, sizeof(*ring));
+    if (ring == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&ucs_log_async_lock);
+    ring->next          = ucs_log_async_rings;
+    ucs_log_async_rings = ring;
+    if (!ucs_log_async_thread_run) {
+        ucs_log_async_thread_run = 1;
+        if (pthread_create(&ucs_log_async_thread, NULL,
+                           ucs_log_async_thread_func, NULL) != 0)
+        {
+            ucs_log_async_thread_run = 0;
+        }
+    }
+    pthread_mutex_unlock(&ucs_log_async_lock);
+
+    ucs_log_async_ring = ring;
+    return ring;
+}
+
+static int ucs_log_async_enqueue(const struct timeval *tv, const char *file,
+                                 unsigned line, ucs_log_level_t level,
+                                 const char *msg)
+{
+    ucs_log_async_record_t *rec;
+    ucs_log_async_ring_t *ring;
+
+    ring = ucs_log_async_ring_get();
+    if (ring == NULL) {
+        return 0; /* Fall back to synchronous output */
+    }
+
+    if (ring->head - ring->tail >= UCS_LOG_ASYNC_RING_SIZE) {
+        ++ring->num_dropped;
+        return 1;
+    }
+
+    rec             = &ring->records[ring->head % UCS_LOG_ASYNC_RING_SIZE];
+    rec->tv         = *tv;
+    rec->file       = file;
+    rec->line       = line;
+    rec->level      = level;
+    rec->thread_num = ucs_log_get_thread_num();
+    ucs_strncpy_zero(rec->msg, msg, sizeof(rec->msg));
+
+    /* Publish the record before making it visible to the flusher */
+    ucs_memory_cpu_store_fence();
+    ++ring->head;
+    return 1;
+}
+
+static void ucs_log_async_cleanup()
+{
+    ucs_log_async_ring_t *ring, *next;
+    uint64_t num_dropped = 0;
+
+    if (ucs_log_async_thread_run) {
+        ucs_log_async_thread_run = 0;
+        pthread_join(ucs_log_async_thread, NULL);
+    }
+
+    pthread_mutex_lock(&ucs_log_async_lock);
+    ucs_log_async_drain();
+    for (ring = ucs_log_async_rings; ring != NULL; ring = next) {
+        next         = ring->next;
+        num_dropped += ring->num_dropped;
+        free(ring);
+    }
+    ucs_log_async_rings = NULL;
+    pthread_mutex_unlock(&ucs_log_async_lock);
+
+    if ((num_dropped > 0) && (ucs_log_file != NULL)) {
+        fprintf(ucs_log_file, "[%s:%-5d] dropped %lu log messages\n",
+                ucs_log_hostname, ucs_log_pid, (unsigned long)num_dropped);
+    }
+}
+
 void ucs_log_flush()
 {
+    if (ucs_log_async_rings != NULL) {
+        pthread_mutex_lock(&ucs_log_async_lock);
+        ucs_log_async_drain();
+        pthread_mutex_unlock(&ucs_log_async_lock);
+    }
+
     if (ucs_log_file != NULL) {
         fflush(ucs_log_file);
         fsync(fileno(ucs_log_file));
@@ -121,11 +291,15 @@ ucs_log_default_handler(const char *file, unsigned line, const char *function,
                  short_file, line, "UCX", ucs_log_level_names[level], buf);
         VALGRIND_PRINTF("%s", valg_buf);
     } else if (ucs_log_initialized) {
-        fprintf(ucs_log_file,
-                "[%lu.%06lu] [%s:%-5d:%d] %16s:%-4u %-4s %-5s %s\n",
-                tv.tv_sec, tv.tv_usec, ucs_log_hostname, ucs_log_pid,
-                ucs_log_get_thread_num(), short_file, line, "UCX",
-                ucs_log_level_names[level], buf);
+        if (!ucs_global_opts.log_async || (level <= UCS_LOG_LEVEL_WARN) ||
+            !ucs_log_async_enqueue(&tv, short_file, line, level, buf))
+        {
+            fprintf(ucs_log_file,
+                    "[%lu.%06lu] [%s:%-5d:%d] %16s:%-4u %-4s %-5s %s\n",
+                    tv.tv_sec, tv.tv_usec, ucs_log_hostname, ucs_log_pid,
+                    ucs_log_get_thread_num(), short_file, line, "UCX",
+                    ucs_log_level_names[level], buf);
+        }
     } else {
         fprintf(stdout,
                 "[%lu.%06lu] %16s:%-4u %-4s %-5s %s\n",
@@ -354,6 +528,7 @@ void ucs_log_init()
 
 void ucs_log_cleanup()
 {
+    ucs_log_async_cleanup();
     ucs_log_flush();
     if (ucs_log_file_close) {
         fclose(ucs_log_file);
@@ -124,7 +124,7 @@ void ucs_log_flush();
 
 void __ucs_log(const char *file, unsigned line, const char *function,
                ucs_log_level_t level, const char *message, ...)
-    UCS_F_PRINTF(5, 6);
+    UCS_F_COLD UCS_F_PRINTF(5, 6);
 
 ucs_log_func_rc_t
 ucs_log_default_handler(const char *file, unsigned line, const char *function,
@@ -135,7 +135,7 @@ void __ucs_abort(const char *error_type, const char *file, unsigned line,
                  const char *function, const char *message, ...)
     UCS_F_NORETURN UCS_F_PRINTF(5, 6);
 
-void ucs_log_fatal_error(const char *fmt, ...);
+void ucs_log_fatal_error(const char *fmt, ...) UCS_F_COLD;
 
 const char *ucs_log_bitmap_to_str(unsigned n, uint8_t *bitmap, size_t length);
 
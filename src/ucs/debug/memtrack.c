@@ -25,8 +25,10 @@
 #if ENABLE_MEMTRACK
 
 #define UCS_MEMTRACK_MAGIC            0x1ee7beefa880feedULL
+#define UCS_MEMTRACK_MAGIC_UNSAMPLED  0x1ee7beefa880faceULL
 #define UCS_MEMTRACK_FORMAT_STRING    ("%22s: size: %9lu / %9lu\tcount: %9lu / %9lu\n")
 #define UCS_MEMTRACK_ENTRY_HASH_SIZE  127
+#define UCS_MEMTRACK_NUM_SHARDS       16
 
 
 typedef struct ucs_memtrack_buffer {
@@ -38,20 +40,32 @@ typedef struct ucs_memtrack_buffer {
 } ucs_memtrack_buffer_t;
 
 
-typedef struct ucs_memtrack_context {
-    int                     enabled;
+/* Independent slice of the accounting state. Threads map to shards, so
+ * unrelated threads do not contend on one global lock; the results are
+ * aggregated only when a report is requested */
+typedef struct ucs_memtrack_shard {
     pthread_mutex_t         lock;
     ucs_memtrack_entry_t    *entries[UCS_MEMTRACK_ENTRY_HASH_SIZE];
+} ucs_memtrack_shard_t;
+
+
+typedef struct ucs_memtrack_context {
+    int                     enabled;
+    int                     initialized;
+    ucs_memtrack_shard_t    shards[UCS_MEMTRACK_NUM_SHARDS];
     UCS_STATS_NODE_DECLARE(stats);
 } ucs_memtrack_context_t;
 
 
 /* Global context for tracking allocated memory */
 static ucs_memtrack_context_t ucs_memtrack_context = {
-    .enabled = 0,
-    .lock    = PTHREAD_MUTEX_INITIALIZER
+    .enabled     = 0,
+    .initialized = 0
 };
 
+/* Number of allocations to skip until the next sampled one (sampling mode) */
+static __thread unsigned ucs_memtrack_sample_skip = 0;
+
 SGLIB_DEFINE_LIST_PROTOTYPES(ucs_memtrack_entry_t, ucs_memtrack_entry_compare, next)
 SGLIB_DEFINE_HASHED_CONTAINER_PROTOTYPES(ucs_memtrack_entry_t,
                                          UCS_MEMTRACK_ENTRY_HASH_SIZE,
@@ -69,7 +83,17 @@ static ucs_stats_class_t ucs_memtrack_stats_class = {
 #endif
 
 
-static inline ucs_memtrack_entry_t* ucs_memtrack_entry_new(const char* name)
+/* Map the calling thread to a shard. This approximates per-CPU accounting
+ * without a getcpu() call on every allocation; a thread always hits the
+ * same shard, so its lock is normally uncontended */
+static inline ucs_memtrack_shard_t *ucs_memtrack_shard()
+{
+    return &ucs_memtrack_context.shards[((uintptr_t)pthread_self() >> 12) %
+                                        UCS_MEMTRACK_NUM_SHARDS];
+}
+
+static inline ucs_memtrack_entry_t*
+ucs_memtrack_entry_new(ucs_memtrack_shard_t *shard, const char* name)
 {
     ucs_memtrack_entry_t *entry;
 
@@ -82,8 +106,9 @@ static inline ucs_memtrack_entry_t* ucs_memtrack_entry_new(const char* name)
     entry->peak_size  = 0;
     entry->count      = 0;
     entry->peak_count = 0;
+    entry->shard      = shard - ucs_memtrack_context.shards;
     ucs_snprintf_zero(entry->name, UCS_MEMTRACK_NAME_MAX, "%s", name);
-    sglib_hashed_ucs_memtrack_entry_t_add(ucs_memtrack_context.entries, entry);
+    sglib_hashed_ucs_memtrack_entry_t_add(shard->entries, entry);
     return entry;
 }
 
@@ -91,6 +116,8 @@ static void ucs_memtrack_record_alloc(ucs_memtrack_buffer_t* buffer, size_t size
                                       off_t offset, const char *name)
 {
     ucs_memtrack_entry_t *entry, search;
+    ucs_memtrack_shard_t *shard;
+
     if (!ucs_memtrack_is_enabled()) {
         goto out;
     }
@@ -101,14 +128,33 @@ static void ucs_memtrack_record_alloc(ucs_memtrack_buffer_t* buffer, size_t size
     }
 
     ucs_assert(buffer != NULL);
-    ucs_assert(ucs_memtrack_context.entries != NULL); // context initialized
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
+    ucs_assert(ucs_memtrack_context.initialized);
+
+    /* In sampling mode, track only one out of every memtrack_sample
+     * allocations. The buffer still gets a header - otherwise the release
+     * path could not tell it apart - but with a magic which says it carries
+     * no accounting */
+    if (ucs_global_opts.memtrack_sample > 1) {
+        if (ucs_memtrack_sample_skip > 0) {
+            --ucs_memtrack_sample_skip;
+            buffer->magic   = UCS_MEMTRACK_MAGIC_UNSAMPLED;
+            buffer->size    = size;
+            buffer->offset  = offset;
+            buffer->entry   = NULL;
+            VALGRIND_MAKE_MEM_NOACCESS(buffer, sizeof(*buffer));
+            goto out;
+        }
+        ucs_memtrack_sample_skip = ucs_global_opts.memtrack_sample - 1;
+    }
+
+    shard = ucs_memtrack_shard();
+    pthread_mutex_lock(&shard->lock);
 
     ucs_snprintf_zero(search.name, UCS_MEMTRACK_NAME_MAX, "%s", name);
-    entry = sglib_hashed_ucs_memtrack_entry_t_find_member(ucs_memtrack_context.entries,
+    entry = sglib_hashed_ucs_memtrack_entry_t_find_member(shard->entries,
                                                           &search);
     if (entry == NULL) {
-        entry = ucs_memtrack_entry_new(name);
+        entry = ucs_memtrack_entry_new(shard, name);
         if (entry == NULL) {
             goto out_unlock;
         }
@@ -132,7 +178,7 @@ static void ucs_memtrack_record_alloc(ucs_memtrack_buffer_t* buffer, size_t size
     entry->peak_size = ucs_max(entry->peak_size, entry->size);
 
 out_unlock:
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    pthread_mutex_unlock(&shard->lock);
 out:
     UCS_EMPTY_STATEMENT;
 }
@@ -141,21 +187,35 @@ static ucs_memtrack_entry_t*
 ucs_memtrack_record_release(ucs_memtrack_buffer_t *buffer, size_t size)
 {
     ucs_memtrack_entry_t *entry;
+    ucs_memtrack_shard_t *shard;
 
     if (!ucs_memtrack_is_enabled()) {
         return NULL;
     }
 
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
     VALGRIND_MAKE_MEM_DEFINED(buffer, sizeof(*buffer));
 
+    if (buffer->magic == UCS_MEMTRACK_MAGIC_UNSAMPLED) {
+        /* This allocation was skipped by the sampling filter - nothing to
+         * account for */
+        buffer->magic = UCS_MEMTRACK_MAGIC_UNSAMPLED + 1; /* protect from double free */
+        if (size != 0) {
+            ucs_assert(buffer->size == size);
+        }
+        return NULL;
+    }
+
     ucs_assert_always(buffer->magic == UCS_MEMTRACK_MAGIC);
     buffer->magic = UCS_MEMTRACK_MAGIC + 1; /* protect from double free */
     if (size != 0) {
         ucs_assert(buffer->size == size);
     }
 
+    /* Lock the shard which tracks this allocation, which is not necessarily
+     * the releasing thread's shard */
     entry = buffer->entry;
+    shard = &ucs_memtrack_context.shards[entry->shard];
+    pthread_mutex_lock(&shard->lock);
 
     /* Update total count */
     ucs_assert(entry->count >= 1);
@@ -165,7 +225,7 @@ ucs_memtrack_record_release(ucs_memtrack_buffer_t *buffer, size_t size)
     ucs_assert(entry->size >= buffer->size);
     entry->size -= buffer->size;
 
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    pthread_mutex_unlock(&shard->lock);
     return entry;
 }
 
@@ -215,7 +275,8 @@ void *ucs_realloc(void *ptr, size_t size, const char *name)
         return NULL;
     }
 
-    ucs_memtrack_record_alloc(buffer, size, 0, entry->name);
+    ucs_memtrack_record_alloc(buffer, size, 0,
+                              (entry != NULL) ? entry->name : name);
     return buffer + 1;
 }
 
@@ -338,25 +399,48 @@ char *ucs_strdup(const char *src, const char *name)
     return str;
 }
 
+static void ucs_memtrack_lock_all()
+{
+    unsigned i;
+
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        pthread_mutex_lock(&ucs_memtrack_context.shards[i].lock);
+    }
+}
+
+static void ucs_memtrack_unlock_all()
+{
+    unsigned i;
+
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        pthread_mutex_unlock(&ucs_memtrack_context.shards[i].lock);
+    }
+}
+
+/* Aggregate the counters of all shards. Must be called with all shard locks
+ * held. The returned count includes same-name entries from different shards,
+ * so it is an upper bound on the number of distinct allocation sites */
 static unsigned ucs_memtrack_total_internal(ucs_memtrack_entry_t* total)
 {
     struct sglib_hashed_ucs_memtrack_entry_t_iterator entry_it;
     ucs_memtrack_entry_t *entry;
-    unsigned num_entries;
+    unsigned num_entries, i;
 
     ucs_memtrack_total_reset(total);
 
     num_entries          = 0;
-    for (entry = sglib_hashed_ucs_memtrack_entry_t_it_init(&entry_it,
-                                                           ucs_memtrack_context.entries);
-         entry != NULL;
-         entry = sglib_hashed_ucs_memtrack_entry_t_it_next(&entry_it))
-    {
-        total->size          += entry->size;
-        total->peak_size     += entry->peak_size;
-        total->count         += entry->count;
-        total->peak_count    += entry->peak_count;
-        ++num_entries;
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        for (entry = sglib_hashed_ucs_memtrack_entry_t_it_init(&entry_it,
+                                                               ucs_memtrack_context.shards[i].entries);
+             entry != NULL;
+             entry = sglib_hashed_ucs_memtrack_entry_t_it_next(&entry_it))
+        {
+            total->size          += entry->size;
+            total->peak_size     += entry->peak_size;
+            total->count         += entry->count;
+            total->peak_count    += entry->peak_count;
+            ++num_entries;
+        }
     }
     return num_entries;
 }
@@ -367,9 +451,9 @@ void ucs_memtrack_total(ucs_memtrack_entry_t* total)
         return;
     }
 
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
+    ucs_memtrack_lock_all();
     ucs_memtrack_total_internal(total);
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    ucs_memtrack_unlock_all();
 }
 
 static int ucs_memtrack_cmp_entries(const void *ptr1, const void *ptr2)
@@ -380,12 +464,20 @@ static int ucs_memtrack_cmp_entries(const void *ptr1, const void *ptr2)
     return (int)((ssize_t)e2->peak_size - (ssize_t)e1->peak_size);
 }
 
+static int ucs_memtrack_cmp_entries_name(const void *ptr1, const void *ptr2)
+{
+    const ucs_memtrack_entry_t *e1 = ptr1;
+    const ucs_memtrack_entry_t *e2 = ptr2;
+
+    return strcmp(e1->name, e2->name);
+}
+
 static void ucs_memtrack_dump_internal(FILE* output_stream)
 {
     struct sglib_hashed_ucs_memtrack_entry_t_iterator entry_it;
-    ucs_memtrack_entry_t *entry, *all_entries;
+    ucs_memtrack_entry_t *entry, *all_entries, *prev;
     ucs_memtrack_entry_t total = {"", 0};
-    unsigned num_entries, i;
+    unsigned num_entries, num_sites, i, shard;
 
     if (!ucs_memtrack_is_enabled()) {
         return;
@@ -402,18 +494,37 @@ static void ucs_memtrack_dump_internal(FILE* output_stream)
 
     /* Copy all entries to one array */
     i = 0;
-    for (entry = sglib_hashed_ucs_memtrack_entry_t_it_init(&entry_it,
-                                                           ucs_memtrack_context.entries);
-         entry != NULL;
-         entry = sglib_hashed_ucs_memtrack_entry_t_it_next(&entry_it))
-    {
-        all_entries[i++] = *entry;
+    for (shard = 0; shard < UCS_MEMTRACK_NUM_SHARDS; ++shard) {
+        for (entry = sglib_hashed_ucs_memtrack_entry_t_it_init(&entry_it,
+                                                               ucs_memtrack_context.shards[shard].entries);
+             entry != NULL;
+             entry = sglib_hashed_ucs_memtrack_entry_t_it_next(&entry_it))
+        {
+            all_entries[i++] = *entry;
+        }
     }
     ucs_assert(i == num_entries);
 
-    /* Sort the entries from large to small */
-    qsort(all_entries, num_entries, sizeof(ucs_memtrack_entry_t), ucs_memtrack_cmp_entries);
+    /* Merge entries of the same allocation site, which may be tracked by
+     * several shards */
+    qsort(all_entries, num_entries, sizeof(ucs_memtrack_entry_t),
+          ucs_memtrack_cmp_entries_name);
+    num_sites = 0;
     for (i = 0; i < num_entries; ++i) {
+        prev = (num_sites > 0) ? &all_entries[num_sites - 1] : NULL;
+        if ((prev != NULL) && !strcmp(prev->name, all_entries[i].name)) {
+            prev->size       += all_entries[i].size;
+            prev->peak_size  += all_entries[i].peak_size;
+            prev->count      += all_entries[i].count;
+            prev->peak_count += all_entries[i].peak_count;
+        } else {
+            all_entries[num_sites++] = all_entries[i];
+        }
+    }
+
+    /* Sort the entries from large to small */
+    qsort(all_entries, num_sites, sizeof(ucs_memtrack_entry_t), ucs_memtrack_cmp_entries);
+    for (i = 0; i < num_sites; ++i) {
         entry = &all_entries[i];
         fprintf(output_stream, UCS_MEMTRACK_FORMAT_STRING, entry->name,
                 entry->size, entry->peak_size, entry->count, entry->peak_count);
@@ -424,9 +535,9 @@ static void ucs_memtrack_dump_internal(FILE* output_stream)
 
 void ucs_memtrack_dump(FILE* output_stream)
 {
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
+    ucs_memtrack_lock_all();
     ucs_memtrack_dump_internal(output_stream);
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    ucs_memtrack_unlock_all();
 }
 
 static void ucs_memtrack_generate_report()
@@ -451,6 +562,7 @@ static void ucs_memtrack_generate_report()
 void ucs_memtrack_init()
 {
     ucs_status_t status;
+    unsigned i;
 
     ucs_assert(ucs_memtrack_context.enabled == 0);
 
@@ -460,7 +572,18 @@ void ucs_memtrack_init()
         return;
     }
 
-    sglib_hashed_ucs_memtrack_entry_t_init(ucs_memtrack_context.entries);
+    /* Initialize the shard locks only once - re-initializing a mutex which
+     * was ever locked is undefined, and init/cleanup may be cycled */
+    if (!ucs_memtrack_context.initialized) {
+        for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+            pthread_mutex_init(&ucs_memtrack_context.shards[i].lock, NULL);
+        }
+        ucs_memtrack_context.initialized = 1;
+    }
+
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        sglib_hashed_ucs_memtrack_entry_t_init(ucs_memtrack_context.shards[i].entries);
+    }
     status = UCS_STATS_NODE_ALLOC(&ucs_memtrack_context.stats,
                                   &ucs_memtrack_stats_class,
                                   ucs_stats_get_root());
@@ -476,27 +599,31 @@ void ucs_memtrack_cleanup()
 {
     struct sglib_hashed_ucs_memtrack_entry_t_iterator entry_it;
     ucs_memtrack_entry_t *entry;
+    unsigned i;
 
     if (!ucs_memtrack_context.enabled) {
         return;
     }
 
-    pthread_mutex_lock(&ucs_memtrack_context.lock);
+    ucs_memtrack_lock_all();
 
     ucs_memtrack_generate_report();
 
     /* disable before releasing the stats node */
     ucs_memtrack_context.enabled = 0;
     UCS_STATS_NODE_FREE(ucs_memtrack_context.stats);
-    for (entry = sglib_hashed_ucs_memtrack_entry_t_it_init(&entry_it,
-                                                           ucs_memtrack_context.entries);
-         entry != NULL;
-         entry = sglib_hashed_ucs_memtrack_entry_t_it_next(&entry_it))
-    {
-        sglib_hashed_ucs_memtrack_entry_t_delete(ucs_memtrack_context.entries, entry);
-        free(entry);
-    }
-    pthread_mutex_unlock(&ucs_memtrack_context.lock);
+    for (i = 0; i < UCS_MEMTRACK_NUM_SHARDS; ++i) {
+        for (entry = sglib_hashed_ucs_memtrack_entry_t_it_init(&entry_it,
+                                                               ucs_memtrack_context.shards[i].entries);
+             entry != NULL;
+             entry = sglib_hashed_ucs_memtrack_entry_t_it_next(&entry_it))
+        {
+            sglib_hashed_ucs_memtrack_entry_t_delete(ucs_memtrack_context.shards[i].entries,
+                                                     entry);
+            free(entry);
+        }
+    }
+    ucs_memtrack_unlock_all();
 }
 
 int ucs_memtrack_is_enabled()
@@ -35,6 +35,7 @@ struct ucs_memtrack_entry {
     size_t                peak_size;
     size_t                count;
     size_t                peak_count;
+    unsigned              shard;  /* Index of the shard holding this entry */
     ucs_memtrack_entry_t  *next;
 };
 
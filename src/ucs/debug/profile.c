@@ -8,9 +8,14 @@
 
 #include <ucs/sys/string.h>
 #include <ucs/sys/sys.h>
+#include <fnmatch.h>
 
 #if HAVE_PROFILING
 
+/* How many records are normalized and written at a time */
+#define UCS_PROFILE_WRITE_BATCH   256
+
+
 const char *ucs_profile_mode_names[] = {
     [UCS_PROFILE_MODE_ACCUM] = "accum",
     [UCS_PROFILE_MODE_LOG]   = "log",
@@ -19,15 +24,13 @@ const char *ucs_profile_mode_names[] = {
 
 ucs_profile_global_context_t ucs_profile_ctx = {
     .locations       = NULL,
-    .log.start       = NULL,
-    .log.end         = NULL,
-    .log.current     = NULL,
-    .log.wraparound  = 0,
-    .accum.stack_top = -1,
     .num_locations   = 0,
     .max_locations   = 0,
+    .start_time      = 0,
 };
 
+__thread ucs_profile_thread_context_t *ucs_profile_thread_ctx = NULL;
+
 static void ucs_profile_file_write_data(int fd, void *data, size_t size)
 {
     ssize_t written = write(fd, data, size);
@@ -39,14 +42,80 @@ static void ucs_profile_file_write_data(int fd, void *data, size_t size)
     }
 }
 
+/* Write a range of records, normalizing their timestamps to the profiling
+ * start time, so records of all threads share one time base */
 static void ucs_profile_file_write_records(int fd, ucs_profile_record_t *begin,
                                            ucs_profile_record_t *end)
 {
-    ucs_profile_file_write_data(fd, begin, (void*)end - (void*)begin);
+    ucs_profile_record_t batch[UCS_PROFILE_WRITE_BATCH];
+    unsigned i, count;
+
+    while (begin < end) {
+        count = ucs_min(end - begin, UCS_PROFILE_WRITE_BATCH);
+        memcpy(batch, begin, count * sizeof(*begin));
+        for (i = 0; i < count; ++i) {
+            batch[i].timestamp -= ucs_profile_ctx.start_time;
+        }
+        ucs_profile_file_write_data(fd, batch, count * sizeof(*begin));
+        begin += count;
+    }
+}
+
+static uint64_t ucs_profile_thread_num_records(ucs_profile_thread_context_t *ctx)
+{
+    if (ctx->log.start == NULL) {
+        return 0;
+    }
+    return ctx->log.wraparound ? (ctx->log.end     - ctx->log.start) :
+                                 (ctx->log.current - ctx->log.start);
+}
+
+static void ucs_profile_file_write_thread(int fd,
+                                          ucs_profile_thread_context_t *ctx)
+{
+    ucs_profile_thread_header_t thread_hdr;
+
+    memset(&thread_hdr, 0, sizeof(thread_hdr));
+    thread_hdr.tid         = ctx->tid;
+    thread_hdr.num_records = ucs_profile_thread_num_records(ctx);
+    ucs_profile_file_write_data(fd, &thread_hdr, sizeof(thread_hdr));
+
+    if (ctx->log.wraparound) {
+        ucs_profile_file_write_records(fd, ctx->log.current, ctx->log.end);
+    }
+    ucs_profile_file_write_records(fd, ctx->log.start, ctx->log.current);
+}
+
+/* Sum the per-thread accumulated data into the locations array.
+ * Called with the context lock held. */
+static void ucs_profile_accum_locations()
+{
+    ucs_profile_thread_context_t *ctx;
+    ucs_profile_location_t *loc;
+    unsigned i;
+
+    for (loc = ucs_profile_ctx.locations;
+         loc < ucs_profile_ctx.locations + ucs_profile_ctx.num_locations;
+         ++loc)
+    {
+        loc->total_time = 0;
+        loc->count      = 0;
+    }
+
+    ucs_list_for_each(ctx, &ucs_profile_ctx.threads, list) {
+        for (i = 0; i < ctx->accum.num_locations; ++i) {
+            ucs_profile_ctx.locations[i].total_time +=
+                            ctx->accum.locations[i].total_time;
+            ucs_profile_ctx.locations[i].count +=
+                            ctx->accum.locations[i].count;
+        }
+    }
 }
 
+/* Called with the context lock held */
 static void ucs_profile_write()
 {
+    ucs_profile_thread_context_t *ctx;
     ucs_profile_header_t header;
     char fullpath[1024] = {0};
     char filename[1024] = {0};
@@ -66,6 +135,8 @@ static void ucs_profile_write()
         return;
     }
 
+    ucs_profile_accum_locations();
+
     /* write header */
     memset(&header, 0, sizeof(header));
     ucs_read_file(header.cmdline, sizeof(header.cmdline), 1, "/proc/self/cmdline");
@@ -73,9 +144,12 @@ static void ucs_profile_write()
     header.pid = getpid();
     header.mode = ucs_global_opts.profile_mode;
     header.num_locations = ucs_profile_ctx.num_locations;
-    header.num_records   = ucs_profile_ctx.log.wraparound ?
-                    (ucs_profile_ctx.log.end     - ucs_profile_ctx.log.start) :
-                    (ucs_profile_ctx.log.current - ucs_profile_ctx.log.start);
+    header.num_threads   = 0;
+    header.num_records   = 0;
+    ucs_list_for_each(ctx, &ucs_profile_ctx.threads, list) {
+        ++header.num_threads;
+        header.num_records += ucs_profile_thread_num_records(ctx);
+    }
     header.one_second    = ucs_time_from_sec(1.0);
     ucs_profile_file_write_data(fd, &header, sizeof(header));
 
@@ -84,13 +158,10 @@ static void ucs_profile_write()
                                 sizeof(*ucs_profile_ctx.locations) *
                                 ucs_profile_ctx.num_locations);
 
-    /* write records */
-    if (ucs_profile_ctx.log.wraparound > 0) {
-        ucs_profile_file_write_records(fd, ucs_profile_ctx.log.current,
-                                       ucs_profile_ctx.log.end);
+    /* write per-thread records */
+    ucs_list_for_each(ctx, &ucs_profile_ctx.threads, list) {
+        ucs_profile_file_write_thread(fd, ctx);
     }
-    ucs_profile_file_write_records(fd, ucs_profile_ctx.log.start,
-                                   ucs_profile_ctx.log.current);
 
     close(fd);
 }
@@ -108,8 +179,12 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
         return;
     }
 
-    /* Location ID must be uninitialized */
-    ucs_assert(*loc_id_p == -1);
+    ucs_spin_lock(&ucs_profile_ctx.lock);
+
+    /* Check if another thread has already registered the location */
+    if (*loc_id_p != -1) {
+        goto out_unlock;
+    }
 
     location = ucs_profile_ctx.num_locations++;
 
@@ -123,7 +198,7 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
         if (ucs_profile_ctx.locations == NULL) {
             ucs_warn("failed to expand locations array");
             *loc_id_p = 0;
-            return;
+            goto out_unlock;
         }
     }
 
@@ -134,43 +209,158 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
     ucs_strncpy_zero(loc->name, name, sizeof(loc->name));
     loc->line       = line;
     loc->type       = type;
+    loc->enable     = 1;
     loc->total_time = 0;
     loc->count      = 0;
     loc->loc_id_p   = loc_id_p;
     *loc_id_p       = location + 1;
+
+out_unlock:
+    ucs_spin_unlock(&ucs_profile_ctx.lock);
 }
 
-void ucs_profile_global_init()
+void ucs_profile_set_location_enabled(const char *pattern, int enable)
 {
-    size_t num_records;
+    ucs_profile_location_t *loc;
 
     if (!ucs_global_opts.profile_mode) {
-        goto off;
+        return;
     }
 
-    if (!strlen(ucs_global_opts.profile_file)) {
-        ucs_warn("profiling file not specified, profiling is disabled");
-        goto disable;
+    ucs_spin_lock(&ucs_profile_ctx.lock);
+    for (loc = ucs_profile_ctx.locations;
+         loc < ucs_profile_ctx.locations + ucs_profile_ctx.num_locations;
+         ++loc)
+    {
+        if (!fnmatch(pattern, loc->name, 0) ||
+            !fnmatch(pattern, loc->function, 0))
+        {
+            loc->enable = !!enable;
+        }
     }
+    ucs_spin_unlock(&ucs_profile_ctx.lock);
+}
+
+static void ucs_profile_thread_key_destructor(void *arg)
+{
+    ucs_profile_thread_context_t *ctx = arg;
+
+    /* The context is kept on the list so its records survive until the next
+     * dump; it is released there */
+    ctx->is_completed = 1;
+}
+
+ucs_profile_thread_context_t *ucs_profile_thread_init()
+{
+    ucs_profile_thread_context_t *ctx;
+    size_t num_records;
+    int ret;
+
+    ctx = ucs_calloc(1, sizeof(*ctx), "profile_thread");
+    if (ctx == NULL) {
+        ucs_warn("failed to allocate profiling thread context");
+        return NULL;
+    }
+
+    ctx->pthread_id      = pthread_self();
+    ctx->tid             = ucs_get_tid();
+    ctx->accum.stack_top = -1;
 
     if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        num_records = ucs_global_opts.profile_log_size / sizeof(ucs_profile_record_t);
-        ucs_profile_ctx.log.start = ucs_calloc(num_records,
-                                               sizeof(ucs_profile_record_t),
-                                               "profile_log");
-        if (ucs_profile_ctx.log.start == NULL) {
+        num_records = ucs_global_opts.profile_log_size /
+                      sizeof(ucs_profile_record_t);
+        ctx->log.start = ucs_calloc(num_records, sizeof(ucs_profile_record_t),
+                                    "profile_log");
+        if (ctx->log.start == NULL) {
             ucs_warn("failed to allocate profiling log");
-            goto disable;
+            goto err_free;
         }
 
-        ucs_profile_ctx.log.end     = ucs_profile_ctx.log.start + num_records;
-        ucs_profile_ctx.log.current = ucs_profile_ctx.log.start;
+        ctx->log.end     = ctx->log.start + num_records;
+        ctx->log.current = ctx->log.start;
+    }
+
+    ret = pthread_setspecific(ucs_profile_ctx.tcontext_key, ctx);
+    if (ret != 0) {
+        ucs_warn("pthread_setspecific() failed: %m");
+        goto err_free_log;
     }
 
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        ucs_profile_ctx.accum.stack_top = -1;
+    ucs_spin_lock(&ucs_profile_ctx.lock);
+    ucs_list_add_tail(&ucs_profile_ctx.threads, &ctx->list);
+    ucs_spin_unlock(&ucs_profile_ctx.lock);
+
+    ucs_profile_thread_ctx = ctx;
+    return ctx;
+
+err_free_log:
+    ucs_free(ctx->log.start);
+err_free:
+    ucs_free(ctx);
+    return NULL;
+}
+
+ucs_profile_thread_location_t *
+ucs_profile_thread_accum_grow(ucs_profile_thread_context_t *ctx, int loc_id)
+{
+    ucs_profile_thread_location_t *locations;
+    unsigned num_locations;
+
+    num_locations = ucs_max(loc_id, 2 * ctx->accum.num_locations);
+    locations     = ucs_realloc(ctx->accum.locations,
+                                sizeof(*locations) * num_locations,
+                                "profile_accum");
+    if (locations == NULL) {
+        ucs_warn("failed to expand per-thread accumulated data array");
+        return NULL;
     }
 
+    memset(locations + ctx->accum.num_locations, 0,
+           sizeof(*locations) * (num_locations - ctx->accum.num_locations));
+    ctx->accum.locations     = locations;
+    ctx->accum.num_locations = num_locations;
+    return &locations[loc_id - 1];
+}
+
+static void ucs_profile_thread_free(ucs_profile_thread_context_t *ctx)
+{
+    ucs_list_del(&ctx->list);
+    ucs_free(ctx->accum.locations);
+    ucs_free(ctx->log.start);
+    ucs_free(ctx);
+}
+
+/* Release contexts of threads which exited since the previous dump.
+ * Called with the context lock held. */
+static void ucs_profile_cleanup_completed_threads()
+{
+    ucs_profile_thread_context_t *ctx, *tmp;
+
+    ucs_list_for_each_safe(ctx, tmp, &ucs_profile_ctx.threads, list) {
+        if (ctx->is_completed) {
+            ucs_profile_thread_free(ctx);
+        }
+    }
+}
+
+void ucs_profile_global_init()
+{
+    ucs_spinlock_init(&ucs_profile_ctx.lock);
+    ucs_list_head_init(&ucs_profile_ctx.threads);
+    pthread_key_create(&ucs_profile_ctx.tcontext_key,
+                       ucs_profile_thread_key_destructor);
+
+    if (!ucs_global_opts.profile_mode) {
+        goto off;
+    }
+
+    if (!strlen(ucs_global_opts.profile_file)) {
+        ucs_warn("profiling file not specified, profiling is disabled");
+        goto disable;
+    }
+
+    ucs_profile_ctx.start_time = ucs_get_time();
+
     ucs_info("profiling is enabled");
     return;
 
@@ -199,33 +389,42 @@ static void ucs_profile_reset_locations()
 
 void ucs_profile_global_cleanup()
 {
+    ucs_profile_thread_context_t *ctx, *tmp;
+
+    ucs_spin_lock(&ucs_profile_ctx.lock);
     ucs_profile_write();
-    ucs_free(ucs_profile_ctx.log.start);
-    ucs_profile_ctx.log.start      = NULL;
-    ucs_profile_ctx.log.end        = NULL;
-    ucs_profile_ctx.log.current    = NULL;
-    ucs_profile_ctx.log.wraparound = 0;
+    ucs_list_for_each_safe(ctx, tmp, &ucs_profile_ctx.threads, list) {
+        ucs_profile_thread_free(ctx);
+    }
+    ucs_profile_thread_ctx = NULL;
     ucs_profile_reset_locations();
+    ucs_spin_unlock(&ucs_profile_ctx.lock);
+
+    pthread_key_delete(ucs_profile_ctx.tcontext_key);
+    ucs_spinlock_destroy(&ucs_profile_ctx.lock);
 }
 
 void ucs_profile_dump()
 {
-    ucs_profile_location_t *loc;
+    ucs_profile_thread_context_t *ctx;
+    unsigned i;
 
+    ucs_spin_lock(&ucs_profile_ctx.lock);
     ucs_profile_write();
 
-    for (loc = ucs_profile_ctx.locations;
-         loc < ucs_profile_ctx.locations + ucs_profile_ctx.num_locations;
-         ++loc)
-    {
-        loc->count      = 0;
-        loc->total_time = 0;
+    ucs_list_for_each(ctx, &ucs_profile_ctx.threads, list) {
+        for (i = 0; i < ctx->accum.num_locations; ++i) {
+            ctx->accum.locations[i].total_time = 0;
+            ctx->accum.locations[i].count      = 0;
+        }
+        if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+            ctx->log.wraparound = 0;
+            ctx->log.current    = ctx->log.start;
+        }
     }
 
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
-        ucs_profile_ctx.log.wraparound = 0;
-        ucs_profile_ctx.log.current    = ucs_profile_ctx.log.start;
-    }
+    ucs_profile_cleanup_completed_threads();
+    ucs_spin_unlock(&ucs_profile_ctx.lock);
 }
 
 #else
@@ -242,4 +441,8 @@ void ucs_profile_dump()
 {
 }
 
+void ucs_profile_set_location_enabled(const char *pattern, int enable)
+{
+}
+
 #endif
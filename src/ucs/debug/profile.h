@@ -11,9 +11,12 @@
 #  include "config.h"
 #endif
 
+#include <ucs/datastruct/list.h>
 #include <ucs/sys/preprocessor.h>
 #include <ucs/time/time.h>
+#include <ucs/type/spinlock.h>
 #include <ucs/debug/log.h>
+#include <pthread.h>
 
 
 #define UCS_PROFILE_STACK_MAX 64
@@ -52,11 +55,25 @@ typedef struct ucs_profile_header {
     uint32_t                 pid;           /**< Process ID */
     uint32_t                 mode;          /**< Profiling mode */
     uint32_t                 num_locations; /**< Number of locations in the file */
-    uint64_t                 num_records;   /**< Number of records in the file */
+    uint32_t                 num_threads;   /**< Number of threads in the file */
+    uint64_t                 num_records;   /**< Total number of records in the file */
     uint64_t                 one_second;    /**< How much time is one second on the sampled machine */
 } UCS_S_PACKED ucs_profile_header_t;
 
 
+/**
+ * Profile output file thread header. The file contains one section per thread,
+ * each made of this header followed by the thread's records. Record timestamps
+ * are normalized to the profiling start time, so records of different threads
+ * are directly comparable.
+ */
+typedef struct ucs_profile_thread_header {
+    uint32_t                 tid;           /**< System thread id */
+    uint32_t                 reserved;      /**< Reserved for future use */
+    uint64_t                 num_records;   /**< Number of records for the thread */
+} UCS_S_PACKED ucs_profile_thread_header_t;
+
+
 /**
  * Profile output file sample record
  */
@@ -78,31 +95,64 @@ typedef struct ucs_profile_location {
     int                      *loc_id_p;     /**< Back-pointer for location ID */
     int                      line;          /**< Source line number */
     uint8_t                  type;          /**< From ucs_profile_type_t */
+    volatile uint8_t         enable;        /**< Whether the location is recorded */
     uint64_t                 total_time;    /**< Total interval from previous location */
     size_t                   count;         /**< Number of times we've hit this location */
 } UCS_S_PACKED ucs_profile_location_t;
 
 
 /**
- * Profiling global context
+ * Per-thread accumulated data of a single location
  */
-typedef struct ucs_profile_global_context {
+typedef struct ucs_profile_thread_location {
+    ucs_time_t               total_time;    /**< Total interval from previous location */
+    size_t                   count;         /**< Number of times we've hit this location */
+} ucs_profile_thread_location_t;
 
-    ucs_profile_location_t   *locations;    /**< Array of all locations */
-    unsigned                 num_locations; /**< Number of valid locations */
-    unsigned                 max_locations; /**< Size of locations array */
+
+/**
+ * Per-thread profiling context. Each thread records into its own log ring, so
+ * the fast path makes no shared writes and needs no locking; the contexts are
+ * collected and written out at dump time.
+ */
+typedef struct ucs_profile_thread_context {
+    pthread_t                pthread_id;    /**< POSIX thread id */
+    uint32_t                 tid;           /**< System thread id */
+    int                      is_completed;  /**< Set when the thread exits */
+    ucs_list_link_t          list;          /**< Entry in the list of threads */
 
     struct {
         ucs_profile_record_t *start, *end;  /**< Circular log buffer */
         ucs_profile_record_t *current;      /**< Current log pointer */
         int                  wraparound;    /**< Whether log was rotated */
+        int                  skip_depth;    /**< Nesting level of a sampled-out scope */
+        unsigned             sample_count;  /**< Events since the last sampled one */
     } log;
 
     struct {
+        ucs_profile_thread_location_t *locations; /**< Per-location data */
+        unsigned             num_locations; /**< Size of locations array */
         int                  stack_top;     /**< Index of stack top */
         ucs_time_t           stack[UCS_PROFILE_STACK_MAX]; /**< Timestamps for each nested scope */
     } accum;
 
+} ucs_profile_thread_context_t;
+
+
+/**
+ * Profiling global context
+ */
+typedef struct ucs_profile_global_context {
+
+    ucs_profile_location_t   *locations;    /**< Array of all locations */
+    unsigned                 num_locations; /**< Number of valid locations */
+    unsigned                 max_locations; /**< Size of locations array */
+
+    ucs_spinlock_t           lock;          /**< Protects locations and thread list */
+    ucs_time_t               start_time;    /**< Base for timestamp normalization */
+    ucs_list_link_t          threads;       /**< List of all thread contexts */
+    pthread_key_t            tcontext_key;  /**< Detects thread exit */
+
 } ucs_profile_global_context_t;
 
 
@@ -124,6 +174,17 @@ void ucs_profile_global_cleanup();
 void ucs_profile_dump();
 
 
+/**
+ * Enable or disable recording of profiling locations at runtime, so the
+ * profiler can be left compiled in and flipped on when needed.
+ *
+ * @param [in]  pattern  Glob pattern matched against the location name and
+ *                       function name.
+ * @param [in]  enable   Nonzero to enable matching locations, 0 to disable.
+ */
+void ucs_profile_set_location_enabled(const char *pattern, int enable);
+
+
 #if HAVE_PROFILING
 
 extern const char *ucs_profile_mode_names[];
@@ -147,6 +208,32 @@ void ucs_profile_get_location(ucs_profile_type_t type, const char *name,
                               int *loc_id_p);
 
 
+/*
+ * Create and register the profiling context of the calling thread.
+ * Should not be used directly.
+ *
+ * @return Thread context, or NULL if it could not be allocated.
+ */
+ucs_profile_thread_context_t *ucs_profile_thread_init();
+
+
+/*
+ * Grow the per-thread accumulated data array to cover the given location.
+ * Should not be used directly.
+ *
+ * @param [in]  ctx       Thread context.
+ * @param [in]  loc_id    Location ID (location index + 1).
+ *
+ * @return Per-thread location data, or NULL if it could not be allocated.
+ */
+ucs_profile_thread_location_t *
+ucs_profile_thread_accum_grow(ucs_profile_thread_context_t *ctx, int loc_id);
+
+
+/* Calling thread's profiling context, created on its first record */
+extern __thread ucs_profile_thread_context_t *ucs_profile_thread_ctx;
+
+
 /*
  * Store a new record with the given data.
  * Should not be used directly - use UCS_PROFILE macros instead.
@@ -166,9 +253,9 @@ static inline void ucs_profile_record(ucs_profile_type_t type, const char *name,
                                       const char *function, int *loc_id_p)
 {
     extern ucs_profile_global_context_t ucs_profile_ctx;
-    ucs_profile_global_context_t *ctx = &ucs_profile_ctx;
-    ucs_profile_record_t   *rec;
-    ucs_profile_location_t *loc;
+    ucs_profile_thread_context_t  *ctx;
+    ucs_profile_thread_location_t *accum;
+    ucs_profile_record_t *rec;
     ucs_time_t current_time;
     int loc_id;
 
@@ -183,25 +270,75 @@ retry:
         goto retry;
     }
 
+    if (ucs_unlikely(!ucs_profile_ctx.locations[loc_id - 1].enable)) {
+        return;
+    }
+
+    ctx = ucs_profile_thread_ctx;
+    if (ucs_unlikely(ctx == NULL)) {
+        ctx = ucs_profile_thread_init();
+        if (ctx == NULL) {
+            return;
+        }
+    }
+
     current_time = ucs_get_time();
     if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_ACCUM)) {
-        loc              = &ctx->locations[loc_id - 1];
+        accum = (ucs_unlikely((unsigned)loc_id > ctx->accum.num_locations)) ?
+                ucs_profile_thread_accum_grow(ctx, loc_id) :
+                &ctx->accum.locations[loc_id - 1];
+        if (ucs_likely(accum != NULL)) {
+            switch (type) {
+            case UCS_PROFILE_TYPE_SCOPE_BEGIN:
+                ctx->accum.stack[++ctx->accum.stack_top] = current_time;
+                ucs_assert(ctx->accum.stack_top < UCS_PROFILE_STACK_MAX);
+                break;
+            case UCS_PROFILE_TYPE_SCOPE_END:
+                ucs_assert(ctx->accum.stack_top >= 0);
+                accum->total_time += current_time -
+                                     ctx->accum.stack[ctx->accum.stack_top];
+                --ctx->accum.stack_top;
+                break;
+            default:
+                break;
+            }
+            ++accum->count;
+        }
+    }
+    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+        /* A sampled-out scope begin suppresses its whole subtree, so the log
+         * stays well-formed when the divisor is larger than 1 */
         switch (type) {
         case UCS_PROFILE_TYPE_SCOPE_BEGIN:
-            ctx->accum.stack[++ctx->accum.stack_top] = current_time;
-            ucs_assert(ctx->accum.stack_top < UCS_PROFILE_STACK_MAX);
+            if (ucs_unlikely(ctx->log.skip_depth > 0)) {
+                ++ctx->log.skip_depth;
+                return;
+            }
+            if (ucs_unlikely(++ctx->log.sample_count <
+                             ucs_global_opts.profile_sample)) {
+                ctx->log.skip_depth = 1;
+                return;
+            }
+            ctx->log.sample_count = 0;
             break;
         case UCS_PROFILE_TYPE_SCOPE_END:
-            ucs_assert(ctx->accum.stack_top >= 0);
-            loc->total_time += current_time - ctx->accum.stack[ctx->accum.stack_top];
-            --ctx->accum.stack_top;
+            if (ucs_unlikely(ctx->log.skip_depth > 0)) {
+                --ctx->log.skip_depth;
+                return;
+            }
             break;
         default:
+            if (ucs_unlikely(ctx->log.skip_depth > 0)) {
+                return;
+            }
+            if (ucs_unlikely(++ctx->log.sample_count <
+                             ucs_global_opts.profile_sample)) {
+                return;
+            }
+            ctx->log.sample_count = 0;
             break;
         }
-        ++loc->count;
-    }
-    if (ucs_global_opts.profile_mode & UCS_BIT(UCS_PROFILE_MODE_LOG)) {
+
         rec              = ctx->log.current;
         rec->timestamp   = current_time;
         rec->param64     = param64;
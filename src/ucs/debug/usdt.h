@@ -0,0 +1,45 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCS_USDT_H_
+#define UCS_USDT_H_
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+/*
+ * Static tracepoints under the "ucx" provider, for perf/bpftrace/systemtap.
+ * Unlike the UCS_PROFILE machinery, these are present in production builds:
+ * each probe compiles to a single nop plus an ELF note, and costs nothing
+ * until a tracer attaches to it. For example, to histogram eager send sizes
+ * on a live process:
+ *
+ *   bpftrace -e 'usdt:libucp.so:ucx:tag_send_start { @ = hist(arg2); }'
+ *
+ * Probe arguments must be side-effect free - they are not evaluated when
+ * sys/sdt.h is unavailable.
+ */
+
+#if HAVE_SYS_SDT_H
+
+#include <sys/sdt.h>
+
+#define UCS_USDT_PROBE1(_name, _a)             DTRACE_PROBE1(ucx, _name, _a)
+#define UCS_USDT_PROBE2(_name, _a, _b)         DTRACE_PROBE2(ucx, _name, _a, _b)
+#define UCS_USDT_PROBE3(_name, _a, _b, _c)     DTRACE_PROBE3(ucx, _name, _a, _b, _c)
+#define UCS_USDT_PROBE4(_name, _a, _b, _c, _d) DTRACE_PROBE4(ucx, _name, _a, _b, _c, _d)
+
+#else
+
+#define UCS_USDT_PROBE1(_name, _a)
+#define UCS_USDT_PROBE2(_name, _a, _b)
+#define UCS_USDT_PROBE3(_name, _a, _b, _c)
+#define UCS_USDT_PROBE4(_name, _a, _b, _c, _d)
+
+#endif
+
+#endif
@@ -28,9 +28,14 @@
 #include <ucs/debug/log.h>
 
 #define UCS_STATS_MAGIC            "UCSSTAT1"
+#define UCS_STATS_DELTA_MAGIC      "UCSSTDL1"
 #define UCS_STATS_MSG_FRAG_SIZE    1400
 #define ENTITY_HASH_SIZE           997
 
+/* How many delta reports may follow a full dump. The periodic full dump
+ * re-establishes the dictionary and recovers from lost delta packets. */
+#define UCS_STATS_DELTA_RESYNC     64
+
 
 /* UDP packet header */
 typedef struct ucs_stats_packet_hdr {
@@ -57,18 +62,37 @@ struct stats_entity {
     size_t              buffer_size;    /* Buffer size */
     void                *inprogress_buffer;    /* Fragment assembly buffer */
     ucs_list_link_t     holes;          /* List of holes in the buffer */
+    int                 is_delta;       /* Current assembly is a delta report */
     stats_entity_t      *next;          /* Hash link */
 
     pthread_mutex_t     lock;
     volatile unsigned   refcount;
     void                *completed_buffer;  /* Completed buffer */
+    size_t              completed_size; /* Valid bytes in completed buffer */
+    size_t              completed_alloc;/* Allocated bytes in completed buffer */
     struct timeval      update_time;
+
+    /* Delta streaming state: the last full dump, deserialized, with the
+     * arriving deltas applied to it, and a flat view of its counters in
+     * serialization order for applying (index, delta) updates. */
+    ucs_stats_node_t    *delta_root;
+    ucs_stats_counter_t **counter_map;
+    unsigned            num_counters;
+    uint64_t            delta_timestamp; /* Timestamp delta_root represents */
 };
 
 
 /* Client context */
 typedef struct ucs_stats_client {
-    int              sockfd;
+    int                 sockfd;
+
+    /* Delta streaming state. A full dump doubles as the dictionary handshake;
+     * afterwards only (index, delta) varint pairs of the changed counters are
+     * sent, against this snapshot of the previously reported values. */
+    ucs_stats_counter_t *prev_counters;    /* values of the last report */
+    unsigned            num_counters;      /* snapshot length, 0 - no snapshot */
+    uint64_t            prev_timestamp;    /* timestamp of the last report */
+    unsigned            resync_countdown;  /* deltas until the next full dump */
 } ucs_stats_client_t;
 
 
@@ -103,6 +127,11 @@ ucs_status_t ucs_stats_client_init(const char *server_addr, int port, ucs_stats_
         goto err;
     }
 
+    client->prev_counters    = NULL;
+    client->num_counters     = 0;
+    client->prev_timestamp   = 0;
+    client->resync_countdown = 0;
+
     he = gethostbyname(server_addr);
     if (he == NULL || he->h_addr_list == NULL) {
         ucs_error("failed to resolve address of '%s'", server_addr);
@@ -144,11 +173,13 @@ err:
 void ucs_stats_client_cleanup(ucs_stats_client_h client)
 {
     close(client->sockfd);
+    free(client->prev_counters);
     free(client);
 }
 
 static ucs_status_t
-ucs_stats_sock_send_frags(int sockfd, uint64_t timestamp, void *buffer, size_t size)
+ucs_stats_sock_send_frags(int sockfd, const char *magic, uint64_t timestamp,
+                          void *buffer, size_t size)
 {
     struct iovec iov[2];
     ucs_stats_packet_hdr_t hdr;
@@ -157,7 +188,7 @@ ucs_stats_sock_send_frags(int sockfd, uint64_t timestamp, void *buffer, size_t s
 
     offset = 0;
 
-    memcpy(hdr.magic, UCS_STATS_MAGIC, sizeof(hdr.magic));
+    memcpy(hdr.magic, magic, sizeof(hdr.magic));
     hdr.total_size  = size;
     hdr.timestamp   = timestamp;
 
@@ -193,6 +224,71 @@ ucs_stats_sock_send_frags(int sockfd, uint64_t timestamp, void *buffer, size_t s
     return UCS_OK;
 }
 
+/*
+ * Send the changed counters as a delta report against the last report. The
+ * client-side snapshot is advanced by the serializer, so consecutive deltas
+ * chain; if the tree changed shape, fall back to a full dump which also
+ * refreshes the server-side dictionary.
+ */
+static ucs_status_t
+ucs_stats_client_send_delta(ucs_stats_client_h client, ucs_stats_node_t *root,
+                            uint64_t timestamp)
+{
+    ucs_status_t status;
+    FILE *stream;
+    char *buffer;
+    size_t size;
+
+    if ((client->num_counters == 0) || (client->resync_countdown == 0) ||
+        (ucs_stats_num_counters(root) != client->num_counters)) {
+        return UCS_ERR_INVALID_PARAM; /* Full dump required */
+    }
+
+    stream = open_memstream(&buffer, &size);
+    if (stream == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    status = ucs_stats_serialize_delta(stream, root, client->prev_counters,
+                                       client->num_counters,
+                                       client->prev_timestamp);
+    fclose(stream);
+
+    if (status == UCS_OK) {
+        status = ucs_stats_sock_send_frags(client->sockfd,
+                                           UCS_STATS_DELTA_MAGIC, timestamp,
+                                           buffer, size);
+        client->prev_timestamp = timestamp;
+        --client->resync_countdown;
+    }
+
+    free(buffer);
+    return status;
+}
+
+/* (Re)take the client-side snapshot the following deltas will be based on */
+static void ucs_stats_client_snapshot(ucs_stats_client_h client,
+                                      ucs_stats_node_t *root,
+                                      uint64_t timestamp)
+{
+    unsigned num_counters = ucs_stats_num_counters(root);
+
+    if (num_counters != client->num_counters) {
+        free(client->prev_counters);
+        client->prev_counters = malloc(num_counters *
+                                       sizeof(*client->prev_counters));
+        if (client->prev_counters == NULL) {
+            client->num_counters = 0;
+            return;
+        }
+        client->num_counters = num_counters;
+    }
+
+    ucs_stats_snapshot_counters(root, client->prev_counters);
+    client->prev_timestamp   = timestamp;
+    client->resync_countdown = UCS_STATS_DELTA_RESYNC;
+}
+
 ucs_status_t
 ucs_stats_client_send(ucs_stats_client_h client, ucs_stats_node_t *root,
                       uint64_t timestamp)
@@ -202,6 +298,14 @@ ucs_stats_client_send(ucs_stats_client_h client, ucs_stats_node_t *root,
     char *buffer;
     size_t size;
 
+    if (ucs_global_opts.stats_delta) {
+        status = ucs_stats_client_send_delta(client, root, timestamp);
+        if (status != UCS_ERR_INVALID_PARAM) {
+            return status;
+        }
+        /* Cannot send incrementally - fall through to a full dump */
+    }
+
     /* TODO use GLIBC custom stream */
     stream = open_memstream(&buffer, &size);
     if (stream == NULL) {
@@ -217,7 +321,14 @@ ucs_stats_client_send(ucs_stats_client_h client, ucs_stats_node_t *root,
     }
 
     /* send */
-    status = ucs_stats_sock_send_frags(client->sockfd, timestamp, buffer, size);
+    status = ucs_stats_sock_send_frags(client->sockfd, UCS_STATS_MAGIC,
+                                       timestamp, buffer, size);
+
+    if ((status == UCS_OK) && ucs_global_opts.stats_delta) {
+        /* The counters may tick between the serialization walk and this one;
+         * the skew is corrected by the next periodic full dump. */
+        ucs_stats_client_snapshot(client, root, timestamp);
+    }
 
 out_free:
     free(buffer);
@@ -237,6 +348,10 @@ static void ucs_stats_server_entity_reset_buffer(stats_entity_t * entity,
                                             new_size + sizeof(frag_hole_t));
         entity->completed_buffer  = realloc(entity->completed_buffer,
                                             new_size + sizeof(frag_hole_t));
+        entity->completed_alloc   = new_size + sizeof(frag_hole_t);
+        if (entity->completed_size > entity->completed_alloc) {
+            entity->completed_size = 0; /* Stale image of a larger report */
+        }
         pthread_mutex_unlock(&entity->lock);
     }
 
@@ -259,7 +374,14 @@ static stats_entity_t *ucs_stats_server_entity_alloc(struct sockaddr_in *addr)
     entity->timestamp         = 0;
     entity->buffer_size       = -1;
     entity->inprogress_buffer = NULL;
+    entity->is_delta          = 0;
     entity->completed_buffer  = NULL;
+    entity->completed_size    = 0;
+    entity->completed_alloc   = 0;
+    entity->delta_root        = NULL;
+    entity->counter_map       = NULL;
+    entity->num_counters      = 0;
+    entity->delta_timestamp   = 0;
     entity->refcount          = 1;
     ucs_list_head_init(&entity->holes);
     pthread_mutex_init(&entity->lock, NULL);
@@ -270,6 +392,10 @@ static stats_entity_t *ucs_stats_server_entity_alloc(struct sockaddr_in *addr)
 
 static void ucs_stats_server_entity_free(stats_entity_t * entity)
 {
+    if (entity->delta_root != NULL) {
+        ucs_stats_free(entity->delta_root);
+    }
+    free(entity->counter_map);
     free(entity->inprogress_buffer);
     free(entity->completed_buffer);
     free(entity);
@@ -321,13 +447,168 @@ find_frag_hole(stats_entity_t *entity, size_t frag_size, size_t frag_offset)
     return NULL;
 }
 
+/* Walk the tree the way the counters are numbered on the wire and collect
+ * pointers to them, so delta updates can be applied by index. */
+static unsigned
+ucs_stats_server_map_counters_recurs(ucs_stats_node_t *node,
+                                     ucs_stats_counter_t **map, unsigned index)
+{
+    ucs_stats_node_t *child;
+    unsigned i;
+
+    for (i = 0; i < node->cls->num_counters; ++i) {
+        map[index++] = &node->counters[i];
+    }
+
+    ucs_list_for_each(child, &node->children[UCS_STATS_ACTIVE_CHILDREN], list) {
+        index = ucs_stats_server_map_counters_recurs(child, map, index);
+    }
+
+    return index;
+}
+
+/**
+ * A fully assembled dump becomes the baseline the following delta reports are
+ * applied to. Deserialization preserves the child order, so the counters are
+ * numbered the same way the sender numbered them.
+ */
+static void ucs_stats_server_entity_set_baseline(stats_entity_t *entity)
+{
+    ucs_stats_node_t *root;
+    ucs_status_t status;
+    FILE *stream;
+
+    if (entity->delta_root != NULL) {
+        ucs_stats_free(entity->delta_root);
+        entity->delta_root = NULL;
+    }
+    free(entity->counter_map);
+    entity->counter_map  = NULL;
+    entity->num_counters = 0;
+
+    stream = fmemopen(entity->inprogress_buffer, entity->buffer_size, "rb");
+    if (stream == NULL) {
+        return;
+    }
+
+    status = ucs_stats_deserialize(stream, &root);
+    fclose(stream);
+    if (status != UCS_OK) {
+        return;
+    }
+
+    entity->num_counters = ucs_stats_num_counters(root);
+    entity->counter_map  = malloc(entity->num_counters *
+                                  sizeof(*entity->counter_map));
+    if (entity->counter_map == NULL) {
+        ucs_stats_free(root);
+        entity->num_counters = 0;
+        return;
+    }
+
+    ucs_stats_server_map_counters_recurs(root, entity->counter_map, 0);
+    entity->delta_root      = root;
+    entity->delta_timestamp = entity->timestamp;
+}
+
+/**
+ * Apply a fully assembled delta report to the baseline tree, and refresh the
+ * completed buffer with its re-serialized image. A malformed or out-of-sync
+ * report (e.g. after a lost packet) is dropped - the next periodic full dump
+ * resynchronizes.
+ */
+static void ucs_stats_server_entity_apply_delta(stats_entity_t *entity)
+{
+    ucs_stats_delta_header_t *hdr = entity->inprogress_buffer;
+    uint64_t gap, value;
+    size_t avail, len, size;
+    unsigned i, index;
+    ucs_status_t status;
+    char *buffer;
+    FILE *stream;
+    void *pos;
+
+    if (entity->buffer_size < sizeof(*hdr)) {
+        ucs_error("Invalid delta report size %Zu", entity->buffer_size);
+        return;
+    }
+
+    if (hdr->version != 1) {
+        ucs_error("Invalid delta report version");
+        return;
+    }
+
+    if ((entity->delta_root == NULL) ||
+        (hdr->base_timestamp != entity->delta_timestamp)) {
+        ucs_debug("Dropping out-of-sync delta report");
+        return;
+    }
+
+    pos   = hdr + 1;
+    avail = entity->buffer_size - sizeof(*hdr);
+    index = 0;
+
+    for (i = 0; i < hdr->num_updates; ++i) {
+        len = ucs_stats_varint_unpack(pos, avail, &gap);
+        if (len == 0) {
+            goto err_truncated;
+        }
+        pos   += len;
+        avail -= len;
+
+        len = ucs_stats_varint_unpack(pos, avail, &value);
+        if (len == 0) {
+            goto err_truncated;
+        }
+        pos   += len;
+        avail -= len;
+
+        index += gap;
+        if (index >= entity->num_counters) {
+            ucs_error("Delta report counter index out of range");
+            return;
+        }
+        *entity->counter_map[index] += ucs_stats_zigzag_decode(value);
+    }
+
+    entity->delta_timestamp = entity->timestamp;
+
+    stream = open_memstream(&buffer, &size);
+    if (stream == NULL) {
+        return;
+    }
+
+    status = ucs_stats_serialize(stream, entity->delta_root,
+                                 UCS_STATS_SERIALIZE_BINARY);
+    fclose(stream);
+    if (status != UCS_OK) {
+        free(buffer);
+        return;
+    }
+
+    pthread_mutex_lock(&entity->lock);
+    if (size > entity->completed_alloc) {
+        entity->completed_buffer = realloc(entity->completed_buffer, size);
+        entity->completed_alloc  = size;
+    }
+    memcpy(entity->completed_buffer, buffer, size);
+    entity->completed_size = size;
+    pthread_mutex_unlock(&entity->lock);
+
+    free(buffer);
+    return;
+
+err_truncated:
+    ucs_error("Truncated delta report");
+}
+
 /**
  * Update statistics with new arrived fragment.
  */
 static ucs_status_t
 ucs_stats_server_entity_update(ucs_stats_server_h server, stats_entity_t *entity,
                                uint64_t timestamp, size_t total_size, void *frag,
-                               size_t frag_size, size_t frag_offset)
+                               size_t frag_size, size_t frag_offset, int is_delta)
 {
     frag_hole_t *hole, *new_hole;
     void *frag_start, *frag_end, *hole_end;
@@ -342,6 +623,7 @@ ucs_stats_server_entity_update(ucs_stats_server_h server, stats_entity_t *entity
     } else if (timestamp > entity->timestamp) {
         ucs_debug("New timestamp, resetting buffer with size %Zu", total_size);
         entity->timestamp = timestamp;
+        entity->is_delta  = is_delta;
         ucs_stats_server_entity_reset_buffer(entity, total_size);
     } else {
         /* Make sure all packets in this timestamp have the same 'total_size' */
@@ -393,9 +675,16 @@ ucs_stats_server_entity_update(ucs_stats_server_h server, stats_entity_t *entity
     /* Completed? */
     if (ucs_list_is_empty(&entity->holes)) {
         ucs_debug("timestamp %"PRIu64" fully assembled", entity->timestamp);
-        pthread_mutex_lock(&entity->lock);
-        memcpy(entity->completed_buffer, entity->inprogress_buffer, entity->buffer_size);
-        pthread_mutex_unlock(&entity->lock);
+        if (entity->is_delta) {
+            ucs_stats_server_entity_apply_delta(entity);
+        } else {
+            pthread_mutex_lock(&entity->lock);
+            memcpy(entity->completed_buffer, entity->inprogress_buffer,
+                   entity->buffer_size);
+            entity->completed_size = entity->buffer_size;
+            pthread_mutex_unlock(&entity->lock);
+            ucs_stats_server_entity_set_baseline(entity);
+        }
     }
 
     return UCS_OK;
@@ -410,6 +699,7 @@ ucs_stats_server_update_context(ucs_stats_server_h server, struct sockaddr_in *s
 {
     stats_entity_t *entity;
     ucs_status_t status;
+    int is_delta;
 
     /* Validate fragment size */
     if (pkt_len != pkt->frag_size + sizeof(ucs_stats_packet_hdr_t)) {
@@ -419,7 +709,11 @@ ucs_stats_server_update_context(ucs_stats_server_h server, struct sockaddr_in *s
     }
 
     /* Validate magic */
-    if (memcmp(pkt->magic, UCS_STATS_MAGIC, sizeof(pkt->magic)) != 0) {
+    if (memcmp(pkt->magic, UCS_STATS_MAGIC, sizeof(pkt->magic)) == 0) {
+        is_delta = 0;
+    } else if (memcmp(pkt->magic, UCS_STATS_DELTA_MAGIC, sizeof(pkt->magic)) == 0) {
+        is_delta = 1;
+    } else {
         ucs_error("Invalid magic in packet header");
         return UCS_ERR_INVALID_PARAM;
     }
@@ -434,7 +728,8 @@ ucs_stats_server_update_context(ucs_stats_server_h server, struct sockaddr_in *s
     /* Update the entity */
     status = ucs_stats_server_entity_update(server, entity, pkt->timestamp,
                                            pkt->total_size, pkt + 1,
-                                           pkt->frag_size, pkt->frag_offset);
+                                           pkt->frag_size, pkt->frag_offset,
+                                           is_delta);
 
     ucs_stats_server_entity_put(entity);
     ++server->rcvd_packets;
@@ -621,7 +916,11 @@ ucs_list_link_t *ucs_stats_server_get_stats(ucs_stats_server_h server)
     {
         /* Parse the statistics data */
         pthread_mutex_lock(&entity->lock);
-        stream = fmemopen(entity->completed_buffer, entity->buffer_size, "rb");
+        if (entity->completed_size == 0) {
+            pthread_mutex_unlock(&entity->lock);
+            continue; /* Nothing was fully assembled yet */
+        }
+        stream = fmemopen(entity->completed_buffer, entity->completed_size, "rb");
         status = ucs_stats_deserialize(stream, &node);
         fclose(stream);
         pthread_mutex_unlock(&entity->lock);
@@ -27,6 +27,15 @@ enum {
 
 #define UCS_STATS_DEFAULT_UDP_PORT 37873
 
+/* Maximal encoded size of a single varint */
+#define UCS_STATS_VARINT_MAX_SIZE  10
+
+/* Zigzag encoding, to keep small negative deltas small on the wire */
+#define ucs_stats_zigzag_encode(_v) \
+    (((uint64_t)(_v) << 1) ^ (uint64_t)((int64_t)(_v) >> 63))
+#define ucs_stats_zigzag_decode(_v) \
+    ((int64_t)(((_v) >> 1) ^ (0 - ((_v) & 1))))
+
 
 #define UCS_STAT_NAME_MAX          31
 
@@ -152,6 +161,20 @@ ucs_status_t ucs_stats_node_initv(ucs_stats_node_t *node, ucs_stats_class_t *cls
                                  const char *name, va_list ap);
 
 
+/**
+ * Header of a delta report. The report updates a previously transferred full
+ * dump, which serves as the dictionary of node/class/counter names, and is
+ * followed by 'num_updates' pairs of varints: the index distance from the
+ * previously updated counter (counters are numbered in binary serialization
+ * order) and the zigzag-encoded change of its value.
+ */
+typedef struct ucs_stats_delta_header {
+    uint32_t   version;
+    uint32_t   num_updates;
+    uint64_t   base_timestamp;    /* Timestamp of the report this builds on */
+} ucs_stats_delta_header_t;
+
+
 /**
  * Serialize statistics.
  *
@@ -162,6 +185,65 @@ ucs_status_t ucs_stats_node_initv(ucs_stats_node_t *node, ucs_stats_class_t *cls
 ucs_status_t ucs_stats_serialize(FILE *stream, ucs_stats_node_t *root, int options);
 
 
+/**
+ * Pack an integer in base-128 varint encoding.
+ *
+ * @param value  Value to pack.
+ * @param buf    Destination buffer, at least UCS_STATS_VARINT_MAX_SIZE bytes.
+ *
+ * @return Number of bytes written.
+ */
+size_t ucs_stats_varint_pack(uint64_t value, void *buf);
+
+
+/**
+ * Unpack a base-128 varint.
+ *
+ * @param buf      Source buffer.
+ * @param max      Bytes available in the buffer.
+ * @param value_p  Filled with the unpacked value.
+ *
+ * @return Number of bytes consumed, or 0 if the buffer is truncated.
+ */
+size_t ucs_stats_varint_unpack(const void *buf, size_t max, uint64_t *value_p);
+
+
+/**
+ * Count the counters of a statistics tree, in binary serialization order.
+ */
+unsigned ucs_stats_num_counters(ucs_stats_node_t *root);
+
+
+/**
+ * Copy the counter values of a statistics tree to a flat array, in binary
+ * serialization order.
+ *
+ * @param root      Statistics node root.
+ * @param counters  Array to fill, at least ucs_stats_num_counters() entries.
+ *
+ * @return Number of counters copied.
+ */
+unsigned ucs_stats_snapshot_counters(ucs_stats_node_t *root,
+                                     ucs_stats_counter_t *counters);
+
+
+/**
+ * Serialize the changes of the counters since a previous snapshot as a delta
+ * report, and advance the snapshot to the current values.
+ *
+ * @param stream          Destination.
+ * @param root            Statistics node root.
+ * @param prev_counters   Snapshot the delta is relative to, updated in place.
+ * @param num_counters    Number of counters in the snapshot; must match the
+ *                        current tree, otherwise a full dump is required.
+ * @param base_timestamp  Timestamp of the report the delta builds on.
+ */
+ucs_status_t ucs_stats_serialize_delta(FILE *stream, ucs_stats_node_t *root,
+                                       ucs_stats_counter_t *prev_counters,
+                                       unsigned num_counters,
+                                       uint64_t base_timestamp);
+
+
 /**
  * De-serialize statistics.
  *
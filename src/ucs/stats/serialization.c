@@ -386,6 +386,125 @@ ucs_stats_serialize_text_recurs_filtered(FILE *stream,
     return UCS_OK;
 }
 
+size_t ucs_stats_varint_pack(uint64_t value, void *buf)
+{
+    uint8_t *p = buf;
+
+    while (value >= 0x80) {
+        *(p++) = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    *(p++) = value;
+    return p - (uint8_t*)buf;
+}
+
+size_t ucs_stats_varint_unpack(const void *buf, size_t max, uint64_t *value_p)
+{
+    const uint8_t *p = buf;
+    uint64_t value   = 0;
+    unsigned shift   = 0;
+
+    while ((max-- > 0) && (shift < 64)) {
+        value |= (uint64_t)(*p & 0x7f) << shift;
+        if (!(*p & 0x80)) {
+            *value_p = value;
+            return (p + 1) - (const uint8_t*)buf;
+        }
+        ++p;
+        shift += 7;
+    }
+    return 0; /* truncated or malformed */
+}
+
+/* Number the counters the way the binary serializer walks the tree: the
+ * node's own counters first, then the active children in list order. The
+ * delta protocol relies on both sides deriving the same numbering.
+ */
+static unsigned
+ucs_stats_snapshot_counters_recurs(ucs_stats_node_t *node,
+                                   ucs_stats_counter_t *counters,
+                                   unsigned index)
+{
+    ucs_stats_node_t *child;
+    unsigned i;
+
+    for (i = 0; i < node->cls->num_counters; ++i) {
+        if (counters != NULL) {
+            counters[index] = node->counters[i];
+        }
+        ++index;
+    }
+
+    ucs_list_for_each(child, &node->children[UCS_STATS_ACTIVE_CHILDREN], list) {
+        index = ucs_stats_snapshot_counters_recurs(child, counters, index);
+    }
+
+    return index;
+}
+
+unsigned ucs_stats_num_counters(ucs_stats_node_t *root)
+{
+    return ucs_stats_snapshot_counters_recurs(root, NULL, 0);
+}
+
+unsigned ucs_stats_snapshot_counters(ucs_stats_node_t *root,
+                                     ucs_stats_counter_t *counters)
+{
+    return ucs_stats_snapshot_counters_recurs(root, counters, 0);
+}
+
+ucs_status_t ucs_stats_serialize_delta(FILE *stream, ucs_stats_node_t *root,
+                                       ucs_stats_counter_t *prev_counters,
+                                       unsigned num_counters,
+                                       uint64_t base_timestamp)
+{
+    uint8_t varint[UCS_STATS_VARINT_MAX_SIZE];
+    ucs_stats_delta_header_t hdr;
+    ucs_stats_counter_t *curr;
+    unsigned i, last, count;
+    size_t len;
+
+    curr = malloc(num_counters * sizeof(*curr));
+    if (curr == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    if (ucs_stats_snapshot_counters(root, curr) != num_counters) {
+        /* The tree changed shape under our feet - need a full dump */
+        free(curr);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    count = 0;
+    for (i = 0; i < num_counters; ++i) {
+        count += (curr[i] != prev_counters[i]);
+    }
+
+    hdr.version        = 1;
+    hdr.num_updates    = count;
+    hdr.base_timestamp = base_timestamp;
+    FWRITE_ONE(&hdr, stream);
+
+    last = 0;
+    for (i = 0; i < num_counters; ++i) {
+        if (curr[i] == prev_counters[i]) {
+            continue;
+        }
+
+        len = ucs_stats_varint_pack(i - last, varint);
+        FWRITE(varint, len, stream);
+        len = ucs_stats_varint_pack(ucs_stats_zigzag_encode((int64_t)curr[i] -
+                                                            (int64_t)prev_counters[i]),
+                                    varint);
+        FWRITE(varint, len, stream);
+        last = i;
+    }
+
+    memcpy(prev_counters, curr, num_counters * sizeof(*curr));
+    free(curr);
+    return UCS_OK;
+}
+
 ucs_status_t ucs_stats_serialize(FILE *stream, ucs_stats_node_t *root, int options)
 {
     ucs_stats_children_sel_t sel =
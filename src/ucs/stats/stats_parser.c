@@ -5,12 +5,20 @@
 */
 
 #include "stats.h"
+#include "stats_shm.h"
+
+#include <ucs/type/status.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
 
 /*
- * Dump binary statistics file to stdout.
- * Usage: ucs_stats_parser [ file1 ] [ file2 ] ...
+ * Dump binary statistics file to stdout, or scrape the always-on shared
+ * memory counters of a running process.
+ * Usage: ucs_stats_parser [ -p pid ] [ file1 ] [ file2 ] ...
  */
 
+#if ENABLE_STATS
 static ucs_status_t dump_file(const char *filename)
 {
     ucs_stats_node_t *root;
@@ -39,13 +47,54 @@ out:
     fclose(stream);
     return status;
 }
+#else
+static ucs_status_t dump_file(const char *filename)
+{
+    fprintf(stderr, "Cannot read %s: "
+            "compiled without full statistics support\n", filename);
+    return UCS_ERR_UNSUPPORTED;
+}
+#endif
+
+static ucs_status_t dump_shm(pid_t pid)
+{
+    ucs_stats_shm_slot_t *slot;
+    ucs_stats_shm_t *shm;
+    ucs_status_t status;
+    unsigned i;
+
+    status = ucs_stats_shm_attach(pid, &shm);
+    if (status != UCS_OK) {
+        fprintf(stderr, "Could not attach to statistics of pid %d\n", pid);
+        return status;
+    }
+
+    for (slot = shm->slots; slot < shm->slots + shm->num_slots; ++slot) {
+        if (slot->name[0] == '\0') {
+            continue;
+        }
+
+        printf("%s:\n", slot->name);
+        for (i = 0; i < slot->num_counters; ++i) {
+            printf("    %24s: %lu\n", slot->counter_names[i],
+                   (unsigned long)slot->counters[i]);
+        }
+    }
+
+    ucs_stats_shm_detach(shm);
+    return UCS_OK;
+}
 
 int main(int argc, char **argv)
 {
     int i;
 
     for (i = 1; i < argc; ++i) {
-        dump_file(argv[i]);
+        if (!strcmp(argv[i], "-p") && (i + 1 < argc)) {
+            dump_shm(atoi(argv[++i]));
+        } else {
+            dump_file(argv[i]);
+        }
     }
 
     return 0;
@@ -0,0 +1,195 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "stats_shm.h"
+
+#include <ucs/config/global_opts.h>
+#include <ucs/debug/log.h>
+#include <ucs/sys/string.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+
+static struct {
+    pthread_mutex_t     lock;      /* Protects slot allocation */
+    ucs_stats_shm_t     *shm;      /* Mapped segment, created lazily */
+    unsigned            num_used;  /* Number of allocated slots */
+} ucs_stats_shm_context = {
+    .lock     = PTHREAD_MUTEX_INITIALIZER,
+    .shm      = NULL,
+    .num_used = 0
+};
+
+
+static void ucs_stats_shm_path(pid_t pid, char *path, size_t max)
+{
+    snprintf(path, max, UCS_STATS_SHM_FILE_FMT, pid);
+}
+
+/* Called with the lock held */
+static ucs_status_t ucs_stats_shm_create()
+{
+    char path[64];
+    void *ptr;
+    int fd;
+
+    ucs_stats_shm_path(getpid(), path, sizeof(path));
+
+    fd = shm_open(path, O_CREAT|O_RDWR, 0644);
+    if (fd < 0) {
+        ucs_warn("shm_open(%s) failed: %m", path);
+        return UCS_ERR_SHMEM_SEGMENT;
+    }
+
+    if (ftruncate(fd, sizeof(ucs_stats_shm_t)) < 0) {
+        ucs_warn("ftruncate(%s) failed: %m", path);
+        goto err_close;
+    }
+
+    ptr = mmap(NULL, sizeof(ucs_stats_shm_t), PROT_READ|PROT_WRITE, MAP_SHARED,
+               fd, 0);
+    if (ptr == MAP_FAILED) {
+        ucs_warn("failed to map statistics segment: %m");
+        goto err_close;
+    }
+
+    close(fd);
+
+    ucs_stats_shm_context.shm = ptr;
+    memset(ptr, 0, sizeof(ucs_stats_shm_t));
+    ucs_stats_shm_context.shm->version   = UCS_STATS_SHM_VERSION;
+    ucs_stats_shm_context.shm->pid       = getpid();
+    ucs_stats_shm_context.shm->num_slots = UCS_STATS_SHM_MAX_SLOTS;
+    return UCS_OK;
+
+err_close:
+    close(fd);
+    shm_unlink(path);
+    return UCS_ERR_SHMEM_SEGMENT;
+}
+
+/* Called with the lock held */
+static void ucs_stats_shm_destroy()
+{
+    char path[64];
+
+    ucs_stats_shm_path(getpid(), path, sizeof(path));
+    munmap(ucs_stats_shm_context.shm, sizeof(ucs_stats_shm_t));
+    shm_unlink(path);
+    ucs_stats_shm_context.shm = NULL;
+}
+
+ucs_stats_shm_slot_t *ucs_stats_shm_slot_alloc(const char *name,
+                                               const char **counter_names,
+                                               unsigned num_counters)
+{
+    ucs_stats_shm_slot_t *slot;
+    unsigned i;
+
+    if (!ucs_global_opts.stats_shm) {
+        return NULL;
+    }
+
+    if (num_counters > UCS_STATS_SHM_MAX_COUNTERS) {
+        ucs_warn("too many counters for statistics slot '%s' (%u, max: %d)",
+                 name, num_counters, UCS_STATS_SHM_MAX_COUNTERS);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&ucs_stats_shm_context.lock);
+
+    if ((ucs_stats_shm_context.shm == NULL) &&
+        (ucs_stats_shm_create() != UCS_OK))
+    {
+        goto err_unlock;
+    }
+
+    for (slot = ucs_stats_shm_context.shm->slots;
+         slot < ucs_stats_shm_context.shm->slots + UCS_STATS_SHM_MAX_SLOTS;
+         ++slot)
+    {
+        if (slot->name[0] == '\0') {
+            break;
+        }
+    }
+    if (slot >= ucs_stats_shm_context.shm->slots + UCS_STATS_SHM_MAX_SLOTS) {
+        ucs_debug("no free statistics slot for '%s'", name);
+        goto err_unlock;
+    }
+
+    memset(slot->counters, 0, sizeof(slot->counters));
+    slot->num_counters = num_counters;
+    for (i = 0; i < num_counters; ++i) {
+        ucs_strncpy_zero(slot->counter_names[i], counter_names[i],
+                         UCS_STATS_SHM_NAME_MAX);
+    }
+
+    /* The name marks the slot valid, so it is set last */
+    ++slot->generation;
+    ucs_strncpy_zero(slot->name, name, UCS_STATS_SHM_NAME_MAX);
+
+    ++ucs_stats_shm_context.num_used;
+    pthread_mutex_unlock(&ucs_stats_shm_context.lock);
+    return slot;
+
+err_unlock:
+    pthread_mutex_unlock(&ucs_stats_shm_context.lock);
+    return NULL;
+}
+
+void ucs_stats_shm_slot_free(ucs_stats_shm_slot_t *slot)
+{
+    if (slot == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&ucs_stats_shm_context.lock);
+    slot->name[0] = '\0';
+    ++slot->generation;
+    if (--ucs_stats_shm_context.num_used == 0) {
+        ucs_stats_shm_destroy();
+    }
+    pthread_mutex_unlock(&ucs_stats_shm_context.lock);
+}
+
+ucs_status_t ucs_stats_shm_attach(pid_t pid, ucs_stats_shm_t **shm_p)
+{
+    ucs_stats_shm_t *shm;
+    char path[64];
+    int fd;
+
+    ucs_stats_shm_path(pid, path, sizeof(path));
+
+    fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) {
+        return UCS_ERR_NO_ELEM;
+    }
+
+    shm = mmap(NULL, sizeof(ucs_stats_shm_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        return UCS_ERR_SHMEM_SEGMENT;
+    }
+
+    if (shm->version != UCS_STATS_SHM_VERSION) {
+        munmap(shm, sizeof(ucs_stats_shm_t));
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    *shm_p = shm;
+    return UCS_OK;
+}
+
+void ucs_stats_shm_detach(ucs_stats_shm_t *shm)
+{
+    munmap(shm, sizeof(ucs_stats_shm_t));
+}
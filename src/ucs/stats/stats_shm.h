@@ -0,0 +1,114 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#ifndef UCS_STATS_SHM_H_
+#define UCS_STATS_SHM_H_
+
+#include <ucs/sys/compiler.h>
+#include <ucs/type/status.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*
+ * Always-on statistics counters, published in a shared memory segment.
+ *
+ * Unlike the full statistics infrastructure (which is compiled out of release
+ * builds), these are flat per-slot counter arrays updated with plain stores,
+ * cheap enough to stay enabled in production. An external reader attaches to
+ * the segment of a running process and scrapes the counters without stopping
+ * it. Each slot has a single writer, so no atomics are needed; the reader may
+ * see a counter value which is a few updates stale, which is acceptable for
+ * monitoring.
+ */
+
+#define UCS_STATS_SHM_VERSION       1
+#define UCS_STATS_SHM_MAX_SLOTS     64
+#define UCS_STATS_SHM_MAX_COUNTERS  32
+#define UCS_STATS_SHM_NAME_MAX      32
+
+/* Name of the shared memory segment of a process, by pid */
+#define UCS_STATS_SHM_FILE_FMT      "/ucx_stats_%d"
+
+
+/**
+ * One slot of counters, owned by a single writer (e.g a worker).
+ */
+typedef struct ucs_stats_shm_slot {
+    char                name[UCS_STATS_SHM_NAME_MAX]; /* Empty when the slot is free */
+    uint32_t            num_counters;                 /* Number of valid counters */
+    uint32_t            generation;                   /* Bumped on alloc and free, so
+                                                         a reader can detect reuse */
+    char                counter_names[UCS_STATS_SHM_MAX_COUNTERS][UCS_STATS_SHM_NAME_MAX];
+    uint64_t            counters[UCS_STATS_SHM_MAX_COUNTERS];
+} ucs_stats_shm_slot_t;
+
+
+/**
+ * Layout of the shared memory segment.
+ */
+typedef struct ucs_stats_shm {
+    uint32_t             version;    /* UCS_STATS_SHM_VERSION */
+    uint32_t             pid;        /* Pid of the owning process */
+    uint32_t             num_slots;  /* UCS_STATS_SHM_MAX_SLOTS */
+    uint32_t             padding;
+    ucs_stats_shm_slot_t slots[UCS_STATS_SHM_MAX_SLOTS];
+} ucs_stats_shm_t;
+
+
+/**
+ * Allocate a counter slot in the shared memory segment of the current process.
+ * The segment is created on the first allocation.
+ *
+ * @param [in] name           Slot name, truncated to UCS_STATS_SHM_NAME_MAX.
+ * @param [in] counter_names  Names of the counters.
+ * @param [in] num_counters   Number of counters.
+ *
+ * @return Slot pointer, or NULL if the slot could not be allocated (in which
+ *         case counting macros become no-ops).
+ */
+ucs_stats_shm_slot_t *ucs_stats_shm_slot_alloc(const char *name,
+                                               const char **counter_names,
+                                               unsigned num_counters);
+
+
+/**
+ * Release a counter slot. When the last slot is released, the shared memory
+ * segment is unlinked.
+ *
+ * @param [in] slot   Slot to release. May be NULL.
+ */
+void ucs_stats_shm_slot_free(ucs_stats_shm_slot_t *slot);
+
+
+/**
+ * Attach to the shared memory statistics segment of another process, read-only.
+ *
+ * @param [in]  pid     Pid of the process to attach to.
+ * @param [out] shm_p   Filled with the mapped segment.
+ *
+ * @return UCS status code.
+ */
+ucs_status_t ucs_stats_shm_attach(pid_t pid, ucs_stats_shm_t **shm_p);
+
+
+/**
+ * Detach from a segment previously attached with ucs_stats_shm_attach().
+ */
+void ucs_stats_shm_detach(ucs_stats_shm_t *shm);
+
+
+/**
+ * Add to a counter in a slot. A plain store - the slot must have one writer.
+ */
+static inline void ucs_stats_shm_count(ucs_stats_shm_slot_t *slot,
+                                       unsigned index, uint64_t delta)
+{
+    if (slot != NULL) {
+        slot->counters[index] += delta;
+    }
+}
+
+#endif
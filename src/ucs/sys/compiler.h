@@ -49,6 +49,11 @@
 /* Avoid inlining the function */
 #define UCS_F_NOINLINE __attribute__ ((noinline))
 
+/* A function which runs only on error/slow paths. Every call site is treated
+ * as unlikely, and its basic block is moved out of the caller's hot layout,
+ * keeping the fast path dense in the instruction cache. */
+#define UCS_F_COLD __attribute__ ((cold))
+
 /* Shared library constructor and destructor */
 #define UCS_F_CTOR __attribute__((constructor))
 #define UCS_F_DTOR __attribute__((destructor))
@@ -44,6 +44,11 @@ typedef struct ucs_rcache_inv_entry {
     ucs_pgt_addr_t           end;
 } ucs_rcache_inv_entry_t;
 
+/* Once this many merged invalidation ranges are pending, the memory event
+ * callback drains the queue itself (if the page table is free) instead of
+ * waiting for the next lookup, to bound how long stale regions can linger */
+#define UCS_RCACHE_INV_FLUSH_LEN  64
+
 
 static void __ucs_rcache_region_log(const char *file, int line, const char *function,
                                     ucs_log_level_t level, ucs_rcache_t *rcache,
@@ -79,14 +84,28 @@ static void __ucs_rcache_region_log(const char *file, int line, const char *func
 
 static ucs_pgt_dir_t *ucs_rcache_pgt_dir_alloc(const ucs_pgtable_t *pgtable)
 {
-    return ucs_memalign(UCS_PGT_ENTRY_MIN_ALIGN, sizeof(ucs_pgt_dir_t),
-                        "rcache_pgdir");
+    ucs_rcache_t *rcache = ucs_container_of((ucs_pgtable_t*)pgtable,
+                                            ucs_rcache_t, pgtable);
+
+    return ucs_mpool_get(&rcache->pgt_dir_mp);
 }
 
+static void ucs_rcache_readers_drain(ucs_rcache_t *rcache);
+static void ucs_rcache_dir_gc_flush(ucs_rcache_t *rcache);
+
 static void ucs_rcache_pgt_dir_release(const ucs_pgtable_t *pgtable,
                                        ucs_pgt_dir_t *dir)
 {
-    ucs_free(dir);
+    ucs_rcache_t *rcache = ucs_container_of((ucs_pgtable_t*)pgtable,
+                                            ucs_rcache_t, pgtable);
+
+    /* Defer the free until lock-free readers drain - a concurrent lookup may
+     * still be traversing this directory */
+    if (rcache->dir_gc_count == UCS_RCACHE_DIR_GC_MAX) {
+        ucs_rcache_readers_drain(rcache);
+        ucs_rcache_dir_gc_flush(rcache);
+    }
+    rcache->dir_gc[rcache->dir_gc_count++] = dir;
 }
 
 static ucs_status_t ucs_rcache_mp_chunk_alloc(ucs_mpool_t *mp, size_t *size_p,
@@ -132,6 +151,44 @@ static ucs_mpool_ops_t ucs_rcache_mp_ops = {
 };
 
 
+/*
+ * The page table is modified only with the lock held in write mode, but
+ * ucs_rcache_get() also traverses it without the lock. Writers keep a seqlock
+ * version counter: it is made odd before the first modification and even again
+ * when the write section ends. Memory unlinked from the page table - regions
+ * and page table directories - is freed only after every lock-free reader
+ * which could still be traversing it has drained, so the unlocked walk never
+ * touches freed memory; any inconsistent result it might compute is rejected
+ * by re-checking the version.
+ */
+static void ucs_rcache_write_section_begin(ucs_rcache_t *rcache)
+{
+    ucs_assert(!(rcache->version & 1));
+    rcache->version++;
+    ucs_memory_cpu_store_fence();
+}
+
+static void ucs_rcache_readers_drain(ucs_rcache_t *rcache)
+{
+    unsigned i;
+
+    /* Pairs with the fence readers issue after marking their slot busy */
+    ucs_memory_bus_fence();
+    for (i = 0; i < UCS_RCACHE_READER_SLOTS; ++i) {
+        while (rcache->readers[i].busy) {
+            sched_yield();
+        }
+    }
+}
+
+static void ucs_rcache_dir_gc_flush(ucs_rcache_t *rcache)
+{
+    while (rcache->dir_gc_count > 0) {
+        ucs_mpool_put(rcache->dir_gc[--rcache->dir_gc_count]);
+    }
+}
+
+
 /* Lock must be held */
 static void ucs_rcache_region_collect_callback(const ucs_pgtable_t *pgtable,
                                                ucs_pgt_region_t *pgt_region, void *arg)
@@ -150,7 +207,8 @@ static void ucs_rcache_find_regions(ucs_rcache_t *rcache, ucs_pgt_addr_t from,
                              ucs_rcache_region_collect_callback, list);
 }
 
-/* Lock must be held in write mode */
+/* The region must be unreachable - unlinked from the page table and drained
+ * of lock-free readers */
 static void ucs_mem_region_destroy_internal(ucs_rcache_t *rcache,
                                             ucs_rcache_region_t *region)
 {
@@ -163,6 +221,58 @@ static void ucs_mem_region_destroy_internal(ucs_rcache_t *rcache,
     ucs_free(region);
 }
 
+/* Lock must be held in write mode. The region must already be unlinked from
+ * the page table; it is destroyed when the write section ends and in-flight
+ * lock-free readers have drained */
+static void ucs_rcache_region_destroy_deferred(ucs_rcache_t *rcache,
+                                               ucs_rcache_region_t *region)
+{
+    ucs_list_add_tail(&rcache->gc_list, &region->list);
+}
+
+static void ucs_rcache_write_section_end(ucs_rcache_t *rcache)
+{
+    ucs_assert(rcache->version & 1);
+    ucs_memory_cpu_store_fence();
+    rcache->version++;
+
+    if ((rcache->dir_gc_count == 0) && ucs_list_is_empty(&rcache->gc_list)) {
+        return;
+    }
+
+    ucs_rcache_readers_drain(rcache);
+    ucs_rcache_dir_gc_flush(rcache);
+
+    /* The drained regions are unreachable now, but deregistration is slow -
+     * queue them and deregister in a batch once the lock is dropped */
+    if (!ucs_list_is_empty(&rcache->gc_list)) {
+        pthread_spin_lock(&rcache->victim_lock);
+        ucs_list_splice_tail(&rcache->victim_list, &rcache->gc_list);
+        pthread_spin_unlock(&rcache->victim_lock);
+        ucs_list_head_init(&rcache->gc_list);
+    }
+}
+
+/* Deregister invalidated regions in a batch. Must be called without the page
+ * table lock, so the expensive mem_dereg calls do not stall threads waiting
+ * for a lookup, and the vm_unmapped hook stays microsecond-fast */
+static void ucs_rcache_victim_flush(ucs_rcache_t *rcache)
+{
+    ucs_rcache_region_t *region, *tmp;
+    ucs_list_link_t victims;
+
+    ucs_list_head_init(&victims);
+    pthread_spin_lock(&rcache->victim_lock);
+    ucs_list_splice_tail(&victims, &rcache->victim_list);
+    ucs_list_head_init(&rcache->victim_list);
+    pthread_spin_unlock(&rcache->victim_lock);
+
+    ucs_list_for_each_safe(region, tmp, &victims, list) {
+        ucs_list_del(&region->list);
+        ucs_mem_region_destroy_internal(rcache, region);
+    }
+}
+
 /* Lock must be held in write mode */
 static void ucs_rcache_region_invalidate(ucs_rcache_t *rcache,
                                          ucs_rcache_region_t *region,
@@ -190,7 +300,7 @@ static void ucs_rcache_region_invalidate(ucs_rcache_t *rcache,
      * reference count drops to 0.
      */
     if (region->refcount == 0) {
-        ucs_mem_region_destroy_internal(rcache, region);
+        ucs_rcache_region_destroy_deferred(rcache, region);
     } else {
         ucs_assert(!must_be_destroyed);
         region->flags |= UCS_RCACHE_REGION_FLAG_INVALID;
@@ -224,6 +334,8 @@ static void ucs_rcache_check_inv_queue(ucs_rcache_t *rcache)
         entry = ucs_queue_pull_elem_non_empty(&rcache->inv_q,
                                               ucs_rcache_inv_entry_t, queue);
 
+        --rcache->inv_count;
+
         /* We need to drop the lock since the following code may trigger memory
          * operations, which could trigger vm_unmapped event which also takes
          * this lock.
@@ -245,6 +357,7 @@ static void ucs_rcache_unmapped_callback(ucm_event_type_t event_type,
     ucs_rcache_t *rcache = arg;
     ucs_rcache_inv_entry_t *entry;
     ucs_pgt_addr_t start, end;
+    int do_flush = 0;
 
     ucs_assert(event_type == UCM_EVENT_VM_UNMAPPED);
 
@@ -253,17 +366,44 @@ static void ucs_rcache_unmapped_callback(ucm_event_type_t event_type,
     ucs_trace_func("%s: event vm_unmapped 0x%lx..0x%lx", rcache->name, start, end);
 
     pthread_spin_lock(&rcache->inv_lock);
+
+    /* Allocator trims release runs of adjacent chunks - extend a pending
+     * range which overlaps or abuts the new one instead of queueing one
+     * invalidation per chunk. Ranges the merge makes redundant are handled
+     * naturally when the queue drains, since invalidation is idempotent. */
+    ucs_queue_for_each(entry, &rcache->inv_q, queue) {
+        if ((start <= entry->end) && (end >= entry->start)) {
+            entry->start = ucs_min(entry->start, start);
+            entry->end   = ucs_max(entry->end,   end);
+            pthread_spin_unlock(&rcache->inv_lock);
+            return;
+        }
+    }
+
     entry = ucs_mpool_get(&rcache->inv_mp);
     if (entry != NULL) {
         /* Add region to invalidation list */
         entry->start = start;
         entry->end   = end;
         ucs_queue_push(&rcache->inv_q, &entry->queue);
+        ++rcache->inv_count;
+        do_flush = (rcache->inv_count >= UCS_RCACHE_INV_FLUSH_LEN);
     } else {
         ucs_error("Failed to allocate invalidation entry for 0x%lx..0x%lx, "
                   "data corruption may occur", start, end);
     }
     pthread_spin_unlock(&rcache->inv_lock);
+
+    /* Bound the flush delay: drain a long queue right away unless the page
+     * table is busy (trywrlock also keeps us safe when the event fires from
+     * a context which already holds the lock) */
+    if (do_flush && (pthread_rwlock_trywrlock(&rcache->lock) == 0)) {
+        ucs_rcache_write_section_begin(rcache);
+        ucs_rcache_check_inv_queue(rcache);
+        ucs_rcache_write_section_end(rcache);
+        pthread_rwlock_unlock(&rcache->lock);
+        ucs_rcache_victim_flush(rcache);
+    }
 }
 
 /* Clear all regions
@@ -284,7 +424,7 @@ static void ucs_rcache_purge(ucs_rcache_t *rcache)
             ucs_rcache_region_warn(rcache, region, "destroying inuse");
         }
         region->flags &= ~UCS_RCACHE_REGION_FLAG_PGTABLE;
-        ucs_mem_region_destroy_internal(rcache, region);
+        ucs_rcache_region_destroy_deferred(rcache, region);
     }
 }
 
@@ -302,14 +442,19 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
 {
     ucs_rcache_region_t *region, *tmp;
     ucs_list_link_t region_list;
+    size_t merged_size;
     int mem_prot;
+    int overlap;
 
     ucs_trace_func("rcache=%s, *start=0x%lx, *end=0x%lx", rcache->name, *start,
                    *end);
 
     ucs_rcache_check_inv_queue(rcache);
 
-    ucs_rcache_find_regions(rcache, *start, *end - 1, &region_list);
+    /* Search one byte beyond the range on both sides, to merge also with
+     * regions which exactly abut the new one */
+    ucs_rcache_find_regions(rcache, (*start > 0) ? *start - 1 : 0, *end,
+                            &region_list);
 
     /* TODO check if any of the regions is locked */
 
@@ -324,6 +469,28 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
             return UCS_ERR_ALREADY_EXISTS;
         }
 
+        /* An adjacent region never conflicts with the new one, so unlike an
+         * overlapping region it can be left in place when it is not merged */
+        overlap = (region->super.start < *end) && (region->super.end > *start);
+
+        /* Cap the size of merged regions, so a stream of adjacent
+         * registrations would not snowball into one huge MR which is
+         * re-registered on every growth */
+        merged_size = ucs_max(*end, region->super.end) -
+                      ucs_min(*start, region->super.start);
+        if ((rcache->params.max_merged_size != 0) &&
+            (merged_size > rcache->params.max_merged_size)) {
+            ucs_rcache_region_trace(rcache, region,
+                                    "do not merge (limit %zu size %zu) with",
+                                    rcache->params.max_merged_size, merged_size);
+            if (overlap) {
+                /* The page table does not allow overlap, so the region has to
+                 * go even though we do not take over its range */
+                ucs_rcache_region_invalidate(rcache, region, 1, 0);
+            }
+            continue;
+        }
+
         /* No point to expand the region to pages which are not accessible
          * the way we want. If somebody will want to use them, it will be
          * by another region (with appropriate permissions).
@@ -336,7 +503,9 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
                                     " with mem "UCS_RCACHE_PROT_FMT,
                                     UCS_RCACHE_PROT_ARG(*prot),
                                     UCS_RCACHE_PROT_ARG(mem_prot));
-            ucs_rcache_region_invalidate(rcache, region, 1, 0);
+            if (overlap) {
+                ucs_rcache_region_invalidate(rcache, region, 1, 0);
+            }
             continue;
         }
 
@@ -362,7 +531,9 @@ ucs_rcache_check_overlap(ucs_rcache_t *rcache, ucs_pgt_addr_t *start,
                 ucs_rcache_region_trace(rcache, region,
                                         "do not merge mem "UCS_RCACHE_PROT_FMT" with",
                                         UCS_RCACHE_PROT_ARG(mem_prot));
-                ucs_rcache_region_invalidate(rcache, region, 1, 0);
+                if (overlap) {
+                    ucs_rcache_region_invalidate(rcache, region, 1, 0);
+                }
                 continue;
             }
         }
@@ -391,6 +562,7 @@ ucs_rcache_create_region(ucs_rcache_t *rcache, void *address, size_t length,
                    length);
 
     pthread_rwlock_wrlock(&rcache->lock);
+    ucs_rcache_write_section_begin(rcache);
 
 retry:
     /* Align to page size */
@@ -453,7 +625,7 @@ retry:
                       UCS_PGT_REGION_ARG(&region->super), ucs_status_string(status));
             status = ucs_pgtable_remove(&rcache->pgtable, &region->super);
             ucs_assert_always(status == UCS_OK);
-            ucs_mem_region_destroy_internal(rcache, region);
+            ucs_rcache_region_destroy_deferred(rcache, region);
             goto retry;
         } else {
             ucs_warn("failed to register region " UCS_PGT_REGION_FMT ": %s",
@@ -470,7 +642,9 @@ retry:
 out_set_region:
     *region_p = region;
 out_unlock:
+    ucs_rcache_write_section_end(rcache);
     pthread_rwlock_unlock(&rcache->lock);
+    ucs_rcache_victim_flush(rcache);
     return status;
 }
 
@@ -484,30 +658,68 @@ ucs_status_t ucs_rcache_get(ucs_rcache_t *rcache, void *address, size_t length,
                             int prot, void *arg, ucs_rcache_region_t **region_p)
 {
     ucs_pgt_addr_t start = (uintptr_t)address;
+    ucs_rcache_reader_t *reader;
     ucs_pgt_region_t *pgt_region;
     ucs_rcache_region_t *region;
+    uint32_t version;
 
     ucs_trace_func("rcache=%s, address=%p, length=%zu", rcache->name, address,
                    length);
 
-    pthread_rwlock_rdlock(&rcache->lock);
-    if (ucs_queue_is_empty(&rcache->inv_q)) {
-        pgt_region = ucs_pgtable_lookup(&rcache->pgtable, start);
-        if (ucs_likely(pgt_region != NULL)) {
-            region = ucs_derived_of(pgt_region, ucs_rcache_region_t);
-            if (((start + length) <= region->super.end) &&
-                ucs_rcache_region_test(region, prot))
-            {
-                ucs_rcache_region_hold(rcache, region);
-                *region_p = region;
-                pthread_rwlock_unlock(&rcache->lock);
-                return UCS_OK;
+    /* Lock-free lookup: claim a reader slot, validate the page table version,
+     * and walk the table without taking the lock. Writers defer freeing
+     * anything unlinked from the table until busy slots drain, so the walk
+     * never touches freed memory; a race with a writer is detected by the
+     * version re-check and falls back to the locked path.
+     */
+    reader  = &rcache->readers[((uintptr_t)pthread_self() >> 12) %
+                               UCS_RCACHE_READER_SLOTS];
+    version = rcache->version;
+    if (ucs_likely(!(version & 1) &&
+                   (ucs_atomic_cswap32(&reader->busy, 0, 1) == 0))) {
+        /* Pairs with the fence writers issue before scanning reader slots */
+        ucs_memory_bus_fence();
+        if (ucs_likely((rcache->version == version) &&
+                       ucs_queue_is_empty(&rcache->inv_q))) {
+            pgt_region = ucs_pgtable_lookup(&rcache->pgtable, start);
+            if (ucs_likely(pgt_region != NULL)) {
+                region = ucs_derived_of(pgt_region, ucs_rcache_region_t);
+                if (((start + length) <= region->super.end) &&
+                    ucs_rcache_region_test(region, prot))
+                {
+                    ucs_rcache_region_hold(rcache, region);
+                    ucs_memory_bus_fence();
+                    if (ucs_likely(rcache->version == version)) {
+                        reader->busy = 0;
+                        *region_p = region;
+                        return UCS_OK;
+                    }
+
+                    /* Raced with an invalidation - undo the hold. The writer
+                     * saw either our reference (and marked the region invalid)
+                     * or a zero refcount (and deferred destruction); in the
+                     * first case the last one out must destroy the region.
+                     */
+                    if ((ucs_atomic_fadd32(&region->refcount, -1) == 1) &&
+                        (region->flags & UCS_RCACHE_REGION_FLAG_INVALID))
+                    {
+                        reader->busy = 0;
+                        pthread_rwlock_wrlock(&rcache->lock);
+                        ucs_rcache_write_section_begin(rcache);
+                        ucs_rcache_region_invalidate(rcache, region, 0, 1);
+                        ucs_rcache_write_section_end(rcache);
+                        pthread_rwlock_unlock(&rcache->lock);
+                        goto slow_path;
+                    }
+                }
             }
         }
+        reader->busy = 0;
     }
-    pthread_rwlock_unlock(&rcache->lock);
 
+slow_path:
     /* Fall back to slow version (with rw lock) in following cases:
+     * - a lock-free lookup raced with a page table update
      * - invalidation list not empty
      * - could not find cached region
      * - found unregistered region
@@ -527,11 +739,27 @@ void ucs_rcache_region_put(ucs_rcache_t *rcache, ucs_rcache_region_t *region)
         (region->refcount == 0))
     {
         pthread_rwlock_wrlock(&rcache->lock);
+        ucs_rcache_write_section_begin(rcache);
         ucs_rcache_region_invalidate(rcache, region, 0, 1);
+        ucs_rcache_write_section_end(rcache);
         pthread_rwlock_unlock(&rcache->lock);
+        ucs_rcache_victim_flush(rcache);
     }
 }
 
+void ucs_rcache_flush(ucs_rcache_t *rcache)
+{
+    ucs_trace_func("rcache=%s", rcache->name);
+
+    pthread_rwlock_wrlock(&rcache->lock);
+    ucs_rcache_write_section_begin(rcache);
+    ucs_rcache_check_inv_queue(rcache);
+    ucs_rcache_invalidate_range(rcache, 0, UCS_PGT_ADDR_MAX);
+    ucs_rcache_write_section_end(rcache);
+    pthread_rwlock_unlock(&rcache->lock);
+    ucs_rcache_victim_flush(rcache);
+}
+
 static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
                            const char *name
                            UCS_STATS_ARG(ucs_stats_node_t *stats_parent))
@@ -557,6 +785,12 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
 
     self->params = *params;
 
+    self->version      = 0;
+    self->dir_gc_count = 0;
+    memset((void*)self->readers, 0, sizeof(self->readers));
+    ucs_list_head_init(&self->gc_list);
+    ucs_list_head_init(&self->victim_list);
+
     self->name = strdup(name);
     if (self->name == NULL) {
         status = UCS_ERR_NO_MEMORY;
@@ -577,10 +811,27 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
         goto err_destroy_rwlock;
     }
 
+    ret = pthread_spin_init(&self->victim_lock, 0);
+    if (ret) {
+        ucs_error("pthread_spin_init() failed: %m");
+        status = UCS_ERR_INVALID_PARAM;
+        goto err_destroy_inv_q_lock;
+    }
+
+    /* Slab for page table directories. It is backed by plain mmap() chunks,
+     * both to pack the nodes into few pages and because directories are
+     * allocated from memory event context */
+    status = ucs_mpool_init(&self->pgt_dir_mp, 0, sizeof(ucs_pgt_dir_t), 0,
+                            UCS_PGT_ENTRY_MIN_ALIGN, 64, -1,
+                            &ucs_rcache_mp_ops, "rcache_pgt_dirs");
+    if (status != UCS_OK) {
+        goto err_destroy_victim_lock;
+    }
+
     status = ucs_pgtable_init(&self->pgtable, ucs_rcache_pgt_dir_alloc,
                               ucs_rcache_pgt_dir_release);
     if (status != UCS_OK) {
-        goto err_destroy_inv_q_lock;
+        goto err_destroy_pgt_dir_mp;
     }
 
     status = ucs_mpool_init(&self->inv_mp, 0, sizeof(ucs_rcache_inv_entry_t), 0,
@@ -596,12 +847,17 @@ static UCS_CLASS_INIT_FUNC(ucs_rcache_t, const ucs_rcache_params_t *params,
     }
 
     ucs_queue_head_init(&self->inv_q);
+    self->inv_count = 0;
     return UCS_OK;
 
 err_destroy_mp:
     ucs_mpool_cleanup(&self->inv_mp, 1);
 err_cleanup_pgtable:
     ucs_pgtable_cleanup(&self->pgtable);
+err_destroy_pgt_dir_mp:
+    ucs_mpool_cleanup(&self->pgt_dir_mp, 1);
+err_destroy_victim_lock:
+    pthread_spin_destroy(&self->victim_lock);
 err_destroy_inv_q_lock:
     pthread_spin_destroy(&self->inv_lock);
 err_destroy_rwlock:
@@ -616,11 +872,17 @@ static UCS_CLASS_CLEANUP_FUNC(ucs_rcache_t)
 {
     ucm_unset_event_handler(UCM_EVENT_VM_UNMAPPED, ucs_rcache_unmapped_callback,
                             self);
+    ucs_rcache_write_section_begin(self);
     ucs_rcache_check_inv_queue(self);
     ucs_rcache_purge(self);
+    ucs_rcache_write_section_end(self);
+    ucs_rcache_victim_flush(self);
 
     ucs_mpool_cleanup(&self->inv_mp, 1);
     ucs_pgtable_cleanup(&self->pgtable);
+    ucs_rcache_dir_gc_flush(self);
+    ucs_mpool_cleanup(&self->pgt_dir_mp, 1);
+    pthread_spin_destroy(&self->victim_lock);
     pthread_spin_destroy(&self->inv_lock);
     pthread_rwlock_destroy(&self->lock);
     free(self->name);
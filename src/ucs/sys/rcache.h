@@ -12,6 +12,7 @@
  * memory invalidation (if it's unmapped), merging of regions, protection flags.
  * This data structure is thread safe.
  */
+#include <ucs/arch/cpu.h>
 #include <ucs/datastruct/pgtable.h>
 #include <ucs/datastruct/list.h>
 #include <ucs/datastruct/queue.h>
@@ -24,6 +25,24 @@ typedef struct ucs_rcache_ops     ucs_rcache_ops_t;
 typedef struct ucs_rcache_params  ucs_rcache_params_t;
 typedef struct ucs_rcache_region  ucs_rcache_region_t;
 
+
+/* Number of slots for tracking threads inside the lock-free lookup path.
+ * Threads map to slots by hash; on a collision the lookup falls back to the
+ * locked path. Must be a power of 2. */
+#define UCS_RCACHE_READER_SLOTS   64
+
+/* Page table directories released in one write section before readers must be
+ * drained. A single remove releases at most the tree depth, so overflow is
+ * rare and only costs an extra drain. */
+#define UCS_RCACHE_DIR_GC_MAX     32
+
+
+/* Per-thread indicator that a lock-free lookup is in flight. Each slot gets
+ * its own cache line, so marking it does not bounce lines between readers. */
+typedef struct ucs_rcache_reader {
+    volatile uint32_t      busy;
+} UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE) ucs_rcache_reader_t;
+
 /*
  * Memory region flags.
  */
@@ -92,6 +111,11 @@ struct ucs_rcache_params {
     size_t                 alignment;           /**< Force-align regions to this size.
                                                      Must be smaller or equal to
                                                      system page size. */
+    size_t                 max_merged_size;     /**< Maximal size of a region created
+                                                     by merging adjacent or overlapping
+                                                     regions. 0 - unlimited. A single
+                                                     request larger than this is still
+                                                     registered as one region. */
     int                    ucm_event_priority;  /**< Priority of memory events */
     const ucs_rcache_ops_t *ops;                /**< Memory operations functions */
     void                   *context;            /**< User-defined context that will
@@ -115,12 +139,40 @@ struct ucs_rcache {
                                           whose refcount is 0 */
     ucs_pgtable_t          pgtable;  /**< page table to hold the regions */
 
+    volatile uint32_t      version;  /**< Page table modification counter. Odd
+                                          while a writer is changing the table;
+                                          lock-free lookups validate against it */
+    ucs_rcache_reader_t    readers[UCS_RCACHE_READER_SLOTS];
+                                     /**< Readers inside the lock-free lookup */
+    ucs_list_link_t        gc_list;  /**< Regions whose destruction is deferred
+                                          until in-flight readers drain */
+    ucs_pgt_dir_t          *dir_gc[UCS_RCACHE_DIR_GC_MAX];
+                                     /**< Page table directories released during
+                                          the current write section; freed after
+                                          readers drain */
+    unsigned               dir_gc_count;
+
+    ucs_mpool_t            pgt_dir_mp; /**< Slab for page table directories.
+                                          Packs sibling nodes into the same
+                                          mmap()ed pages, so a lookup's walk
+                                          down the tree touches nearby cache
+                                          lines instead of random heap
+                                          addresses. Used only with the page
+                                          table write lock held */
+
+    ucs_list_link_t        victim_list; /**< Invalidated regions whose expensive
+                                          deregistration is still pending; they
+                                          are deregistered in batches after the
+                                          page table lock is dropped */
+    pthread_spinlock_t     victim_lock; /**< Lock for victim_list */
+
     pthread_spinlock_t     inv_lock; /**< Lock for inv_q and inv_mp. This is a
                                           separate lock because we may want to put
                                           regions on inv_q while the page table
                                           lock is held by the calling context */
     ucs_queue_head_t       inv_q;    /**< Regions which were invalidated during
                                           memory events */
+    unsigned               inv_count; /**< Number of pending entries on inv_q */
     ucs_mpool_t            inv_mp;   /**< Memory pool to allocate entries for inv_q,
                                           since we cannot use regulat malloc().
                                           The backing storage is original mmap()
@@ -150,6 +202,16 @@ ucs_status_t ucs_rcache_create(const ucs_rcache_params_t *params, const char *na
 void ucs_rcache_destroy(ucs_rcache_t *rcache);
 
 
+/**
+ * Deregister all regions which are not currently in use and release their
+ * memory. Used to quiesce the cache before fork(), so pinned pages do not
+ * linger across it; regions held by the application stay valid.
+ *
+ * @param [in]  rcache      Registration cache to flush.
+ */
+void ucs_rcache_flush(ucs_rcache_t *rcache);
+
+
 /**
  * Resolve buffer in the registration cache, or register it if not found.
  * TODO register after N usages.
@@ -15,7 +15,9 @@
 #include "string.h"
 #include "math.h"
 
+#include <ucs/datastruct/list.h>
 #include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
 #include <ucs/time/time.h>
 #include <ucm/util/sys.h>
 #include <sys/ioctl.h>
@@ -25,6 +27,7 @@
 #include <net/if.h>
 #include <dirent.h>
 #include <sched.h>
+#include <pthread.h>
 
 
 /* Default huge page size is 2 MBytes */
@@ -33,6 +36,108 @@
 #define UCS_PROCESS_MAPS_FILE      "/proc/self/maps"
 
 
+typedef struct ucs_sys_atfork_handler {
+    ucs_list_link_t        list;
+    void                   (*prepare)(void *arg);
+    void                   (*child)(void *arg);
+    void                   *arg;
+} ucs_sys_atfork_handler_t;
+
+static UCS_LIST_HEAD(ucs_sys_atfork_handlers);
+static pthread_mutex_t ucs_sys_atfork_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile uint32_t ucs_sys_fork_counter = 0;
+
+
+static void ucs_sys_atfork_prepare()
+{
+    ucs_sys_atfork_handler_t *handler;
+
+    /* Hold the lock across the fork, so the handler list is consistent in the
+     * child; released by the parent/child hooks below */
+    pthread_mutex_lock(&ucs_sys_atfork_lock);
+    ucs_list_for_each(handler, &ucs_sys_atfork_handlers, list) {
+        if (handler->prepare != NULL) {
+            handler->prepare(handler->arg);
+        }
+    }
+}
+
+static void ucs_sys_atfork_parent()
+{
+    pthread_mutex_unlock(&ucs_sys_atfork_lock);
+}
+
+static void ucs_sys_atfork_child()
+{
+    ucs_sys_atfork_handler_t *handler;
+
+    ++ucs_sys_fork_counter;
+    ucs_list_for_each(handler, &ucs_sys_atfork_handlers, list) {
+        if (handler->child != NULL) {
+            handler->child(handler->arg);
+        }
+    }
+    pthread_mutex_unlock(&ucs_sys_atfork_lock);
+}
+
+ucs_status_t ucs_sys_atfork(void (*prepare)(void *arg),
+                            void (*child)(void *arg), void *arg)
+{
+    static int installed = 0;
+    ucs_sys_atfork_handler_t *handler;
+    ucs_status_t status;
+    int ret;
+
+    handler = ucs_malloc(sizeof(*handler), "atfork handler");
+    if (handler == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    handler->prepare = prepare;
+    handler->child   = child;
+    handler->arg     = arg;
+
+    pthread_mutex_lock(&ucs_sys_atfork_lock);
+    if (!installed) {
+        ret = pthread_atfork(ucs_sys_atfork_prepare, ucs_sys_atfork_parent,
+                             ucs_sys_atfork_child);
+        if (ret != 0) {
+            ucs_error("pthread_atfork() failed: %m");
+            status = UCS_ERR_INVALID_PARAM;
+            goto err_unlock;
+        }
+        installed = 1;
+    }
+
+    ucs_list_add_tail(&ucs_sys_atfork_handlers, &handler->list);
+    pthread_mutex_unlock(&ucs_sys_atfork_lock);
+    return UCS_OK;
+
+err_unlock:
+    pthread_mutex_unlock(&ucs_sys_atfork_lock);
+    ucs_free(handler);
+    return status;
+}
+
+void ucs_sys_atfork_remove(void *arg)
+{
+    ucs_sys_atfork_handler_t *handler, *tmp;
+
+    pthread_mutex_lock(&ucs_sys_atfork_lock);
+    ucs_list_for_each_safe(handler, tmp, &ucs_sys_atfork_handlers, list) {
+        if (handler->arg == arg) {
+            ucs_list_del(&handler->list);
+            ucs_free(handler);
+        }
+    }
+    pthread_mutex_unlock(&ucs_sys_atfork_lock);
+}
+
+uint32_t ucs_sys_fork_count()
+{
+    return ucs_sys_fork_counter;
+}
+
 const char *ucs_get_host_name()
 {
     static char hostname[256] = {0};
@@ -566,6 +671,95 @@ int ucs_get_mem_prot(unsigned long start, unsigned long end)
     return ctx.prot;
 }
 
+/* Memory policy constant from the kernel ABI, defined here to avoid a
+ * dependency on libnuma headers */
+#ifndef MPOL_PREFERRED
+#  define MPOL_PREFERRED 1
+#endif
+
+ucs_status_t ucs_sys_bind_numa(void *address, size_t length, int node)
+{
+#ifdef SYS_mbind
+    unsigned long nodemask[4] = {0};
+    uintptr_t start;
+    long ret;
+
+    if ((node < 0) || (node >= (int)(8 * sizeof(nodemask)))) {
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+    nodemask[node / (8 * sizeof(*nodemask))] |=
+        1ul << (node % (8 * sizeof(*nodemask)));
+
+    start = ucs_align_down_pow2((uintptr_t)address, ucs_get_page_size());
+    ret   = syscall(SYS_mbind, start, (uintptr_t)address + length - start,
+                    MPOL_PREFERRED, nodemask, 8 * sizeof(nodemask), 0);
+    if (ret < 0) {
+        ucs_debug("mbind(address=%p length=%zu node=%d) failed: %m", address,
+                  length, node);
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+#else
+    return UCS_ERR_UNSUPPORTED;
+#endif
+}
+
+void ucs_sys_alloc_apply_attr(void *address, size_t length,
+                              const ucs_sys_alloc_attr_t *attr)
+{
+    size_t page_size = ucs_get_page_size();
+    volatile unsigned char *p;
+    uintptr_t start, end;
+
+    start = ucs_align_down_pow2((uintptr_t)address, page_size);
+    end   = ucs_align_up_pow2((uintptr_t)address + length, page_size);
+
+#ifdef MADV_HUGEPAGE
+    if (attr->thp) {
+        if (madvise((void*)start, end - start, MADV_HUGEPAGE) != 0) {
+            ucs_trace("madvise(address=%p length=%zu MADV_HUGEPAGE) failed: %m",
+                      address, length);
+        }
+    }
+#endif
+
+    /* Bind before faulting in, so the pages are allocated on the right node */
+    if (attr->numa_node >= 0) {
+        ucs_sys_bind_numa(address, length, attr->numa_node);
+    }
+
+    if (attr->prefault && (length > 0)) {
+        /* Touch only bytes inside the region - the enclosing pages may hold
+         * unrelated data (e.g heap allocations) modified by other threads.
+         * Write, since a read maps the shared zero page and leaves the
+         * copy-on-write fault for the first real store */
+        for (p = (volatile unsigned char*)address;
+             (uintptr_t)p < ((uintptr_t)address + length); p += page_size) {
+            *p = *p;
+        }
+        p  = (volatile unsigned char*)address + length - 1;
+        *p = *p;
+    }
+}
+
+int ucs_sys_get_numa_node()
+{
+#ifdef SYS_getcpu
+    unsigned cpu, node;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) < 0) {
+        ucs_debug("getcpu() failed: %m");
+        return -1;
+    }
+
+    return node;
+#else
+    return -1;
+#endif
+}
+
 const char* ucs_get_process_cmdline()
 {
     static char cmdline[1024] = {0};
@@ -183,6 +183,82 @@ ucs_status_t ucs_sysv_alloc(size_t *size, void **address_p, int flags, int *shim
 ucs_status_t ucs_sysv_free(void *address);
 
 
+/**
+ * Set the preferred NUMA node for a range of memory. Pages which are not yet
+ * faulted in will be allocated from the given node, falling back to other
+ * nodes when it is out of memory. Pages which are already resident are not
+ * moved.
+ *
+ * @param address   Region start. Rounded down to the nearest page boundary.
+ * @param length    Region length.
+ * @param node      NUMA node to prefer.
+ */
+ucs_status_t ucs_sys_bind_numa(void *address, size_t length, int node);
+
+
+/**
+ * @return NUMA node the calling thread is currently running on, or -1 if it
+ *         cannot be determined.
+ */
+int ucs_sys_get_numa_node();
+
+
+/**
+ * Register fork handlers which run together with the handlers of other UCX
+ * components, in registration order. Unlike raw pthread_atfork(), handlers
+ * can be removed with @ref ucs_sys_atfork_remove, so objects shorter-lived
+ * than the process may use them.
+ *
+ * @param prepare   Called in the parent before fork(). May be NULL.
+ * @param child     Called in the child after fork(). May be NULL.
+ * @param arg       User-defined argument passed to the callbacks.
+ */
+ucs_status_t ucs_sys_atfork(void (*prepare)(void *arg),
+                            void (*child)(void *arg), void *arg);
+
+
+/**
+ * Remove all fork handlers which were registered with the given argument.
+ *
+ * @param arg       Argument the handlers were registered with.
+ */
+void ucs_sys_atfork_remove(void *arg);
+
+
+/**
+ * @return Number of times this process observed a fork() as the child, so
+ *         process-lifetime caches can detect that they crossed a fork.
+ */
+uint32_t ucs_sys_fork_count();
+
+
+/**
+ * Placement attributes to apply to a freshly allocated memory region.
+ * Huge pages are requested at allocation time (e.g SHM_HUGETLB/MAP_HUGETLB),
+ * so they are not part of this structure.
+ */
+typedef struct ucs_sys_alloc_attr {
+    int                  thp;       /* Advise the kernel to back the region
+                                       with transparent huge pages */
+    int                  prefault;  /* Touch every page, so first-touch faults
+                                       do not land on the data path */
+    int                  numa_node; /* Preferred NUMA node, -1 to keep the
+                                       default policy */
+} ucs_sys_alloc_attr_t;
+
+
+/**
+ * Apply placement attributes to a memory region. Attributes are applied on a
+ * best-effort basis - failures are logged and ignored.
+ *
+ * @param address   Region start.
+ * @param length    Region length.
+ * @param attr      Attributes to apply.
+ */
+void ucs_sys_alloc_apply_attr(void *address, size_t length,
+                              const ucs_sys_alloc_attr_t *attr);
+
+
 /**
  * Retrieve memory access flags for a given region of memory.
  * If the specified memory region has multiple different access flags, the AND
@@ -0,0 +1,136 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2016.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "topo.h"
+
+#include <ucs/debug/log.h>
+#include <ucs/debug/memtrack.h>
+#include <ucs/sys/sys.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+#define UCS_TOPO_NODE_SYSFS_FMT  "/sys/devices/system/node/node%d"
+#define UCS_TOPO_MAX_NODES       256
+
+typedef struct ucs_topo_context {
+    int             num_nodes;
+    int             *distance;  /* num_nodes x num_nodes SLIT matrix,
+                                   NULL if it could not be read */
+} ucs_topo_context_t;
+
+static ucs_topo_context_t ucs_topo_ctx = { 1, NULL };
+static pthread_once_t ucs_topo_once    = PTHREAD_ONCE_INIT;
+
+
+static void ucs_topo_read_distances()
+{
+    char buf[4096], path[128];
+    char *p, *endp;
+    int node, index;
+    ssize_t nread;
+    long value;
+
+    /* Count the nodes; the set is contiguous on Linux */
+    while ((ucs_topo_ctx.num_nodes < UCS_TOPO_MAX_NODES) &&
+           (snprintf(path, sizeof(path), UCS_TOPO_NODE_SYSFS_FMT,
+                     ucs_topo_ctx.num_nodes) > 0) &&
+           (access(path, F_OK) == 0))
+    {
+        ++ucs_topo_ctx.num_nodes;
+    }
+
+    if (ucs_topo_ctx.num_nodes == 1) {
+        return; /* Single node - distance is always local */
+    }
+
+    ucs_topo_ctx.distance = ucs_calloc(ucs_topo_ctx.num_nodes *
+                                       ucs_topo_ctx.num_nodes,
+                                       sizeof(*ucs_topo_ctx.distance),
+                                       "numa distance matrix");
+    if (ucs_topo_ctx.distance == NULL) {
+        return;
+    }
+
+    for (node = 0; node < ucs_topo_ctx.num_nodes; ++node) {
+        nread = ucs_read_file(buf, sizeof(buf), 1,
+                              UCS_TOPO_NODE_SYSFS_FMT "/distance", node);
+        if (nread < 0) {
+            goto err_free;
+        }
+
+        p = buf;
+        for (index = 0; index < ucs_topo_ctx.num_nodes; ++index) {
+            value = strtol(p, &endp, 10);
+            if (endp == p) {
+                goto err_free;
+            }
+
+            ucs_topo_ctx.distance[(node * ucs_topo_ctx.num_nodes) + index] =
+                            value;
+            p = endp;
+        }
+    }
+
+    ucs_debug("numa topology: %d nodes", ucs_topo_ctx.num_nodes);
+    return;
+
+err_free:
+    ucs_debug("failed to read numa distance matrix, using defaults");
+    ucs_free(ucs_topo_ctx.distance);
+    ucs_topo_ctx.distance = NULL;
+}
+
+static void ucs_topo_init_once()
+{
+    pthread_once(&ucs_topo_once, ucs_topo_read_distances);
+}
+
+int ucs_topo_num_numa_nodes()
+{
+    ucs_topo_init_once();
+    return ucs_topo_ctx.num_nodes;
+}
+
+int ucs_topo_numa_distance(int node1, int node2)
+{
+    ucs_topo_init_once();
+
+    if ((node1 < 0) || (node1 >= ucs_topo_ctx.num_nodes) ||
+        (node2 < 0) || (node2 >= ucs_topo_ctx.num_nodes))
+    {
+        return UCS_TOPO_DISTANCE_LOCAL; /* Unknown - assume local */
+    }
+
+    if (node1 == node2) {
+        return UCS_TOPO_DISTANCE_LOCAL;
+    }
+
+    if (ucs_topo_ctx.distance == NULL) {
+        return UCS_TOPO_DISTANCE_REMOTE;
+    }
+
+    return ucs_topo_ctx.distance[(node1 * ucs_topo_ctx.num_nodes) + node2];
+}
+
+int ucs_topo_device_numa_node(const char *dev_class, const char *dev_name)
+{
+    char buf[32];
+    int node;
+
+    if (ucs_read_file(buf, sizeof(buf), 1, "/sys/class/%s/%s/device/numa_node",
+                      dev_class, dev_name) < 0) {
+        return -1;
+    }
+
+    node = atoi(buf);
+    return (node >= 0) ? node : -1;
+}
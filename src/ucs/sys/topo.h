@@ -0,0 +1,55 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2016.  ALL RIGHTS RESERVED.
+ *
+ * See file LICENSE for terms.
+ */
+
+#ifndef UCS_TOPO_H
+#define UCS_TOPO_H
+
+#include <stddef.h>
+
+/*
+ * System topology service. The NUMA distance matrix and device locality are
+ * read from sysfs once per process and cached, so the queries below are cheap
+ * enough to use from resource selection code.
+ */
+
+
+/* ACPI SLIT distance of a node to itself */
+#define UCS_TOPO_DISTANCE_LOCAL    10
+
+/* Default distance between different nodes, when the matrix is unavailable */
+#define UCS_TOPO_DISTANCE_REMOTE   20
+
+
+/**
+ * @return Number of NUMA nodes in the system, at least 1.
+ */
+int ucs_topo_num_numa_nodes();
+
+
+/**
+ * Get the relative distance between two NUMA nodes, in ACPI SLIT units
+ * (10 - local). If either node is unknown (negative or out of range), the
+ * local distance is returned, so callers which scale by distance are not
+ * affected by missing locality information.
+ *
+ * @param node1  First NUMA node.
+ * @param node2  Second NUMA node.
+ * @return Distance between the nodes.
+ */
+int ucs_topo_numa_distance(int node1, int node2);
+
+
+/**
+ * Get the NUMA node a device is attached to, from
+ * /sys/class/<dev_class>/<dev_name>/device/numa_node.
+ *
+ * @param dev_class  Device class in sysfs, e.g "infiniband" or "net".
+ * @param dev_name   Device name within the class.
+ * @return NUMA node of the device, or -1 if it cannot be determined.
+ */
+int ucs_topo_device_numa_node(const char *dev_class, const char *dev_name);
+
+#endif
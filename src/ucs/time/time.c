@@ -6,17 +6,57 @@
 
 #include <ucs/time/time.h>
 #include <ucs/debug/log.h>
+#include <time.h>
 
 
+/* How long the initial cpuinfo-based frequency estimate must age, in wall
+ * time, before it is replaced by a measured value */
+#define UCS_TIME_CALIB_INTERVAL_SEC   0.1
+
+enum {
+    UCS_TIME_CALIB_UNINITIALIZED,
+    UCS_TIME_CALIB_ESTIMATED,
+    UCS_TIME_CALIB_REFINED
+};
+
+
+static double ucs_time_monotonic_sec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / (double)UCS_NSEC_PER_SEC);
+}
+
+/*
+ * The first call takes a cheap frequency estimate from cpuinfo, so process
+ * startup never blocks on a timed measurement. The hres clock keeps returning
+ * raw ticks - once enough wall time has passed in the background of normal
+ * usage, the estimate is replaced by the measured ratio of elapsed ticks to
+ * elapsed monotonic time, which is exact for invariant-TSC cpus.
+ */
 double ucs_get_cpu_clocks_per_sec()
 {
     static double clocks_per_sec = 0.0;
-    static int initialized = 0;
+    static uint64_t base_clock;
+    static double base_sec;
+    static int state = UCS_TIME_CALIB_UNINITIALIZED;
+    double elapsed_sec;
 
-    if (!initialized) {
+    if (state == UCS_TIME_CALIB_UNINITIALIZED) {
         clocks_per_sec = ucs_arch_get_clocks_per_sec();
-        ucs_debug("measured arch clock speed: %.2f Hz", clocks_per_sec);
-        initialized = 1;
+        base_clock     = ucs_arch_read_hres_clock();
+        base_sec       = ucs_time_monotonic_sec();
+        state          = UCS_TIME_CALIB_ESTIMATED;
+        ucs_debug("estimated arch clock speed: %.2f Hz", clocks_per_sec);
+    } else if (state == UCS_TIME_CALIB_ESTIMATED) {
+        elapsed_sec = ucs_time_monotonic_sec() - base_sec;
+        if (elapsed_sec >= UCS_TIME_CALIB_INTERVAL_SEC) {
+            clocks_per_sec = (ucs_arch_read_hres_clock() - base_clock) /
+                             elapsed_sec;
+            state          = UCS_TIME_CALIB_REFINED;
+            ucs_debug("measured arch clock speed: %.2f Hz", clocks_per_sec);
+        }
     }
     return clocks_per_sec;
 }
@@ -18,9 +18,11 @@ ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
 
     twheel->res         = ucs_roundup_pow2(resolution);
     twheel->res_order   = (unsigned) ucs_log2(twheel->res);
-    twheel->num_slots   = 1024;
-    twheel->current     = 0;
+    twheel->num_slots   = UCS_TWHEEL_NUM_LEVELS * UCS_TWHEEL_LEVEL_SLOTS;
+    twheel->current     = current_time >> twheel->res_order;
     twheel->now         = current_time;
+    twheel->earliest    = UCS_TIME_INFINITY;
+    twheel->count       = 0;
     twheel->wheel       = ucs_malloc(sizeof(*twheel->wheel) * twheel->num_slots,
                                      "twheel");
 
@@ -45,50 +47,138 @@ ucs_status_t ucs_wtimer_init(ucs_wtimer_t *t, ucs_twheel_callback_t cb)
     return UCS_OK;
 }
 
-void __ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer, ucs_time_t delta)
+/*
+ * Insert a timer to the slot matching its expiration time: the level is the
+ * coarsest one whose slot span still separates the timer from the current
+ * tick, and the slot within the level is derived from the absolute expiration
+ * tick, so cascading only moves timers to finer levels.
+ */
+static void ucs_twheel_place(ucs_twheel_t *t, ucs_wtimer_t *timer)
 {
-    uint64_t slot;
+    uint64_t tick  = timer->expiration >> t->res_order;
+    uint64_t delta = tick - t->current;
+    unsigned level, slot;
+
+    ucs_assert(delta > 0);
+
+    level = 0;
+    while (((delta >> UCS_TWHEEL_LEVEL_ORDER) != 0) &&
+           (level < (UCS_TWHEEL_NUM_LEVELS - 1)))
+    {
+        delta >>= UCS_TWHEEL_LEVEL_ORDER;
+        ++level;
+    }
+
+    slot = (tick >> (level * UCS_TWHEEL_LEVEL_ORDER)) &
+           (UCS_TWHEEL_LEVEL_SLOTS - 1);
+    ucs_list_add_tail(&t->wheel[(level * UCS_TWHEEL_LEVEL_SLOTS) + slot],
+                      &timer->list);
+}
 
+void __ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer, ucs_time_t delta)
+{
     timer->is_active = 1;
-    slot = delta>>t->res_order;
-    if (ucs_unlikely(slot == 0)) {
+    if (ucs_unlikely((delta >> t->res_order) == 0)) {
         /* nothing really wrong with adding timer to the current slot. However
          * we want to guard against the case we spend to much time in hi res
          * timer processing */
         ucs_fatal("Timer resolution is too low. Min resolution %lf usec, wanted %lf usec",
                 ucs_time_to_usec(t->res), ucs_time_to_usec(delta));
     }
-    ucs_assert(slot > 0);
 
-    if (ucs_unlikely(slot >= t->num_slots)) {
-        slot = t->num_slots - 1;
-    }
-
-    slot = (t->current + slot) % t->num_slots;
-    ucs_assert(slot != t->current);
-
-    ucs_list_add_tail(&t->wheel[slot], &timer->list);
+    timer->expiration = t->now + delta;
+    t->earliest       = ucs_min(t->earliest, timer->expiration);
+    ++t->count;
+    ucs_twheel_place(t, timer);
 }
 
 void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time)
 {
+    uint64_t tick = current_time >> t->res_order;
+    ucs_list_link_t cascade, *head;
     ucs_wtimer_t *timer;
-    uint64_t slot;
+    unsigned level, slot;
 
-    slot   = (current_time - t->now) >> t->res_order;
     t->now = current_time;
 
-    if (ucs_unlikely(slot >= t->num_slots)) {
-        slot = t->num_slots - 1;
+    /* Any timer left armed after this sweep expires on a later tick. This is
+     * a lower bound - callbacks re-arming timers tighten it in __ucs_wtimer_add,
+     * and it is cleared below if the wheel turns out to be empty. */
+    t->earliest = (tick + 1) << t->res_order;
+
+    if (ucs_unlikely((tick - t->current) >=
+                     UCS_BIT(UCS_TWHEEL_NUM_LEVELS * UCS_TWHEEL_LEVEL_ORDER)))
+    {
+        /* The jump is past the whole wheel range. The wheel may have been idle
+         * for longer than its range before the nearest timer came due, so slot
+         * position alone does not imply expiration - check every timer, and
+         * re-place the ones which are still in the future relative to the new
+         * current tick */
+        t->current = tick;
+        for (slot = 0; slot < t->num_slots; ++slot) {
+            head = &t->wheel[slot];
+            ucs_list_head_init(&cascade);
+            ucs_list_splice_tail(&cascade, head);
+            ucs_list_head_init(head);
+
+            while (!ucs_list_is_empty(&cascade)) {
+                timer = ucs_list_extract_head(&cascade, ucs_wtimer_t, list);
+                if ((timer->expiration >> t->res_order) <= t->current) {
+                    timer->is_active = 0;
+                    --t->count;
+                    timer->cb(timer);
+                } else {
+                    ucs_twheel_place(t, timer);
+                }
+            }
+        }
+        goto out;
     }
 
-    slot = (t->current + slot) % t->num_slots;
+    while (t->current < tick) {
+        ++t->current;
+
+        /* When a coarse level period boundary is crossed, cascade the timers
+         * of its current slot down to the finer levels */
+        for (level = 1; level < UCS_TWHEEL_NUM_LEVELS; ++level) {
+            if ((t->current & UCS_MASK(level * UCS_TWHEEL_LEVEL_ORDER)) != 0) {
+                break;
+            }
+
+            slot = (t->current >> (level * UCS_TWHEEL_LEVEL_ORDER)) &
+                   (UCS_TWHEEL_LEVEL_SLOTS - 1);
+            head = &t->wheel[(level * UCS_TWHEEL_LEVEL_SLOTS) + slot];
+
+            /* Detach the slot first - a timer which expires a whole level
+             * period from now maps back to the very same slot, and must wait
+             * there for the next lap instead of being cascaded in circles */
+            ucs_list_head_init(&cascade);
+            ucs_list_splice_tail(&cascade, head);
+            ucs_list_head_init(head);
+
+            while (!ucs_list_is_empty(&cascade)) {
+                timer = ucs_list_extract_head(&cascade, ucs_wtimer_t, list);
+                if ((timer->expiration >> t->res_order) <= t->current) {
+                    timer->is_active = 0;
+                    --t->count;
+                    timer->cb(timer);
+                } else {
+                    ucs_twheel_place(t, timer);
+                }
+            }
+        }
 
-    for (; t->current != slot; t->current = (t->current+1) % t->num_slots) {
-        while (!ucs_list_is_empty(&t->wheel[t->current])) {
-            timer = ucs_list_extract_head(&t->wheel[t->current], ucs_wtimer_t, list);
+        head = &t->wheel[t->current & (UCS_TWHEEL_LEVEL_SLOTS - 1)];
+        while (!ucs_list_is_empty(head)) {
+            timer = ucs_list_extract_head(head, ucs_wtimer_t, list);
             timer->is_active = 0;
+            --t->count;
             timer->cb(timer);
         }
     }
+
+out:
+    if (t->count == 0) {
+        t->earliest = UCS_TIME_INFINITY;
+    }
 }
@@ -17,6 +17,18 @@ typedef struct ucs_wtimer       ucs_wtimer_t;
 typedef struct ucs_timer_wheel  ucs_twheel_t;
 
 
+/*
+ * The wheel is hierarchical: level 0 holds one slot per resolution tick, and
+ * every next level is coarser by UCS_TWHEEL_LEVEL_ORDER bits, so a timer is
+ * always added and removed in O(1) regardless of how far it expires. When the
+ * sweep crosses a boundary of a coarse level, the timers of its current slot
+ * cascade down to the finer levels according to their expiration time.
+ */
+#define UCS_TWHEEL_NUM_LEVELS   4
+#define UCS_TWHEEL_LEVEL_ORDER  8
+#define UCS_TWHEEL_LEVEL_SLOTS  (1 << UCS_TWHEEL_LEVEL_ORDER)
+
+
 /**
  * Timer wheel callback
  */
@@ -29,6 +41,7 @@ typedef void (*ucs_twheel_callback_t)(ucs_wtimer_t *self);
 struct ucs_wtimer {
     ucs_twheel_callback_t  cb;         /* User callback */
     ucs_list_link_t        list;       /* Link in the list of timers */
+    ucs_time_t             expiration; /* Absolute expiration time */
     int                    is_active;
 };
 
@@ -36,8 +49,14 @@ struct ucs_wtimer {
 struct ucs_timer_wheel {
     ucs_time_t             res;
     ucs_time_t             now;        /* when wheel was last updated */
-    uint64_t               current;
-    ucs_list_link_t        *wheel;
+    uint64_t               current;    /* current resolution tick */
+    ucs_time_t             earliest;   /* lower bound on the nearest armed
+                                          expiration time; the sweep is a
+                                          no-op before it. UCS_TIME_INFINITY
+                                          when no timer is armed */
+    unsigned               count;      /* number of armed timers */
+    ucs_list_link_t        *wheel;     /* UCS_TWHEEL_NUM_LEVELS x
+                                          UCS_TWHEEL_LEVEL_SLOTS slots */
     unsigned               res_order;
     unsigned               num_slots;
 };
@@ -47,7 +66,7 @@ struct ucs_timer_wheel {
  * Initialize the timer queue.
  *
  * @param twheel        Timer queue to initialize.
- * @param resolution    Timer resolution. Timer wheel range is from now to now + UCS_TWHEEL_NSLOTS * res
+ * @param resolution    Timer resolution of the finest level.
  * @param current_time  Current time to initialize the timer with.
  */
 ucs_status_t ucs_twheel_init(ucs_twheel_t *twheel, ucs_time_t resolution,
@@ -82,6 +101,13 @@ ucs_status_t ucs_wtimer_init(ucs_wtimer_t *t, ucs_twheel_callback_t cb);
 void __ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time);
 static inline void ucs_twheel_sweep(ucs_twheel_t *t, ucs_time_t current_time)
 {
+    if (ucs_likely(current_time < t->earliest)) {
+        /* Nothing can be due yet - just remember the time, so that timers
+         * armed later are still scheduled relative to fresh time */
+        t->now = current_time;
+        return;
+    }
+
     if (ucs_unlikely(current_time - t->now >= t->res)) {
         __ucs_twheel_sweep(t, current_time);
     }
@@ -121,13 +147,18 @@ static inline ucs_status_t ucs_wtimer_add(ucs_twheel_t *t, ucs_wtimer_t *timer,
 /**
  * Remove a timer.
  *
+ * @param twheel     Timer queue the timer was scheduled on.
  * @param timer      timer to remove.
+ *
+ * @note The cached nearest expiration is left as-is - at worst it causes one
+ *       spurious sweep, while recomputing it would require a full scan.
  */
-static inline void ucs_wtimer_remove(ucs_wtimer_t *timer)
+static inline void ucs_wtimer_remove(ucs_twheel_t *t, ucs_wtimer_t *timer)
 {
     if (ucs_likely(timer->is_active)) {
         ucs_list_del(&timer->list);
         timer->is_active = 0;
+        --t->count;
     }
 }
 
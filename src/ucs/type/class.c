@@ -9,6 +9,18 @@
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/sys/math.h>
+#include <ucs/type/spinlock.h>
+
+
+/* Per-class freelist bounds. Only classes small enough to be churned in bulk
+ * (endpoints, mostly) are cached; a freed instance of a larger class, or one
+ * freed when the list is full, goes back to the heap. */
+#define UCS_CLASS_FREELIST_MAX_ELEMS      256
+#define UCS_CLASS_FREELIST_MAX_ELEM_SIZE  4096
+
+/* One lock for all freelists - they are touched only on object creation and
+ * destruction, which are control path */
+static ucs_ticket_lock_t ucs_class_freelist_lock = {0, 0};
 
 
 UCS_CLASS_INIT_FUNC(void)
@@ -25,7 +37,9 @@ ucs_class_t _UCS_CLASS_DECL_NAME(void) = {
     0,
     NULL,
     (ucs_class_init_func_t)_UCS_CLASS_INIT_NAME(void),
-    (ucs_class_cleanup_func_t)_UCS_CLASS_CLEANUP_NAME(void)
+    (ucs_class_cleanup_func_t)_UCS_CLASS_CLEANUP_NAME(void),
+    NULL,
+    0
 };
 
 void ucs_class_call_cleanup_chain(ucs_class_t *cls, void *obj, int limit)
@@ -54,10 +68,39 @@ void ucs_class_call_cleanup_chain(ucs_class_t *cls, void *obj, int limit)
 
 void *ucs_class_malloc(ucs_class_t *cls)
 {
+    void *obj;
+
+    /* Unlocked peek - a stale NULL just means one extra heap allocation */
+    if (cls->freelist != NULL) {
+        ucs_ticket_lock(&ucs_class_freelist_lock);
+        obj = cls->freelist;
+        if (obj != NULL) {
+            cls->freelist = *(void**)obj;
+            --cls->num_free;
+            ucs_ticket_unlock(&ucs_class_freelist_lock);
+            return obj;
+        }
+        ucs_ticket_unlock(&ucs_class_freelist_lock);
+    }
+
     return ucs_malloc(cls->size, cls->name);
 }
 
-void ucs_class_free(void *obj)
+void ucs_class_free(ucs_class_t *cls, void *obj)
 {
+    if ((cls->size >= sizeof(void*)) &&
+        (cls->size <= UCS_CLASS_FREELIST_MAX_ELEM_SIZE) &&
+        (cls->num_free < UCS_CLASS_FREELIST_MAX_ELEMS)) {
+        ucs_ticket_lock(&ucs_class_freelist_lock);
+        if (cls->num_free < UCS_CLASS_FREELIST_MAX_ELEMS) {
+            *(void**)obj  = cls->freelist;
+            cls->freelist = obj;
+            ++cls->num_free;
+            ucs_ticket_unlock(&ucs_class_freelist_lock);
+            return;
+        }
+        ucs_ticket_unlock(&ucs_class_freelist_lock);
+    }
+
     ucs_free(obj);
 }
@@ -24,6 +24,9 @@ struct ucs_class {
     ucs_class_t              *superclass;
     ucs_class_init_func_t    init;
     ucs_class_cleanup_func_t cleanup;
+    void                     *freelist;   /* Cache of freed instances, linked
+                                             through their first word */
+    unsigned                 num_free;    /* Current freelist length */
 };
 
 
@@ -72,7 +75,9 @@ struct ucs_class {
         sizeof(_type), \
         &_UCS_CLASS_DECL_NAME(_super), \
         (ucs_class_init_func_t)(_UCS_CLASS_INIT_NAME(_type)), \
-        (ucs_class_cleanup_func_t)(_UCS_CLASS_CLEANUP_NAME(_type)) \
+        (ucs_class_cleanup_func_t)(_UCS_CLASS_CLEANUP_NAME(_type)), \
+        NULL, \
+        0 \
     };
 
 
@@ -150,7 +155,7 @@ struct ucs_class {
             if (status == UCS_OK) { \
                 *(_obj) = (typeof(*(_obj)))obj; /* Success - assign pointer */ \
             } else { \
-                ucs_class_free(obj); /* Initialization failure */ \
+                ucs_class_free(cls, obj); /* Initialization failure */ \
             } \
         } else { \
             status = UCS_ERR_NO_MEMORY; /* Allocation failure */ \
@@ -168,8 +173,9 @@ struct ucs_class {
  */
 #define UCS_CLASS_DELETE(_type, _obj) \
     { \
+        extern ucs_class_t _UCS_CLASS_DECL_NAME(_type); \
         UCS_CLASS_CLEANUP(_type, _obj); \
-        ucs_class_free(_obj); \
+        ucs_class_free(&_UCS_CLASS_DECL_NAME(_type), _obj); \
     }
 
 
@@ -291,10 +297,12 @@ void ucs_class_call_cleanup_chain(ucs_class_t *cls, void *obj, int limit);
 
 
 /*
- * Helpers: Allocate/release objects.
+ * Helpers: Allocate/release objects. Released instances of small classes are
+ * cached on a per-class freelist and reused by the next allocation, so that
+ * endpoint churn does not go through the heap.
  */
 void *ucs_class_malloc(ucs_class_t *cls);
-void ucs_class_free(void *obj);
+void ucs_class_free(ucs_class_t *cls, void *obj);
 
 
 /**
@@ -8,28 +8,99 @@
 #define UCS_SPINLOCK_H
 
 #include <ucs/type/status.h>
+#include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
 #include <pthread.h>
+#include <sched.h>
+
+
+/* Max number of pause iterations between lock polls. Waiters back off
+ * exponentially up to this bound, which keeps the handoff latency bounded
+ * while avoiding cache-line storming under contention. */
+#define UCS_TICKET_LOCK_MAX_BACKOFF  64
+
+
+/**
+ * Ticket spinlock - non-reentrant, FIFO-fair.
+ * Waiters are served in arrival order, so no thread can be starved, and each
+ * waiter spins mostly on pause instructions instead of hammering the lock
+ * cache line.
+ */
+typedef struct ucs_ticket_lock {
+    volatile uint32_t next_ticket;  /* next ticket to hand out */
+    volatile uint32_t now_serving;  /* ticket currently holding the lock */
+} ucs_ticket_lock_t;
 
 
 /**
- * Reentrant spinlock.
+ * Reentrant spinlock, built on top of the ticket lock.
  */
 typedef struct ucs_spinlock {
-    pthread_spinlock_t lock;
+    ucs_ticket_lock_t  lock;
     int                count;
     pthread_t          owner;
 } ucs_spinlock_t;
 
 
-static inline ucs_status_t ucs_spinlock_init(ucs_spinlock_t *lock)
+static inline void ucs_ticket_lock_init(ucs_ticket_lock_t *lock)
+{
+    lock->next_ticket = 0;
+    lock->now_serving = 0;
+}
+
+static inline void ucs_ticket_lock_destroy(ucs_ticket_lock_t *lock)
+{
+}
+
+static inline int ucs_ticket_lock_is_locked(ucs_ticket_lock_t *lock)
+{
+    return lock->now_serving != lock->next_ticket;
+}
+
+static inline void ucs_ticket_lock(ucs_ticket_lock_t *lock)
 {
-    int ret;
+    uint32_t ticket = ucs_atomic_fadd32(&lock->next_ticket, 1);
+    unsigned backoff, i;
+
+    backoff = 1;
+    while (lock->now_serving != ticket) {
+        for (i = 0; i < backoff; ++i) {
+            ucs_cpu_relax();
+        }
+        if (backoff < UCS_TICKET_LOCK_MAX_BACKOFF) {
+            backoff <<= 1;
+        } else {
+            /* long wait - probably more runnable threads than cpus, and the
+             * ticket holder ahead of us is descheduled. Spinning would only
+             * delay it further, so give up the timeslice */
+            sched_yield();
+        }
+    }
+    ucs_memory_cpu_load_fence();
+}
+
+static inline int ucs_ticket_trylock(ucs_ticket_lock_t *lock)
+{
+    uint32_t serving = lock->now_serving;
 
-    ret = pthread_spin_init(&lock->lock, 0);
-    if (ret != 0) {
-        return UCS_ERR_IO_ERROR;
+    if ((lock->next_ticket != serving) ||
+        (ucs_atomic_cswap32(&lock->next_ticket, serving, serving + 1) != serving)) {
+        return 0;
     }
 
+    ucs_memory_cpu_load_fence();
+    return 1;
+}
+
+static inline void ucs_ticket_unlock(ucs_ticket_lock_t *lock)
+{
+    ucs_memory_cpu_store_fence();
+    lock->now_serving = lock->now_serving + 1;
+}
+
+static inline ucs_status_t ucs_spinlock_init(ucs_spinlock_t *lock)
+{
+    ucs_ticket_lock_init(&lock->lock);
     lock->count = 0;
     lock->owner = 0xfffffffful;
     return UCS_OK;
@@ -37,13 +108,7 @@ static inline ucs_status_t ucs_spinlock_init(ucs_spinlock_t *lock)
 
 static inline ucs_status_t ucs_spinlock_destroy(ucs_spinlock_t *lock)
 {
-    int ret;
-
-    ret = pthread_spin_destroy(&lock->lock);
-    if (ret != 0) {
-        return UCS_ERR_IO_ERROR;
-    }
-
+    ucs_ticket_lock_destroy(&lock->lock);
     return UCS_OK;
 }
 
@@ -61,7 +126,7 @@ static inline void ucs_spin_lock(ucs_spinlock_t *lock)
         return;
     }
 
-    pthread_spin_lock(&lock->lock);
+    ucs_ticket_lock(&lock->lock);
     lock->owner = self;
     ++lock->count;
 }
@@ -75,7 +140,7 @@ static inline int ucs_spin_trylock(ucs_spinlock_t *lock)
         return 1;
     }
 
-    if (pthread_spin_trylock(&lock->lock) != 0) {
+    if (!ucs_ticket_trylock(&lock->lock)) {
         return 0;
     }
 
@@ -89,7 +154,7 @@ static inline void ucs_spin_unlock(ucs_spinlock_t *lock)
     --lock->count;
     if (lock->count == 0) {
         lock->owner = 0xfffffffful;
-        pthread_spin_unlock(&lock->lock);
+        ucs_ticket_unlock(&lock->lock);
     }
 }
 
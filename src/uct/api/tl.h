@@ -118,6 +118,13 @@ typedef struct uct_iface_ops {
                                 unsigned header_length, const uct_iov_t *iov,
                                 size_t iovcnt, uct_completion_t *comp);
 
+    /* Optional one-to-many fanout of an identical short active message.
+     * NULL - a generic loop over ep_am_short is used. */
+    ucs_status_t (*iface_fanout_short)(uct_iface_h iface, uct_ep_h *eps,
+                                       unsigned num_eps, uint8_t id,
+                                       uint64_t header, const void *payload,
+                                       unsigned length, unsigned *num_sent_p);
+
     /* Atomics */
 
     ucs_status_t (*ep_atomic_add64)(uct_ep_h ep, uint64_t add,
@@ -152,7 +159,8 @@ typedef struct uct_iface_ops {
 
     /* Pending queue */
 
-    ucs_status_t (*ep_pending_add)(uct_ep_h ep, uct_pending_req_t *n);
+    ucs_status_t (*ep_pending_add)(uct_ep_h ep, uct_pending_req_t *n,
+                                   unsigned flags);
 
     void         (*ep_pending_purge)(uct_ep_h ep, uct_pending_purge_callback_t cb,
                                      void * arg);
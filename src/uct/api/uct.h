@@ -15,6 +15,7 @@
 #include <ucs/async/async_fwd.h>
 #include <ucs/config/types.h>
 #include <ucs/datastruct/callbackq.h>
+#include <ucs/sys/preprocessor.h>
 #include <ucs/type/status.h>
 #include <ucs/type/thread_mode.h>
 #include <ucs/type/cpu_set.h>
@@ -376,6 +377,8 @@ struct uct_iface_attr {
     double                   bandwidth;    /**< Maximal bandwidth, bytes/second */
     uct_linear_growth_t      latency;      /**< Latency model */
     uint8_t                  priority;     /**< Priority of device */
+    int                      numa_node;    /**< NUMA node the underlying device
+                                                is attached to, -1 if unknown */
 };
 
 
@@ -423,8 +426,11 @@ enum {
                                               remote memory key for remote memory
                                               operations */
     UCT_MD_FLAG_ADVISE    = UCS_BIT(4),  /**< MD support memory advice */
-    UCT_MD_FLAG_FIXED     = UCS_BIT(5)   /**< MD support memory allocation with
+    UCT_MD_FLAG_FIXED     = UCS_BIT(5),  /**< MD support memory allocation with
                                               fixed address */
+    UCT_MD_FLAG_RKEY_PTR  = UCS_BIT(6)   /**< MD supports direct access to
+                                              remote memory via a local pointer,
+                                              see @ref uct_rkey_ptr */
 };
 
 
@@ -517,7 +523,24 @@ typedef struct uct_rkey_bundle {
  */
 struct uct_completion {
     uct_completion_callback_t func;    /**< User callback function */
-    int                       count;   /**< Completion counter */
+    int                       count;   /**< Completion counter. Updated only from
+                                           the progress thread of the worker the
+                                           operations were issued on, so it is a
+                                           plain (non-atomic) counter even in
+                                           multi-threaded builds. */
+};
+
+
+/**
+ * @ingroup UCT_RESOURCE
+ * @brief Flags for @ref uct_ep_pending_add.
+ */
+enum uct_pending_flags {
+    UCT_PENDING_FLAG_CTRL = UCS_BIT(0) /**< The request carries a small protocol
+                                            control message. Transports which
+                                            support priority queuing may
+                                            dispatch it ahead of previously
+                                            queued data requests. */
 };
 
 
@@ -721,6 +744,90 @@ void uct_worker_destroy(uct_worker_h worker);
 void uct_worker_progress(uct_worker_h worker);
 
 
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Read the worker activity counter.
+ *
+ * The counter increments whenever an interface on the worker delivers an
+ * active message. Comparing its value across calls to
+ * @ref uct_worker_progress tells whether any traffic arrived, which a polling
+ * loop can use to back off while the worker is idle.
+ *
+ * @param [in]  worker        Handle to worker.
+ *
+ * @return Current value of the activity counter (wraps around).
+ */
+unsigned uct_worker_activity_count(uct_worker_h worker);
+
+
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Print a summary of progress-time accounting for the worker.
+ *
+ * When statistics are enabled at configure time, the progress loop samples one
+ * dispatch round out of every few and charges each registered callback with
+ * its elapsed cycles. This function reports, per callback, its share of the
+ * sampled progress time, along with the worker's poll hit rate - the fraction
+ * of progress calls during which any interface delivered a message. Without
+ * statistics support the report only says so.
+ *
+ * @param [in]  worker        Handle to worker.
+ * @param [in]  stream        Output stream to print to.
+ */
+void uct_worker_progress_stats_print(uct_worker_h worker, FILE *stream);
+
+
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Set the memory budget for the worker's buffer pools.
+ *
+ * Transport buffer pools (rx descriptors, bounce buffers) grow on demand to
+ * absorb bursts. When the total size of the pools tracked on the worker
+ * exceeds the budget, completely unused pool chunks are returned to the
+ * system from the progress slow path, bounding steady-state memory.
+ *
+ * @param [in]  worker        Handle to worker.
+ * @param [in]  budget        Budget in bytes, SIZE_MAX for unlimited.
+ */
+void uct_worker_set_mem_budget(uct_worker_h worker, size_t budget);
+
+
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Get the current memory footprint of the worker's buffer pools.
+ *
+ * @param [in]  worker        Handle to worker.
+ *
+ * @return Total size, in bytes, of the pools tracked on the worker.
+ */
+size_t uct_worker_mem_footprint(uct_worker_h worker);
+
+
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Progress callback priority.
+ *
+ * Fast-priority callbacks are dispatched on every call to
+ * @ref uct_worker_progress. Slow-priority callbacks are dispatched once per
+ * several calls, so that polling a high-latency interface does not add to the
+ * latency of low-latency interfaces on the same worker. An interface whose
+ * estimated latency exceeds @ref UCT_PROGRESS_SLOW_LATENCY should register
+ * with slow priority.
+ */
+typedef enum uct_progress_prio {
+    UCT_PROGRESS_PRIO_FAST, /**< Dispatched on every progress call */
+    UCT_PROGRESS_PRIO_SLOW  /**< Dispatched once per several progress calls */
+} uct_progress_prio_t;
+
+
+/**
+ * Interfaces whose latency (as reported in @ref uct_iface_attr_t) is above
+ * this threshold should register their progress callbacks with
+ * @ref UCT_PROGRESS_PRIO_SLOW.
+ */
+#define UCT_PROGRESS_SLOW_LATENCY    5e-6
+
+
 /**
  * @ingroup UCT_CONTEXT
  * @brief Add a callback function to a worker progress.
@@ -739,6 +846,22 @@ void uct_worker_progress_register(uct_worker_h worker,
                                   ucs_callback_t func, void *arg);
 
 
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Add a callback function to a worker progress, with a given priority.
+ *
+ * Same as @ref uct_worker_progress_register, except the callback is dispatched
+ * according to @a prio.
+ *
+ * @param [in]  worker        Handle to worker.
+ * @param [in]  func          Pointer to callback function.
+ * @param [in]  arg           Argument to the function.
+ * @param [in]  prio          Dispatch priority of the callback.
+ */
+void uct_worker_progress_register_prio(uct_worker_h worker, ucs_callback_t func,
+                                       void *arg, uct_progress_prio_t prio);
+
+
 /**
  * @ingroup UCT_CONTEXT
  * @brief Remove a callback function from worker's progress.
@@ -757,6 +880,23 @@ void uct_worker_progress_unregister(uct_worker_h worker,
                                     ucs_callback_t func, void *arg);
 
 
+/**
+ * @ingroup UCT_CONTEXT
+ * @brief Remove a callback function from worker's progress, with a given priority.
+ *
+ * Same as @ref uct_worker_progress_unregister, for a callback which was added
+ * by @ref uct_worker_progress_register_prio with the same @a prio.
+ *
+ * @param [in]  worker        Handle to worker.
+ * @param [in]  func          Pointer to callback function.
+ * @param [in]  arg           Argument to the function.
+ * @param [in]  prio          Dispatch priority the callback was added with.
+ */
+void uct_worker_progress_unregister_prio(uct_worker_h worker,
+                                         ucs_callback_t func, void *arg,
+                                         uct_progress_prio_t prio);
+
+
 /**
  * @ingroup UCT_CONTEXT
  * @brief Add a slow path callback function to a worker progress.
@@ -1411,6 +1551,29 @@ ucs_status_t uct_md_mkey_pack(uct_md_h md, uct_mem_h memh, void *rkey_buffer);
 ucs_status_t uct_rkey_unpack(const void *rkey_buffer, uct_rkey_bundle_t *rkey_ob);
 
 
+/**
+ * @ingroup UCT_MD
+ *
+ * @brief Get a local pointer to remote memory.
+ *
+ * This routine returns a local pointer to the remote memory described by the
+ * rkey bundle, so it can be accessed with ordinary loads and stores. It is
+ * supported only by memory domains which set @ref UCT_MD_FLAG_RKEY_PTR, e.g
+ * shared memory domains mapping the remote segment into the local address
+ * space.
+ *
+ * @param [in]  rkey_ob      A remote key bundle as returned by
+ *                           @ref uct_rkey_unpack.
+ * @param [in]  remote_addr  A remote address within the memory area described
+ *                           by the rkey.
+ * @param [out] addr_p       Filled with the local pointer to the remote memory.
+ *
+ * @return Error code.
+ */
+ucs_status_t uct_rkey_ptr(uct_rkey_bundle_t *rkey_ob, uint64_t remote_addr,
+                          void **addr_p);
+
+
 /**
  * @ingroup UCT_MD
  *
@@ -1602,6 +1765,34 @@ UCT_INLINE_API ucs_status_t uct_ep_get_zcopy(uct_ep_h ep,
 }
 
 
+#ifdef UCT_TL_STATIC
+/*
+ * A single transport was selected at configure time. Its active message entry
+ * points are declared here and called directly, so the compiler emits direct
+ * (and, with LTO, inlinable) calls instead of indirect ones. Such a build
+ * supports only the selected transport; the generic build is the default.
+ */
+#define UCT_TL_STATIC_FNAME(_op) \
+    UCS_PP_TOKENPASTE(uct_, UCS_PP_TOKENPASTE(UCT_TL_STATIC, _op))
+
+ucs_status_t UCT_TL_STATIC_FNAME(_ep_am_short)(uct_ep_h ep, uint8_t id,
+                                               uint64_t header,
+                                               const void *payload,
+                                               unsigned length);
+
+ssize_t UCT_TL_STATIC_FNAME(_ep_am_bcopy)(uct_ep_h ep, uint8_t id,
+                                          uct_pack_callback_t pack_cb,
+                                          void *arg);
+
+ucs_status_t UCT_TL_STATIC_FNAME(_ep_am_zcopy)(uct_ep_h ep, uint8_t id,
+                                               void *header,
+                                               unsigned header_length,
+                                               const uct_iov_t *iov,
+                                               size_t iovcnt,
+                                               uct_completion_t *comp);
+#endif
+
+
 /**
  * @ingroup UCT_AM
  * @brief
@@ -1609,7 +1800,11 @@ UCT_INLINE_API ucs_status_t uct_ep_get_zcopy(uct_ep_h ep,
 UCT_INLINE_API ucs_status_t uct_ep_am_short(uct_ep_h ep, uint8_t id, uint64_t header,
                                             const void *payload, unsigned length)
 {
+#ifdef UCT_TL_STATIC
+    return UCT_TL_STATIC_FNAME(_ep_am_short)(ep, id, header, payload, length);
+#else
     return ep->iface->ops.ep_am_short(ep, id, header, payload, length);
+#endif
 }
 
 
@@ -1620,7 +1815,11 @@ UCT_INLINE_API ucs_status_t uct_ep_am_short(uct_ep_h ep, uint8_t id, uint64_t he
 UCT_INLINE_API ssize_t uct_ep_am_bcopy(uct_ep_h ep, uint8_t id,
                                        uct_pack_callback_t pack_cb, void *arg)
 {
+#ifdef UCT_TL_STATIC
+    return UCT_TL_STATIC_FNAME(_ep_am_bcopy)(ep, id, pack_cb, arg);
+#else
     return ep->iface->ops.ep_am_bcopy(ep, id, pack_cb, arg);
+#endif
 }
 
 
@@ -1659,9 +1858,42 @@ UCT_INLINE_API ucs_status_t uct_ep_am_zcopy(uct_ep_h ep, uint8_t id, void *heade
                                             const uct_iov_t *iov, size_t iovcnt,
                                             uct_completion_t *comp)
 {
+#ifdef UCT_TL_STATIC
+    return UCT_TL_STATIC_FNAME(_ep_am_zcopy)(ep, id, header, header_length,
+                                             iov, iovcnt, comp);
+#else
     return ep->iface->ops.ep_am_zcopy(ep, id, header, header_length, iov, iovcnt, comp);
+#endif
 }
 
+
+/**
+ * @ingroup UCT_AM
+ * @brief Post the same short active message to multiple endpoints.
+ *
+ * Sends an identical header and payload to the endpoints in @a eps, which
+ * must all belong to @a iface, amortizing the per-send setup across the
+ * fanout. Posting stops at the first endpoint which fails to send (e.g.
+ * out of resources); the number of endpoints actually posted is returned
+ * in @a num_sent_p, so the caller can resume from eps[*num_sent_p].
+ *
+ * @param [in]  eps         Array of destination endpoint handles.
+ * @param [in]  num_eps     Number of endpoints in @a eps.
+ * @param [in]  id          Active message id. Must be in range 0..UCT_AM_ID_MAX-1.
+ * @param [in]  header      Active message header.
+ * @param [in]  payload     Payload to send to every endpoint.
+ * @param [in]  length      Payload length in bytes.
+ * @param [out] num_sent_p  Filled with the number of endpoints posted.
+ *
+ * @return UCS_OK - all endpoints were posted, otherwise the error which
+ *         stopped the fanout.
+ */
+ucs_status_t uct_iface_fanout_short(uct_iface_h iface, uct_ep_h *eps,
+                                    unsigned num_eps, uint8_t id,
+                                    uint64_t header, const void *payload,
+                                    unsigned length, unsigned *num_sent_p);
+
+
 /**
  * @ingroup UCT_AMO
  * @brief
@@ -1769,15 +2001,18 @@ UCT_INLINE_API ucs_status_t uct_ep_atomic_cswap32(uct_ep_h ep, uint32_t compare,
  *                    the "func" field.
  *                    After passed to the function, the request is owned by UCT,
  *                    until the callback is called and returns UCS_OK.
+ * @param [in]  flags Flags from @ref uct_pending_flags. Transports are allowed
+ *                    to ignore them.
  *
  * @return UCS_OK       - request added to pending queue
  *         UCS_ERR_BUSY - request was not added to pending queue, because send
  *                        resources are available now. The user is advised to
  *                        retry.
  */
-UCT_INLINE_API ucs_status_t uct_ep_pending_add(uct_ep_h ep, uct_pending_req_t *req)
+UCT_INLINE_API ucs_status_t uct_ep_pending_add(uct_ep_h ep, uct_pending_req_t *req,
+                                               unsigned flags)
 {
-    return ep->iface->ops.ep_pending_add(ep, req);
+    return ep->iface->ops.ep_pending_add(ep, req, flags);
 }
 
 
@@ -0,0 +1,106 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "uct_capture.h"
+
+#include <ucs/arch/atomic.h>
+#include <ucs/debug/log.h>
+#include <ucs/sys/string.h>
+#include <ucs/sys/sys.h>
+#include <sys/mman.h>
+
+
+ucs_status_t uct_capture_init(uct_capture_t *capture, const char *tmpl,
+                              const char *name, unsigned count)
+{
+    static volatile uint32_t file_seq = 0;
+    char filename[1024] = {0};
+    char fullpath[1024] = {0};
+    uct_capture_header_t *header;
+    unsigned num_records;
+    ucs_status_t status;
+    size_t length;
+    void *ptr;
+    int fd;
+
+    capture->header  = NULL;
+    capture->records = NULL;
+
+    if ((tmpl == NULL) || (strlen(tmpl) == 0)) {
+        return UCS_OK;
+    }
+
+    ucs_fill_filename_template(tmpl, filename, sizeof(filename));
+    ucs_expand_path(filename, fullpath, sizeof(fullpath) - 32);
+
+    /* every interface of every process writes its own ring */
+    snprintf(fullpath + strlen(fullpath), 32, ".%d.%u", getpid(),
+             ucs_atomic_fadd32(&file_seq, 1));
+
+    num_records = ucs_roundup_pow2(ucs_max(count, 2));
+    length      = sizeof(*header) + (num_records * sizeof(uct_capture_record_t));
+
+    fd = open(fullpath, O_RDWR|O_CREAT|O_TRUNC, 0600);
+    if (fd < 0) {
+        ucs_error("failed to create wire capture file '%s': %m", fullpath);
+        status = UCS_ERR_IO_ERROR;
+        goto err;
+    }
+
+    if (ftruncate(fd, length) < 0) {
+        ucs_error("failed to resize wire capture file '%s' to %zu bytes: %m",
+                  fullpath, length);
+        status = UCS_ERR_IO_ERROR;
+        goto err_close;
+    }
+
+    ptr = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        ucs_error("failed to map wire capture file '%s': %m", fullpath);
+        status = UCS_ERR_IO_ERROR;
+        goto err_close;
+    }
+
+    /* the mapping keeps the file alive; records land in the page cache and
+     * survive even an abnormal process exit */
+    close(fd);
+
+    header              = ptr;
+    header->magic       = UCT_CAPTURE_MAGIC;
+    header->version     = UCT_CAPTURE_VERSION;
+    header->record_size = sizeof(uct_capture_record_t);
+    header->pid         = getpid();
+    header->num_records = num_records;
+    header->total_count = 0;
+    header->one_second  = ucs_time_from_sec(1.0);
+    header->start_time  = ucs_get_time();
+    ucs_snprintf_zero(header->name, sizeof(header->name), "%s", name);
+
+    capture->header  = header;
+    capture->records = (uct_capture_record_t*)(header + 1);
+    capture->mask    = num_records - 1;
+    capture->length  = length;
+
+    ucs_debug("capturing wire trace of %s to '%s' (%u records)", name,
+              fullpath, num_records);
+    return UCS_OK;
+
+err_close:
+    close(fd);
+err:
+    return status;
+}
+
+void uct_capture_cleanup(uct_capture_t *capture)
+{
+    if (capture->header == NULL) {
+        return;
+    }
+
+    munmap(capture->header, capture->length);
+    capture->header  = NULL;
+    capture->records = NULL;
+}
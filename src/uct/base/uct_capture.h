@@ -0,0 +1,114 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#ifndef UCT_CAPTURE_H_
+#define UCT_CAPTURE_H_
+
+#include <uct/api/uct_def.h>
+#include <ucs/sys/compiler.h>
+#include <ucs/sys/math.h>
+#include <ucs/time/time.h>
+#include <ucs/type/status.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/*
+ * Binary wire-trace capture: every message an interface sends or receives is
+ * recorded as a fixed-size record in a per-interface mmap'd ring file, using
+ * plain stores only - cheap enough to leave enabled at millions of messages
+ * per second, unlike the text dumps of the data tracing log. The ring wraps,
+ * keeping the most recent records. Decode the file with ucx_read_capture.
+ */
+
+#define UCT_CAPTURE_MAGIC         0x74706375 /* "ucpt" */
+#define UCT_CAPTURE_VERSION       1
+#define UCT_CAPTURE_PAYLOAD_SIZE  48
+#define UCT_CAPTURE_NAME_MAX      64
+
+
+/**
+ * Capture file header. The file is the header followed by num_records
+ * fixed-size records; total_count tells the decoder how many were written
+ * and where the ring wrapped.
+ */
+typedef struct uct_capture_header {
+    uint32_t magic;         /* UCT_CAPTURE_MAGIC */
+    uint32_t version;       /* UCT_CAPTURE_VERSION */
+    uint32_t record_size;   /* sizeof(uct_capture_record_t) */
+    uint32_t pid;           /* Process which wrote the capture */
+    uint64_t num_records;   /* Ring capacity */
+    uint64_t total_count;   /* Records written since the capture started */
+    uint64_t one_second;    /* Timestamp units in one second */
+    uint64_t start_time;    /* Timestamp of capture creation */
+    char     name[UCT_CAPTURE_NAME_MAX]; /* Owning interface identification */
+} uct_capture_header_t;
+
+
+/**
+ * One captured message. 64 bytes, so a record never splits a cache line.
+ */
+typedef struct uct_capture_record {
+    uint64_t timestamp;    /* ucs_get_time() at capture */
+    uint32_t length;       /* Full message length */
+    uint8_t  type;         /* uct_am_trace_type_t */
+    uint8_t  am_id;        /* Active message id / opcode */
+    uint16_t caplen;       /* Valid bytes in payload[] */
+    char     payload[UCT_CAPTURE_PAYLOAD_SIZE]; /* First payload bytes */
+} uct_capture_record_t;
+
+
+/**
+ * Per-interface capture state. When the capture is disabled, header is NULL
+ * and the send/receive paths pay a single predictable branch.
+ */
+typedef struct uct_capture {
+    uct_capture_header_t *header;  /* mmap'd file, NULL if disabled */
+    uct_capture_record_t *records; /* Ring, right after the header */
+    uint64_t             mask;     /* Ring capacity - 1 */
+    size_t               length;   /* Total mapped length */
+} uct_capture_t;
+
+
+/**
+ * Open a capture ring file and map it. A zero-length file template disables
+ * the capture. The expanded file name gets a ".<pid>.<seq>" suffix, so every
+ * interface of every process writes its own file.
+ *
+ * @param [in]  capture   Capture state to initialize.
+ * @param [in]  tmpl      File name template (see UCX_LOG_FILE substitutions).
+ * @param [in]  name      Interface identification, stored in the file header.
+ * @param [in]  count     Ring capacity, rounded up to a power of two.
+ */
+ucs_status_t uct_capture_init(uct_capture_t *capture, const char *tmpl,
+                              const char *name, unsigned count);
+
+void uct_capture_cleanup(uct_capture_t *capture);
+
+
+/**
+ * Record one message. Called only when the capture is enabled.
+ */
+static UCS_F_ALWAYS_INLINE void
+uct_capture_record_data(uct_capture_t *capture, uct_am_trace_type_t type,
+                        uint8_t am_id, const void *data, size_t length)
+{
+    uct_capture_record_t *rec;
+    size_t caplen;
+
+    rec    = &capture->records[capture->header->total_count & capture->mask];
+    caplen = ucs_min(length, UCT_CAPTURE_PAYLOAD_SIZE);
+
+    rec->timestamp = ucs_get_time();
+    rec->length    = length;
+    rec->type      = type;
+    rec->am_id     = am_id;
+    rec->caplen    = caplen;
+    memcpy(rec->payload, data, caplen);
+    ++capture->header->total_count;
+}
+
+#endif
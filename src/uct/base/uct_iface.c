@@ -9,6 +9,7 @@
 #include "uct_md.h"
 
 #include <uct/api/uct.h>
+#include <ucs/sys/string.h>
 #include <ucs/time/time.h>
 
 
@@ -56,9 +57,9 @@ static ucs_status_t uct_iface_stub_am_handler(void *arg, void *data,
 
 static void uct_iface_set_stub_am_handler(uct_base_iface_t *iface, uint8_t id)
 {
-    iface->am[id].cb    = uct_iface_stub_am_handler;
-    iface->am[id].arg   = (void*)(uintptr_t)id;
-    iface->am[id].flags = UCT_AM_CB_FLAG_ASYNC;
+    iface->am[id].cb     = uct_iface_stub_am_handler;
+    iface->am[id].arg    = (void*)(uintptr_t)id;
+    iface->am_flags[id]  = UCT_AM_CB_FLAG_ASYNC;
 }
 
 ucs_status_t uct_iface_set_am_handler(uct_iface_h tl_iface, uint8_t id,
@@ -98,9 +99,9 @@ ucs_status_t uct_iface_set_am_handler(uct_iface_h tl_iface, uint8_t id,
         return UCS_ERR_INVALID_PARAM;
     }
 
-    iface->am[id].cb    = cb;
-    iface->am[id].arg   = arg;
-    iface->am[id].flags = flags;
+    iface->am[id].cb     = cb;
+    iface->am[id].arg    = arg;
+    iface->am_flags[id]  = flags;
     return UCS_OK;
 }
 
@@ -166,6 +167,34 @@ ucs_status_t uct_ep_check(const uct_ep_h ep, unsigned flags,
     return ep->iface->ops.ep_check(ep, flags, comp);
 }
 
+ucs_status_t uct_iface_fanout_short(uct_iface_h iface, uct_ep_h *eps,
+                                    unsigned num_eps, uint8_t id,
+                                    uint64_t header, const void *payload,
+                                    unsigned length, unsigned *num_sent_p)
+{
+    ucs_status_t status;
+    unsigned i;
+
+    if (iface->ops.iface_fanout_short != NULL) {
+        return iface->ops.iface_fanout_short(iface, eps, num_eps, id, header,
+                                             payload, length, num_sent_p);
+    }
+
+    /* Generic fallback: a tight loop over the transport short send, stopping
+     * at the first endpoint which cannot post */
+    status = UCS_OK;
+    for (i = 0; i < num_eps; ++i) {
+        ucs_assert(eps[i]->iface == iface);
+        status = iface->ops.ep_am_short(eps[i], id, header, payload, length);
+        if (status != UCS_OK) {
+            break;
+        }
+    }
+
+    *num_sent_p = i;
+    return status;
+}
+
 ucs_status_t uct_wakeup_open(uct_iface_h iface, unsigned events,
                              uct_wakeup_h *wakeup_p)
 {
@@ -364,8 +393,10 @@ UCS_CLASS_INIT_FUNC(uct_base_iface_t, uct_iface_ops_t *ops, uct_md_h md,
                     UCS_STATS_ARG(ucs_stats_node_t *stats_parent)
                     UCS_STATS_ARG(const char *iface_name))
 {
+    char capture_name[UCT_CAPTURE_NAME_MAX];
     uint64_t alloc_methods_bitmap;
     uct_alloc_method_t method;
+    ucs_status_t status;
     unsigned i;
     uint8_t id;
 
@@ -377,6 +408,7 @@ UCS_CLASS_INIT_FUNC(uct_base_iface_t, uct_iface_ops_t *ops, uct_md_h md,
     self->am_tracer_arg   = NULL;
     self->err_handler     = params->err_handler;
     self->err_handler_arg = params->err_handler_arg;
+    self->numa_node       = -1;
 
     for (id = 0; id < UCT_AM_ID_MAX; ++id) {
         uct_iface_set_stub_am_handler(self, id);
@@ -399,12 +431,26 @@ UCS_CLASS_INIT_FUNC(uct_base_iface_t, uct_iface_ops_t *ops, uct_md_h md,
 
     self->config.failure_level = config->failure;
 
-    return UCS_STATS_NODE_ALLOC(&self->stats, &uct_iface_stats_class,
-                                stats_parent, "-%s-%p", iface_name, self);
+    ucs_snprintf_zero(capture_name, sizeof(capture_name), "%s/%s",
+                      (params->tl_name  != NULL) ? params->tl_name  : "-",
+                      (params->dev_name != NULL) ? params->dev_name : "-");
+    status = uct_capture_init(&self->capture, config->capture.file,
+                              capture_name, config->capture.count);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = UCS_STATS_NODE_ALLOC(&self->stats, &uct_iface_stats_class,
+                                  stats_parent, "-%s-%p", iface_name, self);
+    if (status != UCS_OK) {
+        uct_capture_cleanup(&self->capture);
+    }
+    return status;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_base_iface_t)
 {
+    uct_capture_cleanup(&self->capture);
     UCS_STATS_NODE_FREE(self->stats);
 }
 
@@ -490,5 +536,17 @@ ucs_config_field_t uct_iface_config_table[] = {
    "Level of network failure reporting",
    ucs_offsetof(uct_iface_config_t, failure), UCS_CONFIG_TYPE_ENUM(ucs_log_level_names)},
 
+  {"CAPTURE_FILE", "",
+   "If non-empty, capture a binary wire-trace of all messages the interface sends\n"
+   "and receives to this file (%h: host, %p: pid, %c: cpu, %t: time, %e: exe).\n"
+   "Each interface maps its own ring of fixed-size records, cheap enough for\n"
+   "production message rates. Decode with ucx_read_capture.",
+   ucs_offsetof(uct_iface_config_t, capture.file), UCS_CONFIG_TYPE_STRING},
+
+  {"CAPTURE_COUNT", "65536",
+   "Capacity of the wire-trace capture ring, in records. Rounded up to a power\n"
+   "of two; when the ring wraps, the most recent records are kept.",
+   ucs_offsetof(uct_iface_config_t, capture.count), UCS_CONFIG_TYPE_UINT},
+
   {NULL}
 };
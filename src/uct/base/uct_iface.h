@@ -9,6 +9,7 @@
 
 #include <uct/api/uct.h>
 #include <uct/base/addr.h>
+#include <uct/base/uct_capture.h>
 #include <ucs/config/parser.h>
 #include <ucs/datastruct/mpool.h>
 #include <ucs/datastruct/queue.h>
@@ -83,7 +84,7 @@ enum {
  * for error flow as well.
  */
 #define UCT_CHECK_PARAM(_condition, _err_message, ...) \
-    if (ENABLE_PARAMS_CHECK && !(_condition)) { \
+    if (ENABLE_PARAMS_CHECK && ucs_unlikely(!(_condition))) { \
         ucs_error(_err_message, ## __VA_ARGS__); \
         return UCS_ERR_INVALID_PARAM; \
     }
@@ -93,7 +94,7 @@ enum {
  * Check the condition and return status as a pointer if not true.
  */
 #define UCT_CHECK_PARAM_PTR(_condition, _err_message, ...) \
-    if (ENABLE_PARAMS_CHECK && !(_condition)) { \
+    if (ENABLE_PARAMS_CHECK && ucs_unlikely(!(_condition))) { \
         ucs_error(_err_message, ## __VA_ARGS__); \
         return UCS_STATUS_PTR(UCS_ERR_INVALID_PARAM); \
     }
@@ -152,12 +153,13 @@ UCS_CLASS_DECLARE(uct_ep_t, uct_iface_h);
 
 
 /**
- * Active message handle table entry
+ * Active message handle table entry - only the fields read on every received
+ * message. The entry is exactly 16 bytes, so four entries pack into one cache
+ * line; the rarely-consulted handler flags live in a separate byte array.
  */
 typedef struct uct_am_handler {
     uct_am_callback_t cb;
     void              *arg;
-    uint32_t          flags;
 } uct_am_handler_t;
 
 
@@ -181,8 +183,10 @@ typedef struct uct_base_iface {
     uct_worker_h      worker;                /* Worker this interface is on */
     UCS_STATS_NODE_DECLARE(stats);           /* Statistics */
     uct_am_handler_t  am[UCT_AM_ID_MAX];     /* Active message table */
+    uint8_t           am_flags[UCT_AM_ID_MAX]; /* Handler flags (UCT_AM_CB_FLAG_*) */
     uct_am_tracer_t   am_tracer;             /* Active message tracer */
     void              *am_tracer_arg;        /* Tracer argument */
+    uct_capture_t     capture;               /* Binary wire-trace ring */
 
     struct {
         unsigned            num_alloc_methods;
@@ -190,6 +194,11 @@ typedef struct uct_base_iface {
         ucs_log_level_t     failure_level;
     } config;
 
+    int               numa_node;               /* Preferred NUMA node for iface
+                                                  memory, -1 if unknown. Set by
+                                                  the transport from the device
+                                                  locality. */
+
     uct_error_handler_t err_handler;         /* Error handler */
     void                *err_handler_arg;    /* Error handler argument */
 
@@ -268,6 +277,11 @@ struct uct_iface_config {
     } alloc_methods;
 
     int               failure;   /* Level of failure reports */
+
+    struct {
+        char          *file;     /* Wire capture ring file, empty disables */
+        unsigned      count;     /* Wire capture ring capacity */
+    } capture;
 };
 
 
@@ -377,6 +391,10 @@ typedef struct {
         _base_priv = ucs_queue_head_elem_non_empty((_queue), uct_pending_req_priv_t, \
                                                    queue); \
         \
+        /* overlap fetching the next request with dispatching this one */ \
+        ucs_prefetch(ucs_container_of(_base_priv->queue.next, \
+                                      uct_pending_req_priv_t, queue)); \
+        \
         UCS_STATIC_ASSERT(sizeof(*(_priv)) <= UCT_PENDING_REQ_PRIV_LEN); \
         _priv = ucs_derived_of(_base_priv, typeof(*(_priv))); \
         \
@@ -408,7 +426,7 @@ typedef struct {
         uct_pending_req_priv_t *_base_priv; \
         ucs_queue_iter_t _iter; \
         \
-        ucs_queue_for_each_safe(_base_priv, _iter, _queue, queue) { \
+        ucs_queue_for_each_safe_pf(_base_priv, _iter, _queue, queue) { \
             _priv = ucs_derived_of(_base_priv, typeof(*_priv)); \
             if (_cond) { \
                 ucs_queue_del_iter(_queue, _iter); \
@@ -428,12 +446,18 @@ typedef struct {
  * @paral _length   Active message length
  */
 #define uct_iface_trace_am(_iface, _type, _am_id, _payload, _length, _fmt, ...) \
-    if (ucs_log_enabled(UCS_LOG_LEVEL_TRACE_DATA)) { \
-        char buf[256] = {0}; \
-        uct_iface_dump_am(_iface, _type, _am_id, _payload, _length, \
-                          buf, sizeof(buf) - 1); \
-        ucs_trace_data(_fmt " am_id %d len %zu %s", ## __VA_ARGS__, \
-                       _am_id, (size_t)(_length), buf); \
+    { \
+        if (ucs_unlikely((_iface)->capture.header != NULL)) { \
+            uct_capture_record_data(&(_iface)->capture, _type, _am_id, \
+                                    _payload, _length); \
+        } \
+        if (ucs_log_enabled(UCS_LOG_LEVEL_TRACE_DATA)) { \
+            char buf[256] = {0}; \
+            uct_iface_dump_am(_iface, _type, _am_id, _payload, _length, \
+                              buf, sizeof(buf) - 1); \
+            ucs_trace_data(_fmt " am_id %d len %zu %s", ## __VA_ARGS__, \
+                           _am_id, (size_t)(_length), buf); \
+        } \
     }
 
 
@@ -489,6 +513,11 @@ void uct_set_ep_failed(ucs_class_t* cls, uct_ep_h tl_ep, uct_iface_h tl_iface);
  * @param length   Length of received data.
  * @param flags    Mask with @ref uct_cb_flags
  */
+/* Count a unit of work on the worker's activity counter; out-of-line since
+ * uct_worker_t is opaque here */
+void uct_worker_activity_add(uct_worker_h worker);
+
+
 static inline ucs_status_t
 uct_iface_invoke_am(uct_base_iface_t *iface, uint8_t id, void *data,
                     unsigned length, unsigned flags)
@@ -499,6 +528,7 @@ uct_iface_invoke_am(uct_base_iface_t *iface, uint8_t id, void *data,
     ucs_assert(id < UCT_AM_ID_MAX);
     UCS_STATS_UPDATE_COUNTER(iface->stats, UCT_IFACE_STAT_RX_AM, 1);
     UCS_STATS_UPDATE_COUNTER(iface->stats, UCT_IFACE_STAT_RX_AM_BYTES, length);
+    uct_worker_activity_add(iface->worker);
     status = handler->cb(handler->arg, data, length, flags);
     ucs_assert((status == UCS_OK) ||
                ((status == UCS_INPROGRESS) && (flags & UCT_CB_FLAG_DESC)));
@@ -521,6 +551,25 @@ void uct_invoke_completion(uct_completion_t *comp, ucs_status_t status)
     }
 }
 
+/**
+ * Subtract a batch of completed operations from a completion counter, and
+ * invoke the completion callback if it reached zero. Operations which fan out
+ * to many fragments sharing one counter can retire several fragments with a
+ * single update, instead of decrementing the counter once per fragment.
+ */
+static UCS_F_ALWAYS_INLINE
+void uct_invoke_completion_n(uct_completion_t *comp, int count,
+                             ucs_status_t status)
+{
+    ucs_trace_func("comp=%p, count=%d-%d, status=%d", comp, comp->count, count,
+                   status);
+    ucs_assert(comp->count >= count);
+    comp->count -= count;
+    if (comp->count == 0) {
+        comp->func(comp, status);
+    }
+}
+
 /**
  * Calculates total length of particular iov data buffer.
  * Currently has no support for stride.
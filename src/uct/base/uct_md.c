@@ -10,12 +10,16 @@
 #include "uct_iface.h"
 
 #include <uct/api/uct.h>
+#include <ucs/config/global_opts.h>
+#include <ucs/config/parser.h>
+#include <ucs/debug/debug.h>
 #include <ucs/debug/log.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/type/class.h>
 #include <ucs/datastruct/callbackq.inl>
 #include <ucs/sys/string.h>
 #include <malloc.h>
+#include <pthread.h>
 
 
 UCS_LIST_HEAD(uct_md_components_list);
@@ -36,8 +40,17 @@ typedef struct uct_config_bundle {
 } uct_config_bundle_t;
 
 
-ucs_status_t uct_query_md_resources(uct_md_resource_desc_t **resources_p,
-                                    unsigned *num_resources_p)
+static struct {
+    uct_md_resource_desc_t *resources;
+    unsigned               num_resources;
+    int                    valid;
+} uct_md_resource_cache = { NULL, 0, 0 };
+static pthread_mutex_t uct_md_resource_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static ucs_status_t
+uct_query_md_resources_uncached(uct_md_resource_desc_t **resources_p,
+                                unsigned *num_resources_p)
 {
     uct_md_resource_desc_t *resources, *md_resources, *tmp;
     unsigned i, num_resources, num_md_resources;
@@ -48,6 +61,15 @@ ucs_status_t uct_query_md_resources(uct_md_resource_desc_t **resources_p,
     num_resources = 0;
 
     ucs_list_for_each(mdc, &uct_md_components_list, list) {
+        /* A filtered-out component is not probed at all, so its discovery
+         * system calls are never issued */
+        if (ucs_config_names_search(ucs_global_opts.md_components,
+                                    mdc->name) < 0) {
+            ucs_debug("md component %s is disabled by UCX_MD_COMPONENTS",
+                      mdc->name);
+            continue;
+        }
+
         status = mdc->query_resources(&md_resources, &num_md_resources);
         if (status != UCS_OK) {
             ucs_debug("Failed to query %s* resources: %s", mdc->name,
@@ -90,6 +112,53 @@ err:
     return status;
 }
 
+ucs_status_t uct_query_md_resources(uct_md_resource_desc_t **resources_p,
+                                    unsigned *num_resources_p)
+{
+    uct_md_resource_desc_t *resources;
+    ucs_status_t status;
+
+    /* Device discovery scans sysfs and opens devices, which dominates context
+     * creation time. It is done once per process and reused afterwards - in
+     * particular by a fork()ed child which re-creates its context. */
+    pthread_mutex_lock(&uct_md_resource_cache_lock);
+    if (!uct_md_resource_cache.valid) {
+        status = uct_query_md_resources_uncached(&uct_md_resource_cache.resources,
+                                                 &uct_md_resource_cache.num_resources);
+        if (status != UCS_OK) {
+            goto out_unlock;
+        }
+        uct_md_resource_cache.valid = 1;
+    }
+
+    if (uct_md_resource_cache.num_resources == 0) {
+        resources = NULL;
+    } else {
+        resources = ucs_malloc(sizeof(*resources) *
+                               uct_md_resource_cache.num_resources,
+                               "md_resources");
+        if (resources == NULL) {
+            status = UCS_ERR_NO_MEMORY;
+            goto out_unlock;
+        }
+        memcpy(resources, uct_md_resource_cache.resources,
+               sizeof(*resources) * uct_md_resource_cache.num_resources);
+    }
+
+    *resources_p     = resources;
+    *num_resources_p = uct_md_resource_cache.num_resources;
+    status           = UCS_OK;
+
+out_unlock:
+    pthread_mutex_unlock(&uct_md_resource_cache_lock);
+    return status;
+}
+
+static void UCS_F_DTOR uct_md_resource_cache_cleanup()
+{
+    ucs_free(uct_md_resource_cache.resources);
+}
+
 void uct_release_md_resource_list(uct_md_resource_desc_t *resources)
 {
     ucs_free(resources);
@@ -213,36 +282,200 @@ ucs_status_t uct_md_stub_rkey_unpack(uct_md_component_t *mdc,
     return UCS_OK;
 }
 
+/* Period, in progress calls, at which slow-priority progress callbacks are
+ * dispatched */
+#define UCT_WORKER_PROGRESS_SLOW_PERIOD    16
+
+
+/* How often the memory budget of a worker is checked */
+#define UCT_WORKER_MEM_TRIM_INTERVAL  ucs_time_from_sec(1.0)
+
+static void uct_worker_mem_trim_cb(ucs_callbackq_slow_elem_t *self)
+{
+    uct_worker_t *worker = ucs_container_of(self, uct_worker_t, mem_trim_cb);
+    ucs_mpool_data_t *data;
+    ucs_time_t now;
+
+    if (worker->mem_budget == SIZE_MAX) {
+        return;
+    }
+
+    now = ucs_get_time();
+    if (now < worker->mem_check_time) {
+        return;
+    }
+    worker->mem_check_time = now + UCT_WORKER_MEM_TRIM_INTERVAL;
+
+    if (uct_worker_mem_footprint(worker) <= worker->mem_budget) {
+        return;
+    }
+
+    /* Release unused pool chunks until the footprint is within the budget */
+    ucs_list_for_each(data, &worker->trim_mpools, trim_list) {
+        ucs_mpool_trim(data->mp);
+        if (uct_worker_mem_footprint(worker) <= worker->mem_budget) {
+            break;
+        }
+    }
+}
+
 static UCS_CLASS_INIT_FUNC(uct_worker_t, ucs_async_context_t *async,
                            ucs_thread_mode_t thread_mode)
 {
-    self->async       = async;
-    self->thread_mode = thread_mode;
+    self->async          = async;
+    self->thread_mode    = thread_mode;
+    self->progress_count = 0;
+    self->num_progress   = 0;
+    self->activity_count = 0;
+    self->mem_budget     = SIZE_MAX;
+    self->mem_check_time = 0;
     ucs_callbackq_init(&self->progress_q, 64, async);
+    ucs_callbackq_init(&self->slow_prio_q, 32, async);
     ucs_list_head_init(&self->tl_data);
+    ucs_list_head_init(&self->trim_mpools);
+    self->mem_trim_cb.cb = uct_worker_mem_trim_cb;
+    ucs_callbackq_add_slow_path(&self->progress_q, &self->mem_trim_cb);
     return UCS_OK;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_worker_t)
 {
+    ucs_callbackq_remove_slow_path(&self->progress_q, &self->mem_trim_cb);
+    ucs_callbackq_cleanup(&self->slow_prio_q);
     ucs_callbackq_cleanup(&self->progress_q);
 }
 
+void uct_worker_mpool_track(uct_worker_h worker, ucs_mpool_t *mp)
+{
+    ucs_list_add_tail(&worker->trim_mpools, &mp->data->trim_list);
+}
+
+void uct_worker_set_mem_budget(uct_worker_h worker, size_t budget)
+{
+    worker->mem_budget = budget;
+}
+
+size_t uct_worker_mem_footprint(uct_worker_h worker)
+{
+    ucs_mpool_data_t *data;
+    size_t total = 0;
+
+    ucs_list_for_each(data, &worker->trim_mpools, trim_list) {
+        total += data->total_size;
+    }
+    return total;
+}
+
 void uct_worker_progress(uct_worker_h worker)
 {
+#if ENABLE_STATS
+    ++worker->num_progress;
+#endif
     ucs_callbackq_dispatch(&worker->progress_q);
+    if (ucs_unlikely(++worker->progress_count >= UCT_WORKER_PROGRESS_SLOW_PERIOD)) {
+        worker->progress_count = 0;
+        ucs_callbackq_dispatch(&worker->slow_prio_q);
+    }
+}
+
+void uct_worker_activity_add(uct_worker_h worker)
+{
+    ++worker->activity_count;
+}
+
+unsigned uct_worker_activity_count(uct_worker_h worker)
+{
+    return worker->activity_count;
+}
+
+#if ENABLE_STATS
+
+typedef struct {
+    FILE                   *stream;
+    uint64_t               total_time;
+} uct_worker_stats_report_t;
+
+static void uct_worker_progress_stats_sum_cb(ucs_callback_t cb, void *arg,
+                                             uint64_t time, uint64_t count,
+                                             void *fn_arg)
+{
+    *(uint64_t*)fn_arg += time;
+}
+
+static void uct_worker_progress_stats_print_cb(ucs_callback_t cb, void *arg,
+                                               uint64_t time, uint64_t count,
+                                               void *fn_arg)
+{
+    uct_worker_stats_report_t *report = fn_arg;
+
+    if (count == 0) {
+        return;
+    }
+
+    fprintf(report->stream, "#   %-40s(arg=%p) %6.2f%% %12lu samples %10.3f usec avg\n",
+            ucs_debug_get_symbol_name(cb), arg,
+            (report->total_time > 0) ? (100.0 * time / report->total_time) : 0.0,
+            (unsigned long)count, ucs_time_to_usec(time) / count);
+}
+
+#endif
+
+void uct_worker_progress_stats_print(uct_worker_h worker, FILE *stream)
+{
+#if ENABLE_STATS
+    uct_worker_stats_report_t report = {.stream = stream, .total_time = 0};
+
+    ucs_callbackq_stats_foreach(&worker->progress_q,
+                                uct_worker_progress_stats_sum_cb,
+                                &report.total_time);
+    ucs_callbackq_stats_foreach(&worker->slow_prio_q,
+                                uct_worker_progress_stats_sum_cb,
+                                &report.total_time);
+
+    fprintf(stream, "# worker %p: %lu progress calls, poll hit rate %.2f%%\n",
+            worker, worker->num_progress,
+            (worker->num_progress > 0) ?
+            (100.0 * worker->activity_count / worker->num_progress) : 0.0);
+    ucs_callbackq_stats_foreach(&worker->progress_q,
+                                uct_worker_progress_stats_print_cb, &report);
+    ucs_callbackq_stats_foreach(&worker->slow_prio_q,
+                                uct_worker_progress_stats_print_cb, &report);
+#else
+    fprintf(stream, "# worker %p: statistics are not enabled\n", worker);
+#endif
+}
+
+static inline ucs_callbackq_t*
+uct_worker_progress_q(uct_worker_h worker, uct_progress_prio_t prio)
+{
+    return (prio == UCT_PROGRESS_PRIO_SLOW) ? &worker->slow_prio_q :
+           &worker->progress_q;
+}
+
+void uct_worker_progress_register_prio(uct_worker_h worker, ucs_callback_t func,
+                                       void *arg, uct_progress_prio_t prio)
+{
+    ucs_callbackq_add(uct_worker_progress_q(worker, prio), func, arg);
+}
+
+void uct_worker_progress_unregister_prio(uct_worker_h worker,
+                                         ucs_callback_t func, void *arg,
+                                         uct_progress_prio_t prio)
+{
+    ucs_callbackq_remove(uct_worker_progress_q(worker, prio), func, arg);
 }
 
 void uct_worker_progress_register(uct_worker_h worker,
                                   ucs_callback_t func, void *arg)
 {
-    ucs_callbackq_add(&worker->progress_q, func, arg);
+    uct_worker_progress_register_prio(worker, func, arg, UCT_PROGRESS_PRIO_FAST);
 }
 
 void uct_worker_progress_unregister(uct_worker_h worker,
                                     ucs_callback_t func, void *arg)
 {
-    ucs_callbackq_remove(&worker->progress_q, func, arg);
+    uct_worker_progress_unregister_prio(worker, func, arg,
+                                        UCT_PROGRESS_PRIO_FAST);
 }
 
 void uct_worker_slowpath_progress_register(uct_worker_h worker,
@@ -279,8 +512,9 @@ static ucs_status_t uct_config_read(uct_config_bundle_t **bundle,
     }
 
     /* TODO use env_prefix */
-    status = ucs_config_parser_fill_opts(config_bundle->data, config_table,
-                                         env_prefix, cfg_prefix, 0);
+    status = ucs_config_parser_fill_opts_cached(config_bundle->data,
+                                                config_table, config_size,
+                                                env_prefix, cfg_prefix, 0);
     if (status != UCS_OK) {
         goto err_free_bundle;
     }
@@ -484,6 +718,14 @@ ucs_status_t uct_rkey_unpack(const void *rkey_buffer, uct_rkey_bundle_t *rkey_ob
     return UCS_ERR_UNSUPPORTED;
 }
 
+ucs_status_t uct_rkey_ptr(uct_rkey_bundle_t *rkey_ob, uint64_t remote_addr,
+                          void **addr_p)
+{
+    uct_md_component_t *mdc = rkey_ob->type;
+    return mdc->rkey_ptr(mdc, rkey_ob->rkey, rkey_ob->handle, remote_addr,
+                         addr_p);
+}
+
 ucs_status_t uct_rkey_release(const uct_rkey_bundle_t *rkey_ob)
 {
     uct_md_component_t *mdc = rkey_ob->type;
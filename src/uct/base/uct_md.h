@@ -11,6 +11,8 @@
 
 #include <uct/api/uct.h>
 #include <ucs/datastruct/callbackq.h>
+#include <ucs/datastruct/mpool.h>
+#include <ucs/time/time.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/type/component.h>
 #include <ucs/config/parser.h>
@@ -27,6 +29,9 @@ struct uct_md_component {
     ucs_status_t           (*rkey_unpack)(uct_md_component_t *mdc, const void *rkey_buffer,
                                           uct_rkey_t *rkey_p, void **handle_p);
 
+    ucs_status_t           (*rkey_ptr)(uct_md_component_t *mdc, uct_rkey_t rkey,
+                                       void *handle, uint64_t raddr, void **laddr_p);
+
     ucs_status_t           (*rkey_release)(uct_md_component_t *mdc, uct_rkey_t rkey,
                                            void *handle);
 
@@ -66,13 +71,14 @@ typedef struct uct_md_registered_tl {
  * @param _open          Function to open a MD.
  * @param _priv          Custom private data.
  * @param _rkey_unpack   Function to unpack a remote key buffer to handle.
+ * @param _rkey_ptr      Function to get a local pointer to remote memory.
  * @param _rkey_release  Function to release a remote key handle.
  * @param _cfg_prefix    Prefix for configuration environment vars.
  * @param _cfg_table     Defines the MDC's configuration values.
  * @param _cfg_struct    MDC configuration structure.
  */
 #define UCT_MD_COMPONENT_DEFINE(_mdc, _name, _query, _open, _priv, \
-                                _rkey_unpack, _rkey_release, \
+                                _rkey_unpack, _rkey_ptr, _rkey_release, \
                                 _cfg_prefix, _cfg_table, _cfg_struct) \
     \
     uct_md_component_t _mdc = { \
@@ -83,6 +89,7 @@ typedef struct uct_md_registered_tl {
         .md_config_size  = sizeof(_cfg_struct), \
         .priv            = _priv, \
         .rkey_unpack     = _rkey_unpack, \
+        .rkey_ptr        = _rkey_ptr, \
         .rkey_release    = _rkey_release, \
         .name            = _name, \
         .tl_list         = { &_mdc.tl_list, &_mdc.tl_list } \
@@ -154,11 +161,36 @@ typedef struct uct_worker_tl_data {
 typedef struct uct_worker uct_worker_t;
 struct uct_worker {
     ucs_async_context_t    *async;
-    ucs_callbackq_t        progress_q;
+    ucs_callbackq_t        progress_q;      /* Dispatched on every progress call */
+    unsigned               activity_count;  /* Incremented whenever an iface on
+                                               this worker delivers an active
+                                               message - lets the upper layer
+                                               detect idle stretches */
+    ucs_callbackq_t        slow_prio_q;     /* Dispatched once per several
+                                               progress calls - for high-latency
+                                               ifaces whose polling is costly */
+    unsigned               progress_count;  /* Calls since last slow_prio_q
+                                               dispatch */
+    unsigned long          num_progress;    /* Total progress calls, counted
+                                               only when statistics are
+                                               enabled */
     ucs_thread_mode_t      thread_mode;
     ucs_list_link_t        tl_data;
+    ucs_list_link_t        trim_mpools;    /* Pools covered by the memory
+                                              budget, linked by their
+                                              data->trim_list */
+    size_t                 mem_budget;     /* Pool footprint to trim down to */
+    ucs_time_t             mem_check_time; /* Next time to check the budget */
+    ucs_callbackq_slow_elem_t mem_trim_cb; /* Slow-path budget enforcement */
 };
 
+
+/**
+ * Track a memory pool in the worker's memory budget. The pool detaches
+ * itself when it is cleaned up, so no untrack call is needed.
+ */
+void uct_worker_mpool_track(uct_worker_h worker, ucs_mpool_t *mp);
+
 static UCS_F_ALWAYS_INLINE void*
 uct_md_fill_md_name(uct_md_h md, void *buffer)
 {
@@ -7,8 +7,12 @@
 #include "uct_iface.h"
 #include "uct_md.h"
 
+#include <ucs/arch/bitops.h>
 #include <ucs/arch/cpu.h>
 #include <ucs/debug/profile.h>
+#include <ucs/stats/stats.h>
+#include <ucs/sys/sys.h>
+#include <ucs/time/time.h>
 
 
 typedef struct {
@@ -18,6 +22,98 @@ typedef struct {
 } uct_iface_mp_chunk_hdr_t;
 
 
+/*
+ * Learned allocation behavior, keyed by size class (log2 of the requested
+ * length). The method which last satisfied a size class is tried first on the
+ * next allocation of that class, and a method which keeps failing - such as
+ * hugetlb on a host with no hugepages configured - is not retried until a
+ * backoff interval passes, so descriptor pool growth during traffic bursts
+ * does not repeat doomed syscalls. Updates are intentionally unlocked: a lost
+ * update merely costs one extra allocation attempt.
+ *
+ * The MD method is not backed off, because failure of an MD which claims
+ * allocation support is an error by contract and does not fall through to
+ * the next method.
+ */
+#define UCT_MEM_ALLOC_NUM_SIZE_CLASSES  (sizeof(size_t) * 8)
+#define UCT_MEM_ALLOC_FAIL_THRESH       3
+#define UCT_MEM_ALLOC_RETRY_INTERVAL    ucs_time_from_sec(10.0)
+
+typedef struct {
+    unsigned           fail_count;   /* Consecutive failures, saturated */
+    ucs_time_t         retry_time;   /* Earliest next attempt once backed off */
+} uct_mem_alloc_method_state_t;
+
+static struct {
+    /* Preferred method per size class, biased by one so that zero (static
+     * initialization) means "nothing learned yet" */
+    uint8_t                      preferred[UCT_MEM_ALLOC_NUM_SIZE_CLASSES];
+    uct_mem_alloc_method_state_t state[UCT_MEM_ALLOC_NUM_SIZE_CLASSES]
+                                      [UCT_ALLOC_METHOD_LAST];
+} uct_mem_alloc_cache;
+
+#if ENABLE_STATS
+static ucs_stats_class_t uct_mem_alloc_stats_class = {
+    .name = "uct_mem_alloc",
+    .num_counters = UCT_ALLOC_METHOD_LAST,
+    .counter_names = {
+        [UCT_ALLOC_METHOD_MD]   = "md_hit",
+        [UCT_ALLOC_METHOD_HEAP] = "heap_hit",
+        [UCT_ALLOC_METHOD_MMAP] = "mmap_hit",
+        [UCT_ALLOC_METHOD_HUGE] = "huge_hit"
+    }
+};
+
+static ucs_stats_node_t *uct_mem_alloc_stats = NULL;
+static pthread_mutex_t  uct_mem_alloc_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void uct_mem_alloc_stats_hit(uct_alloc_method_t method)
+{
+    pthread_mutex_lock(&uct_mem_alloc_stats_lock);
+    if (uct_mem_alloc_stats == NULL) {
+        UCS_STATS_NODE_ALLOC(&uct_mem_alloc_stats, &uct_mem_alloc_stats_class,
+                             ucs_stats_get_root());
+    }
+    if (uct_mem_alloc_stats != NULL) {
+        UCS_STATS_UPDATE_COUNTER(uct_mem_alloc_stats, method, 1);
+    }
+    pthread_mutex_unlock(&uct_mem_alloc_stats_lock);
+}
+#else
+#define uct_mem_alloc_stats_hit(_method)
+#endif
+
+static void uct_mem_alloc_cache_success(unsigned size_class,
+                                        uct_alloc_method_t method)
+{
+    uct_mem_alloc_method_state_t *state;
+
+    state             = &uct_mem_alloc_cache.state[size_class][method];
+    state->fail_count = 0;
+    state->retry_time = 0;
+    uct_mem_alloc_cache.preferred[size_class] = method + 1;
+}
+
+static void uct_mem_alloc_cache_failure(unsigned size_class,
+                                        uct_alloc_method_t method,
+                                        ucs_time_t now)
+{
+    uct_mem_alloc_method_state_t *state;
+
+    if (method == UCT_ALLOC_METHOD_MD) {
+        return;
+    }
+
+    state = &uct_mem_alloc_cache.state[size_class][method];
+    if (state->fail_count < UCT_MEM_ALLOC_FAIL_THRESH) {
+        ++state->fail_count;
+    }
+    if (state->fail_count >= UCT_MEM_ALLOC_FAIL_THRESH) {
+        state->retry_time = now + UCT_MEM_ALLOC_RETRY_INTERVAL;
+    }
+}
+
+
 typedef struct {
     uct_base_iface_t               *iface;
     uct_iface_mpool_init_obj_cb_t  init_obj_cb;
@@ -47,12 +143,16 @@ static inline unsigned mmap_flags(unsigned uct_mmap_flags)
     return mm_flags;
 }
 
-ucs_status_t uct_mem_alloc(void *addr, size_t min_length, unsigned flags,
-                           uct_alloc_method_t *methods, unsigned num_methods,
-                           uct_md_h *mds, unsigned num_mds,
-                           const char *alloc_name, uct_allocated_memory_t *mem)
+/*
+ * Attempt a single allocation method. Returns UCS_OK with 'mem' fully filled,
+ * UCS_ERR_NO_MEMORY if the method failed and the next one may be tried,
+ * UCS_ERR_UNSUPPORTED if no MD is capable of the allocation, or a fatal error.
+ */
+static ucs_status_t
+uct_mem_alloc_method(uct_alloc_method_t method, void *addr, size_t min_length,
+                     unsigned flags, uct_md_h *mds, unsigned num_mds,
+                     const char *alloc_name, uct_allocated_memory_t *mem)
 {
-    uct_alloc_method_t *method;
     uct_md_attr_t md_attr;
     ucs_status_t status;
     size_t alloc_length;
@@ -63,6 +163,123 @@ ucs_status_t uct_mem_alloc(void *addr, size_t min_length, unsigned flags,
     int shmid;
     unsigned map_flags;
 
+    ucs_debug("trying allocation method %s", uct_alloc_method_names[method]);
+
+    switch (method) {
+    case UCT_ALLOC_METHOD_MD:
+        /* Allocate with one of the specified memory domains */
+        for (md_index = 0; md_index < num_mds; ++md_index) {
+            md = mds[md_index];
+            status = uct_md_query(md, &md_attr);
+            if (status != UCS_OK) {
+                ucs_error("Failed to query MD");
+                return status;
+            }
+
+            /* Check if MD supports allocation */
+            if (!(md_attr.cap.flags & UCT_MD_FLAG_ALLOC)) {
+                continue;
+            }
+
+            /* Check if MD supports allocation with fixed address
+             * if it's requested */
+            if ((flags & UCT_MD_MEM_FLAG_FIXED) &&
+                !(md_attr.cap.flags & UCT_MD_FLAG_FIXED)) {
+                continue;
+            }
+
+            /* Allocate memory using the MD.
+             * If the allocation fails, it's considered an error and we don't
+             * fall-back, because this MD already exposed support for memory
+             * allocation.
+             */
+            alloc_length = min_length;
+            address = addr;
+            status = uct_md_mem_alloc(md, &alloc_length, &address, flags,
+                                      alloc_name, &memh);
+            if (status != UCS_OK) {
+                ucs_error("failed to allocate %zu bytes using md %s: %s",
+                          alloc_length, md->component->name,
+                          ucs_status_string(status));
+                return status;
+            }
+
+            ucs_assert(memh != UCT_MEM_HANDLE_NULL);
+            mem->md   = md;
+            mem->memh = memh;
+            goto allocated;
+        }
+        return UCS_ERR_UNSUPPORTED;
+
+    case UCT_ALLOC_METHOD_HEAP:
+        /* Allocate aligned memory using libc allocator */
+        alloc_length = min_length;
+        address = ucs_memalign(UCS_SYS_CACHE_LINE_SIZE, alloc_length
+                               UCS_MEMTRACK_VAL);
+        if (address != NULL) {
+            goto allocated_without_md;
+        }
+
+        ucs_debug("failed to allocate %zu bytes from the heap", alloc_length);
+        return UCS_ERR_NO_MEMORY;
+
+    case UCT_ALLOC_METHOD_MMAP:
+        map_flags = mmap_flags(flags);
+        /* Request memory from operating system using mmap() */
+        alloc_length = ucs_align_up_pow2(min_length, ucs_get_page_size());
+        address = ucs_mmap(addr, alloc_length, PROT_READ | PROT_WRITE,
+                           map_flags, -1, 0 UCS_MEMTRACK_VAL);
+        if (address != MAP_FAILED) {
+            goto allocated_without_md;
+        }
+
+        ucs_debug("failed to mmap %zu bytes: %m", alloc_length);
+        return UCS_ERR_NO_MEMORY;
+
+    case UCT_ALLOC_METHOD_HUGE:
+        /* Allocate huge pages */
+        alloc_length = min_length;
+        address = (flags & UCT_MD_MEM_FLAG_FIXED) ? addr : NULL;
+        status = ucs_sysv_alloc(&alloc_length, &address, SHM_HUGETLB, &shmid
+                                UCS_MEMTRACK_VAL);
+        if (status == UCS_OK) {
+            goto allocated_without_md;
+        }
+
+        ucs_debug("failed to allocate %zu bytes from hugetlb: %s",
+                  min_length, ucs_status_string(status));
+        return UCS_ERR_NO_MEMORY;
+
+    default:
+        ucs_error("Invalid allocation method %d", method);
+        return UCS_ERR_INVALID_PARAM;
+    }
+
+allocated_without_md:
+    mem->md      = NULL;
+    mem->memh    = UCT_MEM_HANDLE_NULL;
+allocated:
+    ucs_debug("allocated %zu bytes at %p using %s", alloc_length, address,
+              (mem->md == NULL) ? uct_alloc_method_names[method]
+                                : mem->md->component->name);
+    mem->address = address;
+    mem->length  = alloc_length;
+    mem->method  = method;
+    return UCS_OK;
+}
+
+ucs_status_t uct_mem_alloc(void *addr, size_t min_length, unsigned flags,
+                           uct_alloc_method_t *methods, unsigned num_methods,
+                           uct_md_h *mds, unsigned num_mds,
+                           const char *alloc_name, uct_allocated_memory_t *mem)
+{
+    uct_alloc_method_t *method;
+    uct_alloc_method_t preferred;
+    ucs_status_t status;
+    unsigned size_class;
+    ucs_time_t now;
+    int use_cache, honor_backoff, skipped;
+
     if (min_length == 0) {
         ucs_error("Allocation length cannot be 0");
         return UCS_ERR_INVALID_PARAM;
@@ -79,115 +296,80 @@ ucs_status_t uct_mem_alloc(void *addr, size_t min_length, unsigned flags,
         return UCS_ERR_INVALID_PARAM;
     }
 
-    for (method = methods; method < methods + num_methods; ++method) {
-        ucs_debug("trying allocation method %s", uct_alloc_method_names[*method]);
-
-        switch (*method) {
-        case UCT_ALLOC_METHOD_MD:
-            /* Allocate with one of the specified memory domains */
-            for (md_index = 0; md_index < num_mds; ++md_index) {
-                md = mds[md_index];
-                status = uct_md_query(md, &md_attr);
-                if (status != UCS_OK) {
-                    ucs_error("Failed to query MD");
-                    return status;
-                }
-
-                /* Check if MD supports allocation */
-                if (!(md_attr.cap.flags & UCT_MD_FLAG_ALLOC)) {
-                    continue;
-                }
-
-                /* Check if MD supports allocation with fixed address
-                 * if it's requested */
-                if ((flags & UCT_MD_MEM_FLAG_FIXED) &&
-                    !(md_attr.cap.flags & UCT_MD_FLAG_FIXED)) {
-                    continue;
-                }
-
-                /* Allocate memory using the MD.
-                 * If the allocation fails, it's considered an error and we don't
-                 * fall-back, because this MD already exposed support for memory
-                 * allocation.
-                 */
-                alloc_length = min_length;
-                address = addr;
-                status = uct_md_mem_alloc(md, &alloc_length, &address, flags,
-                                          alloc_name, &memh);
-                if (status != UCS_OK) {
-                    ucs_error("failed to allocate %zu bytes using md %s: %s",
-                              alloc_length, md->component->name,
-                              ucs_status_string(status));
-                    return status;
-                }
-
-                ucs_assert(memh != UCT_MEM_HANDLE_NULL);
-                mem->md   = md;
-                mem->memh = memh;
-                goto allocated;
-
+    /* Placement-constrained allocations bypass the learned preferences */
+    use_cache  = (addr == NULL) && !(flags & UCT_MD_MEM_FLAG_FIXED);
+    size_class = ucs_ilog2(min_length);
+    now        = use_cache ? ucs_get_time() : 0;
+    preferred  = UCT_ALLOC_METHOD_LAST;
+
+    if (use_cache && (uct_mem_alloc_cache.preferred[size_class] != 0)) {
+        /* Try the method which satisfied this size class last time first,
+         * if the caller allows it */
+        preferred = uct_mem_alloc_cache.preferred[size_class] - 1;
+        for (method = methods; method < methods + num_methods; ++method) {
+            if (*method == preferred) {
+                break;
             }
-            break;
+        }
 
-        case UCT_ALLOC_METHOD_HEAP:
-            /* Allocate aligned memory using libc allocator */
-            alloc_length = min_length;
-            address = ucs_memalign(UCS_SYS_CACHE_LINE_SIZE, alloc_length
-                                   UCS_MEMTRACK_VAL);
-            if (address != NULL) {
-                goto allocated_without_md;
+        if (method == methods + num_methods) {
+            preferred = UCT_ALLOC_METHOD_LAST;
+        } else {
+            status = uct_mem_alloc_method(preferred, addr, min_length, flags,
+                                          mds, num_mds, alloc_name, mem);
+            if (status == UCS_OK) {
+                uct_mem_alloc_cache_success(size_class, preferred);
+                uct_mem_alloc_stats_hit(preferred);
+                return UCS_OK;
+            } else if ((status != UCS_ERR_NO_MEMORY) &&
+                       (status != UCS_ERR_UNSUPPORTED)) {
+                return status;
             }
+            uct_mem_alloc_cache_failure(size_class, preferred, now);
+        }
+    }
 
-            ucs_debug("failed to allocate %zu bytes from the heap", alloc_length);
-            break;
-
-        case UCT_ALLOC_METHOD_MMAP:
-            map_flags = mmap_flags(flags);
-            /* Request memory from operating system using mmap() */
-            alloc_length = ucs_align_up_pow2(min_length, ucs_get_page_size());
-            address = ucs_mmap(addr, alloc_length, PROT_READ | PROT_WRITE,
-                               map_flags, -1, 0 UCS_MEMTRACK_VAL);
-            if (address != MAP_FAILED) {
-                goto allocated_without_md;
-            }
+    honor_backoff = use_cache;
+retry:
+    skipped = 0;
+    for (method = methods; method < methods + num_methods; ++method) {
+        if (*method == preferred) {
+            continue; /* Already attempted above */
+        }
 
-            ucs_debug("failed to mmap %zu bytes: %m", alloc_length);
-            break;
+        if (honor_backoff && (*method < UCT_ALLOC_METHOD_LAST) &&
+            (now < uct_mem_alloc_cache.state[size_class][*method].retry_time)) {
+            /* The method failed persistently not long ago - skip it */
+            ++skipped;
+            continue;
+        }
 
-        case UCT_ALLOC_METHOD_HUGE:
-            /* Allocate huge pages */
-            alloc_length = min_length;
-            address = (flags & UCT_MD_MEM_FLAG_FIXED) ? addr : NULL;
-            status = ucs_sysv_alloc(&alloc_length, &address, SHM_HUGETLB, &shmid
-                                    UCS_MEMTRACK_VAL);
-            if (status == UCS_OK) {
-                goto allocated_without_md;
+        status = uct_mem_alloc_method(*method, addr, min_length, flags,
+                                      mds, num_mds, alloc_name, mem);
+        if (status == UCS_OK) {
+            if (use_cache) {
+                uct_mem_alloc_cache_success(size_class, *method);
             }
+            uct_mem_alloc_stats_hit(*method);
+            return UCS_OK;
+        } else if ((status != UCS_ERR_NO_MEMORY) &&
+                   (status != UCS_ERR_UNSUPPORTED)) {
+            return status;
+        }
 
-            ucs_debug("failed to allocate %zu bytes from hugetlb: %s",
-                      min_length, ucs_status_string(status));
-            break;
-
-        default:
-            ucs_error("Invalid allocation method %d", *method);
-            return UCS_ERR_INVALID_PARAM;
+        if (use_cache) {
+            uct_mem_alloc_cache_failure(size_class, *method, now);
         }
     }
 
+    if (skipped > 0) {
+        /* Never fail an allocation which a backed-off method could satisfy */
+        honor_backoff = 0;
+        goto retry;
+    }
+
     ucs_debug("Could not allocate memory with any of the provided methods");
     return UCS_ERR_NO_MEMORY;
-
-allocated_without_md:
-    mem->md      = NULL;
-    mem->memh    = UCT_MEM_HANDLE_NULL;
-allocated:
-    ucs_debug("allocated %zu bytes at %p using %s", alloc_length, address,
-              (mem->md == NULL) ? uct_alloc_method_names[*method]
-                                : mem->md->component->name);
-    mem->address = address;
-    mem->length  = alloc_length;
-    mem->method  = *method;
-    return UCS_OK;
 }
 
 ucs_status_t uct_mem_free(const uct_allocated_memory_t *mem)
@@ -234,6 +416,23 @@ ucs_status_t uct_iface_mem_alloc(uct_iface_h tl_iface, size_t length, unsigned f
         goto err;
     }
 
+    /* Place the memory next to the device before it is touched or registered,
+     * while its pages are not yet faulted in. Heap memory is skipped since it
+     * is not page-aligned, and MD memory is placed by the MD itself. */
+    if ((mem->method == UCT_ALLOC_METHOD_MMAP) ||
+        (mem->method == UCT_ALLOC_METHOD_HUGE)) {
+        if (iface->numa_node >= 0) {
+            ucs_sys_bind_numa(mem->address, mem->length, iface->numa_node);
+        }
+#ifdef MADV_HUGEPAGE
+        if (mem->method == UCT_ALLOC_METHOD_MMAP) {
+            /* Back mmap-ed chunks with transparent huge pages, to cut TLB
+             * misses when the buffers are used for bounce copies */
+            madvise(mem->address, mem->length, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
     /* If the memory was not allocated using MD, register it */
     if (mem->method != UCT_ALLOC_METHOD_MD) {
 
@@ -287,6 +486,7 @@ UCS_PROFILE_FUNC(ucs_status_t, uct_iface_mp_chunk_alloc, (mp, size_p, chunk_p),
     uct_base_iface_t *iface = uct_iface_mp_priv(mp)->iface;
     uct_iface_mp_chunk_hdr_t *hdr;
     uct_allocated_memory_t mem;
+    ucs_sys_alloc_attr_t attr;
     ucs_status_t status;
     size_t length;
 
@@ -306,6 +506,14 @@ UCS_PROFILE_FUNC(ucs_status_t, uct_iface_mp_chunk_alloc, (mp, size_p, chunk_p),
     hdr->memh   = mem.memh;
     *size_p       = mem.length - sizeof(*hdr);
     *chunk_p    = hdr + 1;
+
+    /* Fault the chunk in now - rx descriptors from this pool are first
+     * touched by the device/data path otherwise. Registered memory is
+     * already pinned, so skip the huge page advice */
+    attr.thp       = 0;
+    attr.prefault  = 1;
+    attr.numa_node = -1;
+    ucs_sys_alloc_apply_attr(mem.address, mem.length, &attr);
     return UCS_OK;
 }
 
@@ -367,5 +575,6 @@ ucs_status_t uct_iface_mpool_init(uct_base_iface_t *iface, ucs_mpool_t *mp,
 
     uct_iface_mp_priv(mp)->iface       = iface;
     uct_iface_mp_priv(mp)->init_obj_cb = init_obj_cb;
+    uct_worker_mpool_track(iface->worker, mp);
     return UCS_OK;
 }
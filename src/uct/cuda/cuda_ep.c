@@ -31,12 +31,183 @@ UCS_CLASS_DEFINE_NEW_FUNC(uct_cuda_ep_t, uct_ep_t, uct_iface_t*,
 UCS_CLASS_DEFINE_DELETE_FUNC(uct_cuda_ep_t, uct_ep_t);
 
 
+/*
+ * All copies go through the interface stream with cudaMemcpyDefault, so the
+ * runtime resolves the direction from the pointers - device-to-device,
+ * host-to-device and device-to-host all take the same path and overlap with
+ * compute on other streams.
+ */
+
 ucs_status_t uct_cuda_ep_put_short(uct_ep_h tl_ep, const void *buffer,
                                    unsigned length, uint64_t remote_addr,
                                    uct_rkey_t rkey)
 {
-    /* Code for PUT here */
-    return UCS_ERR_UNSUPPORTED;
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cuda_iface_t);
+    ucs_status_t status;
+
+    if (length == 0) {
+        return UCS_OK;
+    }
+
+    /* Short is synchronous - queue the copy behind the in-flight ones and
+     * wait for the stream to drain */
+    status = UCT_CUDA_FUNC(cudaMemcpyAsync((void*)remote_addr, buffer, length,
+                                           cudaMemcpyDefault, iface->stream));
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = UCT_CUDA_FUNC(cudaStreamSynchronize(iface->stream));
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, SHORT, length);
+    return UCS_OK;
+}
+
+ssize_t uct_cuda_ep_put_bcopy(uct_ep_h tl_ep, uct_pack_callback_t pack_cb,
+                              void *arg, uint64_t remote_addr, uct_rkey_t rkey)
+{
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cuda_iface_t);
+    uct_cuda_event_desc_t *event_desc;
+    ucs_status_t status;
+    void *staging;
+    size_t length;
+
+    event_desc = ucs_mpool_get(&iface->event_mp);
+    if (ucs_unlikely(event_desc == NULL)) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    staging = ucs_mpool_get(&iface->staging_mp);
+    if (ucs_unlikely(staging == NULL)) {
+        ucs_mpool_put(event_desc);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    length = pack_cb(staging, arg);
+    ucs_assert(length <= iface->seg_size);
+
+    status = UCT_CUDA_FUNC(cudaMemcpyAsync((void*)remote_addr, staging, length,
+                                           cudaMemcpyDefault, iface->stream));
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(staging);
+        ucs_mpool_put(event_desc);
+        return status;
+    }
+
+    /* The staging buffer is owned by the transport, so the operation is
+     * locally complete right away; the buffer is recycled when the copy
+     * event retires */
+    uct_cuda_iface_track(iface, event_desc, NULL, staging, NULL, NULL, length);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, BCOPY, length);
+    return length;
+}
+
+ucs_status_t uct_cuda_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov,
+                                   size_t iovcnt, uint64_t remote_addr,
+                                   uct_rkey_t rkey, uct_completion_t *comp)
+{
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cuda_iface_t);
+    uct_cuda_event_desc_t *event_desc;
+    ucs_status_t status;
+
+    UCT_CHECK_IOV_SIZE(iovcnt, 1ul, "uct_cuda_ep_put_zcopy");
+
+    if (iov[0].length == 0) {
+        return UCS_OK;
+    }
+
+    event_desc = ucs_mpool_get(&iface->event_mp);
+    if (ucs_unlikely(event_desc == NULL)) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    status = UCT_CUDA_FUNC(cudaMemcpyAsync((void*)remote_addr, iov[0].buffer,
+                                           iov[0].length, cudaMemcpyDefault,
+                                           iface->stream));
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(event_desc);
+        return status;
+    }
+
+    status = uct_cuda_iface_track(iface, event_desc, comp, NULL, NULL, NULL,
+                                  iov[0].length);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, ZCOPY,
+                      iov[0].length);
+    return status;
+}
+
+ucs_status_t uct_cuda_ep_get_bcopy(uct_ep_h tl_ep,
+                                   uct_unpack_callback_t unpack_cb, void *arg,
+                                   size_t length, uint64_t remote_addr,
+                                   uct_rkey_t rkey, uct_completion_t *comp)
+{
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cuda_iface_t);
+    uct_cuda_event_desc_t *event_desc;
+    ucs_status_t status;
+    void *staging;
+
+    UCT_CHECK_LENGTH(length, 0, iface->seg_size, "uct_cuda_ep_get_bcopy");
+
+    event_desc = ucs_mpool_get(&iface->event_mp);
+    if (ucs_unlikely(event_desc == NULL)) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    staging = ucs_mpool_get(&iface->staging_mp);
+    if (ucs_unlikely(staging == NULL)) {
+        ucs_mpool_put(event_desc);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    status = UCT_CUDA_FUNC(cudaMemcpyAsync(staging, (void*)remote_addr, length,
+                                           cudaMemcpyDefault, iface->stream));
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(staging);
+        ucs_mpool_put(event_desc);
+        return status;
+    }
+
+    status = uct_cuda_iface_track(iface, event_desc, comp, staging, unpack_cb,
+                                  arg, length);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), GET, BCOPY, length);
+    return status;
+}
+
+ucs_status_t uct_cuda_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov,
+                                   size_t iovcnt, uint64_t remote_addr,
+                                   uct_rkey_t rkey, uct_completion_t *comp)
+{
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cuda_iface_t);
+    uct_cuda_event_desc_t *event_desc;
+    ucs_status_t status;
+
+    UCT_CHECK_IOV_SIZE(iovcnt, 1ul, "uct_cuda_ep_get_zcopy");
+
+    if (iov[0].length == 0) {
+        return UCS_OK;
+    }
+
+    event_desc = ucs_mpool_get(&iface->event_mp);
+    if (ucs_unlikely(event_desc == NULL)) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    status = UCT_CUDA_FUNC(cudaMemcpyAsync(iov[0].buffer, (void*)remote_addr,
+                                           iov[0].length, cudaMemcpyDefault,
+                                           iface->stream));
+    if (ucs_unlikely(status != UCS_OK)) {
+        ucs_mpool_put(event_desc);
+        return status;
+    }
+
+    status = uct_cuda_iface_track(iface, event_desc, comp, NULL, NULL, NULL,
+                                  iov[0].length);
+    UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), GET, ZCOPY,
+                      iov[0].length);
+    return status;
 }
 
 ucs_status_t uct_cuda_ep_am_short(uct_ep_h ep, uint8_t id, uint64_t header,
@@ -45,3 +216,20 @@ ucs_status_t uct_cuda_ep_am_short(uct_ep_h ep, uint8_t id, uint64_t header,
     return UCS_ERR_UNSUPPORTED;
 }
 
+ucs_status_t uct_cuda_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                               uct_completion_t *comp)
+{
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cuda_iface_t);
+
+    if (comp != NULL) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    if (ucs_queue_is_empty(&iface->outstanding)) {
+        UCT_TL_EP_STAT_FLUSH(ucs_derived_of(tl_ep, uct_base_ep_t));
+        return UCS_OK;
+    }
+
+    UCT_TL_EP_STAT_FLUSH_WAIT(ucs_derived_of(tl_ep, uct_base_ep_t));
+    return UCS_INPROGRESS;
+}
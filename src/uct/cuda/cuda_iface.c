@@ -18,6 +18,11 @@ static ucs_config_field_t uct_cuda_iface_config_table[] = {
      ucs_offsetof(uct_cuda_iface_config_t, super),
      UCS_CONFIG_TYPE_TABLE(uct_iface_config_table)},
 
+    {"SEG_SIZE", "64k",
+     "Size of a pinned host bounce buffer, used for packing and unpacking\n"
+     "bcopy operations.",
+     ucs_offsetof(uct_cuda_iface_config_t, seg_size), UCS_CONFIG_TYPE_MEMUNITS},
+
     {NULL}
 };
 
@@ -40,28 +45,124 @@ static int uct_cuda_iface_is_reachable(const uct_iface_h iface, const uct_device
     return 0;
 }
 
-static ucs_status_t uct_cuda_iface_query(uct_iface_h iface,
+/*
+ * Completed copies are retired in issue order. The stream is ordered, so once
+ * the head event is still not ready, no later copy can be done either.
+ */
+static void uct_cuda_iface_progress(void *arg)
+{
+    uct_cuda_iface_t *iface = arg;
+    uct_cuda_event_desc_t *event_desc;
+    cudaError_t result;
+
+    while (!ucs_queue_is_empty(&iface->outstanding)) {
+        event_desc = ucs_queue_head_elem_non_empty(&iface->outstanding,
+                                                   uct_cuda_event_desc_t,
+                                                   queue);
+        result = cudaEventQuery(event_desc->event);
+        if (result == cudaErrorNotReady) {
+            break;
+        }
+
+        ucs_queue_pull_non_empty(&iface->outstanding);
+
+        if ((result == cudaSuccess) && (event_desc->unpack_cb != NULL)) {
+            event_desc->unpack_cb(event_desc->unpack_arg, event_desc->staging,
+                                  event_desc->length);
+        }
+        if (event_desc->staging != NULL) {
+            ucs_mpool_put(event_desc->staging);
+        }
+        if (event_desc->comp != NULL) {
+            uct_invoke_completion(event_desc->comp,
+                                  (result == cudaSuccess) ? UCS_OK :
+                                                            UCS_ERR_IO_ERROR);
+        }
+        ucs_mpool_put(event_desc);
+    }
+}
+
+ucs_status_t uct_cuda_iface_track(uct_cuda_iface_t *iface,
+                                  uct_cuda_event_desc_t *event_desc,
+                                  uct_completion_t *comp, void *staging,
+                                  uct_unpack_callback_t unpack_cb,
+                                  void *unpack_arg, size_t length)
+{
+    ucs_status_t status;
+
+    status = UCT_CUDA_FUNC(cudaEventRecord(event_desc->event, iface->stream));
+    if (ucs_unlikely(status != UCS_OK)) {
+        /* The copy is already on the stream and cannot be tracked - wait for
+         * it here and finish the operation inline */
+        UCT_CUDA_FUNC(cudaStreamSynchronize(iface->stream));
+        if (unpack_cb != NULL) {
+            unpack_cb(unpack_arg, staging, length);
+        }
+        if (staging != NULL) {
+            ucs_mpool_put(staging);
+        }
+        ucs_mpool_put(event_desc);
+        return UCS_OK;
+    }
+
+    event_desc->comp       = comp;
+    event_desc->staging    = staging;
+    event_desc->unpack_cb  = unpack_cb;
+    event_desc->unpack_arg = unpack_arg;
+    event_desc->length     = length;
+    ucs_queue_push(&iface->outstanding, &event_desc->queue);
+    return UCS_INPROGRESS;
+}
+
+static ucs_status_t uct_cuda_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                         uct_completion_t *comp)
+{
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_iface, uct_cuda_iface_t);
+
+    if (comp != NULL) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    if (ucs_queue_is_empty(&iface->outstanding)) {
+        UCT_TL_IFACE_STAT_FLUSH(&iface->super);
+        return UCS_OK;
+    }
+
+    uct_cuda_iface_progress(iface);
+    UCT_TL_IFACE_STAT_FLUSH_WAIT(&iface->super);
+    return UCS_INPROGRESS;
+}
+
+static ucs_status_t uct_cuda_iface_query(uct_iface_h tl_iface,
                                          uct_iface_attr_t *iface_attr)
 {
+    uct_cuda_iface_t *iface = ucs_derived_of(tl_iface, uct_cuda_iface_t);
+
     memset(iface_attr, 0, sizeof(uct_iface_attr_t));
+    iface_attr->numa_node = -1;
 
-    /* FIXME all of these values */
     iface_attr->iface_addr_len          = sizeof(int);
     iface_attr->device_addr_len         = 0;
     iface_attr->ep_addr_len             = 0;
-    iface_attr->cap.flags               = 0;
+    iface_attr->cap.flags               = UCT_IFACE_FLAG_PUT_SHORT |
+                                          UCT_IFACE_FLAG_PUT_BCOPY |
+                                          UCT_IFACE_FLAG_PUT_ZCOPY |
+                                          UCT_IFACE_FLAG_GET_BCOPY |
+                                          UCT_IFACE_FLAG_GET_ZCOPY |
+                                          UCT_IFACE_FLAG_CONNECT_TO_IFACE;
 
-    iface_attr->cap.put.max_short       = 0;
-    iface_attr->cap.put.max_bcopy       = 0;
+    /* Short puts synchronize the stream, so keep them small */
+    iface_attr->cap.put.max_short       = 4096;
+    iface_attr->cap.put.max_bcopy       = iface->seg_size;
     iface_attr->cap.put.min_zcopy       = 0;
-    iface_attr->cap.put.max_zcopy       = 0;
+    iface_attr->cap.put.max_zcopy       = ULONG_MAX;
     iface_attr->cap.put.opt_zcopy_align = 1;
     iface_attr->cap.put.align_mtu       = iface_attr->cap.put.opt_zcopy_align;
     iface_attr->cap.put.max_iov         = 1;
 
-    iface_attr->cap.get.max_bcopy       = 0;
+    iface_attr->cap.get.max_bcopy       = iface->seg_size;
     iface_attr->cap.get.min_zcopy       = 0;
-    iface_attr->cap.get.max_zcopy       = 0;
+    iface_attr->cap.get.max_zcopy       = ULONG_MAX;
     iface_attr->cap.get.opt_zcopy_align = 1;
     iface_attr->cap.get.align_mtu       = iface_attr->cap.get.opt_zcopy_align;
     iface_attr->cap.get.max_iov         = 1;
@@ -90,16 +191,69 @@ static uct_iface_ops_t uct_cuda_iface_ops = {
     .iface_get_device_address = (void*)ucs_empty_function_return_success,
     .iface_query         = uct_cuda_iface_query,
     .iface_is_reachable  = uct_cuda_iface_is_reachable,
+    .iface_flush         = uct_cuda_iface_flush,
     .ep_create_connected = UCS_CLASS_NEW_FUNC_NAME(uct_cuda_ep_t),
     .ep_destroy          = UCS_CLASS_DELETE_FUNC_NAME(uct_cuda_ep_t),
     .ep_put_short        = uct_cuda_ep_put_short,
+    .ep_put_bcopy        = uct_cuda_ep_put_bcopy,
+    .ep_put_zcopy        = uct_cuda_ep_put_zcopy,
+    .ep_get_bcopy        = uct_cuda_ep_get_bcopy,
+    .ep_get_zcopy        = uct_cuda_ep_get_zcopy,
     .ep_am_short         = uct_cuda_ep_am_short,
+    .ep_flush            = uct_cuda_ep_flush,
+    .ep_pending_add      = (void*)ucs_empty_function_return_busy,
+    .ep_pending_purge    = (void*)ucs_empty_function,
+};
+
+static void uct_cuda_event_desc_init(ucs_mpool_t *mp, void *obj, void *chunk)
+{
+    uct_cuda_event_desc_t *event_desc = obj;
+
+    UCT_CUDA_FUNC(cudaEventCreateWithFlags(&event_desc->event,
+                                           cudaEventDisableTiming));
+}
+
+static void uct_cuda_event_desc_cleanup(ucs_mpool_t *mp, void *obj)
+{
+    uct_cuda_event_desc_t *event_desc = obj;
+
+    UCT_CUDA_FUNC(cudaEventDestroy(event_desc->event));
+}
+
+static ucs_mpool_ops_t uct_cuda_event_mpool_ops = {
+    .chunk_alloc   = ucs_mpool_chunk_malloc,
+    .chunk_release = ucs_mpool_chunk_free,
+    .obj_init      = uct_cuda_event_desc_init,
+    .obj_cleanup   = uct_cuda_event_desc_cleanup
+};
+
+static ucs_status_t uct_cuda_staging_chunk_alloc(ucs_mpool_t *mp,
+                                                 size_t *size_p, void **chunk_p)
+{
+    return UCT_CUDA_FUNC(cudaHostAlloc(chunk_p, *size_p,
+                                       cudaHostAllocDefault));
+}
+
+static void uct_cuda_staging_chunk_release(ucs_mpool_t *mp, void *chunk)
+{
+    UCT_CUDA_FUNC(cudaFreeHost(chunk));
+}
+
+static ucs_mpool_ops_t uct_cuda_staging_mpool_ops = {
+    .chunk_alloc   = uct_cuda_staging_chunk_alloc,
+    .chunk_release = uct_cuda_staging_chunk_release,
+    .obj_init      = NULL,
+    .obj_cleanup   = NULL
 };
 
 static UCS_CLASS_INIT_FUNC(uct_cuda_iface_t, uct_md_h md, uct_worker_h worker,
                            const uct_iface_params_t *params,
                            const uct_iface_config_t *tl_config)
 {
+    uct_cuda_iface_config_t *config = ucs_derived_of(tl_config,
+                                                     uct_cuda_iface_config_t);
+    ucs_status_t status;
+
     UCS_CLASS_CALL_SUPER_INIT(uct_base_iface_t, &uct_cuda_iface_ops, md, worker,
                               params, tl_config UCS_STATS_ARG(params->stats_root)
                               UCS_STATS_ARG(UCT_CUDA_TL_NAME));
@@ -109,12 +263,51 @@ static UCS_CLASS_INIT_FUNC(uct_cuda_iface_t, uct_md_h md, uct_worker_h worker,
         return UCS_ERR_NO_DEVICE;
     }
 
+    status = UCT_CUDA_FUNC(cudaStreamCreateWithFlags(&self->stream,
+                                                     cudaStreamNonBlocking));
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucs_queue_head_init(&self->outstanding);
+    self->seg_size = config->seg_size;
+
+    status = ucs_mpool_init(&self->event_mp, 0, sizeof(uct_cuda_event_desc_t),
+                            0, UCS_SYS_CACHE_LINE_SIZE, 128, UINT_MAX,
+                            &uct_cuda_event_mpool_ops, "cuda_event_desc");
+    if (status != UCS_OK) {
+        goto err_destroy_stream;
+    }
+
+    status = ucs_mpool_init(&self->staging_mp, 0, config->seg_size, 0,
+                            UCS_SYS_CACHE_LINE_SIZE, 16, UINT_MAX,
+                            &uct_cuda_staging_mpool_ops, "cuda_staging");
+    if (status != UCS_OK) {
+        goto err_cleanup_event_mp;
+    }
+
+    uct_worker_progress_register(worker, uct_cuda_iface_progress, self);
     return UCS_OK;
+
+err_cleanup_event_mp:
+    ucs_mpool_cleanup(&self->event_mp, 1);
+err_destroy_stream:
+    UCT_CUDA_FUNC(cudaStreamDestroy(self->stream));
+    return status;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_cuda_iface_t)
 {
-    /* tasks to tear down the domain */
+    uct_worker_progress_unregister(self->super.worker, uct_cuda_iface_progress,
+                                   self);
+
+    /* Retire whatever is still in flight before tearing the pools down */
+    UCT_CUDA_FUNC(cudaStreamSynchronize(self->stream));
+    uct_cuda_iface_progress(self);
+
+    ucs_mpool_cleanup(&self->staging_mp, 1);
+    ucs_mpool_cleanup(&self->event_mp, 1);
+    UCT_CUDA_FUNC(cudaStreamDestroy(self->stream));
 }
 
 UCS_CLASS_DEFINE(uct_cuda_iface_t, uct_base_iface_t);
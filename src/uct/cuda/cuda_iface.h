@@ -8,20 +8,67 @@
 #define UCT_CUDA_IFACE_H
 
 #include <uct/base/uct_iface.h>
+#include <ucs/datastruct/mpool.h>
+#include <ucs/datastruct/queue.h>
+
+#include <cuda_runtime.h>
 
 
 #define UCT_CUDA_TL_NAME    "cuda"
 #define UCT_CUDA_DEV_NAME   "gpu0"
 
 
+/* Call a CUDA runtime function, log failures and map them to a status code */
+#define UCT_CUDA_FUNC(_func) \
+    ({ \
+        cudaError_t _result = (_func); \
+        if (ucs_unlikely(_result != cudaSuccess)) { \
+            ucs_error("%s failed: %s", UCS_PP_MAKE_STRING(_func), \
+                      cudaGetErrorString(_result)); \
+        } \
+        (_result == cudaSuccess) ? UCS_OK : UCS_ERR_IO_ERROR; \
+    })
+
+
 typedef struct uct_cuda_iface {
     uct_base_iface_t        super;
+    cudaStream_t            stream;      /* Stream all copies are ordered on */
+    ucs_queue_head_t        outstanding; /* Events of in-flight copies, in
+                                            issue order */
+    ucs_mpool_t             event_mp;    /* Event descriptors */
+    ucs_mpool_t             staging_mp;  /* Pinned host bounce buffers for
+                                            bcopy */
+    size_t                  seg_size;    /* Size of one bounce buffer */
 } uct_cuda_iface_t;
 
 
 typedef struct uct_cuda_iface_config {
     uct_iface_config_t      super;
+    size_t                  seg_size;
 } uct_cuda_iface_config_t;
 
 
+/*
+ * Tracks one asynchronous copy. The event is recorded on the stream right
+ * behind the copy; when it tests complete from the progress loop, the
+ * completion is invoked and the staging buffer, if any, goes back to its pool.
+ */
+typedef struct uct_cuda_event_desc {
+    cudaEvent_t             event;
+    uct_completion_t        *comp;       /* Completion to signal, may be NULL */
+    void                    *staging;    /* Pinned bounce buffer, may be NULL */
+    uct_unpack_callback_t   unpack_cb;   /* Unpack from the bounce buffer on
+                                            completion (get_bcopy) */
+    void                    *unpack_arg;
+    size_t                  length;
+    ucs_queue_elem_t        queue;
+} uct_cuda_event_desc_t;
+
+
+ucs_status_t uct_cuda_iface_track(uct_cuda_iface_t *iface,
+                                  uct_cuda_event_desc_t *event_desc,
+                                  uct_completion_t *comp, void *staging,
+                                  uct_unpack_callback_t unpack_cb,
+                                  void *unpack_arg, size_t length);
+
 #endif
@@ -97,6 +97,8 @@ static ucs_status_t uct_cuda_md_open(const char *md_name, const uct_md_config_t
 
 UCT_MD_COMPONENT_DEFINE(uct_cuda_md, UCT_CUDA_MD_NAME,
                         uct_cuda_query_md_resources, uct_cuda_md_open, NULL,
-                        uct_cuda_rkey_unpack, uct_cuda_rkey_release, "CUDA_",
+                        uct_cuda_rkey_unpack,
+                        ucs_empty_function_return_unsupported,
+                        uct_cuda_rkey_release, "CUDA_",
                         uct_md_config_table, uct_md_config_t);
 
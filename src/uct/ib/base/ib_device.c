@@ -14,6 +14,7 @@
 #include <ucs/sys/compiler.h>
 #include <ucs/sys/string.h>
 #include <ucs/sys/sys.h>
+#include <ucs/sys/topo.h>
 #include <sys/poll.h>
 #include <sched.h>
 
@@ -23,7 +24,8 @@ static ucs_stats_class_t uct_ib_device_stats_class = {
     .name           = "",
     .num_counters   = UCT_IB_DEVICE_STAT_LAST,
     .counter_names = {
-        [UCT_IB_DEVICE_STAT_ASYNC_EVENT] = "async_event"
+        [UCT_IB_DEVICE_STAT_ASYNC_EVENT] = "async_event",
+        [UCT_IB_DEVICE_STAT_PATH_MIG]    = "path_mig"
     }
 };
 #endif
@@ -77,6 +79,11 @@ static void uct_ib_device_get_affinity(const char *dev_name, cpu_set_t *cpu_mask
     }
 }
 
+static int uct_ib_device_get_numa_node(const char *dev_name)
+{
+    return ucs_topo_device_numa_node("infiniband", dev_name);
+}
+
 static void uct_ib_async_event_handler(int fd, void *arg)
 {
     uct_ib_device_t *dev = arg;
@@ -104,12 +111,20 @@ static void uct_ib_async_event_handler(int fd, void *arg)
     case IBV_EVENT_QP_ACCESS_ERR:
     case IBV_EVENT_COMM_EST:
     case IBV_EVENT_SQ_DRAINED:
-    case IBV_EVENT_PATH_MIG:
     case IBV_EVENT_PATH_MIG_ERR:
         snprintf(event_info, sizeof(event_info), "%s on QPN 0x%x",
                  ibv_event_type_str(event.event_type), event.element.qp->qp_num);
         level = UCS_LOG_LEVEL_ERROR;
         break;
+    case IBV_EVENT_PATH_MIG:
+        /* The HCA migrated to the alternate path - traffic continues, so this
+         * is not an error. Account it so fabric issues can be spotted. */
+        snprintf(event_info, sizeof(event_info),
+                 "QPN 0x%x migrated to its alternate path",
+                 event.element.qp->qp_num);
+        UCS_STATS_UPDATE_COUNTER(dev->stats, UCT_IB_DEVICE_STAT_PATH_MIG, +1);
+        level = UCS_LOG_LEVEL_WARN;
+        break;
     case IBV_EVENT_QP_LAST_WQE_REACHED:
         snprintf(event_info, sizeof(event_info), "SRQ-attached QP 0x%x was flushed",
                  event.element.qp->qp_num);
@@ -230,6 +245,7 @@ ucs_status_t uct_ib_device_init(uct_ib_device_t *dev, struct ibv_device *ibv_dev
 
     /* Get device locality */
     uct_ib_device_get_affinity(ibv_get_device_name(ibv_device), &dev->local_cpus);
+    dev->numa_node = uct_ib_device_get_numa_node(ibv_get_device_name(ibv_device));
 
     /* Query all ports */
     for (i = 0; i < dev->num_ports; ++i) {
@@ -264,6 +280,9 @@ ucs_status_t uct_ib_device_init(uct_ib_device_t *dev, struct ibv_device *ibv_dev
         goto err_release_stats;
     }
 
+    kh_init_inplace(uct_ib_ah, &dev->ah_hash);
+    ucs_spinlock_init(&dev->ah_lock);
+
     ucs_debug("initialized device '%s' (%s) with %d ports", uct_ib_device_name(dev),
               ibv_node_type_str(ibv_device->node_type),
               dev->num_ports);
@@ -277,15 +296,66 @@ err:
     return status;
 }
 
+static void uct_ib_device_destroy_ah_cached(uct_ib_device_t *dev)
+{
+    struct ibv_ah *ah;
+
+    kh_foreach_value(&dev->ah_hash, ah, ibv_destroy_ah(ah));
+    kh_destroy_inplace(uct_ib_ah, &dev->ah_hash);
+    ucs_spinlock_destroy(&dev->ah_lock);
+}
+
 void uct_ib_device_cleanup(uct_ib_device_t *dev)
 {
     ucs_debug("destroying ib device %s", uct_ib_device_name(dev));
 
+    uct_ib_device_destroy_ah_cached(dev);
     ucs_async_remove_handler(dev->ibv_context->async_fd, 1);
     UCS_STATS_NODE_FREE(dev->stats);
     ibv_close_device(dev->ibv_context);
 }
 
+ucs_status_t uct_ib_device_create_ah_cached(uct_ib_device_t *dev,
+                                            struct ibv_ah_attr *ah_attr,
+                                            struct ibv_pd *pd,
+                                            struct ibv_ah **ah_p)
+{
+    ucs_status_t status = UCS_OK;
+    struct ibv_ah *ah;
+    khiter_t iter;
+    int ret;
+
+    ucs_spin_lock(&dev->ah_lock);
+
+    /* Looking for existing AH with same attributes */
+    iter = kh_get(uct_ib_ah, &dev->ah_hash, *ah_attr);
+    if (iter == kh_end(&dev->ah_hash)) {
+        /* New AH - resolve the route and add to the hash */
+        ah = ibv_create_ah(pd, ah_attr);
+        if (ah == NULL) {
+            status = UCS_ERR_INVALID_ADDR;
+            goto out_unlock;
+        }
+
+        iter = kh_put(uct_ib_ah, &dev->ah_hash, *ah_attr, &ret);
+        if (iter == kh_end(&dev->ah_hash)) {
+            ibv_destroy_ah(ah);
+            status = UCS_ERR_NO_MEMORY;
+            goto out_unlock;
+        }
+
+        kh_value(&dev->ah_hash, iter) = ah;
+    } else {
+        /* Found existing AH with same attributes - share it */
+        ah = kh_value(&dev->ah_hash, iter);
+    }
+
+    *ah_p = ah;
+out_unlock:
+    ucs_spin_unlock(&dev->ah_lock);
+    return status;
+}
+
 static inline int uct_ib_device_spec_match(uct_ib_device_t *dev,
                                            const uct_ib_device_spec_t *spec)
 {
@@ -788,3 +858,9 @@ size_t uct_ib_device_odp_max_size(uct_ib_device_t *dev)
     return 0;
 #endif /* HAVE_STRUCT_IBV_EXP_DEVICE_ATTR_ODP_CAPS */
 }
+
+int uct_ib_device_odp_has_global_mr(uct_ib_device_t *dev)
+{
+    return (uct_ib_device_odp_max_size(dev) > 0) &&
+           IBV_EXP_HAVE_ODP_IMPLICIT(&dev->dev_attr);
+}
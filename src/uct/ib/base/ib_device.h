@@ -12,8 +12,11 @@
 #include <uct/api/uct.h>
 #include <ucs/stats/stats.h>
 #include <ucs/debug/log.h>
+#include <ucs/datastruct/khash.h>
+#include <ucs/type/spinlock.h>
 
 #include <endian.h>
+#include <string.h>
 
 
 #define UCT_IB_QPN_ORDER            24  /* How many bits can be an IB QP number */
@@ -45,6 +48,7 @@
 
 enum {
     UCT_IB_DEVICE_STAT_ASYNC_EVENT,
+    UCT_IB_DEVICE_STAT_PATH_MIG,
     UCT_IB_DEVICE_STAT_LAST
 };
 
@@ -109,6 +113,29 @@ typedef struct uct_ib_device_spec {
 } uct_ib_device_spec_t;
 
 
+/*
+ * Cache of resolved address handles, keyed by the full address handle
+ * attributes (destination gid/lid, sl, traffic class, etc.). The attributes
+ * structure must be zero-initialized before filling, so that padding bytes
+ * compare equal.
+ */
+static inline khint32_t uct_ib_kh_ah_hash_func(struct ibv_ah_attr attr)
+{
+    return kh_int64_hash_func(attr.grh.dgid.global.subnet_prefix ^
+                              attr.grh.dgid.global.interface_id  ^
+                              attr.dlid);
+}
+
+static inline int uct_ib_kh_ah_hash_equal(struct ibv_ah_attr attr1,
+                                          struct ibv_ah_attr attr2)
+{
+    return !memcmp(&attr1, &attr2, sizeof(attr1));
+}
+
+KHASH_INIT(uct_ib_ah, struct ibv_ah_attr, struct ibv_ah*, 1,
+           uct_ib_kh_ah_hash_func, uct_ib_kh_ah_hash_equal)
+
+
 /**
  * IB device (corresponds to HCA)
  */
@@ -121,8 +148,11 @@ typedef struct uct_ib_device {
     uint8_t                     first_port;      /* Number of first port (usually 1) */
     uint8_t                     num_ports;       /* Amount of physical ports */
     cpu_set_t                   local_cpus;      /* CPUs local to device */
+    int                         numa_node;       /* NUMA node of the device, -1 if unknown */
     UCS_STATS_NODE_DECLARE(stats);
     struct ibv_exp_port_attr    port_attr[UCT_IB_DEV_MAX_PORTS]; /* Cached port attributes */
+    khash_t(uct_ib_ah)          ah_hash;         /* Cached address handles */
+    ucs_spinlock_t              ah_lock;         /* Protects ah_hash */
 } uct_ib_device_t;
 
 
@@ -252,6 +282,8 @@ ucs_status_t uct_ib_device_find_port(uct_ib_device_t *dev,
 
 size_t uct_ib_device_odp_max_size(uct_ib_device_t *dev);
 
+int uct_ib_device_odp_has_global_mr(uct_ib_device_t *dev);
+
 static inline struct ibv_exp_port_attr*
 uct_ib_device_port_attr(uct_ib_device_t *dev, uint8_t port_num)
 {
@@ -263,6 +295,19 @@ uct_ib_device_query_gid(uct_ib_device_t *dev, uint8_t port_num, unsigned gid_ind
                         union ibv_gid *gid);
 
 
+/**
+ * Get an address handle for the given attributes, from the per-device cache.
+ * If no matching handle exists, it is resolved and added to the cache. The
+ * returned handle is shared between all endpoints with the same path
+ * parameters, is owned by the device, and must not be destroyed by the caller
+ * - it is released on device cleanup.
+ */
+ucs_status_t uct_ib_device_create_ah_cached(uct_ib_device_t *dev,
+                                            struct ibv_ah_attr *ah_attr,
+                                            struct ibv_pd *pd,
+                                            struct ibv_ah **ah_p);
+
+
 static inline ucs_status_t uct_ib_poll_cq(struct ibv_cq *cq, unsigned *count, struct ibv_wc *wcs)
 {
     int ret;
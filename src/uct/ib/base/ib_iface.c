@@ -107,6 +107,27 @@ ucs_config_field_t uct_ib_iface_config_table[] = {
   UCT_IFACE_MPOOL_CONFIG_FIELDS("RX_", -1, 0, "receive",
                                 ucs_offsetof(uct_ib_iface_config_t, rx.mp), ""),
 
+  {"CQE_COMPRESSION", "try",
+   "Negotiate compressed CQE sessions on the completion queues. Bursts of\n"
+   "completions are delivered as a single title CQE followed by an array of\n"
+   "8-byte mini CQEs, reducing the PCIe and memory bandwidth spent on\n"
+   "completion traffic at high message rates.",
+   ucs_offsetof(uct_ib_iface_config_t, cqe_compression), UCS_CONFIG_TYPE_TERNARY},
+
+  {"CQ_MODERATION_COUNT", "16",
+   "Number of completions to coalesce into a single CQ event, when event-based\n"
+   "wakeup is used. 0 - do not configure event moderation.",
+   ucs_offsetof(uct_ib_iface_config_t, event_moder.count), UCS_CONFIG_TYPE_UINT},
+
+  {"CQ_MODERATION_PERIOD", "100us",
+   "Maximal delay of a CQ event while completions are being coalesced.",
+   ucs_offsetof(uct_ib_iface_config_t, event_moder.period), UCS_CONFIG_TYPE_TIME},
+
+  {"CQ_MODERATION_ADAPTIVE", "y",
+   "Adapt the coalescing window to the load: grow it while CQ events arrive\n"
+   "back-to-back, shrink it again when the traffic becomes sparse.",
+   ucs_offsetof(uct_ib_iface_config_t, event_moder.adaptive), UCS_CONFIG_TYPE_BOOL},
+
   {"ADDR_TYPE", "auto",
    "Set the interface address type. \"auto\" mode detects the type according to\n"
    "link layer type and IB subnet prefix.",
@@ -142,9 +163,10 @@ static void uct_ib_iface_recv_desc_init(uct_iface_h tl_iface, void *obj, uct_mem
     desc->lkey = ib_memh->lkey;
 }
 
-ucs_status_t uct_ib_iface_recv_mpool_init(uct_ib_iface_t *iface,
-                                          const uct_ib_iface_config_t *config,
-                                          const char *name, ucs_mpool_t *mp)
+ucs_status_t uct_ib_iface_recv_mpool_init_size(uct_ib_iface_t *iface,
+                                               const uct_ib_iface_config_t *config,
+                                               const char *name, size_t seg_size,
+                                               ucs_mpool_t *mp)
 {
     unsigned grow;
 
@@ -157,7 +179,7 @@ ucs_status_t uct_ib_iface_recv_mpool_init(uct_ib_iface_t *iface,
     }
 
     return uct_iface_mpool_init(&iface->super, mp,
-                                iface->config.rx_payload_offset + iface->config.seg_size,
+                                iface->config.rx_payload_offset + seg_size,
                                 iface->config.rx_hdr_offset,
                                 UCS_SYS_CACHE_LINE_SIZE,
                                 &config->rx.mp, grow,
@@ -165,6 +187,14 @@ ucs_status_t uct_ib_iface_recv_mpool_init(uct_ib_iface_t *iface,
                                 name);
 }
 
+ucs_status_t uct_ib_iface_recv_mpool_init(uct_ib_iface_t *iface,
+                                          const uct_ib_iface_config_t *config,
+                                          const char *name, ucs_mpool_t *mp)
+{
+    return uct_ib_iface_recv_mpool_init_size(iface, config, name,
+                                             iface->config.seg_size, mp);
+}
+
 void uct_ib_iface_release_desc(uct_recv_desc_t *self, void *desc)
 {
     uct_ib_iface_t *iface = ucs_container_of(self, uct_ib_iface_t, release_desc);
@@ -248,14 +278,15 @@ ucs_status_t uct_ib_iface_create_ah(uct_ib_iface_t *iface,
                                     int *is_global_p)
 {
     struct ibv_ah_attr ah_attr;
+    ucs_status_t status;
     struct ibv_ah *ah;
     char buf[128];
     char *p, *endp;
 
     uct_ib_iface_fill_ah_attr(iface, ib_addr, path_bits, &ah_attr);
-    ah = ibv_create_ah(uct_ib_iface_md(iface)->pd, &ah_attr);
-
-    if (ah == NULL) {
+    status = uct_ib_device_create_ah_cached(uct_ib_iface_device(iface), &ah_attr,
+                                            uct_ib_iface_md(iface)->pd, &ah);
+    if (status != UCS_OK) {
         p    = buf;
         endp = buf + sizeof(buf);
         snprintf(p, endp - p, "dlid=%d sl=%d port=%d src_path_bits=%d",
@@ -272,7 +303,7 @@ ucs_status_t uct_ib_iface_create_ah(uct_ib_iface_t *iface,
 
         ucs_error("ibv_create_ah(%s) on "UCT_IB_IFACE_FMT" failed: %m", buf,
                   UCT_IB_IFACE_ARG(iface));
-        return UCS_ERR_INVALID_ADDR;
+        return status;
     }
 
     *ah_p        = ah;
@@ -459,6 +490,26 @@ static ucs_status_t uct_ib_iface_create_cq(uct_ib_iface_t *iface, int cq_length,
         goto out;
     }
 
+    if (iface->config.cqe_compression != UCS_NO) {
+        cq = ibv_exp_create_compressed_cq(dev->ibv_context, cq_length,
+                                          iface->comp_channel, preferred_cpu);
+        if (cq != NULL) {
+            ucs_debug("created CQ with compressed CQE sessions on %s",
+                      uct_ib_device_name(dev));
+            goto out_cq;
+        }
+
+        if (iface->config.cqe_compression == UCS_YES) {
+            ucs_error("ibv_exp_create_cq(cqe=%d, COMPRESSED_CQE) failed: %m",
+                      cq_length);
+            status = UCS_ERR_IO_ERROR;
+            goto out_unsetenv;
+        }
+
+        ucs_debug("CQE compression is not supported on %s, falling back "
+                  "to plain CQEs", uct_ib_device_name(dev));
+    }
+
     cq = ibv_create_cq(dev->ibv_context, cq_length, NULL, iface->comp_channel,
                        preferred_cpu);
     if (cq == NULL) {
@@ -467,6 +518,8 @@ static ucs_status_t uct_ib_iface_create_cq(uct_ib_iface_t *iface, int cq_length,
         goto out_unsetenv;
     }
 
+out_cq:
+
     *cq_p = cq;
     status = UCS_OK;
 
@@ -538,6 +591,73 @@ static ucs_status_t uct_ib_iface_create_recv_cq(uct_ib_iface_t *iface,
     }
 }
 
+/* Bounds and pacing of the adaptive coalescing window */
+#define UCT_IB_CQ_MODER_ADAPT_MAX    256
+#define UCT_IB_CQ_MODER_GROW_STREAK  16
+#define UCT_IB_CQ_MODER_BUSY_FACTOR  4
+
+static void uct_ib_iface_cq_moderate(uct_ib_iface_t *iface, struct ibv_cq *cq,
+                                     unsigned count, double period)
+{
+#if HAVE_DECL_IBV_MODIFY_CQ
+    struct ibv_modify_cq_attr attr = {};
+    int ret;
+
+    attr.attr_mask          = IBV_CQ_ATTR_MODERATE;
+    attr.moderate.cq_count  = count;
+    attr.moderate.cq_period = period * UCS_USEC_PER_SEC;
+
+    ret = ibv_modify_cq(cq, &attr);
+    if (ret != 0) {
+        ucs_debug("ibv_modify_cq("UCT_IB_IFACE_FMT", count=%u) failed: %m",
+                  UCT_IB_IFACE_ARG(iface), count);
+    }
+#else
+    ucs_debug("CQ moderation is not supported by the verbs library");
+#endif
+}
+
+static void uct_ib_iface_cq_moder_apply(uct_ib_iface_t *iface)
+{
+    uct_ib_iface_cq_moderate(iface, iface->send_cq, iface->cq_moder.count,
+                             iface->cq_moder.period);
+    uct_ib_iface_cq_moderate(iface, iface->recv_cq, iface->cq_moder.count,
+                             iface->cq_moder.period);
+}
+
+/* Called when the receive CQ is armed; CQ arms closely trailing the previous
+ * one mean the wakeup fires as fast as events can be delivered, so completions
+ * should be coalesced more aggressively. A long quiet gap means latency
+ * matters more than the interrupt rate, so the window shrinks back. */
+static void uct_ib_iface_cq_moder_update(uct_ib_iface_t *iface)
+{
+    ucs_time_t now, busy_gap;
+
+    if (!iface->cq_moder.adaptive || (iface->cq_moder.count == 0)) {
+        return;
+    }
+
+    now      = ucs_get_time();
+    busy_gap = ucs_time_from_sec(iface->cq_moder.period *
+                                 UCT_IB_CQ_MODER_BUSY_FACTOR);
+    if ((now - iface->cq_moder.last_arm) < busy_gap) {
+        if (++iface->cq_moder.streak >= UCT_IB_CQ_MODER_GROW_STREAK) {
+            iface->cq_moder.streak = 0;
+            if (iface->cq_moder.count < UCT_IB_CQ_MODER_ADAPT_MAX) {
+                iface->cq_moder.count *= 2;
+                uct_ib_iface_cq_moder_apply(iface);
+            }
+        }
+    } else {
+        iface->cq_moder.streak = 0;
+        if (iface->cq_moder.count > 1) {
+            iface->cq_moder.count = ucs_max(iface->cq_moder.count / 2, 1);
+            uct_ib_iface_cq_moder_apply(iface);
+        }
+    }
+    iface->cq_moder.last_arm = now;
+}
+
 /**
  * @param rx_headroom   Headroom requested by the user.
  * @param rx_priv_len   Length of transport private data to reserve (0 if unused)
@@ -574,6 +694,7 @@ UCS_CLASS_INIT_FUNC(uct_ib_iface_t, uct_ib_iface_ops_t *ops, uct_md_h md,
     }
 
     self->ops                      = ops;
+    self->super.numa_node          = dev->numa_node;
 
     self->config.rx_payload_offset = sizeof(uct_ib_iface_recv_desc_t) +
                                      ucs_max(sizeof(uct_recv_desc_t) +
@@ -590,6 +711,7 @@ UCS_CLASS_INIT_FUNC(uct_ib_iface_t, uct_ib_iface_ops_t *ops, uct_md_h md,
     self->config.port_num          = port_num;
     self->config.sl                = config->sl;
     self->config.gid_index         = config->gid_index;
+    self->config.cqe_compression   = config->cqe_compression;
     self->release_desc.cb          = uct_ib_iface_release_desc;
 
     status = uct_ib_iface_init_pkey(self, config);
@@ -637,6 +759,15 @@ UCS_CLASS_INIT_FUNC(uct_ib_iface_t, uct_ib_iface_ops_t *ops, uct_md_h md,
         goto err_destroy_send_cq;
     }
 
+    self->cq_moder.count    = config->event_moder.count;
+    self->cq_moder.period   = config->event_moder.period;
+    self->cq_moder.adaptive = config->event_moder.adaptive;
+    self->cq_moder.last_arm = 0;
+    self->cq_moder.streak   = 0;
+    if (self->cq_moder.count > 0) {
+        uct_ib_iface_cq_moder_apply(self);
+    }
+
     /* Address scope and size */
     if (config->addr_type == UCT_IB_IFACE_ADDRESS_TYPE_AUTO) {
         if (IBV_PORT_IS_LINK_LAYER_ETHERNET(uct_ib_iface_port_attr(self))) {
@@ -749,6 +880,7 @@ ucs_status_t uct_ib_iface_query(uct_ib_iface_t *iface, size_t xport_hdr_len,
 
     memset(iface_attr, 0, sizeof(*iface_attr));
 
+    iface_attr->numa_node       = uct_ib_iface_device(iface)->numa_node;
     iface_attr->device_addr_len = iface->addr_size;
 
     switch (active_speed) {
@@ -956,5 +1088,6 @@ ucs_status_t uct_ib_iface_arm_tx_cq(uct_ib_iface_t *iface)
 
 ucs_status_t uct_ib_iface_arm_rx_cq(uct_ib_iface_t *iface, int solicited)
 {
+    uct_ib_iface_cq_moder_update(iface);
     return uct_ib_iface_arm_cq(iface, iface->recv_cq, solicited);
 }
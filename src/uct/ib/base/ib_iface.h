@@ -14,6 +14,7 @@
 #include <ucs/sys/compiler.h>
 #include <ucs/config/parser.h>
 #include <ucs/datastruct/mpool.inl>
+#include <ucs/time/time.h>
 
 #define UCT_IB_MAX_IOV         8UL
 
@@ -58,6 +59,16 @@ struct uct_ib_iface_config {
         uct_iface_mpool_config_t mp;
     } rx;
 
+    /* CQ event (interrupt) moderation */
+    struct {
+        unsigned            count;           /* Completions coalesced into one CQ event */
+        double              period;          /* Maximal delay of a coalesced CQ event */
+        int                 adaptive;        /* Adjust the coalescing window with load */
+    } event_moder;
+
+    /* Negotiate compressed CQE sessions */
+    ucs_ternary_value_t     cqe_compression;
+
     /* Change the address type */
     int                     addr_type;
 
@@ -114,8 +125,17 @@ struct uct_ib_iface {
         uint8_t             sl;
         uint8_t             gid_index;
         size_t              max_iov;             /* Maximum buffers in IOV array */
+        ucs_ternary_value_t cqe_compression;     /* Negotiate compressed CQE sessions */
     } config;
 
+    struct {
+        unsigned            count;           /* Current coalescing window */
+        double              period;          /* Maximal event delay, seconds */
+        int                 adaptive;        /* Whether the window tracks the load */
+        ucs_time_t          last_arm;        /* Time of the previous CQ arm */
+        unsigned            streak;          /* Consecutive closely-spaced arms */
+    } cq_moder;
+
     uct_ib_iface_ops_t      *ops;
 
 };
@@ -173,6 +193,15 @@ extern ucs_config_field_t uct_ib_iface_config_table[];
 extern const char *uct_ib_mtu_values[];
 
 
+/**
+ * Create memory pool of receive descriptors with a custom segment size, for
+ * transports which scatter the packet into more than one buffer.
+ */
+ucs_status_t uct_ib_iface_recv_mpool_init_size(uct_ib_iface_t *iface,
+                                               const uct_ib_iface_config_t *config,
+                                               const char *name, size_t seg_size,
+                                               ucs_mpool_t *mp);
+
 /**
  * Create memory pool of receive descriptors.
  */
@@ -249,6 +278,8 @@ int uct_ib_iface_prepare_rx_wrs(uct_ib_iface_t *iface, ucs_mpool_t *mp,
 void uct_ib_iface_fill_ah_attr(uct_ib_iface_t *iface, const uct_ib_address_t *ib_addr,
                                uint8_t src_path_bits, struct ibv_ah_attr *ah_attr);
 
+/* The returned address handle comes from the per-device cache and is shared
+ * with other endpoints on the same path - the caller must not destroy it. */
 ucs_status_t uct_ib_iface_create_ah(uct_ib_iface_t *iface,
                                     const uct_ib_address_t *ib_addr,
                                     uint8_t path_bits,
@@ -11,8 +11,13 @@
 
 #include <ucs/arch/atomic.h>
 #include <ucs/debug/profile.h>
+#include <ucs/sys/sys.h>
 #include <pthread.h>
 
+#if HAVE_CUDA
+#include <cuda_runtime.h>
+#endif
+
 #ifndef UCT_MD_DISABLE_NUMA
 #include <numaif.h>
 #include <numa.h>
@@ -71,6 +76,12 @@ static ucs_config_field_t uct_ib_md_config_table[] = {
    "between "UCS_PP_MAKE_STRING(UCS_PGT_ADDR_ALIGN)"and system page size",
    ucs_offsetof(uct_ib_md_config_t, rcache.alignment), UCS_CONFIG_TYPE_UINT},
 
+  {"RCACHE_MAX_MERGE", "inf",
+   "Maximal size of a region created by the registration cache when merging\n"
+   "adjacent or overlapping registrations. A single registration larger than\n"
+   "this is still cached as one region",
+   ucs_offsetof(uct_ib_md_config_t, rcache.max_merge), UCS_CONFIG_TYPE_MEMUNITS},
+
   {"RCACHE_MEM_PRIO", "1000", "Registration cache memory event priority",
    ucs_offsetof(uct_ib_md_config_t, rcache.event_prio), UCS_CONFIG_TYPE_UINT},
 
@@ -114,6 +125,12 @@ static ucs_config_field_t uct_ib_md_config_table[] = {
    "Maximal memory region size to enable ODP for. 0 - disable.\n",
    ucs_offsetof(uct_ib_md_config_t, ext.odp.max_size), UCS_CONFIG_TYPE_MEMUNITS},
 
+  {"ODP_IMPLICIT", "n",
+   "Register the whole address space with a single implicit ODP memory region,\n"
+   "if the device supports it. Memory registration and deregistration become\n"
+   "no-ops, and the registration cache is not needed.",
+   ucs_offsetof(uct_ib_md_config_t, ext.odp.implicit), UCS_CONFIG_TYPE_BOOL},
+
   {"DEVICE_SPECS", "",
    "Array of custom device specification. Each element is a string of the following format:\n"
    "  <vendor-id>:<part-id>[:name[:<flags>[:<priority>]]]\n"
@@ -134,6 +151,18 @@ static ucs_config_field_t uct_ib_md_config_table[] = {
    "cause stack smashing.\n",
    ucs_offsetof(uct_ib_md_config_t, ext.enable_contig_pages), UCS_CONFIG_TYPE_BOOL},
 
+  {"REG_MT_THRESH", "4g",
+   "Minimal memory region size to be registered by multiple threads in parallel.\n"
+   "The region is split to chunks which are pinned concurrently and stitched\n"
+   "under a single indirect key, so it requires UMR support on the device.",
+   ucs_offsetof(uct_ib_md_config_t, ext.mt_reg_thresh), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"REG_MT_CHUNK", "2g",
+   "Size of a chunk registered by one thread during multi-threaded registration.\n"
+   "The chunk size is enlarged as needed to fit the region into the maximal\n"
+   "indirect key list supported by the device.",
+   ucs_offsetof(uct_ib_md_config_t, ext.mt_reg_chunk), UCS_CONFIG_TYPE_MEMUNITS},
+
   {NULL}
 };
 
@@ -222,6 +251,8 @@ static ucs_status_t uct_ib_md_umr_qp_create(uct_ib_md_t *md)
     qp_init_attr.exp_create_flags    = IBV_EXP_QP_CREATE_UMR;
 #endif
 
+    md->umr_max_klms = qp_init_attr.max_inl_send_klms;
+
     md->umr_qp = ibv_exp_create_qp(ibdev->ibv_context, &qp_init_attr);
     if (md->umr_qp == NULL) {
         ucs_error("failed to create UMR QP: %m");
@@ -472,6 +503,275 @@ err:
 #endif
 }
 
+/*
+ * Stitch a list of chunk MRs under a single indirect memory key, which covers
+ * the whole region contiguously. The klm list is posted inline on the UMR QP,
+ * so its length is limited by md->umr_max_klms.
+ */
+static ucs_status_t uct_ib_md_post_umr_mr_list(uct_ib_md_t *md, void *address,
+                                               struct ibv_mr **mrs, int num_mrs,
+                                               struct ibv_mr **umr_p)
+{
+#if HAVE_EXP_UMR
+    struct ibv_exp_mem_region *mem_reg;
+    struct ibv_exp_send_wr wr, *bad_wr;
+    struct ibv_exp_create_mr_in mrin;
+    ucs_status_t status;
+    struct ibv_mr *umr;
+    struct ibv_wc wc;
+    int i, ret;
+
+    if ((md->umr_qp == NULL) || (num_mrs > md->umr_max_klms)) {
+        status = UCS_ERR_UNSUPPORTED;
+        goto err;
+    }
+
+    mem_reg = ucs_calloc(num_mrs, sizeof(*mem_reg), "umr_mr_list");
+    if (mem_reg == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err;
+    }
+
+    /* Create memory key */
+    memset(&mrin, 0, sizeof(mrin));
+    mrin.pd                       = md->pd;
+
+#ifdef HAVE_EXP_UMR_NEW_API
+    mrin.attr.create_flags        = IBV_EXP_MR_INDIRECT_KLMS;
+    mrin.attr.exp_access_flags    = UCT_IB_MEM_ACCESS_FLAGS;
+    mrin.attr.max_klm_list_size   = num_mrs;
+#else
+    mrin.attr.create_flags        = IBV_MR_NONCONTIG_MEM;
+    mrin.attr.access_flags        = UCT_IB_MEM_ACCESS_FLAGS;
+    mrin.attr.max_reg_descriptors = num_mrs;
+#endif
+
+    umr = ibv_exp_create_mr(&mrin);
+    if (!umr) {
+        ucs_error("Failed to create modified_mr: %m");
+        status = UCS_ERR_NO_MEMORY;
+        goto err_free_list;
+    }
+
+    /* Fill memory list and UMR */
+    memset(&wr, 0, sizeof(wr));
+    for (i = 0; i < num_mrs; ++i) {
+        mem_reg[i].base_addr                       = (uintptr_t)mrs[i]->addr;
+        mem_reg[i].length                          = mrs[i]->length;
+#ifdef HAVE_EXP_UMR_NEW_API
+        mem_reg[i].mr                              = mrs[i];
+#else
+        mem_reg[i].m_key                           = mrs[i];
+#endif
+    }
+
+#ifdef HAVE_EXP_UMR_NEW_API
+    wr.ext_op.umr.umr_type                         = IBV_EXP_UMR_MR_LIST;
+    wr.ext_op.umr.mem_list.mem_reg_list            = mem_reg;
+    wr.ext_op.umr.exp_access                       = UCT_IB_MEM_ACCESS_FLAGS;
+    wr.ext_op.umr.modified_mr                      = umr;
+    wr.ext_op.umr.base_addr                        = (uint64_t)(uintptr_t)address;
+    wr.ext_op.umr.num_mrs                          = num_mrs;
+#else
+    wr.ext_op.umr.memory_key.mkey_type             = IBV_EXP_UMR_MEM_LAYOUT_NONCONTIG;
+    wr.ext_op.umr.memory_key.mem_list.mem_reg_list = mem_reg;
+    wr.ext_op.umr.memory_key.access                = UCT_IB_MEM_ACCESS_FLAGS;
+    wr.ext_op.umr.memory_key.modified_mr           = umr;
+    wr.ext_op.umr.memory_key.region_base_addr      = address;
+    wr.num_sge                                     = num_mrs;
+#endif
+
+    wr.exp_opcode                                  = IBV_EXP_WR_UMR_FILL;
+    wr.exp_send_flags                              = IBV_EXP_SEND_INLINE | IBV_EXP_SEND_SIGNALED;
+
+    /* Post UMR */
+    ret = ibv_exp_post_send(md->umr_qp, &wr, &bad_wr);
+    if (ret) {
+        ucs_error("ibv_exp_post_send(UMR_FILL) failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_free_umr;
+    }
+
+    /* Wait for send UMR completion */
+    for (;;) {
+        ret = ibv_poll_cq(md->umr_cq, 1, &wc);
+        if (ret < 0) {
+            ucs_error("ibv_exp_poll_cq(umr_cq) failed: %m");
+            status = UCS_ERR_IO_ERROR;
+            goto err_free_umr;
+        }
+        if (ret == 1) {
+            if (wc.status != IBV_WC_SUCCESS) {
+                ucs_error("UMR_FILL completed with error: %s vendor_err %d",
+                          ibv_wc_status_str(wc.status), wc.vendor_err);
+                status = UCS_ERR_IO_ERROR;
+                goto err_free_umr;
+            }
+            break;
+        }
+    }
+
+    ucs_trace("UMR registered %d chunks at %p on %s lkey 0x%x rkey 0x%x",
+              num_mrs, address, uct_ib_device_name(&md->dev), umr->lkey,
+              umr->rkey);
+    *umr_p = umr;
+    ucs_free(mem_reg);
+    return UCS_OK;
+
+err_free_umr:
+    ibv_dereg_mr(umr);
+err_free_list:
+    ucs_free(mem_reg);
+err:
+    return status;
+#else
+    return UCS_ERR_UNSUPPORTED;
+#endif
+}
+
+typedef struct uct_ib_md_mem_reg_thread {
+    pthread_t           thread;
+    uct_ib_md_t         *md;
+    void                *address;
+    size_t              length;
+    size_t              chunk;
+    uint64_t            exp_access;
+    struct ibv_mr       **mrs;
+    int                 index;
+    int                 stride;
+    ucs_status_t        status;
+} uct_ib_md_mem_reg_thread_t;
+
+static void *uct_ib_md_mem_reg_thread_func(void *arg)
+{
+    uct_ib_md_mem_reg_thread_t *ctx = arg;
+    size_t offset, chunk_length;
+    ucs_status_t status;
+    int i;
+
+    /* Thread 'index' registers chunks index, index+stride, ... so all threads
+     * finish at roughly the same time regardless of the chunk count */
+    for (i = ctx->index; (size_t)i * ctx->chunk < ctx->length; i += ctx->stride) {
+        offset       = (size_t)i * ctx->chunk;
+        chunk_length = ucs_min(ctx->chunk, ctx->length - offset);
+        status       = uct_ib_md_reg_mr(ctx->md, ctx->address + offset,
+                                        chunk_length, ctx->exp_access, 1,
+                                        &ctx->mrs[i]);
+        if (status != UCS_OK) {
+            ctx->status = status;
+            return NULL;
+        }
+    }
+
+    ctx->status = UCS_OK;
+    return NULL;
+}
+
+/*
+ * Register a large region by multiple threads in parallel, one chunk at a
+ * time, and stitch the chunks under a single indirect key, so the zcopy
+ * senders see an ordinary contiguous lkey/rkey. Registration time scales with
+ * the number of cores instead of the region size alone.
+ */
+static ucs_status_t
+uct_ib_md_mem_reg_multithreaded(uct_ib_md_t *md, void *address, size_t length,
+                                uint64_t exp_access, uct_ib_mem_t *memh)
+{
+    size_t chunk = md->config.mt_reg_chunk;
+    uct_ib_md_mem_reg_thread_t *threads;
+    struct ibv_mr **mrs;
+    ucs_status_t status;
+    int num_mrs, num_threads;
+    int i, ret;
+
+    if ((md->umr_qp == NULL) || (md->umr_max_klms < 2)) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    /* Enlarge the chunk until the klm list fits on the umr qp */
+    while (ucs_div_round_up(length, chunk) > md->umr_max_klms) {
+        chunk *= 2;
+    }
+
+    num_mrs = ucs_div_round_up(length, chunk);
+    if (num_mrs < 2) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    num_threads = ucs_min(num_mrs, (int)ucs_max(1, sysconf(_SC_NPROCESSORS_ONLN)));
+
+    mrs = ucs_calloc(num_mrs, sizeof(*mrs), "ib_mt_mrs");
+    if (mrs == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    threads = ucs_calloc(num_threads, sizeof(*threads), "ib_mt_threads");
+    if (threads == NULL) {
+        status = UCS_ERR_NO_MEMORY;
+        goto err_free_mrs;
+    }
+
+    for (i = 0; i < num_threads; ++i) {
+        threads[i].md         = md;
+        threads[i].address    = address;
+        threads[i].length     = length;
+        threads[i].chunk      = chunk;
+        threads[i].exp_access = exp_access;
+        threads[i].mrs        = mrs;
+        threads[i].index      = i;
+        threads[i].stride     = num_threads;
+        threads[i].status     = UCS_OK;
+
+        ret = pthread_create(&threads[i].thread, NULL,
+                             uct_ib_md_mem_reg_thread_func, &threads[i]);
+        if (ret != 0) {
+            ucs_error("pthread_create() failed: %m");
+            /* Join the threads which did start, and bail out */
+            num_threads = i;
+            status      = UCS_ERR_IO_ERROR;
+            break;
+        }
+    }
+
+    status = UCS_OK;
+    for (i = 0; i < num_threads; ++i) {
+        pthread_join(threads[i].thread, NULL);
+        if (threads[i].status != UCS_OK) {
+            status = threads[i].status;
+        }
+    }
+
+    if (status != UCS_OK) {
+        goto err_dereg;
+    }
+
+    status = uct_ib_md_post_umr_mr_list(md, address, mrs, num_mrs, &memh->mr);
+    if (status != UCS_OK) {
+        goto err_dereg;
+    }
+
+    ucs_debug("multi-threaded registration of %p..%p on %s: %d chunks of %zu, "
+              "%d threads, lkey 0x%x rkey 0x%x", address, address + length,
+              uct_ib_device_name(&md->dev), num_mrs, chunk, num_threads,
+              memh->mr->lkey, memh->mr->rkey);
+
+    memh->mt_mrs     = mrs;
+    memh->mt_num_mrs = num_mrs;
+    ucs_free(threads);
+    return UCS_OK;
+
+err_dereg:
+    for (i = 0; i < num_mrs; ++i) {
+        if (mrs[i] != NULL) {
+            ibv_dereg_mr(mrs[i]);
+        }
+    }
+    ucs_free(threads);
+err_free_mrs:
+    ucs_free(mrs);
+    return status;
+}
+
 static ucs_status_t uct_ib_dereg_mr(struct ibv_mr *mr)
 {
     int ret;
@@ -487,9 +787,10 @@ static ucs_status_t uct_ib_dereg_mr(struct ibv_mr *mr)
 
 static ucs_status_t uct_ib_memh_dereg(uct_ib_mem_t *memh)
 {
-    ucs_status_t s1, s2;
+    ucs_status_t s1, s2, s3;
+    int i;
 
-    s1 = s2 = UCS_OK;
+    s1 = s2 = s3 = UCS_OK;
     if (memh->flags & UCT_IB_MEM_FLAG_ATOMIC_MR) {
         s2 = uct_ib_dereg_mr(memh->atomic_mr);
         memh->flags &= ~UCT_IB_MEM_FLAG_ATOMIC_MR;
@@ -497,7 +798,16 @@ static ucs_status_t uct_ib_memh_dereg(uct_ib_mem_t *memh)
     if (memh->mr != NULL) {
         s1 = uct_ib_dereg_mr(memh->mr);
     }
-    return (s1 != UCS_OK) ? s1 : s2;
+    if (memh->mt_mrs != NULL) {
+        /* The indirect mr above was destroyed first - now release the chunk
+         * mrs which backed it */
+        for (i = 0; i < memh->mt_num_mrs; ++i) {
+            s3 = uct_ib_dereg_mr(memh->mt_mrs[i]);
+        }
+        ucs_free(memh->mt_mrs);
+        memh->mt_mrs = NULL;
+    }
+    return (s1 != UCS_OK) ? s1 : (s2 != UCS_OK) ? s2 : s3;
 }
 
 static void uct_ib_memh_free(uct_ib_mem_t *memh)
@@ -510,6 +820,25 @@ static uct_ib_mem_t *uct_ib_memh_alloc()
     return ucs_calloc(1, sizeof(uct_ib_mem_t), "ib_memh");
 }
 
+#if HAVE_CUDA
+static int uct_ib_mem_is_cuda(void *address)
+{
+    struct cudaPointerAttributes attr;
+
+    if (cudaPointerGetAttributes(&attr, address) != cudaSuccess) {
+        /* Pointer unknown to the CUDA runtime - plain host memory */
+        (void)cudaGetLastError();
+        return 0;
+    }
+    return attr.memoryType == cudaMemoryTypeDevice;
+}
+#else
+static int uct_ib_mem_is_cuda(void *address)
+{
+    return 0;
+}
+#endif
+
 static uint64_t uct_ib_md_access_flags(uct_ib_md_t *md, unsigned flags,
                                        size_t length)
 {
@@ -733,18 +1062,47 @@ static ucs_status_t uct_ib_mem_reg_internal(uct_md_h uct_md, void *address,
     uct_ib_md_t *md = ucs_derived_of(uct_md, uct_ib_md_t);
     ucs_status_t status;
     uint64_t exp_access;
+    int is_gpu;
+
+    is_gpu = uct_ib_mem_is_cuda(address);
+    if (is_gpu) {
+        /* Device memory registers through peer-direct and cannot be backed
+         * by on-demand paging */
+        flags &= ~UCT_MD_MEM_FLAG_NONBLOCK;
+    }
+
+    memh->mt_mrs     = NULL;
+    memh->mt_num_mrs = 0;
 
     exp_access = uct_ib_md_access_flags(md, flags, length);
+    if ((length >= md->config.mt_reg_thresh) && !is_gpu &&
+        !(exp_access & IBV_EXP_ACCESS_ON_DEMAND)) {
+        status = uct_ib_md_mem_reg_multithreaded(md, address, length,
+                                                 exp_access, memh);
+        if (status == UCS_OK) {
+            goto out_registered;
+        }
+        /* Fall back to a single registration call on any failure */
+        ucs_debug("multi-threaded registration of %p length %zu failed (%s), "
+                  "falling back to a single mr", address, length,
+                  ucs_status_string(status));
+    }
+
     status = uct_ib_md_reg_mr(md, address, length, exp_access, silent, &memh->mr);
     if (status != UCS_OK) {
         return status;
     }
 
-    ucs_debug("registered memory %p..%p on %s lkey 0x%x rkey 0x%x",
-              address, address + length, uct_ib_device_name(&md->dev),
-              memh->mr->lkey, memh->mr->rkey);
+out_registered:
+
+    ucs_debug("registered %smemory %p..%p on %s lkey 0x%x rkey 0x%x",
+              is_gpu ? "gpu " : "", address, address + length,
+              uct_ib_device_name(&md->dev), memh->mr->lkey, memh->mr->rkey);
 
     uct_ib_mem_init(memh, exp_access);
+    if (is_gpu) {
+        memh->flags |= UCT_IB_MEM_FLAG_GPU;
+    }
     uct_ib_mem_set_numa_policy(md, memh);
     if (md->config.odp.prefetch) {
         uct_ib_mem_prefetch_internal(md, memh, memh->mr->addr, memh->mr->length);
@@ -757,9 +1115,22 @@ static ucs_status_t uct_ib_mem_reg_internal(uct_md_h uct_md, void *address,
 static ucs_status_t uct_ib_mem_reg(uct_md_h uct_md, void *address, size_t length,
                                    unsigned flags, uct_mem_h *memh_p)
 {
+    uct_ib_md_t *md = ucs_derived_of(uct_md, uct_ib_md_t);
     ucs_status_t status;
     uct_ib_mem_t *memh;
 
+    if ((md->global_odp.mr != NULL) && !uct_ib_mem_is_cuda(address)) {
+        /* Implicit ODP covers the whole address space - every registration
+         * returns the shared memory handle, and the pages fault in on access.
+         * Device memory cannot fault in, so it always takes a dedicated
+         * peer-direct registration below */
+        if (md->config.odp.prefetch) {
+            uct_ib_mem_prefetch_internal(md, &md->global_odp, address, length);
+        }
+        *memh_p = &md->global_odp;
+        return UCS_OK;
+    }
+
     memh = uct_ib_memh_alloc();
     if (memh == NULL) {
         return UCS_ERR_NO_MEMORY;
@@ -782,9 +1153,15 @@ static ucs_status_t uct_ib_mem_dereg_internal(uct_ib_mem_t *memh)
 
 static ucs_status_t uct_ib_mem_dereg(uct_md_h uct_md, uct_mem_h memh)
 {
+    uct_ib_md_t *md = ucs_derived_of(uct_md, uct_ib_md_t);
     uct_ib_mem_t *ib_memh = memh;
     ucs_status_t status;
 
+    if (ib_memh == &md->global_odp) {
+        /* Shared implicit ODP handle - stays valid until the MD is closed */
+        return UCS_OK;
+    }
+
     status = uct_ib_mem_dereg_internal(ib_memh);
     uct_ib_memh_free(ib_memh);
     return status;
@@ -996,6 +1373,18 @@ out:
     return status;
 }
 
+static void uct_ib_md_fork_prepare(void *arg)
+{
+    uct_ib_md_t *md = arg;
+
+    /* Quiesce the registration cache, so pinned pages (madvise-DONTFORK
+     * tagged when ibv_fork_init() is in effect) do not linger across fork().
+     * Regions the application still holds stay registered. */
+    if (md->rcache != NULL) {
+        ucs_rcache_flush(md->rcache);
+    }
+}
+
 static void uct_ib_fork_warn()
 {
     ucs_warn("ibv_fork_init() was not successful, yet a fork() has been issued.");
@@ -1134,6 +1523,9 @@ uct_ib_md_open(const char *md_name, const uct_md_config_t *uct_md_config, uct_md
     md->super.ops             = &uct_ib_md_ops;
     md->super.component       = &uct_ib_mdc;
     md->rcache                = NULL;
+    md->global_odp.mr         = NULL;
+    md->global_odp.mt_mrs     = NULL;
+    md->global_odp.mt_num_mrs = 0;
     md->reg_cost              = md_config->uc_reg_cost;
     md->config                = md_config->ext;
 
@@ -1184,16 +1576,38 @@ uct_ib_md_open(const char *md_name, const uct_md_config_t *uct_md_config, uct_md
 
     status = uct_ib_md_umr_qp_create(md);
     if (status == UCS_ERR_UNSUPPORTED) {
-        md->umr_qp = NULL;
-        md->umr_cq = NULL;
+        md->umr_qp       = NULL;
+        md->umr_cq       = NULL;
+        md->umr_max_klms = 0;
     } else if (status != UCS_OK) {
         goto err_dealloc_pd;
     }
 
-    if (md_config->rcache.enable != UCS_NO) {
+    if (md->config.odp.implicit && (md->config.odp.max_size > 0) &&
+        uct_ib_device_odp_has_global_mr(&md->dev)) {
+        /* Register the whole address space once. All subsequent registrations
+         * return this handle, so there is no pinning churn and no need for
+         * the registration cache. */
+        status = uct_ib_md_reg_mr(md, 0, UINT64_MAX, IBV_EXP_ACCESS_ON_DEMAND,
+                                  1, &md->global_odp.mr);
+        if (status == UCS_OK) {
+            ucs_debug("%s: registered global ODP region, lkey 0x%x",
+                      uct_ib_device_name(&md->dev), md->global_odp.mr->lkey);
+            uct_ib_mem_init(&md->global_odp, IBV_EXP_ACCESS_ON_DEMAND);
+        } else {
+            ucs_debug("%s: failed to register global ODP region: %s",
+                      uct_ib_device_name(&md->dev), ucs_status_string(status));
+            md->global_odp.mr = NULL;
+        }
+    }
+
+    if ((md_config->rcache.enable != UCS_NO) && (md->global_odp.mr == NULL)) {
         UCS_STATIC_ASSERT(UCS_PGT_ADDR_ALIGN >= UCT_IB_MD_RCACHE_DEFAULT_ALIGN);
         rcache_params.region_struct_size = sizeof(uct_ib_rcache_region_t);
         rcache_params.alignment          = md_config->rcache.alignment;
+        rcache_params.max_merged_size    =
+                        (md_config->rcache.max_merge == UCS_CONFIG_MEMUNITS_INF) ?
+                        0 : md_config->rcache.max_merge;
         rcache_params.ucm_event_priority = md_config->rcache.event_prio;
         rcache_params.context            = md;
         rcache_params.ops                = &uct_ib_rcache_ops;
@@ -1221,6 +1635,12 @@ uct_ib_md_open(const char *md_name, const uct_md_config_t *uct_md_config, uct_md
         goto err_destroy_rcache;
     }
 
+    status = ucs_sys_atfork(uct_ib_md_fork_prepare, NULL, md);
+    if (status != UCS_OK) {
+        ucs_debug("failed to register fork handler for %s",
+                  uct_ib_device_name(&md->dev));
+    }
+
     *md_p = &md->super;
     status = UCS_OK;
 
@@ -1234,6 +1654,9 @@ err_destroy_rcache:
         ucs_rcache_destroy(md->rcache);
     }
 err_destroy_umr_qp:
+    if (md->global_odp.mr != NULL) {
+        uct_ib_dereg_mr(md->global_odp.mr);
+    }
     uct_ib_md_umr_qp_destroy(md);
 err_dealloc_pd:
     ibv_dealloc_pd(md->pd);
@@ -1250,10 +1673,14 @@ static void uct_ib_md_close(uct_md_h uct_md)
 {
     uct_ib_md_t *md = ucs_derived_of(uct_md, uct_ib_md_t);
 
+    ucs_sys_atfork_remove(md);
     uct_ib_md_release_device_config(md);
     if (md->rcache != NULL) {
         ucs_rcache_destroy(md->rcache);
     }
+    if (md->global_odp.mr != NULL) {
+        uct_ib_dereg_mr(md->global_odp.mr);
+    }
     uct_ib_md_umr_qp_destroy(md);
     ibv_dealloc_pd(md->pd);
     uct_ib_device_cleanup(&md->dev);
@@ -1264,5 +1691,6 @@ static void uct_ib_md_close(uct_md_h uct_md)
 UCT_MD_COMPONENT_DEFINE(uct_ib_mdc, UCT_IB_MD_PREFIX,
                         uct_ib_query_md_resources, uct_ib_md_open, NULL,
                         uct_ib_rkey_unpack,
+                        ucs_empty_function_return_unsupported,
                         (void*)ucs_empty_function_return_success /* release */,
                         "IB_", uct_ib_md_config_table, uct_ib_md_config_t);
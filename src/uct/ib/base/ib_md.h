@@ -39,7 +39,9 @@ typedef enum {
 
 enum {
     UCT_IB_MEM_FLAG_ODP       = UCS_BIT(0),
-    UCT_IB_MEM_FLAG_ATOMIC_MR = UCS_BIT(1)
+    UCT_IB_MEM_FLAG_ATOMIC_MR = UCS_BIT(1),
+    UCT_IB_MEM_FLAG_GPU       = UCS_BIT(2)  /**< GPU device memory, registered
+                                                 through peer-direct */
 };
 
 
@@ -50,11 +52,18 @@ typedef struct uct_ib_md_ext_config {
                                                          device */
     int                      enable_contig_pages; /** Enable contiguous pages */
 
+    size_t                   mt_reg_thresh; /**< Threshold for multi-threaded
+                                                 registration */
+    size_t                   mt_reg_chunk;  /**< Chunk size for multi-threaded
+                                                 registration */
+
     struct {
         uct_ib_numa_policy_t numa_policy;  /**< NUMA policy flags for ODP */
         int                  prefetch;     /**< Auto-prefetch non-blocking memory
                                                 registrations / allocations */
         size_t               max_size;     /**< Maximal memory region size for ODP */
+        int                  implicit;     /**< Register the whole address space
+                                                with one implicit ODP MR */
     } odp;
 
 } uct_ib_md_ext_config_t;
@@ -65,6 +74,10 @@ typedef struct uct_ib_mem {
     uint32_t                flags;
     struct ibv_mr           *mr;
     struct ibv_mr           *atomic_mr;
+    struct ibv_mr           **mt_mrs;    /**< Chunk MRs backing an indirect mr,
+                                              when the region was registered by
+                                              multiple threads. NULL otherwise */
+    int                     mt_num_mrs;
 } uct_ib_mem_t;
 
 /**
@@ -73,12 +86,16 @@ typedef struct uct_ib_mem {
 typedef struct uct_ib_md {
     uct_md_t                 super;
     ucs_rcache_t             *rcache;   /**< Registration cache (can be NULL) */
+    uct_ib_mem_t             global_odp;/**< Implicit ODP memory handle covering
+                                             the whole address space, mr is NULL
+                                             if unsupported or disabled */
     struct ibv_pd            *pd;       /**< IB memory domain */
     uct_ib_device_t          dev;       /**< IB device */
     uct_linear_growth_t      reg_cost;  /**< Memory registration cost */
     /* keep it in md because pd is needed to create umr_qp/cq */
     struct ibv_qp            *umr_qp;   /* special QP for creating UMR */
     struct ibv_cq            *umr_cq;   /* special CQ for creating UMR */
+    unsigned                 umr_max_klms; /* max inline klm list length on umr_qp */
     UCS_STATS_NODE_DECLARE(stats);
     uct_ib_md_ext_config_t   config;    /* IB external configuration */
     struct {
@@ -97,6 +114,7 @@ typedef struct uct_ib_md_config {
     struct {
         ucs_ternary_value_t  enable;       /**< Enable registration cache */
         size_t               alignment;    /**< Force address alignment */
+        size_t               max_merge;    /**< Maximal size of merged regions */
         unsigned             event_prio;   /**< Memory events priority */
         double               overhead;     /**< Lookup overhead estimation */
     } rcache;
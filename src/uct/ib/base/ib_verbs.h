@@ -86,6 +86,12 @@
 #  define IBV_EXP_ODP_CAPS(_attr, _xport)           0
 #endif
 
+#if HAVE_STRUCT_IBV_EXP_DEVICE_ATTR_ODP_CAPS && HAVE_DECL_IBV_EXP_ODP_SUPPORT_IMPLICIT
+#  define IBV_EXP_HAVE_ODP_IMPLICIT(_attr)          ((_attr)->odp_caps.general_odp_caps & IBV_EXP_ODP_SUPPORT_IMPLICIT)
+#else
+#  define IBV_EXP_HAVE_ODP_IMPLICIT(_attr)          0
+#endif
+
 #if !HAVE_DECL_IBV_EXP_ACCESS_ON_DEMAND
 #  define IBV_EXP_ACCESS_ON_DEMAND                  0
 #endif
@@ -145,6 +151,30 @@ static inline int ibv_exp_cq_ignore_overrun(struct ibv_cq *cq)
 #endif /* HAVE_IBV_EXP_CQ_IGNORE_OVERRUN */
 
 
+/*
+ * CQE compression support
+ */
+#if HAVE_DECL_IBV_EXP_CQ_COMPRESSED_CQE
+static inline struct ibv_cq *
+ibv_exp_create_compressed_cq(struct ibv_context *context, int cqe,
+                             struct ibv_comp_channel *channel, int comp_vector)
+{
+    struct ibv_exp_cq_init_attr cq_attr = {0};
+    cq_attr.comp_mask = IBV_EXP_CQ_INIT_ATTR_FLAGS;
+    cq_attr.flags     = IBV_EXP_CQ_COMPRESSED_CQE;
+    return ibv_exp_create_cq(context, cqe, NULL, channel, comp_vector, &cq_attr);
+}
+#else
+static inline struct ibv_cq *
+ibv_exp_create_compressed_cq(struct ibv_context *context, int cqe,
+                             struct ibv_comp_channel *channel, int comp_vector)
+{
+    errno = ENOSYS;
+    return NULL;
+}
+#endif /* HAVE_IBV_EXP_CQ_COMPRESSED_CQE */
+
+
 /*
  * Atomics support
  */
@@ -50,6 +50,10 @@ typedef struct uct_cm_iface {
     ucs_queue_head_t          notify_q;        /* Notification queue */
     uint32_t                  num_outstanding; /* Number of outstanding sends */
     ucs_queue_head_t          outstanding_q;   /* Outstanding operations queue */
+    ucs_queue_head_t          avail_q;         /* Idle CM ids from completed sends,
+                                                  reused by subsequent sends to avoid
+                                                  a create/destroy syscall pair per
+                                                  message */
     ucs_callbackq_slow_elem_t cbq_elem;        /* Slow-path callback */
     uint8_t                   cbq_elem_on;
 
@@ -70,6 +74,8 @@ typedef struct uct_cm_ep {
     uint8_t                is_global;
     uint32_t               dest_service_id;
     union ibv_gid          dgid;
+    struct ibv_sa_path_rec path;   /* Path record to the peer, resolved once at
+                                      creation and reused by every send */
 } uct_cm_ep_t;
 
 
@@ -104,7 +110,8 @@ ucs_status_t uct_cm_iface_flush_do(uct_cm_iface_t *iface, uct_completion_t *comp
 ssize_t uct_cm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id, uct_pack_callback_t pack_cb,
                            void *arg);
 
-ucs_status_t uct_cm_ep_pending_add(uct_ep_h ep, uct_pending_req_t *req);
+ucs_status_t uct_cm_ep_pending_add(uct_ep_h ep, uct_pending_req_t *req,
+                                   unsigned flags);
 void uct_cm_ep_pending_purge(uct_ep_h ep, uct_pending_purge_callback_t cb,
                              void *arg);
 
@@ -20,32 +20,6 @@ typedef struct uct_cm_iov {
 } uct_cm_iov_t;
 
 
-static UCS_CLASS_INIT_FUNC(uct_cm_ep_t, uct_iface_t *tl_iface,
-                           const uct_device_addr_t *dev_addr,
-                           const uct_iface_addr_t *iface_addr)
-
-{
-    uct_cm_iface_t *iface = ucs_derived_of(tl_iface, uct_cm_iface_t);
-
-    UCS_CLASS_CALL_SUPER_INIT(uct_base_ep_t, &iface->super.super);
-
-    uct_ib_address_unpack((const uct_ib_address_t*)dev_addr, &self->dlid,
-                          &self->is_global, &self->dgid);
-    self->dest_service_id = *(const uint32_t*)iface_addr;
-    return UCS_OK;
-}
-
-static UCS_CLASS_CLEANUP_FUNC(uct_cm_ep_t)
-{
-    ucs_trace_func("");
-}
-
-UCS_CLASS_DEFINE(uct_cm_ep_t, uct_base_ep_t);
-UCS_CLASS_DEFINE_NEW_FUNC(uct_cm_ep_t, uct_ep_t, uct_iface_h,
-                          const uct_device_addr_t *, const uct_iface_addr_t *);
-UCS_CLASS_DEFINE_DELETE_FUNC(uct_cm_ep_t, uct_ep_t);
-
-
 static ucs_status_t uct_cm_ep_fill_path_rec(uct_cm_ep_t *ep,
                                             struct ibv_sa_path_rec *path)
 {
@@ -99,16 +73,50 @@ static void uct_cm_dump_path(struct ibv_sa_path_rec *path)
                    path->preference);
 }
 
+static UCS_CLASS_INIT_FUNC(uct_cm_ep_t, uct_iface_t *tl_iface,
+                           const uct_device_addr_t *dev_addr,
+                           const uct_iface_addr_t *iface_addr)
+
+{
+    uct_cm_iface_t *iface = ucs_derived_of(tl_iface, uct_cm_iface_t);
+    ucs_status_t status;
+
+    UCS_CLASS_CALL_SUPER_INIT(uct_base_ep_t, &iface->super.super);
+
+    uct_ib_address_unpack((const uct_ib_address_t*)dev_addr, &self->dlid,
+                          &self->is_global, &self->dgid);
+    self->dest_service_id = *(const uint32_t*)iface_addr;
+
+    /* Resolve the path once - every send to this peer reuses it */
+    status = uct_cm_ep_fill_path_rec(self, &self->path);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    uct_cm_dump_path(&self->path);
+    return UCS_OK;
+}
+
+static UCS_CLASS_CLEANUP_FUNC(uct_cm_ep_t)
+{
+    ucs_trace_func("");
+}
+
+UCS_CLASS_DEFINE(uct_cm_ep_t, uct_base_ep_t);
+UCS_CLASS_DEFINE_NEW_FUNC(uct_cm_ep_t, uct_ep_t, uct_iface_h,
+                          const uct_device_addr_t *, const uct_iface_addr_t *);
+UCS_CLASS_DEFINE_DELETE_FUNC(uct_cm_ep_t, uct_ep_t);
+
 ssize_t uct_cm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t am_id,
                            uct_pack_callback_t pack_cb, void *arg)
 {
     uct_cm_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cm_iface_t);
     uct_cm_ep_t *ep = ucs_derived_of(tl_ep, uct_cm_ep_t);
+    char buf[IB_CM_SIDR_REQ_PRIVATE_DATA_SIZE];
+    uct_cm_hdr_t *hdr = (uct_cm_hdr_t*)buf;
     struct ib_cm_sidr_req_param req;
-    struct ibv_sa_path_rec path;
     uct_cm_iface_op_t *op;
     ucs_status_t status;
-    uct_cm_hdr_t *hdr;
     size_t payload_len;
     size_t total_len;
     int ret;
@@ -122,50 +130,45 @@ ssize_t uct_cm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t am_id,
         goto err;
     }
 
-    /* Allocate temporary contiguous buffer */
-    hdr = ucs_malloc(IB_CM_SIDR_REQ_PRIVATE_DATA_SIZE, "cm_send_buf");
-    if (hdr == NULL) {
-        status = UCS_ERR_NO_MEMORY;
-        goto err;
-    }
-
+    /* The private data is copied by the kernel during the send call, so a
+     * stack buffer is sufficient */
     payload_len = pack_cb(hdr + 1, arg);
     hdr->am_id  = am_id;
     hdr->length = payload_len;
     total_len   = sizeof(*hdr) + payload_len;
 
-    status = uct_cm_ep_fill_path_rec(ep, &path);
-    if (status != UCS_OK) {
-        goto err_free_hdr;
-    }
-
-    /* Fill SIDR request */
+    /* Fill SIDR request, reusing the path record resolved at ep creation */
     memset(&req, 0, sizeof req);
-    req.path             = &path;
+    req.path             = &ep->path;
     req.service_id       = ep->dest_service_id;
     req.timeout_ms       = iface->config.timeout_ms;
     req.private_data     = hdr;
     req.private_data_len = total_len;
     req.max_cm_retries   = iface->config.retry_count;
 
-    op = ucs_malloc(sizeof *op, "cm_op");
-    if (op == NULL) {
-        status = UCS_ERR_NO_MEMORY;
-        goto err_free_hdr;
-    }
+    /* Reuse a CM id from a previously completed send, if one is cached.
+     * Otherwise, create a new ID for this message. It will be cached when
+     * getting REP. */
+    if (!ucs_queue_is_empty(&iface->avail_q)) {
+        op = ucs_queue_pull_elem_non_empty(&iface->avail_q, uct_cm_iface_op_t,
+                                           queue);
+    } else {
+        op = ucs_malloc(sizeof *op, "cm_op");
+        if (op == NULL) {
+            status = UCS_ERR_NO_MEMORY;
+            goto err;
+        }
 
-    op->is_id = 1;
+        op->is_id = 1;
 
-    /* Create temporary ID for this message. Will be released when getting REP. */
-    ret = ib_cm_create_id(iface->cmdev, &op->id, NULL);
-    if (ret) {
-        ucs_error("ib_cm_create_id() failed: %m");
-        status = UCS_ERR_IO_ERROR;
-        goto err_free_op;
+        ret = ib_cm_create_id(iface->cmdev, &op->id, NULL);
+        if (ret) {
+            ucs_error("ib_cm_create_id() failed: %m");
+            status = UCS_ERR_IO_ERROR;
+            goto err_free_op;
+        }
     }
 
-    uct_cm_dump_path(&path);
-
     ret = ib_cm_send_sidr_req(op->id, &req);
     if (ret) {
         ucs_error("ib_cm_send_sidr_req() failed: %m");
@@ -180,10 +183,9 @@ ssize_t uct_cm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t am_id,
 
     uct_cm_iface_trace_data(iface, UCT_AM_TRACE_TYPE_SEND, hdr,
                             "TX: SIDR_REQ [id %p{%u} dlid %d svc 0x%"PRIx64"]",
-                            op->id, op->id->handle, ntohs(path.dlid),
+                            op->id, op->id->handle, ntohs(ep->path.dlid),
                             (uint64_t)req.service_id);
     uct_cm_leave(iface);
-    ucs_free(hdr);
     /* coverity[missing_unlock] */
     return payload_len;
 
@@ -191,14 +193,13 @@ err_destroy_id:
     ib_cm_destroy_id(op->id);
 err_free_op:
     ucs_free(op);
-err_free_hdr:
-    ucs_free(hdr);
 err:
     uct_cm_leave(iface);
     return status;
 }
 
-ucs_status_t uct_cm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *req)
+ucs_status_t uct_cm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *req,
+                                   unsigned flags)
 {
     uct_cm_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_cm_iface_t);
     uct_cm_ep_t *ep = ucs_derived_of(tl_ep, uct_cm_ep_t);
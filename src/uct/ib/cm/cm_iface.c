@@ -34,6 +34,10 @@ static ucs_config_field_t uct_cm_iface_config_table[] = {
   {NULL}
 };
 
+/* Number of CM ids to destroy with a single batch of syscalls */
+#define UCT_CM_IFACE_EVENT_BATCH    16
+
+
 static uct_ib_iface_ops_t uct_cm_iface_ops;
 
 
@@ -142,8 +146,8 @@ static void uct_cm_iface_handle_sidr_req(uct_cm_iface_t *iface,
     uct_iface_invoke_am(&iface->super.super, hdr->am_id, hdr + 1, hdr->length, 0);
 }
 
-static void uct_cm_iface_outstanding_remove(uct_cm_iface_t* iface,
-                                            struct ib_cm_id* id)
+static uct_cm_iface_op_t *
+uct_cm_iface_outstanding_remove(uct_cm_iface_t* iface, struct ib_cm_id* id)
 {
     uct_cm_iface_op_t *op;
     ucs_queue_iter_t iter;
@@ -152,8 +156,7 @@ static void uct_cm_iface_outstanding_remove(uct_cm_iface_t* iface,
         if (op->is_id && (op->id == id)) {
             ucs_queue_del_iter(&iface->outstanding_q, iter);
             --iface->num_outstanding;
-            ucs_free(op);
-            return;
+            return op;
         }
     }
 
@@ -175,10 +178,36 @@ static void uct_cm_iface_outstanding_purge(uct_cm_iface_t *iface)
     iface->num_outstanding = 0;
 }
 
+static void uct_cm_iface_avail_purge(uct_cm_iface_t *iface)
+{
+    uct_cm_iface_op_t *op;
+
+    ucs_queue_for_each_extract(op, &iface->avail_q, queue, 1) {
+        ib_cm_destroy_id(op->id);
+        ucs_free(op);
+    }
+}
+
+static void uct_cm_iface_destroy_ids(struct ib_cm_id **ids, unsigned count)
+{
+    unsigned i;
+    int ret;
+
+    for (i = 0; i < count; ++i) {
+        ret = ib_cm_destroy_id(ids[i]);
+        if (ret) {
+            ucs_error("ib_cm_destroy_id() failed: %m");
+        }
+    }
+}
+
 static void uct_cm_iface_event_handler(int fd, void *arg)
 {
     uct_cm_iface_t *iface = arg;
+    struct ib_cm_id *destroy_ids[UCT_CM_IFACE_EVENT_BATCH];
+    unsigned num_destroy_ids = 0;
     struct ib_cm_event *event;
+    uct_cm_iface_op_t *op;
     struct ib_cm_id *id;
     int destroy_id;
     int ret;
@@ -192,7 +221,7 @@ static void uct_cm_iface_event_handler(int fd, void *arg)
             if (errno != EAGAIN) {
                 ucs_warn("ib_cm_get_event() failed: %m");
             }
-            return;
+            break;
         }
 
         id  = event->cm_id;
@@ -210,8 +239,11 @@ static void uct_cm_iface_event_handler(int fd, void *arg)
             break;
         case IB_CM_SIDR_REP_RECEIVED:
             ucs_trace_data("RX: SIDR_REP [id %p{%u}]", id, id->handle);
-            uct_cm_iface_outstanding_remove(iface, id);
-            destroy_id = 1; /* Destroy the ID which was used for sending */
+            op = uct_cm_iface_outstanding_remove(iface, id);
+            /* The ID which was used for sending is idle again - cache it
+             * for the next send instead of destroying it */
+            ucs_queue_push(&iface->avail_q, &op->queue);
+            destroy_id = 0;
             break;
         default:
             ucs_warn("Unexpected CM event: %d", event->event);
@@ -225,22 +257,25 @@ static void uct_cm_iface_event_handler(int fd, void *arg)
             ucs_warn("ib_cm_ack_event() failed: %m");
         }
 
-        /* If there is an id which should be destroyed, do it now, after
-         * acknowledging all events.
+        /* Collect ids which should be destroyed, and destroy them in batches
+         * after acknowledging all events, instead of a syscall per event.
          */
         if (destroy_id) {
-            ret = ib_cm_destroy_id(id);
-            if (ret) {
-                ucs_error("ib_cm_destroy_id() failed: %m");
+            destroy_ids[num_destroy_ids++] = id;
+            if (num_destroy_ids == UCT_CM_IFACE_EVENT_BATCH) {
+                uct_cm_iface_destroy_ids(destroy_ids, num_destroy_ids);
+                num_destroy_ids = 0;
             }
         }
 
         if (!iface->cbq_elem_on) {
-            uct_worker_slowpath_progress_register(uct_cm_iface_worker(iface), 
+            uct_worker_slowpath_progress_register(uct_cm_iface_worker(iface),
                                                   &iface->cbq_elem);
             iface->cbq_elem_on = 1;
         }
     }
+
+    uct_cm_iface_destroy_ids(destroy_ids, num_destroy_ids);
 }
 
 static void uct_cm_iface_release_desc(uct_recv_desc_t *self, void *desc)
@@ -282,6 +317,7 @@ static UCS_CLASS_INIT_FUNC(uct_cm_iface_t, uct_md_h md, uct_worker_h worker,
     self->cbq_elem.cb         = uct_cm_iface_progress;
     ucs_queue_head_init(&self->notify_q);
     ucs_queue_head_init(&self->outstanding_q);
+    ucs_queue_head_init(&self->avail_q);
 
     /* Redefine receive desc release callback */
     self->super.release_desc.cb = uct_cm_iface_release_desc;
@@ -359,6 +395,7 @@ static UCS_CLASS_CLEANUP_FUNC(uct_cm_iface_t)
 
     uct_cm_enter(self);
     uct_cm_iface_outstanding_purge(self);
+    uct_cm_iface_avail_purge(self);
     ib_cm_destroy_id(self->listen_id);
     ib_cm_close_device(self->cmdev);
     if (self->cbq_elem_on) {
@@ -92,20 +92,13 @@ static ucs_status_t uct_dc_mlx5_iface_query(uct_iface_h tl_iface, uct_iface_attr
                                       UCT_IFACE_FLAG_PUT_ZCOPY|
                                       UCT_IFACE_FLAG_GET_BCOPY|
                                       UCT_IFACE_FLAG_GET_ZCOPY|
-                                      UCT_IFACE_FLAG_ATOMIC_ADD64|
-                                      UCT_IFACE_FLAG_ATOMIC_FADD64|
-                                      UCT_IFACE_FLAG_ATOMIC_SWAP64|
-                                      UCT_IFACE_FLAG_ATOMIC_CSWAP64|
-                                      UCT_IFACE_FLAG_ATOMIC_ADD32|
-                                      UCT_IFACE_FLAG_ATOMIC_FADD32|
-                                      UCT_IFACE_FLAG_ATOMIC_SWAP32|
-                                      UCT_IFACE_FLAG_ATOMIC_CSWAP32|
-                                      UCT_IFACE_FLAG_ATOMIC_DEVICE |
                                       UCT_IFACE_FLAG_PENDING|
                                       UCT_IFACE_FLAG_AM_CB_SYNC|
                                       UCT_IFACE_FLAG_CONNECT_TO_IFACE|
                                       UCT_IFACE_FLAG_ERRHANDLE_PEER_FAILURE;
 
+    uct_dc_iface_query_atomic_caps(&iface->super, iface_attr);
+
     return UCS_OK;
 }
 
@@ -657,6 +650,24 @@ static ucs_status_t uct_dc_mlx5_iface_reset_dci(uct_dc_iface_t *dc_iface, int dc
     return status;
 }
 
+static ucs_status_t uct_dc_mlx5_iface_init_dci(uct_dc_iface_t *dc_iface, int dci)
+{
+    uct_dc_mlx5_iface_t *iface = ucs_derived_of(dc_iface, uct_dc_mlx5_iface_t);
+    ucs_status_t status;
+
+    status = uct_ib_mlx5_txwq_init(dc_iface->super.super.super.worker,
+                                   &iface->dci_wqs[dci],
+                                   dc_iface->tx.dcis[dci].txqp.qp);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    ucs_assert(iface->dci_wqs[dci].bb_max == dc_iface->super.config.tx_qp_len);
+    uct_rc_txqp_available_set(&dc_iface->tx.dcis[dci].txqp,
+                              iface->dci_wqs[dci].bb_max);
+    return UCS_OK;
+}
+
 static uct_dc_iface_ops_t uct_dc_mlx5_iface_ops = {
     {
     {
@@ -706,7 +717,8 @@ static uct_dc_iface_ops_t uct_dc_mlx5_iface_ops = {
     .fc_ctrl                  = uct_dc_mlx5_ep_fc_ctrl,
     .fc_handler               = uct_dc_iface_fc_handler,
     },
-    .reset_dci                = uct_dc_mlx5_iface_reset_dci
+    .reset_dci                = uct_dc_mlx5_iface_reset_dci,
+    .init_dci                 = uct_dc_mlx5_iface_init_dci
 };
 
 
@@ -717,7 +729,7 @@ static ucs_status_t uct_dc_mlx5_iface_init_dcis(uct_dc_mlx5_iface_t *iface)
     int i;
 
     bb_max = 0;
-    for (i = 0; i < iface->super.tx.ndci; i++) {
+    for (i = 0; i < iface->super.tx.ndci_active; i++) {
         status = uct_ib_mlx5_txwq_init(iface->super.super.super.super.worker,
                                        &iface->dci_wqs[i],
                                        iface->super.tx.dcis[i].txqp.qp);
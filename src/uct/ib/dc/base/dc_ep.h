@@ -52,7 +52,8 @@ uct_dc_iface_dci_do_pending_tx(ucs_arbiter_t *arbiter,
                                ucs_arbiter_elem_t *elem,
                                void *arg);
 
-ucs_status_t uct_dc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *r);
+ucs_status_t uct_dc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *r,
+                                   unsigned flags);
 void uct_dc_ep_pending_purge(uct_ep_h tl_ep, uct_pending_purge_callback_t cb, void *arg);
 
 void uct_dc_ep_cleanup(uct_ep_h tl_ep, ucs_class_t *cls);
@@ -128,7 +129,7 @@ static UCS_F_ALWAYS_INLINE ucs_status_t uct_dc_ep_basic_init(uct_dc_iface_t *ifa
 
 static inline int uct_dc_iface_dci_can_alloc_dcs(uct_dc_iface_t *iface)
 {
-    return iface->tx.stack_top < iface->tx.ndci;
+    return iface->tx.stack_top < iface->tx.ndci_active;
 }
 
 static inline int uct_dc_iface_dci_ep_can_send(uct_dc_ep_t *ep)
@@ -275,6 +276,12 @@ static inline ucs_status_t uct_dc_iface_dci_get_dcs(uct_dc_iface_t *iface, uct_d
         return UCS_OK;
     }
 
+    /* all active dcis are taken - try to grow the pool, up to NUM_DCI */
+    if (uct_dc_iface_dci_pool_grow(iface) == UCS_OK) {
+        uct_dc_iface_dci_alloc_dcs(iface, ep);
+        return UCS_OK;
+    }
+
     /* we will have to wait until someone releases dci */
     UCS_STATS_UPDATE_COUNTER(ep->super.stats, UCT_EP_STAT_NO_RES, 1);
     return UCS_ERR_NO_RESOURCE;
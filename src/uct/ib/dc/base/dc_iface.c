@@ -23,6 +23,12 @@ ucs_config_field_t uct_dc_iface_config_table[] = {
      "(up to " UCS_PP_QUOTE(UCT_DC_IFACE_MAX_DCIS) ").",
      ucs_offsetof(uct_dc_iface_config_t, ndci), UCS_CONFIG_TYPE_UINT},
 
+    {"NUM_DCI_INITIAL", "2",
+     "Initial number of DCIs created by the interface. The pool grows on\n"
+     "demand, up to NUM_DCI, when all active DCIs are held by endpoints and\n"
+     "more endpoints need to send.",
+     ucs_offsetof(uct_dc_iface_config_t, ndci_initial), UCS_CONFIG_TYPE_UINT},
+
     {"TX_POLICY", "dcs_quota",
      "Specifies how DC initiator (DCI) is selected by the endpoint. The policies are:\n"
      "\n"
@@ -148,10 +154,13 @@ static ucs_status_t uct_dc_iface_create_dcis(uct_dc_iface_t *iface,
     ucs_status_t status;
     int i;
 
-    ucs_debug("creating %d dci(s)", iface->tx.ndci);
+    iface->tx.ndci_active = ucs_max(1, ucs_min(config->ndci_initial,
+                                               iface->tx.ndci));
+    ucs_debug("creating %d of up to %d dci(s)", iface->tx.ndci_active,
+              iface->tx.ndci);
 
     iface->tx.stack_top = 0;
-    for (i = 0; i < iface->tx.ndci; i++) {
+    for (i = 0; i < iface->tx.ndci_active; i++) {
         status = uct_rc_txqp_init(&iface->tx.dcis[i].txqp, &iface->super,
                                   IBV_EXP_QPT_DC_INI, &cap,
                                   iface->super.rx.srq.srq
@@ -177,6 +186,52 @@ err:
     return status;
 }
 
+ucs_status_t uct_dc_iface_dci_pool_grow(uct_dc_iface_t *iface)
+{
+    uct_dc_iface_ops_t *dc_ops = ucs_derived_of(iface->super.super.ops,
+                                                uct_dc_iface_ops_t);
+    struct ibv_qp_cap cap;
+    ucs_status_t status;
+    int dci;
+
+    if (iface->tx.ndci_active >= iface->tx.ndci) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    /* the pool grows only when all active dcis are taken */
+    ucs_assert(iface->tx.stack_top == iface->tx.ndci_active);
+
+    dci    = iface->tx.ndci_active;
+    status = uct_rc_txqp_init(&iface->tx.dcis[dci].txqp, &iface->super,
+                              IBV_EXP_QPT_DC_INI, &cap,
+                              iface->super.rx.srq.srq
+                              UCS_STATS_ARG(iface->super.stats));
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = uct_dc_iface_dci_connect(iface, &iface->tx.dcis[dci].txqp);
+    if (status != UCS_OK) {
+        goto err_txqp_cleanup;
+    }
+
+    status = dc_ops->init_dci(iface, dci);
+    if (status != UCS_OK) {
+        goto err_txqp_cleanup;
+    }
+
+    iface->tx.dcis[dci].ep    = NULL;
+    iface->tx.dcis_stack[dci] = dci;
+    iface->tx.ndci_active++;
+    ucs_debug("iface %p grew dci pool to %d dci(s)", iface,
+              iface->tx.ndci_active);
+    return UCS_OK;
+
+err_txqp_cleanup:
+    uct_rc_txqp_cleanup(&iface->tx.dcis[dci].txqp);
+    return status;
+}
+
 void uct_dc_iface_set_quota(uct_dc_iface_t *iface, uct_dc_iface_config_t *config)
 {
     iface->tx.available_quota = iface->super.config.tx_qp_len -
@@ -251,7 +306,7 @@ static UCS_CLASS_CLEANUP_FUNC(uct_dc_iface_t)
     ucs_list_for_each_safe(ep, tmp, &self->tx.gc_list, list) {
         uct_dc_ep_release(ep);
     }
-    uct_dc_iface_dcis_destroy(self, self->tx.ndci);
+    uct_dc_iface_dcis_destroy(self, self->tx.ndci_active);
     ucs_arbiter_cleanup(&self->tx.dci_arbiter);
     uct_dc_iface_cleanup_fc_ep(self);
 }
@@ -270,6 +325,35 @@ void uct_dc_iface_query(uct_dc_iface_t *iface, uct_iface_attr_t *iface_attr)
     iface_attr->latency.overhead += 60e-9; /* connect packet + cqe */
 }
 
+/* Advertise only the atomic operations the device can actually execute,
+ * the same way the rc query does. The 32-bit and swap operations go over
+ * extended/masked atomics, which not every device supports. */
+void uct_dc_iface_query_atomic_caps(uct_dc_iface_t *iface,
+                                    uct_iface_attr_t *iface_attr)
+{
+    uct_ib_device_t *dev = uct_ib_iface_device(&iface->super.super);
+
+    if (uct_ib_atomic_is_supported(dev, 0, sizeof(uint64_t))) {
+        iface_attr->cap.flags |= UCT_IFACE_FLAG_ATOMIC_ADD64 |
+                                 UCT_IFACE_FLAG_ATOMIC_FADD64 |
+                                 UCT_IFACE_FLAG_ATOMIC_CSWAP64 |
+                                 UCT_IFACE_FLAG_ATOMIC_DEVICE;
+    }
+
+    if (uct_ib_atomic_is_supported(dev, 1, sizeof(uint64_t))) {
+        iface_attr->cap.flags |= UCT_IFACE_FLAG_ATOMIC_SWAP64 |
+                                 UCT_IFACE_FLAG_ATOMIC_DEVICE;
+    }
+
+    if (uct_ib_atomic_is_supported(dev, 1, sizeof(uint32_t))) {
+        iface_attr->cap.flags |= UCT_IFACE_FLAG_ATOMIC_ADD32 |
+                                 UCT_IFACE_FLAG_ATOMIC_FADD32 |
+                                 UCT_IFACE_FLAG_ATOMIC_SWAP32 |
+                                 UCT_IFACE_FLAG_ATOMIC_CSWAP32 |
+                                 UCT_IFACE_FLAG_ATOMIC_DEVICE;
+    }
+}
+
 ucs_status_t
 uct_dc_iface_get_address(uct_iface_h tl_iface, uct_iface_addr_t *iface_addr)
 {
@@ -297,7 +381,7 @@ static inline ucs_status_t uct_dc_iface_flush_dcis(uct_dc_iface_t *iface)
     int i;
     int is_flush_done = 1;
 
-    for (i = 0; i < iface->tx.ndci; i++) {
+    for (i = 0; i < iface->tx.ndci_active; i++) {
         if ((iface->tx.dcis[i].ep != NULL) &&
             uct_dc_ep_fc_wait_for_grant(iface->tx.dcis[i].ep)) {
             return UCS_ERR_NO_RESOURCE;
@@ -422,7 +506,8 @@ ucs_status_t uct_dc_iface_fc_handler(uct_rc_iface_t *rc_iface, unsigned qp_num,
 
         status = uct_dc_iface_fc_grant(&dc_req->super.super);
         if (status == UCS_ERR_NO_RESOURCE){
-            status = uct_ep_pending_add(&ep->super.super, &dc_req->super.super);
+            status = uct_ep_pending_add(&ep->super.super, &dc_req->super.super,
+                                        UCT_PENDING_FLAG_CTRL);
         }
         ucs_assertv_always(status == UCS_OK, "Failed to send FC grant msg: %s",
                            ucs_status_string(status));
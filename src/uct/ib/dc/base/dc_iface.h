@@ -33,6 +33,7 @@ typedef enum {
 typedef struct uct_dc_iface_config {
     uct_rc_iface_config_t         super;
     int                           ndci;
+    int                           ndci_initial;
     int                           tx_policy;
     unsigned                      quota;
 } uct_dc_iface_config_t;
@@ -60,6 +61,10 @@ typedef struct uct_dc_fc_request {
 typedef struct uct_dc_iface_ops {
     uct_rc_iface_ops_t            super;
     ucs_status_t                  (*reset_dci)(uct_dc_iface_t *iface, int dci);
+
+    /* Initialize the transport-specific part of a dci which was created after
+     * the interface, when the pool grows on demand */
+    ucs_status_t                  (*init_dci)(uct_dc_iface_t *iface, int dci);
 } uct_dc_iface_ops_t;
 
 
@@ -67,7 +72,10 @@ struct uct_dc_iface {
     uct_rc_iface_t                super;
     struct {
         uct_dc_dci_t              dcis[UCT_DC_IFACE_MAX_DCIS]; /* Array of dcis */
-        uint8_t                   ndci;                        /* Number of DCIs */
+        uint8_t                   ndci;                        /* Max number of DCIs */
+        uint8_t                   ndci_active;                 /* Number of DCIs created so
+                                                                  far; grows on demand up
+                                                                  to ndci */
         uct_dc_tx_policty_t       policy;                      /* dci selection algorithm */
         int16_t                   available_quota;             /* if available tx is lower, let
                                                                   another endpoint use the dci */
@@ -99,6 +107,9 @@ extern ucs_config_field_t uct_dc_iface_config_table[];
 
 void uct_dc_iface_query(uct_dc_iface_t *iface, uct_iface_attr_t *iface_attr);
 
+void uct_dc_iface_query_atomic_caps(uct_dc_iface_t *iface,
+                                    uct_iface_attr_t *iface_attr);
+
 ucs_status_t uct_dc_iface_get_address(uct_iface_h tl_iface, uct_iface_addr_t *iface_addr);
 
 ucs_status_t uct_dc_device_query_tl_resources(uct_ib_device_t *dev,
@@ -122,6 +133,8 @@ ucs_status_t uct_dc_iface_fc_handler(uct_rc_iface_t *rc_iface, unsigned qp_num,
 
 void uct_dc_handle_failure(uct_ib_iface_t *ib_iface, uint32_t qp_num);
 
+ucs_status_t uct_dc_iface_dci_pool_grow(uct_dc_iface_t *iface);
+
 /* TODO:
  * use a better seach algorithm (perfect hash, bsearch, hash) ???
  *
@@ -131,7 +144,7 @@ void uct_dc_handle_failure(uct_ib_iface_t *ib_iface, uint32_t qp_num);
 static inline uint8_t uct_dc_iface_dci_find(uct_dc_iface_t *iface, uint32_t qp_num)
 {
     uct_dc_dci_t *dcis = iface->tx.dcis;
-    int i, ndci = iface->tx.ndci;
+    int i, ndci = iface->tx.ndci_active;
 
     for (i = 0; i < ndci; i++) {
         if (dcis[i].txqp.qp->qp_num == qp_num) {
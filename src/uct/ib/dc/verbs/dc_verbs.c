@@ -58,7 +58,7 @@ static UCS_CLASS_INIT_FUNC(uct_dc_verbs_ep_t,
 static UCS_CLASS_CLEANUP_FUNC(uct_dc_verbs_ep_t)
 {
     ucs_trace_func("");
-    ibv_destroy_ah(self->ah);
+    /* The address handle is cached on the device and released with it */
 }
 
 UCS_CLASS_DEFINE(uct_dc_verbs_ep_t, uct_dc_ep_t);
@@ -86,20 +86,13 @@ static ucs_status_t uct_dc_verbs_iface_query(uct_iface_h tl_iface, uct_iface_att
                                       UCT_IFACE_FLAG_PUT_ZCOPY|
                                       UCT_IFACE_FLAG_GET_BCOPY|
                                       UCT_IFACE_FLAG_GET_ZCOPY|
-                                      UCT_IFACE_FLAG_ATOMIC_ADD64|
-                                      UCT_IFACE_FLAG_ATOMIC_FADD64|
-                                      UCT_IFACE_FLAG_ATOMIC_SWAP64|
-                                      UCT_IFACE_FLAG_ATOMIC_CSWAP64|
-                                      UCT_IFACE_FLAG_ATOMIC_ADD32|
-                                      UCT_IFACE_FLAG_ATOMIC_FADD32|
-                                      UCT_IFACE_FLAG_ATOMIC_SWAP32|
-                                      UCT_IFACE_FLAG_ATOMIC_CSWAP32|
-                                      UCT_IFACE_FLAG_ATOMIC_DEVICE |
                                       UCT_IFACE_FLAG_PENDING|
                                       UCT_IFACE_FLAG_AM_CB_SYNC|
                                       UCT_IFACE_FLAG_CONNECT_TO_IFACE|
                                       UCT_IFACE_FLAG_ERRHANDLE_PEER_FAILURE;
 
+    uct_dc_iface_query_atomic_caps(&iface->super, iface_attr);
+
     return UCS_OK;
 }
 
@@ -583,10 +576,11 @@ ucs_status_t uct_dc_verbs_iface_create_ah(uct_dc_iface_t *dc_iface, uint16_t lid
                                           struct ibv_ah **ah_p)
 {
     struct ibv_ah_attr ah_attr;
-    struct ibv_ah *ah;
     uct_ib_iface_t *iface = &dc_iface->super.super;
+    ucs_status_t status;
 
     /* TODO: GRH, path_bits, etc */
+    memset(&ah_attr, 0, sizeof(ah_attr));
     ah_attr.sl            = iface->config.sl;
     ah_attr.src_path_bits = iface->path_bits[0];
     ah_attr.dlid          = lid | ah_attr.src_path_bits;
@@ -594,15 +588,13 @@ ucs_status_t uct_dc_verbs_iface_create_ah(uct_dc_iface_t *dc_iface, uint16_t lid
     ah_attr.is_global     = 0;
     ah_attr.static_rate   = 0;
 
-    ah = ibv_create_ah(uct_ib_iface_md(iface)->pd, &ah_attr);
-    if (ucs_unlikely(ah == NULL)) {
+    status = uct_ib_device_create_ah_cached(uct_ib_iface_device(iface), &ah_attr,
+                                            uct_ib_iface_md(iface)->pd, ah_p);
+    if (ucs_unlikely(status != UCS_OK)) {
         ucs_error("Failed to create ah on "UCT_IB_IFACE_FMT,
                   UCT_IB_IFACE_ARG(iface));
-        return UCS_ERR_INVALID_ADDR;
     }
-
-    *ah_p = ah;
-    return UCS_OK;
+    return status;
 }
 
 static void uct_dc_verbs_handle_failure(uct_ib_iface_t *ib_iface, void *arg)
@@ -634,6 +626,16 @@ static ucs_status_t uct_dc_verbs_reset_dci(uct_dc_iface_t *dc_iface, int dci)
     return uct_rc_modify_qp(&dc_iface->tx.dcis[dci].txqp, IBV_QPS_RESET);
 }
 
+static ucs_status_t uct_dc_verbs_iface_init_dci(uct_dc_iface_t *dc_iface, int dci)
+{
+    uct_dc_verbs_iface_t *iface = ucs_derived_of(dc_iface, uct_dc_verbs_iface_t);
+
+    uct_rc_verbs_txcnt_init(&iface->dcis_txcnt[dci]);
+    uct_rc_txqp_available_set(&dc_iface->tx.dcis[dci].txqp,
+                              dc_iface->super.config.tx_qp_len);
+    return UCS_OK;
+}
+
 /* Send either request for grants or grant message. Request includes ep
  * structure address, which will be received back in a grant message.
  * This will help to determine the particular ep targeted by the grant.
@@ -679,7 +681,6 @@ ucs_status_t uct_dc_verbs_ep_fc_ctrl(uct_ep_h tl_ep, unsigned op,
         uct_dc_verbs_iface_post_send_to_dci(iface, &wr, dc_ep->dci, ah,
                                             dc_req->dct_num,
                                             IBV_SEND_INLINE | IBV_SEND_SIGNALED);
-        ibv_destroy_ah(ah);
     } else {
         ucs_assert(op == UCT_RC_EP_FC_FLAG_HARD_REQ);
         iface->verbs_common.inl_sge[1].addr   = (uintptr_t)&dc_ep;
@@ -798,7 +799,8 @@ static uct_dc_iface_ops_t uct_dc_verbs_iface_ops = {
     .fc_ctrl                  = uct_dc_verbs_ep_fc_ctrl,
     .fc_handler               = uct_dc_iface_fc_handler,
     },
-    .reset_dci                = uct_dc_verbs_reset_dci
+    .reset_dci                = uct_dc_verbs_reset_dci,
+    .init_dci                 = uct_dc_verbs_iface_init_dci
 };
 
 void uct_dc_verbs_iface_init_wrs(uct_dc_verbs_iface_t *self)
@@ -855,7 +857,7 @@ static UCS_CLASS_INIT_FUNC(uct_dc_verbs_iface_t, uct_md_h md, uct_worker_h worke
 
     self->verbs_common.config.max_inline = dci_init_attr.cap.max_inline_data;
 
-    for (i = 0; i < self->super.tx.ndci; i++) {
+    for (i = 0; i < self->super.tx.ndci_active; i++) {
         uct_rc_verbs_txcnt_init(&self->dcis_txcnt[i]);
         uct_rc_txqp_available_set(&self->super.tx.dcis[i].txqp,
                                   self->super.super.config.tx_qp_len);
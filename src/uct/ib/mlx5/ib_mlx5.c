@@ -169,6 +169,9 @@ ucs_status_t uct_ib_mlx5_get_cq(struct ibv_cq *cq, uct_ib_mlx5_cq_t *mlx5_cq)
     cqe_size             = mcq->cqe_sz;
 #endif
 
+    /* The whole CQ poll state must fit in one cache line */
+    UCS_STATIC_ASSERT(sizeof(uct_ib_mlx5_cq_t) <= UCS_SYS_CACHE_LINE_SIZE);
+
     /* Move buffer forward for 128b CQE, so we would get pointer to the 2nd
      * 64b when polling.
      */
@@ -230,7 +233,6 @@ ucs_status_t uct_ib_mlx5_get_compact_av(uct_ib_iface_t *iface, int *compact_av)
     }
 
     uct_ib_mlx5_get_av(ah, &mlx5_av);
-    ibv_destroy_ah(ah);
 
     /* copy MLX5_EXTENDED_UD_AV from the driver, if the flag is not present then
      * the device supports compact address vector. */
@@ -239,6 +241,48 @@ ucs_status_t uct_ib_mlx5_get_compact_av(uct_ib_iface_t *iface, int *compact_av)
 }
 
 
+void uct_ib_mlx5_cq_expand_minicqes(uct_ib_mlx5_cq_t *cq, unsigned index,
+                                    struct mlx5_cqe64 *title_cqe)
+{
+    uct_ib_mlx5_mini_cqe8_t minis[UCT_IB_MLX5_MINICQE_ARR_SIZE];
+    struct mlx5_cqe64 title = *title_cqe;
+    const uct_ib_mlx5_mini_cqe8_t *mini;
+    struct mlx5_cqe64 *cqe;
+    uint16_t wqe_counter;
+    unsigned count, i;
+    uint8_t op_own;
+
+    count       = ntohl(title.byte_cnt);
+    wqe_counter = ntohs(title.wqe_counter);
+    op_own      = title.op_own & 0xf0; /* keep the opcode, clear the format */
+
+    /* The first mini CQE array sits in the slot following the title; further
+     * arrays are emitted every 8 completions, in the slot of the completion
+     * they describe first. Each array is copied aside just before the slot it
+     * occupies is rewritten with an expanded CQE.
+     */
+    memcpy(minis, uct_ib_mlx5_get_cqe(cq, index + 1), sizeof(minis));
+    for (i = 0; i < count; ++i) {
+        if ((i > 0) && ((i % UCT_IB_MLX5_MINICQE_ARR_SIZE) == 0)) {
+            memcpy(minis, uct_ib_mlx5_get_cqe(cq, index + i), sizeof(minis));
+        }
+
+        mini = &minis[i % UCT_IB_MLX5_MINICQE_ARR_SIZE];
+        cqe  = uct_ib_mlx5_get_cqe(cq, index + i);
+
+        *cqe          = title;
+        cqe->byte_cnt = mini->byte_cnt;
+        if ((title.op_own >> 4) == MLX5_CQE_REQ) {
+            /* Send completion - the mini CQE carries its own WQE counter */
+            cqe->wqe_counter = mini->s_wqe_info.wqe_counter;
+        } else {
+            /* Receive completions of a session consume consecutive WQEs */
+            cqe->wqe_counter = htons(wqe_counter + i);
+        }
+        cqe->op_own = op_own | !!((index + i) & cq->cq_length);
+    }
+}
+
 struct mlx5_cqe64* uct_ib_mlx5_check_completion(uct_ib_iface_t *iface,
                                                 uct_ib_mlx5_cq_t *cq,
                                                 struct mlx5_cqe64 *cqe)
@@ -283,6 +327,8 @@ void uct_ib_mlx5_txwq_reset(uct_ib_mlx5_txwq_t *txwq)
 {
     txwq->curr     = txwq->qstart;
     txwq->sw_pi    = txwq->prev_sw_pi = 0;
+    txwq->db_pending = 0;
+    txwq->db_ctrl  = NULL;
 #if ENABLE_ASSERT
     txwq->hw_ci    = 0xFFFF;
 #endif
@@ -295,6 +341,10 @@ ucs_status_t uct_ib_mlx5_txwq_init(uct_worker_h worker, uct_ib_mlx5_txwq_t *txwq
     uct_ib_mlx5_qp_info_t qp_info;
     ucs_status_t status;
 
+    /* Keep the send hot path on a single cache line */
+    UCS_STATIC_ASSERT(ucs_offsetof(uct_ib_mlx5_txwq_t, db_list) <=
+                      UCS_SYS_CACHE_LINE_SIZE);
+
     status = uct_ib_mlx5_get_qp_info(verbs_qp, &qp_info);
     if (status != UCS_OK) {
         ucs_error("Failed to get mlx5 QP information");
@@ -12,6 +12,8 @@
 #include <uct/ib/base/ib_log.h>
 #include <uct/ib/base/ib_device.h>
 #include <ucs/arch/cpu.h>
+#include <ucs/datastruct/list.h>
+#include <ucs/sys/compiler.h>
 #include <ucs/debug/log.h>
 #include <ucs/type/status.h>
 
@@ -30,6 +32,13 @@
 #define UCT_IB_MLX5_WORKER_BF_KEY    0x00c1b7e8u
 #define UCT_IB_MLX5_EXTENDED_UD_AV   0x80 /* htonl(0x80000000) */
 #define UCT_IB_MLX5_BF_REG_SIZE      256
+#define UCT_IB_MLX5_POLL_CQ_BATCH    16 /* Max CQEs drained in one progress pass */
+
+/* CQE format field, bits [3:2] of op_own. Format 3 marks the title CQE of a
+ * compressed session, which is followed by arrays of 8-byte mini CQEs. */
+#define UCT_IB_MLX5_CQE_FORMAT_MASK  0x0c
+#define UCT_IB_MLX5_CQE_FORMAT_MINI  0x0c
+#define UCT_IB_MLX5_MINICQE_ARR_SIZE 8  /* Mini CQEs per 64-byte CQE slot */
 
 #define UCT_IB_MLX5_OPMOD_EXT_ATOMIC(_log_arg_size) \
     ((8) | ((_log_arg_size) - 2))
@@ -89,7 +98,8 @@ typedef struct uct_ib_mlx5_srq {
 } uct_ib_mlx5_srq_t;
 
 
-/* Completion queue */
+/* Completion queue. The poll state is kept together on one cache line so a
+ * CQ poll does not pull in neighboring structure fields. */
 typedef struct uct_ib_mlx5_cq {
     void               *cq_buf;
     unsigned           cq_ci;
@@ -98,7 +108,7 @@ typedef struct uct_ib_mlx5_cq {
 #if ENABLE_DEBUG_DATA
     unsigned           cq_num;
 #endif
-} uct_ib_mlx5_cq_t;
+} UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE) uct_ib_mlx5_cq_t;
 
 
 /* Blue flame register */
@@ -112,21 +122,33 @@ typedef struct uct_ib_mlx5_bf {
 } uct_ib_mlx5_bf_t;
 
 
-/* Send work-queue */
+/* Send work-queue. Every field a send posting touches is packed into the
+ * first cache line; the doorbell-batching list membership and debug state,
+ * which are accessed only when a batched doorbell is flushed, follow it.
+ * uct_ib_mlx5_txwq_init() pins this split with a static assert. */
 typedef struct uct_ib_mlx5_txwq {
     uint16_t                    sw_pi;      /* PI for next WQE */
     uint16_t                    prev_sw_pi; /* PI where last WQE *started*  */
+    uint16_t                    bb_max;
+    uint16_t                    sig_pi;     /* PI for last signaled WQE */
+    uint16_t                    db_pending; /* BBs posted since the doorbell was
+                                               last rung; 0 - all posted WQEs
+                                               are visible to HW */
     uct_ib_mlx5_bf_t            *bf;
     void                        *curr;
     volatile uint32_t           *dbrec;
     void                        *qstart;
     void                        *qend;
-    uint16_t                    bb_max;
-    uint16_t                    sig_pi;     /* PI for last signaled WQE */
+    void                        *db_ctrl;   /* Ctrl segment of the last WQE
+                                               posted with a postponed doorbell */
+    /* --- cold part --- */
+    ucs_list_link_t             db_list;    /* Membership in the interface list
+                                               of work queues with a postponed
+                                               doorbell; valid iff db_pending > 0 */
 #if ENABLE_ASSERT
     uint16_t                    hw_ci;
 #endif
-} uct_ib_mlx5_txwq_t;
+} UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE) uct_ib_mlx5_txwq_t;
 
 
 /* Receive work-queue */
@@ -176,6 +198,25 @@ typedef struct uct_rc_mlx5_srq_seg {
 } uct_ib_mlx5_srq_seg_t;
 
 
+/**
+ * Mini CQE of a compressed session. The title CQE carries the fields which are
+ * common to the whole session; each mini CQE supplies only the byte count and
+ * (for send completions) the WQE counter. All fields are in network order.
+ */
+typedef struct uct_ib_mlx5_mini_cqe8 {
+    union {
+        uint32_t               rx_hash_result;
+        uint16_t               checksum;
+        struct {
+            uint16_t           wqe_counter;
+            uint8_t            s_wqe_opcode;
+            uint8_t            reserved;
+        } s_wqe_info;
+    };
+    uint32_t                   byte_cnt;
+} UCS_S_PACKED uct_ib_mlx5_mini_cqe8_t;
+
+
 struct uct_ib_mlx5_atomic_masked_cswap32_seg {
     uint32_t           swap;
     uint32_t           compare;
@@ -222,6 +263,13 @@ void uct_ib_mlx5_get_av(struct ibv_ah *ah, struct mlx5_wqe_av *av);
  */
 ucs_status_t uct_ib_mlx5_get_compact_av(uct_ib_iface_t *iface, int *compact_av);
 
+/**
+ * Expand a compressed CQE session in place, rewriting the title CQE and the
+ * mini CQE arrays as ordinary CQEs in their ring slots.
+ */
+void uct_ib_mlx5_cq_expand_minicqes(uct_ib_mlx5_cq_t *cq, unsigned index,
+                                    struct mlx5_cqe64 *title_cqe);
+
 /**
  * Check for completion with error.
  */
@@ -32,6 +32,11 @@ uct_ib_mlx5_poll_cq(uct_ib_iface_t *iface, uct_ib_mlx5_cq_t *cq)
         } else {
             return uct_ib_mlx5_check_completion(iface, cq, cqe);
         }
+    } else if (ucs_unlikely((op_own & UCT_IB_MLX5_CQE_FORMAT_MASK) ==
+                            UCT_IB_MLX5_CQE_FORMAT_MINI)) {
+        /* Title CQE of a compressed session - expand it in place, then return
+         * its slot which now holds the first completion of the session. */
+        uct_ib_mlx5_cq_expand_minicqes(cq, index, cqe);
     }
 
     cq->cq_ci = index + 1;
@@ -39,6 +44,54 @@ uct_ib_mlx5_poll_cq(uct_ib_iface_t *iface, uct_ib_mlx5_cq_t *cq)
 }
 
 
+/*
+ * Drain up to 'max' completions from the CQ in one pass. Ownership bits are
+ * checked ahead for the whole batch and the consumer index is advanced once,
+ * so the cq_ci update is paid per batch rather than per CQE. An error CQE is
+ * handled immediately if it is the first one; otherwise it is left in place,
+ * to be handled on a following call after the valid completions collected
+ * before it are processed.
+ */
+static UCS_F_ALWAYS_INLINE unsigned
+uct_ib_mlx5_poll_cq_batch(uct_ib_iface_t *iface, uct_ib_mlx5_cq_t *cq,
+                          struct mlx5_cqe64 **cqes, unsigned max)
+{
+    struct mlx5_cqe64 *cqe;
+    unsigned index;
+    unsigned count;
+    uint8_t op_own;
+
+    index = cq->cq_ci;
+    for (count = 0; count < max; ++count) {
+        cqe    = uct_ib_mlx5_get_cqe(cq, index);
+        op_own = cqe->op_own;
+
+        if (ucs_unlikely((op_own & MLX5_CQE_OWNER_MASK) == !(index & cq->cq_length))) {
+            break;
+        } else if (ucs_unlikely(op_own & 0x80)) {
+            if ((count == 0) && ((op_own >> 4) != MLX5_CQE_INVALID)) {
+                /* check_completion() updates cq_ci by itself */
+                uct_ib_mlx5_check_completion(iface, cq, cqe);
+                return 0;
+            }
+            break;
+        } else if (ucs_unlikely((op_own & UCT_IB_MLX5_CQE_FORMAT_MASK) ==
+                                UCT_IB_MLX5_CQE_FORMAT_MINI)) {
+            /* Title CQE of a compressed session - expand it in place; the
+             * following ring slots become ordinary CQEs and are collected by
+             * the next loop iterations. */
+            uct_ib_mlx5_cq_expand_minicqes(cq, index, cqe);
+        }
+
+        cqes[count] = cqe;
+        ++index;
+    }
+
+    cq->cq_ci = index;
+    return count;
+}
+
+
 static UCS_F_ALWAYS_INLINE uint16_t
 uct_ib_mlx5_txwq_update_bb(uct_ib_mlx5_txwq_t *wq, uint16_t hw_ci)
 {
@@ -411,6 +464,62 @@ uct_ib_mlx5_post_send(uct_ib_mlx5_txwq_t *wq,
 }
 
 
+/*
+ * Post a WQE to the work queue without ringing the doorbell. The WQE is
+ * counted in db_pending and becomes visible to the device only when
+ * uct_ib_mlx5_txwq_ring_db() is called, which allows a burst of sends to pay
+ * for a single doorbell.
+ */
+static UCS_F_ALWAYS_INLINE uint16_t
+uct_ib_mlx5_post_send_nodb(uct_ib_mlx5_txwq_t *wq,
+                           struct mlx5_wqe_ctrl_seg *ctrl, unsigned wqe_size)
+{
+    uint16_t num_bb;
+
+    ucs_assert(((unsigned long)ctrl % UCT_IB_MLX5_WQE_SEG_SIZE) == 0);
+    num_bb = ucs_div_round_up(wqe_size, MLX5_SEND_WQE_BB);
+    uct_ib_mlx5_txwq_validate(wq, num_bb);
+
+    ucs_compiler_fence();
+
+    /* Advance queue pointer */
+    ucs_assert(ctrl == wq->curr);
+    wq->curr        = uct_ib_mlx5_txwq_wrap_any(wq, (void*)ctrl +
+                                                (num_bb * MLX5_SEND_WQE_BB));
+    wq->prev_sw_pi  = wq->sw_pi;
+    wq->sw_pi      += num_bb;
+    wq->db_ctrl     = ctrl;
+    wq->db_pending += num_bb;
+    return num_bb;
+}
+
+
+/*
+ * Ring the doorbell for all WQEs posted with uct_ib_mlx5_post_send_nodb()
+ * since the last ring. A single 8-byte doorbell write is enough - the device
+ * fetches all WQEs up to the doorbell record from memory, so there is no need
+ * to stream them through the BlueFlame register.
+ */
+static UCS_F_ALWAYS_INLINE void
+uct_ib_mlx5_txwq_ring_db(uct_ib_mlx5_txwq_t *wq)
+{
+    ucs_assert(wq->db_pending > 0);
+
+    ucs_memory_cpu_store_fence();
+
+    /* Write doorbell record */
+    *wq->dbrec = htonl(wq->sw_pi);
+
+    /* Make sure that doorbell record is written before ringing the doorbell */
+    ucs_memory_bus_store_fence();
+
+    *(volatile uint64_t *)wq->bf->reg.ptr = *(volatile uint64_t*)wq->db_ctrl;
+    ucs_memory_bus_store_fence();
+
+    wq->db_pending = 0;
+}
+
+
 static inline uct_ib_mlx5_srq_seg_t *
 uct_ib_mlx5_srq_get_wqe(uct_ib_mlx5_srq_t *srq, uint16_t index)
 {
@@ -22,13 +22,32 @@ typedef struct uct_rc_mlx5_iface_config {
     uct_rc_iface_config_t  super;
     uct_rc_fc_config_t     fc;
     unsigned               tx_max_bb;
+    unsigned               tx_db_batch;
+    int                    tx_inl_adapt;
     /* TODO wc_mode, UAR mode SnB W/A... */
 } uct_rc_mlx5_iface_config_t;
 
 
 
 /**
- * RC remote endpoint
+ * Prepared am_short WQE template. The control, inline and AM header segments
+ * are preformatted once at endpoint creation; per send the template is copied
+ * to the head of the work queue and only the producer index, segment count,
+ * completion flag, inline byte count and AM id/header are patched before the
+ * payload is appended.
+ */
+typedef struct uct_rc_mlx5_wqe_tmpl {
+    struct mlx5_wqe_ctrl_seg       ctrl;
+    struct mlx5_wqe_inl_data_seg   inl;
+    uct_rc_am_short_hdr_t          am;
+} uct_rc_mlx5_wqe_tmpl_t;
+
+
+/**
+ * RC remote endpoint. The send state is placed on its own cache lines, after
+ * the connection and pending-queue state of the base class, so a send posting
+ * does not drag the cold wireup/arbiter lines into the cache and incidental
+ * changes to the base class do not shift the hot fields between builds.
  */
 typedef struct uct_rc_mlx5_ep {
     uct_rc_ep_t      super;
@@ -36,7 +55,18 @@ typedef struct uct_rc_mlx5_ep {
 
     struct {
         uct_ib_mlx5_txwq_t  wq;
-    } tx;
+        uct_rc_mlx5_wqe_tmpl_t am_tmpl;  /* prepared am_short WQE */
+        /* Adaptive inline state. Short sends longer than 'thresh' are posted
+         * as 1-BB gather WQEs from bounce descriptors instead of being
+         * inlined; the cutoff is re-learned every decision window from the
+         * size distribution and send queue occupancy counters below. */
+        struct {
+            uint16_t        thresh;  /* current inline cutoff */
+            uint16_t        count;   /* short sends in the current window */
+            uint16_t        large;   /* ... in the upper half of the short range */
+            uint16_t        full;    /* ... posted with the queue nearly full */
+        } inl;
+    } tx UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE);
 } uct_rc_mlx5_ep_t;
 
 
@@ -48,6 +78,7 @@ typedef struct {
     uct_rc_mlx5_iface_common_t  mlx5_common;
     struct {
         uint16_t           bb_max;     /* limit number of outstanding WQE BBs */
+        int                inl_adapt;  /* adapt the short send inline cutoff */
     } tx;
 } uct_rc_mlx5_iface_t;
 
@@ -79,6 +110,11 @@ ucs_status_t uct_rc_mlx5_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size
 ucs_status_t uct_rc_mlx5_ep_am_short(uct_ep_h tl_ep, uint8_t id, uint64_t header,
                                      const void *payload, unsigned length);
 
+ucs_status_t uct_rc_mlx5_iface_fanout_short(uct_iface_h tl_iface, uct_ep_h *eps,
+                                            unsigned num_eps, uint8_t id,
+                                            uint64_t header, const void *payload,
+                                            unsigned length, unsigned *num_sent_p);
+
 ssize_t uct_rc_mlx5_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id,
                                 uct_pack_callback_t pack_cb, void *arg);
 
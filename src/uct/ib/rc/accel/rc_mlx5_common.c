@@ -27,6 +27,7 @@ unsigned uct_rc_mlx5_iface_srq_post_recv(uct_rc_iface_t *iface, uct_ib_mlx5_srq_
     uct_ib_mlx5_srq_seg_t *seg;
     uct_ib_iface_recv_desc_t *desc;
     uint16_t count, index, next_index;
+    unsigned window;
     uct_rc_hdr_t *hdr;
 
     /* Make sure the union is right */
@@ -37,8 +38,13 @@ unsigned uct_rc_mlx5_iface_srq_post_recv(uct_rc_iface_t *iface, uct_ib_mlx5_srq_
 
     ucs_assert(UCS_CIRCULAR_COMPARE16(srq->ready_idx, <=, srq->free_idx));
 
-    index = srq->ready_idx;
+    window = uct_rc_iface_srq_window(&iface->rx.srq);
+    index  = srq->ready_idx;
     for (;;) {
+        if ((uint16_t)(index - srq->sw_pi) >= window) {
+            break;
+        }
+
         next_index = index + 1;
         seg = uct_ib_mlx5_srq_get_wqe(srq, next_index & srq->mask);
         if (UCS_CIRCULAR_COMPARE16(next_index, >, srq->free_idx)) {
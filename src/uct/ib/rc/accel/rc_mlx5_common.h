@@ -38,6 +38,16 @@
     UCT_RC_CHECK_AM_SHORT(_id, _length, UCT_RC_MLX5_AM_MAX_SHORT(_av_size))
 
 
+/* Adaptive inline decision window: every WINDOW short sends the cutoff is
+ * lowered to half of the short range if at most 1/LARGE_FRAC of them were in
+ * the upper half while at least 1/FULL_FRAC found the send queue short of
+ * building blocks, and restored to the full range otherwise.
+ */
+#define UCT_RC_MLX5_INL_ADAPT_WINDOW       256
+#define UCT_RC_MLX5_INL_ADAPT_LARGE_FRAC   8
+#define UCT_RC_MLX5_INL_ADAPT_FULL_FRAC    4
+
+
 /* there is no need to do a special check for length == 0 because in that
  * case wqe size is valid: inl + raddr + dgram + ctrl fit in 2 WQ BB
  */
@@ -108,36 +118,22 @@ uct_rc_mlx5_iface_common_rx_inline(uct_rc_mlx5_iface_common_t *mlx5_iface,
                                 byte_len);
 }
 
-static UCS_F_ALWAYS_INLINE ucs_status_t
-uct_rc_mlx5_iface_common_poll_rx(uct_rc_mlx5_iface_common_t *mlx5_common_iface,
-                                 uct_rc_iface_t *rc_iface)
+static UCS_F_ALWAYS_INLINE void
+uct_rc_mlx5_iface_common_rx_process(uct_rc_mlx5_iface_common_t *mlx5_common_iface,
+                                    uct_rc_iface_t *rc_iface,
+                                    struct mlx5_cqe64 *cqe)
 {
     uct_ib_mlx5_srq_seg_t *seg;
     uct_ib_iface_recv_desc_t *desc;
     uct_rc_iface_ops_t *rc_ops;
     uct_rc_hdr_t *hdr;
-    struct mlx5_cqe64 *cqe;
     unsigned byte_len;
     unsigned qp_num;
     uint16_t wqe_ctr;
-    uint16_t max_batch;
     ucs_status_t status;
     void *udesc;
     unsigned flags;
 
-    ucs_assert(uct_ib_mlx5_srq_get_wqe(&mlx5_common_iface->rx.srq,
-                                       mlx5_common_iface->rx.srq.mask)->srq.next_wqe_index == 0);
-
-    cqe = uct_ib_mlx5_poll_cq(&rc_iface->super, &mlx5_common_iface->rx.cq);
-    if (cqe == NULL) {
-        /* If not CQE - post receives */
-        status = UCS_ERR_NO_PROGRESS;
-        goto done;
-    }
-
-    ucs_memory_cpu_load_fence();
-    UCS_STATS_UPDATE_COUNTER(rc_iface->stats, UCT_RC_IFACE_STAT_RX_COMPLETION, 1);
-
     byte_len = ntohl(cqe->byte_cnt);
     wqe_ctr  = ntohs(cqe->wqe_counter);
     seg      = uct_ib_mlx5_srq_get_wqe(&mlx5_common_iface->rx.srq, wqe_ctr);
@@ -204,17 +200,119 @@ uct_rc_mlx5_iface_common_poll_rx(uct_rc_mlx5_iface_common_t *mlx5_common_iface,
     }
 
     ++rc_iface->rx.srq.available;
+}
+
+static UCS_F_ALWAYS_INLINE ucs_status_t
+uct_rc_mlx5_iface_common_poll_rx(uct_rc_mlx5_iface_common_t *mlx5_common_iface,
+                                 uct_rc_iface_t *rc_iface)
+{
+    struct mlx5_cqe64 *cqes[UCT_IB_MLX5_POLL_CQ_BATCH];
+    uct_ib_mlx5_srq_seg_t *seg;
+    unsigned count, i;
+    uint16_t max_batch;
+    ucs_status_t status;
+
+    ucs_assert(uct_ib_mlx5_srq_get_wqe(&mlx5_common_iface->rx.srq,
+                                       mlx5_common_iface->rx.srq.mask)->srq.next_wqe_index == 0);
+
+    count = uct_ib_mlx5_poll_cq_batch(&rc_iface->super, &mlx5_common_iface->rx.cq,
+                                      cqes, UCT_IB_MLX5_POLL_CQ_BATCH);
+    if (count == 0) {
+        /* If not CQE - post receives */
+        status = UCS_ERR_NO_PROGRESS;
+        goto done;
+    }
+
+    ucs_memory_cpu_load_fence();
+    UCS_STATS_UPDATE_COUNTER(rc_iface->stats, UCT_RC_IFACE_STAT_RX_COMPLETION, count);
+
+    /* Prefetch the receive descriptors of the whole batch before processing
+     * it, so the AM handlers find the packet headers already in cache. Inline
+     * completions are delivered from the CQE itself, so their rx buffers are
+     * never touched and need no prefetch. */
+    for (i = 0; i < count; ++i) {
+        if (cqes[i]->op_own & (MLX5_INLINE_SCATTER_32|MLX5_INLINE_SCATTER_64)) {
+            continue;
+        }
+        seg = uct_ib_mlx5_srq_get_wqe(&mlx5_common_iface->rx.srq,
+                                      ntohs(cqes[i]->wqe_counter));
+        ucs_prefetch(uct_ib_iface_recv_desc_hdr(&rc_iface->super, seg->srq.desc));
+    }
+
+    for (i = 0; i < count; ++i) {
+        uct_rc_mlx5_iface_common_rx_process(mlx5_common_iface, rc_iface, cqes[i]);
+    }
     status = UCS_OK;
 
 done:
+    uct_rc_iface_srq_adapt(rc_iface, &rc_iface->rx.srq, count);
     max_batch = rc_iface->super.config.rx_max_batch;
-    if (rc_iface->rx.srq.available >= max_batch) {
+    if (uct_rc_iface_srq_window(&rc_iface->rx.srq) >= max_batch) {
         uct_rc_mlx5_iface_srq_post_recv(rc_iface, &mlx5_common_iface->rx.srq);
     }
     return status;
 }
 
 
+/* Ring the postponed doorbell of a work queue, if it has one */
+static UCS_F_ALWAYS_INLINE void
+uct_rc_mlx5_txwq_flush_db(uct_ib_mlx5_txwq_t *txwq)
+{
+    if (txwq->db_pending > 0) {
+        ucs_list_del(&txwq->db_list);
+        uct_ib_mlx5_txwq_ring_db(txwq);
+    }
+}
+
+/* Ring the postponed doorbells of all work queues on the interface */
+static UCS_F_ALWAYS_INLINE void
+uct_rc_mlx5_iface_common_ring_dbs(uct_rc_iface_t *iface)
+{
+    uct_ib_mlx5_txwq_t *txwq, *next;
+
+    ucs_list_for_each_safe(txwq, next, &iface->tx.db_list, db_list) {
+        ucs_list_del(&txwq->db_list);
+        uct_ib_mlx5_txwq_ring_db(txwq);
+    }
+}
+
+/*
+ * Common tail of a WQE post: log the WQE, ring (or postpone) the doorbell
+ * and account the consumed building blocks. The caller must have fully set
+ * up the control segment at txwq->curr.
+ */
+static UCS_F_ALWAYS_INLINE void
+uct_rc_mlx5_common_tx_commit(uct_rc_iface_t *iface, enum ibv_qp_type qp_type,
+                             uct_rc_txqp_t *txqp, uct_ib_mlx5_txwq_t *txwq,
+                             struct mlx5_wqe_ctrl_seg *ctrl, size_t wqe_size,
+                             unsigned sig_flag, uct_log_data_dump_func_t dump_cb)
+{
+    uint16_t posted;
+
+    uct_ib_mlx5_log_tx(&iface->super, qp_type, ctrl, txwq->qstart, txwq->qend,
+                       dump_cb);
+
+    if (ucs_likely(iface->config.tx_db_batch <= 1)) {
+        posted = uct_ib_mlx5_post_send(txwq, ctrl, wqe_size);
+    } else {
+        posted = uct_ib_mlx5_post_send_nodb(txwq, ctrl, wqe_size);
+        if (txwq->db_pending == posted) {
+            /* First postponed WQE on this work queue - track it, so progress
+             * and flush could ring the accumulated doorbell */
+            ucs_list_add_tail(&iface->tx.db_list, &txwq->db_list);
+        }
+        if (txwq->db_pending >= iface->config.tx_db_batch) {
+            ucs_list_del(&txwq->db_list);
+            uct_ib_mlx5_txwq_ring_db(txwq);
+        }
+    }
+    if (sig_flag & MLX5_WQE_CTRL_CQ_UPDATE) {
+        txwq->sig_pi = txwq->sw_pi - posted;
+    }
+
+    uct_rc_txqp_posted(txqp, iface, posted, sig_flag & MLX5_WQE_CTRL_CQ_UPDATE);
+}
+
 static UCS_F_ALWAYS_INLINE void
 uct_rc_mlx5_common_post_send(uct_rc_iface_t *iface, enum ibv_qp_type qp_type,
                              uct_rc_txqp_t *txqp, uct_ib_mlx5_txwq_t *txwq,
@@ -223,7 +321,6 @@ uct_rc_mlx5_common_post_send(uct_rc_iface_t *iface, enum ibv_qp_type qp_type,
                              uint32_t imm)
 {
     struct mlx5_wqe_ctrl_seg *ctrl;
-    uint16_t posted;
 
     ctrl = txwq->curr;
 
@@ -239,16 +336,11 @@ uct_rc_mlx5_common_post_send(uct_rc_iface_t *iface, enum ibv_qp_type qp_type,
         uct_ib_mlx5_set_dgram_seg((void*)(ctrl + 1), av, NULL, qp_type);
     }
 
-    uct_ib_mlx5_log_tx(&iface->super, qp_type, ctrl, txwq->qstart, txwq->qend,
-                       ((opcode == MLX5_OPCODE_SEND) || (opcode == MLX5_OPCODE_SEND_IMM)) ?
-                       uct_rc_ep_am_packet_dump : NULL);
-
-    posted = uct_ib_mlx5_post_send(txwq, ctrl, wqe_size);
-    if (sig_flag & MLX5_WQE_CTRL_CQ_UPDATE) {
-        txwq->sig_pi = txwq->sw_pi - posted;
-    }
-
-    uct_rc_txqp_posted(txqp, iface, posted, sig_flag & MLX5_WQE_CTRL_CQ_UPDATE);
+    uct_rc_mlx5_common_tx_commit(iface, qp_type, txqp, txwq, ctrl, wqe_size,
+                                 sig_flag,
+                                 ((opcode == MLX5_OPCODE_SEND) ||
+                                  (opcode == MLX5_OPCODE_SEND_IMM)) ?
+                                 uct_rc_ep_am_packet_dump : NULL);
 }
 
 
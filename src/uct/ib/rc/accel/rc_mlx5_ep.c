@@ -10,6 +10,7 @@
 #include <ucs/arch/cpu.h>
 #include <ucs/sys/compiler.h>
 #include <arpa/inet.h> /* For htonl */
+#include <string.h>
 
 /*
  *
@@ -226,27 +227,160 @@ ucs_status_t uct_rc_mlx5_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size
     return status;
 }
 
+/*
+ * Learn whether a short send of this size should still be inlined. Inlined
+ * payload enlarges the WQE, so sizes near the short limit consume up to
+ * UCT_IB_MLX5_MAX_BB building blocks per send; when such sizes are rare on
+ * this endpoint and the send queue is congested, a 1-BB gather WQE posted
+ * from a bounce descriptor goes further on the same queue depth. The decision
+ * window counts the sends in the upper half of the short range and the posts
+ * which found the queue short of building blocks, and moves the cutoff at
+ * window boundaries.
+ */
+static UCS_F_ALWAYS_INLINE int
+uct_rc_mlx5_ep_am_short_use_gather(uct_rc_mlx5_iface_t *iface,
+                                   uct_rc_mlx5_ep_t *ep, unsigned length)
+{
+    if (!iface->tx.inl_adapt) {
+        return 0;
+    }
+
+    ++ep->tx.inl.count;
+    ep->tx.inl.large += (length > (UCT_RC_MLX5_AM_MAX_SHORT(0) / 2));
+    ep->tx.inl.full  += (uct_rc_txqp_available(&ep->super.txqp) <
+                         (int16_t)(ep->tx.wq.bb_max / 4));
+
+    if (ucs_unlikely(ep->tx.inl.count >= UCT_RC_MLX5_INL_ADAPT_WINDOW)) {
+        if ((ep->tx.inl.large <= (UCT_RC_MLX5_INL_ADAPT_WINDOW /
+                                  UCT_RC_MLX5_INL_ADAPT_LARGE_FRAC)) &&
+            (ep->tx.inl.full  >= (UCT_RC_MLX5_INL_ADAPT_WINDOW /
+                                  UCT_RC_MLX5_INL_ADAPT_FULL_FRAC)))
+        {
+            ep->tx.inl.thresh = UCT_RC_MLX5_AM_MAX_SHORT(0) / 2;
+        } else {
+            ep->tx.inl.thresh = UCT_RC_MLX5_AM_MAX_SHORT(0);
+        }
+        ep->tx.inl.count = 0;
+        ep->tx.inl.large = 0;
+        ep->tx.inl.full  = 0;
+    }
+
+    return length > ep->tx.inl.thresh;
+}
+
+/*
+ * Post an am_short WQE from the prepared per-ep template: copy the
+ * preformatted control/inline/AM-header segments to the head of the work
+ * queue, patch the fields which vary per send, and append the payload. This
+ * replaces rebuilding the WQE segments from scratch on every send.
+ */
+static UCS_F_ALWAYS_INLINE void
+uct_rc_mlx5_ep_am_short_post(uct_rc_mlx5_iface_t *iface, uct_rc_mlx5_ep_t *ep,
+                             uint8_t id, uint64_t hdr, const void *payload,
+                             unsigned length)
+{
+    uct_rc_mlx5_wqe_tmpl_t *wqe = ep->tx.wq.curr;
+    size_t wqe_size             = sizeof(struct mlx5_wqe_ctrl_seg) +
+                                  sizeof(struct mlx5_wqe_inl_data_seg) +
+                                  sizeof(uct_rc_am_short_hdr_t) + length;
+    unsigned sig_flag;
+
+    sig_flag = uct_rc_iface_tx_moderation(&iface->super, &ep->super.txqp,
+                                          MLX5_WQE_CTRL_CQ_UPDATE);
+
+    *wqe = ep->tx.am_tmpl;
+    wqe->ctrl.opmod_idx_opcode |= htons(ep->tx.wq.sw_pi) << 8;
+    wqe->ctrl.qpn_ds           |= htonl(ucs_div_round_up(wqe_size,
+                                                         UCT_IB_MLX5_WQE_SEG_SIZE));
+    wqe->ctrl.fm_ce_se          = sig_flag;
+    wqe->inl.byte_count         = htonl((sizeof(uct_rc_am_short_hdr_t) + length) |
+                                        MLX5_INLINE_SEG);
+    wqe->am.rc_hdr.am_id        = id;
+    wqe->am.am_hdr              = hdr;
+    uct_ib_mlx5_inline_copy(&wqe->am + 1, payload, length, &ep->tx.wq);
+
+    uct_rc_mlx5_common_tx_commit(&iface->super, IBV_QPT_RC, &ep->super.txqp,
+                                 &ep->tx.wq, &wqe->ctrl, wqe_size, sig_flag,
+                                 uct_rc_ep_am_packet_dump);
+}
+
+/* am_short per-endpoint work, after the id/length validation which is common
+ * to all destinations of a fanout */
+static UCS_F_ALWAYS_INLINE ucs_status_t
+uct_rc_mlx5_ep_am_short_inner(uct_rc_mlx5_iface_t *iface, uct_rc_mlx5_ep_t *ep,
+                              uint8_t id, uint64_t hdr, const void *payload,
+                              unsigned length)
+{
+    uct_rc_iface_send_desc_t *desc;
+    uct_rc_am_short_hdr_t *am;
+
+    UCT_RC_CHECK_RES(&iface->super, &ep->super);
+    UCT_RC_CHECK_FC(&iface->super, &ep->super, id);
+
+    if (ucs_unlikely(uct_rc_mlx5_ep_am_short_use_gather(iface, ep, length))) {
+        /* This size is too rare to justify the extra building blocks - copy
+         * it into a send descriptor and post a small gather WQE instead. */
+        UCT_RC_IFACE_GET_TX_DESC(&iface->super, &iface->super.tx.mp, desc);
+        desc->super.handler = (uct_rc_send_handler_t)ucs_mpool_put;
+        am                  = (uct_rc_am_short_hdr_t*)(desc + 1);
+        am->rc_hdr.am_id    = id;
+        am->am_hdr          = hdr;
+        memcpy(am + 1, payload, length);
+        uct_rc_mlx5_txqp_bcopy_post(&iface->super, &ep->super.txqp, &ep->tx.wq,
+                                    MLX5_OPCODE_SEND|UCT_RC_MLX5_OPCODE_FLAG_RAW,
+                                    sizeof(*am) + length, 0, NULL, 0, 0, 0,
+                                    0, desc);
+        UCS_STATS_UPDATE_COUNTER(ep->super.txqp.stats,
+                                 UCT_RC_TXQP_STAT_GATHER_SHORT, 1);
+    } else {
+        uct_rc_mlx5_ep_am_short_post(iface, ep, id, hdr, payload, length);
+        UCS_STATS_UPDATE_COUNTER(ep->super.txqp.stats,
+                                 UCT_RC_TXQP_STAT_INL_SHORT, 1);
+    }
+    UCT_TL_EP_STAT_OP(&ep->super.super, AM, SHORT, sizeof(hdr) + length);
+    UCT_RC_UPDATE_FC(&iface->super, &ep->super, id);
+    return UCS_OK;
+}
+
 ucs_status_t uct_rc_mlx5_ep_am_short(uct_ep_h tl_ep, uint8_t id, uint64_t hdr,
                                      const void *payload, unsigned length)
 {
-    uct_rc_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_rc_iface_t);
-    uct_rc_mlx5_ep_t *ep  = ucs_derived_of(tl_ep, uct_rc_mlx5_ep_t);
+    uct_rc_mlx5_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_rc_mlx5_iface_t);
+    uct_rc_mlx5_ep_t *ep       = ucs_derived_of(tl_ep, uct_rc_mlx5_ep_t);
 
     UCT_RC_MLX5_CHECK_AM_SHORT(id, length, 0);
+    return uct_rc_mlx5_ep_am_short_inner(iface, ep, id, hdr, payload, length);
+}
 
-    UCT_RC_CHECK_RES(iface, &ep->super);
-    UCT_RC_CHECK_FC(iface, &ep->super, id);
+ucs_status_t uct_rc_mlx5_iface_fanout_short(uct_iface_h tl_iface, uct_ep_h *eps,
+                                            unsigned num_eps, uint8_t id,
+                                            uint64_t hdr, const void *payload,
+                                            unsigned length,
+                                            unsigned *num_sent_p)
+{
+    uct_rc_mlx5_iface_t *iface = ucs_derived_of(tl_iface, uct_rc_mlx5_iface_t);
+    ucs_status_t status;
+    unsigned i;
 
-    uct_rc_mlx5_txqp_inline_post(iface, IBV_QPT_RC,
-                                 &ep->super.txqp, &ep->tx.wq,
-                                 MLX5_OPCODE_SEND,
-                                 payload, length,
-                                 id, hdr, 0,
-                                 0, 0,
-                                 NULL, 0);
-    UCT_TL_EP_STAT_OP(&ep->super.super, AM, SHORT, sizeof(hdr) + length);
-    UCT_RC_UPDATE_FC(iface, &ep->super, id);
-    return UCS_OK;
+    *num_sent_p = 0;
+    UCT_RC_MLX5_CHECK_AM_SHORT(id, length, 0);
+
+    /* The id/length validation above is common to all destinations, so the
+     * loop runs only the per-endpoint checks and the prepared-template post.
+     * With TX_DB_BATCH > 1 the doorbells of the posted QPs are deferred and
+     * rung in one sweep by progress/flush. */
+    status = UCS_OK;
+    for (i = 0; i < num_eps; ++i) {
+        status = uct_rc_mlx5_ep_am_short_inner(iface,
+                                               ucs_derived_of(eps[i], uct_rc_mlx5_ep_t),
+                                               id, hdr, payload, length);
+        if (status != UCS_OK) {
+            break;
+        }
+    }
+
+    *num_sent_p = i;
+    return status;
 }
 
 ssize_t uct_rc_mlx5_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id,
@@ -396,6 +530,9 @@ ucs_status_t uct_rc_mlx5_ep_flush(uct_ep_h tl_ep, unsigned flags,
         sn = ep->tx.wq.sig_pi;
     }
 
+    /* All posted WQEs must be visible to HW before we wait for them */
+    uct_rc_mlx5_txwq_flush_db(&ep->tx.wq);
+
     uct_rc_txqp_add_send_comp(&iface->super, &ep->super.txqp, comp, sn);
     UCT_TL_EP_STAT_FLUSH_WAIT(&ep->super.super);
     return UCS_INPROGRESS;
@@ -429,6 +566,14 @@ UCS_CLASS_INIT_FUNC(uct_rc_mlx5_ep_t, uct_iface_h tl_iface)
 
     UCS_CLASS_CALL_SUPER_INIT(uct_rc_ep_t, &iface->super);
 
+    /* Pin the send hot-line layout: the work queue starts the aligned tx
+     * block, and the WQE template begins right on the following line. */
+    UCS_STATIC_ASSERT((ucs_offsetof(uct_rc_mlx5_ep_t, tx) %
+                       UCS_SYS_CACHE_LINE_SIZE) == 0);
+    UCS_STATIC_ASSERT(ucs_offsetof(uct_rc_mlx5_ep_t, tx.am_tmpl) -
+                      ucs_offsetof(uct_rc_mlx5_ep_t, tx.wq) ==
+                      sizeof(uct_ib_mlx5_txwq_t));
+
     status = uct_ib_mlx5_txwq_init(iface->super.super.super.worker, &self->tx.wq,
                                    self->super.txqp.qp);
     if (status != UCS_OK) {
@@ -436,10 +581,21 @@ UCS_CLASS_INIT_FUNC(uct_rc_mlx5_ep_t, uct_iface_h tl_iface)
         return status;
     }
 
-    self->qp_num       = self->super.txqp.qp->qp_num;
-    self->tx.wq.bb_max = ucs_min(self->tx.wq.bb_max, iface->tx.bb_max);
+    self->qp_num        = self->super.txqp.qp->qp_num;
+    self->tx.wq.bb_max  = ucs_min(self->tx.wq.bb_max, iface->tx.bb_max);
+    self->tx.inl.thresh = UCT_RC_MLX5_AM_MAX_SHORT(0);
+    self->tx.inl.count  = 0;
+    self->tx.inl.large  = 0;
+    self->tx.inl.full   = 0;
     uct_rc_txqp_available_set(&self->super.txqp, self->tx.wq.bb_max);
 
+    /* Preformat the am_short WQE template. The producer index, segment count
+     * and completion flag are OR-ed / stored into it per send, so they must
+     * start out as zero here. */
+    memset(&self->tx.am_tmpl, 0, sizeof(self->tx.am_tmpl));
+    self->tx.am_tmpl.ctrl.opmod_idx_opcode = MLX5_OPCODE_SEND << 24;
+    self->tx.am_tmpl.ctrl.qpn_ds           = htonl(self->qp_num << 8);
+
     uct_worker_progress_register(iface->super.super.super.worker,
                                  uct_rc_mlx5_iface_progress, iface);
     return UCS_OK;
@@ -452,6 +608,14 @@ static UCS_CLASS_CLEANUP_FUNC(uct_rc_mlx5_ep_t)
 
     uct_worker_progress_unregister(iface->super.super.super.worker,
                                    uct_rc_mlx5_iface_progress, iface);
+
+    /* Drop a postponed doorbell, so the interface list does not point to a
+     * destroyed work queue */
+    if (self->tx.wq.db_pending > 0) {
+        ucs_list_del(&self->tx.wq.db_list);
+        self->tx.wq.db_pending = 0;
+    }
+
     uct_ib_mlx5_txwq_cleanup(iface->super.super.super.worker, &self->tx.wq);
 
     /* Modify QP to error to make HW generate CQEs for all in-progress SRQ
@@ -29,6 +29,19 @@ ucs_config_field_t uct_rc_mlx5_iface_config_table[] = {
    "-1 means no limit.",
    ucs_offsetof(uct_rc_mlx5_iface_config_t, tx_max_bb), UCS_CONFIG_TYPE_UINT},
 
+  {"TX_DB_BATCH", "1",
+   "Number of WQE building blocks to accumulate on a QP before ringing its\n"
+   "doorbell. Postponed doorbells are rung when the threshold is reached, and\n"
+   "on flush and progress. 1 - ring the doorbell on every send.",
+   ucs_offsetof(uct_rc_mlx5_iface_config_t, tx_db_batch), UCS_CONFIG_TYPE_UINT},
+
+  {"TX_INLINE_ADAPT", "y",
+   "Adjust the inline cutoff for short sends at runtime, per endpoint, based\n"
+   "on the distribution of sent sizes and on send queue occupancy. Sizes above\n"
+   "the learned cutoff are posted as gather WQEs from bounce buffers instead\n"
+   "of being copied into the WQE.",
+   ucs_offsetof(uct_rc_mlx5_iface_config_t, tx_inl_adapt), UCS_CONFIG_TYPE_BOOL},
+
   {NULL}
 };
 
@@ -37,33 +50,51 @@ static uct_rc_iface_ops_t uct_rc_mlx5_iface_ops;
 static UCS_F_ALWAYS_INLINE void
 uct_rc_mlx5_iface_poll_tx(uct_rc_mlx5_iface_t *iface)
 {
+    struct mlx5_cqe64 *cqes[UCT_IB_MLX5_POLL_CQ_BATCH];
+    uct_rc_mlx5_ep_t *eps[UCT_IB_MLX5_POLL_CQ_BATCH];
     struct mlx5_cqe64 *cqe;
     uct_rc_mlx5_ep_t *ep;
+    unsigned count, i;
     unsigned qp_num;
     uint16_t hw_ci;
 
-    cqe = uct_ib_mlx5_poll_cq(&iface->super.super, &iface->mlx5_common.tx.cq);
-    if (cqe == NULL) {
+    count = uct_ib_mlx5_poll_cq_batch(&iface->super.super, &iface->mlx5_common.tx.cq,
+                                      cqes, UCT_IB_MLX5_POLL_CQ_BATCH);
+    if (count == 0) {
         return;
     }
 
-    UCS_STATS_UPDATE_COUNTER(iface->super.stats, UCT_RC_IFACE_STAT_TX_COMPLETION, 1);
+    UCS_STATS_UPDATE_COUNTER(iface->super.stats, UCT_RC_IFACE_STAT_TX_COMPLETION, count);
 
     ucs_memory_cpu_load_fence();
 
-    qp_num = ntohl(cqe->sop_drop_qpn) & UCS_MASK(UCT_IB_QPN_ORDER);
-    ep = ucs_derived_of(uct_rc_iface_lookup_ep(&iface->super, qp_num), uct_rc_mlx5_ep_t);
-    ucs_assert(ep != NULL);
-    hw_ci = ntohs(cqe->wqe_counter);
-    ucs_trace_poll("rc_mlx5 iface %p tx_cqe: ep %p qpn 0x%x hw_ci %d", iface, ep,
-                   qp_num, hw_ci);
+    /* Resolve the endpoints for the whole batch and prefetch the completed
+     * send operations, so the processing loop below does not stall on them. */
+    for (i = 0; i < count; ++i) {
+        qp_num = ntohl(cqes[i]->sop_drop_qpn) & UCS_MASK(UCT_IB_QPN_ORDER);
+        ep     = ucs_derived_of(uct_rc_iface_lookup_ep(&iface->super, qp_num),
+                                uct_rc_mlx5_ep_t);
+        ucs_assert(ep != NULL);
+        ucs_prefetch(ep->super.txqp.outstanding.head);
+        eps[i] = ep;
+    }
+
+    for (i = 0; i < count; ++i) {
+        cqe   = cqes[i];
+        ep    = eps[i];
+        hw_ci = ntohs(cqe->wqe_counter);
+        ucs_trace_poll("rc_mlx5 iface %p tx_cqe: ep %p qpn 0x%x hw_ci %d", iface,
+                       ep, ntohl(cqe->sop_drop_qpn) & UCS_MASK(UCT_IB_QPN_ORDER),
+                       hw_ci);
 
-    uct_rc_txqp_available_set(&ep->super.txqp, uct_ib_mlx5_txwq_update_bb(&ep->tx.wq, hw_ci));
-    ++iface->super.tx.cq_available;
+        uct_rc_txqp_available_set(&ep->super.txqp, uct_ib_mlx5_txwq_update_bb(&ep->tx.wq, hw_ci));
+        ++iface->super.tx.cq_available;
 
-    uct_rc_mlx5_txqp_process_tx_cqe(&ep->super.txqp, cqe, hw_ci);
+        uct_rc_mlx5_txqp_process_tx_cqe(&ep->super.txqp, cqe, hw_ci);
+
+        uct_rc_ep_schedule_arb_groups(&iface->super.tx.arbiter, &ep->super);
+    }
 
-    ucs_arbiter_group_schedule(&iface->super.tx.arbiter, &ep->super.arb_group);
     ucs_arbiter_dispatch(&iface->super.tx.arbiter, 1, uct_rc_ep_process_pending, NULL);
 }
 
@@ -72,6 +103,8 @@ void uct_rc_mlx5_iface_progress(void *arg)
     uct_rc_mlx5_iface_t *iface = arg;
     ucs_status_t status;
 
+    uct_rc_mlx5_iface_common_ring_dbs(&iface->super);
+
     status = uct_rc_mlx5_iface_common_poll_rx(&iface->mlx5_common, &iface->super);
     if (status == UCS_ERR_NO_PROGRESS) {
         uct_rc_mlx5_iface_poll_tx(iface);
@@ -143,6 +176,10 @@ static UCS_CLASS_INIT_FUNC(uct_rc_mlx5_iface_t, uct_md_h md, uct_worker_h worker
     self->tx.bb_max                  = ucs_min(config->tx_max_bb, UINT16_MAX);
     self->super.config.tx_moderation = ucs_min(self->super.config.tx_moderation,
                                                self->tx.bb_max / 4);
+    self->super.config.tx_db_batch   = ucs_max(1,
+                                               ucs_min(config->tx_db_batch,
+                                                       self->tx.bb_max / 2));
+    self->tx.inl_adapt               = config->tx_inl_adapt;
 
     status = uct_rc_init_fc_thresh(&config->fc, &config->super, &self->super);
     if (status != UCS_OK) {
@@ -197,6 +234,7 @@ static uct_rc_iface_ops_t uct_rc_mlx5_iface_ops = {
     .ep_am_short              = uct_rc_mlx5_ep_am_short,
     .ep_am_bcopy              = uct_rc_mlx5_ep_am_bcopy,
     .ep_am_zcopy              = uct_rc_mlx5_ep_am_zcopy,
+    .iface_fanout_short       = uct_rc_mlx5_iface_fanout_short,
     .ep_atomic_add64          = uct_rc_mlx5_ep_atomic_add64,
     .ep_atomic_fadd64         = uct_rc_mlx5_ep_atomic_fadd64,
     .ep_atomic_swap64         = uct_rc_mlx5_ep_atomic_swap64,
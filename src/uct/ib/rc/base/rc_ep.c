@@ -37,7 +37,9 @@ static ucs_stats_class_t uct_rc_txqp_stats_class = {
     .num_counters = UCT_RC_TXQP_STAT_LAST,
     .counter_names = {
         [UCT_RC_TXQP_STAT_QP_FULL]          = "qp_full",
-        [UCT_RC_TXQP_STAT_SIGNAL]           = "signal"
+        [UCT_RC_TXQP_STAT_SIGNAL]           = "signal",
+        [UCT_RC_TXQP_STAT_INL_SHORT]        = "inl_short",
+        [UCT_RC_TXQP_STAT_GATHER_SHORT]     = "gather_short"
     }
 };
 #endif
@@ -143,6 +145,7 @@ UCS_CLASS_INIT_FUNC(uct_rc_ep_t, uct_rc_iface_t *iface)
     UCS_STATIC_ASSERT(UCT_RC_EP_FC_MASK < UINT8_MAX);
 
     ucs_arbiter_group_init(&self->arb_group);
+    ucs_arbiter_group_init_prio(&self->arb_group_ctrl, UCS_ARBITER_PRIO_CTRL);
 
     uct_rc_iface_add_ep(iface, self, self->txqp.qp->qp_num);
     ucs_list_add_head(&iface->ep_list, &self->list);
@@ -264,23 +267,30 @@ void uct_rc_ep_send_op_completion_handler(uct_rc_iface_send_op_t *op,
     uct_rc_iface_put_send_op(op);
 }
 
-ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                   unsigned flags)
 {
     uct_rc_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_rc_iface_t);
     uct_rc_ep_t *ep = ucs_derived_of(tl_ep, uct_rc_ep_t);
+    ucs_arbiter_group_t *group;
 
     if (uct_rc_ep_has_tx_resources(ep) &&
         uct_rc_iface_has_tx_resources(iface)) {
         return UCS_ERR_BUSY;
     }
 
+    /* Control messages go to a separate group dispatched on the control tier,
+     * so they are not stuck behind queued bulk data of the same ep */
+    group = (flags & UCT_PENDING_FLAG_CTRL) ? &ep->arb_group_ctrl :
+                                              &ep->arb_group;
+
     UCS_STATIC_ASSERT(sizeof(ucs_arbiter_elem_t) <= UCT_PENDING_REQ_PRIV_LEN);
     ucs_arbiter_elem_init((ucs_arbiter_elem_t *)n->priv);
-    ucs_arbiter_group_push_elem(&ep->arb_group, (ucs_arbiter_elem_t*)n->priv);
+    ucs_arbiter_group_push_elem(group, (ucs_arbiter_elem_t*)n->priv);
 
     if (uct_rc_ep_has_tx_resources(ep)) {
         /* If we have ep (but not iface) resources, we need to schedule the ep */
-        ucs_arbiter_group_schedule(&iface->tx.arbiter, &ep->arb_group);
+        ucs_arbiter_group_schedule(&iface->tx.arbiter, group);
     }
 
     return UCS_OK;
@@ -304,7 +314,7 @@ ucs_arbiter_cb_result_t uct_rc_ep_process_pending(ucs_arbiter_t *arbiter,
     } else if (status == UCS_INPROGRESS) {
         return UCS_ARBITER_CB_RESULT_NEXT_GROUP;
     } else {
-        ep = ucs_container_of(ucs_arbiter_elem_group(elem), uct_rc_ep_t, arb_group);
+        ep = uct_rc_ep_from_arb_group(ucs_arbiter_elem_group(elem));
         if (! uct_rc_ep_has_tx_resources(ep)) {
             /* No ep resources */
             return UCS_ARBITER_CB_RESULT_DESCHED_GROUP;
@@ -326,8 +336,7 @@ static ucs_arbiter_cb_result_t uct_rc_ep_abriter_purge_cb(ucs_arbiter_t *arbiter
     uct_purge_cb_args_t  *cb_args   = arg;
     uct_pending_purge_callback_t cb = cb_args->cb;
     uct_pending_req_t *req    = ucs_container_of(elem, uct_pending_req_t, priv);
-    uct_rc_ep_t *ep           = ucs_container_of(ucs_arbiter_elem_group(elem),
-                                                 uct_rc_ep_t, arb_group);
+    uct_rc_ep_t *ep           = uct_rc_ep_from_arb_group(ucs_arbiter_elem_group(elem));
 
     /* Invoke user's callback only if it is not internal FC message */
     if (ucs_likely(req->func != uct_rc_ep_fc_grant)){
@@ -350,6 +359,8 @@ void uct_rc_ep_pending_purge(uct_ep_h tl_ep, uct_pending_purge_callback_t cb,
     uct_rc_ep_t *ep       = ucs_derived_of(tl_ep, uct_rc_ep_t);
     uct_purge_cb_args_t  args = {cb, arg};
 
+    ucs_arbiter_group_purge(&iface->tx.arbiter, &ep->arb_group_ctrl,
+                            uct_rc_ep_abriter_purge_cb, &args);
     ucs_arbiter_group_purge(&iface->tx.arbiter, &ep->arb_group,
                             uct_rc_ep_abriter_purge_cb, &args);
 }
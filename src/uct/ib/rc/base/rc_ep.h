@@ -30,6 +30,8 @@ enum {
 enum {
     UCT_RC_TXQP_STAT_QP_FULL,
     UCT_RC_TXQP_STAT_SIGNAL,
+    UCT_RC_TXQP_STAT_INL_SHORT,
+    UCT_RC_TXQP_STAT_GATHER_SHORT,
     UCT_RC_TXQP_STAT_LAST
 };
 
@@ -177,7 +179,10 @@ struct uct_rc_ep {
     uint8_t             sl;
     uint8_t             path_bits;
     ucs_list_link_t     list;
-    ucs_arbiter_group_t arb_group;
+    ucs_arbiter_group_t arb_group;      /* Data pending requests */
+    ucs_arbiter_group_t arb_group_ctrl; /* Control pending requests - the
+                                           control tier is dispatched ahead of
+                                           queued data */
     uct_rc_fc_t         fc;
 };
 
@@ -210,7 +215,8 @@ void uct_rc_ep_get_bcopy_handler_no_completion(uct_rc_iface_send_op_t *op,
 void uct_rc_ep_send_op_completion_handler(uct_rc_iface_send_op_t *op,
                                              const void *resp);
 
-ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n);
+ucs_status_t uct_rc_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                   unsigned flags);
 
 void uct_rc_ep_pending_purge(uct_ep_h ep, uct_pending_purge_callback_t cb,
                              void*arg);
@@ -219,6 +225,21 @@ ucs_arbiter_cb_result_t uct_rc_ep_process_pending(ucs_arbiter_t *arbiter,
                                                   ucs_arbiter_elem_t *elem,
                                                   void *arg);
 
+/* An ep has two arbiter groups - the priority tier tells them apart */
+static inline uct_rc_ep_t *uct_rc_ep_from_arb_group(ucs_arbiter_group_t *group)
+{
+    return (ucs_arbiter_group_prio(group) == UCS_ARBITER_PRIO_CTRL) ?
+           ucs_container_of(group, uct_rc_ep_t, arb_group_ctrl) :
+           ucs_container_of(group, uct_rc_ep_t, arb_group);
+}
+
+static inline void uct_rc_ep_schedule_arb_groups(ucs_arbiter_t *arbiter,
+                                                 uct_rc_ep_t *ep)
+{
+    ucs_arbiter_group_schedule(arbiter, &ep->arb_group_ctrl);
+    ucs_arbiter_group_schedule(arbiter, &ep->arb_group);
+}
+
 ucs_status_t uct_rc_fc_init(uct_rc_fc_t *fc, int16_t winsize
                             UCS_STATS_ARG(ucs_stats_node_t* stats_parent));
 void uct_rc_fc_cleanup(uct_rc_fc_t *fc);
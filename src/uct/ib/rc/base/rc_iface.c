@@ -25,6 +25,21 @@ ucs_config_field_t uct_rc_iface_config_table[] = {
    "Maximal number of outstanding read or atomic replies",
    ucs_offsetof(uct_rc_iface_config_t, max_rd_atomic), UCS_CONFIG_TYPE_UINT},
 
+  {"SRQ_MIN_POST", "64",
+   "Initial and minimal size of the adaptively sized posted receive window of\n"
+   "the shared receive queue. A new interface posts only this many receives;\n"
+   "the window grows up to RX_QUEUE_LEN on first activity from the progress\n"
+   "loop, and shrinks back toward this value while the interface is idle, so\n"
+   "interfaces which never receive traffic keep only a skeleton of buffers.",
+   ucs_offsetof(uct_rc_iface_config_t, srq_min_post), UCS_CONFIG_TYPE_UINT},
+
+  {"PATH_MIG", "n",
+   "Arm automatic path migration (APM) when connecting QPs: load an alternate\n"
+   "path on the adjacent LID offset and let the HCA migrate to it when the\n"
+   "primary path exceeds its retry budget. Requires LMC > 0 on the subnet for\n"
+   "the offsets to be routed disjointly.",
+   ucs_offsetof(uct_rc_iface_config_t, path_mig), UCS_CONFIG_TYPE_BOOL},
+
   {"TIMEOUT", "1.0s",
    "Transport timeout",
    ucs_offsetof(uct_rc_iface_config_t, tx.timeout), UCS_CONFIG_TYPE_TIME},
@@ -45,6 +60,14 @@ ucs_config_field_t uct_rc_iface_config_table[] = {
    "Length of send completion queue. This limits the total number of outstanding signaled sends.",
    ucs_offsetof(uct_rc_iface_config_t, tx.cq_len), UCS_CONFIG_TYPE_UINT},
 
+  {"TX_EP_QUEUE_LEN", "0",
+   "Length of each endpoint's send queue. 0 - use TX_QUEUE_LEN. The send queue\n"
+   "WQE ring is allocated per QP, so on servers with many mostly-idle\n"
+   "connections a small value caps per-connection memory, while the aggregate\n"
+   "send resources - the send completion queue and the shared descriptor pools,\n"
+   "which grow on demand - remain sized by TX_CQ_LEN.",
+   ucs_offsetof(uct_rc_iface_config_t, tx.ep_queue_len), UCS_CONFIG_TYPE_UINT},
+
   {"FC_ENABLE", "y",
    "Enable flow control protocol to prevent sender from overwhelming the receiver,\n"
    "thus avoiding RC RnR backoff timer.",
@@ -280,7 +303,7 @@ ucs_status_t uct_rc_iface_fc_handler(uct_rc_iface_t *iface, unsigned qp_num,
          * operations if current fc_wnd is <= 0
          * (otherwise it will be dispatched by tx progress) */
         if (cur_wnd <= 0) {
-            ucs_arbiter_group_schedule(&iface->tx.arbiter, &ep->arb_group);
+            uct_rc_ep_schedule_arb_groups(&iface->tx.arbiter, ep);
             ucs_arbiter_dispatch(&iface->tx.arbiter, 1,
                                  uct_rc_ep_process_pending, NULL);
         }
@@ -314,7 +337,8 @@ ucs_status_t uct_rc_iface_fc_handler(uct_rc_iface_t *iface, unsigned qp_num,
         status = uct_rc_ep_fc_grant(&fc_req->super);
 
         if (status == UCS_ERR_NO_RESOURCE){
-            status = uct_ep_pending_add(&ep->super.super, &fc_req->super);
+            status = uct_ep_pending_add(&ep->super.super, &fc_req->super,
+                                        UCT_PENDING_FLAG_CTRL);
         }
         ucs_assertv_always(status == UCS_OK, "Failed to send FC grant msg: %s",
                            ucs_status_string(status));
@@ -382,11 +406,15 @@ UCS_CLASS_INIT_FUNC(uct_rc_iface_t, uct_rc_iface_ops_t *ops, uct_md_h md,
 
     self->tx.cq_available           = tx_cq_len - 1; /* Reserve one for error */
     self->rx.srq.available          = 0;
-    self->config.tx_qp_len          = config->super.tx.queue_len;
+    uct_rc_iface_srq_window_init(&self->rx.srq, 0, 0);
+    self->config.tx_qp_len          = (config->tx.ep_queue_len != 0) ?
+                                      config->tx.ep_queue_len :
+                                      config->super.tx.queue_len;
+    self->config.srq_min_post       = config->srq_min_post;
     self->config.tx_min_sge         = config->super.tx.min_sge;
     self->config.tx_min_inline      = config->super.tx.min_inline;
     self->config.tx_moderation      = ucs_min(config->super.tx.cq_moderation,
-                                              config->super.tx.queue_len / 4);
+                                              self->config.tx_qp_len / 4);
     self->config.tx_ops_count       = tx_cq_len;
     self->config.rx_inline          = config->super.rx.inl;
     self->config.min_rnr_timer      = uct_ib_to_fabric_time(config->tx.rnr_timeout);
@@ -396,12 +424,17 @@ UCS_CLASS_INIT_FUNC(uct_rc_iface_t, uct_rc_iface_ops_t *ops, uct_md_h md,
     self->config.retry_cnt          = ucs_min(config->tx.retry_count,
                                               UCR_RC_QP_MAX_RETRY_COUNT);
     self->config.max_rd_atomic      = config->max_rd_atomic;
+    self->config.path_mig           = config->path_mig;
 
     uct_rc_iface_set_path_mtu(self, config);
     memset(self->eps, 0, sizeof(self->eps));
     ucs_arbiter_init(&self->tx.arbiter);
+    ucs_list_head_init(&self->tx.db_list);
     ucs_list_head_init(&self->ep_list);
 
+    /* Doorbell batching is off unless the transport enables it explicitly */
+    self->config.tx_db_batch        = 1;
+
     /* Check FC parameters correctness */
     if ((config->fc.hard_thresh <= 0) || (config->fc.hard_thresh >= 1)) {
         ucs_error("The factor for hard FC threshold should be > 0 and < 1 (%f)",
@@ -450,6 +483,8 @@ UCS_CLASS_INIT_FUNC(uct_rc_iface_t, uct_rc_iface_ops_t *ops, uct_md_h md,
             goto err_free_tx_ops;
         }
         self->rx.srq.available       = srq_init_attr.attr.max_wr;
+        uct_rc_iface_srq_window_init(&self->rx.srq, srq_init_attr.attr.max_wr,
+                                     self->config.srq_min_post);
     } else {
         self->rx.srq.srq             = NULL;
     }
@@ -668,6 +703,8 @@ ucs_status_t uct_rc_iface_qp_connect(uct_rc_iface_t *iface, struct ibv_qp *qp,
                                      struct ibv_ah_attr *ah_attr)
 {
     struct ibv_qp_attr qp_attr;
+    int qp_attr_mask;
+    int path_mig_armed = 0;
     int ret;
 
     memset(&qp_attr, 0, sizeof(qp_attr));
@@ -679,15 +716,30 @@ ucs_status_t uct_rc_iface_qp_connect(uct_rc_iface_t *iface, struct ibv_qp *qp,
     qp_attr.max_dest_rd_atomic    = iface->config.max_rd_atomic;
     qp_attr.min_rnr_timer         = iface->config.min_rnr_timer;
     qp_attr.ah_attr               = *ah_attr;
-
-    ret = ibv_modify_qp(qp, &qp_attr,
-                        IBV_QP_STATE              |
-                        IBV_QP_AV                 |
-                        IBV_QP_PATH_MTU           |
-                        IBV_QP_DEST_QPN           |
-                        IBV_QP_RQ_PSN             |
-                        IBV_QP_MAX_DEST_RD_ATOMIC |
-                        IBV_QP_MIN_RNR_TIMER);
+    qp_attr_mask                  = IBV_QP_STATE              |
+                                    IBV_QP_AV                 |
+                                    IBV_QP_PATH_MTU           |
+                                    IBV_QP_DEST_QPN           |
+                                    IBV_QP_RQ_PSN             |
+                                    IBV_QP_MAX_DEST_RD_ATOMIC |
+                                    IBV_QP_MIN_RNR_TIMER;
+
+    if (iface->config.path_mig &&
+        (uct_ib_iface_port_attr(&iface->super)->lmc > 0)) {
+        /* Load an alternate path on the adjacent LID offset, so the HCA can
+         * migrate to it when the primary path exceeds its retry budget. The
+         * subnet manager routes the offsets disjointly when LMC > 0. */
+        qp_attr.alt_ah_attr                = *ah_attr;
+        qp_attr.alt_ah_attr.dlid          ^= 1;
+        qp_attr.alt_ah_attr.src_path_bits ^= 1;
+        qp_attr.alt_pkey_index             = iface->super.pkey_index;
+        qp_attr.alt_port_num               = iface->super.config.port_num;
+        qp_attr.alt_timeout                = iface->config.timeout;
+        qp_attr_mask                      |= IBV_QP_ALT_PATH;
+        path_mig_armed                     = 1;
+    }
+
+    ret = ibv_modify_qp(qp, &qp_attr, qp_attr_mask);
     if (ret) {
         ucs_error("error modifying QP to RTR: %m");
         return UCS_ERR_IO_ERROR;
@@ -699,25 +751,33 @@ ucs_status_t uct_rc_iface_qp_connect(uct_rc_iface_t *iface, struct ibv_qp *qp,
     qp_attr.rnr_retry             = iface->config.rnr_retry;
     qp_attr.retry_cnt             = iface->config.retry_cnt;
     qp_attr.max_rd_atomic         = iface->config.max_rd_atomic;
-    ret = ibv_modify_qp(qp, &qp_attr,
-                        IBV_QP_STATE              |
-                        IBV_QP_TIMEOUT            |
-                        IBV_QP_RETRY_CNT          |
-                        IBV_QP_RNR_RETRY          |
-                        IBV_QP_SQ_PSN             |
-                        IBV_QP_MAX_QP_RD_ATOMIC);
+    qp_attr_mask                  = IBV_QP_STATE              |
+                                    IBV_QP_TIMEOUT            |
+                                    IBV_QP_RETRY_CNT          |
+                                    IBV_QP_RNR_RETRY          |
+                                    IBV_QP_SQ_PSN             |
+                                    IBV_QP_MAX_QP_RD_ATOMIC;
+
+    if (path_mig_armed) {
+        /* Rearm APM, so the HCA migrates to the loaded alternate path on its
+         * own and raises IBV_EVENT_PATH_MIG instead of a transport error */
+        qp_attr.path_mig_state    = IBV_MIG_REARM;
+        qp_attr_mask             |= IBV_QP_PATH_MIG_STATE;
+    }
+
+    ret = ibv_modify_qp(qp, &qp_attr, qp_attr_mask);
     if (ret) {
         ucs_error("error modifying QP to RTS: %m");
         return UCS_ERR_IO_ERROR;
     }
 
     ucs_debug("connected rc qp 0x%x on "UCT_IB_IFACE_FMT" to lid %d(+%d) sl %d "
-              "remote_qp 0x%x mtu %zu timer %dx%d rnr %dx%d rd_atom %d",
+              "remote_qp 0x%x mtu %zu timer %dx%d rnr %dx%d rd_atom %d apm %d",
               qp->qp_num, UCT_IB_IFACE_ARG(&iface->super), ah_attr->dlid,
               ah_attr->src_path_bits, ah_attr->sl, qp_attr.dest_qp_num,
               uct_ib_mtu_value(qp_attr.path_mtu), qp_attr.timeout,
               qp_attr.retry_cnt, qp_attr.min_rnr_timer, qp_attr.rnr_retry,
-              qp_attr.max_rd_atomic);
+              qp_attr.max_rd_atomic, path_mig_armed);
 
     return UCS_OK;
 }
@@ -23,6 +23,10 @@
 #define UCT_RC_MAX_ATOMIC_SIZE      sizeof(uint64_t)
 #define UCR_RC_QP_MAX_RETRY_COUNT   7
 
+/* Number of consecutive empty polls after which the posted receive window of
+ * the SRQ is shrunk toward UCX_RC_SRQ_MIN_POST */
+#define UCT_RC_IFACE_SRQ_IDLE_THRESH 16384
+
 #define UCT_RC_CHECK_AM_SHORT(_am_id, _length, _max_inline) \
      UCT_CHECK_AM_ID(_am_id); \
      UCT_CHECK_LENGTH(sizeof(uct_rc_am_short_hdr_t) + _length, 0, _max_inline, "am_short");
@@ -128,6 +132,8 @@ struct uct_rc_iface_config {
     uct_ib_iface_config_t    super;
     uct_ib_mtu_t             path_mtu;
     unsigned                 max_rd_atomic;
+    unsigned                 srq_min_post;
+    int                      path_mig;
 
     struct {
         double               timeout;
@@ -135,6 +141,7 @@ struct uct_rc_iface_config {
         double               rnr_timeout;
         unsigned             rnr_retry_count;
         unsigned             cq_len;
+        unsigned             ep_queue_len;
     } tx;
 
     struct {
@@ -159,6 +166,15 @@ typedef struct uct_rc_iface_ops {
 typedef struct uct_rc_srq {
     struct ibv_srq           *srq;
     unsigned                 available;
+    unsigned                 depth;        /* Total number of receives the SRQ
+                                              can hold */
+    unsigned                 posted_limit; /* Adaptive bound on the number of
+                                              posted receives. Grows when polls
+                                              drain full batches, shrinks after
+                                              long idle periods to cap receive
+                                              buffer memory. */
+    unsigned                 idle_count;   /* Consecutive polls which found no
+                                              completion */
 } uct_rc_srq_t;
 
 
@@ -172,6 +188,8 @@ struct uct_rc_iface {
         uct_rc_iface_send_op_t  *free_ops; /* stack of free send operations */
         ucs_arbiter_t           arbiter;
         uct_rc_iface_send_op_t  *ops_buffer;
+        ucs_list_link_t         db_list; /* mlx5 work queues with a postponed
+                                            doorbell, rung on progress/flush */
     } tx;
 
     struct {
@@ -187,6 +205,10 @@ struct uct_rc_iface {
         unsigned             rx_inline;
         uint16_t             tx_moderation;
 
+        /* Number of WQE building blocks to accumulate on a work queue before
+         * ringing its doorbell. 1 - ring on every post (mlx5 only). */
+        uint16_t             tx_db_batch;
+
         /* Threshold to send "soft" FC credit request. The peer will try to
          * piggy-back credits grant to the counter AM, if any. */
         int16_t              fc_soft_thresh;
@@ -198,11 +220,15 @@ struct uct_rc_iface {
         uint16_t             fc_wnd_size;
         uint8_t              fc_enabled;
 
+        /* Lower bound on the adaptive posted receive window of the SRQ */
+        unsigned             srq_min_post;
+
         uint8_t              min_rnr_timer;
         uint8_t              timeout;
         uint8_t              rnr_retry;
         uint8_t              retry_cnt;
         uint8_t              max_rd_atomic;
+        uint8_t              path_mig;
         enum ibv_mtu         path_mtu;
 
         /* Atomic callbacks */
@@ -311,6 +337,65 @@ static inline uct_rc_ep_t *uct_rc_iface_lookup_ep(uct_rc_iface_t *iface,
                      [qp_num &  UCS_MASK(UCT_RC_QP_TABLE_MEMB_ORDER)];
 }
 
+/*
+ * The window starts at min_post and grows toward the full depth on first
+ * activity, so interfaces which never receive traffic - because wireup chose
+ * other lanes - keep only a skeleton of posted receives. Pass the full depth
+ * as min_post for queues which have no adaptive poll path.
+ */
+static inline void uct_rc_iface_srq_window_init(uct_rc_srq_t *srq, unsigned depth,
+                                                unsigned min_post)
+{
+    srq->depth        = depth;
+    srq->posted_limit = ucs_min(depth, min_post);
+    srq->idle_count   = 0;
+}
+
+/**
+ * @return How many receives may be posted to the SRQ without exceeding its
+ *         adaptive window.
+ */
+static UCS_F_ALWAYS_INLINE unsigned uct_rc_iface_srq_window(uct_rc_srq_t *srq)
+{
+    unsigned reserved = srq->depth - srq->posted_limit;
+
+    /* right after the window shrinks, more receives than the new limit may
+     * still be posted */
+    return (srq->available > reserved) ? (srq->available - reserved) : 0;
+}
+
+/**
+ * Adapt the posted receive window of the SRQ to the observed completion rate:
+ * a poll which drains a full batch indicates bursty traffic and grows the
+ * window, while a long run of empty polls shrinks it toward SRQ_MIN_POST, so
+ * mostly-idle interfaces do not pin a full RX_QUEUE_LEN worth of receive
+ * buffers.
+ */
+static UCS_F_ALWAYS_INLINE void
+uct_rc_iface_srq_adapt(uct_rc_iface_t *iface, uct_rc_srq_t *srq,
+                       unsigned num_comps)
+{
+    if (num_comps > 0) {
+        srq->idle_count = 0;
+        if ((num_comps >= iface->super.config.rx_max_batch) &&
+            (srq->posted_limit < srq->depth)) {
+            /* A fully drained batch means the sender is running ahead of the
+             * posted window - open it exponentially, so an interface starting
+             * from the skeleton posting reaches full depth within a few
+             * progress calls */
+            srq->posted_limit = ucs_min(ucs_max(srq->posted_limit * 2,
+                                                srq->posted_limit +
+                                                iface->super.config.rx_max_batch),
+                                        srq->depth);
+        }
+    } else if (ucs_unlikely(++srq->idle_count >= UCT_RC_IFACE_SRQ_IDLE_THRESH)) {
+        srq->idle_count   = 0;
+        srq->posted_limit = ucs_max(srq->posted_limit / 2,
+                                    ucs_min(iface->config.srq_min_post,
+                                            srq->depth));
+    }
+}
+
 
 static UCS_F_ALWAYS_INLINE int
 uct_rc_iface_have_tx_cqe_avail(uct_rc_iface_t* iface)
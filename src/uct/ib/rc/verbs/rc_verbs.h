@@ -10,10 +10,16 @@
 #include <uct/ib/rc/base/rc_iface.h>
 #include <uct/ib/rc/base/rc_ep.h>
 #include <ucs/type/class.h>
+#include <ucs/datastruct/list.h>
 #include <ucs/datastruct/ptr_array.h>
 
 #include "rc_verbs_common.h"
 
+
+/* Maximal number of work requests which may be accumulated on an endpoint
+ * before being submitted as a single chained ibv_post_send() call */
+#define UCT_RC_VERBS_TX_CHAIN_MAX  16
+
 #if HAVE_IBV_EX_HW_TM
 typedef struct uct_rc_verbs_release_desc {
     uct_recv_desc_t             super;
@@ -27,6 +33,16 @@ typedef struct uct_rc_verbs_release_desc {
 typedef struct uct_rc_verbs_ep {
     uct_rc_ep_t            super;
     uct_rc_verbs_txcnt_t   txcnt;
+
+    /* Chain of fully accounted but not yet submitted work requests. The
+     * descriptors are already on the txqp outstanding queue; only the
+     * ibv_post_send() call is deferred. */
+    struct {
+        struct ibv_send_wr wrs[UCT_RC_VERBS_TX_CHAIN_MAX];
+        struct ibv_sge     sges[UCT_RC_VERBS_TX_CHAIN_MAX];
+        unsigned           count;
+        ucs_list_link_t    list;    /* entry in iface chained_eps */
+    } chain;
 #if HAVE_IBV_EX_HW_TM
     struct ibv_qp          *tm_qp;
 #endif
@@ -40,6 +56,7 @@ typedef struct uct_rc_verbs_iface_config {
     uct_rc_iface_config_t              super;
     uct_rc_verbs_iface_common_config_t verbs_common;
     uct_rc_fc_config_t                 fc;
+    unsigned                           tx_chain;
 #if HAVE_IBV_EX_HW_TM
     struct {
         int                            enable;
@@ -81,14 +98,35 @@ typedef struct uct_rc_verbs_iface {
         uct_rc_verbs_release_desc_t  rndv_desc;
     } tm;
 #endif
+    ucs_list_link_t             chained_eps; /* endpoints with a pending WR chain */
+
     struct {
         unsigned                tx_max_wr;
+        unsigned                tx_chain;
     } config;
 
     void (*progress)(void*); /* Progress function (either regular or TM aware) */
 } uct_rc_verbs_iface_t;
 
 
+void uct_rc_verbs_ep_post_chain(uct_rc_verbs_iface_t *iface,
+                                uct_rc_verbs_ep_t *ep);
+
+
+/* Submit the pending work request chains of all endpoints on the interface.
+ * Called on every progress invocation so that chained sends never wait for
+ * more than one progress round. */
+static UCS_F_ALWAYS_INLINE void
+uct_rc_verbs_iface_post_chains(uct_rc_verbs_iface_t *iface)
+{
+    while (!ucs_list_is_empty(&iface->chained_eps)) {
+        uct_rc_verbs_ep_post_chain(iface,
+                                   ucs_list_head(&iface->chained_eps,
+                                                 uct_rc_verbs_ep_t, chain.list));
+    }
+}
+
+
 #define UCT_RC_VERBS_CHECK_AM_SHORT(_iface, _id, _length, _max_inline) \
      UCT_CHECK_AM_ID(_id); \
      UCT_CHECK_LENGTH(sizeof(uct_rc_am_short_hdr_t) + _length + \
@@ -87,7 +87,7 @@ unsigned uct_rc_verbs_iface_post_recv_always(uct_rc_iface_t *iface,
 ucs_status_t uct_rc_verbs_iface_prepost_recvs_common(uct_rc_iface_t *iface,
                                                      uct_rc_srq_t *srq)
 {
-    while (srq->available > 0) {
+    while (uct_rc_iface_srq_window(srq) > 0) {
         if (uct_rc_verbs_iface_post_recv_common(iface, srq, 1) == 0) {
             ucs_error("failed to post receives");
             return UCS_ERR_NO_MEMORY;
@@ -85,14 +85,15 @@ static inline unsigned uct_rc_verbs_iface_post_recv_common(uct_rc_iface_t *iface
                                                            uct_rc_srq_t *srq,
                                                            int fill)
 {
-    unsigned batch = iface->super.config.rx_max_batch;
+    unsigned batch  = iface->super.config.rx_max_batch;
+    unsigned window = uct_rc_iface_srq_window(srq);
     unsigned count;
 
-    if (srq->available < batch) {
-        if (ucs_likely(fill == 0)) {
+    if (window < batch) {
+        if (ucs_likely(fill == 0) || (window == 0)) {
             return 0;
         } else {
-            count = srq->available;
+            count = window;
         }
     } else {
         count = batch;
@@ -153,6 +154,7 @@ uct_rc_verbs_iface_poll_rx_common(uct_rc_iface_t *iface)
 
     status = uct_ib_poll_cq(iface->super.recv_cq, &num_wcs, wc);
     if (status != UCS_OK) {
+        num_wcs = 0;
         goto out;
     }
 
@@ -166,6 +168,7 @@ uct_rc_verbs_iface_poll_rx_common(uct_rc_iface_t *iface)
     UCS_STATS_UPDATE_COUNTER(iface->stats, UCT_RC_IFACE_STAT_RX_COMPLETION, num_wcs);
 
 out:
+    uct_rc_iface_srq_adapt(iface, &iface->rx.srq, num_wcs);
     uct_rc_verbs_iface_post_recv_common(iface, &iface->rx.srq, 0);
     return status;
 }
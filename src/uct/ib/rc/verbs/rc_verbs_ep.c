@@ -10,6 +10,27 @@
 #include <ucs/arch/bitops.h>
 #include <uct/ib/base/ib_log.h>
 
+/*
+ * Submit the endpoint's pending work request chain with a single
+ * ibv_post_send() call. All txqp accounting was already done when the work
+ * requests were staged, so only the verbs library call remains.
+ */
+void uct_rc_verbs_ep_post_chain(uct_rc_verbs_iface_t *iface, uct_rc_verbs_ep_t *ep)
+{
+    struct ibv_send_wr *bad_wr;
+    int ret;
+
+    ucs_assert(ep->chain.count > 0);
+
+    ret = ibv_post_send(ep->super.txqp.qp, &ep->chain.wrs[0], &bad_wr);
+    if (ret != 0) {
+        ucs_fatal("ibv_post_send() returned %d (%m)", ret);
+    }
+
+    ep->chain.count = 0;
+    ucs_list_del(&ep->chain.list);
+}
+
 static UCS_F_ALWAYS_INLINE void
 uct_rc_verbs_ep_post_send(uct_rc_verbs_iface_t* iface, uct_rc_verbs_ep_t* ep,
                           struct ibv_send_wr *wr, int send_flags)
@@ -17,6 +38,12 @@ uct_rc_verbs_ep_post_send(uct_rc_verbs_iface_t* iface, uct_rc_verbs_ep_t* ep,
     struct ibv_send_wr *bad_wr;
     int ret;
 
+    /* Submit chained work requests first to keep wire order equal to the
+     * order in which the txqp accounting was done */
+    if (ucs_unlikely(ep->chain.count > 0)) {
+        uct_rc_verbs_ep_post_chain(iface, ep);
+    }
+
     uct_rc_txqp_check(&ep->super.txqp);
 
     if (!(send_flags & IBV_SEND_SIGNALED)) {
@@ -44,6 +71,11 @@ uct_rc_verbs_exp_post_send(uct_rc_verbs_ep_t *ep, struct ibv_exp_send_wr *wr,
 {
     uct_rc_verbs_iface_t *iface = ucs_derived_of(ep->super.super.super.iface,
                                                  uct_rc_verbs_iface_t);
+
+    if (ucs_unlikely(ep->chain.count > 0)) {
+        uct_rc_verbs_ep_post_chain(iface, ep);
+    }
+
     uct_rc_txqp_check(&ep->super.txqp);
 
     struct ibv_exp_send_wr *bad_wr;
@@ -67,6 +99,60 @@ uct_rc_verbs_exp_post_send(uct_rc_verbs_ep_t *ep, struct ibv_exp_send_wr *wr,
 }
 #endif
 
+/*
+ * Stage an unsignaled single-SGE descriptor send on the endpoint's work
+ * request chain instead of submitting it right away. All txqp accounting
+ * (moderation, wr_id, outstanding descriptor tracking) is done here in
+ * staging order; since every other submission path posts the pending chain
+ * first, staging order is also wire order and only the ibv_post_send() call
+ * itself is deferred. The chain is submitted when it reaches the configured
+ * length, when any other operation hits the QP, or on interface progress.
+ *
+ * @return Whether the work request was queued on the chain.
+ */
+static UCS_F_ALWAYS_INLINE int
+uct_rc_verbs_ep_chain_send_desc(uct_rc_verbs_iface_t *iface, uct_rc_verbs_ep_t *ep,
+                                struct ibv_send_wr *wr, uct_rc_iface_send_desc_t *desc)
+{
+    struct ibv_send_wr *cwr;
+    int send_flags;
+
+    if ((iface->config.tx_chain <= 1) || (wr->num_sge != 1)) {
+        return 0;
+    }
+
+    uct_rc_txqp_check(&ep->super.txqp);
+
+    cwr                             = &ep->chain.wrs[ep->chain.count];
+    *cwr                            = *wr;
+    ep->chain.sges[ep->chain.count] = wr->sg_list[0];
+    cwr->sg_list                    = &ep->chain.sges[ep->chain.count];
+    cwr->next                       = NULL;
+
+    send_flags      = uct_rc_iface_tx_moderation(&iface->super, &ep->super.txqp,
+                                                 IBV_SEND_SIGNALED);
+    cwr->send_flags = send_flags;
+    cwr->wr_id      = uct_rc_txqp_unsignaled(&ep->super.txqp);
+
+    uct_ib_log_post_send(&iface->super.super, ep->super.txqp.qp, cwr,
+                         (cwr->opcode == IBV_WR_SEND) ? uct_rc_verbs_ep_am_packet_dump : NULL);
+
+    uct_rc_verbs_txqp_posted(&ep->super.txqp, &ep->txcnt, &iface->super,
+                             send_flags & IBV_SEND_SIGNALED);
+    uct_rc_txqp_add_send_op_sn(&ep->super.txqp, &desc->super, ep->txcnt.pi);
+
+    if (ep->chain.count == 0) {
+        ucs_list_add_tail(&iface->chained_eps, &ep->chain.list);
+    } else {
+        ep->chain.wrs[ep->chain.count - 1].next = cwr;
+    }
+
+    if (++ep->chain.count >= iface->config.tx_chain) {
+        uct_rc_verbs_ep_post_chain(iface, ep);
+    }
+    return 1;
+}
+
 /*
  * Helper function for posting sends with a descriptor.
  * User needs to fill: wr.opcode, wr.sg_list, wr.num_sge, first sge length, and
@@ -79,6 +165,10 @@ uct_rc_verbs_ep_post_send_desc(uct_rc_verbs_ep_t* ep, struct ibv_send_wr *wr,
     uct_rc_verbs_iface_t *iface = ucs_derived_of(ep->super.super.super.iface,
                                                  uct_rc_verbs_iface_t);
     UCT_RC_VERBS_FILL_DESC_WR(wr, desc);
+    if ((send_flags == 0) &&
+        uct_rc_verbs_ep_chain_send_desc(iface, ep, wr, desc)) {
+        return;
+    }
     uct_rc_verbs_ep_post_send(iface, ep, wr, send_flags);
     uct_rc_txqp_add_send_op_sn(&ep->super.txqp, &desc->super, ep->txcnt.pi);
 }
@@ -496,6 +586,12 @@ ucs_status_t uct_rc_verbs_ep_flush(uct_ep_h tl_ep, unsigned flags,
     uct_rc_verbs_ep_t *ep = ucs_derived_of(tl_ep, uct_rc_verbs_ep_t);
     ucs_status_t status;
 
+    /* Flush completes only after everything already accounted for is on the
+     * wire, so the pending chain must be submitted first */
+    if (ucs_unlikely(ep->chain.count > 0)) {
+        uct_rc_verbs_ep_post_chain(iface, ep);
+    }
+
     status = uct_rc_ep_flush(&ep->super, iface->config.tx_max_wr);
     if (status != UCS_INPROGRESS) {
         return status;
@@ -829,6 +925,7 @@ UCS_CLASS_INIT_FUNC(uct_rc_verbs_ep_t, uct_iface_h tl_iface)
 
     uct_rc_txqp_available_set(&self->super.txqp, iface->config.tx_max_wr);
     uct_rc_verbs_txcnt_init(&self->txcnt);
+    self->chain.count = 0;
 
     uct_worker_progress_register(iface->super.super.super.worker,
                                  iface->progress, iface);
@@ -842,6 +939,12 @@ static UCS_CLASS_CLEANUP_FUNC(uct_rc_verbs_ep_t)
                                                  uct_rc_verbs_iface_t);
     uct_worker_progress_unregister(iface->super.super.super.worker,
                                    iface->progress, iface);
+    if (self->chain.count > 0) {
+        /* Drop never-submitted work requests; their descriptors are released
+         * by the txqp outstanding queue purge */
+        ucs_list_del(&self->chain.list);
+        self->chain.count = 0;
+    }
     uct_rc_verbs_ep_tag_qp_destroy(self);
 }
 
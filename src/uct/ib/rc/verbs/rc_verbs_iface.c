@@ -32,6 +32,14 @@ static ucs_config_field_t uct_rc_verbs_iface_config_table[] = {
    ucs_offsetof(uct_rc_verbs_iface_config_t, fc),
    UCS_CONFIG_TYPE_TABLE(uct_rc_fc_config_table)},
 
+  {"TX_CHAIN", "8",
+   "Number of send work requests to accumulate per endpoint before submitting\n"
+   "them to the device in a single chained ibv_post_send() call. Only unsignaled\n"
+   "single-SGE sends (e.g bcopy active messages) are chained; any other operation\n"
+   "on the QP, flush, or interface progress submits the pending chain first.\n"
+   "Setting this to 0 or 1 disables chaining.",
+   ucs_offsetof(uct_rc_verbs_iface_config_t, tx_chain), UCS_CONFIG_TYPE_UINT},
+
 #if HAVE_IBV_EX_HW_TM
   {"TM_ENABLE", "y",
    "Enable HW tag matching",
@@ -115,7 +123,7 @@ uct_rc_verbs_iface_poll_tx(uct_rc_verbs_iface_t *iface)
         uct_rc_verbs_txqp_completed(&ep->super.txqp, &ep->txcnt, count);
 
         uct_rc_txqp_completion_desc(&ep->super.txqp, ep->txcnt.ci);
-        ucs_arbiter_group_schedule(&iface->super.tx.arbiter, &ep->super.arb_group);
+        uct_rc_ep_schedule_arb_groups(&iface->super.tx.arbiter, &ep->super);
     }
     iface->super.tx.cq_available += num_wcs;
     ucs_arbiter_dispatch(&iface->super.tx.arbiter, 1, uct_rc_ep_process_pending, NULL);
@@ -126,6 +134,8 @@ void uct_rc_verbs_iface_progress(void *arg)
     uct_rc_verbs_iface_t *iface = arg;
     ucs_status_t status;
 
+    uct_rc_verbs_iface_post_chains(iface);
+
     status = uct_rc_verbs_iface_poll_rx_common(&iface->super);
     if (status == UCS_ERR_NO_PROGRESS) {
         uct_rc_verbs_iface_poll_tx(iface);
@@ -425,6 +435,8 @@ void uct_rc_verbs_iface_progress_tm(void *arg)
     uct_rc_verbs_iface_t *iface = arg;
     ucs_status_t status;
 
+    uct_rc_verbs_iface_post_chains(iface);
+
     status = uct_rc_verbs_iface_poll_rx_tm(iface);
     if (status == UCS_ERR_NO_PROGRESS) {
         uct_rc_verbs_iface_poll_tx(iface);
@@ -548,6 +560,9 @@ static ucs_status_t uct_rc_verbs_iface_tag_init(uct_rc_verbs_iface_t *iface,
         iface->tm.num_outstanding = iface->tm.tag_available;
 
         iface->tm.xrq.available = srq_init_attr.attr.max_wr;
+        /* The XRQ has no adaptive poll path - keep it fully provisioned */
+        uct_rc_iface_srq_window_init(&iface->tm.xrq, srq_init_attr.attr.max_wr,
+                                     srq_init_attr.attr.max_wr);
         --iface->tm.tag_available; /* 1 tag should be always available in HW match list */
 
         /* AM (NO_TAG) and eager messages have different header sizes.
@@ -759,8 +774,11 @@ static UCS_CLASS_INIT_FUNC(uct_rc_verbs_iface_t, uct_md_h md, uct_worker_h worke
 
     self->config.tx_max_wr           = ucs_min(config->verbs_common.tx_max_wr,
                                                self->super.config.tx_qp_len);
+    self->config.tx_chain            = ucs_min(config->tx_chain,
+                                               UCT_RC_VERBS_TX_CHAIN_MAX);
     self->super.config.tx_moderation = ucs_min(self->super.config.tx_moderation,
                                                self->config.tx_max_wr / 4);
+    ucs_list_head_init(&self->chained_eps);
 
     max_hdr_len = ucs_max(config->verbs_common.max_am_hdr, short_mp_size);
     status = uct_rc_verbs_iface_common_init(&self->verbs_common, &self->super,
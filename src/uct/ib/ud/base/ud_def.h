@@ -34,6 +34,10 @@
 #define UCT_UD_CA_MIN_WINDOW    2
 #define UCT_UD_CA_MAX_WINDOW    1025
 
+/* rx reorder window: must cover the tx congestion window so that any packet
+ * the peer may have in flight can be stashed instead of dropped */
+#define UCT_UD_RX_OOO_WINDOW    1024
+
 
 typedef uint16_t                 uct_ud_psn_t;
 #define UCT_UD_PSN_COMPARE       UCS_CIRCULAR_COMPARE16
@@ -178,9 +182,13 @@ typedef struct uct_ud_send_skb_inl {
 
 typedef struct uct_ud_recv_skb {
     uct_ib_iface_recv_desc_t super;
+    void                     *payload; /* separate payload buffer when the
+                                          iface posts split rx buffers */
     union {
         struct {
             ucs_frag_list_elem_t     elem;
+            uct_ud_neth_t            *neth;  /* stashed packet header */
+            uint32_t                 len;    /* stashed packet length */
         } ooo;
         struct {
             ucs_queue_elem_t         queue;
@@ -40,6 +40,8 @@ static void uct_ud_ep_resend_start(uct_ud_iface_t *iface, uct_ud_ep_t *ep)
     ep->resend.max_psn   = ep->tx.psn - 1;
     ep->resend.psn       = ep->tx.acked_psn + 1;
     ep->resend.pos       = ucs_queue_iter_begin(&ep->tx.window);
+    /* the timed packet may be retransmitted - drop the ambiguous sample */
+    ep->tx.rtt_time      = 0;
     uct_ud_ep_ctl_op_add(iface, ep, UCT_UD_EP_OP_RESEND);
 }
 
@@ -63,6 +65,37 @@ static void uct_ud_ep_resend_ack(uct_ud_iface_t *iface, uct_ud_ep_t *ep)
 }
 
 
+/* Fold a round trip sample into the smoothed estimates and derive the resend
+ * timeout, RFC6298 style (alpha=1/8, beta=1/4). The timeout is clamped to
+ * [tick, 3*tick] - the timer cannot usefully fire below its own tick, and the
+ * upper bound is the old fixed threshold. */
+static void uct_ud_ep_rtt_update(uct_ud_ep_t *ep, ucs_time_t rtt)
+{
+    ucs_time_t err;
+
+    if (ep->tx.srtt == 0) {
+        ep->tx.srtt   = rtt;
+        ep->tx.rttvar = rtt / 2;
+    } else {
+        err = (rtt > ep->tx.srtt) ? (rtt - ep->tx.srtt) :
+                                    (ep->tx.srtt - rtt);
+        if (err > ep->tx.rttvar) {
+            ep->tx.rttvar += (err - ep->tx.rttvar) / 4;
+        } else {
+            ep->tx.rttvar -= (ep->tx.rttvar - err) / 4;
+        }
+        if (rtt > ep->tx.srtt) {
+            ep->tx.srtt   += (rtt - ep->tx.srtt) / 8;
+        } else {
+            ep->tx.srtt   -= (ep->tx.srtt - rtt) / 8;
+        }
+    }
+
+    ep->tx.rto = ucs_max(uct_ud_slow_tick(),
+                         ucs_min(ep->tx.srtt + (4 * ep->tx.rttvar),
+                                 3 * uct_ud_slow_tick()));
+}
+
 static void uct_ud_ep_ca_drop(uct_ud_ep_t *ep)
 {
     ucs_debug("ep: %p ca drop@cwnd = %d in flight: %d",
@@ -100,11 +133,33 @@ static void uct_ud_ep_reset(uct_ud_ep_t *ep)
     ep->resend.psn       = ep->tx.psn;
     ep->resend.max_psn   = ep->tx.acked_psn;
 
+    ep->tx.rtt_time      = 0;
+    ep->tx.srtt          = 0;
+    ep->tx.rttvar        = 0;
+    ep->tx.rto           = 3 * uct_ud_slow_tick();
+
     ep->rx.acked_psn = UCT_UD_INITIAL_PSN - 1;
-    ucs_frag_list_init(ep->tx.psn-1, &ep->rx.ooo_pkts, 0 /*TODO: ooo support */
+    /* no hole lists - out of order packets are stashed in the sliding window,
+     * anything beyond it is dropped and resent by the peer */
+    ucs_frag_list_init(ep->tx.psn-1, &ep->rx.ooo_pkts, 0, UCT_UD_RX_OOO_WINDOW
                        UCS_STATS_ARG(ep->super.stats));
 }
 
+/* release stashed out-of-order skbs back to the rx mpool */
+static void uct_ud_ep_rx_ooo_cleanup(uct_ud_ep_t *ep)
+{
+    uct_ud_iface_t *iface = ucs_derived_of(ep->super.super.iface,
+                                           uct_ud_iface_t);
+    ucs_frag_list_elem_t *elem;
+
+    while ((elem = ucs_frag_list_extract(&ep->rx.ooo_pkts)) != NULL) {
+        uct_ud_recv_skb_put(iface,
+                            ucs_container_of(elem, uct_ud_recv_skb_t,
+                                             u.ooo.elem));
+    }
+    ucs_frag_list_cleanup(&ep->rx.ooo_pkts);
+}
+
 static void uct_ud_ep_slow_timer(ucs_wtimer_t *self)
 {
     uct_ud_ep_t *ep = ucs_container_of(self, uct_ud_ep_t, slow_timer);
@@ -124,9 +179,9 @@ static void uct_ud_ep_slow_timer(ucs_wtimer_t *self)
     if (diff > iface->config.peer_timeout) {
         iface->super.ops->handle_failure(&iface->super, ep);
         return;
-    } else if (diff > 3*uct_ud_slow_tick()) {
-        ucs_trace("sceduling resend now: %lu send_time: %lu diff: %lu tick: %lu",
-                   now, ep->tx.send_time, now - ep->tx.send_time, uct_ud_slow_tick());
+    } else if (diff > ep->tx.rto) {
+        ucs_trace("sceduling resend now: %lu send_time: %lu diff: %lu rto: %lu",
+                   now, ep->tx.send_time, now - ep->tx.send_time, ep->tx.rto);
         uct_ud_ep_ctl_op_del(ep, UCT_UD_EP_OP_ACK_REQ);
         uct_ud_ep_ca_drop(ep);
         uct_ud_ep_resend_start(iface, ep);
@@ -208,10 +263,14 @@ static UCS_CLASS_CLEANUP_FUNC(uct_ud_ep_t)
                                    ucs_derived_of(iface->super.ops, uct_ud_iface_ops_t)->progress,
                                    iface);
 
-    ucs_wtimer_remove(&self->slow_timer);
+    ucs_wtimer_remove(&iface->async.slow_timer, &self->slow_timer);
     uct_ud_iface_remove_ep(iface, self);
     uct_ud_iface_cep_remove(self);
-    ucs_frag_list_cleanup(&self->rx.ooo_pkts);
+    uct_ud_ep_rx_ooo_cleanup(self);
+
+    if (self->flags & UCT_UD_EP_FLAG_ACK_QUEUED) {
+        ucs_list_del(&self->ack_list);
+    }
 
     ucs_arbiter_group_purge(&iface->tx.pending_q, &self->tx.pending.group,
                             uct_ud_ep_pending_cancel_cb, 0);
@@ -230,9 +289,18 @@ void uct_ud_ep_clone(uct_ud_ep_t *old_ep, uct_ud_ep_t *new_ep)
 {
     uct_ep_t *ep_h = &old_ep->super.super;
     uct_iface_t *iface_h = ep_h->iface;
+    uct_ud_iface_t *iface = ucs_derived_of(iface_h, uct_ud_iface_t);
 
-    uct_ud_iface_replace_ep(ucs_derived_of(iface_h, uct_ud_iface_t), old_ep, new_ep);
+    uct_ud_iface_replace_ep(iface, old_ep, new_ep);
+
+    /* the ack list points to the old ep - relink it to the new one */
+    if (old_ep->flags & UCT_UD_EP_FLAG_ACK_QUEUED) {
+        ucs_list_del(&old_ep->ack_list);
+    }
     memcpy(new_ep, old_ep, sizeof(uct_ud_ep_t));
+    if (new_ep->flags & UCT_UD_EP_FLAG_ACK_QUEUED) {
+        ucs_list_add_tail(&iface->tx.ack_list, &new_ep->ack_list);
+    }
 }
 
 ucs_status_t uct_ud_ep_get_address(uct_ep_h tl_ep, uct_ep_addr_t *addr)
@@ -254,7 +322,7 @@ static ucs_status_t uct_ud_ep_connect_to_iface(uct_ud_ep_t *ep,
     uct_ib_device_t *dev = uct_ib_iface_device(&iface->super);
     char buf[128];
 
-    ucs_frag_list_cleanup(&ep->rx.ooo_pkts);
+    uct_ud_ep_rx_ooo_cleanup(ep);
     uct_ud_ep_reset(ep);
 
     ucs_debug(UCT_IB_IFACE_FMT" lid %d qpn 0x%x epid %u ep %p connected to "
@@ -271,7 +339,7 @@ static ucs_status_t uct_ud_ep_disconnect_from_iface(uct_ep_h tl_ep)
 {
     uct_ud_ep_t *ep = ucs_derived_of(tl_ep, uct_ud_ep_t);
 
-    ucs_frag_list_cleanup(&ep->rx.ooo_pkts);
+    uct_ud_ep_rx_ooo_cleanup(ep);
     uct_ud_ep_reset(ep);
     ep->dest_ep_id = UCT_UD_EP_NULL_ID;
 
@@ -348,7 +416,7 @@ ucs_status_t uct_ud_ep_connect_to_ep(uct_ud_ep_t *ep,
 
     ep->dest_ep_id = uct_ib_unpack_uint24(ep_addr->ep_id);
 
-    ucs_frag_list_cleanup(&ep->rx.ooo_pkts);
+    uct_ud_ep_rx_ooo_cleanup(ep);
     uct_ud_ep_reset(ep);
 
     ucs_debug(UCT_IB_IFACE_FMT" slid %d qpn 0x%x epid %u connected to %s qpn 0x%x "
@@ -394,6 +462,13 @@ uct_ud_ep_process_ack(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
         ucs_mpool_put(skb);
     }
 
+    if ((ep->tx.rtt_time != 0) &&
+        UCT_UD_PSN_COMPARE(ack_psn, >=, ep->tx.rtt_psn)) {
+        uct_ud_ep_rtt_update(ep, uct_ud_iface_get_async_time(iface) -
+                                 ep->tx.rtt_time);
+        ep->tx.rtt_time = 0;
+    }
+
     uct_ud_ep_ca_ack(ep);
 
     if (ucs_unlikely(UCT_UD_PSN_COMPARE(ep->resend.psn, <=, ep->resend.max_psn))) {
@@ -405,11 +480,12 @@ uct_ud_ep_process_ack(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
     ep->tx.send_time = uct_ud_iface_get_async_time(iface);
 }
 
-static inline void uct_ud_ep_rx_put(uct_ud_neth_t *neth, unsigned byte_len)
+static inline void uct_ud_ep_rx_put(uct_ud_neth_t *neth, void *data,
+                                    unsigned byte_len)
 {
     uct_ud_put_hdr_t *put_hdr;
 
-    put_hdr = (uct_ud_put_hdr_t *)(neth+1);
+    put_hdr = (uct_ud_put_hdr_t *)data;
 
     memcpy((void *)put_hdr->rva, put_hdr+1,
             byte_len - sizeof(*neth) - sizeof(*put_hdr));
@@ -437,10 +513,10 @@ static uct_ud_ep_t *uct_ud_ep_create_passive(uct_ud_iface_t *iface, uct_ud_ctl_h
     return ep;
 }
 
-static void uct_ud_ep_rx_creq(uct_ud_iface_t *iface, uct_ud_neth_t *neth)
+static void uct_ud_ep_rx_creq(uct_ud_iface_t *iface, uct_ud_neth_t *neth,
+                              uct_ud_ctl_hdr_t *ctl)
 {
     uct_ud_ep_t *ep;
-    uct_ud_ctl_hdr_t *ctl = (uct_ud_ctl_hdr_t *)(neth + 1);
 
     ucs_assert_always(ctl->type == UCT_UD_PACKET_CREQ);
 
@@ -490,7 +566,7 @@ static void uct_ud_ep_rx_creq(uct_ud_iface_t *iface, uct_ud_neth_t *neth)
 static void uct_ud_ep_rx_ctl(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
                              uct_ud_neth_t *neth, uct_ud_recv_skb_t *skb)
 {
-    uct_ud_ctl_hdr_t *ctl = (uct_ud_ctl_hdr_t*)(neth + 1);
+    uct_ud_ctl_hdr_t *ctl = uct_ud_recv_skb_data(iface, skb, neth);
 
     ucs_trace_func("");
     ucs_assert_always(ctl->type == UCT_UD_PACKET_CREP);
@@ -554,23 +630,89 @@ uct_ud_send_skb_t *uct_ud_ep_prepare_creq(uct_ud_ep_t *ep)
     return skb;
 }
 
+/* Note the ack request, but do not send anything yet: an outgoing data packet
+ * will carry the ack, and only the eps which stay quiet get a standalone ack,
+ * once per progress, from uct_ud_iface_dispatch_acks() */
+static UCS_F_ALWAYS_INLINE void
+uct_ud_ep_schedule_ack(uct_ud_iface_t *iface, uct_ud_ep_t *ep)
+{
+    ep->tx.pending.ops |= UCT_UD_EP_OP_ACK;
+    if (!(ep->flags & UCT_UD_EP_FLAG_ACK_QUEUED)) {
+        ep->flags |= UCT_UD_EP_FLAG_ACK_QUEUED;
+        ucs_list_add_tail(&iface->tx.ack_list, &ep->ack_list);
+    }
+}
+
+/* deliver an in-order data packet to its final destination - put handler, the
+ * sync am pending queue, or the am callback. Used both for freshly received
+ * packets and for packets replayed from the reorder window */
+static UCS_F_ALWAYS_INLINE void
+uct_ud_ep_dispatch_rx(uct_ud_iface_t *iface, uct_ud_neth_t *neth,
+                      unsigned byte_len, uct_ud_recv_skb_t *skb, int is_async)
+{
+    uint32_t am_id = uct_ud_neth_get_am_id(neth);
+
+    if (ucs_unlikely(!(neth->packet_type & UCT_UD_PACKET_FLAG_AM) &&
+                     (neth->packet_type & UCT_UD_PACKET_FLAG_PUT))) {
+        /* TODO: remove once ucp implements put */
+        uct_ud_ep_rx_put(neth, uct_ud_recv_skb_data(iface, skb, neth),
+                         byte_len);
+        uct_ud_recv_skb_put(iface, skb);
+        return;
+    }
+
+    if (ucs_unlikely(is_async &&
+                     (iface->super.super.am_flags[am_id] & UCT_AM_CB_FLAG_SYNC))) {
+        skb->u.am.len = byte_len - sizeof(*neth);
+        ucs_queue_push(&iface->rx.pending_q, &skb->u.am.queue);
+    } else {
+        uct_ud_iface_invoke_am(iface, am_id,
+                               uct_ud_recv_skb_data(iface, skb, neth),
+                               byte_len - sizeof(*neth), skb);
+    }
+}
+
+/* pull the whole in-order run of stashed packets from the reorder window and
+ * deliver them in sequence number order */
+static void uct_ud_ep_replay_ooo(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
+                                 int is_async)
+{
+    ucs_frag_list_elem_t *elem;
+    ucs_queue_head_t run;
+    uct_ud_recv_skb_t *skb;
+    uct_ud_neth_t *neth;
+    unsigned len;
+
+    ucs_queue_head_init(&run);
+    ucs_frag_list_pull_bulk(&ep->rx.ooo_pkts, &run);
+    while (!ucs_queue_is_empty(&run)) {
+        elem = ucs_queue_pull_elem_non_empty(&run, ucs_frag_list_elem_t, list);
+        skb  = ucs_container_of(elem, uct_ud_recv_skb_t, u.ooo.elem);
+        /* read the stash before dispatching - the sync pending queue reuses
+         * the same union */
+        neth = skb->u.ooo.neth;
+        len  = skb->u.ooo.len;
+        uct_ud_ep_dispatch_rx(iface, neth, len, skb, is_async);
+    }
+}
+
 void uct_ud_ep_process_rx(uct_ud_iface_t *iface, uct_ud_neth_t *neth, unsigned byte_len,
                           uct_ud_recv_skb_t *skb, int is_async)
 {
     uint32_t dest_id;
-    uint32_t is_am, am_id;
+    uint32_t is_am;
     uct_ud_ep_t *ep = 0; /* todo: check why gcc complaints about uninitialized var */
     ucs_frag_list_ooo_type_t ooo_type;
 
     UCT_UD_IFACE_HOOK_CALL_RX(iface, neth, byte_len);
 
     dest_id = uct_ud_neth_get_dest_id(neth);
-    am_id   = uct_ud_neth_get_am_id(neth);
     is_am   = neth->packet_type & UCT_UD_PACKET_FLAG_AM;
 
     if (ucs_unlikely(dest_id == UCT_UD_EP_NULL_ID)) {
         /* must be connection request packet */
-        uct_ud_ep_rx_creq(iface, neth);
+        uct_ud_ep_rx_creq(iface, neth,
+                          uct_ud_recv_skb_data(iface, skb, neth));
         goto out;
     } else if (ucs_unlikely(!ucs_ptr_array_lookup(&iface->eps, dest_id, ep) ||
                ep->ep_id != dest_id))
@@ -589,7 +731,7 @@ void uct_ud_ep_process_rx(uct_ud_iface_t *iface, uct_ud_neth_t *neth, unsigned b
     uct_ud_ep_process_ack(iface, ep, neth->ack_psn, is_async);
 
     if (ucs_unlikely(neth->packet_type & UCT_UD_PACKET_FLAG_ACK_REQ)) {
-        uct_ud_ep_ctl_op_add(iface, ep, UCT_UD_EP_OP_ACK);
+        uct_ud_ep_schedule_ack(iface, ep);
         ucs_trace_data("ACK_REQ - schedule ack, head_sn=%d sn=%d",
                        ep->rx.ooo_pkts.head_sn, neth->psn);
     }
@@ -604,36 +746,45 @@ void uct_ud_ep_process_rx(uct_ud_iface_t *iface, uct_ud_neth_t *neth, unsigned b
         }
     }
 
+    skb->u.ooo.neth = neth;
+    skb->u.ooo.len  = byte_len;
     ooo_type = ucs_frag_list_insert(&ep->rx.ooo_pkts, &skb->u.ooo.elem, neth->psn);
     if (ucs_unlikely(ooo_type != UCS_FRAG_LIST_INSERT_FAST)) {
-        if (ooo_type != UCS_FRAG_LIST_INSERT_DUP &&
-            ooo_type != UCS_FRAG_LIST_INSERT_FAIL) {
-            ucs_fatal("Out of order is not implemented: got %d", ooo_type);
+        if (ooo_type == UCS_FRAG_LIST_INSERT_SLOW) {
+            /* stashed in the reorder window - the skb is now owned by the frag
+             * list. Ask for an ack so the sender learns about the hole */
+            ucs_trace_data("OOO stash - schedule ack, head_sn=%d sn=%d",
+                           ep->rx.ooo_pkts.head_sn, neth->psn);
+            uct_ud_ep_schedule_ack(iface, ep);
+            return;
+        }
+
+        if (ooo_type == UCS_FRAG_LIST_INSERT_FIRST) {
+            /* this packet filled the hole - deliver it and replay the whole
+             * in-order run from the reorder window */
+            uct_ud_ep_dispatch_rx(iface, neth, byte_len, skb, is_async);
+            uct_ud_ep_replay_ooo(iface, ep, is_async);
+            return;
         }
+
+        if (ooo_type == UCS_FRAG_LIST_INSERT_READY) {
+            /* the skb went onto the ready list - the replay pulls it together
+             * with the rest of the run */
+            uct_ud_ep_replay_ooo(iface, ep, is_async);
+            return;
+        }
+
         ucs_trace_data("DUP/OOB - schedule ack, head_sn=%d sn=%d",
                        ep->rx.ooo_pkts.head_sn, neth->psn);
-        uct_ud_ep_ctl_op_add(iface, ep, UCT_UD_EP_OP_ACK);
+        uct_ud_ep_schedule_ack(iface, ep);
         goto out;
     }
 
-    if (ucs_unlikely(!is_am && (neth->packet_type & UCT_UD_PACKET_FLAG_PUT))) {
-        /* TODO: remove once ucp implements put */
-        uct_ud_ep_rx_put(neth, byte_len);
-        goto out;
-    }
-
-    if (ucs_unlikely(is_async &&
-                     (iface->super.super.am[am_id].flags & UCT_AM_CB_FLAG_SYNC))) {
-        skb->u.am.len = byte_len - sizeof(*neth);
-        ucs_queue_push(&iface->rx.pending_q, &skb->u.am.queue);
-    } else {
-        uct_ib_iface_invoke_am_desc(&iface->super, am_id, neth + 1,
-                                    byte_len - sizeof(*neth), &skb->super);
-    }
+    uct_ud_ep_dispatch_rx(iface, neth, byte_len, skb, is_async);
     return;
 
 out:
-    ucs_mpool_put(skb);
+    uct_ud_recv_skb_put(iface, skb);
 }
 
 ucs_status_t uct_ud_ep_flush_nolock(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
@@ -1021,7 +1172,8 @@ uct_ud_ep_do_pending(ucs_arbiter_t *arbiter, ucs_arbiter_elem_t *elem,
     return uct_ud_ep_ctl_op_next(ep);
 }
 
-ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep_h, uct_pending_req_t *req)
+ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep_h, uct_pending_req_t *req,
+                                   unsigned flags)
 {
     uct_ud_ep_t *ep = ucs_derived_of(ep_h, uct_ud_ep_t);
     uct_ud_iface_t *iface = ucs_derived_of(ep->super.super.iface,
@@ -94,12 +94,16 @@ do { \
  * on ack recv:
  *   - send_time = wheel_time. (advance last send time)
  * on timer expiration:
- *   - if wheel_time - saved_time > 3*one_tick_time
+ *   - if wheel_time - saved_time > rto
  *        schedule resend
  *        send_time = wheel_time
  *        consgestion avoidance decreases tx window
  *   - if window is not empty resched timer
- *   3x is needed to avoid false resends because of errors in timekeeping
+ *   rto is derived from a per ep estimate of the round trip time
+ *   (srtt + 4*rttvar, as in RFC6298) and is clamped to
+ *   [one_tick_time, 3*one_tick_time]. Until the first measurement it
+ *   stays at the upper bound, which also absorbs errors in timekeeping.
+ *   Acks of retransmitted packets are not sampled (Karn's algorithm).
  *
  * Fast ep timer (Not implemented)
  *
@@ -194,9 +198,11 @@ enum {
     UCT_UD_EP_FLAG_CREP_RCVD         = UCS_BIT(4), /* CREP message was received */
     UCT_UD_EP_FLAG_CREQ_SENT         = UCS_BIT(5), /* CREQ message was sent */
     UCT_UD_EP_FLAG_CREP_SENT         = UCS_BIT(6), /* CREP message was sent */
-    UCT_UD_EP_FLAG_CREQ_NOTSENT      = UCS_BIT(7)  /* CREQ message is NOT sent, because
+    UCT_UD_EP_FLAG_CREQ_NOTSENT      = UCS_BIT(7), /* CREQ message is NOT sent, because
                                                       connection establishment process
                                                       is driven by remote side. */
+    UCT_UD_EP_FLAG_ACK_QUEUED        = UCS_BIT(8)  /* EP is on the interface list of
+                                                      endpoints with a pending ack */
 };
 
 typedef struct uct_ud_peer_name {
@@ -215,6 +221,12 @@ struct uct_ud_ep {
          ucs_queue_head_t       window;       /* send window: [acked_psn+1, psn-1] */
          uct_ud_ep_pending_op_t pending;      /* pending ops */
          ucs_time_t             send_time;    /* tx time of last packet */
+         ucs_time_t             rtt_time;     /* tx time of the packet being timed,
+                                                 0 if no measurement is in flight */
+         uct_ud_psn_t           rtt_psn;      /* psn of the packet being timed */
+         ucs_time_t             srtt;         /* smoothed round trip time estimate */
+         ucs_time_t             rttvar;       /* round trip time variance estimate */
+         ucs_time_t             rto;          /* resend timeout driven by srtt/rttvar */
          UCS_STATS_NODE_DECLARE(stats);
          UCT_UD_EP_HOOK_DECLARE(tx_hook);
     } tx;
@@ -235,9 +247,11 @@ struct uct_ud_ep {
         UCT_UD_EP_HOOK_DECLARE(rx_hook);
     } rx;
     ucs_list_link_t  cep_list;
+    ucs_list_link_t  ack_list;     /* membership in the interface list of eps with
+                                      a pending ack; valid iff ACK_QUEUED is set */
     uint32_t         conn_id;      /* connection id. assigned in connect_to_iface() */
     ucs_wtimer_t     slow_timer;
-    uint8_t          flags;
+    uint16_t         flags;
     uint8_t          path_bits;
     UCS_STATS_NODE_DECLARE(stats);
     UCT_UD_EP_HOOK_DECLARE(timer_hook);
@@ -260,7 +274,8 @@ ucs_status_t uct_ud_ep_connect_to_ep(uct_ud_ep_t *ep,
                                      const uct_ib_address_t *ib_addr,
                                      const uct_ud_ep_addr_t *ep_addr);
 
-ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep, uct_pending_req_t *n);
+ucs_status_t uct_ud_ep_pending_add(uct_ep_h ep, uct_pending_req_t *n,
+                                   unsigned flags);
 
 void   uct_ud_ep_pending_purge(uct_ep_h ep, uct_pending_purge_callback_t cb,
                                void *arg);
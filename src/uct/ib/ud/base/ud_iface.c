@@ -259,7 +259,7 @@ uct_ud_iface_create_qp(uct_ud_iface_t *self, const uct_ud_iface_config_t *config
     qp_init_attr.cap.max_send_wr     = config->super.tx.queue_len;
     qp_init_attr.cap.max_recv_wr     = config->super.rx.queue_len;
     qp_init_attr.cap.max_send_sge    = 2;
-    qp_init_attr.cap.max_recv_sge    = 1;
+    qp_init_attr.cap.max_recv_sge    = self->rx.hdr_split ? 2 : 1;
     qp_init_attr.cap.max_inline_data = ucs_max(config->super.tx.min_inline,
                                                UCT_UD_MIN_INLINE);
 
@@ -387,7 +387,7 @@ void uct_ud_iface_remove_async_handlers(uct_ud_iface_t *iface)
 
 UCS_CLASS_INIT_FUNC(uct_ud_iface_t, uct_ud_iface_ops_t *ops, uct_md_h md,
                     uct_worker_h worker, const uct_iface_params_t *params,
-                    unsigned ud_rx_priv_len,
+                    unsigned ud_rx_priv_len, int rx_hdr_split_cap,
                     const uct_ud_iface_config_t *config)
 {
     unsigned rx_priv_len, rx_hdr_len;
@@ -430,6 +430,7 @@ UCS_CLASS_INIT_FUNC(uct_ud_iface_t, uct_ud_iface_ops_t *ops, uct_md_h md,
     self->tx.available           = config->super.tx.queue_len;
 
     self->rx.available           = config->super.rx.queue_len;
+    self->rx.hdr_split           = rx_hdr_split_cap && config->rx_hdr_split;
     self->config.tx_qp_len       = config->super.tx.queue_len;
     self->config.peer_timeout    = ucs_time_from_sec(config->peer_timeout);
 
@@ -445,12 +446,26 @@ UCS_CLASS_INIT_FUNC(uct_ud_iface_t, uct_ud_iface_ops_t *ops, uct_md_h md,
     ucs_ptr_array_init(&self->eps, 0, "ud_eps");
     uct_ud_iface_cep_init(self);
 
-    status = uct_ib_iface_recv_mpool_init(&self->super, &config->super,
-                                          "ud_recv_skb", &self->rx.mp);
+    /* with split rx the skb holds only the GRH and network header, and the
+     * payload lands in a buffer of its own which can outlive the skb */
+    status = uct_ib_iface_recv_mpool_init_size(&self->super, &config->super,
+                                               "ud_recv_skb",
+                                               self->rx.hdr_split ? 0 :
+                                               self->super.config.seg_size,
+                                               &self->rx.mp);
     if (status != UCS_OK) {
         goto err_qp;
     }
 
+    if (self->rx.hdr_split) {
+        status = uct_ib_iface_recv_mpool_init(&self->super, &config->super,
+                                              "ud_recv_payload",
+                                              &self->rx.payload_mp);
+        if (status != UCS_OK) {
+            goto err_mpool;
+        }
+    }
+
     data_size = sizeof(uct_ud_ctl_hdr_t) + self->super.addr_size;
     data_size = ucs_max(data_size, self->super.config.seg_size);
     data_size = ucs_max(data_size, sizeof(uct_ud_zcopy_desc_t) + self->config.max_inline);
@@ -462,7 +477,7 @@ UCS_CLASS_INIT_FUNC(uct_ud_iface_t, uct_ud_iface_ops_t *ops, uct_md_h md,
                                   &config->super.tx.mp, self->config.tx_qp_len,
                                   uct_ud_iface_send_skb_init, "ud_tx_skb");
     if (status != UCS_OK) {
-        goto err_mpool;
+        goto err_payload_mpool;
     }
     self->tx.skb = ucs_mpool_get(&self->tx.mp);
     self->tx.skb_inl.super.len = sizeof(uct_ud_neth_t);
@@ -472,11 +487,16 @@ UCS_CLASS_INIT_FUNC(uct_ud_iface_t, uct_ud_iface_ops_t *ops, uct_md_h md,
     ucs_arbiter_init(&self->tx.pending_q);
     self->tx.pending_q_len = 0;
     self->tx.in_pending = 0;
+    ucs_list_head_init(&self->tx.ack_list);
 
     ucs_queue_head_init(&self->rx.pending_q);
 
     return UCS_OK;
 
+err_payload_mpool:
+    if (self->rx.hdr_split) {
+        ucs_mpool_cleanup(&self->rx.payload_mp, 1);
+    }
 err_mpool:
     ucs_mpool_cleanup(&self->rx.mp, 1);
 err_qp:
@@ -498,6 +518,9 @@ static UCS_CLASS_CLEANUP_FUNC(uct_ud_iface_t)
     ucs_mpool_cleanup(&self->tx.mp, 0);
     /* TODO: qp to error state and cleanup all wqes */
     uct_ud_iface_free_pending_rx(self);
+    if (self->rx.hdr_split) {
+        ucs_mpool_cleanup(&self->rx.payload_mp, 0);
+    }
     ucs_mpool_cleanup(&self->rx.mp, 0);
     ibv_destroy_qp(self->qp);
     ucs_debug("iface(%p): ptr_array cleanup", self);
@@ -514,6 +537,12 @@ ucs_config_field_t uct_ud_iface_config_table[] = {
      ucs_offsetof(uct_ud_iface_config_t, super), UCS_CONFIG_TYPE_TABLE(uct_ib_iface_config_table)},
     {"TIMEOUT", "5.0m", "Transport timeout",
      ucs_offsetof(uct_ud_iface_config_t, peer_timeout), UCS_CONFIG_TYPE_TIME},
+    {"RX_HDR_SPLIT", "n",
+     "Post receive buffers as a small header segment plus a payload segment from\n"
+     "a separate pool. A payload held by the upper layer (unexpected messages)\n"
+     "then does not pin a whole MTU-sized buffer, and the header buffers recycle\n"
+     "immediately. Supported by the verbs UD transport only.",
+     ucs_offsetof(uct_ud_iface_config_t, rx_hdr_split), UCS_CONFIG_TYPE_BOOL},
     {NULL}
 };
 
@@ -642,6 +671,21 @@ static void uct_ud_iface_reserve_skbs(uct_ud_iface_t *iface, int count)
     }
 }
 
+void uct_ud_iface_dispatch_acks(uct_ud_iface_t *iface)
+{
+    uct_ud_ep_t *ep, *tmp;
+
+    ucs_list_for_each_safe(ep, tmp, &iface->tx.ack_list, ack_list) {
+        ucs_list_del(&ep->ack_list);
+        ep->flags &= ~UCT_UD_EP_FLAG_ACK_QUEUED;
+        if (uct_ud_ep_ctl_op_check(ep, UCT_UD_EP_OP_ACK)) {
+            /* the ack did not piggyback on outgoing data since it was
+             * requested - send a standalone one */
+            uct_ud_ep_ctl_op_schedule(iface, ep);
+        }
+    }
+}
+
 uct_ud_send_skb_t *uct_ud_iface_res_skb_get(uct_ud_iface_t *iface)
 {
     ucs_queue_elem_t *elem;
@@ -716,11 +760,9 @@ ucs_status_t uct_ud_iface_dispatch_pending_rx_do(uct_ud_iface_t *iface)
         neth =  (uct_ud_neth_t *)((char *)uct_ib_iface_recv_desc_hdr(&iface->super,
                                                                      (uct_ib_iface_recv_desc_t *)skb) +
                                   UCT_IB_GRH_LEN);
-        uct_ib_iface_invoke_am_desc(&iface->super,
-                                    uct_ud_neth_get_am_id(neth),
-                                    neth + 1,
-                                    skb->u.am.len,
-                                    &skb->super);
+        uct_ud_iface_invoke_am(iface, uct_ud_neth_get_am_id(neth),
+                               uct_ud_recv_skb_data(iface, skb, neth),
+                               skb->u.am.len, skb);
         count++;
         if (count >= max_poll) {
             return UCS_ERR_NO_RESOURCE;
@@ -736,7 +778,7 @@ static void uct_ud_iface_free_pending_rx(uct_ud_iface_t *iface)
 
     while (!ucs_queue_is_empty(&iface->rx.pending_q)) {
         skb = ucs_queue_pull_elem_non_empty(&iface->rx.pending_q, uct_ud_recv_skb_t, u.am.queue);
-        ucs_mpool_put(skb);
+        uct_ud_recv_skb_put(iface, skb);
     }
 }
 
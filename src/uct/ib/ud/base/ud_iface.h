@@ -28,6 +28,7 @@
 typedef struct uct_ud_iface_config {
     uct_ib_iface_config_t    super;
     double                   peer_timeout;
+    int                      rx_hdr_split;
 } uct_ud_iface_config_t;
 
 struct uct_ud_iface_peer {
@@ -100,6 +101,11 @@ struct uct_ud_iface {
     struct ibv_qp           *qp;
     struct {
         ucs_mpool_t          mp;
+        /* payload buffers when rx buffers are posted split; the header part
+         * recycles with the skb while a payload held by the am callback stays
+         * out until the upper layer releases its desc */
+        ucs_mpool_t          payload_mp;
+        unsigned             hdr_split;
         unsigned             available;
         ucs_queue_head_t     pending_q;
         UCT_UD_IFACE_HOOK_DECLARE(hook);
@@ -116,6 +122,10 @@ struct uct_ud_iface {
         int                    pending_q_len;
         int                    in_pending;
         ucs_queue_head_t       async_comp_q;
+        /* eps which got an ack request and did not send anything since; a
+         * standalone ack is sent once per progress for those which could not
+         * piggyback it on outgoing data */
+        ucs_list_link_t        ack_list;
     } tx;
     struct {
         ucs_time_t           peer_timeout;
@@ -132,7 +142,7 @@ struct uct_ud_iface {
 
 UCS_CLASS_DECLARE(uct_ud_iface_t, uct_ud_iface_ops_t*, uct_md_h,
                   uct_worker_h, const uct_iface_params_t*,
-                  unsigned, const uct_ud_iface_config_t*)
+                  unsigned, int, const uct_ud_iface_config_t*)
 
 struct uct_ud_ctl_hdr {
     uint8_t                    type;
@@ -168,6 +178,8 @@ ucs_status_t uct_ud_iface_flush(uct_iface_h tl_iface, unsigned flags,
 
 ucs_status_t uct_ud_iface_complete_init(uct_ud_iface_t *iface);
 
+void uct_ud_iface_dispatch_acks(uct_ud_iface_t *iface);
+
 void uct_ud_iface_remove_async_handlers(uct_ud_iface_t *iface);
 
 void uct_ud_dump_packet(uct_base_iface_t *iface, uct_am_trace_type_t type,
@@ -202,6 +214,46 @@ static inline uct_ib_address_t* uct_ud_creq_ib_addr(uct_ud_ctl_hdr_t *conn_req)
     return (uct_ib_address_t*)(conn_req + 1);
 }
 
+/* pointer to the packet payload - the bytes which follow the network header.
+ * With header/data split the payload is scattered into a separate buffer;
+ * otherwise it follows the header inside the skb */
+static UCS_F_ALWAYS_INLINE void *
+uct_ud_recv_skb_data(uct_ud_iface_t *iface, uct_ud_recv_skb_t *skb,
+                     uct_ud_neth_t *neth)
+{
+    if (iface->rx.hdr_split) {
+        return (char*)skb->payload + iface->super.config.rx_payload_offset;
+    }
+    return neth + 1;
+}
+
+/* release a receive skb together with its split payload buffer, if any */
+static UCS_F_ALWAYS_INLINE void
+uct_ud_recv_skb_put(uct_ud_iface_t *iface, uct_ud_recv_skb_t *skb)
+{
+    if (iface->rx.hdr_split) {
+        ucs_mpool_put(skb->payload);
+    }
+    ucs_mpool_put(skb);
+}
+
+/* hand an am to the user callback. With header/data split the payload buffer
+ * itself is the descriptor the callback may keep, and the header skb recycles
+ * immediately; otherwise the skb is the descriptor as usual */
+static UCS_F_ALWAYS_INLINE void
+uct_ud_iface_invoke_am(uct_ud_iface_t *iface, uint8_t am_id, void *data,
+                       unsigned length, uct_ud_recv_skb_t *skb)
+{
+    if (iface->rx.hdr_split) {
+        uct_ib_iface_invoke_am_desc(&iface->super, am_id, data, length,
+                                    (uct_ib_iface_recv_desc_t*)skb->payload);
+        ucs_mpool_put(skb);
+    } else {
+        uct_ib_iface_invoke_am_desc(&iface->super, am_id, data, length,
+                                    &skb->super);
+    }
+}
+
 static UCS_F_ALWAYS_INLINE void uct_ud_enter(uct_ud_iface_t *iface)
 {
     UCS_ASYNC_BLOCK(iface->super.super.worker->async);
@@ -333,6 +385,10 @@ uct_ud_iface_progress_pending(uct_ud_iface_t *iface, const uintptr_t is_async)
         return;
     }
 
+    if (ucs_unlikely(!ucs_list_is_empty(&iface->tx.ack_list))) {
+        uct_ud_iface_dispatch_acks(iface);
+    }
+
     iface->tx.in_pending = 1;
     ucs_arbiter_dispatch(&iface->tx.pending_q, 1,
              uct_ud_ep_do_pending, (void *)is_async);
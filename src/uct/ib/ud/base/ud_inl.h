@@ -120,6 +120,18 @@ uct_ud_am_set_zcopy_desc(uct_ud_send_skb_t *skb, const uct_iov_t *iov, size_t io
     }
 }
 
+/* Time the round trip of this packet, unless a measurement is already in
+ * flight. Acks of retransmits never restart it, so samples stay unambiguous
+ * (Karn's algorithm). */
+static UCS_F_ALWAYS_INLINE void
+uct_ud_ep_rtt_sample_start(uct_ud_ep_t *ep, uct_ud_send_skb_t *skb)
+{
+    if (ep->tx.rtt_time == 0) {
+        ep->tx.rtt_time = ep->tx.send_time;
+        ep->tx.rtt_psn  = skb->neth->psn;
+    }
+}
+
 static UCS_F_ALWAYS_INLINE void
 uct_ud_iface_complete_tx_inl(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
                              uct_ud_send_skb_t *skb, void *data,
@@ -135,6 +147,7 @@ uct_ud_iface_complete_tx_inl(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
                    ucs_twheel_get_time(&iface->async.slow_timer) +
                    uct_ud_slow_tick());
     ep->tx.send_time = uct_ud_iface_get_async_time(iface);
+    uct_ud_ep_rtt_sample_start(ep, skb);
 }
 
 static UCS_F_ALWAYS_INLINE void
@@ -149,6 +162,7 @@ uct_ud_iface_complete_tx_skb(uct_ud_iface_t *iface, uct_ud_ep_t *ep,
                    ucs_twheel_get_time(&iface->async.slow_timer) +
                    uct_ud_slow_tick());
     ep->tx.send_time = uct_ud_iface_get_async_time(iface);
+    uct_ud_ep_rtt_sample_start(ep, skb);
 }
 
 static UCS_F_ALWAYS_INLINE void
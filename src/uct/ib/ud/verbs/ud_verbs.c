@@ -50,10 +50,8 @@ UCS_CLASS_INIT_FUNC(uct_ud_verbs_ep_t, uct_iface_h tl_iface)
 static UCS_CLASS_CLEANUP_FUNC(uct_ud_verbs_ep_t)
 {
     ucs_trace_func("");
-    if (self->ah) {
-        ibv_destroy_ah(self->ah);
-        self->ah = NULL;
-    }
+    /* The address handle is cached on the device and released with it */
+    self->ah = NULL;
 }
 
 UCS_CLASS_DEFINE(uct_ud_verbs_ep_t, uct_ud_ep_t);
@@ -323,8 +321,14 @@ uct_ud_verbs_iface_poll_rx(uct_ud_verbs_iface_t *iface, int is_async)
     }
 
     UCT_IB_IFACE_VERBS_FOREACH_RXWQE(&iface->super.super, i, packet, wc, num_wcs) {
+        /* with split rx only the header part is contiguous at 'packet' */
         uct_ib_log_recv_completion(&iface->super.super, IBV_QPT_UD, &wc[i],
-                                   packet, wc[i].byte_len, uct_ud_dump_packet);
+                                   packet,
+                                   iface->super.rx.hdr_split ?
+                                   ucs_min(wc[i].byte_len,
+                                           UCT_IB_GRH_LEN + sizeof(uct_ud_neth_t)) :
+                                   wc[i].byte_len,
+                                   uct_ud_dump_packet);
         uct_ud_ep_process_rx(&iface->super,
                              (uct_ud_neth_t *)(packet + UCT_IB_GRH_LEN),
                              wc[i].byte_len - UCT_IB_GRH_LEN,
@@ -506,23 +510,76 @@ static uct_ud_iface_ops_t uct_ud_verbs_iface_ops = {
     .tx_skb                   = uct_ud_verbs_ep_tx_ctl_skb,
 };
 
+/* recv wr with room for a split posting: header segment in the skb, payload
+ * segment in a buffer of its own */
+typedef struct uct_ud_verbs_recv_wr {
+    struct ibv_recv_wr      ibwr;
+    struct ibv_sge          sg[2];
+} uct_ud_verbs_recv_wr_t;
+
+static unsigned
+uct_ud_verbs_iface_prepare_rx_wrs_split(uct_ud_verbs_iface_t *iface,
+                                        uct_ud_verbs_recv_wr_t *wrs, unsigned n)
+{
+    uct_ib_iface_t *ib_iface = &iface->super.super;
+    uct_ib_iface_recv_desc_t *desc, *pdesc;
+    unsigned count;
+
+    count = 0;
+    while (count < n) {
+        UCT_TL_IFACE_GET_RX_DESC(&ib_iface->super, &iface->super.rx.mp,
+                                 desc, break);
+        UCT_TL_IFACE_GET_RX_DESC(&ib_iface->super, &iface->super.rx.payload_mp,
+                                 pdesc, { ucs_mpool_put(desc); break; });
+
+        ((uct_ud_recv_skb_t *)desc)->payload = pdesc;
+
+        wrs[count].sg[0].addr   = (uintptr_t)uct_ib_iface_recv_desc_hdr(ib_iface, desc);
+        wrs[count].sg[0].length = UCT_IB_GRH_LEN + sizeof(uct_ud_neth_t);
+        wrs[count].sg[0].lkey   = desc->lkey;
+        wrs[count].sg[1].addr   = (uintptr_t)((char*)pdesc +
+                                              ib_iface->config.rx_payload_offset);
+        wrs[count].sg[1].length = ib_iface->config.seg_size;
+        wrs[count].sg[1].lkey   = pdesc->lkey;
+        wrs[count].ibwr.num_sge = 2;
+        wrs[count].ibwr.wr_id   = (uintptr_t)desc;
+        wrs[count].ibwr.sg_list = wrs[count].sg;
+        wrs[count].ibwr.next    = &wrs[count + 1].ibwr;
+        ++count;
+    }
+
+    if (count > 0) {
+        wrs[count - 1].ibwr.next = NULL;
+    }
+
+    return count;
+}
+
 static UCS_F_NOINLINE void
 uct_ud_verbs_iface_post_recv_always(uct_ud_verbs_iface_t *iface, int max)
 {
     struct ibv_recv_wr *bad_wr;
+    uct_ud_verbs_recv_wr_t *swrs;
     uct_ib_recv_wr_t *wrs;
+    struct ibv_recv_wr *head;
     unsigned count;
     int ret;
 
-    wrs  = ucs_alloca(sizeof *wrs  * max);
-
-    count = uct_ib_iface_prepare_rx_wrs(&iface->super.super, &iface->super.rx.mp,
-                                        wrs, max);
+    if (iface->super.rx.hdr_split) {
+        swrs  = ucs_alloca(sizeof *swrs * max);
+        count = uct_ud_verbs_iface_prepare_rx_wrs_split(iface, swrs, max);
+        head  = &swrs[0].ibwr;
+    } else {
+        wrs   = ucs_alloca(sizeof *wrs  * max);
+        count = uct_ib_iface_prepare_rx_wrs(&iface->super.super,
+                                            &iface->super.rx.mp, wrs, max);
+        head  = &wrs[0].ibwr;
+    }
     if (count == 0) {
         return;
     }
 
-    ret = ibv_post_recv(iface->super.qp, &wrs[0].ibwr, &bad_wr);
+    ret = ibv_post_recv(iface->super.qp, head, &bad_wr);
     if (ret != 0) {
         ucs_fatal("ibv_post_recv() returned %d: %m", ret);
     }
@@ -551,7 +608,7 @@ static UCS_CLASS_INIT_FUNC(uct_ud_verbs_iface_t, uct_md_h md, uct_worker_h worke
     ucs_trace_func("");
 
     UCS_CLASS_CALL_SUPER_INIT(uct_ud_iface_t, &uct_ud_verbs_iface_ops, md,
-                              worker, params, 0, config);
+                              worker, params, 0, 1, config);
 
     memset(&self->tx.wr_inl, 0, sizeof(self->tx.wr_inl));
     self->tx.wr_inl.opcode            = IBV_WR_SEND;
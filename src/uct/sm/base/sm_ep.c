@@ -6,6 +6,7 @@
 #include "sm_ep.h"
 
 #include <ucs/arch/atomic.h>
+#include <ucs/arch/cpu.h>
 
 
 #define uct_sm_ep_trace_data(_remote_addr, _rkey, _fmt, ...) \
@@ -17,7 +18,7 @@ ucs_status_t uct_sm_ep_put_short(uct_ep_h tl_ep, const void *buffer,
                                  uct_rkey_t rkey)
 {
     if (ucs_likely(length != 0)) {
-        memcpy((void *)(rkey + remote_addr), buffer, length);
+        ucs_memcpy_relaxed((void *)(rkey + remote_addr), buffer, length);
         uct_sm_ep_trace_data(remote_addr, rkey, "PUT_SHORT [buffer %p size %u]",
                              buffer, length);
     } else {
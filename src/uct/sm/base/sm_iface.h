@@ -12,7 +12,11 @@
 #include <ucs/sys/sys.h>
 
 #define UCT_SM_IFACE_DEVICE_ADDR_LEN    sizeof(uint64_t)
-#define UCT_SM_MAX_IOV                  16
+
+/* How many iov entries a single zcopy operation can carry. cma/knem pass the
+ * whole array to one kernel call, so a larger bound means fewer syscalls for
+ * strided transfers. Bounded at runtime by IOV_MAX via uct_sm_get_max_iov(). */
+#define UCT_SM_MAX_IOV                  128
 
 ucs_status_t uct_sm_iface_get_device_address(uct_iface_t *tl_iface,
                                              uct_device_addr_t *addr);
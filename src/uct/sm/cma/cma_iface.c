@@ -33,6 +33,7 @@ static ucs_status_t uct_cma_iface_query(uct_iface_h tl_iface,
                                        uct_iface_attr_t *iface_attr)
 {
     memset(iface_attr, 0, sizeof(uct_iface_attr_t));
+    iface_attr->numa_node = -1;
 
     /* default values for all shared memory transports */
     iface_attr->cap.put.min_zcopy       = 0;
@@ -9,6 +9,7 @@
 #include "knem_ep.h"
 #include "knem_md.h"
 #include <uct/sm/base/sm_iface.h>
+#include <ucs/arch/bitops.h>
 #include <ucs/debug/log.h>
 
 static UCS_CLASS_INIT_FUNC(uct_knem_ep_t, uct_iface_t *tl_iface,
@@ -43,12 +44,14 @@ UCS_CLASS_DEFINE_DELETE_FUNC(uct_knem_ep_t, uct_ep_t);
 
 static inline ucs_status_t uct_knem_rma(uct_ep_h tl_ep, const uct_iov_t *iov,
                                         size_t iovcnt, uint64_t remote_addr,
-                                        uct_knem_key_t *key, int write)
+                                        uct_knem_key_t *key, int write,
+                                        uct_completion_t *comp)
 {
     struct knem_cmd_inline_copy icopy;
     struct knem_cmd_param_iovec knem_iov[UCT_SM_MAX_IOV];
     uct_knem_iface_t *knem_iface = ucs_derived_of(tl_ep->iface, uct_knem_iface_t);
     int knem_fd = knem_iface->knem_md->knem_fd;
+    unsigned slot = 0;
     int rc;
     size_t iov_it;
     size_t knem_iov_it = 0;
@@ -73,11 +76,22 @@ static inline ucs_status_t uct_knem_rma(uct_ep_h tl_ep, const uct_iov_t *iov,
 
     icopy.write = write; /* if 0 then, READ from the remote region into my local segments
                           * if 1 then, WRITE to the remote region from my local segment */
-    icopy.flags = 0;     /* TBD: add check and support for KNEM_FLAG_DMA */
+    icopy.flags = 0;
     icopy.current_status = 0;
     icopy.async_status_index = 0;
     icopy.pad = 0;
 
+    /* offload the copy to the DMA engine when it is enabled and a completion
+     * slot is free, so it overlaps with the rest of the worker's work */
+    if ((knem_iface->status_array != NULL) &&
+        (knem_iface->busy_slots != UINT64_MAX)) {
+        slot                           = ucs_ffs64(~knem_iface->busy_slots);
+        icopy.flags                    = KNEM_FLAG_DMA |
+                                         KNEM_FLAG_ASYNCDMACOMPLETE;
+        icopy.async_status_index       = slot;
+        knem_iface->status_array[slot] = KNEM_STATUS_PENDING;
+    }
+
     ucs_assert(knem_fd > -1);
     rc = ioctl(knem_fd, KNEM_CMD_INLINE_COPY, &icopy);
     if (rc < 0) {
@@ -88,9 +102,26 @@ static inline ucs_status_t uct_knem_rma(uct_ep_h tl_ep, const uct_iov_t *iov,
     uct_knem_trace_data(remote_addr, (uintptr_t)key, "%s [length %zu]",
                         write?"PUT_ZCOPY":"GET_ZCOPY",
                         uct_iov_total_length(iov, iovcnt));
+
+    /* the copy was queued - completion is reported through the status array
+     * and picked up by the interface progress */
+    if ((icopy.flags & KNEM_FLAG_ASYNCDMACOMPLETE) &&
+        (icopy.current_status == KNEM_STATUS_PENDING)) {
+        knem_iface->busy_slots |= UCS_BIT(slot);
+        knem_iface->comps[slot] = comp;
+        return UCS_INPROGRESS;
+    }
+
     return UCS_OK;
 }
 
+ucs_status_t uct_knem_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                               uct_completion_t *comp)
+{
+    /* all in-flight copies are tracked on the interface */
+    return uct_knem_iface_flush(tl_ep->iface, flags, comp);
+}
+
 ucs_status_t uct_knem_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t iovcnt,
                                    uint64_t remote_addr, uct_rkey_t rkey,
                                    uct_completion_t *comp)
@@ -100,7 +131,7 @@ ucs_status_t uct_knem_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t
 
     UCT_CHECK_IOV_SIZE(iovcnt, uct_sm_get_max_iov(), "uct_knem_ep_put_zcopy");
 
-    status = uct_knem_rma(tl_ep, iov, iovcnt, remote_addr, key, 1);
+    status = uct_knem_rma(tl_ep, iov, iovcnt, remote_addr, key, 1, comp);
     UCT_TL_EP_STAT_OP_IF_SUCCESS(status, ucs_derived_of(tl_ep, uct_base_ep_t),
                                  PUT, ZCOPY, uct_iov_total_length(iov, iovcnt));
     return status;
@@ -115,7 +146,7 @@ ucs_status_t uct_knem_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t
 
     UCT_CHECK_IOV_SIZE(iovcnt, uct_sm_get_max_iov(), "uct_knem_ep_get_zcopy");
 
-    status = uct_knem_rma(tl_ep, iov, iovcnt, remote_addr, key, 0);
+    status = uct_knem_rma(tl_ep, iov, iovcnt, remote_addr, key, 0, comp);
     UCT_TL_EP_STAT_OP_IF_SUCCESS(status, ucs_derived_of(tl_ep, uct_base_ep_t),
                                  GET, ZCOPY, uct_iov_total_length(iov, iovcnt));
     return status;
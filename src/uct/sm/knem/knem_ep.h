@@ -23,4 +23,6 @@ ucs_status_t uct_knem_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t
 ucs_status_t uct_knem_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t iovcnt,
                                    uint64_t remote_addr, uct_rkey_t rkey,
                                    uct_completion_t *comp);
+ucs_status_t uct_knem_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                               uct_completion_t *comp);
 #endif
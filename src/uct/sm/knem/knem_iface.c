@@ -10,15 +10,31 @@
 
 #include <uct/base/uct_md.h>
 #include <uct/sm/base/sm_iface.h>
+#include <ucs/arch/bitops.h>
 #include <ucs/sys/string.h>
 
 
 UCT_MD_REGISTER_TL(&uct_knem_md_component, &uct_knem_tl);
 
+static ucs_config_field_t uct_knem_iface_config_table[] = {
+    {"", "", NULL,
+     ucs_offsetof(uct_knem_iface_config_t, super),
+     UCS_CONFIG_TYPE_TABLE(uct_iface_config_table)},
+
+    {"DMA_ASYNC", "n",
+     "Offload copies to the kernel DMA engine and complete them asynchronously\n"
+     "from the interface progress, instead of blocking until the copy is done.\n"
+     "Requires DMA engine support in the knem driver.",
+     ucs_offsetof(uct_knem_iface_config_t, dma_async), UCS_CONFIG_TYPE_BOOL},
+
+    {NULL}
+};
+
 static ucs_status_t uct_knem_iface_query(uct_iface_h tl_iface,
                                          uct_iface_attr_t *iface_attr)
 {
     memset(iface_attr, 0, sizeof(uct_iface_attr_t));
+    iface_attr->numa_node = -1;
 
     /* default values for all shared memory transports */
     iface_attr->cap.put.min_zcopy       = 0;
@@ -51,6 +67,55 @@ static ucs_status_t uct_knem_iface_query(uct_iface_h tl_iface,
     return UCS_OK;
 }
 
+/* Reap completed DMA copies and invoke their completions. Runs from the
+ * worker progress while any copy is in flight. */
+static void uct_knem_iface_progress(void *arg)
+{
+    uct_knem_iface_t *iface = arg;
+    uint64_t busy           = iface->busy_slots;
+    knem_status_t knem_status;
+    unsigned slot;
+
+    while (busy != 0) {
+        slot  = ucs_ffs64(busy);
+        busy &= ~UCS_BIT(slot);
+
+        knem_status = iface->status_array[slot];
+        if (knem_status == KNEM_STATUS_PENDING) {
+            continue;
+        }
+
+        if (knem_status != KNEM_STATUS_SUCCESS) {
+            ucs_error("KNEM async copy failed, status %d", knem_status);
+        }
+
+        iface->busy_slots &= ~UCS_BIT(slot);
+        if (iface->comps[slot] != NULL) {
+            uct_invoke_completion(iface->comps[slot],
+                                  (knem_status == KNEM_STATUS_SUCCESS) ?
+                                  UCS_OK : UCS_ERR_IO_ERROR);
+        }
+    }
+}
+
+ucs_status_t uct_knem_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                  uct_completion_t *comp)
+{
+    uct_knem_iface_t *iface = ucs_derived_of(tl_iface, uct_knem_iface_t);
+
+    if (comp != NULL) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    if (iface->busy_slots != 0) {
+        UCT_TL_IFACE_STAT_FLUSH_WAIT(&iface->super);
+        return UCS_INPROGRESS;
+    }
+
+    UCT_TL_IFACE_STAT_FLUSH(&iface->super);
+    return UCS_OK;
+}
+
 static UCS_CLASS_DECLARE_DELETE_FUNC(uct_knem_iface_t, uct_iface_t);
 
 static uct_iface_ops_t uct_knem_iface_ops = {
@@ -60,8 +125,10 @@ static uct_iface_ops_t uct_knem_iface_ops = {
     .iface_get_device_address = uct_sm_iface_get_device_address,
     .iface_is_reachable  = uct_sm_iface_is_reachable,
     .iface_fence         = uct_sm_iface_fence,
+    .iface_flush         = uct_knem_iface_flush,
     .ep_put_zcopy        = uct_knem_ep_put_zcopy,
     .ep_get_zcopy        = uct_knem_ep_get_zcopy,
+    .ep_flush            = uct_knem_ep_flush,
     .ep_fence            = uct_sm_ep_fence,
     .ep_create_connected = UCS_CLASS_NEW_FUNC_NAME(uct_knem_ep_t),
     .ep_destroy          = UCS_CLASS_DELETE_FUNC_NAME(uct_knem_ep_t),
@@ -72,18 +139,60 @@ static UCS_CLASS_INIT_FUNC(uct_knem_iface_t, uct_md_h md, uct_worker_h worker,
                            const uct_iface_params_t *params,
                            const uct_iface_config_t *tl_config)
 {
+    uct_knem_iface_config_t *config = ucs_derived_of(tl_config,
+                                                     uct_knem_iface_config_t);
+    struct knem_cmd_info info;
+    int rc;
+
     UCS_CLASS_CALL_SUPER_INIT(uct_base_iface_t, &uct_knem_iface_ops, md, worker,
                               params, tl_config UCS_STATS_ARG(params->stats_root)
                               UCS_STATS_ARG(UCT_KNEM_TL_NAME));
-    self->knem_md = (uct_knem_md_t *)md;
+    self->knem_md      = (uct_knem_md_t *)md;
+    self->status_array = NULL;
+    self->busy_slots   = 0;
     uct_sm_get_max_iov(); /* to initialize ucs_get_max_iov static variable */
 
+    if (config->dma_async) {
+        memset(&info, 0, sizeof(info));
+        rc = ioctl(self->knem_md->knem_fd, KNEM_CMD_GET_INFO, &info);
+        if ((rc < 0) || !(info.features & KNEM_FEATURE_DMA)) {
+            ucs_debug("KNEM DMA engine is not available, "
+                      "falling back to synchronous copies");
+            return UCS_OK;
+        }
+
+        /* map the driver's completion status array, where the asynchronous
+         * copies report their status */
+        self->status_array = mmap(NULL,
+                                  UCT_KNEM_IFACE_MAX_ASYNC_COPIES *
+                                  sizeof(knem_status_t),
+                                  PROT_READ | PROT_WRITE, MAP_SHARED,
+                                  self->knem_md->knem_fd,
+                                  KNEM_STATUS_ARRAY_FILE_OFFSET);
+        if (self->status_array == MAP_FAILED) {
+            ucs_debug("failed to map the KNEM status array: %m, "
+                      "falling back to synchronous copies");
+            self->status_array = NULL;
+            return UCS_OK;
+        }
+
+        uct_worker_progress_register(worker, uct_knem_iface_progress, self);
+    }
+
     return UCS_OK;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_knem_iface_t)
 {
-    /* No OP */
+    if (self->status_array != NULL) {
+        if (self->busy_slots != 0) {
+            ucs_warn("destroying knem iface %p with copies in flight", self);
+        }
+        uct_worker_progress_unregister(self->super.worker,
+                                       uct_knem_iface_progress, self);
+        munmap((void*)self->status_array,
+               UCT_KNEM_IFACE_MAX_ASYNC_COPIES * sizeof(knem_status_t));
+    }
 }
 
 UCS_CLASS_DEFINE(uct_knem_iface_t, uct_base_iface_t);
@@ -120,6 +229,6 @@ UCT_TL_COMPONENT_DEFINE(uct_knem_tl,
                         uct_knem_query_tl_resources,
                         uct_knem_iface_t,
                         UCT_KNEM_TL_NAME,
-                        "",
-                        uct_iface_config_table,
-                        uct_iface_config_t);
+                        "KNEM_",
+                        uct_knem_iface_config_table,
+                        uct_knem_iface_config_t);
@@ -7,6 +7,8 @@
 #ifndef UCT_KNEM_IFACE_H
 #define UCT_KNEM_IFACE_H
 
+#include <knem_io.h>
+
 #include "knem_md.h"
 
 #include <uct/base/uct_iface.h>
@@ -14,18 +16,33 @@
 
 #define UCT_KNEM_TL_NAME "knem"
 
+/* How many DMA copies can be in flight on an interface. Bounded by the size
+ * of the busy-slot bitmap. */
+#define UCT_KNEM_IFACE_MAX_ASYNC_COPIES  64
+
 
 typedef struct uct_knem_iface_config {
     uct_iface_config_t      super;
+    int                     dma_async;
 } uct_knem_iface_config_t;
 
 
 typedef struct uct_knem_iface {
     uct_base_iface_t        super;
-    uct_knem_md_t        *knem_md;
+    uct_knem_md_t           *knem_md;
+
+    /* Asynchronous DMA copy state. status_array is the driver's completion
+     * status array mapped from the knem fd, NULL when copies are synchronous. */
+    volatile knem_status_t  *status_array;
+    uint64_t                busy_slots;   /* bitmap of slots with a copy in flight */
+    uct_completion_t        *comps[UCT_KNEM_IFACE_MAX_ASYNC_COPIES];
 } uct_knem_iface_t;
 
 
+ucs_status_t uct_knem_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                  uct_completion_t *comp);
+
+
 extern uct_tl_component_t uct_knem_tl;
 
 #endif
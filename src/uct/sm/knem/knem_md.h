@@ -10,18 +10,33 @@
 
 #include <ucs/config/types.h>
 #include <ucs/debug/memtrack.h>
+#include <ucs/sys/rcache.h>
 #include <ucs/type/status.h>
 #include <uct/base/uct_md.h>
 
 extern uct_md_component_t uct_knem_md_component;
 ucs_status_t uct_knem_md_query(uct_md_h md, uct_md_attr_t *md_attr);
 
+/**
+ * @brief KNEM MD configuration
+ */
+typedef struct uct_knem_md_config {
+    uct_md_config_t      super;
+    struct {
+        ucs_ternary_value_t  enable;       /**< Enable registration cache */
+        unsigned             event_prio;   /**< Memory events priority */
+        double               overhead;     /**< Lookup overhead estimation */
+    } rcache;
+} uct_knem_md_config_t;
+
 /**
  * @brief KNEM MD descriptor
  */
 typedef struct uct_knem_md {
-    struct uct_md super; /**< Domain info */
-    int knem_fd;         /**< File descriptor for /dev/knem */
+    struct uct_md       super;    /**< Domain info */
+    int                 knem_fd;  /**< File descriptor for /dev/knem */
+    ucs_rcache_t        *rcache;  /**< Registration cache (can be NULL) */
+    uct_linear_growth_t reg_cost; /**< Cost of memory registration */
 } uct_knem_md_t;
 
 /**
@@ -32,4 +47,12 @@ typedef struct uct_knem_key {
     uintptr_t address; /**< base addr for the registration */
 } uct_knem_key_t;
 
+/**
+ * KNEM memory region in the registration cache
+ */
+typedef struct uct_knem_rcache_region {
+    ucs_rcache_region_t super;
+    uct_knem_key_t      key;      /**< exposed to the user as the memh */
+} uct_knem_rcache_region_t;
+
 #endif
@@ -51,6 +51,7 @@ enum {
 typedef struct uct_mm_md_config {
     uct_md_config_t      super;
     ucs_ternary_value_t  hugetlb_mode;     /* Enable using huge pages */
+    unsigned             seg_pool_size;    /* Freed segments cached per size class */
 } uct_mm_md_config_t;
 
 
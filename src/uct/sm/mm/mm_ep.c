@@ -7,6 +7,8 @@
 
 #include "mm_ep.h"
 
+#include <ucs/arch/cpu.h>
+
 #include <ucs/arch/atomic.h>
 
 SGLIB_DEFINE_LIST_FUNCTIONS(uct_mm_remote_seg_t, uct_mm_remote_seg_compare, next)
@@ -156,6 +158,7 @@ static UCS_CLASS_INIT_FUNC(uct_mm_ep_t, uct_iface_t *tl_iface,
     /* Initiate the hash which will keep the base_adresses of remote memory
      * chunks that hold the descriptors for bcopy. */
     sglib_hashed_uct_mm_remote_seg_t_init(self->remote_segments_hash);
+    self->recent_seg = NULL;
 
     ucs_arbiter_group_init(&self->arb_group);
 
@@ -218,6 +221,14 @@ void *uct_mm_ep_attach_remote_seg(uct_mm_ep_t *ep, uct_mm_iface_t *iface, uct_mm
     uct_mm_remote_seg_t *remote_seg, search;
     ucs_status_t status;
 
+    /* segments stay attached for the lifetime of the ep, so the one the
+     * previous descriptor came from is still valid - check it before
+     * searching the hash */
+    remote_seg = ep->recent_seg;
+    if ((remote_seg != NULL) && (remote_seg->mmid == elem->desc_mmid)) {
+        return remote_seg->address;
+    }
+
     /* take the mmid of the chunk that the desc belongs to, (the desc that the fifo_elem
      * is 'assigned' to), and check if the ep has already attached to it.
      */
@@ -250,28 +261,55 @@ void *uct_mm_ep_attach_remote_seg(uct_mm_ep_t *ep, uct_mm_iface_t *iface, uct_mm
         sglib_hashed_uct_mm_remote_seg_t_add(ep->remote_segments_hash, remote_seg);
     }
 
+    ep->recent_seg = remote_seg;
     return remote_seg->address;
 
 }
 
-static inline ucs_status_t uct_mm_ep_get_remote_elem(uct_mm_ep_t *ep, uint64_t head,
+static inline ucs_status_t uct_mm_ep_get_remote_elem(uct_mm_ep_t *ep, uint64_t *head_p,
                                                      uct_mm_fifo_element_t **elem)
 {
     uct_mm_iface_t *iface = ucs_derived_of(ep->super.super.iface, uct_mm_iface_t);
+    uint64_t head = *head_p;
     uint64_t elem_index;       /* the fifo elem's index in the fifo. */
                                /* must be smaller than fifo size */
     uint64_t returned_val;
 
-    elem_index = ep->fifo_ctl->head & iface->fifo_mask;
-    *elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, elem_index);
+    for (;;) {
+        /* index from the head snapshot - don't touch the contended shared
+         * cacheline again */
+        elem_index = head & iface->fifo_mask;
+        *elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, ep->fifo, elem_index);
+
+        /* try to get ownership of the head element */
+        returned_val = ucs_atomic_cswap64(&ep->fifo_ctl->head, head, head+1);
+        if (returned_val == head) {
+            *head_p = head;
+            return UCS_OK;
+        }
 
-    /* try to get ownership of the head element */
-    returned_val = ucs_atomic_cswap64(&ep->fifo_ctl->head, head, head+1);
-    if (returned_val != head) {
-        return UCS_ERR_NO_RESOURCE;
+        /* another sender took this slot. the cswap returned the current head,
+         * so retry from there instead of failing the send - as long as the
+         * FIFO still has room against the tail we last saw */
+        head = returned_val;
+        if (!UCT_MM_EP_IS_ABLE_TO_SEND(head, ep->cached_tail,
+                                       iface->config.fifo_size)) {
+            return UCS_ERR_NO_RESOURCE;
+        }
     }
+}
 
-    return UCS_OK;
+static UCS_F_NOINLINE void uct_mm_ep_wake_remote(uct_mm_ep_t *ep)
+{
+    /* flip the doorbell back before waking, so that of all the senders which
+     * saw the sleeping state only one pays the futex syscall */
+    if (ucs_atomic_cswap32(&ep->fifo_ctl->signal_state,
+                           UCT_MM_FIFO_SIGNAL_SLEEPING,
+                           UCT_MM_FIFO_SIGNAL_NONE) ==
+        UCT_MM_FIFO_SIGNAL_SLEEPING)
+    {
+        uct_mm_futex_wake(&ep->fifo_ctl->signal_state);
+    }
 }
 
 static inline void uct_mm_ep_update_cached_tail(uct_mm_ep_t *ep)
@@ -315,7 +353,7 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
         }
     }
 
-    status = uct_mm_ep_get_remote_elem(ep, head, &elem);
+    status = uct_mm_ep_get_remote_elem(ep, &head, &elem);
     if (status != UCS_OK) {
         ucs_trace_poll("couldn't get an available FIFO element");
         UCS_STATS_UPDATE_COUNTER(ep->super.stats, UCT_EP_STAT_NO_RES, 1);
@@ -326,7 +364,7 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
         /* AM_SHORT */
         /* write to the remote FIFO */
         *(uint64_t*) (elem + 1) = header;
-        memcpy((void*) (elem + 1) + sizeof(header), payload, length);
+        ucs_memcpy_relaxed((void*) (elem + 1) + sizeof(header), payload, length);
 
         elem->flags |= UCT_MM_FIFO_ELEM_FLAG_INLINE;
         elem->length = length + sizeof(header);
@@ -364,6 +402,15 @@ uct_mm_ep_am_common_send(const unsigned is_short, uct_mm_ep_t *ep, uct_mm_iface_
         elem->flags &= ~UCT_MM_FIFO_ELEM_FLAG_OWNER;
     }
 
+    /* wake the receiver if it published that it may be sleeping. the full
+     * fence orders the element publish against the doorbell read, so either
+     * this sender sees the sleeping state, or the receiver's pre-sleep
+     * recheck sees the new element */
+    ucs_memory_cpu_fence();
+    if (ucs_unlikely(ep->fifo_ctl->signal_state != UCT_MM_FIFO_SIGNAL_NONE)) {
+        uct_mm_ep_wake_remote(ep);
+    }
+
     if (is_short) {
         return UCS_OK;
     } else {
@@ -402,7 +449,8 @@ static inline int uct_mm_ep_has_tx_resources(uct_mm_ep_t *ep)
                                      iface->config.fifo_size);
 }
 
-ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                   unsigned flags)
 {
     uct_mm_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_mm_iface_t);
     uct_mm_ep_t *ep = ucs_derived_of(tl_ep, uct_mm_ep_t);
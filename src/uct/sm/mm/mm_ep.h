@@ -28,6 +28,11 @@ struct uct_mm_ep {
      * (after attaching to them) */
     uct_mm_remote_seg_t  *remote_segments_hash[UCT_MM_BASE_ADDRESS_HASH_SIZE];
 
+    /* the remote segment the last received descriptor belonged to. consecutive
+     * descriptors usually come from the same chunk, so checking it first skips
+     * the hash search on the receive fast path */
+    uct_mm_remote_seg_t  *recent_seg;
+
     ucs_arbiter_group_t  arb_group;   /* the group that holds this ep's pending operations */
 
     /* The cached addrlen and sockaddr is used for a safe
@@ -55,7 +60,8 @@ ssize_t uct_mm_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id, uct_pack_callback_t pack_
 ucs_status_t uct_mm_ep_flush(uct_ep_h tl_ep, unsigned flags,
                              uct_completion_t *comp);
 
-ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n);
+ucs_status_t uct_mm_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                   unsigned flags);
 
 void uct_mm_ep_pending_purge(uct_ep_h ep, uct_pending_purge_callback_t cb,
                              void *arg);
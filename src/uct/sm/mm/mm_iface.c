@@ -25,6 +25,11 @@ static ucs_config_field_t uct_mm_iface_config_table[] = {
      "Size of the receive FIFO in the memory-map UCTs.",
      ucs_offsetof(uct_mm_iface_config_t, fifo_size), UCS_CONFIG_TYPE_UINT},
 
+    {"FIFO_MAX_POLL", "16",
+     "Maximal number of receive completions to pick from the FIFO in a single\n"
+     "progress call.",
+     ucs_offsetof(uct_mm_iface_config_t, fifo_max_poll), UCS_CONFIG_TYPE_UINT},
+
     {"FIFO_RELEASE_FACTOR", "0.5",
      "Frequency of resource releasing on the receiver's side in the MM UCT.\n"
      "This value refers to the percentage of the FIFO size. (must be >= 0 and < 1)",
@@ -80,6 +85,7 @@ static ucs_status_t uct_mm_iface_query(uct_iface_h tl_iface,
 {
     uct_mm_iface_t *iface = ucs_derived_of(tl_iface, uct_mm_iface_t);
     memset(iface_attr, 0, sizeof(uct_iface_attr_t));
+    iface_attr->numa_node = -1;
 
     /* default values for all shared memory transports */
     iface_attr->cap.put.max_short       = UINT_MAX;
@@ -137,6 +143,96 @@ static ucs_status_t uct_mm_iface_query(uct_iface_h tl_iface,
 
 static UCS_CLASS_DECLARE_DELETE_FUNC(uct_mm_iface_t, uct_iface_t);
 
+/* check the owner bit of the next FIFO element to read - same check as the
+ * polling loop */
+static int uct_mm_iface_fifo_has_new_data(uct_mm_iface_t *iface)
+{
+    uct_mm_fifo_element_t *elem =
+        UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements,
+                                   iface->read_index & iface->fifo_mask);
+
+    return ((iface->read_index >> iface->fifo_shift) & 1) == (elem->flags & 1);
+}
+
+static ucs_status_t uct_mm_iface_wakeup_open(uct_iface_h tl_iface,
+                                             unsigned events,
+                                             uct_wakeup_h wakeup)
+{
+    /* the futex doorbell has no file descriptor - wakeup->fd stays -1 */
+    return UCS_OK;
+}
+
+static ucs_status_t uct_mm_iface_wakeup_get_fd(uct_wakeup_h wakeup, int *fd_p)
+{
+    return UCS_ERR_UNSUPPORTED;
+}
+
+static ucs_status_t uct_mm_iface_wakeup_arm(uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(wakeup->iface, uct_mm_iface_t);
+
+    /* publish the sleeping state before rechecking the FIFO. the full fence
+     * pairs with the one on the send path - either a sender sees the doorbell,
+     * or the recheck below sees its element */
+    iface->recv_fifo_ctl->signal_state = UCT_MM_FIFO_SIGNAL_SLEEPING;
+    ucs_memory_cpu_fence();
+
+    if (uct_mm_iface_fifo_has_new_data(iface)) {
+        iface->recv_fifo_ctl->signal_state = UCT_MM_FIFO_SIGNAL_NONE;
+        return UCS_ERR_BUSY;
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t uct_mm_iface_wakeup_wait(uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(wakeup->iface, uct_mm_iface_t);
+    ucs_status_t status;
+    int ret;
+
+    status = wakeup->iface->ops.iface_wakeup_arm(wakeup);
+    if (status == UCS_ERR_BUSY) { /* new data already arrived - don't block */
+        return UCS_OK;
+    } else if (status != UCS_OK) {
+        return status;
+    }
+
+    /* EAGAIN means a sender already flipped the doorbell back - woken */
+    do {
+        ret = uct_mm_futex_wait(&iface->recv_fifo_ctl->signal_state,
+                                UCT_MM_FIFO_SIGNAL_SLEEPING);
+    } while ((ret < 0) && (errno == EINTR));
+
+    iface->recv_fifo_ctl->signal_state = UCT_MM_FIFO_SIGNAL_NONE;
+
+    if ((ret < 0) && (errno != EAGAIN)) {
+        ucs_error("futex wait on mm doorbell failed: %m");
+        return UCS_ERR_IO_ERROR;
+    }
+
+    return UCS_OK;
+}
+
+static ucs_status_t uct_mm_iface_wakeup_signal(uct_wakeup_h wakeup)
+{
+    uct_mm_iface_t *iface = ucs_derived_of(wakeup->iface, uct_mm_iface_t);
+
+    if (ucs_atomic_cswap32(&iface->recv_fifo_ctl->signal_state,
+                           UCT_MM_FIFO_SIGNAL_SLEEPING,
+                           UCT_MM_FIFO_SIGNAL_NONE) ==
+        UCT_MM_FIFO_SIGNAL_SLEEPING)
+    {
+        uct_mm_futex_wake(&iface->recv_fifo_ctl->signal_state);
+    }
+
+    return UCS_OK;
+}
+
+static void uct_mm_iface_wakeup_close(uct_wakeup_h wakeup)
+{
+}
+
 static uct_iface_ops_t uct_mm_iface_ops = {
     .iface_close         = UCS_CLASS_DELETE_FUNC_NAME(uct_mm_iface_t),
     .iface_query         = uct_mm_iface_query,
@@ -145,6 +241,12 @@ static uct_iface_ops_t uct_mm_iface_ops = {
     .iface_is_reachable  = uct_sm_iface_is_reachable,
     .iface_flush         = uct_mm_iface_flush,
     .iface_fence         = uct_sm_iface_fence,
+    .iface_wakeup_open   = uct_mm_iface_wakeup_open,
+    .iface_wakeup_get_fd = uct_mm_iface_wakeup_get_fd,
+    .iface_wakeup_arm    = uct_mm_iface_wakeup_arm,
+    .iface_wakeup_wait   = uct_mm_iface_wakeup_wait,
+    .iface_wakeup_signal = uct_mm_iface_wakeup_signal,
+    .iface_wakeup_close  = uct_mm_iface_wakeup_close,
     .ep_put_short        = uct_sm_ep_put_short,
     .ep_put_bcopy        = uct_sm_ep_put_bcopy,
     .ep_get_bcopy        = uct_sm_ep_get_bcopy,
@@ -234,7 +336,9 @@ static inline void uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
 {
     uint64_t read_index_loc, read_index;
     uct_mm_fifo_element_t* read_index_elem;
+    uct_mm_fifo_element_t* next_elem;
     ucs_status_t status;
+    unsigned count;
 
     /* check the memory pool to make sure that there is a new descriptor available */
     if (ucs_unlikely(iface->last_recv_desc == NULL)) {
@@ -242,23 +346,41 @@ static inline void uct_mm_iface_poll_fifo(uct_mm_iface_t *iface)
                                  iface->last_recv_desc, return);
     }
 
-    read_index = iface->read_index;
-    read_index_loc = (read_index & iface->fifo_mask);
-    /* the fifo_element which the read_index points to */
-    read_index_elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements ,read_index_loc);
-
-    /* check the read_index to see if there is a new item to read (checking the owner bit) */
-    if (((read_index >> iface->fifo_shift) & 1) == ((read_index_elem->flags) & 1)) {
+    /* drain every ready element in one sweep, and publish the tail update
+     * once at the end, so a batch costs a single write-back of the shared
+     * tail cacheline */
+    for (count = 0; count < iface->config.fifo_max_poll; count++) {
+        read_index = iface->read_index;
+        read_index_loc = (read_index & iface->fifo_mask);
+        /* the fifo_element which the read_index points to */
+        read_index_elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements ,read_index_loc);
+
+        /* check the read_index to see if there is a new item to read (checking the owner bit) */
+        if (((read_index >> iface->fifo_shift) & 1) != ((read_index_elem->flags) & 1)) {
+            break;
+        }
 
         /* read from read_index_elem */
         ucs_memory_cpu_load_fence();
         ucs_assert(iface->read_index <= iface->recv_fifo_ctl->head);
 
+        /* pull the next element into cache while handling the current one */
+        next_elem = UCT_MM_IFACE_GET_FIFO_ELEM(iface, iface->recv_fifo_elements,
+                                               (read_index + 1) & iface->fifo_mask);
+        ucs_prefetch(next_elem);
+
         status = uct_mm_iface_process_recv(iface, read_index_elem);
         if (status != UCS_OK) {
             /* the last_recv_desc is in use. get a new descriptor for it */
             UCT_TL_IFACE_GET_RX_DESC(&iface->super, &iface->recv_desc_mp,
-                                     iface->last_recv_desc, ucs_debug("recv mpool is empty"));
+                                     iface->last_recv_desc,
+                                     {
+                                         /* no more descriptors - stop the
+                                          * sweep, the entry check will refill */
+                                         ucs_debug("recv mpool is empty");
+                                         iface->read_index++;
+                                         break;
+                                     });
         }
 
         /* raise the read_index. */
@@ -279,6 +401,15 @@ void uct_mm_iface_progress(void *arg)
     ucs_arbiter_dispatch(&iface->arbiter, 1, uct_mm_ep_process_pending, NULL);
 }
 
+static void uct_mm_iface_bind_chunk_numa(uct_mm_seg_t *seg)
+{
+    int numa_node = ucs_sys_get_numa_node();
+
+    if (numa_node >= 0) {
+        ucs_sys_bind_numa(seg->address, seg->length, numa_node);
+    }
+}
+
 void uct_mm_iface_recv_desc_init(uct_iface_h tl_iface, void *obj, uct_mem_h memh)
 {
     uct_mm_recv_desc_t *desc = obj;
@@ -289,6 +420,10 @@ void uct_mm_iface_recv_desc_init(uct_iface_h tl_iface, void *obj, uct_mem_h memh
     desc->key          = seg->mmid;
     desc->base_address = seg->address;
     desc->mpool_length = seg->length;
+
+    /* keep the bounce buffers on the receiver's NUMA node as well. the call is
+     * idempotent per chunk, and this is an allocation-time-only path */
+    uct_mm_iface_bind_chunk_numa(seg);
 }
 
 static void uct_mm_iface_free_rx_descs(uct_mm_iface_t *iface, unsigned num_elems)
@@ -310,6 +445,7 @@ ucs_status_t uct_mm_allocate_fifo_mem(uct_mm_iface_t *iface,
     uct_mm_fifo_ctl_t *ctl;
     size_t size_to_alloc;
     ucs_status_t status;
+    int numa_node;
 
     /* allocate the receive FIFO */
     size_to_alloc = UCT_MM_GET_FIFO_SIZE(iface);
@@ -323,6 +459,14 @@ ucs_status_t uct_mm_allocate_fifo_mem(uct_mm_iface_t *iface,
         return status;
     }
 
+    /* prefer placing the FIFO on the NUMA node of the polling thread, before
+     * any page of it is faulted in. the senders write it remotely either way,
+     * while the receiver reads every element from the progress loop */
+    numa_node = ucs_sys_get_numa_node();
+    if (numa_node >= 0) {
+        ucs_sys_bind_numa(iface->shared_mem, size_to_alloc, numa_node);
+    }
+
     ctl = uct_mm_set_fifo_ctl(iface->shared_mem);
     uct_mm_set_fifo_elems_ptr(iface->shared_mem, &iface->recv_fifo_elements);
 
@@ -425,8 +569,9 @@ static void uct_mm_iface_singal_handler(int fd, void *arg)
 
 static void uct_mm_iface_init_dummy_fifo_ctl(uct_mm_iface_t *iface)
 {
-    iface->dummy_fifo_ctl.head = iface->config.fifo_size;
-    iface->dummy_fifo_ctl.tail = 0;
+    iface->dummy_fifo_ctl.head         = iface->config.fifo_size;
+    iface->dummy_fifo_ctl.tail         = 0;
+    iface->dummy_fifo_ctl.signal_state = UCT_MM_FIFO_SIGNAL_NONE;
 }
 
 static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
@@ -469,6 +614,7 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
 
     self->config.fifo_size         = mm_config->fifo_size;
     self->config.fifo_elem_size    = mm_config->super.max_short;
+    self->config.fifo_max_poll     = ucs_max(1, mm_config->fifo_max_poll);
     self->config.seg_size          = mm_config->super.max_bcopy;
     self->fifo_release_factor_mask = UCS_MASK(ucs_ilog2(ucs_max((int)
                                      (mm_config->fifo_size * mm_config->release_fifo_factor),
@@ -486,9 +632,10 @@ static UCS_CLASS_INIT_FUNC(uct_mm_iface_t, uct_md_h md, uct_worker_h worker,
         goto err;
     }
 
-    self->recv_fifo_ctl->head   = 0;
-    self->recv_fifo_ctl->tail   = 0;
-    self->read_index            = 0;
+    self->recv_fifo_ctl->head         = 0;
+    self->recv_fifo_ctl->tail         = 0;
+    self->recv_fifo_ctl->signal_state = UCT_MM_FIFO_SIGNAL_NONE;
+    self->read_index                  = 0;
 
     status = uct_mm_iface_create_signal_fd(self);
     if (status != UCS_OK) {
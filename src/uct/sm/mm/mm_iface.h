@@ -17,7 +17,9 @@
 #include <ucs/datastruct/arbiter.h>
 #include <ucs/sys/compiler.h>
 #include <ucs/sys/sys.h>
+#include <linux/futex.h>
 #include <sys/shm.h>
+#include <sys/syscall.h>
 #include <sys/un.h>
 
 
@@ -35,9 +37,20 @@ typedef enum {
 } uct_mm_iface_conn_signal_t;
 
 
+/* Receiver-published doorbell state, embedded in the shared FIFO ctl */
+enum {
+    UCT_MM_FIFO_SIGNAL_NONE     = 0, /* receiver is polling - senders need
+                                        no syscall */
+    UCT_MM_FIFO_SIGNAL_SLEEPING = 1  /* receiver may be blocked in futex
+                                        wait on the doorbell word */
+};
+
+
 typedef struct uct_mm_iface_config {
     uct_iface_config_t       super;
     unsigned                 fifo_size;            /* Size of the receive FIFO */
+    unsigned                 fifo_max_poll;        /* Maximal RX completions to pick
+                                                      in a single progress call */
     double                   release_fifo_factor;
     ucs_ternary_value_t      hugetlb_mode;         /* Enable using huge pages for */
                                                    /* shared memory buffers */
@@ -53,7 +66,8 @@ struct uct_mm_fifo_ctl {
     UCS_CACHELINE_PADDING(uint64_t, socklen_t, struct sockaddr_un);
 
     /* 2nd cacheline */
-    volatile uint64_t  tail;       /* how much was read */
+    volatile uint64_t  tail;          /* how much was read */
+    volatile uint32_t  signal_state;  /* doorbell - UCT_MM_FIFO_SIGNAL_* */
 } UCS_S_PACKED;
 
 
@@ -95,6 +109,7 @@ struct uct_mm_iface {
     struct {
         unsigned fifo_size;
         unsigned fifo_elem_size;
+        unsigned fifo_max_poll;
         unsigned seg_size;                    /* size of the receive descriptor (for payload)*/
     } config;
 };
@@ -144,6 +159,19 @@ uct_mm_iface_invoke_am(uct_mm_iface_t *iface, uint8_t am_id, void *data,
 }
 
 
+/* The doorbell word lives in shared memory, so the non-private futex ops
+ * (the cross-process variant) are used on it */
+static inline int uct_mm_futex_wait(volatile uint32_t *addr, uint32_t value)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAIT, value, NULL, NULL, 0);
+}
+
+static inline int uct_mm_futex_wake(volatile uint32_t *addr)
+{
+    return syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+
 static uct_mm_fifo_ctl_t* uct_mm_set_fifo_ctl(void *mem_region)
 {
     return (uct_mm_fifo_ctl_t*) ucs_align_up_pow2
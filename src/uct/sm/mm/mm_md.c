@@ -7,6 +7,9 @@
 
 #include "mm_md.h"
 
+#include <ucs/arch/bitops.h>
+#include <ucs/sys/math.h>
+
 ucs_config_field_t uct_mm_md_config_table[] = {
   {"", "", NULL,
    ucs_offsetof(uct_mm_md_config_t, super), UCS_CONFIG_TYPE_TABLE(uct_md_config_table)},
@@ -19,21 +22,92 @@ ucs_config_field_t uct_mm_md_config_table[] = {
    " try - Try to allocate memory using huge pages and if it fails, allocate regular pages.\n",
    ucs_offsetof(uct_mm_md_config_t, hugetlb_mode), UCS_CONFIG_TYPE_TERNARY},
 
+  {"SEG_POOL_SIZE", "8",
+   "Maximal number of freed shared memory segments to cache per size class for\n"
+   "reuse by subsequent allocations. Reusing a segment skips the creation and\n"
+   "mapping system calls, and remote peers which already attached it skip the\n"
+   "attach as well. 0 - disable segment caching.",
+   ucs_offsetof(uct_mm_md_config_t, seg_pool_size), UCS_CONFIG_TYPE_UINT},
+
   {NULL}
 };
 
+/* Index of the segment pool free list a segment of the given length is filed
+ * under. Class c holds segments of at least 2^c bytes, so any segment found
+ * there satisfies a request whose rounded-up class is c. */
+static UCS_F_ALWAYS_INLINE unsigned uct_mm_seg_pool_class(size_t length)
+{
+    return ucs_ilog2(length);
+}
+
+static uct_mm_seg_t *uct_mm_seg_pool_get(uct_mm_md_t *mm_md, size_t length)
+{
+    unsigned cls;
+
+    if ((mm_md->config->seg_pool_size == 0) || (length <= 1)) {
+        return NULL;
+    }
+
+    /* smallest class whose segments are large enough for the request */
+    cls = uct_mm_seg_pool_class(length - 1) + 1;
+    if ((cls >= UCT_MM_SEG_POOL_NUM_CLASSES) ||
+        ucs_list_is_empty(&mm_md->seg_pool[cls].list)) {
+        return NULL;
+    }
+
+    --mm_md->seg_pool[cls].count;
+    return ucs_list_extract_head(&mm_md->seg_pool[cls].list, uct_mm_seg_t, list);
+}
+
+static int uct_mm_seg_pool_put(uct_mm_md_t *mm_md, uct_mm_seg_t *seg)
+{
+    unsigned cls;
+
+    if ((mm_md->config->seg_pool_size == 0) || (seg->length == 0)) {
+        return 0;
+    }
+
+    cls = uct_mm_seg_pool_class(seg->length);
+    if ((cls >= UCT_MM_SEG_POOL_NUM_CLASSES) ||
+        (mm_md->seg_pool[cls].count >= mm_md->config->seg_pool_size)) {
+        return 0;
+    }
+
+    ucs_list_add_head(&mm_md->seg_pool[cls].list, &seg->list);
+    ++mm_md->seg_pool[cls].count;
+    return 1;
+}
+
 ucs_status_t uct_mm_mem_alloc(uct_md_h md, size_t *length_p, void **address_p,
                               unsigned flags, uct_mem_h *memh_p UCS_MEMTRACK_ARG)
 {
+    uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
     ucs_status_t status;
     uct_mm_seg_t *seg;
 
+    seg = uct_mm_seg_pool_get(mm_md, *length_p);
+    if (seg != NULL) {
+        *length_p  = seg->length;
+        *address_p = seg->address;
+        *memh_p    = seg;
+        ucs_trace("mm reused pooled segment address %p length %zu mmid %"PRIu64,
+                  *address_p, seg->length, seg->mmid);
+        return UCS_OK;
+    }
+
     seg = ucs_calloc(1, sizeof(*seg), "mm_seg");
     if (NULL == seg) {
         ucs_error("Failed to allocate memory for mm segment");
         return UCS_ERR_NO_MEMORY;
     }
 
+    /* Round the length up to the size class, so the segment can serve any
+     * request of its class when it comes back from the pool */
+    if ((mm_md->config->seg_pool_size > 0) && (*length_p > 1) &&
+        (uct_mm_seg_pool_class(*length_p - 1) + 1 < UCT_MM_SEG_POOL_NUM_CLASSES)) {
+        *length_p = UCS_BIT(uct_mm_seg_pool_class(*length_p - 1) + 1);
+    }
+
     status = uct_mm_md_mapper_ops(md)->alloc(md, length_p, UCS_TRY, &seg->address,
                                              &seg->mmid, &seg->path
                                              UCS_MEMTRACK_VAL);
@@ -53,9 +127,14 @@ ucs_status_t uct_mm_mem_alloc(uct_md_h md, size_t *length_p, void **address_p,
 
 ucs_status_t uct_mm_mem_free(uct_md_h md, uct_mem_h memh)
 {
-    uct_mm_seg_t *seg = memh;
+    uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
+    uct_mm_seg_t *seg  = memh;
     ucs_status_t status;
 
+    if (uct_mm_seg_pool_put(mm_md, seg)) {
+        return UCS_OK;
+    }
+
     status = uct_mm_md_mapper_ops(md)->free(seg->address, seg->mmid, seg->length,
                                             seg->path);
     if (status != UCS_OK) {
@@ -120,6 +199,7 @@ ucs_status_t uct_mm_md_query(uct_md_h md, uct_md_attr_t *md_attr)
         md_attr->reg_cost.growth   = 0.007e-9;
     }
     md_attr->cap.flags        |= UCT_MD_FLAG_NEED_RKEY;
+    md_attr->cap.flags        |= UCT_MD_FLAG_RKEY_PTR;
     md_attr->cap.max_alloc    = ULONG_MAX;
     md_attr->cap.max_reg      = 0;
     md_attr->rkey_packed_size = sizeof(uct_mm_packed_rkey_t) +
@@ -181,6 +261,23 @@ ucs_status_t uct_mm_rkey_unpack(uct_md_component_t *mdc, const void *rkey_buffer
     return UCS_OK;
 }
 
+ucs_status_t uct_mm_rkey_ptr(uct_md_component_t *mdc, uct_rkey_t rkey, void *handle,
+                             uint64_t raddr, void **laddr_p)
+{
+    uct_mm_remote_seg_t *mm_desc = handle;
+
+    /* rkey stores the offset from the remote VA to the local VA of the
+     * attached segment, so adding it to the remote address gives a pointer
+     * which is directly usable for loads and stores */
+    if ((raddr < (uintptr_t)mm_desc->address - rkey) ||
+        (raddr > (uintptr_t)mm_desc->address - rkey + mm_desc->length)) {
+        return UCS_ERR_INVALID_ADDR;
+    }
+
+    *laddr_p = (void *)(rkey + raddr);
+    return UCS_OK;
+}
+
 ucs_status_t uct_mm_rkey_release(uct_md_component_t *mdc, uct_rkey_t rkey, void *handle)
 {
     ucs_status_t status;
@@ -194,6 +291,23 @@ ucs_status_t uct_mm_rkey_release(uct_md_component_t *mdc, uct_rkey_t rkey, void
 static void uct_mm_md_close(uct_md_h md)
 {
     uct_mm_md_t *mm_md = ucs_derived_of(md, uct_mm_md_t);
+    uct_mm_seg_t *seg;
+    ucs_status_t status;
+    unsigned cls;
+
+    for (cls = 0; cls < UCT_MM_SEG_POOL_NUM_CLASSES; ++cls) {
+        while (!ucs_list_is_empty(&mm_md->seg_pool[cls].list)) {
+            seg    = ucs_list_extract_head(&mm_md->seg_pool[cls].list,
+                                           uct_mm_seg_t, list);
+            status = uct_mm_md_mapper_ops(md)->free(seg->address, seg->mmid,
+                                                    seg->length, seg->path);
+            if (status != UCS_OK) {
+                ucs_warn("failed to release pooled mm segment mmid %"PRIu64": %s",
+                         seg->mmid, ucs_status_string(status));
+            }
+            ucs_free(seg);
+        }
+    }
 
     ucs_config_parser_release_opts(mm_md->config, md->component->md_config_table);
     ucs_free(mm_md->config);
@@ -215,6 +329,7 @@ ucs_status_t uct_mm_md_open(const char *md_name, const uct_md_config_t *md_confi
 {
     uct_mm_md_t *mm_md;
     ucs_status_t status;
+    unsigned cls;
 
     mm_md = ucs_malloc(sizeof(*mm_md), "uct_mm_md_t");
     if (mm_md == NULL) {
@@ -237,6 +352,11 @@ ucs_status_t uct_mm_md_open(const char *md_name, const uct_md_config_t *md_confi
         goto err_free_mm_md_config;
     }
 
+    for (cls = 0; cls < UCT_MM_SEG_POOL_NUM_CLASSES; ++cls) {
+        ucs_list_head_init(&mm_md->seg_pool[cls].list);
+        mm_md->seg_pool[cls].count = 0;
+    }
+
     mm_md->super.ops = &uct_mm_md_ops;
     mm_md->super.component = mdc;
 
@@ -12,10 +12,15 @@
 
 #include <uct/base/uct_md.h>
 #include <ucs/config/types.h>
+#include <ucs/datastruct/list.h>
 #include <ucs/debug/memtrack.h>
 #include <ucs/type/status.h>
 
 
+/* Number of size classes in the segment pool - one per power of two */
+#define UCT_MM_SEG_POOL_NUM_CLASSES  64
+
+
 /* Shared memory ID */
 typedef uint64_t uct_mm_id_t;
 
@@ -106,6 +111,7 @@ typedef struct uct_mm_mapper_ops {
     UCT_MD_COMPONENT_DEFINE(_var, _name, \
                             _var##_query_md_resources, _var##_md_open, _ops, \
                             uct_mm_rkey_unpack, \
+                            uct_mm_rkey_ptr, \
                             uct_mm_rkey_release, _cfg_prefix, _prefix##_md_config_table, \
                             _prefix##_md_config_t)
 
@@ -118,6 +124,7 @@ typedef struct uct_mm_seg {
     void             *address;  /* Virtual address */
     size_t           length;    /* Size of the memory */
     const char      *path;      /* path to the backing file when using posix */
+    ucs_list_link_t  list;      /* entry in the md segment pool */
 } uct_mm_seg_t;
 
 
@@ -138,6 +145,15 @@ typedef struct uct_mm_packed_rkey {
 typedef struct uct_mm_md {
     uct_md_t           super;
     uct_mm_md_config_t *config;
+
+    /* Pool of freed segments kept mapped for reuse, one free list per
+     * power-of-two size class. Reusing a segment skips the creation and
+     * attach syscalls, and keeps its mmid, so remote peers which already
+     * attached it skip their attach as well. */
+    struct {
+        ucs_list_link_t list;
+        unsigned        count;
+    } seg_pool[UCT_MM_SEG_POOL_NUM_CLASSES];
 } uct_mm_md_t;
 
 
@@ -158,6 +174,9 @@ ucs_status_t uct_mm_mkey_pack(uct_md_h md, uct_mem_h memh, void *rkey_buffer);
 ucs_status_t uct_mm_rkey_unpack(uct_md_component_t *mdc, const void *rkey_buffer,
                                 uct_rkey_t *rkey_p, void **handle_p);
 
+ucs_status_t uct_mm_rkey_ptr(uct_md_component_t *mdc, uct_rkey_t rkey, void *handle,
+                             uint64_t raddr, void **laddr_p);
+
 ucs_status_t uct_mm_rkey_release(uct_md_component_t *mdc, uct_rkey_t rkey, void *handle);
 
 ucs_status_t uct_mm_md_open(const char *md_name, const uct_md_config_t *md_config,
@@ -254,6 +254,7 @@ uct_posix_alloc(uct_md_h md, size_t *length_p, ucs_ternary_value_t hugetlb,
                 UCS_MEMTRACK_ARG)
 {
     ucs_status_t status;
+    ucs_sys_alloc_attr_t attr;
     int shm_fd = -1;
     uint64_t uuid;
     char *file_name;
@@ -375,6 +376,13 @@ err:
     return status;
 
 out_ok:
+    /* Fault the segment in now, so the first FIFO accesses and bounce buffer
+     * copies do not take page faults */
+    attr.thp       = !(uuid & UCT_MM_POSIX_HUGETLB);
+    attr.prefault  = 1;
+    attr.numa_node = -1;
+    ucs_sys_alloc_apply_attr(*address_p, *length_p, &attr);
+
     ucs_free(file_name);
     if (!posix_config->use_proc_link) {
         /* closing the shm_fd here won't unmap the mem region*/
@@ -30,9 +30,13 @@ uct_sysv_alloc(uct_md_h md, size_t *length_p, ucs_ternary_value_t hugetlb,
                void **address_p, uct_mm_id_t *mmid_p, const char **path_p UCS_MEMTRACK_ARG)
 {
     ucs_status_t status = UCS_ERR_NO_MEMORY;
+    ucs_sys_alloc_attr_t attr;
     int flags, shmid = 0;
 
-    flags = UCT_MM_SYSV_MSTR;
+    attr.thp       = 0;
+    attr.prefault  = 1;
+    attr.numa_node = -1;
+    flags          = UCT_MM_SYSV_MSTR;
     *address_p = NULL;
 
     if (0 == *length_p) {
@@ -54,6 +58,7 @@ uct_sysv_alloc(uct_md_h md, size_t *length_p, ucs_ternary_value_t hugetlb,
     if (hugetlb != UCS_YES) {
         status = ucs_sysv_alloc(length_p, address_p, flags , &shmid UCS_MEMTRACK_VAL);
         if (status == UCS_OK) {
+            attr.thp = 1;
             goto out_ok;
         }
 
@@ -64,6 +69,9 @@ err:
     ucs_fatal("failed to allocate %zu bytes with mm", *length_p);
 
 out_ok:
+    /* Fault the segment in now, so the first FIFO accesses and bounce buffer
+     * copies do not take page faults */
+    ucs_sys_alloc_apply_attr(*address_p, *length_p, &attr);
     *mmid_p = shmid;
     return UCS_OK;
 }
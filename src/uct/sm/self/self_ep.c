@@ -55,6 +55,33 @@ ucs_status_t uct_self_ep_am_short(uct_ep_h tl_ep, uint8_t id, uint64_t header,
     /* Send part */
     UCT_CHECK_AM_ID(id);
     UCT_CHECK_LENGTH(total_length, 0, self_iface->data_length, "am_short");
+
+    /* The handler consumes the message during the call, so deliver it from a
+     * bounce slot without the descriptor flag - the descriptor pool is not
+     * touched at all. Fall back to a descriptor when the handlers nest deeper
+     * than the available slots (a handler sending another loop-back message).
+     */
+    if (ucs_likely(self_iface->bounce_depth < UCT_SELF_IFACE_NUM_BOUNCE_BUFS)) {
+        p_data = self_iface->bounce_bufs +
+                 (self_iface->bounce_depth * self_iface->data_length);
+        *(typeof(header)*) p_data = header;
+        memcpy(p_data + sizeof(header), payload, length);
+
+        UCT_TL_EP_STAT_OP(&self_ep->super, AM, SHORT, total_length);
+        uct_iface_trace_am(&self_iface->super, UCT_AM_TRACE_TYPE_SEND, id,
+                           p_data, total_length, "TX: AM_SHORT");
+
+        /* Receive part */
+        uct_iface_trace_am(&self_iface->super, UCT_AM_TRACE_TYPE_RECV, id,
+                           p_data, total_length, "RX: AM_SHORT");
+        ++self_iface->bounce_depth;
+        status = uct_iface_invoke_am(&self_iface->super, id, p_data,
+                                     total_length, 0);
+        --self_iface->bounce_depth;
+        ucs_assert(status != UCS_INPROGRESS);
+        return status;
+    }
+
     if (ucs_unlikely(NULL == self_iface->msg_cur_desc)) {
         UCT_TL_IFACE_GET_TX_DESC(&self_iface->super, &self_iface->msg_desc_mp,
                                  self_iface->msg_cur_desc, return UCS_ERR_NO_MEMORY);
@@ -29,6 +29,7 @@ static ucs_status_t uct_self_iface_query(uct_iface_h iface, uct_iface_attr_t *at
 
     ucs_trace_func("iface=%p", iface);
     memset(attr, 0, sizeof(*attr));
+    attr->numa_node = -1;
 
     attr->iface_addr_len         = sizeof(uct_self_iface_addr_t);
     attr->device_addr_len        = 0;
@@ -196,10 +197,25 @@ static UCS_CLASS_INIT_FUNC(uct_self_iface_t, uct_md_h md, uct_worker_h worker,
         goto destroy_mpool;
     }
 
+    /* short messages are delivered from these slots without touching the
+     * descriptor pool, since the handler consumes them during the call */
+    self->bounce_bufs = ucs_memalign(UCS_SYS_CACHE_LINE_SIZE,
+                                     UCT_SELF_IFACE_NUM_BOUNCE_BUFS *
+                                     self->data_length,
+                                     "self_bounce_bufs");
+    if (NULL == self->bounce_bufs) {
+        ucs_error("Failed to allocate the loop-back bounce buffers");
+        status = UCS_ERR_NO_MEMORY;
+        goto put_desc;
+    }
+    self->bounce_depth = 0;
+
     ucs_debug("Created a loop-back iface. id=0x%lx, desc=%p, len=%u, tx_hdr=%lu",
               self->id, self->msg_cur_desc, self->data_length, self->rx_headroom);
     return UCS_OK;
 
+put_desc:
+    ucs_mpool_put(self->msg_cur_desc);
 destroy_mpool:
     ucs_mpool_cleanup(&self->msg_desc_mp, 1);
 err:
@@ -210,6 +226,7 @@ static UCS_CLASS_CLEANUP_FUNC(uct_self_iface_t)
 {
     ucs_trace_func("self=%p", self);
 
+    ucs_free(self->bounce_bufs);
     if (self->msg_cur_desc) {
         ucs_mpool_put(self->msg_cur_desc);
     }
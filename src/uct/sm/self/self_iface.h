@@ -12,6 +12,11 @@
 
 typedef uint64_t uct_self_iface_addr_t;
 
+/* How many short messages can be delivered from the bounce slots at the same
+ * time. Depth above one happens only when an active message handler sends
+ * another loop-back message from within the callback. */
+#define UCT_SELF_IFACE_NUM_BOUNCE_BUFS  2
+
 typedef struct uct_self_iface {
     uct_base_iface_t      super;
     uct_self_iface_addr_t id;           /* Unique identifier for the instance */
@@ -20,6 +25,10 @@ typedef struct uct_self_iface {
     uct_recv_desc_t       *msg_cur_desc; /* Current message descriptor to use */
     uct_recv_desc_t       release_desc; /* Callback to desc release func */
     ucs_mpool_t           msg_desc_mp;  /* Messages memory pool */
+    void                  *bounce_bufs; /* Cache-aligned slots for delivering
+                                           short messages without a descriptor */
+    unsigned              bounce_depth; /* Slots busy with a delivery currently
+                                           on the stack */
 } UCS_V_ALIGNED(UCS_SYS_CACHE_LINE_SIZE) uct_self_iface_t;
 
 typedef struct uct_self_iface_config {
@@ -9,7 +9,9 @@
 static ucs_status_t uct_self_md_query(uct_md_h md, uct_md_attr_t *attr)
 {
     /* Dummy memory registration provided. No real memory handling exists */
-    attr->cap.flags         = UCT_MD_FLAG_REG;
+    attr->cap.flags         = UCT_MD_FLAG_REG |
+                              UCT_MD_FLAG_RKEY_PTR; /* same process - remote
+                                                       addresses are local */
     attr->cap.max_alloc     = 0;
     attr->cap.max_reg       = ULONG_MAX;
     attr->rkey_packed_size  = 0; /* uct_md_query adds UCT_MD_COMPONENT_NAME_MAX to this */
@@ -64,9 +66,19 @@ static ucs_status_t uct_self_md_rkey_unpack(uct_md_component_t *mdc,
     return UCS_OK;
 }
 
+static ucs_status_t uct_self_md_rkey_ptr(uct_md_component_t *mdc, uct_rkey_t rkey,
+                                         void *handle, uint64_t raddr,
+                                         void **laddr_p)
+{
+    /* rkey == 0 - the remote address is directly usable */
+    *laddr_p = (void*)raddr;
+    return UCS_OK;
+}
+
 UCT_MD_COMPONENT_DEFINE(uct_self_md, UCT_SELF_NAME,
                         uct_self_query_md_resources, uct_self_md_open, NULL,
                         uct_self_md_rkey_unpack,
+                        uct_self_md_rkey_ptr,
                         ucs_empty_function_return_success, "SELF_",
                         uct_md_config_table, uct_md_config_t);
 
@@ -8,10 +8,26 @@
 
 #include <uct/base/uct_md.h>
 #include <ucs/datastruct/khash.h>
+#include <ucs/datastruct/queue.h>
 #include <net/if.h>
 
 #define UCT_TCP_NAME "tcp"
 
+/* Maximal number of payload entries in a zcopy send */
+#define UCT_TCP_MAX_IOV      8ul
+
+/* Maximal number of parallel streams per endpoint */
+#define UCT_TCP_MAX_STREAMS  16
+
+/* Zero-copy transmission, linux 4.14 and above. The values are defined here
+ * for older libc headers which do not carry them yet. */
+#ifndef SO_ZEROCOPY
+#  define SO_ZEROCOPY    60
+#endif
+#ifndef MSG_ZEROCOPY
+#  define MSG_ZEROCOPY   0x4000000
+#endif
+
 
 /** Hash of fd->rsock */
 typedef struct uct_tcp_recv_sock uct_tcp_recv_sock_t;
@@ -19,11 +35,64 @@ KHASH_MAP_INIT_INT64(uct_tcp_fd_hash, uct_tcp_recv_sock_t*);
 
 
 /**
- * TCP endpoint
+ * TCP active message header
+ */
+typedef struct uct_tcp_am_hdr {
+    uint8_t                       am_id;          /* Active message id */
+    uint32_t                      length;         /* Payload length */
+} UCS_S_PACKED uct_tcp_am_hdr_t;
+
+
+/**
+ * Completion of an in-flight zero-copy send. The kernel releases the user
+ * pages in send order, and reports it on the socket error queue with the
+ * sequence number of the send.
+ */
+typedef struct uct_tcp_zcopy_comp {
+    ucs_queue_elem_t              queue;          /* On the ep completion queue */
+    uint32_t                      seq;            /* Sequence number of the send */
+    uct_completion_t              *comp;          /* User completion, may be NULL */
+} uct_tcp_zcopy_comp_t;
+
+
+/**
+ * One stream of a TCP endpoint - a connected socket with its own zero-copy
+ * completion tracking, since the kernel numbers the zero-copy sends per
+ * socket.
+ */
+typedef struct uct_tcp_ep_stream {
+    int                           fd;             /* Socket file descriptor */
+    uint32_t                      zcopy_seq;      /* Next zero-copy send number */
+    ucs_queue_head_t              zcopy_comps;    /* In-flight zero-copy sends */
+} uct_tcp_ep_stream_t;
+
+
+/**
+ * TCP endpoint. Small messages always go out on stream 0, so they stay
+ * ordered; large (zcopy) messages are striped over the remaining streams to
+ * aggregate bandwidth past the per-flow limits of the fabric.
  */
 typedef struct uct_tcp_ep {
     uct_base_ep_t                 super;
-    int                           fd;             /* Socket file descriptor */
+    uct_tcp_ep_stream_t           streams[UCT_TCP_MAX_STREAMS];
+    unsigned                      num_streams;    /* Connected streams */
+    unsigned                      stripe_count;   /* Round-robin position of the
+                                                     large-message striping */
+    unsigned                      zcopy_inflight; /* Zero-copy sends in flight
+                                                     on all streams */
+    void                          *tx_buf;        /* Staging buffer for data which
+                                                     did not fit in the socket
+                                                     buffer, NULL when idle */
+    size_t                        tx_offset;      /* Bytes of tx_buf already sent */
+    size_t                        tx_length;      /* Bytes staged in tx_buf */
+    unsigned                      tx_stream;      /* Stream whose socket drains
+                                                     tx_buf */
+    ucs_queue_elem_t              tx_queue;       /* On the interface queue of
+                                                     endpoints with staged data */
+    int                           zcopy_enabled;  /* SO_ZEROCOPY is set on fds */
+    ucs_queue_elem_t              zcopy_queue;    /* On the interface queue of
+                                                     endpoints with in-flight
+                                                     zero-copy sends */
 } uct_tcp_ep_t;
 
 
@@ -34,13 +103,24 @@ typedef struct uct_tcp_iface {
     uct_base_iface_t              super;          /* Parent class */
     ucs_mpool_t                   mp;             /* Memory pool for TX/RX buffers */
     int                           listen_fd;      /* Server socket */
+    int                           epfd;           /* Epoll set of all receive sockets */
     khash_t(uct_tcp_fd_hash)      fd_hash;        /* Hash table of all FDs */
+    ucs_queue_head_t              tx_eps;         /* Endpoints with staged data
+                                                     waiting for the socket to
+                                                     drain */
+    ucs_queue_head_t              zcopy_eps;      /* Endpoints with in-flight
+                                                     zero-copy sends */
     char                          if_name[IFNAMSIZ];/* Network interface name */
 
     struct {
         struct sockaddr_in        ifaddr;         /* Network address */
         struct sockaddr_in        netmask;        /* Network address mask */
         size_t                    max_bcopy;      /* Maximal bcopy size */
+        size_t                    buf_size;       /* Staging buffer size; each
+                                                     recv() fills up to this
+                                                     many bytes, holding several
+                                                     messages */
+        unsigned                  num_streams;    /* Sockets per endpoint */
         int                       prefer_default; /* prefer default gateway */
         ptrdiff_t                 am_hdr_offset;  /* offset to receive header */
         ptrdiff_t                 headroom_offset;/* offset to receive headroom */
@@ -48,6 +128,7 @@ typedef struct uct_tcp_iface {
 
     struct {
         int                       nodelay;        /* TCP_NODELAY */
+        int                       zcopy;          /* SO_ZEROCOPY */
     } sockopt;
 } uct_tcp_iface_t;
 
@@ -57,9 +138,12 @@ typedef struct uct_tcp_iface {
  */
 typedef struct uct_tcp_iface_config {
     uct_iface_config_t            super;
+    size_t                        rx_buf_size;
+    unsigned                      num_streams;
     int                           prefer_default;
     unsigned                      backlog;
     int                           sockopt_nodelay;
+    int                           sockopt_zcopy;
 } uct_tcp_iface_config_t;
 
 
@@ -67,6 +151,10 @@ typedef struct uct_tcp_iface_config {
  * TCP receive socket wrapper/
  */
 struct uct_tcp_recv_sock {
+    int                           fd;             /* Socket file descriptor */
+    void                          *buf;           /* Receive staging buffer, from
+                                                     the interface memory pool */
+    size_t                        offset;         /* Bytes accumulated in buf */
 };
 
 
@@ -91,10 +179,27 @@ ucs_status_t uct_tcp_iface_set_sockopt(uct_tcp_iface_t *iface, int fd);
 
 ucs_status_t uct_tcp_iface_connection_accepted(uct_tcp_iface_t *iface, int fd);
 
+void uct_tcp_iface_progress(void *arg);
+
 void uct_tcp_iface_recv_cleanup(uct_tcp_iface_t *iface);
 
 UCS_CLASS_DECLARE_NEW_FUNC(uct_tcp_ep_t, uct_ep_t, uct_iface_t *,
                            const uct_device_addr_t *, const uct_iface_addr_t *);
 UCS_CLASS_DECLARE_DELETE_FUNC(uct_tcp_ep_t, uct_ep_t);
 
+ucs_status_t uct_tcp_ep_am_short(uct_ep_h tl_ep, uint8_t id, uint64_t header,
+                                 const void *payload, unsigned length);
+
+ssize_t uct_tcp_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id,
+                            uct_pack_callback_t pack_cb, void *arg);
+
+ucs_status_t uct_tcp_ep_am_zcopy(uct_ep_h tl_ep, uint8_t id, const void *header,
+                                 unsigned header_length, const uct_iov_t *iov,
+                                 size_t iovcnt, uct_completion_t *comp);
+
+ucs_status_t uct_tcp_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                              uct_completion_t *comp);
+
+void uct_tcp_iface_progress_tx(uct_tcp_iface_t *iface);
+
 #endif
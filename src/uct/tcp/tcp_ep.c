@@ -6,55 +6,600 @@
 #include "tcp.h"
 
 #include <ucs/async/async.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/uio.h>
 
 
-static UCS_CLASS_INIT_FUNC(uct_tcp_ep_t, uct_iface_t *tl_iface,
-                           const uct_device_addr_t *dev_addr,
-                           const uct_iface_addr_t *iface_addr)
+/* Connect one stream socket of the endpoint. All streams connect to the same
+ * listening port; the receive side treats every accepted socket as an
+ * independent message stream, so no extra negotiation is needed. */
+static ucs_status_t uct_tcp_ep_stream_connect(uct_tcp_iface_t *iface,
+                                              uct_tcp_ep_stream_t *stream,
+                                              const struct sockaddr_in *dest_addr)
 {
-    uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
-    struct sockaddr_in dest_addr;
     ucs_status_t status;
 
-    UCS_CLASS_CALL_SUPER_INIT(uct_base_ep_t, &iface->super)
+    status = uct_tcp_socket_create(&stream->fd);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+    status = uct_tcp_iface_set_sockopt(iface, stream->fd);
+    if (status != UCS_OK) {
+        goto err_close;
+    }
 
-    status = uct_tcp_socket_create(&self->fd);
+    status = uct_tcp_socket_connect(stream->fd, dest_addr);
     if (status != UCS_OK) {
-        goto err;
+        goto err_close;
     }
 
-    status = uct_tcp_iface_set_sockopt(iface, self->fd);
+    /* Sends must not block the worker - data which does not fit in the socket
+     * buffer is staged and flushed from the interface progress */
+    status = ucs_sys_fcntl_modfl(stream->fd, O_NONBLOCK, 0);
     if (status != UCS_OK) {
         goto err_close;
     }
 
+    stream->zcopy_seq = 0;
+    ucs_queue_head_init(&stream->zcopy_comps);
+    return UCS_OK;
+
+err_close:
+    close(stream->fd);
+    return status;
+}
+
+static UCS_CLASS_INIT_FUNC(uct_tcp_ep_t, uct_iface_t *tl_iface,
+                           const uct_device_addr_t *dev_addr,
+                           const uct_iface_addr_t *iface_addr)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
+    struct sockaddr_in dest_addr;
+    ucs_status_t status;
+    unsigned i;
+    int on = 1;
+
+    UCS_CLASS_CALL_SUPER_INIT(uct_base_ep_t, &iface->super)
+
     memset(&dest_addr, 0, sizeof(dest_addr));
     dest_addr.sin_family = AF_INET;
     dest_addr.sin_port   = *(in_port_t*)iface_addr;
     dest_addr.sin_addr   = *(struct in_addr*)dev_addr;
 
-    status = uct_tcp_socket_connect(self->fd, &dest_addr);
-    if (status != UCS_OK) {
-        goto err_close;
+    for (i = 0; i < iface->config.num_streams; ++i) {
+        status = uct_tcp_ep_stream_connect(iface, &self->streams[i],
+                                           &dest_addr);
+        if (status != UCS_OK) {
+            goto err_close;
+        }
+    }
+    self->num_streams  = iface->config.num_streams;
+    self->stripe_count = 0;
+
+    self->tx_buf    = NULL;
+    self->tx_offset = 0;
+    self->tx_length = 0;
+    self->tx_stream = 0;
+
+    self->zcopy_enabled  = 0;
+    self->zcopy_inflight = 0;
+
+    if (iface->sockopt.zcopy) {
+        self->zcopy_enabled = 1;
+        for (i = 0; i < self->num_streams; ++i) {
+            if (setsockopt(self->streams[i].fd, SOL_SOCKET, SO_ZEROCOPY, &on,
+                           sizeof(on)) < 0) {
+                ucs_debug("failed to set SO_ZEROCOPY on fd %d: %m, "
+                          "falling back to copying sends", self->streams[i].fd);
+                self->zcopy_enabled = 0;
+                break;
+            }
+        }
     }
 
-    ucs_debug("connected to %s:%d", inet_ntoa(dest_addr.sin_addr),
+    ucs_debug("connected %u stream%s to %s:%d", self->num_streams,
+              (self->num_streams > 1) ? "s" : "", inet_ntoa(dest_addr.sin_addr),
               ntohs(dest_addr.sin_port));
     return UCS_OK;
 
 err_close:
-    close(self->fd);
-err:
+    while (i-- > 0) {
+        close(self->streams[i].fd);
+    }
     return status;
 }
 
 static UCS_CLASS_CLEANUP_FUNC(uct_tcp_ep_t)
 {
+    uct_tcp_iface_t *iface = ucs_derived_of(self->super.super.iface,
+                                            uct_tcp_iface_t);
+    uct_tcp_zcopy_comp_t *zcomp;
+    unsigned i;
+
     ucs_trace_func("self=%p", self);
-    close(self->fd);
+
+    if (self->tx_buf != NULL) {
+        ucs_warn("destroying ep %p with %zu bytes of staged data", self,
+                 self->tx_length - self->tx_offset);
+        ucs_queue_remove(&iface->tx_eps, &self->tx_queue);
+        ucs_mpool_put(self->tx_buf);
+    }
+
+    if (self->zcopy_inflight != 0) {
+        ucs_warn("destroying ep %p with %u zero-copy sends in flight", self,
+                 self->zcopy_inflight);
+        ucs_queue_remove(&iface->zcopy_eps, &self->zcopy_queue);
+    }
+
+    for (i = 0; i < self->num_streams; ++i) {
+        ucs_queue_for_each_extract(zcomp, &self->streams[i].zcopy_comps, queue,
+                                   1) {
+            ucs_free(zcomp);
+        }
+        close(self->streams[i].fd);
+    }
 }
 
 UCS_CLASS_DEFINE(uct_tcp_ep_t, uct_base_ep_t);
 UCS_CLASS_DEFINE_NEW_FUNC(uct_tcp_ep_t, uct_ep_t, uct_iface_t *,
                           const uct_device_addr_t *, const uct_iface_addr_t *);
 UCS_CLASS_DEFINE_DELETE_FUNC(uct_tcp_ep_t, uct_ep_t);
+
+/* Send as much of the iovec list as the socket accepts. The entries are
+ * advanced in place; returns UCS_ERR_NO_RESOURCE when unsent data remains,
+ * so the caller stages the tail. */
+static ucs_status_t uct_tcp_ep_sendv(int fd, struct iovec *iov, int iovcnt,
+                                     int *index_p)
+{
+    ssize_t nwritten;
+    int i = 0;
+
+    while (i < iovcnt) {
+        nwritten = writev(fd, iov + i, iovcnt - i);
+        if (nwritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                *index_p = i;
+                return UCS_ERR_NO_RESOURCE;
+            }
+            ucs_error("writev(fd=%d) failed: %m", fd);
+            return UCS_ERR_IO_ERROR;
+        }
+
+        /* Skip the entries which were sent in full */
+        while ((i < iovcnt) && ((size_t)nwritten >= iov[i].iov_len)) {
+            nwritten -= iov[i].iov_len;
+            ++i;
+        }
+
+        if (i < iovcnt) {
+            iov[i].iov_base += nwritten;
+            iov[i].iov_len  -= nwritten;
+        }
+    }
+
+    *index_p = iovcnt;
+    return UCS_OK;
+}
+
+/* Park the bytes the socket did not accept, preserving wire order. The
+ * message was already accepted (its head may be on the wire), so staging
+ * must succeed for the stream to stay consistent. */
+static ucs_status_t uct_tcp_ep_stage(uct_tcp_iface_t *iface, uct_tcp_ep_t *ep,
+                                     const struct iovec *iov, int index,
+                                     int iovcnt, unsigned stream_index)
+{
+    size_t length = 0;
+    int i;
+
+    ucs_assert(ep->tx_buf == NULL);
+    ep->tx_buf = ucs_mpool_get(&iface->mp);
+    if (ep->tx_buf == NULL) {
+        ucs_error("failed to allocate staging buffer for ep %p", ep);
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    for (i = index; i < iovcnt; ++i) {
+        memcpy(ep->tx_buf + length, iov[i].iov_base, iov[i].iov_len);
+        length += iov[i].iov_len;
+    }
+
+    ep->tx_offset = 0;
+    ep->tx_length = length;
+    ep->tx_stream = stream_index;
+    ucs_queue_push(&iface->tx_eps, &ep->tx_queue);
+    return UCS_OK;
+}
+
+static void uct_tcp_ep_zcopy_reap(uct_tcp_ep_t *ep);
+
+/* Flush the staged data of all endpoints which have any. Called from the
+ * interface progress, so senders do not have to spin on UCS_ERR_NO_RESOURCE
+ * while the socket drains. */
+void uct_tcp_iface_progress_tx(uct_tcp_iface_t *iface)
+{
+    ucs_queue_iter_t iter;
+    uct_tcp_ep_t *ep;
+    ssize_t nwritten;
+
+    ucs_queue_for_each_safe(ep, iter, &iface->tx_eps, tx_queue) {
+        nwritten = send(ep->streams[ep->tx_stream].fd,
+                        ep->tx_buf + ep->tx_offset,
+                        ep->tx_length - ep->tx_offset, 0);
+        if (nwritten < 0) {
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK) ||
+                (errno == EINTR)) {
+                continue;
+            }
+            ucs_error("send(fd=%d) failed: %m", ep->streams[ep->tx_stream].fd);
+            nwritten = ep->tx_length - ep->tx_offset; /* drop staged data */
+        }
+
+        ep->tx_offset += nwritten;
+        if (ep->tx_offset == ep->tx_length) {
+            ucs_mpool_put(ep->tx_buf);
+            ep->tx_buf = NULL;
+            ucs_queue_del_iter(&iface->tx_eps, iter);
+        }
+    }
+
+    ucs_queue_for_each_safe(ep, iter, &iface->zcopy_eps, zcopy_queue) {
+        uct_tcp_ep_zcopy_reap(ep);
+        if (ep->zcopy_inflight == 0) {
+            ucs_queue_del_iter(&iface->zcopy_eps, iter);
+        }
+    }
+}
+
+ucs_status_t uct_tcp_ep_am_zcopy(uct_ep_h tl_ep, uint8_t id, const void *header,
+                                 unsigned header_length, const uct_iov_t *iov,
+                                 size_t iovcnt, uct_completion_t *comp)
+{
+    uct_tcp_ep_t *ep       = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    struct iovec vec[2 + UCT_TCP_MAX_IOV];
+    uct_tcp_ep_stream_t *stream;
+    uct_tcp_zcopy_comp_t *zcomp;
+    unsigned nsent_zcopy = 0;
+    uct_tcp_am_hdr_t hdr;
+    ucs_status_t status;
+    struct msghdr msg;
+    size_t length, iov_it;
+    ssize_t nwritten;
+    int vec_cnt, i, flags;
+    int sent_any = 0;
+
+    length = uct_iov_total_length(iov, iovcnt);
+
+    UCT_CHECK_AM_ID(id);
+    UCT_CHECK_IOV_SIZE(iovcnt, UCT_TCP_MAX_IOV, "uct_tcp_ep_am_zcopy");
+    /* The remote staging buffer bounds the message size */
+    UCT_CHECK_LENGTH(header_length + length, 0, iface->config.max_bcopy,
+                     "am_zcopy");
+
+    /* Large messages are striped round-robin over the streams beyond the
+     * first one, which is reserved for the ordered small messages. With a
+     * single stream everything shares it. */
+    if (ep->num_streams > 1) {
+        stream = &ep->streams[1 + (ep->stripe_count++ % (ep->num_streams - 1))];
+    } else {
+        stream = &ep->streams[0];
+    }
+
+    /* The staging buffer is the fallback for a partially accepted frame, and
+     * only one frame can be parked per endpoint */
+    if (ep->tx_buf != NULL) {
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    /* Allocate the completion tracking before sending anything, so a failure
+     * cannot leave a notification without an owner */
+    zcomp = NULL;
+    if (ep->zcopy_enabled) {
+        zcomp = ucs_malloc(sizeof(*zcomp), "tcp_zcopy_comp");
+        if (zcomp == NULL) {
+            return UCS_ERR_NO_MEMORY;
+        }
+    }
+
+    hdr.am_id  = id;
+    hdr.length = header_length + length;
+
+    vec[0].iov_base = &hdr;
+    vec[0].iov_len  = sizeof(hdr);
+    vec[1].iov_base = (void*)header;
+    vec[1].iov_len  = header_length;
+    vec_cnt         = 2;
+    for (iov_it = 0; iov_it < iovcnt; ++iov_it) {
+        vec[vec_cnt].iov_base = iov[iov_it].buffer;
+        vec[vec_cnt].iov_len  = uct_iov_get_length(&iov[iov_it]);
+        if (vec[vec_cnt].iov_len != 0) {
+            ++vec_cnt;
+        }
+    }
+
+    flags = ep->zcopy_enabled ? MSG_ZEROCOPY : 0;
+    i     = 0;
+    while (i < vec_cnt) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov    = vec + i;
+        msg.msg_iovlen = vec_cnt - i;
+
+        nwritten = sendmsg(stream->fd, &msg, flags);
+        if (nwritten < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+                if (!sent_any) {
+                    /* Nothing was accepted - the caller can queue the send
+                     * as pending and retry once progress drains the socket */
+                    ucs_free(zcomp);
+                    return UCS_ERR_NO_RESOURCE;
+                }
+
+                /* The message head is already on the wire, so the frame must
+                 * be completed - park the remainder in the staging buffer and
+                 * let the interface progress finish it, instead of blocking
+                 * here on the peer draining the socket */
+                status = uct_tcp_ep_stage(iface, ep, vec, i, vec_cnt,
+                                          stream - ep->streams);
+                if (status != UCS_OK) {
+                    ucs_free(zcomp);
+                    return status;
+                }
+                break;
+            }
+            if ((flags & MSG_ZEROCOPY) && (errno == ENOBUFS)) {
+                /* Out of pinned-pages budget - send the rest with a copy */
+                flags &= ~MSG_ZEROCOPY;
+                continue;
+            }
+            ucs_error("sendmsg(fd=%d) failed: %m", stream->fd);
+            ucs_free(zcomp);
+            return UCS_ERR_IO_ERROR;
+        }
+
+        if (nwritten > 0) {
+            sent_any = 1;
+            if (flags & MSG_ZEROCOPY) {
+                /* Every zero-copy sendmsg() gets its own notification */
+                ++stream->zcopy_seq;
+                ++nsent_zcopy;
+            }
+        }
+
+        while ((i < vec_cnt) && ((size_t)nwritten >= vec[i].iov_len)) {
+            nwritten -= vec[i].iov_len;
+            ++i;
+        }
+        if (i < vec_cnt) {
+            vec[i].iov_base += nwritten;
+            vec[i].iov_len  -= nwritten;
+        }
+    }
+
+    UCT_TL_EP_STAT_OP(&ep->super, AM, ZCOPY, header_length + length);
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, id,
+                       (void*)header, header_length, "TX: AM_ZCOPY");
+
+    if (nsent_zcopy == 0) {
+        /* The kernel did not pin any pages - the buffers are reusable */
+        ucs_free(zcomp);
+        return UCS_OK;
+    }
+
+    zcomp->seq  = stream->zcopy_seq - 1;
+    zcomp->comp = comp;
+    if (ep->zcopy_inflight++ == 0) {
+        ucs_queue_push(&iface->zcopy_eps, &ep->zcopy_queue);
+    }
+    ucs_queue_push(&stream->zcopy_comps, &zcomp->queue);
+    return UCS_INPROGRESS;
+}
+
+/* Read the zero-copy notifications from the socket error queue of one stream
+ * and complete the sends whose pages the kernel released */
+static void uct_tcp_ep_stream_zcopy_reap(uct_tcp_ep_t *ep,
+                                         uct_tcp_ep_stream_t *stream)
+{
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+    struct sock_extended_err *serr;
+    uct_tcp_zcopy_comp_t *zcomp;
+    struct cmsghdr *cmsg;
+    struct msghdr msg;
+    uint32_t hi;
+    int ret;
+
+    for (;;) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control    = control;
+        msg.msg_controllen = sizeof(control);
+
+        ret = recvmsg(stream->fd, &msg, MSG_ERRQUEUE);
+        if (ret < 0) {
+            return; /* No more notifications */
+        }
+
+        for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            serr = (struct sock_extended_err*)CMSG_DATA(cmsg);
+            if ((serr->ee_errno != 0) ||
+                (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)) {
+                continue;
+            }
+
+            /* All the sends up to ee_data released their pages (possibly by
+             * copying them, which is still a completion) */
+            hi = serr->ee_data;
+            while (!ucs_queue_is_empty(&stream->zcopy_comps)) {
+                zcomp = ucs_queue_head_elem_non_empty(&stream->zcopy_comps,
+                                                      uct_tcp_zcopy_comp_t,
+                                                      queue);
+                if ((int32_t)(zcomp->seq - hi) > 0) {
+                    break;
+                }
+
+                ucs_queue_pull_non_empty(&stream->zcopy_comps);
+                if (zcomp->comp != NULL) {
+                    uct_invoke_completion(zcomp->comp, UCS_OK);
+                }
+                ucs_free(zcomp);
+                --ep->zcopy_inflight;
+            }
+        }
+    }
+}
+
+static void uct_tcp_ep_zcopy_reap(uct_tcp_ep_t *ep)
+{
+    unsigned i;
+
+    for (i = 0; i < ep->num_streams; ++i) {
+        if (!ucs_queue_is_empty(&ep->streams[i].zcopy_comps)) {
+            uct_tcp_ep_stream_zcopy_reap(ep, &ep->streams[i]);
+        }
+    }
+}
+
+ucs_status_t uct_tcp_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                              uct_completion_t *comp)
+{
+    uct_tcp_ep_t *ep = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+
+    if (comp != NULL) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    if ((ep->tx_buf != NULL) || (ep->zcopy_inflight != 0)) {
+        UCT_TL_EP_STAT_FLUSH_WAIT(&ep->super);
+        return UCS_INPROGRESS;
+    }
+
+    UCT_TL_EP_STAT_FLUSH(&ep->super);
+    return UCS_OK;
+}
+
+ucs_status_t uct_tcp_ep_am_short(uct_ep_h tl_ep, uint8_t id, uint64_t header,
+                                 const void *payload, unsigned length)
+{
+    uct_tcp_ep_t *ep       = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    size_t buf_size        = iface->config.buf_size;
+    struct iovec iov[2];
+    ucs_status_t status;
+    int index;
+
+    /* Wire header and AM header, contiguous so the whole message goes out in
+     * a single writev() straight from the user buffer */
+    struct UCS_S_PACKED {
+        uct_tcp_am_hdr_t          hdr;
+        uint64_t                  header;
+    } short_hdr;
+
+    UCT_CHECK_AM_ID(id);
+    UCT_CHECK_LENGTH(length + sizeof(header), 0, iface->config.max_bcopy,
+                     "am_short");
+
+    short_hdr.hdr.am_id  = id;
+    short_hdr.hdr.length = length + sizeof(header);
+    short_hdr.header     = header;
+
+    if (ep->tx_buf != NULL) {
+        /* The socket is backed up - coalesce the message into the staging
+         * buffer behind the parked data, so it leaves in the same syscall
+         * once the socket drains. Only when the parked data belongs to
+         * stream 0, which carries the ordered small messages. */
+        if ((ep->tx_stream != 0) ||
+            ((buf_size - ep->tx_length) < (sizeof(short_hdr) + length))) {
+            return UCS_ERR_NO_RESOURCE;
+        }
+
+        memcpy(ep->tx_buf + ep->tx_length, &short_hdr, sizeof(short_hdr));
+        memcpy(ep->tx_buf + ep->tx_length + sizeof(short_hdr), payload, length);
+        ep->tx_length += sizeof(short_hdr) + length;
+        goto out_sent;
+    }
+
+    iov[0].iov_base = &short_hdr;
+    iov[0].iov_len  = sizeof(short_hdr);
+    iov[1].iov_base = (void*)payload;
+    iov[1].iov_len  = length;
+
+    status = uct_tcp_ep_sendv(ep->streams[0].fd, iov, 2, &index);
+    if (status == UCS_ERR_NO_RESOURCE) {
+        status = uct_tcp_ep_stage(iface, ep, iov, index, 2, 0);
+    }
+    if (status != UCS_OK) {
+        return status;
+    }
+
+out_sent:
+    UCT_TL_EP_STAT_OP(&ep->super, AM, SHORT, length + sizeof(header));
+    /* header and payload are not contiguous here, dump only the header */
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, id,
+                       &short_hdr.header, sizeof(header), "TX: AM_SHORT");
+    return UCS_OK;
+}
+
+ssize_t uct_tcp_ep_am_bcopy(uct_ep_h tl_ep, uint8_t id,
+                            uct_pack_callback_t pack_cb, void *arg)
+{
+    uct_tcp_ep_t *ep       = ucs_derived_of(tl_ep, uct_tcp_ep_t);
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_tcp_iface_t);
+    size_t buf_size        = iface->config.buf_size;
+    uct_tcp_am_hdr_t *hdr;
+    struct iovec iov;
+    ucs_status_t status;
+    size_t length;
+    int index;
+
+    UCT_CHECK_AM_ID(id);
+
+    hdr = ucs_mpool_get(&iface->mp);
+    if (hdr == NULL) {
+        return UCS_ERR_NO_MEMORY;
+    }
+
+    length      = pack_cb(hdr + 1, arg);
+    hdr->am_id  = id;
+    hdr->length = length;
+    UCT_CHECK_LENGTH(length, 0, iface->config.max_bcopy, "am_bcopy");
+
+    uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_SEND, id, hdr + 1,
+                       length, "TX: AM_BCOPY");
+
+    if (ep->tx_buf != NULL) {
+        /* Coalesce behind the staged data when it fits and the staged data
+         * is on the ordered stream, to preserve order */
+        if ((ep->tx_stream != 0) ||
+            ((buf_size - ep->tx_length) < (sizeof(*hdr) + length))) {
+            ucs_mpool_put(hdr);
+            return UCS_ERR_NO_RESOURCE;
+        }
+
+        memcpy(ep->tx_buf + ep->tx_length, hdr, sizeof(*hdr) + length);
+        ep->tx_length += sizeof(*hdr) + length;
+        ucs_mpool_put(hdr);
+        goto out_sent;
+    }
+
+    iov.iov_base = hdr;
+    iov.iov_len  = sizeof(*hdr) + length;
+    status       = uct_tcp_ep_sendv(ep->streams[0].fd, &iov, 1, &index);
+    if (status == UCS_ERR_NO_RESOURCE) {
+        status = uct_tcp_ep_stage(iface, ep, &iov, index, 1, 0);
+    }
+    ucs_mpool_put(hdr);
+    if (status != UCS_OK) {
+        return status;
+    }
+
+out_sent:
+    UCT_TL_EP_STAT_OP(&ep->super, AM, BCOPY, length);
+    return length;
+}
@@ -7,7 +7,9 @@
 
 #include <ucs/async/async.h>
 #include <ucs/sys/string.h>
+#include <ucs/sys/topo.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <sys/poll.h>
 #include <netinet/tcp.h>
 #include <dirent.h>
@@ -18,6 +20,19 @@ static ucs_config_field_t uct_tcp_iface_config_table[] = {
    ucs_offsetof(uct_tcp_iface_config_t, super),
    UCS_CONFIG_TYPE_TABLE(uct_iface_config_table)},
 
+  {"RX_BUF_SIZE", "64k",
+   "Size of the receive staging buffers. Each recv() call fills up to this\n"
+   "many bytes, and all complete messages in the fill are delivered without\n"
+   "additional copies, so larger buffers mean fewer syscalls per message.",
+   ucs_offsetof(uct_tcp_iface_config_t, rx_buf_size), UCS_CONFIG_TYPE_MEMUNITS},
+
+  {"NUM_STREAMS", "1",
+   "Number of parallel sockets per endpoint. Large (zcopy) messages are\n"
+   "striped over the additional sockets to aggregate bandwidth past the\n"
+   "per-flow limits of the fabric; small messages stay on the first socket\n"
+   "to preserve their order.",
+   ucs_offsetof(uct_tcp_iface_config_t, num_streams), UCS_CONFIG_TYPE_UINT},
+
   {"PREFER_DEFAULT", "y",
    "Give higher priority to the default network interface on the host",
    ucs_offsetof(uct_tcp_iface_config_t, prefer_default), UCS_CONFIG_TYPE_BOOL},
@@ -31,6 +46,12 @@ static ucs_config_field_t uct_tcp_iface_config_table[] = {
    "option usually provides better performance",
    ucs_offsetof(uct_tcp_iface_config_t, sockopt_nodelay), UCS_CONFIG_TYPE_BOOL},
 
+  {"ZCOPY", "n",
+   "Use the kernel zero-copy transmission (SO_ZEROCOPY) for zcopy sends, so\n"
+   "large payloads are not copied into the socket buffers. Requires\n"
+   "linux 4.14 or above.",
+   ucs_offsetof(uct_tcp_iface_config_t, sockopt_zcopy), UCS_CONFIG_TYPE_BOOL},
+
   {NULL}
 };
 
@@ -72,13 +93,26 @@ static ucs_status_t uct_tcp_iface_query(uct_iface_h tl_iface, uct_iface_attr_t *
     int is_default;
 
     memset(attr, 0, sizeof(*attr));
+    attr->numa_node        = ucs_topo_device_numa_node("net", iface->if_name);
     attr->iface_addr_len   = sizeof(in_port_t);
     attr->device_addr_len  = sizeof(struct in_addr);
     attr->cap.flags        = UCT_IFACE_FLAG_CONNECT_TO_IFACE |
+                             UCT_IFACE_FLAG_AM_SHORT |
+                             UCT_IFACE_FLAG_AM_BCOPY |
                              UCT_IFACE_FLAG_PENDING;
 
+    attr->cap.am.max_short = iface->config.max_bcopy - sizeof(uint64_t);
     attr->cap.am.max_bcopy = iface->config.max_bcopy;
 
+    if (iface->sockopt.zcopy) {
+        attr->cap.flags       |= UCT_IFACE_FLAG_AM_ZCOPY;
+        /* The receive side stages a full message, so it is bounded the same
+         * way as bcopy */
+        attr->cap.am.max_zcopy = iface->config.max_bcopy;
+        attr->cap.am.max_hdr   = iface->config.max_bcopy;
+        attr->cap.am.max_iov   = UCT_TCP_MAX_IOV;
+    }
+
     status = uct_tcp_netif_caps(iface->if_name, &attr->latency.overhead,
                                 &attr->bandwidth);
     if (status != UCS_OK) {
@@ -141,12 +175,36 @@ ucs_status_t uct_tcp_iface_set_sockopt(uct_tcp_iface_t *iface, int fd)
     return UCS_OK;
 }
 
+static ucs_status_t uct_tcp_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                        uct_completion_t *comp)
+{
+    uct_tcp_iface_t *iface = ucs_derived_of(tl_iface, uct_tcp_iface_t);
+
+    if (comp != NULL) {
+        return UCS_ERR_UNSUPPORTED;
+    }
+
+    if (!ucs_queue_is_empty(&iface->tx_eps) ||
+        !ucs_queue_is_empty(&iface->zcopy_eps)) {
+        UCT_TL_IFACE_STAT_FLUSH_WAIT(&iface->super);
+        return UCS_INPROGRESS;
+    }
+
+    UCT_TL_IFACE_STAT_FLUSH(&iface->super);
+    return UCS_OK;
+}
+
 static uct_iface_ops_t uct_tcp_iface_ops = {
     .iface_close              = UCS_CLASS_DELETE_FUNC_NAME(uct_tcp_iface_t),
+    .iface_flush              = uct_tcp_iface_flush,
     .iface_get_device_address = uct_tcp_iface_get_device_address,
     .iface_get_address        = uct_tcp_iface_get_address,
     .iface_query              = uct_tcp_iface_query,
     .iface_is_reachable       = uct_tcp_iface_is_reachable,
+    .ep_am_short              = uct_tcp_ep_am_short,
+    .ep_am_bcopy              = uct_tcp_ep_am_bcopy,
+    .ep_am_zcopy              = uct_tcp_ep_am_zcopy,
+    .ep_flush                 = uct_tcp_ep_flush,
     .ep_create_connected      = UCS_CLASS_NEW_FUNC_NAME(uct_tcp_ep_t),
     .ep_destroy               = UCS_CLASS_DELETE_FUNC_NAME(uct_tcp_ep_t),
     .ep_pending_add           = ucs_empty_function_return_busy,
@@ -176,10 +234,20 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
 
     ucs_strncpy_zero(self->if_name, params->dev_name, sizeof(self->if_name));
     self->config.max_bcopy       = config->super.max_bcopy;
+    /* a buffer must be able to hold at least one maximal message */
+    self->config.buf_size        = ucs_max(config->rx_buf_size,
+                                           sizeof(uct_tcp_am_hdr_t) +
+                                           self->config.max_bcopy);
+    self->config.num_streams     = ucs_max(1,
+                                           ucs_min(config->num_streams,
+                                                   UCT_TCP_MAX_STREAMS));
     self->config.prefer_default  = config->prefer_default;
     self->sockopt.nodelay        = config->sockopt_nodelay;
+    self->sockopt.zcopy          = config->sockopt_zcopy;
 
     kh_init_inplace(uct_tcp_fd_hash, &self->fd_hash);
+    ucs_queue_head_init(&self->tx_eps);
+    ucs_queue_head_init(&self->zcopy_eps);
 
     status = uct_tcp_netif_inaddr(self->if_name, &self->config.ifaddr,
                                   &self->config.netmask);
@@ -188,7 +256,7 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
     }
 
     status = ucs_mpool_init(&self->mp, 0,
-                            self->config.max_bcopy,
+                            self->config.buf_size,
                             0,                        /* alignment offset */
                             UCS_SYS_CACHE_LINE_SIZE,  /* alignment */
                             32,                       /* grow */
@@ -198,11 +266,21 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
     if (status != UCS_OK) {
         goto err;
     }
+    uct_worker_mpool_track(self->super.worker, &self->mp);
+
+    /* Create the epoll set which multiplexes all the receive sockets, so a
+     * single system call per progress discovers the readable ones */
+    self->epfd = epoll_create(1);
+    if (self->epfd < 0) {
+        ucs_error("epoll_create() failed: %m");
+        status = UCS_ERR_IO_ERROR;
+        goto err_mpool_cleanup;
+    }
 
     /* Create the server socket for accepting incoming connections */
     status = uct_tcp_socket_create(&self->listen_fd);
     if (status != UCS_OK) {
-        goto err_mpool_cleanup;
+        goto err_close_epfd;
     }
 
     /* Set the server socket to non-blocking mode */
@@ -249,10 +327,13 @@ static UCS_CLASS_INIT_FUNC(uct_tcp_iface_t, uct_md_h md, uct_worker_h worker,
         goto err_close_sock;
     }
 
+    uct_worker_progress_register(worker, uct_tcp_iface_progress, self);
     return UCS_OK;
 
 err_close_sock:
     close(self->listen_fd);
+err_close_epfd:
+    close(self->epfd);
 err_mpool_cleanup:
     ucs_mpool_cleanup(&self->mp, 0);
 err:
@@ -263,12 +344,16 @@ static UCS_CLASS_CLEANUP_FUNC(uct_tcp_iface_t)
 {
     ucs_status_t status;
 
+    uct_worker_progress_unregister(self->super.worker, uct_tcp_iface_progress,
+                                   self);
+
     status = ucs_async_remove_handler(self->listen_fd, 1);
     if (status != UCS_OK) {
         ucs_warn("failed to remove handler for server socket fd=%d", self->listen_fd);
     }
 
     uct_tcp_iface_recv_cleanup(self);
+    close(self->epfd);
     close(self->listen_fd);
     ucs_mpool_cleanup(&self->mp, 1);
     kh_destroy_inplace(uct_tcp_fd_hash, &self->fd_hash);
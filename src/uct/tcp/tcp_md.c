@@ -46,5 +46,6 @@ static ucs_status_t uct_tcp_md_open(const char *md_name, const uct_md_config_t *
 UCT_MD_COMPONENT_DEFINE(uct_tcp_md, UCT_TCP_NAME,
                         uct_tcp_query_md_resources, uct_tcp_md_open, NULL,
                         ucs_empty_function_return_unsupported,
+                        ucs_empty_function_return_unsupported,
                         ucs_empty_function_return_success, "TCP_",
                         uct_md_config_table, uct_md_config_t);
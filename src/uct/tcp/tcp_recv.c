@@ -7,9 +7,14 @@
 #include "tcp.h"
 
 #include <ucs/async/async.h>
+#include <sys/epoll.h>
 #include <sys/poll.h>
 
 
+/* How many epoll events to process in a single progress sweep */
+#define UCT_TCP_MAX_EVENTS  16
+
+
 static ucs_status_t uct_tcp_iface_recv_sock_add(uct_tcp_iface_t *iface, int fd,
                                                 uct_tcp_recv_sock_t *rsock)
 {
@@ -37,7 +42,9 @@ static ucs_status_t uct_tcp_iface_recv_sock_add(uct_tcp_iface_t *iface, int fd,
 ucs_status_t uct_tcp_iface_connection_accepted(uct_tcp_iface_t *iface, int fd)
 {
     uct_tcp_recv_sock_t *rsock;
+    struct epoll_event event;
     ucs_status_t status;
+    int ret;
 
     status = ucs_sys_fcntl_modfl(fd, O_NONBLOCK, 0);
     if (status != UCS_OK) {
@@ -56,11 +63,28 @@ ucs_status_t uct_tcp_iface_connection_accepted(uct_tcp_iface_t *iface, int fd)
         goto err_close;
     }
 
+    rsock->fd     = fd;
+    rsock->buf    = NULL;
+    rsock->offset = 0;
+
     status = uct_tcp_iface_recv_sock_add(iface, fd, rsock);
     if (status != UCS_OK) {
         goto err_free;
     }
 
+    /* Add the socket to the persistent epoll set, so the interface progress
+     * picks up only the sockets which are actually readable instead of
+     * scanning the whole connection list */
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.ptr = rsock;
+    ret = epoll_ctl(iface->epfd, EPOLL_CTL_ADD, fd, &event);
+    if (ret < 0) {
+        ucs_error("epoll_ctl(add, fd=%d) failed: %m", fd);
+        status = UCS_ERR_IO_ERROR;
+        goto err_free;
+    }
+
     return UCS_OK;
 
 err_free:
@@ -70,10 +94,115 @@ err_close:
     return status;
 }
 
+static void uct_tcp_iface_recv_sock_del(uct_tcp_iface_t *iface,
+                                        uct_tcp_recv_sock_t *rsock)
+{
+    khiter_t hash_it;
+
+    (void)epoll_ctl(iface->epfd, EPOLL_CTL_DEL, rsock->fd, NULL);
+
+    /* The hash is also modified from the async accept handler */
+    UCS_ASYNC_BLOCK(iface->super.worker->async);
+    hash_it = kh_get(uct_tcp_fd_hash, &iface->fd_hash, rsock->fd);
+    if (hash_it != kh_end(&iface->fd_hash)) {
+        kh_del(uct_tcp_fd_hash, &iface->fd_hash, hash_it);
+    }
+    UCS_ASYNC_UNBLOCK(iface->super.worker->async);
+
+    if (rsock->buf != NULL) {
+        ucs_mpool_put(rsock->buf);
+    }
+    close(rsock->fd);
+    ucs_free(rsock);
+}
+
+static void uct_tcp_iface_recv_sock_progress(uct_tcp_iface_t *iface,
+                                             uct_tcp_recv_sock_t *rsock)
+{
+    size_t buf_size = iface->config.buf_size;
+    uct_tcp_am_hdr_t *hdr;
+    size_t remainder;
+    ssize_t nread;
+    void *ptr;
+
+    if (rsock->buf == NULL) {
+        rsock->buf = ucs_mpool_get(&iface->mp);
+        if (rsock->buf == NULL) {
+            return; /* Retry on the next progress */
+        }
+        rsock->offset = 0;
+    }
+
+    nread = recv(rsock->fd, rsock->buf + rsock->offset,
+                 buf_size - rsock->offset, 0);
+    if (nread < 0) {
+        if ((errno == EAGAIN) || (errno == EINTR)) {
+            return;
+        }
+        ucs_error("recv(fd=%d) failed: %m", rsock->fd);
+        uct_tcp_iface_recv_sock_del(iface, rsock);
+        return;
+    } else if (nread == 0) {
+        /* The remote side closed the connection */
+        ucs_trace("connection closed on fd %d", rsock->fd);
+        uct_tcp_iface_recv_sock_del(iface, rsock);
+        return;
+    }
+
+    rsock->offset += nread;
+
+    /* Deliver all fully received messages. The handler has to consume the
+     * data during the callback, since the buffer is reused for the rest of
+     * the stream. */
+    ptr = rsock->buf;
+    while ((remainder = rsock->offset - (ptr - rsock->buf)) >=
+           sizeof(uct_tcp_am_hdr_t)) {
+        hdr = ptr;
+        if (remainder < sizeof(*hdr) + hdr->length) {
+            break; /* Partially received message */
+        }
+
+        uct_iface_trace_am(&iface->super, UCT_AM_TRACE_TYPE_RECV, hdr->am_id,
+                           hdr + 1, hdr->length, "RX: AM");
+        uct_iface_invoke_am(&iface->super, hdr->am_id, hdr + 1, hdr->length, 0);
+        ptr += sizeof(*hdr) + hdr->length;
+    }
+
+    /* Move the tail of a partially received message to the beginning of the
+     * buffer, so it can always arrive in full */
+    remainder = rsock->offset - (ptr - rsock->buf);
+    memmove(rsock->buf, ptr, remainder);
+    rsock->offset = remainder;
+}
+
+void uct_tcp_iface_progress(void *arg)
+{
+    uct_tcp_iface_t *iface = arg;
+    struct epoll_event events[UCT_TCP_MAX_EVENTS];
+    int i, nevents;
+
+    nevents = epoll_wait(iface->epfd, events, UCT_TCP_MAX_EVENTS, 0);
+    if (nevents < 0) {
+        if (errno != EINTR) {
+            ucs_error("epoll_wait(epfd=%d) failed: %m", iface->epfd);
+        }
+        nevents = 0;
+    }
+
+    for (i = 0; i < nevents; ++i) {
+        uct_tcp_iface_recv_sock_progress(iface, events[i].data.ptr);
+    }
+
+    uct_tcp_iface_progress_tx(iface);
+}
+
 static void uct_tcp_iface_recv_sock_destroy(uct_tcp_iface_t *iface,
                                             uct_tcp_recv_sock_t *rsock, int fd,
                                             int sync)
 {
+    if (rsock->buf != NULL) {
+        ucs_mpool_put(rsock->buf);
+    }
     ucs_free(rsock);
     close(fd);
 }
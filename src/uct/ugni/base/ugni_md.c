@@ -337,6 +337,7 @@ UCT_MD_COMPONENT_DEFINE(uct_ugni_md_component,
                         uct_ugni_md_open,
                         NULL,
                         uct_ugni_rkey_unpack,
+                        ucs_empty_function_return_unsupported,
                         uct_ugni_rkey_release,
                         "UGNI_",
                         uct_md_config_table,
@@ -9,6 +9,8 @@
 #include "ugni_def.h"
 #include <uct/base/uct_md.h>
 #include <ucs/datastruct/arbiter.h>
+#include <ucs/datastruct/queue.h>
+#include <ucs/time/time.h>
 #include <gni_pub.h>
 #include <stdbool.h>
 
@@ -88,6 +90,9 @@ typedef struct uct_ugni_base_desc {
     uct_completion_t *comp_cb;
     uct_unpack_callback_t unpack_cb;
     uct_ugni_flush_group_t *flush_group;
+    uct_ugni_ep_t *ep;           /**< Endpoint to post a queued descriptor on */
+    ucs_queue_elem_t queue;      /**< Element in the deferred-post backlog */
+    ucs_time_t post_time;        /**< When the descriptor was handed to uGNI */
     int not_ready_to_free;
 } uct_ugni_base_desc_t;
 
@@ -97,6 +97,7 @@ static inline ucs_status_t uct_ugni_post_rdma(uct_ugni_rdma_iface_t *iface,
         return UCS_ERR_NO_RESOURCE;
     }
 
+    rdma->post_time = ucs_get_time();
     ugni_rc = GNI_PostRdma(ep->ep, &rdma->desc);
     if (ucs_unlikely(GNI_RC_SUCCESS != ugni_rc)) {
         ucs_mpool_put(rdma);
@@ -129,6 +130,7 @@ static inline ssize_t uct_ugni_post_fma(uct_ugni_rdma_iface_t *iface,
         return UCS_ERR_NO_RESOURCE;
     }
 
+    fma->post_time = ucs_get_time();
     ugni_rc = GNI_PostFma(ep->ep, &fma->desc);
     if (ucs_unlikely(GNI_RC_SUCCESS != ugni_rc)) {
         ucs_mpool_put(fma);
@@ -149,6 +151,32 @@ static inline ssize_t uct_ugni_post_fma(uct_ugni_rdma_iface_t *iface,
     return ok_status;
 }
 
+/* Queue a small FMA transaction instead of posting it right away. The whole
+ * backlog is submitted back-to-back on the next progress call (or once it
+ * grows to the configured batch length), which keeps the FMA window full
+ * without paying the post overhead on the critical path of every message. */
+static inline ssize_t uct_ugni_fma_backlog_add(uct_ugni_rdma_iface_t *iface,
+                                               uct_ugni_ep_t *ep,
+                                               uct_ugni_base_desc_t *fma,
+                                               ssize_t ok_status)
+{
+    if (ucs_unlikely(!uct_ugni_ep_can_send(ep))) {
+        ucs_mpool_put(fma);
+        return UCS_ERR_NO_RESOURCE;
+    }
+
+    fma->ep = ep;
+    ucs_queue_push(&iface->fma_backlog, &fma->queue);
+    ++fma->flush_group->flush_comp.count;
+    ++iface->super.outstanding;
+
+    if (++iface->fma_backlog_length >= iface->config.fma_chain) {
+        uct_ugni_rdma_iface_post_backlog(iface);
+    }
+
+    return ok_status;
+}
+
 ucs_status_t uct_ugni_ep_put_short(uct_ep_h tl_ep, const void *buffer,
                                    unsigned length, uint64_t remote_addr,
                                    uct_rkey_t rkey)
@@ -159,10 +187,20 @@ ucs_status_t uct_ugni_ep_put_short(uct_ep_h tl_ep, const void *buffer,
 
     UCT_SKIP_ZERO_LENGTH(length);
     UCT_CHECK_LENGTH(length, 0, iface->config.fma_seg_size, "put_short");
-    UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, &iface->free_desc,
-                             fma, return UCS_ERR_NO_RESOURCE);
-    uct_ugni_format_fma(fma, GNI_POST_FMA_PUT, buffer,
-                        remote_addr, rkey, length, ep, NULL, NULL);
+    if (iface->config.fma_chain > 0) {
+        /* Stage the payload in a bounce buffer so the post can be deferred
+         * and batched with other queued FMA transactions */
+        UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, &iface->free_desc_buffer,
+                                 fma, return UCS_ERR_NO_RESOURCE);
+        memcpy(fma + 1, buffer, length);
+        uct_ugni_format_fma(fma, GNI_POST_FMA_PUT, fma + 1,
+                            remote_addr, rkey, length, ep, NULL, NULL);
+    } else {
+        UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, &iface->free_desc,
+                                 fma, return UCS_ERR_NO_RESOURCE);
+        uct_ugni_format_fma(fma, GNI_POST_FMA_PUT, buffer,
+                            remote_addr, rkey, length, ep, NULL, NULL);
+    }
     ucs_trace_data("Posting PUT Short, GNI_PostFma of size %"PRIx64" from %p to "
                    "%p, with [%"PRIx64" %"PRIx64"]",
                    fma->desc.length,
@@ -171,6 +209,9 @@ ucs_status_t uct_ugni_ep_put_short(uct_ep_h tl_ep, const void *buffer,
                    fma->desc.remote_mem_hndl.qword1,
                    fma->desc.remote_mem_hndl.qword2);
     UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, SHORT, length);
+    if (iface->config.fma_chain > 0) {
+        return uct_ugni_fma_backlog_add(iface, ep, fma, UCS_OK);
+    }
     return uct_ugni_post_fma(iface, ep, fma, UCS_OK);
 }
 
@@ -203,6 +244,11 @@ ssize_t uct_ugni_ep_put_bcopy(uct_ep_h tl_ep, uct_pack_callback_t pack_cb,
                    fma->desc.remote_mem_hndl.qword1,
                    fma->desc.remote_mem_hndl.qword2);
     UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, BCOPY, length);
+    if (iface->config.fma_chain > 0) {
+        /* The data already sits in the bounce buffer, so the post can be
+         * deferred and batched */
+        return uct_ugni_fma_backlog_add(iface, ep, fma, length);
+    }
     return uct_ugni_post_fma(iface, ep, fma, length);
 }
 
@@ -217,6 +263,26 @@ ucs_status_t uct_ugni_ep_put_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t
     UCT_CHECK_PARAM_IOV(iov, iovcnt, buffer, length, memh);
     UCT_SKIP_ZERO_LENGTH(length);
     UCT_CHECK_LENGTH(length, 0, iface->config.rdma_max_size, "put_zcopy");
+
+    /* FMA/BTE crossover - below the threshold the FMA window has a lower
+     * start-up cost than bringing up a BTE channel. The threshold is adjusted
+     * at runtime from the observed completion latency of both paths. */
+    if (length <= iface->config.put_fma_thresh) {
+        UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, &iface->free_desc, rdma,
+                                 return UCS_ERR_NO_RESOURCE);
+        uct_ugni_format_fma(rdma, GNI_POST_FMA_PUT, buffer, remote_addr,
+                            rkey, length, ep, comp, NULL);
+        ucs_trace_data("Posting PUT ZCOPY, GNI_PostFma of size %"PRIx64" from %p to "
+                       "%p, with [%"PRIx64" %"PRIx64"]",
+                       rdma->desc.length,
+                       (void *)rdma->desc.local_addr,
+                       (void *)rdma->desc.remote_addr,
+                       rdma->desc.remote_mem_hndl.qword1,
+                       rdma->desc.remote_mem_hndl.qword2);
+        UCT_TL_EP_STAT_OP(ucs_derived_of(tl_ep, uct_base_ep_t), PUT, ZCOPY, length);
+        return uct_ugni_post_fma(iface, ep, rdma, UCS_INPROGRESS);
+    }
+
     UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, &iface->free_desc, rdma,
                              return UCS_ERR_NO_RESOURCE);
     /* Setup Callback */
@@ -745,3 +811,14 @@ ucs_status_t uct_ugni_ep_am_short(uct_ep_h ep, uint8_t id, uint64_t header,
 {
     return UCS_ERR_UNSUPPORTED;
 }
+
+ucs_status_t uct_ugni_rdma_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                                    uct_completion_t *comp)
+{
+    uct_ugni_rdma_iface_t *iface = ucs_derived_of(tl_ep->iface,
+                                                  uct_ugni_rdma_iface_t);
+
+    /* Queued posts never complete unless they are pushed to the NIC */
+    uct_ugni_rdma_iface_post_backlog(iface);
+    return uct_ugni_ep_flush(tl_ep, flags, comp);
+}
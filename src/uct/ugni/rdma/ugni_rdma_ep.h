@@ -53,4 +53,6 @@ ucs_status_t uct_ugni_ep_get_bcopy(uct_ep_h tl_ep,
 ucs_status_t uct_ugni_ep_get_zcopy(uct_ep_h tl_ep, const uct_iov_t *iov, size_t size,
                                    uint64_t remote_addr, uct_rkey_t rkey,
                                    uct_completion_t *comp);
+ucs_status_t uct_ugni_rdma_ep_flush(uct_ep_h tl_ep, unsigned flags,
+                                    uct_completion_t *comp);
 #endif
@@ -19,6 +19,15 @@ static ucs_config_field_t uct_ugni_rdma_iface_config_table[] = {
                                   "\nAttention: Setting this param with value != -1 is a dangerous thing\n"
                                   "and could cause deadlock or performance degradation."),
 
+    {"FMA_CHAIN", "16",
+     "Number of small FMA puts to queue and submit back-to-back in one batch\n"
+     "on the next progress call (0 - post each put immediately)",
+     ucs_offsetof(uct_ugni_rdma_iface_config_t, fma_chain), UCS_CONFIG_TYPE_UINT},
+
+    {"MAX_POLL", "16",
+     "Max number of completions to process on each progress call",
+     ucs_offsetof(uct_ugni_rdma_iface_config_t, max_poll), UCS_CONFIG_TYPE_UINT},
+
     {NULL}
 };
 
@@ -35,6 +44,7 @@ static ucs_status_t uct_ugni_rdma_iface_query(uct_iface_h tl_iface, uct_iface_at
     uct_ugni_rdma_iface_t *iface = ucs_derived_of(tl_iface, uct_ugni_rdma_iface_t);
 
     memset(iface_attr, 0, sizeof(uct_iface_attr_t));
+    iface_attr->numa_node = -1;
     iface_attr->cap.put.max_short       = iface->config.fma_seg_size;
     iface_attr->cap.put.max_bcopy       = iface->config.fma_seg_size;
     iface_attr->cap.put.min_zcopy       = 0;
@@ -85,11 +95,154 @@ static ucs_status_t uct_ugni_rdma_iface_query(uct_iface_h tl_iface, uct_iface_at
     return UCS_OK;
 }
 
+void uct_ugni_rdma_iface_post_backlog(uct_ugni_rdma_iface_t *iface)
+{
+    uct_ugni_base_desc_t *fma;
+    gni_return_t ugni_rc;
+
+    while (!ucs_queue_is_empty(&iface->fma_backlog)) {
+        fma = ucs_queue_head_elem_non_empty(&iface->fma_backlog,
+                                            uct_ugni_base_desc_t, queue);
+        fma->post_time = ucs_get_time();
+        ugni_rc = GNI_PostFma(fma->ep->ep, &fma->desc);
+        if (ucs_unlikely(GNI_RC_SUCCESS != ugni_rc)) {
+            if (GNI_RC_ERROR_RESOURCE == ugni_rc || GNI_RC_ERROR_NOMEM == ugni_rc) {
+                /* Out of FMA window space - keep the rest of the batch queued
+                 * and retry on the next progress call */
+                ucs_debug("GNI_PostFma failed, Error status: %s %d",
+                          gni_err_str[ugni_rc], ugni_rc);
+                return;
+            }
+            ucs_queue_pull_non_empty(&iface->fma_backlog);
+            --iface->fma_backlog_length;
+            ucs_error("GNI_PostFma failed, Error status: %s %d",
+                      gni_err_str[ugni_rc], ugni_rc);
+            --iface->super.outstanding;
+            uct_ugni_check_flush(fma->flush_group);
+            ucs_mpool_put(fma);
+            continue;
+        }
+        ucs_queue_pull_non_empty(&iface->fma_backlog);
+        --iface->fma_backlog_length;
+    }
+}
+
+/* Exponential moving average weight for completion latency samples */
+#define UCT_UGNI_RDMA_LAT_WEIGHT 0.05
+
+static void uct_ugni_rdma_update_crossover(uct_ugni_rdma_iface_t *iface,
+                                           uct_ugni_base_desc_t *desc)
+{
+    double lat;
+
+    /* Only transfers around the crossover region can go either way - the
+     * latency of very small or very large ones would just skew the averages */
+    if ((desc->desc.length < UCT_UGNI_RDMA_THRESH_MIN) ||
+        (desc->desc.length > 2 * iface->config.fma_seg_size)) {
+        return;
+    }
+
+    lat = ucs_time_to_sec(ucs_get_time() - desc->post_time);
+    if (GNI_POST_FMA_PUT == desc->desc.type) {
+        iface->lat.fma_avg  += UCT_UGNI_RDMA_LAT_WEIGHT * (lat - iface->lat.fma_avg);
+    } else if (GNI_POST_RDMA_PUT == desc->desc.type) {
+        iface->lat.rdma_avg += UCT_UGNI_RDMA_LAT_WEIGHT * (lat - iface->lat.rdma_avg);
+    } else {
+        return;
+    }
+
+    if (++iface->lat.samples < UCT_UGNI_RDMA_LAT_PERIOD) {
+        return;
+    }
+    iface->lat.samples = 0;
+
+    if ((0.0 == iface->lat.fma_avg) || (0.0 == iface->lat.rdma_avg)) {
+        /* One of the paths was not exercised yet */
+        return;
+    }
+
+    if (iface->lat.rdma_avg < iface->lat.fma_avg) {
+        iface->config.put_fma_thresh = ucs_max(iface->config.put_fma_thresh / 2,
+                                               UCT_UGNI_RDMA_THRESH_MIN);
+    } else {
+        iface->config.put_fma_thresh = ucs_min(iface->config.put_fma_thresh * 2,
+                                               iface->config.fma_seg_size);
+    }
+    ucs_trace("iface %p FMA/BTE crossover set to %u (fma %.3fus rdma %.3fus)",
+              iface, iface->config.put_fma_thresh,
+              iface->lat.fma_avg * 1e6, iface->lat.rdma_avg * 1e6);
+}
+
+static void uct_ugni_rdma_progress(void *arg)
+{
+    uct_ugni_rdma_iface_t *iface = (uct_ugni_rdma_iface_t *)arg;
+    gni_cq_entry_t event_data;
+    gni_post_descriptor_t *event_post_desc_ptr;
+    uct_ugni_base_desc_t *desc;
+    gni_return_t ugni_rc;
+    unsigned count;
+
+    /* Submit the batch of FMA posts accumulated since the last call */
+    uct_ugni_rdma_iface_post_backlog(iface);
+
+    /* Drain the completion queue in bursts instead of one event per call */
+    for (count = 0; count < iface->config.max_poll; ++count) {
+        event_data = 0;
+        ugni_rc = GNI_CqGetEvent(iface->super.local_cq, &event_data);
+        if (GNI_RC_NOT_DONE == ugni_rc) {
+            break;
+        }
+
+        if ((GNI_RC_SUCCESS != ugni_rc && !event_data) || GNI_CQ_OVERRUN(event_data)) {
+            ucs_error("GNI_CqGetEvent falied. Error status %s %d ",
+                      gni_err_str[ugni_rc], ugni_rc);
+            return;
+        }
+
+        ugni_rc = GNI_GetCompleted(iface->super.local_cq, event_data,
+                                   &event_post_desc_ptr);
+        if (GNI_RC_SUCCESS != ugni_rc && GNI_RC_TRANSACTION_ERROR != ugni_rc) {
+            ucs_error("GNI_GetCompleted falied. Error status %s %d %d",
+                      gni_err_str[ugni_rc], ugni_rc, GNI_RC_TRANSACTION_ERROR);
+            return;
+        }
+
+        desc = (uct_ugni_base_desc_t *)event_post_desc_ptr;
+        ucs_trace_async("Completion received on %p", desc);
+
+        uct_ugni_rdma_update_crossover(iface, desc);
+
+        if (NULL != desc->comp_cb) {
+            uct_invoke_completion(desc->comp_cb, UCS_OK);
+        }
+
+        if (ucs_likely(0 == desc->not_ready_to_free)) {
+            ucs_mpool_put(desc);
+        }
+
+        iface->super.outstanding--;
+        uct_ugni_check_flush(desc->flush_group);
+    }
+
+    /* have a go a processing the pending queue */
+    ucs_arbiter_dispatch(&iface->super.arbiter, 1, uct_ugni_ep_process_pending,
+                         NULL);
+}
+
+static ucs_status_t uct_ugni_rdma_iface_flush(uct_iface_h tl_iface, unsigned flags,
+                                              uct_completion_t *comp)
+{
+    uct_ugni_rdma_iface_t *iface = ucs_derived_of(tl_iface, uct_ugni_rdma_iface_t);
+
+    /* Queued posts never complete unless they are pushed to the NIC */
+    uct_ugni_rdma_iface_post_backlog(iface);
+    return uct_ugni_iface_flush(tl_iface, flags, comp);
+}
 
 static UCS_CLASS_CLEANUP_FUNC(uct_ugni_rdma_iface_t)
 {
     uct_worker_progress_unregister(self->super.super.worker,
-                                   uct_ugni_progress, self);
+                                   uct_ugni_rdma_progress, self);
 
     if (!self->super.activated) {
         /* We done with release */
@@ -107,7 +260,7 @@ static UCS_CLASS_DEFINE_DELETE_FUNC(uct_ugni_rdma_iface_t, uct_iface_t);
 
 static uct_iface_ops_t uct_ugni_aries_rdma_iface_ops = {
     .iface_query         = uct_ugni_rdma_iface_query,
-    .iface_flush         = uct_ugni_iface_flush,
+    .iface_flush         = uct_ugni_rdma_iface_flush,
     .iface_close         = UCS_CLASS_DELETE_FUNC_NAME(uct_ugni_rdma_iface_t),
     .iface_get_address   = uct_ugni_iface_get_address,
     .iface_get_device_address = uct_ugni_iface_get_dev_address,
@@ -130,12 +283,12 @@ static uct_iface_ops_t uct_ugni_aries_rdma_iface_ops = {
     .ep_atomic_fadd32    = uct_ugni_ep_atomic_fadd32,
     .ep_atomic_cswap32   = uct_ugni_ep_atomic_cswap32,
     .ep_atomic_swap32    = uct_ugni_ep_atomic_swap32,
-    .ep_flush            = uct_ugni_ep_flush,
+    .ep_flush            = uct_ugni_rdma_ep_flush,
 };
 
 static uct_iface_ops_t uct_ugni_gemini_rdma_iface_ops = {
     .iface_query         = uct_ugni_rdma_iface_query,
-    .iface_flush         = uct_ugni_iface_flush,
+    .iface_flush         = uct_ugni_rdma_iface_flush,
     .iface_close         = UCS_CLASS_DELETE_FUNC_NAME(uct_ugni_rdma_iface_t),
     .iface_get_address   = uct_ugni_iface_get_address,
     .iface_get_device_address = uct_ugni_iface_get_dev_address,
@@ -153,7 +306,7 @@ static uct_iface_ops_t uct_ugni_gemini_rdma_iface_ops = {
     .ep_get_zcopy        = uct_ugni_ep_get_zcopy,
     .ep_pending_add      = uct_ugni_ep_pending_add,
     .ep_pending_purge    = uct_ugni_ep_pending_purge,
-    .ep_flush            = uct_ugni_ep_flush,
+    .ep_flush            = uct_ugni_rdma_ep_flush,
 };
 
 static ucs_mpool_ops_t uct_ugni_rdma_desc_mpool_ops = {
@@ -199,6 +352,17 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_rdma_iface_t, uct_md_h md, uct_worker_h work
     /* Setting initial configuration */
     self->config.fma_seg_size  = UCT_UGNI_MAX_FMA;
     self->config.rdma_max_size = UCT_UGNI_MAX_RDMA;
+    /* Start the crossover in the middle of its range so both paths get
+     * exercised and the latency feedback can move it either way */
+    self->config.put_fma_thresh = UCT_UGNI_MAX_FMA / 2;
+    self->config.fma_chain      = config->fma_chain;
+    self->config.max_poll       = ucs_max(config->max_poll, 1);
+
+    ucs_queue_head_init(&self->fma_backlog);
+    self->fma_backlog_length = 0;
+    self->lat.fma_avg        = 0.0;
+    self->lat.rdma_avg       = 0.0;
+    self->lat.samples        = 0;
 
     status = ucs_mpool_init(&self->free_desc,
                             0,
@@ -277,9 +441,7 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_rdma_iface_t, uct_md_h md, uct_worker_h work
         goto clean_get_buffer;
     }
 
-    /* TBD: eventually the uct_ugni_progress has to be moved to
-     * rdma layer so each ugni layer will have own progress */
-    uct_worker_progress_register(worker, uct_ugni_progress, self);
+    uct_worker_progress_register(worker, uct_ugni_rdma_progress, self);
     pthread_mutex_unlock(&uct_ugni_global_lock);
     return UCS_OK;
 
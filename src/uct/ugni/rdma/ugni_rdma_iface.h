@@ -15,6 +15,11 @@
 #define UCT_UGNI_MAX_FMA       2048
 #define UCT_UGNI_MAX_RDMA      (512*1024*1024);
 
+/* Bounds for the dynamic FMA/BTE crossover of put operations */
+#define UCT_UGNI_RDMA_THRESH_MIN  256
+/* Number of completion latency samples between crossover updates */
+#define UCT_UGNI_RDMA_LAT_PERIOD  256
+
 typedef struct uct_ugni_rdma_iface {
     uct_ugni_iface_t        super;                       /**< Super type */
     ucs_mpool_t             free_desc;                   /**< Pool of FMA descriptors for
@@ -30,17 +35,38 @@ typedef struct uct_ugni_rdma_iface {
     ucs_mpool_t             free_desc_get_buffer;        /**< Pool of FMA descriptors for
                                                               FMA_SIZE fetch operations
                                                               (registered memory) */
+    ucs_queue_head_t        fma_backlog;                 /**< Small FMA puts queued for
+                                                              batched submission */
+    unsigned                fma_backlog_length;          /**< Number of queued descriptors */
+    struct {
+        double              fma_avg;                     /**< EWMA of FMA put completion latency */
+        double              rdma_avg;                    /**< EWMA of RDMA put completion latency */
+        unsigned            samples;                     /**< Samples since the last
+                                                              crossover update */
+    } lat;
     struct {
         unsigned            fma_seg_size;                /**< FMA Segment size */
         unsigned            rdma_max_size;               /**< Max RDMA size */
+        unsigned            put_fma_thresh;              /**< Puts up to this size go through
+                                                              FMA, larger ones through the BTE.
+                                                              Adjusted at runtime from observed
+                                                              completion latency */
+        unsigned            fma_chain;                   /**< Max batch of deferred FMA posts,
+                                                              0 - post immediately */
+        unsigned            max_poll;                    /**< Max CQ events per progress call */
     } config;
 } uct_ugni_rdma_iface_t;
 
 typedef struct uct_ugni_rdma_iface_config {
     uct_iface_config_t       super;
     uct_iface_mpool_config_t mpool;
+    unsigned                 fma_chain;
+    unsigned                 max_poll;
 } uct_ugni_rdma_iface_config_t;
 
+
+void uct_ugni_rdma_iface_post_backlog(uct_ugni_rdma_iface_t *iface);
+
 typedef struct uct_ugni_rdma_fetch_desc {
     uct_ugni_base_desc_t super;
     uct_completion_t tmp;
@@ -17,6 +17,8 @@ static void compact_smsg_attr(gni_smsg_attr_t *smsg_attr, uct_ugni_compact_smsg_
     smsg_compact_attr->msg_buffer = smsg_attr->msg_buffer;
     smsg_compact_attr->mbox_offset = smsg_attr->mbox_offset;
     smsg_compact_attr->mem_hndl = smsg_attr->mem_hndl;
+    smsg_compact_attr->buff_size = smsg_attr->buff_size;
+    smsg_compact_attr->mbox_maxcredit = smsg_attr->mbox_maxcredit;
 }
 
 static void uncompact_smsg_attr(uct_ugni_smsg_iface_t *iface, uct_ugni_compact_smsg_attr_t *smsg_compact_attr, gni_smsg_attr_t *smsg_attr)
@@ -24,37 +26,41 @@ static void uncompact_smsg_attr(uct_ugni_smsg_iface_t *iface, uct_ugni_compact_s
     smsg_attr->mem_hndl = smsg_compact_attr->mem_hndl;
     smsg_attr->msg_buffer = smsg_compact_attr->msg_buffer;
     smsg_attr->msg_type = GNI_SMSG_TYPE_MBOX_AUTO_RETRANSMIT;
-    smsg_attr->buff_size = iface->bytes_per_mbox;
+    /* Mailbox geometry comes from the wire - the peer picks its own tier and
+     * it does not have to match ours */
+    smsg_attr->buff_size = smsg_compact_attr->buff_size;
     smsg_attr->mbox_offset = smsg_compact_attr->mbox_offset;
-    smsg_attr->mbox_maxcredit = iface->config.smsg_max_credit;
+    smsg_attr->mbox_maxcredit = smsg_compact_attr->mbox_maxcredit;
     smsg_attr->msg_maxsize = iface->config.smsg_seg_size;
 }
 
-static void uct_ugni_smsg_mbox_init(uct_ugni_smsg_iface_t *iface, uct_ugni_smsg_mbox_t *mbox_info){
+static void uct_ugni_smsg_mbox_init(uct_ugni_smsg_iface_t *iface, uct_ugni_smsg_mbox_t *mbox_info,
+                                    uint16_t maxcredit, size_t buff_size){
     void *mbox_data = (void *)(mbox_info+1);
 
     mbox_info->mbox_attr.mem_hndl = mbox_info->gni_mem;
     mbox_info->mbox_attr.msg_buffer = mbox_data;
     mbox_info->mbox_attr.msg_type = GNI_SMSG_TYPE_MBOX_AUTO_RETRANSMIT;
-    mbox_info->mbox_attr.buff_size = iface->bytes_per_mbox;
+    mbox_info->mbox_attr.buff_size = buff_size;
     mbox_info->mbox_attr.mbox_offset = 0;
-    mbox_info->mbox_attr.mbox_maxcredit = iface->config.smsg_max_credit;
+    mbox_info->mbox_attr.mbox_maxcredit = maxcredit;
     mbox_info->mbox_attr.msg_maxsize = iface->config.smsg_seg_size;
 }
 
-static ucs_status_t uct_ugni_smsg_mbox_reg(uct_ugni_smsg_iface_t *iface, uct_ugni_smsg_mbox_t *mbox)
+static ucs_status_t uct_ugni_smsg_mbox_reg(uct_ugni_smsg_iface_t *iface, uct_ugni_smsg_mbox_t *mbox,
+                                           size_t buff_size)
 {
     gni_return_t ugni_rc;
     void *address = (mbox+1);
 
-    if (0 == iface->bytes_per_mbox) {
-        ucs_error("Unexpected length %zu", iface->bytes_per_mbox);
+    if (0 == buff_size) {
+        ucs_error("Unexpected length %zu", buff_size);
         return UCS_ERR_INVALID_PARAM;
     }
     pthread_mutex_lock(&uct_ugni_global_lock);
 
     ugni_rc = GNI_MemRegister(iface->super.nic_handle, (uint64_t)address,
-                              iface->bytes_per_mbox, iface->remote_cq,
+                              buff_size, iface->remote_cq,
                               GNI_MEM_READWRITE,
                               -1, &(mbox->gni_mem));
 
@@ -62,7 +68,7 @@ static ucs_status_t uct_ugni_smsg_mbox_reg(uct_ugni_smsg_iface_t *iface, uct_ugn
 
     if (GNI_RC_SUCCESS != ugni_rc) {
         ucs_error("GNI_MemRegister failed (addr %p, size %zu), Error status: %s %d",
-                  address, iface->bytes_per_mbox, gni_err_str[ugni_rc], ugni_rc);
+                  address, buff_size, gni_err_str[ugni_rc], ugni_rc);
         return UCS_ERR_IO_ERROR;
     }
 
@@ -91,15 +97,33 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_smsg_ep_t, uct_iface_t *tl_iface)
 {
     UCS_CLASS_CALL_SUPER_INIT(uct_ugni_ep_t, tl_iface, NULL, NULL);
     uct_ugni_smsg_iface_t *iface = ucs_derived_of(tl_iface, uct_ugni_smsg_iface_t);
+    ucs_mpool_t *mbox_pool;
+    uint16_t maxcredit;
+    size_t buff_size;
     void *mbox;
 
-    UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, &iface->free_mbox,
+    /* Endpoints are created on first traffic, so the first peers we talk to
+     * are the busy ones and get the full-credit mailbox. The quiet tail of a
+     * large job stays on the small tier */
+    if (iface->num_eps < iface->config.large_peers) {
+        mbox_pool = &iface->free_mbox;
+        maxcredit = iface->config.smsg_max_credit;
+        buff_size = iface->bytes_per_mbox;
+    } else {
+        mbox_pool = &iface->free_mbox_small;
+        maxcredit = iface->config.smsg_small_credit;
+        buff_size = iface->bytes_per_mbox_small;
+    }
+
+    UCT_TL_IFACE_GET_TX_DESC(&iface->super.super, mbox_pool,
                              mbox, return UCS_ERR_NO_RESOURCE);
 
     self->smsg_attr = (uct_ugni_smsg_mbox_t *)mbox;
+    self->mbox_ready = 0;
+    iface->num_eps++;
 
-    uct_ugni_smsg_mbox_reg(iface, self->smsg_attr);
-    uct_ugni_smsg_mbox_init(iface, self->smsg_attr);
+    uct_ugni_smsg_mbox_reg(iface, self->smsg_attr, buff_size);
+    uct_ugni_smsg_mbox_init(iface, self->smsg_attr, maxcredit, buff_size);
     compact_smsg_attr(&self->smsg_attr->mbox_attr, &self->smsg_compact_attr);
 
     return UCS_OK;
@@ -117,6 +141,7 @@ static UCS_CLASS_CLEANUP_FUNC(uct_ugni_smsg_ep_t)
     progress_remote_cq(iface);
     uct_ugni_smsg_mbox_dereg(iface, self->smsg_attr);
     ucs_mpool_put(self->smsg_attr);
+    iface->num_eps--;
 }
 
 UCS_CLASS_DEFINE(uct_ugni_smsg_ep_t, uct_ugni_ep_t);
@@ -186,6 +211,8 @@ ucs_status_t uct_ugni_smsg_ep_connect_to_ep(uct_ep_h tl_ep,
         ucs_error("Could not set GNI_EpSetEventData!");
     }
 
+    ep->mbox_ready = 1;
+
 
  exit_lock:
     pthread_mutex_unlock(&uct_ugni_global_lock);
@@ -21,6 +21,8 @@ typedef struct uct_ugni_compact_smsg_attr {
     gni_mem_handle_t mem_hndl;
     void *msg_buffer;
     uint32_t mbox_offset;
+    uint32_t buff_size;      /**< Mailbox buffer size of the owner's tier */
+    uint16_t mbox_maxcredit; /**< Number of credits in the owner's mailbox */
 } UCS_S_PACKED uct_ugni_compact_smsg_attr_t;
 
 typedef struct uct_sockaddr_smsg_ugni {
@@ -39,6 +41,7 @@ typedef struct uct_ugni_smsg_ep {
     uct_ugni_ep_t super;
     uct_ugni_smsg_mbox_t *smsg_attr;
     uct_ugni_compact_smsg_attr_t smsg_compact_attr;
+    int mbox_ready;          /**< SmsgInit completed - the mailbox can be polled */
 } uct_ugni_smsg_ep_t;
 
 typedef struct uct_ugni_smsg_desc {
@@ -14,14 +14,24 @@
 
 static ucs_config_field_t uct_ugni_smsg_iface_config_table[] = {
     {"", "ALLOC=huge,mmap,heap", NULL,
-     ucs_offsetof(uct_ugni_iface_config_t, super),
+     ucs_offsetof(uct_ugni_smsg_iface_config_t, super),
      UCS_CONFIG_TYPE_TABLE(uct_iface_config_table)},
 
     UCT_IFACE_MPOOL_CONFIG_FIELDS("SMSG", -1, 0, "smsg",
-                                  ucs_offsetof(uct_ugni_iface_config_t, mpool),
+                                  ucs_offsetof(uct_ugni_smsg_iface_config_t, mpool),
                                   "\nAttention: Setting this param with value != -1 is a dangerous thing\n"
                                   "and could cause deadlock or performance degradation."),
 
+    {"SMALL_CREDIT", "2",
+     "Number of credits in the small (default) mailbox tier",
+     ucs_offsetof(uct_ugni_smsg_iface_config_t, small_credit), UCS_CONFIG_TYPE_UINT},
+
+    {"LARGE_PEERS", "256",
+     "Number of endpoints that get a full-credit mailbox. Endpoints are\n"
+     "created on first traffic, so the first peers to communicate take the\n"
+     "large tier and the quiet tail stays on small mailboxes",
+     ucs_offsetof(uct_ugni_smsg_iface_config_t, large_peers), UCS_CONFIG_TYPE_UINT},
+
     {NULL}
 };
 
@@ -160,6 +170,25 @@ ucs_status_t progress_remote_cq(uct_ugni_smsg_iface_t *iface)
 
 UCS_CLASS_DEFINE_DELETE_FUNC(uct_ugni_smsg_iface_t, uct_iface_t);
 
+/* Proactively drain one hash bucket of mailboxes per progress call. Releasing
+ * messages is what hands credits back to the sender, and waiting for a remote
+ * CQ event to do it leaves senders starved whenever events get coalesced or
+ * dropped. One bucket per call bounds the work on large jobs. */
+static void uct_ugni_smsg_sweep_mboxes(uct_ugni_smsg_iface_t *iface)
+{
+    uct_ugni_ep_t *current_ep;
+    uct_ugni_smsg_ep_t *ep;
+
+    for (current_ep = iface->super.eps[iface->sweep_bucket]; NULL != current_ep;
+         current_ep = current_ep->next) {
+        ep = ucs_derived_of(current_ep, uct_ugni_smsg_ep_t);
+        if (ep->mbox_ready) {
+            process_mbox(iface, ep);
+        }
+    }
+    iface->sweep_bucket = (iface->sweep_bucket + 1) % UCT_UGNI_HASH_SIZE;
+}
+
 static void uct_ugni_smsg_progress(void *arg)
 {
     uct_ugni_smsg_iface_t *iface = (uct_ugni_smsg_iface_t *)arg;
@@ -172,6 +201,8 @@ static void uct_ugni_smsg_progress(void *arg)
          status = progress_remote_cq(iface);
     } while(status == UCS_INPROGRESS);
 
+    uct_ugni_smsg_sweep_mboxes(iface);
+
     /* have a go a processing the pending queue */
 
     ucs_arbiter_dispatch(&iface->super.arbiter, iface->config.smsg_max_credit,
@@ -191,6 +222,7 @@ static ucs_status_t uct_ugni_smsg_iface_query(uct_iface_h tl_iface, uct_iface_at
     uct_ugni_smsg_iface_t *iface = ucs_derived_of(tl_iface, uct_ugni_smsg_iface_t);
 
     memset(iface_attr, 0, sizeof(uct_iface_attr_t));
+    iface_attr->numa_node = -1;
     iface_attr->cap.am.max_short       = iface->config.smsg_seg_size-sizeof(uint64_t);
     iface_attr->cap.am.max_bcopy       = iface->config.smsg_seg_size;
     iface_attr->cap.am.opt_zcopy_align = 1;
@@ -223,6 +255,7 @@ static UCS_CLASS_CLEANUP_FUNC(uct_ugni_smsg_iface_t)
 
     ucs_mpool_cleanup(&self->free_desc, 1);
     ucs_mpool_cleanup(&self->free_mbox, 1);
+    ucs_mpool_cleanup(&self->free_mbox_small, 1);
 }
 
 uct_iface_ops_t uct_ugni_smsg_iface_ops = {
@@ -337,7 +370,7 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_smsg_iface_t, uct_md_h md, uct_worker_h work
                            const uct_iface_params_t *params,
                            const uct_iface_config_t *tl_config)
 {
-    uct_ugni_iface_config_t *config = ucs_derived_of(tl_config, uct_ugni_iface_config_t);
+    uct_ugni_smsg_iface_config_t *config = ucs_derived_of(tl_config, uct_ugni_smsg_iface_config_t);
     ucs_status_t status;
     gni_return_t ugni_rc;
     unsigned int bytes_per_mbox;
@@ -354,7 +387,12 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_smsg_iface_t, uct_md_h md, uct_worker_h work
     self->config.rx_headroom  = params->rx_headroom;
     self->config.smsg_max_retransmit = 16;
     self->config.smsg_max_credit = 8;
+    self->config.smsg_small_credit = ucs_min(config->small_credit,
+                                             self->config.smsg_max_credit);
+    self->config.large_peers = config->large_peers;
     self->smsg_id = 0;
+    self->num_eps = 0;
+    self->sweep_bucket = 0;
 
     smsg_attr.msg_type = GNI_SMSG_TYPE_MBOX_AUTO_RETRANSMIT;
     smsg_attr.mbox_maxcredit = self->config.smsg_max_credit;
@@ -369,6 +407,18 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_smsg_iface_t, uct_md_h md, uct_worker_h work
         goto exit;
     }
 
+    smsg_attr.mbox_maxcredit = self->config.smsg_small_credit;
+
+    ugni_rc = GNI_SmsgBufferSizeNeeded(&(smsg_attr), &bytes_per_mbox);
+    self->bytes_per_mbox_small = ucs_align_up_pow2(bytes_per_mbox,
+                                                   ucs_get_page_size());
+
+    if (ugni_rc != GNI_RC_SUCCESS) {
+        ucs_error("Smsg buffer size calculation failed");
+        status = UCS_ERR_INVALID_PARAM;
+        goto exit;
+    }
+
     status = ucs_mpool_init(&self->free_desc,
                             0,
                             self->config.smsg_seg_size + sizeof(uct_ugni_smsg_desc_t),
@@ -399,10 +449,25 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_smsg_iface_t, uct_md_h md, uct_worker_h work
         goto clean_desc;
     }
 
+    status = ucs_mpool_init(&self->free_mbox_small,
+                            0,
+                            self->bytes_per_mbox_small + sizeof(uct_ugni_smsg_mbox_t),
+                            sizeof(uct_ugni_smsg_mbox_t),
+                            UCS_SYS_CACHE_LINE_SIZE,      /* alignment */
+                            128,                          /* grow */
+                            config->mpool.max_bufs,       /* max buffers */
+                            &uct_ugni_smsg_mbox_mpool_ops,
+                            "UGNI-SMSG-MBOX-SMALL");
+
+    if (UCS_OK != status) {
+        ucs_error("Mbox Mpool creation failed");
+        goto clean_mbox;
+    }
+
     status = ugni_smsg_activate_iface(self);
     if (UCS_OK != status) {
         ucs_error("Failed to activate the interface");
-        goto clean_mbox;
+        goto clean_mbox_small;
     }
 
     ugni_rc = GNI_SmsgSetMaxRetrans(self->super.nic_handle, self->config.smsg_max_retransmit);
@@ -421,10 +486,12 @@ static UCS_CLASS_INIT_FUNC(uct_ugni_smsg_iface_t, uct_md_h md, uct_worker_h work
 
  clean_iface:
     ugni_smsg_deactivate_iface(self);
- clean_desc:
-    ucs_mpool_cleanup(&self->free_desc, 1);
+ clean_mbox_small:
+    ucs_mpool_cleanup(&self->free_mbox_small, 1);
  clean_mbox:
     ucs_mpool_cleanup(&self->free_mbox, 1);
+ clean_desc:
+    ucs_mpool_cleanup(&self->free_desc, 1);
  exit:
     ucs_error("Failed to activate interface");
     pthread_mutex_unlock(&uct_ugni_global_lock);
@@ -442,6 +509,6 @@ UCT_TL_COMPONENT_DEFINE(uct_ugni_smsg_tl_component,
                         UCT_UGNI_SMSG_TL_NAME,
                         "UGNI_SMSG",
                         uct_ugni_smsg_iface_config_table,
-                        uct_ugni_iface_config_t);
+                        uct_ugni_smsg_iface_config_t);
 
 UCT_MD_REGISTER_TL(&uct_ugni_md_component, &uct_ugni_smsg_tl_component);
@@ -20,18 +20,36 @@ typedef struct uct_ugni_smsg_iface {
     gni_cq_handle_t         remote_cq;    /**< Remote completion queue */
     ucs_mpool_t             free_desc;    /**< Pool of FMA descriptors for
                                                requests without bouncing buffers */
-    ucs_mpool_t             free_mbox;    /**< Pool of mboxes for use with smsg */
+    ucs_mpool_t             free_mbox;    /**< Pool of full-credit mboxes for the
+                                               first (busiest) peers */
+    ucs_mpool_t             free_mbox_small; /**< Pool of small mboxes for the
+                                                  quiet tail of peers */
     uint32_t                smsg_id;      /**< Id number to uniquely identify smsgs in the cq */
+    unsigned                num_eps;      /**< Number of live endpoints, picks the
+                                               mailbox tier of new connections */
+    unsigned                sweep_bucket; /**< Next ep hash bucket to sweep for
+                                               proactive credit return */
     struct {
         unsigned            smsg_seg_size; /**< Max SMSG size */
         size_t              rx_headroom;   /**< The size of user defined header for am */
         uint16_t            smsg_max_retransmit;
         uint16_t            smsg_max_credit; /**< Max credits for smsg boxes */
+        uint16_t            smsg_small_credit; /**< Credits in the small mailbox tier */
+        unsigned            large_peers;   /**< Endpoints eligible for the full
+                                                mailbox tier */
     } config;
     size_t bytes_per_mbox;
+    size_t bytes_per_mbox_small;
     uct_ugni_smsg_desc_t *       smsg_list[UCT_UGNI_HASH_SIZE]; /**< A list of descriptors currently outstanding */
 } uct_ugni_smsg_iface_t;
 
+typedef struct uct_ugni_smsg_iface_config {
+    uct_iface_config_t       super;
+    uct_iface_mpool_config_t mpool;
+    unsigned                 small_credit;
+    unsigned                 large_peers;
+} uct_ugni_smsg_iface_config_t;
+
 typedef struct uct_ugni_smsg_header {
     uint32_t length;
 } uct_ugni_smsg_header_t;
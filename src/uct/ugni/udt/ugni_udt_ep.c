@@ -11,13 +11,19 @@
 
 #define uct_ugni_udt_can_send(_ep) ((uct_ugni_ep_can_send(&_ep->super)) && (_ep->posted_desc == NULL))
 
-ucs_status_t uct_ugni_udt_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n)
+ucs_status_t uct_ugni_udt_ep_pending_add(uct_ep_h tl_ep, uct_pending_req_t *n,
+                                         unsigned flags)
 {
     uct_ugni_iface_t *iface = ucs_derived_of(tl_ep->iface, uct_ugni_iface_t);
-    ucs_status_t status = uct_ugni_ep_pending_add(tl_ep, n);
+    ucs_status_t status = uct_ugni_ep_pending_add(tl_ep, n, flags);
 
     if (UCS_OK == status) {
-        uct_worker_progress_register(iface->super.worker, uct_ugni_udt_progress, iface);
+        /* UDT latency is way above UCT_PROGRESS_SLOW_LATENCY - poll it at a
+         * reduced rate so it does not slow down low-latency ifaces sharing
+         * the worker */
+        uct_worker_progress_register_prio(iface->super.worker,
+                                          uct_ugni_udt_progress, iface,
+                                          UCT_PROGRESS_PRIO_SLOW);
     }
     return status;
 }
@@ -32,7 +38,9 @@ ucs_arbiter_cb_result_t uct_ugni_udt_ep_process_pending(ucs_arbiter_t *arbiter,
 
     result = uct_ugni_ep_process_pending(arbiter, elem, arg);
     if (UCS_ARBITER_CB_RESULT_REMOVE_ELEM == result) {
-        uct_worker_progress_unregister(iface->super.worker, uct_ugni_udt_progress, iface);
+        uct_worker_progress_unregister_prio(iface->super.worker,
+                                            uct_ugni_udt_progress, iface,
+                                            UCT_PROGRESS_PRIO_SLOW);
     }
     return result;
 }
@@ -47,7 +55,9 @@ static ucs_arbiter_cb_result_t uct_ugni_udt_ep_abriter_purge_cb(ucs_arbiter_t *a
 
     result = uct_ugni_ep_abriter_purge_cb(arbiter, elem, arg);
     if (UCS_ARBITER_CB_RESULT_REMOVE_ELEM == result) {
-        uct_worker_progress_unregister(iface->super.worker, uct_ugni_udt_progress, iface);
+        uct_worker_progress_unregister_prio(iface->super.worker,
+                                            uct_ugni_udt_progress, iface,
+                                            UCT_PROGRESS_PRIO_SLOW);
     }
     return result;
 }
@@ -74,7 +74,7 @@ private:
         static void exchange_vec(void *rte_group, void * req);
 
         static void report(void *rte_group, const ucx_perf_result_t *result,
-                           void *arg, int is_final);
+                           void *arg, const char *extra_info, int is_final);
 
         static ucx_perf_rte_t test_rte;
 
@@ -0,0 +1,120 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include "ucp_test.h"
+
+extern "C" {
+#include <ucp/core/ucp_listener.h>
+}
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <pthread.h>
+
+
+class test_ucp_listener : public ucp_test {
+public:
+    static ucp_params_t get_ctx_params() {
+        ucp_params_t params = ucp_test::get_ctx_params();
+        params.features     = UCP_FEATURE_TAG;
+        return params;
+    }
+
+protected:
+    /* ucp_ep_create_sockaddr() blocks in the bootstrap handshake until the
+     * server worker is progressed, so the client side runs on its own thread
+     * while the main thread progresses the server */
+    struct connect_args {
+        ucp_worker_h       worker;
+        struct sockaddr_in addr;
+        ucp_ep_h           ep;
+        ucs_status_t       status;
+    };
+
+    virtual void init() {
+        ucp_test::init();
+        m_accepted_ep  = NULL;
+        m_num_accepted = 0;
+    }
+
+    static void accept_cb(ucp_ep_h ep, void *arg) {
+        test_ucp_listener *self = reinterpret_cast<test_ucp_listener*>(arg);
+        self->m_accepted_ep = ep;
+        ++self->m_num_accepted;
+    }
+
+    static void *connect_thread_func(void *arg) {
+        connect_args *args = reinterpret_cast<connect_args*>(arg);
+        args->status = ucp_ep_create_sockaddr(args->worker,
+                                              (struct sockaddr*)&args->addr,
+                                              sizeof(args->addr), NULL,
+                                              &args->ep);
+        return NULL;
+    }
+
+    void disconnect(ucp_ep_h ep) {
+        void *req = ucp_disconnect_nb(ep);
+        if (!UCS_PTR_IS_PTR(req)) {
+            ASSERT_UCS_OK(UCS_PTR_STATUS(req));
+        }
+        wait(req);
+    }
+
+    ucp_ep_h          m_accepted_ep;
+    volatile uint32_t m_num_accepted;
+};
+
+UCS_TEST_P(test_ucp_listener, connect_accept_disconnect) {
+    struct sockaddr_in addr;
+    ucp_listener_h listener;
+    ucs_status_t status;
+    socklen_t addrlen;
+    connect_args args;
+    pthread_t thread;
+    int ret;
+
+    /* Bind to an ephemeral port on the loopback interface */
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = 0;
+
+    status = ucp_listener_create(receiver().worker(), (struct sockaddr*)&addr,
+                                 sizeof(addr), accept_cb, this, &listener);
+    ASSERT_UCS_OK(status);
+
+    /* Learn which port the kernel picked */
+    addrlen = sizeof(addr);
+    ret     = getsockname(listener->fd, (struct sockaddr*)&addr, &addrlen);
+    ASSERT_EQ(0, ret);
+
+    args.worker = sender().worker();
+    args.addr   = addr;
+    args.ep     = NULL;
+    args.status = UCS_INPROGRESS;
+    pthread_create(&thread, NULL, connect_thread_func, &args);
+
+    /* Progress only the server entity here - the client worker belongs to the
+     * connecting thread until it is joined */
+    ucs_time_t deadline = ucs_get_time() + ucs_time_from_sec(10.0);
+    while ((m_num_accepted == 0) && (ucs_get_time() < deadline)) {
+        receiver().progress();
+    }
+    pthread_join(thread, NULL);
+
+    ASSERT_UCS_OK(args.status);
+    ASSERT_TRUE(args.ep != NULL);
+    EXPECT_EQ(1u, m_num_accepted);
+    ASSERT_TRUE(m_accepted_ep != NULL);
+
+    ucp_listener_destroy(listener);
+
+    disconnect(args.ep);
+    disconnect(m_accepted_ep);
+}
+
+UCP_INSTANTIATE_TEST_CASE(test_ucp_listener)
@@ -364,6 +364,34 @@ UCS_TEST_P(test_ucp_tag_match, send_nb_multiple_recv_unexp) {
     }
 }
 
+UCS_TEST_P(test_ucp_tag_match, exp_hash_resize) {
+    /* Enough distinct tags to force the expected hash table to grow and
+     * migrate incrementally while requests are still posted */
+    const unsigned num_requests = 5000;
+
+    std::vector<request*> recv_reqs(num_requests);
+    std::vector<uint64_t> recv_data(num_requests, 0);
+    uint64_t send_data = 0xdeadbeefdeadbeef;
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        recv_reqs[i] = recv_nb(&recv_data[i], sizeof(uint64_t), DATATYPE,
+                               0x1337 + i, 0xffffffffffffffffUL);
+        ASSERT_TRUE(!UCS_PTR_IS_ERR(recv_reqs[i]));
+    }
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        send_b(&send_data, sizeof(send_data), DATATYPE, 0x1337 + i);
+    }
+
+    for (unsigned i = 0; i < num_requests; ++i) {
+        wait(recv_reqs[i]);
+        EXPECT_EQ(sizeof(send_data), recv_reqs[i]->info.length);
+        EXPECT_EQ((ucp_tag_t)(0x1337 + i), recv_reqs[i]->info.sender_tag);
+        EXPECT_EQ(send_data, recv_data[i]);
+        request_release(recv_reqs[i]);
+    }
+}
+
 UCS_TEST_P(test_ucp_tag_match, sync_send_unexp) {
     ucp_tag_recv_info_t info;
     ucs_status_t status;
@@ -269,7 +269,7 @@ UCS_TEST_P(test_ucp_wireup, address) {
     unsigned address_count;
     ucp_address_entry_t *address_list;
 
-    ucp_address_unpack(buffer, &uuid, name, sizeof(name), &address_count,
+    ucp_address_unpack(NULL, buffer, &uuid, name, sizeof(name), &address_count,
                        &address_list);
     EXPECT_EQ(sender().worker()->uuid, uuid);
     EXPECT_EQ(std::string(ucp_worker_get_name(sender().worker())), std::string(name));
@@ -303,7 +303,7 @@ UCS_TEST_P(test_ucp_wireup, empty_address) {
     unsigned address_count;
     ucp_address_entry_t *address_list;
 
-    ucp_address_unpack(buffer, &uuid, name, sizeof(name), &address_count,
+    ucp_address_unpack(NULL, buffer, &uuid, name, sizeof(name), &address_count,
                        &address_list);
     EXPECT_EQ(sender().worker()->uuid, uuid);
     EXPECT_EQ(std::string(ucp_worker_get_name(sender().worker())), std::string(name));
@@ -0,0 +1,81 @@
+/**
+* Copyright (C) Mellanox Technologies Ltd. 2001-2017.  ALL RIGHTS RESERVED.
+*
+* See file LICENSE for terms.
+*/
+
+#include <common/test.h>
+extern "C" {
+#include <ucs/datastruct/arena.h>
+}
+
+class test_arena : public ucs::test {
+protected:
+    static const size_t chunk_size = 256;
+};
+
+
+UCS_TEST_F(test_arena, basic) {
+    ucs_arena_t arena;
+    void *ptr1, *ptr2;
+
+    ucs_arena_init(&arena, chunk_size);
+
+    ptr1 = ucs_arena_alloc(&arena, 40);
+    ASSERT_TRUE(ptr1 != NULL);
+    memset(ptr1, 0xaa, 40);
+
+    ptr2 = ucs_arena_alloc(&arena, 40);
+    ASSERT_TRUE(ptr2 != NULL);
+    EXPECT_NE(ptr1, ptr2);
+    memset(ptr2, 0xbb, 40);
+
+    /* Buffers must be aligned and not overlap */
+    EXPECT_EQ(0ul, (uintptr_t)ptr1 % 16);
+    EXPECT_EQ(0ul, (uintptr_t)ptr2 % 16);
+    EXPECT_EQ(0xaa, *(uint8_t*)ptr1);
+
+    ucs_arena_cleanup(&arena);
+}
+
+UCS_TEST_F(test_arena, grow) {
+    ucs_arena_t arena;
+    void *ptr;
+
+    ucs_arena_init(&arena, chunk_size);
+
+    /* Allocate more than one chunk worth of buffers */
+    for (unsigned i = 0; i < 100; ++i) {
+        ptr = ucs_arena_alloc(&arena, 40);
+        ASSERT_TRUE(ptr != NULL);
+        memset(ptr, i, 40);
+    }
+
+    /* A single allocation larger than the chunk size must still succeed */
+    ptr = ucs_arena_alloc(&arena, 4 * chunk_size);
+    ASSERT_TRUE(ptr != NULL);
+    memset(ptr, 0xcc, 4 * chunk_size);
+
+    ucs_arena_cleanup(&arena);
+}
+
+UCS_TEST_F(test_arena, reset) {
+    ucs_arena_t arena;
+    void *ptr;
+
+    ucs_arena_init(&arena, chunk_size);
+
+    /* Resetting an arena which was never used should be a no-op */
+    ucs_arena_reset(&arena);
+
+    for (unsigned iter = 0; iter < 10; ++iter) {
+        for (unsigned i = 0; i < 50; ++i) {
+            ptr = ucs_arena_alloc(&arena, 32);
+            ASSERT_TRUE(ptr != NULL);
+            memset(ptr, i, 32);
+        }
+        ucs_arena_reset(&arena);
+    }
+
+    ucs_arena_cleanup(&arena);
+}
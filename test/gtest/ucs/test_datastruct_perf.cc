@@ -0,0 +1,229 @@
+/**
+ * Copyright (C) Mellanox Technologies Ltd. 2001-2016.  ALL RIGHTS RESERVED.
+ * See file LICENSE for terms.
+ */
+
+#include <common/test.h>
+
+extern "C" {
+#include <ucs/datastruct/arbiter.h>
+#include <ucs/datastruct/callbackq.h>
+#include <ucs/datastruct/callbackq.inl>
+#include <ucs/datastruct/mpool.h>
+#include <ucs/datastruct/pgtable.h>
+#include <ucs/time/time.h>
+}
+
+#if _OPENMP
+#include <omp.h>
+#endif
+
+#include <limits.h>
+#include <algorithm>
+
+
+/* Per-operation cost of the data structures on the communication fast path.
+ * Every benchmark reports nanoseconds per operation, once single-threaded and
+ * once from inside an OpenMP parallel region with a private instance per
+ * thread, which exposes allocator and cache-line contention. The output lines
+ * have a fixed format so nightly runs can diff them against a baseline. Tag
+ * matching has its own benchmark in ucp/test_ucp_tag_perf.cc.
+ */
+class test_datastruct_perf : public ucs::test {
+protected:
+    typedef double (*bench_func_t)();
+
+    static const unsigned ITERS      = 100000;
+    static const unsigned BATCH      = 16;
+    static const unsigned ARB_GROUPS = 32;
+    static const unsigned ARB_ELEMS  = 32;
+    static const unsigned PGT_COUNT  = 1024;
+
+    void report(const char *name, bench_func_t func)
+    {
+        double single_ns, multi_ns;
+        int num_threads = 1;
+
+        single_ns = func();
+        multi_ns  = single_ns;
+#if _OPENMP
+#pragma omp parallel
+        {
+            double ns;
+#pragma omp master
+            num_threads = omp_get_num_threads();
+            ns = func();
+#pragma omp critical
+            multi_ns = std::max(multi_ns, ns);
+        }
+#endif
+        UCS_TEST_MESSAGE << name << ": " << single_ns << " ns single-thread, "
+                         << multi_ns << " ns worst of " << num_threads
+                         << " threads";
+        EXPECT_LT(single_ns, 2000.0) << name;
+    }
+
+    static void cbq_count_cb(void *arg)
+    {
+        ++*(unsigned*)arg;
+    }
+
+    static ucs_arbiter_cb_result_t arb_count_cb(ucs_arbiter_t *arbiter,
+                                                ucs_arbiter_elem_t *elem,
+                                                void *arg)
+    {
+        ++*(size_t*)arg;
+        return UCS_ARBITER_CB_RESULT_REMOVE_ELEM;
+    }
+
+    static ucs_pgt_dir_t *pgd_alloc(const ucs_pgtable_t *pgtable)
+    {
+        return new ucs_pgt_dir_t;
+    }
+
+    static void pgd_free(const ucs_pgtable_t *pgtable, ucs_pgt_dir_t *pgdir)
+    {
+        delete pgdir;
+    }
+
+    /* ucs_mpool_get/put of a batch of elements, so consecutive gets cannot be
+     * satisfied from the same cache line */
+    static double bench_mpool()
+    {
+        ucs_mpool_ops_t ops = {
+            ucs_mpool_chunk_malloc,
+            ucs_mpool_chunk_free,
+            NULL,
+            NULL
+        };
+        void *objs[BATCH];
+        ucs_mpool_t mp;
+        ucs_status_t status;
+        unsigned i, j;
+
+        status = ucs_mpool_init(&mp, 0, 64, 0, UCS_SYS_CACHE_LINE_SIZE, 128,
+                                UINT_MAX, &ops, "perf_test");
+        EXPECT_TRUE(status == UCS_OK);
+
+        ucs_time_t time = -ucs_get_time();
+        for (i = 0; i < ITERS; ++i) {
+            for (j = 0; j < BATCH; ++j) {
+                objs[j] = ucs_mpool_get(&mp);
+            }
+            for (j = 0; j < BATCH; ++j) {
+                ucs_mpool_put(objs[j]);
+            }
+        }
+        time += ucs_get_time();
+
+        ucs_mpool_cleanup(&mp, 1);
+        return ucs_time_to_nsec(time) / (ITERS * BATCH * 2.0);
+    }
+
+    static double bench_callbackq()
+    {
+        ucs_callbackq_t cbq;
+        unsigned count = 0;
+        ucs_status_t status;
+        unsigned i;
+
+        status = ucs_callbackq_init(&cbq, 64, NULL);
+        EXPECT_TRUE(status == UCS_OK);
+        for (i = 0; i < BATCH; ++i) {
+            ucs_callbackq_add(&cbq, cbq_count_cb, &count);
+        }
+
+        ucs_time_t time = -ucs_get_time();
+        for (i = 0; i < ITERS; ++i) {
+            ucs_callbackq_dispatch(&cbq);
+        }
+        time += ucs_get_time();
+
+        EXPECT_EQ(ITERS * BATCH, count);
+        ucs_callbackq_remove_all(&cbq, cbq_count_cb, &count);
+        ucs_callbackq_cleanup(&cbq);
+        return ucs_time_to_nsec(time) / ((double)ITERS * BATCH);
+    }
+
+    /* Time only the dispatch; groups are refilled outside the measurement */
+    static double bench_arbiter()
+    {
+        const unsigned rounds = ITERS / (ARB_GROUPS * ARB_ELEMS);
+        ucs_arbiter_group_t groups[ARB_GROUPS];
+        ucs_arbiter_elem_t elems[ARB_GROUPS * ARB_ELEMS];
+        ucs_arbiter_t arbiter;
+        ucs_time_t time = 0;
+        size_t count = 0;
+        unsigned round, i, j;
+
+        ucs_arbiter_init(&arbiter);
+        for (round = 0; round < rounds; ++round) {
+            for (i = 0; i < ARB_GROUPS; ++i) {
+                ucs_arbiter_group_init(&groups[i]);
+                for (j = 0; j < ARB_ELEMS; ++j) {
+                    ucs_arbiter_elem_init(&elems[(i * ARB_ELEMS) + j]);
+                    ucs_arbiter_group_push_elem(&groups[i],
+                                                &elems[(i * ARB_ELEMS) + j]);
+                }
+                ucs_arbiter_group_schedule(&arbiter, &groups[i]);
+            }
+
+            time -= ucs_get_time();
+            ucs_arbiter_dispatch(&arbiter, 1, arb_count_cb, &count);
+            time += ucs_get_time();
+        }
+
+        EXPECT_EQ((size_t)rounds * ARB_GROUPS * ARB_ELEMS, count);
+        ucs_arbiter_cleanup(&arbiter);
+        return ucs_time_to_nsec(time) / count;
+    }
+
+    static double bench_pgtable()
+    {
+        const size_t page = 4096;
+        const ucs_pgt_addr_t base = 0x7fa000000000ul;
+        std::vector<ucs_pgt_region_t> regions(PGT_COUNT);
+        ucs_pgtable_t pgtable;
+        ucs_pgt_region_t *region;
+        ucs_pgt_addr_t addr;
+        ucs_status_t status;
+        unsigned i;
+
+        status = ucs_pgtable_init(&pgtable, pgd_alloc, pgd_free);
+        EXPECT_TRUE(status == UCS_OK);
+
+        for (i = 0; i < PGT_COUNT; ++i) {
+            regions[i].start = base + (i * page);
+            regions[i].end   = base + ((i + 1) * page);
+            status = ucs_pgtable_insert(&pgtable, &regions[i]);
+            EXPECT_TRUE(status == UCS_OK);
+        }
+
+        ucs_time_t time = -ucs_get_time();
+        for (i = 0; i < ITERS; ++i) {
+            /* jump around the table to defeat the lookup cache of the CPU */
+            addr   = base + (((i * 2654435761u) % PGT_COUNT) * page) + 64;
+            region = ucs_pgtable_lookup(&pgtable, addr);
+            EXPECT_TRUE(region != NULL);
+        }
+        time += ucs_get_time();
+
+        for (i = 0; i < PGT_COUNT; ++i) {
+            status = ucs_pgtable_remove(&pgtable, &regions[i]);
+            EXPECT_TRUE(status == UCS_OK);
+        }
+        ucs_pgtable_cleanup(&pgtable);
+        return ucs_time_to_nsec(time) / ITERS;
+    }
+};
+
+UCS_TEST_F(test_datastruct_perf, per_op_costs) {
+    if (ucs::test_time_multiplier() > 1) {
+        UCS_TEST_SKIP_R("Long run expected. Skipped.");
+    }
+
+    report("mpool_get_put",      bench_mpool);
+    report("callbackq_dispatch", bench_callbackq);
+    report("arbiter_dispatch",   bench_arbiter);
+    report("pgtable_lookup",     bench_pgtable);
+}
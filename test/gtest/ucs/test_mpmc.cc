@@ -15,7 +15,7 @@ extern "C" {
 class test_mpmc : public ucs::test {
 protected:
     static const unsigned MPMC_SIZE = 100;
-    static const uint32_t SENTINEL  = 0x7fffffffu;
+    static const uintptr_t SENTINEL = (uintptr_t)-1;
     static const unsigned NUM_THREADS = 4;
 
 
@@ -29,14 +29,14 @@ protected:
         long count = elem_count();
         ucs_status_t status;
 
-        for (uint32_t i = 0; i < count; ++i) {
+        for (long i = 0; i < count; ++i) {
             do {
-                status = ucs_mpmc_queue_push(mpmc, i);
+                status = ucs_mpmc_queue_push(mpmc, (void*)(uintptr_t)i);
             } while (status == UCS_ERR_EXCEEDS_LIMIT);
             ASSERT_UCS_OK(status);
         }
         do {
-            status = ucs_mpmc_queue_push(mpmc, SENTINEL);
+            status = ucs_mpmc_queue_push(mpmc, (void*)SENTINEL);
         } while (status == UCS_ERR_EXCEEDS_LIMIT);
         return NULL;
     }
@@ -44,7 +44,7 @@ protected:
     static void * consumer_thread_func(void *arg) {
         ucs_mpmc_queue_t *mpmc = reinterpret_cast<ucs_mpmc_queue_t*>(arg);
         ucs_status_t status;
-        uint32_t value;
+        void *value;
         size_t count;
 
         count = 0;
@@ -54,7 +54,7 @@ protected:
             } while (status == UCS_ERR_NO_PROGRESS);
             ASSERT_UCS_OK(status);
             ++count;
-        } while (value != SENTINEL);
+        } while ((uintptr_t)value != SENTINEL);
 
         return (void*)((uintptr_t)count - 1); /* return count except sentinel */
     }
@@ -70,30 +70,34 @@ UCS_TEST_F(test_mpmc, basic) {
 
     EXPECT_TRUE(ucs_mpmc_queue_is_empty(&mpmc));
 
-    status = ucs_mpmc_queue_push(&mpmc, 124);
+    /* Values are full pointers now - make sure all bits survive the trip */
+    int dummy;
+    void *full_width = (void*)(uintptr_t)0xdeadbeefa5a5a5a5ull;
+
+    status = ucs_mpmc_queue_push(&mpmc, &dummy);
     ASSERT_UCS_OK(status);
 
-    status = ucs_mpmc_queue_push(&mpmc, 125);
+    status = ucs_mpmc_queue_push(&mpmc, full_width);
     ASSERT_UCS_OK(status);
 
-    status = ucs_mpmc_queue_push(&mpmc, 126);
+    status = ucs_mpmc_queue_push(&mpmc, NULL);
     ASSERT_UCS_OK(status);
 
     EXPECT_FALSE(ucs_mpmc_queue_is_empty(&mpmc));
 
-    uint32_t value;
+    void *value;
 
     status = ucs_mpmc_queue_pull(&mpmc, &value);
     ASSERT_UCS_OK(status);
-    EXPECT_EQ(124u, value);
+    EXPECT_EQ((void*)&dummy, value);
 
     status = ucs_mpmc_queue_pull(&mpmc, &value);
     ASSERT_UCS_OK(status);
-    EXPECT_EQ(125u, value);
+    EXPECT_EQ(full_width, value);
 
     status = ucs_mpmc_queue_pull(&mpmc, &value);
     ASSERT_UCS_OK(status);
-    EXPECT_EQ(126u, value);
+    EXPECT_EQ((void*)NULL, value);
 
     EXPECT_TRUE(ucs_mpmc_queue_is_empty(&mpmc));
 
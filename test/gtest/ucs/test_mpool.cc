@@ -10,6 +10,7 @@ extern "C" {
 }
 
 #include <limits.h>
+#include <pthread.h>
 #include <vector>
 #include <queue>
 
@@ -27,6 +28,37 @@ protected:
     static const size_t header_size = 30;
     static const size_t data_size = 152;
     static const size_t align = 128;
+    static const unsigned MT_NUM_THREADS = 4;
+
+    static void *mt_thread_func(void *arg) {
+        ucs_mpool_t *mp  = reinterpret_cast<ucs_mpool_t*>(arg);
+        const long count = ucs_max(100000l / ucs::test_time_multiplier(), 1000l);
+        std::vector<void*> objs;
+
+        /* Get objects in bursts larger than a magazine, so that full
+         * magazines are retired to the depot and picked up by other threads */
+        for (long i = 0; i < count; ++i) {
+            void *obj = ucs_mpool_get(mp);
+            EXPECT_TRUE(obj != NULL);
+            if (obj == NULL) {
+                break;
+            }
+            objs.push_back(obj);
+
+            if (objs.size() >= 3 * UCS_MPOOL_MAG_SIZE) {
+                while (!objs.empty()) {
+                    ucs_mpool_put(objs.back());
+                    objs.pop_back();
+                }
+            }
+        }
+
+        while (!objs.empty()) {
+            ucs_mpool_put(objs.back());
+            objs.pop_back();
+        }
+        return NULL;
+    }
 };
 
 
@@ -148,3 +180,34 @@ UCS_TEST_F(test_mpool, infinite) {
 
     ucs_mpool_cleanup(&mp, 1);
 }
+
+UCS_TEST_F(test_mpool, mt_get_put) {
+    pthread_t threads[MT_NUM_THREADS];
+    ucs_status_t status;
+    ucs_mpool_t mp;
+
+    ucs_mpool_ops_t ops = {
+       ucs_mpool_chunk_malloc,
+       ucs_mpool_chunk_free,
+       NULL,
+       NULL
+    };
+
+    status = ucs_mpool_init(&mp, 0, header_size + data_size, header_size, align,
+                            128, UINT_MAX, &ops, "test_mt");
+    ASSERT_UCS_OK(status);
+
+    status = ucs_mpool_enable_mt(&mp);
+    ASSERT_UCS_OK(status);
+
+    for (unsigned i = 0; i < MT_NUM_THREADS; ++i) {
+        pthread_create(&threads[i], NULL, mt_thread_func, &mp);
+    }
+    for (unsigned i = 0; i < MT_NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Exiting threads flush their magazines back to the depot, so the leak
+     * check must find every object accounted for */
+    ucs_mpool_cleanup(&mp, 1);
+}
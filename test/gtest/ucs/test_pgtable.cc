@@ -154,6 +154,53 @@ UCS_TEST_F(test_pgtable, basic) {
     purge(); /* region goes out of scope so we must remove it */
 }
 
+UCS_TEST_F(test_pgtable, bulk) {
+    const unsigned count = 100;
+    std::vector<ucs_pgt_region_t> regions(count);
+    std::vector<ucs_pgt_region_t*> ptrs(count);
+    ucs_status_t status;
+
+    /* Sorted, non-overlapping batch */
+    for (unsigned i = 0; i < count; ++i) {
+        regions[i].start = 0x7000000 + (i * 0x2000);
+        regions[i].end   = regions[i].start + 0x1000;
+        ptrs[i]          = &regions[i];
+    }
+
+    status = ucs_pgtable_insert_bulk(&m_pgtable, &ptrs[0], count);
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(count, num_regions());
+
+    for (unsigned i = 0; i < count; ++i) {
+        EXPECT_EQ(&regions[i], lookup(regions[i].start));
+        EXPECT_EQ(&regions[i], lookup(regions[i].end - 1));
+        EXPECT_TRUE(NULL == lookup(regions[i].end));
+    }
+
+    status = ucs_pgtable_remove_bulk(&m_pgtable, &ptrs[0], count);
+    ASSERT_UCS_OK(status);
+    EXPECT_EQ(0u, num_regions());
+    EXPECT_TRUE(NULL == lookup(regions[0].start));
+}
+
+UCS_TEST_F(test_pgtable, bulk_insert_failure) {
+    ucs_pgt_region_t exist = {0x5a000, 0x5b000};
+    insert(&exist);
+
+    /* The batch overlaps an existing region - none of it may remain */
+    ucs_pgt_region_t region1 = {0x58000, 0x59000};
+    ucs_pgt_region_t region2 = {0x5a000, 0x5c000};
+    ucs_pgt_region_t *ptrs[] = {&region1, &region2};
+
+    ucs_status_t status = ucs_pgtable_insert_bulk(&m_pgtable, ptrs, 2);
+    EXPECT_EQ(UCS_ERR_ALREADY_EXISTS, status);
+    EXPECT_EQ(1u, num_regions());
+    EXPECT_EQ(&exist, lookup(0x5a000));
+    EXPECT_TRUE(NULL == lookup(0x58000));
+
+    remove(&exist);
+}
+
 UCS_TEST_F(test_pgtable, lookup_adjacent) {
     ucs_pgt_region_t region1 = {0xc500000, 0xc500400};
     ucs_pgt_region_t region2 = {0xc500400, 0xc500800};
@@ -376,7 +423,7 @@ protected:
 
 private:
     struct region_comparator {
-        bool operator()(ucs_pgt_region_t* region1, ucs_pgt_region_t* region2) {
+        bool operator()(ucs_pgt_region_t* region1, ucs_pgt_region_t* region2) const {
             return region1->end <= region2->start;
         }
     };
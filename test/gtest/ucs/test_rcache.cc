@@ -34,6 +34,7 @@ protected:
         ucs_rcache_params_t params = {
             sizeof(region),
             UCS_PGT_ADDR_ALIGN,
+            0,
             1000,
             &ops,
             reinterpret_cast<void*>(this)
@@ -305,7 +305,7 @@ UCS_TEST_P(test_dc, dcs_ep_flush_pending) {
     preq.is_done = 0;
     preq.e = m_e1;
     preq.uct_req.func = uct_pending_flush;
-    status = uct_ep_pending_add(m_e1->ep(0), &preq.uct_req);
+    status = uct_ep_pending_add(m_e1->ep(0), &preq.uct_req, 0);
     EXPECT_UCS_OK(status);
     
     /* progress till ep is flushed */
@@ -351,7 +351,7 @@ UCS_TEST_P(test_dc, dcs_ep_purge_pending) {
     preq.is_done = 0;
     preq.e = m_e1;
     preq.uct_req.func = uct_pending_dummy;
-    status = uct_ep_pending_add(m_e1->ep(0), &preq.uct_req);
+    status = uct_ep_pending_add(m_e1->ep(0), &preq.uct_req, 0);
     EXPECT_UCS_OK(status);
 
     do {
@@ -456,7 +456,7 @@ UCS_TEST_P(test_dc_flow_control, dci_leak)
     uct_pending_req_t req;
     req.func = reinterpret_cast<ucs_status_t (*)(uct_pending_req*)>
                                (ucs_empty_function_return_no_resource);
-    EXPECT_UCS_OK(uct_ep_pending_add(m_e1->ep(0), &req));
+    EXPECT_UCS_OK(uct_ep_pending_add(m_e1->ep(0), &req, 0));
 
     /* Make sure that ep does not hold dci when sends completed */
     uct_dc_iface_t *iface = ucs_derived_of(m_e1->iface(), uct_dc_iface_t);
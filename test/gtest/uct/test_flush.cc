@@ -339,7 +339,7 @@ UCS_TEST_P(uct_flush_test, am_pending_flush_nb) {
          it->uct.func   = am_progress;
          it->comp.count = 2;
          it->comp.func  = NULL;
-         status = uct_ep_pending_add(sender().ep(0), &it->uct);
+         status = uct_ep_pending_add(sender().ep(0), &it->uct, 0);
          if (UCS_ERR_BUSY == status) {
              /* User advised to retry the send. It means no requests added
               * to the queue
@@ -366,7 +366,7 @@ UCS_TEST_P(uct_flush_test, am_pending_flush_nb) {
              /* If flush returned NO_RESOURCE, add to pending must succeed */
              flush_req.test      = this;
              flush_req.uct.func  = flush_progress;
-             status = uct_ep_pending_add(sender().ep(0), &flush_req.uct);
+             status = uct_ep_pending_add(sender().ep(0), &flush_req.uct, 0);
              if (status == UCS_ERR_BUSY) {
                  continue;
              }
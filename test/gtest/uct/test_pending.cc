@@ -159,7 +159,7 @@ UCS_TEST_P(test_uct_pending, pending_op)
 
                 pending_send_request_t *req = pending_alloc(send_data);
 
-                status = uct_ep_pending_add(m_e1->ep(0), &req->uct);
+                status = uct_ep_pending_add(m_e1->ep(0), &req->uct, 0);
                 if (status != UCS_OK) {
                     /* the request wasn't added to the pending data structure
                      * since resources became available. retry sending this message */
@@ -209,7 +209,7 @@ UCS_TEST_P(test_uct_pending, send_ooo_with_pending)
 
             pending_send_request_t *req = pending_alloc(send_data);
 
-            status_pend = uct_ep_pending_add(m_e1->ep(0), &req->uct);
+            status_pend = uct_ep_pending_add(m_e1->ep(0), &req->uct, 0);
             if (status_pend == UCS_ERR_BUSY) {
                 delete req;
             } else {
@@ -296,7 +296,7 @@ UCS_TEST_P(test_uct_pending, pending_fairness)
                                              &send_data, sizeof(send_data));
                     if (status == UCS_ERR_NO_RESOURCE) {
                         /* schedule pending */
-                        status = uct_ep_pending_add(m_e1->ep(i), &reqs[i]->uct);
+                        status = uct_ep_pending_add(m_e1->ep(i), &reqs[i]->uct, 0);
                         if (status == UCS_ERR_BUSY) {
                             continue; /* retry */
                         }
@@ -154,7 +154,7 @@ void test_rc_flow_control::test_pending_purge(int wnd, int num_pend_sends)
      * Add some user pending requests as well */
     for (int i = 0; i < num_pend_sends; i ++) {
         reqs[i].func = NULL; /* make valgrind happy */
-        EXPECT_EQ(uct_ep_pending_add(m_e2->ep(0), &reqs[i]), UCS_OK);
+        EXPECT_EQ(uct_ep_pending_add(m_e2->ep(0), &reqs[i], 0), UCS_OK);
     }
     uct_ep_pending_purge(m_e2->ep(0), purge_cb, NULL);
     EXPECT_EQ(num_pend_sends, req_count);
@@ -36,7 +36,7 @@ public:
         /* queuee some work */
         for(i = 0; i < N; i++) {
             m_r[i].func = pending_cb_dispatch;
-            EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &m_r[i]));
+            EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &m_r[i], 0));
         }
     }
 
@@ -100,7 +100,7 @@ UCS_TEST_P(test_ud_pending, async_progress) {
     EXPECT_UCS_OK(tx(m_e1));
 
     for(i = 0; i < N; i++) {
-        EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r[i]));
+        EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r[i], 0));
     }
     twait(300);
     /* requests must not be dispatched from async progress */
@@ -121,7 +121,7 @@ UCS_TEST_P(test_ud_pending, sync_progress) {
 
     for(i = 0; i < N; i++) {
         r[i].func = pending_cb;
-        EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r[i]));
+        EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r[i], 0));
     }
     short_progress_loop();
     /* requests must be dispatched from progress */
@@ -142,7 +142,7 @@ UCS_TEST_P(test_ud_pending, err_busy) {
 
     for(i = 0; i < N; i++) {
         r[i].func = pending_cb_busy;
-        EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r[i]));
+        EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r[i], 0));
     }
     short_progress_loop();
     /* requests will not be dispatched from progress */
@@ -181,7 +181,7 @@ UCS_TEST_P(test_ud_pending, window)
     }
     EXPECT_EQ(UCS_ERR_NO_RESOURCE, tx(m_e1));
     r.func = pending_cb_dispatch;
-    EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r));
+    EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r, 0));
     short_progress_loop();
     EXPECT_EQ(1, req_count);
     uct_ep_pending_purge(m_e1->ep(0), purge_cb, NULL);
@@ -206,7 +206,7 @@ UCS_TEST_P(test_ud_pending, tx_wqe)
     } while (status == UCS_OK);
 
     r.func = pending_cb_dispatch;
-    EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r));
+    EXPECT_EQ(UCS_OK, uct_ep_pending_add(m_e1->ep(0), &r, 0));
     short_progress_loop();
     EXPECT_EQ(1, req_count);
     short_progress_loop();